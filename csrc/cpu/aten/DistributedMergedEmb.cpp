@@ -62,6 +62,10 @@ void mergedemb_distribute_forward_merge_cpu(
 
 IPEX_DEFINE_DISPATCH(mergedemb_distribute_backward_local_kernel_stub);
 IPEX_DEFINE_DISPATCH(mergedemb_distribute_backward_merge_adagrad_update_stub);
+IPEX_DEFINE_DISPATCH(mergedemb_distribute_backward_merge_adam_update_stub);
+IPEX_DEFINE_DISPATCH(
+    mergedemb_distribute_backward_merge_rowwise_adam_update_stub);
+IPEX_DEFINE_DISPATCH(mergedemb_distribute_backward_merge_lamb_update_stub);
 /**
  * mergedemb_distribute_backward_local_cpu -> sparse_all_to_all ->
  * mergedemb_distribute_backward_merge_adagrad_update_cpu. Will serve the
@@ -115,6 +119,111 @@ void mergedemb_distribute_backward_merge_adagrad_update_cpu(
   return mergedemb_distribute_backward_merge_adagrad_update_stub(
       kCPU, idx, val, ofs, weight, weight_trail, hessian, lr, eps);
 }
+
+void mergedemb_distribute_backward_merge_adam_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  // return None
+  RECORD_FUNCTION(
+      "ipex::mergedemb_distribute_backward_merge_adam_update_cpu",
+      c10::ArrayRef<c10::IValue>({}));
+  return mergedemb_distribute_backward_merge_adam_update_stub(
+      kCPU,
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void mergedemb_distribute_backward_merge_rowwise_adam_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  // return None
+  RECORD_FUNCTION(
+      "ipex::mergedemb_distribute_backward_merge_rowwise_adam_update_cpu",
+      c10::ArrayRef<c10::IValue>({}));
+  return mergedemb_distribute_backward_merge_rowwise_adam_update_stub(
+      kCPU,
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void mergedemb_distribute_backward_merge_lamb_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  // return None
+  RECORD_FUNCTION(
+      "ipex::mergedemb_distribute_backward_merge_lamb_update_cpu",
+      c10::ArrayRef<c10::IValue>({}));
+  return mergedemb_distribute_backward_merge_lamb_update_stub(
+      kCPU,
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -151,5 +260,29 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "mergedemb_distribute_backward_merge_adagrad_update",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::mergedemb_distribute_backward_merge_adagrad_update_cpu);
+
+  // backward merge and adam update
+  m.def(
+      "mergedemb_distribute_backward_merge_adam_update(Tensor []idx, Tensor []val, Tensor []ofs, Tensor wgt, Tensor trail, Tensor exp_avg, Tensor exp_avg_sq, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "mergedemb_distribute_backward_merge_adam_update",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::mergedemb_distribute_backward_merge_adam_update_cpu);
+
+  // backward merge and rowwise adam update
+  m.def(
+      "mergedemb_distribute_backward_merge_rowwise_adam_update(Tensor []idx, Tensor []val, Tensor []ofs, Tensor wgt, Tensor trail, Tensor exp_avg, Tensor exp_avg_sq, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "mergedemb_distribute_backward_merge_rowwise_adam_update",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::mergedemb_distribute_backward_merge_rowwise_adam_update_cpu);
+
+  // backward merge and lamb update
+  m.def(
+      "mergedemb_distribute_backward_merge_lamb_update(Tensor []idx, Tensor []val, Tensor []ofs, Tensor wgt, Tensor trail, Tensor exp_avg, Tensor exp_avg_sq, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "mergedemb_distribute_backward_merge_lamb_update",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::mergedemb_distribute_backward_merge_lamb_update_cpu);
 }
 } // namespace
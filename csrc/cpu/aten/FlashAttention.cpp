@@ -6,6 +6,7 @@ namespace torch_ipex {
 namespace cpu {
 
 IPEX_DEFINE_DISPATCH(flash_attention_kernel_stub);
+IPEX_DEFINE_DISPATCH(int8_flash_attention_kernel_stub);
 
 /*
  *Caculate the flash attention SDPA with attention mask.
@@ -22,6 +23,35 @@ std::tuple<at::Tensor, at::Tensor> flash_attention_forward_cpu(
       kCPU, query, key, value, dropout_p, is_causal, attention_mask, scale);
 }
 
+/*
+ *Caculate the flash attention SDPA of int8 Q/K/V, of per tensor or per head
+ *scales. The output is int8 of output_scale if given, otherwise bf16.
+ */
+at::Tensor int8_flash_attention_forward_cpu(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    const c10::optional<at::Tensor>& attention_mask,
+    c10::optional<double> scale,
+    c10::optional<double> output_scale) {
+  return int8_flash_attention_kernel_stub(
+      kCPU,
+      query,
+      key,
+      value,
+      q_scale,
+      k_scale,
+      v_scale,
+      is_causal,
+      attention_mask,
+      scale,
+      output_scale);
+}
+
 /*
  *Substitude the flash attention SDPA in PT.
  *In order to add optimizations which are hard to upstream, like TPP layout
@@ -43,6 +73,15 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "flash_attention",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::flash_attention_forward_cpu);
+  m.def(
+      "int8_flash_attention(Tensor query, Tensor key, Tensor value, \
+       Tensor q_scale, Tensor k_scale, Tensor v_scale, bool is_causal=False, \
+       *, Tensor? attention_mask=None, float? scale=None, \
+       float? output_scale=None) -> Tensor");
+  m.impl(
+      "int8_flash_attention",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::int8_flash_attention_forward_cpu);
 }
 
 } // namespace cpu
@@ -16,6 +16,18 @@ std::tuple<at::Tensor, at::Tensor> flash_attention(
     bool is_causal,
     c10::optional<at::Tensor> attention_mask,
     c10::optional<double> scale);
+
+at::Tensor int8_flash_attention(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    c10::optional<at::Tensor> attention_mask,
+    c10::optional<double> scale,
+    c10::optional<double> output_scale);
 } // namespace
 
 using flash_attention_kernel_fn = std::tuple<at::Tensor, at::Tensor> (*)(
@@ -27,7 +39,22 @@ using flash_attention_kernel_fn = std::tuple<at::Tensor, at::Tensor> (*)(
     c10::optional<at::Tensor> attention_mask,
     c10::optional<double> scale);
 
+using int8_flash_attention_kernel_fn = at::Tensor (*)(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    c10::optional<at::Tensor> attention_mask,
+    c10::optional<double> scale,
+    c10::optional<double> output_scale);
+
 IPEX_DECLARE_DISPATCH(flash_attention_kernel_fn, flash_attention_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    int8_flash_attention_kernel_fn,
+    int8_flash_attention_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -8,6 +8,7 @@
 #include <ATen/native/cpu/mixed_data_type.h>
 #include <ATen/record_function.h>
 #include <c10/util/accumulate.h>
+#include <torch/all.h>
 #include "utils/library.h"
 
 #include <array>
@@ -22,6 +23,8 @@ namespace cpu {
 
 IPEX_DEFINE_DISPATCH(GroupNormKernel);
 IPEX_DEFINE_DISPATCH(GroupNormBackwardKernel);
+IPEX_DEFINE_DISPATCH(GroupNormSiluKernel);
+IPEX_DEFINE_DISPATCH(GroupNormSiluBackwardKernel);
 
 void check_group_norm_inputs(
     const at::Tensor& input,
@@ -235,6 +238,279 @@ at::Tensor group_norm(
       at::native_group_norm(X, gamma, beta, N, C, HxW, num_groups, eps));
 }
 
+namespace {
+
+// The input of the kernels, in its suggested memory format
+at::Tensor group_norm_input(const at::Tensor& input) {
+  return is_channels_last_1d(input)
+      ? input
+      : input.contiguous(input.suggest_memory_format());
+}
+
+// t as a tensor of the dtype and the strides of X, which the fused kernels
+// index with the layout of X
+at::Tensor like_input(const at::Tensor& t, const at::Tensor& X) {
+  TORCH_CHECK(
+      t.sizes() == X.sizes(),
+      "Expected a tensor of the shape of input ",
+      X.sizes(),
+      ", but got ",
+      t.sizes());
+  if (t.scalar_type() == X.scalar_type() && t.strides() == X.strides()) {
+    return t;
+  }
+  return at::empty_like(X).copy_(t);
+}
+
+} // namespace
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> group_norm_silu_forward(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps) {
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::group_norm_silu_forward\n");
+#endif
+  RECORD_FUNCTION(
+      "torch_ipex::group_norm_silu_forward", c10::ArrayRef<c10::IValue>({}));
+
+  const at::Tensor& weight =
+      c10::value_or_else(weight_opt, [] { return at::Tensor(); });
+  const at::Tensor& bias =
+      c10::value_or_else(bias_opt, [] { return at::Tensor(); });
+  const at::Tensor& other =
+      c10::value_or_else(other_opt, [] { return at::Tensor(); });
+
+  const int64_t N = input.size(0);
+  const int64_t C = input.size(1);
+  check_group_norm_inputs(input, weight, bias, C, num_groups);
+  const auto input_shape = input.sizes();
+  const int64_t HxW =
+      c10::multiply_integers(input_shape.cbegin() + 2, input_shape.cend());
+
+  const auto X = group_norm_input(input);
+  const auto gamma = weight.defined() ? weight.contiguous() : at::Tensor();
+  const auto beta = bias.defined() ? bias.contiguous() : at::Tensor();
+  bool mixed_type = at::native::is_mixed_type(X, gamma, beta);
+  if (mixed_type) {
+    at::native::check_mixed_data_type(X, gamma, beta);
+  }
+  const auto other_ = other.defined() ? like_input(other, X) : at::Tensor();
+
+  // Y has the strides of X, as other
+  at::Tensor Y = at::empty_like(X);
+  const auto dtype = at::native::param_scalar_type(X, mixed_type);
+  at::Tensor mean = at::empty({N, num_groups}, X.options().dtype(dtype));
+  at::Tensor rstd = at::empty({N, num_groups}, X.options().dtype(dtype));
+  GroupNormSiluKernel(
+      X.device().type(),
+      X,
+      gamma,
+      beta,
+      other_,
+      N,
+      C,
+      HxW,
+      num_groups,
+      eps,
+      Y,
+      mean,
+      rstd);
+  return std::make_tuple(Y, mean, rstd);
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> group_norm_silu_backward(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    const at::Tensor& mean,
+    const at::Tensor& rstd,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    int64_t num_groups,
+    std::array<bool, 3> grad_input_mask) {
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::group_norm_silu_backward\n");
+#endif
+  RECORD_FUNCTION(
+      "torch_ipex::group_norm_silu_backward", c10::ArrayRef<c10::IValue>({}));
+
+  const at::Tensor& weight =
+      c10::value_or_else(weight_opt, [] { return at::Tensor(); });
+  const at::Tensor& bias =
+      c10::value_or_else(bias_opt, [] { return at::Tensor(); });
+
+  const int64_t N = input.size(0);
+  const int64_t C = input.size(1);
+  const auto input_shape = input.sizes();
+  const int64_t HxW =
+      c10::multiply_integers(input_shape.cbegin() + 2, input_shape.cend());
+
+  const auto X = group_norm_input(input);
+  const auto gamma = weight.defined() ? weight.contiguous() : at::Tensor();
+  const auto beta = bias.defined() ? bias.contiguous() : at::Tensor();
+  const auto dY = like_input(grad_output, X);
+
+  // Gradient of the GroupNorm output, then the GroupNorm backward on it
+  at::Tensor dY_gn = at::empty_like(X);
+  GroupNormSiluBackwardKernel(
+      X.device().type(),
+      dY,
+      X,
+      mean,
+      rstd,
+      gamma,
+      beta,
+      N,
+      C,
+      HxW,
+      num_groups,
+      dY_gn);
+  return native_group_norm_backward(
+      dY_gn, X, mean, rstd, gamma, N, C, HxW, num_groups, grad_input_mask);
+}
+
+at::Tensor IPEXGroupNormSiluOp::_forward(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps) {
+  RECORD_FUNCTION(
+      "IPEXGroupNormSiluOp::_forward", c10::ArrayRef<c10::IValue>({}));
+  return std::get<0>(group_norm_silu_forward(
+      input, num_groups, weight_opt, bias_opt, other_opt, eps));
+}
+
+at::Tensor IPEXGroupNormSiluOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps) {
+  RECORD_FUNCTION(
+      "IPEXGroupNormSiluOp::forward", c10::ArrayRef<c10::IValue>({}));
+
+  const at::Tensor& weight =
+      c10::value_or_else(weight_opt, [] { return at::Tensor(); });
+  const at::Tensor& bias =
+      c10::value_or_else(bias_opt, [] { return at::Tensor(); });
+  const at::Tensor& other =
+      c10::value_or_else(other_opt, [] { return at::Tensor(); });
+
+  ctx->saved_data["num_groups"] = num_groups;
+  ctx->saved_data["input_requires_grad"] = input.requires_grad();
+  ctx->saved_data["weight_requires_grad"] =
+      weight.defined() && weight.requires_grad();
+  ctx->saved_data["bias_requires_grad"] =
+      bias.defined() && bias.requires_grad();
+  ctx->saved_data["other_requires_grad"] =
+      other.defined() && other.requires_grad();
+  at::Tensor output, mean, rstd;
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::group_norm_silu_forward", "")
+          .typed<decltype(group_norm_silu_forward)>();
+  std::tie(output, mean, rstd) =
+      op.call(input, num_groups, weight_opt, bias_opt, other_opt, eps);
+  ctx->save_for_backward({input, weight, bias, mean, rstd});
+  return output;
+}
+
+torch::autograd::variable_list IPEXGroupNormSiluOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  RECORD_FUNCTION(
+      "IPEXGroupNormSiluOp::backward", c10::ArrayRef<c10::IValue>({}));
+
+  auto num_groups = ctx->saved_data["num_groups"].toInt();
+  std::array<bool, 3> output_mask;
+  output_mask[0] = ctx->saved_data["input_requires_grad"].toBool();
+  output_mask[1] = ctx->saved_data["weight_requires_grad"].toBool();
+  output_mask[2] = ctx->saved_data["bias_requires_grad"].toBool();
+  auto other_requires_grad = ctx->saved_data["other_requires_grad"].toBool();
+  auto saved = ctx->get_saved_variables();
+  at::Tensor input = saved[0];
+  at::Tensor weight = saved[1];
+  at::Tensor bias = saved[2];
+  at::Tensor mean = saved[3];
+  at::Tensor rstd = saved[4];
+  at::Tensor grad_input, grad_weight, grad_bias;
+  if (output_mask[0] || output_mask[1] || output_mask[2]) {
+    static auto op =
+        torch::Dispatcher::singleton()
+            .findSchemaOrThrow("torch_ipex::group_norm_silu_backward", "")
+            .typed<decltype(group_norm_silu_backward)>();
+    std::tie(grad_input, grad_weight, grad_bias) = op.call(
+        grad_outputs[0],
+        input,
+        mean,
+        rstd,
+        weight,
+        bias,
+        num_groups,
+        output_mask);
+  }
+  // The residual is added after silu
+  at::Tensor grad_other = other_requires_grad ? grad_outputs[0] : at::Tensor();
+  return {
+      grad_input,
+      at::Tensor(),
+      grad_weight,
+      grad_bias,
+      grad_other,
+      at::Tensor()};
+}
+
+at::Tensor group_norm_silu(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps) {
+  if (at::GradMode::is_enabled()) {
+    return IPEXGroupNormSiluOp::apply(
+        input, num_groups, weight_opt, bias_opt, other_opt, eps);
+  }
+  return IPEXGroupNormSiluOp::_forward(
+      input, num_groups, weight_opt, bias_opt, other_opt, eps);
+}
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "group_norm_silu(Tensor input, int num_groups, Tensor? weight, Tensor? "
+      "bias, Tensor? other, float eps) -> Tensor");
+  m.impl(
+      "group_norm_silu",
+      c10::DispatchKey::AutogradCPU,
+      torch_ipex::cpu::group_norm_silu);
+  m.impl(
+      "group_norm_silu",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::IPEXGroupNormSiluOp::_forward);
+  m.def(
+      "group_norm_silu_forward(Tensor input, int num_groups, Tensor? weight, "
+      "Tensor? bias, Tensor? other, float eps) -> (Tensor, Tensor, Tensor)");
+  m.impl(
+      "group_norm_silu_forward",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::group_norm_silu_forward);
+  m.def(
+      "group_norm_silu_backward(Tensor grad_output, Tensor input, Tensor "
+      "mean, Tensor rstd, Tensor? weight, Tensor? bias, int num_groups, "
+      "bool[3] grad_input_mask) -> (Tensor, Tensor, Tensor)");
+  m.impl(
+      "group_norm_silu_backward",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::group_norm_silu_backward);
+}
+
 IPEX_TORCH_LIBRARY_IMPL(aten, CPU, m) {
   m.impl(
       TORCH_SELECTIVE_NAME("aten::group_norm"),
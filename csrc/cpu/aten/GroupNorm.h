@@ -2,6 +2,8 @@
 
 #include <ATen/ATen.h>
 #include <dyndisp/DispatchStub.h>
+#include <torch/csrc/autograd/custom_function.h>
+#include <array>
 #include <cstdint>
 
 namespace torch_ipex {
@@ -35,8 +37,93 @@ using backward_fn = void (*)(
     at::Tensor& /* dgamma */,
     at::Tensor& /* dbeta */);
 
+// GroupNorm with the epilogue y = silu(y) + other, other is optional and
+// has the shape and the strides of X
+using silu_forward_fn = void (*)(
+    const at::Tensor& /* X */,
+    const at::Tensor& /* gamma */,
+    const at::Tensor& /* beta */,
+    const at::Tensor& /* other */,
+    int64_t /* N */,
+    int64_t /* C */,
+    int64_t /* HxW */,
+    int64_t /* group */,
+    double /* eps */,
+    at::Tensor& /* Y */,
+    at::Tensor& /* mean */,
+    at::Tensor& /* rstd */);
+
+// Gradient of the GroupNorm output from the gradient of its silu, with the
+// GroupNorm output recomputed from X, mean and rstd
+using silu_backward_fn = void (*)(
+    const at::Tensor& /* dY */,
+    const at::Tensor& /* X */,
+    const at::Tensor& /* mean */,
+    const at::Tensor& /* rstd */,
+    const at::Tensor& /* gamma */,
+    const at::Tensor& /* beta */,
+    int64_t /* N */,
+    int64_t /* C */,
+    int64_t /* HxW */,
+    int64_t /* group */,
+    at::Tensor& /* dY_gn */);
+
 IPEX_DECLARE_DISPATCH(forward_fn, GroupNormKernel);
 IPEX_DECLARE_DISPATCH(backward_fn, GroupNormBackwardKernel);
+IPEX_DECLARE_DISPATCH(silu_forward_fn, GroupNormSiluKernel);
+IPEX_DECLARE_DISPATCH(silu_backward_fn, GroupNormSiluBackwardKernel);
+
+// silu(group_norm(input)) + other, of the diffusion UNet and VAE blocks
+std::tuple<at::Tensor, at::Tensor, at::Tensor> group_norm_silu_forward(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> group_norm_silu_backward(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    const at::Tensor& mean,
+    const at::Tensor& rstd,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    int64_t num_groups,
+    std::array<bool, 3> grad_input_mask);
+
+class IPEXGroupNormSiluOp
+    : public torch::autograd::Function<IPEXGroupNormSiluOp> {
+ public:
+  static at::Tensor _forward(
+      const at::Tensor& input,
+      int64_t num_groups,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& bias_opt,
+      const c10::optional<at::Tensor>& other_opt,
+      double eps);
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      int64_t num_groups,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& bias_opt,
+      const c10::optional<at::Tensor>& other_opt,
+      double eps);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+at::Tensor group_norm_silu(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    const c10::optional<at::Tensor>& other_opt,
+    double eps);
 
 } // namespace cpu
 } // namespace torch_ipex
\ No newline at end of file
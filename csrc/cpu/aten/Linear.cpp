@@ -4,6 +4,7 @@
 #include "Eltwise.h"
 #include "Linear.h"
 #include "WeightPack.h"
+#include "WoqTuning.h"
 #include "autocast/autocast_mode.h"
 #include "ideep/IDeepConversions.h"
 
@@ -361,34 +362,34 @@ IPEX_DEFINE_DISPATCH(woq_tpp_gemm_packB_stub);
 at::Tensor woq_linear_pack_weight(
     const at::Tensor& weight,
     std::vector<int64_t>& weight_shape,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode) {
   // TPP kernel does not support edge cases
   // It generates packed weight in 4d (Nc, Kc, block_k, block_n)
   auto N = weight_shape[0], K = weight_shape[1];
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   // For TPP kernel, we only consider even K
   if (K % 2 == 0) {
-    size_t block_n = 32;
-    size_t block_k = group_size > 0 ? std::min(group_size, (int64_t)64) : 64;
-    while (K % block_k != 0) {
-      block_k /= 2;
-    }
+    // Tuned block sizes if any, see WoqTuning.h
+    auto pack_config =
+        woq_get_pack_config(N, K, weight_dtype, group_size, lowp_mode);
+    size_t block_n = pack_config.block_n;
+    size_t block_k = pack_config.block_k;
     assert(block_k > 0);
-    if (is_int4) {
+    int64_t bits = woq_dtype_bits(weight_dtype);
+    if (bits < 8) {
       if (block_k % 4 && lowp_mode == 3) {
         // This case is not supported by kernel
         return weight;
       }
       // Create a new non-quantized tensor in data type uint8 (Byte)
-      // One uint8 holds two int4 values. Compressed along K.
+      // Values of `bits` bits, e.g. two int4 in one uint8, compressed along K.
       // N is padded to the nearest multiple of block_n.
       // Note that weight is already compressed
-      int64_t K_int4_compressed = K / 2;
+      int64_t K_compressed = K * bits / 8;
       int64_t N_int4 = N % block_n ? N / block_n * block_n + block_n : N;
       at::Tensor weight_int4 = at::empty(
-          {N_int4, K_int4_compressed}, device(c10::kCPU).dtype(c10::kByte));
+          {N_int4, K_compressed}, device(c10::kCPU).dtype(c10::kByte));
       int64_t weight_size_bytes = weight.numel();
       int64_t weight_int4_size_bytes = weight_int4.numel();
       int64_t pad_size_bytes = weight_int4_size_bytes - weight_size_bytes;
@@ -398,13 +399,13 @@ at::Tensor woq_linear_pack_weight(
           0,
           pad_size_bytes);
       return woq_tpp_gemm_packB_stub(
-          kCPU, weight_int4, w_dtype, block_n, block_k, lowp_mode);
+          kCPU, weight_int4, weight_dtype, block_n, block_k, lowp_mode);
     }
     if (N % block_n) {
       return weight;
     } else {
       return woq_tpp_gemm_packB_stub(
-          kCPU, weight, w_dtype, block_n, block_k, lowp_mode);
+          kCPU, weight, weight_dtype, block_n, block_k, lowp_mode);
     }
   }
   return weight;
@@ -413,10 +414,9 @@ at::Tensor woq_linear_pack_weight(
 IPEX_DEFINE_DISPATCH(woq_tpp_gemm_unpackB_stub);
 at::Tensor woq_linear_unpack_weight(
     const at::Tensor& weight,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t lowp_mode) {
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
-  return woq_tpp_gemm_unpackB_stub(kCPU, weight, w_dtype, lowp_mode);
+  return woq_tpp_gemm_unpackB_stub(kCPU, weight, weight_dtype, lowp_mode);
 }
 
 IPEX_DEFINE_DISPATCH(woq_tpp_gemm_kernel_stub);
@@ -426,12 +426,11 @@ at::Tensor woq_linear_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
     int64_t act_quant_mode) {
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
   return woq_tpp_gemm_kernel_stub(
       kCPU,
@@ -440,7 +439,7 @@ at::Tensor woq_linear_kernel(
       scales_list,
       zps_list,
       bias_list,
-      w_dtype,
+      weight_dtype,
       lowp_mode,
       num_concats,
       WOQ_FUSE_NONE, // no post op fusion
@@ -469,12 +468,11 @@ at::Tensor woq_linear_eltwise_kernel(
     const c10::string_view& post_op,
     const torch::List<c10::optional<at::Scalar>>& scalars,
     const c10::optional<c10::string_view>& algorithm,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
     int64_t act_quant_mode) {
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t post_op_fusion_type = WOQ_FUSE_NONE;
   if (post_op == "gelu") {
     if (algorithm == "none") {
@@ -491,7 +489,7 @@ at::Tensor woq_linear_eltwise_kernel(
       scales_list,
       zps_list,
       bias_list,
-      w_dtype,
+      weight_dtype,
       lowp_mode,
       num_concats,
       post_op_fusion_type,
@@ -529,13 +527,12 @@ at::Tensor woq_linear_add_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
     const std::vector<at::Tensor>& others,
     int64_t act_quant_mode) {
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
   return woq_tpp_gemm_kernel_stub(
       kCPU,
@@ -544,7 +541,7 @@ at::Tensor woq_linear_add_kernel(
       scales_list,
       zps_list,
       bias_list,
-      w_dtype,
+      weight_dtype,
       lowp_mode,
       num_concats,
       WOQ_FUSE_ADD, // post op add
@@ -560,13 +557,12 @@ at::Tensor woq_linear_add_add_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
     const std::vector<at::Tensor>& others,
     int64_t act_quant_mode) {
-  int w_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
   int64_t quant_w_mode = group_size > 0 ? 1 : 0;
   return woq_tpp_gemm_kernel_stub(
       kCPU,
@@ -575,7 +571,7 @@ at::Tensor woq_linear_add_add_kernel(
       scales_list,
       zps_list,
       bias_list,
-      w_dtype,
+      weight_dtype,
       lowp_mode,
       num_concats,
       WOQ_FUSE_ADD_ADD, // post op add-add
@@ -605,6 +601,59 @@ at::Tensor woq_linear_add_add_forward(
              op_context.data_ptr<int64_t>()[0])
       ->run_add_add(input, others);
 }
+
+IPEX_DEFINE_DISPATCH(woq_tpp_mlp_kernel_stub);
+at::Tensor woq_fused_mlp_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_gate_up,
+    const std::vector<at::Tensor>& scales_gate_up,
+    const std::vector<at::Tensor>& zps_gate_up,
+    const std::vector<at::Tensor>& bias_gate_up,
+    const at::Tensor& weight_down,
+    const std::vector<at::Tensor>& scales_down,
+    const std::vector<at::Tensor>& zps_down,
+    const std::vector<at::Tensor>& bias_down,
+    int64_t intermediate_size,
+    int64_t out_features,
+    int64_t weight_dtype,
+    int64_t group_size,
+    int64_t lowp_mode,
+    const std::vector<at::Tensor>& others,
+    int64_t act_quant_mode) {
+  int64_t quant_w_mode = group_size > 0 ? 1 : 0;
+  return woq_tpp_mlp_kernel_stub(
+      kCPU,
+      self,
+      weight_gate_up,
+      scales_gate_up,
+      zps_gate_up,
+      bias_gate_up,
+      weight_down,
+      scales_down,
+      zps_down,
+      bias_down,
+      intermediate_size,
+      out_features,
+      weight_dtype,
+      lowp_mode,
+      others,
+      act_quant_mode,
+      quant_w_mode,
+      group_size);
+}
+
+at::Tensor woq_fused_mlp_forward(
+    const at::Tensor& input,
+    const at::Tensor& op_context_gate_up,
+    const at::Tensor& op_context_down,
+    const std::vector<at::Tensor>& others) {
+  RECORD_FUNCTION("torch_ipex::woq_fused_mlp", c10::ArrayRef<c10::IValue>({}));
+  auto down = reinterpret_cast<IpexWoqLinearOpContext*>(
+      op_context_down.data_ptr<int64_t>()[0]);
+  return reinterpret_cast<IpexWoqLinearOpContext*>(
+             op_context_gate_up.data_ptr<int64_t>()[0])
+      ->run_fused_mlp(input, *down, others);
+}
 #endif
 
 at::Tensor matmul_i8i8i32(const at::Tensor& input, const at::Tensor& weight) {
@@ -797,6 +846,23 @@ at::Tensor woq_linear_add_add_forward(
       op_context,
       cpu_cached_cast(target_type, others));
 }
+
+at::Tensor woq_fused_mlp_forward(
+    const at::Tensor& input,
+    const at::Tensor& op_context_gate_up,
+    const at::Tensor& op_context_down,
+    const std::vector<at::Tensor>& others) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op = torch::Dispatcher::singleton()
+                       .findSchemaOrThrow("torch_ipex::woq_fused_mlp", "")
+                       .typed<decltype(woq_fused_mlp_forward)>();
+  auto target_type = get_autocast_dtype();
+  return op.call(
+      cpu_cached_cast(target_type, input),
+      op_context_gate_up,
+      op_context_down,
+      cpu_cached_cast(target_type, others));
+}
 #endif
 
 at::Tensor matmul_i8i8i32(const at::Tensor& input, const at::Tensor& weight) {
@@ -872,6 +938,17 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "woq_linear_add_add",
       c10::DispatchKey::AutocastCPU,
       torch_ipex::autocast::woq_linear_add_add_forward);
+  m.def(
+      "woq_fused_mlp(Tensor input, Tensor W_gate_up_prepack, "
+      "Tensor W_down_prepack, Tensor[] others) -> Tensor");
+  m.impl(
+      "woq_fused_mlp",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::woq_fused_mlp_forward);
+  m.impl(
+      "woq_fused_mlp",
+      c10::DispatchKey::AutocastCPU,
+      torch_ipex::autocast::woq_fused_mlp_forward);
 #endif
   // fuse eltwise
   m.def(
@@ -84,16 +84,17 @@ at::Tensor ipex_linear_eltwise(
 
 #ifdef USE_LIBXSMM
 // WOQ linear ops
+// weight_dtype is one of WOQ_DTYPE_*
 at::Tensor woq_linear_pack_weight(
     const at::Tensor& weight,
     std::vector<int64_t>& weight_shape,
-    bool is_4bit,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode);
 
 at::Tensor woq_linear_unpack_weight(
     const at::Tensor& weight,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t lowp_mode);
 
 at::Tensor woq_linear_kernel(
@@ -102,7 +103,7 @@ at::Tensor woq_linear_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
@@ -117,7 +118,7 @@ at::Tensor woq_linear_eltwise_kernel(
     const c10::string_view& post_op,
     const torch::List<c10::optional<at::Scalar>>& scalars,
     const c10::optional<c10::string_view>& algorithm,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
@@ -129,7 +130,7 @@ at::Tensor woq_linear_add_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
@@ -142,13 +143,33 @@ at::Tensor woq_linear_add_add_kernel(
     const std::vector<at::Tensor>& scales_list,
     const std::vector<at::Tensor>& zps_list,
     const std::vector<at::Tensor>& bias_list,
-    bool is_int4,
+    int64_t weight_dtype,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
     const std::vector<at::Tensor>& others,
     int64_t act_quant_mode);
 
+// Gated MLP, down(silu(gate(x)) * up(x)) + others. The gate and up
+// projections are concatenated in weight_gate_up, gate first.
+at::Tensor woq_fused_mlp_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_gate_up,
+    const std::vector<at::Tensor>& scales_gate_up,
+    const std::vector<at::Tensor>& zps_gate_up,
+    const std::vector<at::Tensor>& bias_gate_up,
+    const at::Tensor& weight_down,
+    const std::vector<at::Tensor>& scales_down,
+    const std::vector<at::Tensor>& zps_down,
+    const std::vector<at::Tensor>& bias_down,
+    int64_t intermediate_size,
+    int64_t out_features,
+    int64_t weight_dtype,
+    int64_t group_size,
+    int64_t lowp_mode,
+    const std::vector<at::Tensor>& others,
+    int64_t act_quant_mode);
+
 namespace {
 void woq_gemm_kernel_impl(
     const at::Tensor& self,
@@ -235,6 +256,27 @@ IPEX_DECLARE_DISPATCH(woq_tpp_gemm_kernel_fn, woq_tpp_gemm_kernel_stub);
 IPEX_DECLARE_DISPATCH(woq_tpp_gemm_packB_fn, woq_tpp_gemm_packB_stub);
 IPEX_DECLARE_DISPATCH(woq_tpp_gemm_unpackB_fn, woq_tpp_gemm_unpackB_stub);
 
+using woq_tpp_mlp_kernel_fn = at::Tensor (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const std::vector<at::Tensor>&,
+    const std::vector<at::Tensor>&,
+    const std::vector<at::Tensor>&,
+    const at::Tensor&,
+    const std::vector<at::Tensor>&,
+    const std::vector<at::Tensor>&,
+    const std::vector<at::Tensor>&,
+    int64_t,
+    int64_t,
+    const int,
+    int64_t,
+    const std::vector<at::Tensor>&,
+    int64_t,
+    int64_t,
+    int64_t);
+
+IPEX_DECLARE_DISPATCH(woq_tpp_mlp_kernel_fn, woq_tpp_mlp_kernel_stub);
+
 #define WOQ_FUSE_NONE 0
 #define WOQ_FUSE_GELU 1
 #define WOQ_FUSE_ADD 2
@@ -244,6 +286,36 @@ IPEX_DECLARE_DISPATCH(woq_tpp_gemm_unpackB_fn, woq_tpp_gemm_unpackB_stub);
 #define WOQ_DTYPE_QINT8 1
 #define WOQ_DTYPE_QINT4 2
 #define WOQ_DTYPE_NF4 3
+// MX formats, whose E8M0 scales are shared by blocks of 32 along K. Codes of
+// FP4 (E2M1) are packed two per byte as int4, those of FP6 (E2M3) four in
+// three bytes and those of FP8 (E4M3) take one byte each as int8.
+#define WOQ_DTYPE_MXFP4 4
+#define WOQ_DTYPE_MXFP6 5
+#define WOQ_DTYPE_MXFP8 6
+#define WOQ_MX_BLOCK_SIZE 32
+// Asymmetric 2-bit and 3-bit integers, e.g. of GPTQ checkpoints
+#define WOQ_DTYPE_INT2 7
+#define WOQ_DTYPE_INT3 8
+
+// Whether two values of the weight dtype are packed in one byte
+inline bool woq_is_4bit_dtype(int64_t weight_dtype) {
+  return weight_dtype == WOQ_DTYPE_QINT4 || weight_dtype == WOQ_DTYPE_NF4 ||
+      weight_dtype == WOQ_DTYPE_MXFP4;
+}
+
+// Bits of one value of the weight dtype. Values of less than 8 bits are
+// packed along K of the plain [N, K] weight as a little-endian bitstream,
+// i.e. [N, K * bits / 8] in uint8, and the weight may be padded along N.
+inline int64_t woq_dtype_bits(int64_t weight_dtype) {
+  if (weight_dtype == WOQ_DTYPE_INT2) {
+    return 2;
+  } else if (weight_dtype == WOQ_DTYPE_INT3) {
+    return 3;
+  } else if (weight_dtype == WOQ_DTYPE_MXFP6) {
+    return 6;
+  }
+  return woq_is_4bit_dtype(weight_dtype) ? 4 : 8;
+}
 
 #endif
 
@@ -4,7 +4,6 @@
 #include <ATen/Tensor.h>
 #include <dyndisp/DispatchStub.h>
 #include <torch/all.h>
-#include "utils/robin_hood.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -13,33 +12,6 @@ namespace {
 using namespace at;
 enum PoolingMode { SUM = 0, MEAN = 1 };
 
-template <class T>
-class EMBROW {
- public:
-  T* data = nullptr;
-  std::vector<T> arr;
-  int32_t length;
-
-  EMBROW(int32_t len) {
-    length = len;
-    arr.resize(length);
-    data = &arr[0];
-    memset(data, 0, len * sizeof(T));
-  }
-};
-
-template <class T, int32_t emb_dim>
-class EMBROWFixLen {
- public:
-  T* data = nullptr;
-  T arr[emb_dim];
-
-  EMBROWFixLen(int32_t len) {
-    data = &arr[0];
-    memset(data, 0, emb_dim * sizeof(T));
-  }
-};
-
 /**
  * EmbeddingRowCache is used for 2 purpose:
  * (1) For low precision data type, we need accumulate grads or lookup results
@@ -49,20 +21,17 @@ class EMBROWFixLen {
  * a large contiguous buffer to store the results, then we store them in
  * EmbeddingRowCache with smaller memory usage.
  *
- * EmbeddingRowCache contains var length EmbRow hash map and Fixed length EmbRow
- * with len=64, 128, 256 And handle different lenght inside EmbeddingRowCache
- * without expose len info to users.
- *
- * The robin_hood::unordered_map<int64_t, T*> _cached_ptr is used because user
- * need to iterate this cache and we wish to provide a unfied api to return the
- * iterated object without introducing length info in user code.
- *
- * Why we need fixed length EmbRow:
- *     We will allocate memory to hold emb row very frequently during Embedding
- * FW/BW, we wish to allocate the memory on stack by using temporal varalble
- * instead of allocating them in heap for performance consideration. So we use C
- * array to hold fixed length and use std::vector to hold var lenght
- * (std::vector will use memory on heap).
+ * The rows are carved out of a flat arena, and indexed by an open addressing
+ * hash table of the row ids with linear probing, so that adding a row neither
+ * allocates nor goes through the nodes of a hash map. clear() resets the cache
+ * in O(1) by bumping the epoch of the index, of which the slots of an older
+ * epoch are free, and keeps the arena and the index: a cache reused across the
+ * iterations, e.g. by reuse_row_caches(), is sized by the rows of the previous
+ * iterations, and stops allocating once they reach their high-water mark.
+ * Every kShrinkPeriod clears, the arena and the index are shrunk to twice the
+ * high-water mark of these iterations when it is at most a quarter of them,
+ * so that one large batch does not pin its memory in a thread_local cache for
+ * the life of the thread.
  *
  * How to use:
  *
@@ -81,43 +50,131 @@ class EMBROWFixLen {
  * int64_t size()
  *    return the cache size
  *
- * const robin_hood::unordered_map<int64_t, T*> cache()
- *    return the hash map of EmbeddingRowCache to iterate purpose
+ * const std::vector<std::pair<int64_t, T*>>& cache()
+ *    return the (key, data-ptr) of the rows, in the order of their emplace, to
+ *    iterate purpose
+ *
+ * int64_t capacity()
+ *    return the size of the arena, in elements of T
+ *
+ * void clear()
+ *    remove all the rows, in O(1) but every kShrinkPeriod calls
+ *
+ * void release()
+ *    remove all the rows and free the arena and the index
  */
 template <class T>
 class EmbeddingRowCache {
-  robin_hood::unordered_map<int64_t, EMBROW<T>> _cache;
-  robin_hood::unordered_map<int64_t, EMBROWFixLen<T, 64>> _cache64;
-  robin_hood::unordered_map<int64_t, EMBROWFixLen<T, 128>> _cache128;
-  robin_hood::unordered_map<int64_t, EMBROWFixLen<T, 256>> _cache256;
-  robin_hood::unordered_map<int64_t, T*> _cached_ptr;
-  int32_t _emb_dim = -1;
+  struct Slot {
+    int64_t key;
+    T* data;
+    // the slot is free unless it is of the epoch of the cache
+    uint32_t epoch;
+  };
+
+  std::vector<Slot> _slots;
+  int32_t _slot_bits = 0;
+  uint32_t _epoch = 1;
+  std::vector<std::pair<int64_t, T*>> _rows;
+  // The arena grows by blocks, so that the rows do not move, and is merged
+  // into a single block by clear()
+  std::vector<std::unique_ptr<T[]>> _blocks;
+  int64_t _block_size = 0;
+  int64_t _block_used = 0;
+  int64_t _arena_size = 0;
+  // elements of the rows since the last clear()
+  int64_t _arena_used = 0;
+  // high-water marks of the iterations since the last shrink
+  int64_t _peak_used = 0;
+  int64_t _peak_rows = 0;
+  int32_t _clears = 0;
+
+  // Fibonacci hashing, the row ids of a cache are often strided
+  int64_t slot_of(int64_t key) const {
+    return static_cast<int64_t>(
+        (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >>
+        (64 - _slot_bits));
+  }
+
+  // Slot of the key, or the free slot where to add it
+  Slot& probe(int64_t key) {
+    int64_t mask = _slots.size() - 1;
+    int64_t i = slot_of(key);
+    while (_slots[i].epoch == _epoch && _slots[i].key != key) {
+      i = (i + 1) & mask;
+    }
+    return _slots[i];
+  }
+
+  // Keeps the load factor of the index at most 1/2
+  void grow_index() {
+    _slot_bits = std::max(_slot_bits + 1, 6);
+    _slots.assign(int64_t(1) << _slot_bits, Slot{0, nullptr, 0});
+    for (auto& row : _rows) {
+      probe(row.first) = Slot{row.first, row.second, _epoch};
+    }
+  }
+
+  T* allocate_row(int32_t emb_dim) {
+    if (_block_used + emb_dim > _block_size) {
+      _block_size = std::max<int64_t>(_arena_size, int64_t(emb_dim) * 64);
+      _blocks.emplace_back(new T[_block_size]);
+      _block_used = 0;
+      _arena_size += _block_size;
+    }
+    T* ptr = _blocks.back().get() + _block_used;
+    _block_used += emb_dim;
+    _arena_used += emb_dim;
+    return ptr;
+  }
+
+  // Frees what the rows of the last iterations left unused, the cache being
+  // empty
+  void shrink() {
+    if (4 * _peak_used < _arena_size) {
+      _blocks.clear();
+      _arena_size = 2 * _peak_used;
+      _block_size = _arena_size;
+      if (_arena_size > 0) {
+        _blocks.emplace_back(new T[_arena_size]);
+      }
+    }
+    if (4 * _peak_rows < int64_t(_rows.capacity())) {
+      _rows.shrink_to_fit();
+    }
+    if (_slot_bits > 6 && 8 * _peak_rows < int64_t(_slots.size())) {
+      // rebuilt by the next emplace()
+      _slots = std::vector<Slot>();
+      _slot_bits = 0;
+    }
+    _peak_used = 0;
+    _peak_rows = 0;
+    _clears = 0;
+  }
 
  public:
+  static constexpr int32_t kShrinkPeriod = 64;
+
   T* find(int64_t key) {
-    auto find = _cached_ptr.find(key);
-    if (find == _cached_ptr.end())
+    if (_slots.empty()) {
       return nullptr;
-    return find->second;
+    }
+    Slot& slot = probe(key);
+    return slot.epoch == _epoch ? slot.data : nullptr;
   }
 
   T* emplace(const int64_t key, int32_t emb_dim) {
-    _emb_dim = emb_dim;
-    T* ptr = nullptr;
-    switch (_emb_dim) {
-      case 64:
-        ptr = _cache64.emplace(key, 64).first->second.data;
-        break;
-      case 128:
-        ptr = _cache128.emplace(key, 128).first->second.data;
-        break;
-      case 256:
-        ptr = _cache256.emplace(key, 256).first->second.data;
-        break;
-      default:
-        ptr = _cache.emplace(key, emb_dim).first->second.data;
+    if (2 * (_rows.size() + 1) > _slots.size()) {
+      grow_index();
     }
-    _cached_ptr.emplace(key, ptr);
+    Slot& slot = probe(key);
+    if (slot.epoch == _epoch) {
+      return slot.data;
+    }
+    T* ptr = allocate_row(emb_dim);
+    memset(ptr, 0, emb_dim * sizeof(T));
+    slot = Slot{key, ptr, _epoch};
+    _rows.emplace_back(key, ptr);
     return ptr;
   }
 
@@ -127,15 +184,61 @@ class EmbeddingRowCache {
     return ptr;
   }
 
-  int64_t size() {
-    return _cached_ptr.size();
+  int64_t size() const {
+    return _rows.size();
+  }
+
+  const std::vector<std::pair<int64_t, T*>>& cache() const {
+    return _rows;
   }
 
-  const robin_hood::unordered_map<int64_t, T*> cache() const {
-    return _cached_ptr;
+  int64_t capacity() const {
+    return _arena_size;
+  }
+
+  void clear() {
+    _peak_used = std::max(_peak_used, _arena_used);
+    _peak_rows = std::max<int64_t>(_peak_rows, _rows.size());
+    _rows.clear();
+    _arena_used = 0;
+    _block_used = 0;
+    if (++_clears == kShrinkPeriod) {
+      shrink();
+    }
+    if (++_epoch == 0) {
+      // the epochs wrapped around, free the slots of the previous ones
+      for (auto& slot : _slots) {
+        slot.epoch = 0;
+      }
+      _epoch = 1;
+    }
+    if (_blocks.size() > 1) {
+      _blocks.clear();
+      _blocks.emplace_back(new T[_arena_size]);
+      _block_size = _arena_size;
+    }
+  }
+
+  void release() {
+    *this = EmbeddingRowCache();
   }
 };
 
+/**
+ * Caches of the calling thread, reused across the calls and cleared, see
+ * EmbeddingRowCache. A kernel takes them once per type, and may not hold them
+ * while calling another kernel which takes them.
+ */
+template <class T>
+std::vector<EmbeddingRowCache<T>>& reuse_row_caches(int64_t num_caches) {
+  thread_local std::vector<EmbeddingRowCache<T>> caches;
+  caches.resize(num_caches);
+  for (auto& cache : caches) {
+    cache.clear();
+  }
+  return caches;
+}
+
 struct SGDArgs {
   SGDArgs(const TensorList& bf16_trail_, float weight_decay_, float lr_)
       : bf16_trail(bf16_trail_), weight_decay(weight_decay_), lr(lr_) {}
@@ -159,6 +262,62 @@ struct AdaGradArgs {
   float lr;
 };
 
+/**
+ * Args of the Adam (with lazy moments), rowwise Adam and LAMB updates. Only the
+ * rows of the batch are updated, with their moments, in a single pass. The
+ * weight decay is the L2 penalty added to the grad for Adam, as for
+ * torch.optim.Adam, and is decoupled for LAMB.
+ *
+ * exp_avg and exp_avg_sq are [num_rows, emb_dim] tensors in the accumulate
+ * type of the weight (float for bfloat16 weights), in bfloat16, or in 8 bits:
+ * an 8 bits moment row holds emb_dim codes on a log scale below the largest
+ * magnitude of the row, followed by that magnitude in float, for a
+ * [num_rows, emb_dim + 4] tensor, int8 with a sign for exp_avg and uint8 for
+ * exp_avg_sq. The rowwise Adam keeps a single exp_avg_sq per row, a [num_rows]
+ * tensor in the accumulate type, the mean of the squared grads of the row.
+ *
+ * step is the number of the update, from 1, for the bias corrections.
+ */
+struct AdamArgs {
+  AdamArgs(
+      const TensorList& bf16_trail_,
+      const TensorList& exp_avg_,
+      const TensorList& exp_avg_sq_,
+      int64_t step_,
+      float beta1_,
+      float beta2_,
+      float eps_,
+      float lr_,
+      float weight_decay_)
+      : bf16_trail(bf16_trail_),
+        exp_avg(exp_avg_),
+        exp_avg_sq(exp_avg_sq_),
+        step(step_),
+        beta1(beta1_),
+        beta2(beta2_),
+        eps(eps_),
+        lr(lr_),
+        weight_decay(weight_decay_) {}
+
+  TensorList bf16_trail;
+  TensorList exp_avg;
+  TensorList exp_avg_sq;
+  int64_t step;
+  float beta1;
+  float beta2;
+  float eps;
+  float lr;
+  float weight_decay;
+};
+
+struct RowwiseAdamArgs : AdamArgs {
+  using AdamArgs::AdamArgs;
+};
+
+struct LambArgs : AdamArgs {
+  using AdamArgs::AdamArgs;
+};
+
 template <typename data_t, typename acc_t, typename optimizer_args_t>
 class EmbeddingGradUpdate {};
 
@@ -184,6 +343,39 @@ class EmbeddingGradUpdate<data_t, acc_t, AdaGradArgs> {
       const int64_t emb_dim);
 };
 
+template <typename data_t, typename acc_t>
+class EmbeddingGradUpdate<data_t, acc_t, AdamArgs> {
+ public:
+  static void update(
+      data_t* weight,
+      const EmbeddingRowCache<acc_t>& ewc,
+      const AdamArgs& args,
+      const int32_t table_id,
+      const int64_t emb_dim);
+};
+
+template <typename data_t, typename acc_t>
+class EmbeddingGradUpdate<data_t, acc_t, RowwiseAdamArgs> {
+ public:
+  static void update(
+      data_t* weight,
+      const EmbeddingRowCache<acc_t>& ewc,
+      const RowwiseAdamArgs& args,
+      const int32_t table_id,
+      const int64_t emb_dim);
+};
+
+template <typename data_t, typename acc_t>
+class EmbeddingGradUpdate<data_t, acc_t, LambArgs> {
+ public:
+  static void update(
+      data_t* weight,
+      const EmbeddingRowCache<acc_t>& ewc,
+      const LambArgs& args,
+      const int32_t table_id,
+      const int64_t emb_dim);
+};
+
 std::vector<Tensor> merged_embeddingbag_forward_cpu_kernel_impl(
     const std::vector<Tensor>& weights,
     const TensorList& indices,
@@ -222,6 +414,57 @@ void merged_embeddingbag_backward_adagrad_cpu_kernel_impl(
     const double eps,
     const double lr);
 
+void merged_embeddingbag_backward_adam_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
+void merged_embeddingbag_backward_rowwise_adam_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
+void merged_embeddingbag_backward_lamb_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
 std::tuple<std::vector<Tensor>, std::vector<Tensor>, std::vector<Tensor>>
 mergedemb_distribute_forward_local_kernel_impl(
     const Tensor& weight,
@@ -259,6 +502,51 @@ void mergedemb_distribute_backward_merge_adagrad_update_cpu(
     const float lr,
     const float eps);
 
+void mergedemb_distribute_backward_merge_adam_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
+void mergedemb_distribute_backward_merge_rowwise_adam_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
+void mergedemb_distribute_backward_merge_lamb_update_cpu(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay);
+
 } // namespace
 
 using merged_embeddingbag_forward_cpu_kernel_fn = std::vector<Tensor> (*)(
@@ -311,6 +599,33 @@ IPEX_DECLARE_DISPATCH(
     merged_embeddingbag_backward_adagrad_cpu_kernel_fn,
     merged_embeddingbag_backward_adagrad_cpu_kernel_stub);
 
+// The Adam, rowwise Adam and LAMB updates share their args
+using merged_embeddingbag_backward_adam_cpu_kernel_fn = void (*)(
+    const TensorList&,
+    const TensorList&,
+    const TensorList&,
+    const TensorList&,
+    const int64_t,
+    const bool,
+    const TensorList&,
+    const TensorList&,
+    const TensorList&,
+    const int64_t,
+    const double,
+    const double,
+    const double,
+    const double,
+    const double);
+IPEX_DECLARE_DISPATCH(
+    merged_embeddingbag_backward_adam_cpu_kernel_fn,
+    merged_embeddingbag_backward_adam_cpu_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    merged_embeddingbag_backward_adam_cpu_kernel_fn,
+    merged_embeddingbag_backward_rowwise_adam_cpu_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    merged_embeddingbag_backward_adam_cpu_kernel_fn,
+    merged_embeddingbag_backward_lamb_cpu_kernel_stub);
+
 using mergedemb_distribute_forward_local_kernel_fn = std::
     tuple<std::vector<Tensor>, std::vector<Tensor>, std::vector<Tensor>> (*)(
         const Tensor&,
@@ -360,6 +675,30 @@ IPEX_DECLARE_DISPATCH(
     mergedemb_distribute_backward_merge_adagrad_update_fn,
     mergedemb_distribute_backward_merge_adagrad_update_stub);
 
+using mergedemb_distribute_backward_merge_adam_update_fn = void (*)(
+    const TensorList&,
+    const TensorList&,
+    const TensorList&,
+    Tensor&,
+    Tensor&,
+    Tensor&,
+    Tensor&,
+    const int64_t,
+    const double,
+    const double,
+    const double,
+    const double,
+    const double);
+IPEX_DECLARE_DISPATCH(
+    mergedemb_distribute_backward_merge_adam_update_fn,
+    mergedemb_distribute_backward_merge_adam_update_stub);
+IPEX_DECLARE_DISPATCH(
+    mergedemb_distribute_backward_merge_adam_update_fn,
+    mergedemb_distribute_backward_merge_rowwise_adam_update_stub);
+IPEX_DECLARE_DISPATCH(
+    mergedemb_distribute_backward_merge_adam_update_fn,
+    mergedemb_distribute_backward_merge_lamb_update_stub);
+
 } // namespace cpu
 } // namespace torch_ipex
 
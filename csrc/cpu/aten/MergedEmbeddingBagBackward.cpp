@@ -6,6 +6,9 @@ namespace cpu {
 IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_cpu_kernel_stub);
 IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_sgd_cpu_kernel_stub);
 IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_adagrad_cpu_kernel_stub);
+IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_adam_cpu_kernel_stub);
+IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_rowwise_adam_cpu_kernel_stub);
+IPEX_DEFINE_DISPATCH(merged_embeddingbag_backward_lamb_cpu_kernel_stub);
 
 std::vector<Tensor> merged_embeddingbag_backward_cpu(
     const TensorList& grad_outs_,
@@ -102,6 +105,165 @@ void merged_embeddingbag_backward_adagrad_cpu(
       lr);
 }
 
+void merged_embeddingbag_backward_adam_cpu(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  /*
+  pointer to merged_embeddingbag_backward_adam_cpu_kernel_impl(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+  */
+  return merged_embeddingbag_backward_adam_cpu_kernel_stub(
+      kCPU,
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void merged_embeddingbag_backward_rowwise_adam_cpu(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  /*
+  pointer to merged_embeddingbag_backward_rowwise_adam_cpu_kernel_impl(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+  */
+  return merged_embeddingbag_backward_rowwise_adam_cpu_kernel_stub(
+      kCPU,
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void merged_embeddingbag_backward_lamb_cpu(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  /*
+  pointer to merged_embeddingbag_backward_lamb_cpu_kernel_impl(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+  */
+  return merged_embeddingbag_backward_lamb_cpu_kernel_stub(
+      kCPU,
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      include_last_offsets,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -126,6 +288,24 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "merged_embeddingbag_backward_adagrad",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::merged_embeddingbag_backward_adagrad_cpu);
+  m.def(
+      "merged_embeddingbag_backward_adam(Tensor[] grad, Tensor[] weight, Tensor[] index, Tensor[] offsets, int pooling_mode, bool include_last, Tensor[] exp_avg, Tensor[] exp_avg_sq, Tensor[] bf16_trail, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_adam",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_adam_cpu);
+  m.def(
+      "merged_embeddingbag_backward_rowwise_adam(Tensor[] grad, Tensor[] weight, Tensor[] index, Tensor[] offsets, int pooling_mode, bool include_last, Tensor[] exp_avg, Tensor[] exp_avg_sq, Tensor[] bf16_trail, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_rowwise_adam",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_rowwise_adam_cpu);
+  m.def(
+      "merged_embeddingbag_backward_lamb(Tensor[] grad, Tensor[] weight, Tensor[] index, Tensor[] offsets, int pooling_mode, bool include_last, Tensor[] exp_avg, Tensor[] exp_avg_sq, Tensor[] bf16_trail, int step, float beta1, float beta2, float eps, float lr, float weight_decay) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_lamb",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_lamb_cpu);
 }
 
 } // namespace
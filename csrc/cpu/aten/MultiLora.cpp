@@ -0,0 +1,144 @@
+#include "MultiLora.h"
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+#include <torch/csrc/autograd/function.h>
+
+#ifdef USE_LIBXSMM
+#include "Linear.h"
+#include "TPPGEMM.h"
+#endif
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(multi_lora_add_kernel_stub);
+
+at::Tensor& multi_lora_add_(
+    at::Tensor& output,
+    const at::Tensor& input,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings) {
+  RECORD_FUNCTION("ipex::multi_lora_add_", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      lora_a.dim() == 3 && lora_b.dim() == 3,
+      "multi_lora_add_: expect lora_a and lora_b of 3 dims");
+  auto num_adapters = lora_a.size(0);
+  auto rank = lora_a.size(1);
+  auto K = lora_a.size(2);
+  auto N = lora_b.size(2);
+  TORCH_CHECK(
+      lora_b.size(0) == num_adapters && lora_b.size(1) == rank,
+      "multi_lora_add_: lora_a and lora_b of different adapters or ranks");
+  TORCH_CHECK(
+      input.size(-1) == K && output.size(-1) == N,
+      "multi_lora_add_: input or output features mismatch the adapters");
+  TORCH_CHECK(
+      input.numel() / K == output.numel() / N,
+      "multi_lora_add_: input and output of different numbers of tokens");
+  auto T = input.numel() / K;
+  TORCH_CHECK(
+      indices.numel() == T,
+      "multi_lora_add_: expect one adapter index per token");
+  TORCH_CHECK(
+      scalings.numel() == num_adapters,
+      "multi_lora_add_: expect one scaling per adapter");
+  TORCH_CHECK(
+      input.scalar_type() == output.scalar_type() &&
+          lora_a.scalar_type() == output.scalar_type() &&
+          lora_b.scalar_type() == output.scalar_type(),
+      "multi_lora_add_: expect input, output and adapters of the same dtype");
+  if (T == 0 || rank == 0) {
+    return output;
+  }
+
+  auto input_2d = input.contiguous().view({T, K});
+  auto indices_ = indices.to(at::kLong).contiguous().view({T});
+  auto scalings_ = scalings.to(at::kFloat).contiguous();
+  auto lora_a_ = lora_a.contiguous();
+  auto lora_b_ = lora_b.contiguous();
+  if (output.is_contiguous()) {
+    auto output_2d = output.view({T, N});
+    multi_lora_add_kernel_stub(
+        kCPU, output_2d, input_2d, lora_a_, lora_b_, indices_, scalings_);
+  } else {
+    auto output_2d = output.contiguous().view({T, N});
+    multi_lora_add_kernel_stub(
+        kCPU, output_2d, input_2d, lora_a_, lora_b_, indices_, scalings_);
+    output.copy_(output_2d.view(output.sizes()));
+  }
+  return output;
+}
+
+#ifdef USE_LIBXSMM
+at::Tensor tpp_linear_multi_lora(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings,
+    c10::optional<int64_t> out_features) {
+  RECORD_FUNCTION(
+      "ipex::tpp_linear_multi_lora", c10::ArrayRef<c10::IValue>({}));
+
+  auto output = t_bias.numel() > 0
+      ? tpp_linear_bias_forward_cpu(t_in, t_wt, t_bias, out_features)
+      : tpp_linear_nobias_forward_cpu(t_in, t_wt, out_features);
+  return multi_lora_add_(output, t_in, lora_a, lora_b, indices, scalings);
+}
+
+at::Tensor woq_linear_multi_lora(
+    const at::Tensor& input,
+    const at::Tensor& op_context,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings) {
+  RECORD_FUNCTION(
+      "ipex::woq_linear_multi_lora", c10::ArrayRef<c10::IValue>({}));
+
+  auto output = woq_linear_forward(input, op_context);
+  if (output.scalar_type() != input.scalar_type()) {
+    output = output.to(input.scalar_type());
+  }
+  return multi_lora_add_(output, input, lora_a, lora_b, indices, scalings);
+}
+#endif
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "multi_lora_add_(Tensor(a!) self, Tensor input, Tensor lora_a, "
+      "Tensor lora_b, Tensor indices, Tensor scalings) -> Tensor(a!)");
+  m.impl(
+      "multi_lora_add_",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::multi_lora_add_);
+#ifdef USE_LIBXSMM
+  m.def(
+      "tpp_linear_multi_lora(Tensor t_in, Tensor t_wt, Tensor t_bias, "
+      "Tensor lora_a, Tensor lora_b, Tensor indices, Tensor scalings, "
+      "int? out_features=None) -> Tensor");
+  m.impl(
+      "tpp_linear_multi_lora",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tpp_linear_multi_lora);
+  m.def(
+      "woq_linear_multi_lora(Tensor input, Tensor W_prepack, Tensor lora_a, "
+      "Tensor lora_b, Tensor indices, Tensor scalings) -> Tensor");
+  m.impl(
+      "woq_linear_multi_lora",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::woq_linear_multi_lora);
+#endif
+}
+
+} // namespace
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Batched LoRA adapters of one linear layer, for serving requests that use
+// different adapters in the same batch.
+//
+// The adapters are stacked into a pool padded with zeros to the largest rank:
+//   lora_a:   [num_adapters, rank, in_features], lora_A.weight of each adapter
+//   lora_b:   [num_adapters, rank, out_features], lora_B.weight transposed
+//   scalings: [num_adapters], alpha / rank of each adapter
+// indices holds the adapter of each token, or a negative value for the tokens
+// without adapter.
+//
+// output[t] += scalings[a] * (input[t] @ lora_a[a].T) @ lora_b[a]
+// with a = indices[t], for input of [..., in_features] and output of
+// [..., out_features].
+at::Tensor& multi_lora_add_(
+    at::Tensor& output,
+    const at::Tensor& input,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings);
+
+#ifdef USE_LIBXSMM
+// Linear with a weight packed by TPP, followed by multi_lora_add_
+at::Tensor tpp_linear_multi_lora(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings,
+    c10::optional<int64_t> out_features);
+
+// Weight-only quantized linear, followed by multi_lora_add_
+at::Tensor woq_linear_multi_lora(
+    const at::Tensor& input,
+    const at::Tensor& op_context,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings);
+#endif
+
+namespace {
+
+void multi_lora_add_kernel_impl(
+    at::Tensor& output,
+    const at::Tensor& input,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings);
+}
+
+// 2D contiguous output [T, N] and input [T, K], int64 indices [T] and float
+// scalings
+using multi_lora_add_kernel_fn = void (*)(
+    at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&);
+IPEX_DECLARE_DISPATCH(multi_lora_add_kernel_fn, multi_lora_add_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
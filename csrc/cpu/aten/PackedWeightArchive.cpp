@@ -0,0 +1,364 @@
+#include "PackedWeightArchive.h"
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+#include "utils/isa_help.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+constexpr char kArchiveMagic[8] = {'I', 'P', 'E', 'X', 'P', 'K', 'W', '\0'};
+constexpr int64_t kArchiveVersion = 1;
+// Blobs start at page boundaries, so that each of them is mapped by its own
+// pages and is aligned for any vector load
+constexpr int64_t kBlobAlign = 4096;
+
+// a + b of non-negative sizes, failing instead of overflowing
+int64_t checked_add(int64_t a, int64_t b, const std::string& what) {
+  TORCH_CHECK(
+      a >= 0 && b >= 0 && a <= std::numeric_limits<int64_t>::max() - b,
+      what,
+      ": size overflow");
+  return a + b;
+}
+
+int64_t align_up(int64_t n) {
+  n = checked_add(n, kBlobAlign - 1, "packed weight archive");
+  return n / kBlobAlign * kBlobAlign;
+}
+
+void put_int(std::string& buf, int64_t v) {
+  buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void put_str(std::string& buf, const std::string& s) {
+  put_int(buf, s.size());
+  buf.append(s);
+}
+
+// Reads the header with bounds checks, so that a truncated or corrupted
+// archive fails with an error instead of reading beyond the mapping
+struct HeaderReader {
+  const char* data;
+  int64_t size;
+  const std::string& path;
+  int64_t pos = 0;
+
+  const char* take(int64_t n) {
+    TORCH_CHECK(
+        n >= 0 && n <= size - pos,
+        "load_packed_weights: truncated header of ",
+        path);
+    auto p = data + pos;
+    pos += n;
+    return p;
+  }
+
+  int64_t get_int() {
+    int64_t v;
+    std::memcpy(&v, take(sizeof(v)), sizeof(v));
+    return v;
+  }
+
+  std::string get_str() {
+    auto n = get_int();
+    auto p = take(n);
+    return std::string(p, n);
+  }
+};
+
+struct MappedArchive {
+  void* addr;
+  size_t size;
+
+  MappedArchive(void* addr, size_t size) : addr(addr), size(size) {}
+
+  ~MappedArchive() {
+    munmap(addr, size);
+  }
+};
+
+std::string make_header(
+    const std::vector<std::string>& names,
+    const std::vector<at::Tensor>& tensors,
+    const std::string& metadata,
+    const std::vector<int64_t>& offsets) {
+  std::string buf(kArchiveMagic, sizeof(kArchiveMagic));
+  put_int(buf, kArchiveVersion);
+  put_str(buf, packed_weight_isa_signature());
+  put_str(buf, metadata);
+  put_int(buf, tensors.size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    const auto& t = tensors[i];
+    put_str(buf, names[i]);
+    put_int(buf, static_cast<int64_t>(t.scalar_type()));
+    put_int(buf, t.dim());
+    for (auto s : t.sizes()) {
+      put_int(buf, s);
+    }
+    put_int(buf, offsets[i]);
+    put_int(buf, t.nbytes());
+  }
+  return buf;
+}
+
+} // namespace
+
+std::string packed_weight_isa_signature() {
+  return get_current_isa_level() + "/" + get_current_onednn_isa_level();
+}
+
+void save_packed_weights(
+    const std::string& path,
+    const std::vector<std::string>& names,
+    const std::vector<at::Tensor>& tensors,
+    const std::string& metadata) {
+  RECORD_FUNCTION("ipex::save_packed_weights", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      names.size() == tensors.size(),
+      "save_packed_weights: expect one name per tensor");
+  std::vector<at::Tensor> contiguous;
+  contiguous.reserve(tensors.size());
+  for (const auto& t : tensors) {
+    TORCH_CHECK(
+        t.device().is_cpu() && !t.is_quantized() && t.layout() == at::kStrided,
+        "save_packed_weights: expect dense CPU tensors");
+    contiguous.push_back(t.contiguous());
+  }
+  // The size of the header does not depend on the offsets
+  std::vector<int64_t> offsets(contiguous.size(), 0);
+  auto pos = align_up(make_header(names, contiguous, metadata, offsets).size());
+  for (size_t i = 0; i < contiguous.size(); i++) {
+    offsets[i] = pos;
+    pos = align_up(checked_add(
+        pos, contiguous[i].nbytes(), "save_packed_weights: " + path));
+  }
+  auto header = make_header(names, contiguous, metadata, offsets);
+
+  // Processes may have mapped the archive at path, which must not change
+  // under them. Write a new file and rename it over path, so that they keep
+  // the previous file while the later loads get the new one.
+  auto tmp_path = path + ".tmp." + std::to_string(getpid());
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  TORCH_CHECK(
+      fd >= 0,
+      "save_packed_weights: failed to open ",
+      tmp_path,
+      " to write: ",
+      std::strerror(errno));
+  auto fail = [&](const char* what) {
+    int err = errno;
+    close(fd);
+    unlink(tmp_path.c_str());
+    TORCH_CHECK(
+        false,
+        "save_packed_weights: failed to ",
+        what,
+        " ",
+        tmp_path,
+        ": ",
+        std::strerror(err));
+  };
+  auto write_all = [&](const char* data, int64_t n) {
+    while (n > 0) {
+      auto written = write(fd, data, n);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        fail("write");
+      }
+      data += written;
+      n -= written;
+    }
+  };
+  write_all(header.data(), header.size());
+  int64_t written = header.size();
+  std::vector<char> zeros(kBlobAlign, 0);
+  for (size_t i = 0; i < contiguous.size(); i++) {
+    write_all(zeros.data(), offsets[i] - written);
+    auto nbytes = contiguous[i].nbytes();
+    write_all(static_cast<const char*>(contiguous[i].data_ptr()), nbytes);
+    written = offsets[i] + nbytes;
+  }
+  if (fsync(fd) != 0) {
+    fail("sync");
+  }
+  if (close(fd) != 0) {
+    int err = errno;
+    unlink(tmp_path.c_str());
+    TORCH_CHECK(
+        false,
+        "save_packed_weights: failed to close ",
+        tmp_path,
+        ": ",
+        std::strerror(err));
+  }
+  if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+    int err = errno;
+    unlink(tmp_path.c_str());
+    TORCH_CHECK(
+        false,
+        "save_packed_weights: failed to rename ",
+        tmp_path,
+        " to ",
+        path,
+        ": ",
+        std::strerror(err));
+  }
+}
+
+std::tuple<
+    std::vector<std::string>,
+    std::vector<at::Tensor>,
+    std::string,
+    std::string>
+load_packed_weights(const std::string& path) {
+  RECORD_FUNCTION("ipex::load_packed_weights", c10::ArrayRef<c10::IValue>({}));
+
+  int fd = open(path.c_str(), O_RDONLY);
+  TORCH_CHECK(
+      fd >= 0,
+      "load_packed_weights: failed to open ",
+      path,
+      ": ",
+      std::strerror(errno));
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(kArchiveMagic)) {
+    close(fd);
+    TORCH_CHECK(false, "load_packed_weights: ", path, " is not an archive");
+  }
+  void* addr = mmap(
+      nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  int err = errno;
+  close(fd);
+  TORCH_CHECK(
+      addr != MAP_FAILED,
+      "load_packed_weights: failed to map ",
+      path,
+      ": ",
+      std::strerror(err));
+  auto mapping = std::make_shared<MappedArchive>(addr, st.st_size);
+
+  HeaderReader reader{static_cast<const char*>(addr), st.st_size, path};
+  TORCH_CHECK(
+      std::memcmp(
+          reader.take(sizeof(kArchiveMagic)),
+          kArchiveMagic,
+          sizeof(kArchiveMagic)) == 0,
+      "load_packed_weights: ",
+      path,
+      " is not an archive");
+  auto version = reader.get_int();
+  TORCH_CHECK(
+      version == kArchiveVersion,
+      "load_packed_weights: unsupported version ",
+      version,
+      " of ",
+      path);
+  auto isa = reader.get_str();
+  auto metadata = reader.get_str();
+  auto num_tensors = reader.get_int();
+  TORCH_CHECK(
+      num_tensors >= 0, "load_packed_weights: corrupted header of ", path);
+
+  std::vector<std::string> names;
+  std::vector<at::Tensor> tensors;
+  for (int64_t i = 0; i < num_tensors; i++) {
+    names.push_back(reader.get_str());
+    auto dtype = reader.get_int();
+    auto dim = reader.get_int();
+    // Each size takes 8 bytes of the header
+    TORCH_CHECK(
+        dtype >= 0 &&
+            dtype < static_cast<int64_t>(at::ScalarType::NumOptions) &&
+            dim >= 0 && dim <= (reader.size - reader.pos) / 8,
+        "load_packed_weights: corrupted header of ",
+        path);
+    auto scalar_type = static_cast<at::ScalarType>(dtype);
+    std::vector<int64_t> sizes(dim);
+    // Bytes of the sizes read so far, bounded by the size of the file so
+    // that the product does not overflow
+    int64_t expected_nbytes = c10::elementSize(scalar_type);
+    for (auto& s : sizes) {
+      s = reader.get_int();
+      TORCH_CHECK(
+          s >= 0 && (s == 0 || expected_nbytes <= (int64_t)st.st_size / s),
+          "load_packed_weights: corrupted header of ",
+          path);
+      expected_nbytes *= s;
+    }
+    auto offset = reader.get_int();
+    auto nbytes = reader.get_int();
+    TORCH_CHECK(
+        nbytes == expected_nbytes && offset % kBlobAlign == 0 &&
+            offset >= reader.pos && offset <= st.st_size &&
+            nbytes <= st.st_size - offset,
+        "load_packed_weights: corrupted entry ",
+        names.back(),
+        " of ",
+        path);
+    auto options = at::TensorOptions().dtype(scalar_type);
+    if (nbytes == 0) {
+      tensors.push_back(at::empty(sizes, options));
+      continue;
+    }
+    // Each tensor holds the mapping until it is released
+    tensors.push_back(at::from_blob(
+        static_cast<char*>(addr) + offset,
+        sizes,
+        [mapping](void*) {},
+        options));
+  }
+  return std::make_tuple(names, tensors, metadata, isa);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+void save_packed_weights(
+    c10::string_view path,
+    const std::vector<std::string>& names,
+    const std::vector<at::Tensor>& tensors,
+    c10::string_view metadata) {
+  torch_ipex::cpu::save_packed_weights(
+      std::string(path), names, tensors, std::string(metadata));
+}
+
+std::tuple<
+    std::vector<std::string>,
+    std::vector<at::Tensor>,
+    std::string,
+    std::string>
+load_packed_weights(c10::string_view path) {
+  return torch_ipex::cpu::load_packed_weights(std::string(path));
+}
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "packed_weight_isa_signature() -> str",
+      torch_ipex::cpu::packed_weight_isa_signature);
+  m.def(
+      "save_packed_weights(str path, str[] names, Tensor[] tensors, "
+      "str metadata) -> ()",
+      save_packed_weights);
+  m.def(
+      "load_packed_weights(str path) -> (str[], Tensor[], str, str)",
+      load_packed_weights);
+}
+
+} // namespace
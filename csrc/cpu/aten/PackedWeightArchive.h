@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// On-disk archive of prepacked weights, so that a process restores the
+// weights packed by a previous one instead of repacking the checkpoint.
+//
+// The archive is
+//   header: magic, version, ISA signature, metadata and tensor table
+//   blobs:  the bytes of each tensor, starting at a multiple of the page size
+// The tensor table has the name, dtype, sizes, offset and size of each blob.
+// The metadata is an opaque string for the caller, usually JSON describing
+// how to rebuild the op contexts from the tensors.
+//
+// The ISA signature is the ISA level of the kernels and of oneDNN of the
+// process which packed the weights, as the packed layouts depend on them.
+
+// ISA signature of the current process
+std::string packed_weight_isa_signature();
+
+// Write tensors to path, replacing it. The tensors are written as contiguous
+// tensors to a new file, which is synced and renamed to path, so that the
+// processes which mapped the previous archive keep reading it unchanged.
+void save_packed_weights(
+    const std::string& path,
+    const std::vector<std::string>& names,
+    const std::vector<at::Tensor>& tensors,
+    const std::string& metadata);
+
+// Map path into memory and return the names, tensors, metadata and ISA
+// signature of the archive. The tensors are views of the mapping without
+// copies, which is unmapped once they are all released. The mapping is
+// private and writable: the pages stay shared with the page cache and with
+// the other processes mapping the file until they are written, which only
+// copies the written pages.
+std::tuple<
+    std::vector<std::string>,
+    std::vector<at::Tensor>,
+    std::string,
+    std::string>
+load_packed_weights(const std::string& path);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -7,6 +7,36 @@ namespace cpu {
 
 IPEX_DEFINE_DISPATCH(single_query_cached_kv_attention_kernel_stub);
 IPEX_DEFINE_DISPATCH(reshape_and_cache_kernel_stub);
+IPEX_DEFINE_DISPATCH(tree_cached_kv_attention_kernel_stub);
+IPEX_DEFINE_DISPATCH(tree_accept_kv_cache_kernel_stub);
+IPEX_DEFINE_DISPATCH(copy_blocks_kernel_stub);
+IPEX_DEFINE_DISPATCH(swap_blocks_kernel_stub);
+IPEX_DEFINE_DISPATCH(hash_kv_blocks_kernel_stub);
+
+namespace {
+
+// Check the [num_pairs, 2] block mapping against the number of blocks of the
+// source and destination caches, and return it as contiguous int64
+at::Tensor check_block_mapping(
+    const at::Tensor& block_mapping,
+    int64_t num_src_blocks,
+    int64_t num_dst_blocks) {
+  TORCH_CHECK(
+      block_mapping.dim() == 2 && block_mapping.size(1) == 2,
+      "expect block_mapping of [num_pairs, 2]");
+  auto mapping = block_mapping.to(at::kLong).contiguous();
+  auto mapping_ptr = mapping.data_ptr<int64_t>();
+  for (int64_t i = 0; i < mapping.size(0); i++) {
+    TORCH_CHECK(
+        mapping_ptr[2 * i] >= 0 && mapping_ptr[2 * i] < num_src_blocks &&
+            mapping_ptr[2 * i + 1] >= 0 &&
+            mapping_ptr[2 * i + 1] < num_dst_blocks,
+        "block_mapping out of range of the blocks of the caches");
+  }
+  return mapping;
+}
+
+} // namespace
 
 /*
  *Caculate the masked multihead attention for decoder layer in decoder only
@@ -48,6 +78,191 @@ void reshape_and_cache_cpu(
       kCPU, key, value, key_cache, value_cache, slot_mapping);
 }
 
+void copy_blocks(
+    at::TensorList key_caches,
+    at::TensorList value_caches,
+    const at::Tensor& block_mapping) {
+  RECORD_FUNCTION("ipex::copy_blocks", c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(
+      key_caches.size() == value_caches.size(),
+      "copy_blocks: expect the key and value caches of the same layers");
+  if (key_caches.empty() || block_mapping.numel() == 0) {
+    return;
+  }
+  for (size_t i = 0; i < key_caches.size(); i++) {
+    TORCH_CHECK(
+        key_caches[i].sizes() == key_caches[0].sizes() &&
+            value_caches[i].sizes() == key_caches[0].sizes() &&
+            key_caches[i].scalar_type() == key_caches[0].scalar_type() &&
+            value_caches[i].scalar_type() == key_caches[0].scalar_type() &&
+            key_caches[i].is_contiguous() && value_caches[i].is_contiguous(),
+        "copy_blocks: expect contiguous caches of the same shape and dtype");
+  }
+  auto num_blocks = key_caches[0].size(0);
+  auto mapping = check_block_mapping(block_mapping, num_blocks, num_blocks);
+  return copy_blocks_kernel_stub(kCPU, key_caches, value_caches, mapping);
+}
+
+void swap_blocks(
+    const at::Tensor& src,
+    at::Tensor& dst,
+    const at::Tensor& block_mapping) {
+  RECORD_FUNCTION("ipex::swap_blocks", c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(
+      src.is_contiguous() && dst.is_contiguous(),
+      "swap_blocks: expect contiguous caches");
+  TORCH_CHECK(
+      src.dim() > 0 && src.dim() == dst.dim() &&
+          src[0].numel() == dst[0].numel(),
+      "swap_blocks: expect caches of blocks of the same shape");
+  if (block_mapping.numel() == 0) {
+    return;
+  }
+  auto mapping = check_block_mapping(block_mapping, src.size(0), dst.size(0));
+  return swap_blocks_kernel_stub(kCPU, src, dst, mapping);
+}
+
+at::Tensor hash_kv_blocks(
+    const at::Tensor& token_ids,
+    const at::Tensor& seq_lens,
+    int64_t block_size,
+    const c10::optional<at::Tensor>& extra_hashes) {
+  RECORD_FUNCTION("ipex::hash_kv_blocks", c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(block_size > 0, "hash_kv_blocks: expect a positive block_size");
+  auto token_ids_ = token_ids.dim() == 1 ? token_ids.unsqueeze(0) : token_ids;
+  TORCH_CHECK(
+      token_ids_.dim() == 2, "hash_kv_blocks: expect token_ids of 2 dims");
+  auto num_seqs = token_ids_.size(0);
+  TORCH_CHECK(
+      seq_lens.numel() == num_seqs,
+      "hash_kv_blocks: expect one length per sequence");
+  auto seq_lens_ = seq_lens.to(at::kLong).contiguous();
+  auto seq_lens_ptr = seq_lens_.data_ptr<int64_t>();
+  for (int64_t i = 0; i < num_seqs; i++) {
+    TORCH_CHECK(
+        seq_lens_ptr[i] >= 0 && seq_lens_ptr[i] <= token_ids_.size(1),
+        "hash_kv_blocks: seq_lens out of range of token_ids");
+  }
+  at::Tensor extra;
+  if (extra_hashes.has_value()) {
+    TORCH_CHECK(
+        extra_hashes.value().numel() == num_seqs,
+        "hash_kv_blocks: expect one extra hash per sequence");
+    extra = extra_hashes.value().to(at::kLong).contiguous();
+  }
+  return hash_kv_blocks_kernel_stub(
+      kCPU,
+      token_ids_.to(at::kLong).contiguous(),
+      seq_lens_,
+      block_size,
+      extra);
+}
+
+void tree_cached_kv_attention(
+    at::Tensor& out,
+    at::Tensor& query,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& head_mapping,
+    const double scale,
+    at::Tensor& block_tables,
+    at::Tensor& context_lens,
+    at::Tensor& tree_parents,
+    int64_t block_size,
+    const c10::optional<at::Tensor>& alibi_slopes) {
+  RECORD_FUNCTION(
+      "ipex::tree_cached_kv_attention", c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(
+      query.dim() == 4 && out.sizes() == query.sizes(),
+      "tree_cached_kv_attention: expect query and out of [num_seqs, ",
+      "num_tree_tokens, num_heads, head_size]");
+  auto num_seqs = query.size(0);
+  auto num_tree_tokens = query.size(1);
+  TORCH_CHECK(
+      tree_parents.numel() == num_tree_tokens ||
+          tree_parents.numel() == num_seqs * num_tree_tokens,
+      "tree_cached_kv_attention: expect one parent per tree token");
+  auto parents = tree_parents.to(at::kInt)
+                     .reshape({-1, num_tree_tokens})
+                     .expand({num_seqs, num_tree_tokens})
+                     .contiguous();
+  return tree_cached_kv_attention_kernel_stub(
+      kCPU,
+      out,
+      query,
+      key_cache,
+      value_cache,
+      head_mapping,
+      scale,
+      block_tables,
+      context_lens,
+      parents,
+      block_size,
+      alibi_slopes);
+}
+
+void tree_accept_kv_cache(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& block_tables,
+    at::Tensor& prefix_lens,
+    at::Tensor& accepted,
+    at::Tensor& num_accepted) {
+  RECORD_FUNCTION("ipex::tree_accept_kv_cache", c10::ArrayRef<c10::IValue>({}));
+  auto num_seqs = block_tables.size(0);
+  TORCH_CHECK(
+      accepted.dim() == 2 && accepted.size(0) == num_seqs &&
+          num_accepted.numel() == num_seqs && prefix_lens.numel() == num_seqs,
+      "tree_accept_kv_cache: expect accepted of [num_seqs, max_num_accepted]",
+      " and one prefix_len and num_accepted per sequence");
+  auto accepted_ = accepted.to(at::kInt).contiguous();
+  auto num_accepted_ = num_accepted.to(at::kInt).contiguous();
+  auto prefix_lens_ = prefix_lens.to(at::kInt).contiguous();
+  // The accepted tokens form a path from the root, so that they are in
+  // ascending order, and each of them only moves towards the prefix.
+  TORCH_CHECK(
+      key_cache.dim() == 4,
+      "tree_accept_kv_cache: expect key_cache of [num_blocks, block_size, ",
+      "num_heads, head_size]");
+  // Each accepted token is read from the slot of prefix_len + token, which
+  // must be mapped by the block table of the sequence.
+  auto max_num_slots = block_tables.size(1) * key_cache.size(1);
+  auto accepted_ptr = accepted_.data_ptr<int>();
+  auto num_accepted_ptr = num_accepted_.data_ptr<int>();
+  auto prefix_lens_ptr = prefix_lens_.data_ptr<int>();
+  auto max_num_accepted = accepted_.size(1);
+  for (int64_t i = 0; i < num_seqs; i++) {
+    TORCH_CHECK(
+        num_accepted_ptr[i] >= 0 && num_accepted_ptr[i] <= max_num_accepted,
+        "tree_accept_kv_cache: num_accepted out of range");
+    TORCH_CHECK(
+        prefix_lens_ptr[i] >= 0, "tree_accept_kv_cache: negative prefix_len");
+    for (int64_t t = 0; t < num_accepted_ptr[i]; t++) {
+      auto token = accepted_ptr[i * max_num_accepted + t];
+      TORCH_CHECK(
+          token >= t &&
+              (t == 0 || token > accepted_ptr[i * max_num_accepted + t - 1]),
+          "tree_accept_kv_cache: expect the accepted tokens in ascending ",
+          "order");
+      TORCH_CHECK(
+          prefix_lens_ptr[i] + static_cast<int64_t>(token) < max_num_slots,
+          "tree_accept_kv_cache: accepted token ",
+          token,
+          " of sequence ",
+          i,
+          " is out of the slots of its block table");
+    }
+  }
+  return tree_accept_kv_cache_kernel_stub(
+      kCPU,
+      key_cache,
+      value_cache,
+      block_tables,
+      prefix_lens_,
+      accepted_,
+      num_accepted_);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -68,5 +283,33 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "reshape_and_cache",
       c10::DispatchKey::CPU,
       torch_ipex::cpu::reshape_and_cache_cpu);
+  m.def(
+      "tree_cached_kv_attention(Tensor(a!) out, Tensor query, "
+      "Tensor key_cache, Tensor value_cache, Tensor head_mapping, float scale, "
+      "Tensor block_tables, Tensor context_lens, Tensor tree_parents, "
+      "int block_size, Tensor? alibi_slopes) -> ()");
+  m.impl(
+      "tree_cached_kv_attention",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tree_cached_kv_attention);
+  m.def(
+      "tree_accept_kv_cache(Tensor(a!) key_cache, Tensor(b!) value_cache, "
+      "Tensor block_tables, Tensor prefix_lens, Tensor accepted, "
+      "Tensor num_accepted) -> ()");
+  m.impl(
+      "tree_accept_kv_cache",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tree_accept_kv_cache);
+  m.def(
+      "copy_blocks(Tensor(a!)[] key_caches, Tensor(b!)[] value_caches, "
+      "Tensor block_mapping) -> ()");
+  m.impl("copy_blocks", c10::DispatchKey::CPU, torch_ipex::cpu::copy_blocks);
+  m.def("swap_blocks(Tensor src, Tensor(a!) dst, Tensor block_mapping) -> ()");
+  m.impl("swap_blocks", c10::DispatchKey::CPU, torch_ipex::cpu::swap_blocks);
+  m.def(
+      "hash_kv_blocks(Tensor token_ids, Tensor seq_lens, int block_size, "
+      "Tensor? extra_hashes=None) -> Tensor");
+  m.impl(
+      "hash_kv_blocks", c10::DispatchKey::CPU, torch_ipex::cpu::hash_kv_blocks);
 }
 } // namespace
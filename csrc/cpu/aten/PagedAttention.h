@@ -29,6 +29,68 @@ void reshape_and_cache(
     at::Tensor& value_cache,
     at::Tensor& slot_mapping);
 
+// Attention of the tokens of a speculative token tree over the cached keys
+// and values, to verify the tree in one step of speculative decoding. The
+// keys and values of the num_tree_tokens tokens are expected in the cache,
+// after the context_lens[i] - num_tree_tokens tokens of the prefix of
+// sequence i. A tree token attends to the prefix, its ancestors and itself.
+void tree_cached_kv_attention(
+    at::Tensor& out, // [num_seqs, num_tree_tokens, num_heads, head_size]
+    at::Tensor& query, // [num_seqs, num_tree_tokens, num_heads, head_size]
+    at::Tensor& key_cache, // [num_blocks,  block_size, num_heads, head_size]
+    at::Tensor& value_cache, // [num_blocks,  block_size, num_heads, head_size]
+    at::Tensor& head_mapping, // [num_heads]
+    const double scale,
+    at::Tensor& block_tables, // [num_seqs, max_num_blocks_per_seq]
+    at::Tensor& context_lens, // [num_seqs], including the tree tokens
+    at::Tensor& tree_parents, // [num_tree_tokens] or [num_seqs, ...]
+    int64_t block_size,
+    const c10::optional<at::Tensor>& alibi_slopes);
+
+// Move the keys and values of the accepted tokens of the token tree of each
+// sequence right after its prefix, so that the accepted path is contiguous
+// in the cache.
+void tree_accept_kv_cache(
+    at::Tensor& key_cache, // [num_blocks,  block_size, num_heads, head_size]
+    at::Tensor& value_cache, // [num_blocks,  block_size, num_heads, head_size]
+    at::Tensor& block_tables, // [num_seqs, max_num_blocks_per_seq]
+    at::Tensor& prefix_lens, // [num_seqs], excluding the tree tokens
+    at::Tensor& accepted, // [num_seqs, max_num_accepted], tree tokens
+    at::Tensor& num_accepted); // [num_seqs]
+
+// Block management of the paged cache, for copy-on-write of the blocks
+// shared by sequences, swapping between the cache and a host tier, and
+// automatic prefix caching.
+//
+// Copy the blocks block_mapping[i][0] to block_mapping[i][1] of the caches
+// of all layers. block_mapping is [num_pairs, 2].
+void copy_blocks(
+    at::TensorList key_caches,
+    at::TensorList value_caches,
+    const at::Tensor& block_mapping);
+
+// Copy the blocks block_mapping[i][0] of src to the blocks block_mapping[i][1]
+// of dst. src and dst may be of different float dtypes, e.g. to swap to a
+// host tier in lower precision.
+void swap_blocks(
+    const at::Tensor& src,
+    at::Tensor& dst,
+    const at::Tensor& block_mapping);
+
+// Hash of the tokens of each full block of block_size tokens of each
+// sequence, chained with the hashes of the blocks before it, so that equal
+// hashes mean equal prefixes and the cached blocks can be reused. The hash is
+// SHA-256, so that a prompt cannot be crafted to collide with the blocks of
+// other requests. extra_hashes of [num_seqs] seeds the chain of each
+// sequence, e.g. for the adapter of the sequence. Returns the 256-bit digests
+// as int64 of [num_seqs, max_len / block_size, 4], 0 for the blocks beyond
+// seq_lens.
+at::Tensor hash_kv_blocks(
+    const at::Tensor& token_ids, // [num_seqs, max_len]
+    const at::Tensor& seq_lens, // [num_seqs]
+    int64_t block_size,
+    const c10::optional<at::Tensor>& extra_hashes);
+
 using single_query_cached_kv_attention_fn = void (*)(
     at::Tensor& out, // [num_seqs, num_heads, head_size]
     at::Tensor& query, // [num_seqs, num_heads, head_size]
@@ -52,7 +114,53 @@ using reshape_and_cache_fn = void (*)(
 IPEX_DECLARE_DISPATCH(
     single_query_cached_kv_attention_fn,
     single_query_cached_kv_attention_kernel_stub);
+using tree_cached_kv_attention_fn = void (*)(
+    at::Tensor& out,
+    at::Tensor& query,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& head_mapping,
+    const double scale,
+    at::Tensor& block_tables,
+    at::Tensor& context_lens,
+    at::Tensor& tree_parents, // [num_seqs, num_tree_tokens]
+    int64_t block_size,
+    const c10::optional<at::Tensor>& alibi_slopes);
+
+using tree_accept_kv_cache_fn = void (*)(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& block_tables,
+    at::Tensor& prefix_lens,
+    at::Tensor& accepted,
+    at::Tensor& num_accepted);
+
+using copy_blocks_fn = void (*)(
+    at::TensorList key_caches,
+    at::TensorList value_caches,
+    const at::Tensor& block_mapping);
+
+using swap_blocks_fn = void (*)(
+    const at::Tensor& src,
+    at::Tensor& dst,
+    const at::Tensor& block_mapping);
+
+using hash_kv_blocks_fn = at::Tensor (*)(
+    const at::Tensor& token_ids,
+    const at::Tensor& seq_lens,
+    int64_t block_size,
+    const at::Tensor& extra_hashes); // undefined for no extra hashes
+
 IPEX_DECLARE_DISPATCH(reshape_and_cache_fn, reshape_and_cache_kernel_stub);
+IPEX_DECLARE_DISPATCH(copy_blocks_fn, copy_blocks_kernel_stub);
+IPEX_DECLARE_DISPATCH(swap_blocks_fn, swap_blocks_kernel_stub);
+IPEX_DECLARE_DISPATCH(hash_kv_blocks_fn, hash_kv_blocks_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    tree_cached_kv_attention_fn,
+    tree_cached_kv_attention_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    tree_accept_kv_cache_fn,
+    tree_accept_kv_cache_kernel_stub);
 
 } // namespace cpu
 } // namespace torch_ipex
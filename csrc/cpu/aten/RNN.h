@@ -22,6 +22,14 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm(
 
 namespace cpu {
 
+// Shuffle the gates of PyTorch RNN weights/biases into the oneDNN order
+at::Tensor _shuffle_weight(const at::Tensor& weight, int64_t fn_mode);
+
+at::Tensor _shuffle_bias(
+    const at::Tensor& bias_ih,
+    const at::Tensor& bias_hh,
+    int64_t fn_mode);
+
 struct QuantizedLstmParams {
   const float scale;
   const int32_t zp;
@@ -0,0 +1,144 @@
+#include "RnntGreedyDecode.h"
+#include <ATen/Parallel.h>
+#include <ATen/Tensor.h>
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(rnnt_lstm_pack_weight_kernel_stub);
+IPEX_DEFINE_DISPATCH(rnnt_greedy_decode_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace torch_ipex {
+namespace kernel {
+
+/*
+  rnnt_lstm_pack_weight: pack the weights of one layer of the prediction
+  network LSTM for rnnt_greedy_decode.
+  The input-to-hidden and hidden-to-hidden weights are concatenated along the
+  input channel and transposed so that each step of a layer is a single GEMM
+  of [x, h] against the packed weight. Both biases are summed.
+
+  weight_ih: [4*hidden_size, input_size]
+  weight_hh: [4*hidden_size, hidden_size]
+  bias_ih, bias_hh: [4*hidden_size]
+
+  return: packed weight [input_size + hidden_size, 4*hidden_size] and packed
+  bias [4*hidden_size]
+*/
+static std::tuple<at::Tensor, at::Tensor> rnnt_lstm_pack_weight(
+    const at::Tensor& weight_ih,
+    const at::Tensor& weight_hh,
+    const at::Tensor& bias_ih,
+    const at::Tensor& bias_hh) {
+#if defined(IPEX_DISP_OP)
+  printf("IPEX::rnnt_lstm_pack_weight\n");
+#endif
+  RECORD_FUNCTION(
+      "IPEX::rnnt_lstm_pack_weight", c10::ArrayRef<c10::IValue>({}));
+
+  return torch_ipex::cpu::rnnt_lstm_pack_weight_kernel_stub(
+      kCPU, weight_ih, weight_hh, bias_ih, bias_hh);
+}
+
+/*
+  rnnt_greedy_decode: the whole greedy decoding loop of RNN-T in one op.
+  For each utterance, walk through the valid time steps of the encoder
+  output and emit up to max_symbols non-blank symbols per time step. The
+  prediction network (embedding + LSTM) and the joint network run inside the
+  kernel on a compacted batch of the unfinished utterances; finished
+  utterances are dropped from the working set without returning to Python.
+
+  x: the feature got from the encoder, [batch_size, time_step, enc_dim],
+  f32 or bf16
+  out_lens: valid time step of the encoded feature, [batch_size]
+  embedding_table: the embedding of the prediction network,
+  [vocab_size - 1, embedding_dim]; the _SOS label looks up a zero vector
+  lstm_weights, lstm_biases: per-layer weights packed by rnnt_lstm_pack_weight
+  joint_enc_weight, joint_enc_bias: joint network projection of x,
+  [joint_dim, enc_dim], [joint_dim]
+  joint_pred_weight, joint_pred_bias: joint network projection of the
+  prediction network output, [joint_dim, pred_dim], [joint_dim]
+  joint_fc_weight, joint_fc_bias: joint network classifier,
+  [vocab_size, joint_dim], [vocab_size]
+  max_symbols: the max symbols to generate per time step
+  blank_id: id for blank symbol
+  _SOS: the mark of the Start Of Sequence
+
+  return: labels [batch_size, max_len * max_symbols] padded with _SOS, and the
+  number of valid labels of each utterance [batch_size], both torch.int64
+*/
+static std::tuple<at::Tensor, at::Tensor> rnnt_greedy_decode(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    std::vector<at::Tensor> lstm_weights,
+    std::vector<at::Tensor> lstm_biases,
+    const at::Tensor& joint_enc_weight,
+    const at::Tensor& joint_enc_bias,
+    const at::Tensor& joint_pred_weight,
+    const at::Tensor& joint_pred_bias,
+    const at::Tensor& joint_fc_weight,
+    const at::Tensor& joint_fc_bias,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS) {
+#if defined(IPEX_DISP_OP)
+  printf("IPEX::rnnt_greedy_decode\n");
+#endif
+  RECORD_FUNCTION("IPEX::rnnt_greedy_decode", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(x.dim() == 3, "rnnt_greedy_decode: expect x to be 3D");
+  TORCH_CHECK(
+      lstm_weights.size() == lstm_biases.size() && lstm_weights.size() > 0,
+      "rnnt_greedy_decode: expect the same non-zero number of LSTM weights and biases");
+  TORCH_CHECK(max_symbols > 0, "rnnt_greedy_decode: max_symbols should be > 0");
+
+  return torch_ipex::cpu::rnnt_greedy_decode_kernel_stub(
+      kCPU,
+      x,
+      out_lens,
+      embedding_table,
+      lstm_weights,
+      lstm_biases,
+      joint_enc_weight,
+      joint_enc_bias,
+      joint_pred_weight,
+      joint_pred_bias,
+      joint_fc_weight,
+      joint_fc_bias,
+      max_symbols,
+      blank_id,
+      _SOS);
+}
+
+} // namespace kernel
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "rnnt_lstm_pack_weight(Tensor weight_ih, Tensor weight_hh, "
+      "Tensor bias_ih, Tensor bias_hh) -> (Tensor, Tensor)");
+  m.impl(
+      "rnnt_lstm_pack_weight",
+      c10::DispatchKey::CPU,
+      torch_ipex::kernel::rnnt_lstm_pack_weight);
+  m.def(
+      "rnnt_greedy_decode(Tensor x, Tensor out_lens, Tensor embedding_table, "
+      "Tensor[] lstm_weights, Tensor[] lstm_biases, Tensor joint_enc_weight, "
+      "Tensor joint_enc_bias, Tensor joint_pred_weight, Tensor "
+      "joint_pred_bias, Tensor joint_fc_weight, Tensor joint_fc_bias, int "
+      "max_symbols, int blank_id, int _SOS) -> (Tensor, Tensor)");
+  m.impl(
+      "rnnt_greedy_decode",
+      c10::DispatchKey::CPU,
+      torch_ipex::kernel::rnnt_greedy_decode);
+}
+
+} // namespace
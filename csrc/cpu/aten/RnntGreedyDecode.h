@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+std::tuple<at::Tensor, at::Tensor> rnnt_lstm_pack_weight_kernel_impl(
+    const at::Tensor& weight_ih,
+    const at::Tensor& weight_hh,
+    const at::Tensor& bias_ih,
+    const at::Tensor& bias_hh);
+
+std::tuple<at::Tensor, at::Tensor> rnnt_greedy_decode_kernel_impl(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const std::vector<at::Tensor>& lstm_weights,
+    const std::vector<at::Tensor>& lstm_biases,
+    const at::Tensor& joint_enc_weight,
+    const at::Tensor& joint_enc_bias,
+    const at::Tensor& joint_pred_weight,
+    const at::Tensor& joint_pred_bias,
+    const at::Tensor& joint_fc_weight,
+    const at::Tensor& joint_fc_bias,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS);
+} // namespace
+
+using rnnt_lstm_pack_weight_kernel_fn = std::tuple<at::Tensor, at::Tensor> (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&);
+IPEX_DECLARE_DISPATCH(
+    rnnt_lstm_pack_weight_kernel_fn,
+    rnnt_lstm_pack_weight_kernel_stub);
+
+using rnnt_greedy_decode_kernel_fn = std::tuple<at::Tensor, at::Tensor> (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const std::vector<at::Tensor>&,
+    const std::vector<at::Tensor>&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    int64_t,
+    int64_t,
+    int64_t);
+IPEX_DECLARE_DISPATCH(
+    rnnt_greedy_decode_kernel_fn,
+    rnnt_greedy_decode_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,253 @@
+#include "Sampling.h"
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+#include <torch/csrc/autograd/function.h>
+
+#include <algorithm>
+
+#ifdef USE_LIBXSMM
+#include "Linear.h"
+#include "TPPGEMM.h"
+#endif
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(sampling_update_kernel_stub);
+IPEX_DEFINE_DISPATCH(sampling_finish_kernel_stub);
+
+namespace {
+
+// Candidates kept for top-p and min-p filtering without top-k. The tokens
+// beyond them are left out even if the top-p mass is not reached.
+constexpr int64_t kMaxSamplingCandidates = 1024;
+// Output features of the LM head computed at once by tpp_linear_sample
+constexpr int64_t kLmHeadTileSize = 8192;
+
+// Logits of the last token of each sequence of t, as [batch_size, n]
+at::Tensor last_token_logits(const at::Tensor& t) {
+  auto logits = t.dim() == 3 ? t.select(1, t.size(1) - 1) : t;
+  TORCH_CHECK(logits.dim() == 2, "sampling: expect logits of 2 or 3 dims");
+  return logits.stride(1) == 1 ? logits : logits.contiguous();
+}
+
+} // namespace
+
+SamplingState sampling_init(
+    int64_t batch_size,
+    int64_t vocab_size,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    const SamplingParams& params) {
+  TORCH_CHECK(
+      seeds.numel() == batch_size && counters.numel() == batch_size,
+      "sampling: expect one seed and one counter per sequence");
+  TORCH_CHECK(
+      params.top_p > 0 && params.min_p >= 0 && params.min_p <= 1,
+      "sampling: expect top_p in (0, 1] and min_p in [0, 1]");
+  TORCH_CHECK(
+      params.repetition_penalty > 0,
+      "sampling: expect a positive repetition_penalty");
+  SamplingState state;
+  state.params = params;
+  state.batch_size = batch_size;
+  state.vocab_size = vocab_size;
+  state.seeds = seeds.to(at::kLong).contiguous();
+  state.counters = counters.to(at::kLong).contiguous();
+  bool filtered = params.top_p < 1 || params.min_p > 0;
+  if (params.temperature <= 0) {
+    state.num_candidates = 1;
+  } else if (params.top_k > 0) {
+    state.num_candidates = std::min(params.top_k, vocab_size);
+  } else if (!filtered) {
+    state.gumbel = true;
+    state.num_candidates = 1;
+  } else {
+    state.num_candidates = std::min(kMaxSamplingCandidates, vocab_size);
+  }
+
+  state.penalized_tokens.resize(batch_size);
+  if (prev_tokens.has_value() && prev_tokens.value().numel() > 0 &&
+      params.repetition_penalty != 1) {
+    auto prev = prev_tokens.value().to(at::kLong).contiguous();
+    TORCH_CHECK(
+        prev.size(0) == batch_size,
+        "sampling: expect prev_tokens of [batch_size, length]");
+    prev = prev.view({batch_size, -1});
+    auto len = prev.size(1);
+    auto prev_ptr = prev.data_ptr<int64_t>();
+    for (int64_t b = 0; b < batch_size; b++) {
+      auto& tokens = state.penalized_tokens[b];
+      for (int64_t i = 0; i < len; i++) {
+        auto token = prev_ptr[b * len + i];
+        // negative tokens are padding
+        if (token >= 0 && token < vocab_size) {
+          tokens.push_back(token);
+        }
+      }
+      std::sort(tokens.begin(), tokens.end());
+      tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+    }
+  }
+  state.candidates.resize(at::get_num_threads() * batch_size);
+  for (auto& c : state.candidates) {
+    c.heap.reserve(state.num_candidates);
+  }
+  return state;
+}
+
+at::Tensor sample_logits(
+    const at::Tensor& logits,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty) {
+  RECORD_FUNCTION("ipex::sample_logits", c10::ArrayRef<c10::IValue>({}));
+
+  auto logits_ = last_token_logits(logits);
+  auto state = sampling_init(
+      logits_.size(0),
+      logits_.size(1),
+      seeds,
+      counters,
+      prev_tokens,
+      {temperature, top_k, top_p, min_p, repetition_penalty});
+  sampling_update_kernel_stub(kCPU, state, logits_, 0);
+  return sampling_finish_kernel_stub(kCPU, state);
+}
+
+#ifdef USE_LIBXSMM
+std::tuple<at::Tensor, at::Tensor> tpp_linear_sample(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    int64_t out_features,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty,
+    bool return_logits) {
+  RECORD_FUNCTION("ipex::tpp_linear_sample", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(t_in.dim() == 3, "tpp_linear_sample: expect input of 3 dims");
+  auto x = t_in.narrow(1, t_in.size(1) - 1, 1).contiguous();
+  auto B = x.size(0);
+  auto state = sampling_init(
+      B,
+      out_features,
+      seeds,
+      counters,
+      prev_tokens,
+      {temperature, top_k, top_p, min_p, repetition_penalty});
+
+  // The packed weight is [Nk, Kc, Hc, Hk] or [Nk, Kc, Hc / 2, Hk, 2], so
+  // that a tile of the output features is a slice of blocks of the weight.
+  auto Nk = t_wt.size(0);
+  auto Hk = t_wt.size(3);
+  auto tile_blocks = std::max<int64_t>(1, kLmHeadTileSize / Hk);
+  at::Tensor bias;
+  if (t_bias.numel() > 0) {
+    bias = t_bias.numel() < Nk * Hk
+        ? at::constant_pad_nd(t_bias, {0, Nk * Hk - t_bias.numel()})
+        : t_bias;
+  }
+  auto logits = return_logits ? at::empty({B, out_features}, x.options())
+                              : at::empty({0}, x.options());
+  for (int64_t nb = 0; nb < Nk && nb * Hk < out_features; nb += tile_blocks) {
+    auto num_blocks = std::min(tile_blocks, Nk - nb);
+    auto wt_tile = t_wt.narrow(0, nb, num_blocks);
+    at::Tensor tile;
+    if (bias.defined()) {
+      auto bias_tile = bias.narrow(0, nb * Hk, num_blocks * Hk);
+      tile = tpp_linear_bias_forward_cpu(x, wt_tile, bias_tile, c10::nullopt);
+    } else {
+      tile = tpp_linear_nobias_forward_cpu(x, wt_tile, c10::nullopt);
+    }
+    tile = tile.view({B, num_blocks * Hk});
+    sampling_update_kernel_stub(kCPU, state, tile, nb * Hk);
+    if (return_logits) {
+      auto n = std::min(num_blocks * Hk, out_features - nb * Hk);
+      logits.narrow(1, nb * Hk, n).copy_(tile.narrow(1, 0, n));
+    }
+  }
+  return std::make_tuple(sampling_finish_kernel_stub(kCPU, state), logits);
+}
+
+std::tuple<at::Tensor, at::Tensor> woq_linear_sample(
+    const at::Tensor& input,
+    const at::Tensor& op_context,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty,
+    bool return_logits) {
+  RECORD_FUNCTION("ipex::woq_linear_sample", c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(input.dim() == 3, "woq_linear_sample: expect input of 3 dims");
+  auto x = input.narrow(1, input.size(1) - 1, 1).contiguous();
+  auto logits = last_token_logits(woq_linear_forward(x, op_context));
+  auto state = sampling_init(
+      logits.size(0),
+      logits.size(1),
+      seeds,
+      counters,
+      prev_tokens,
+      {temperature, top_k, top_p, min_p, repetition_penalty});
+  sampling_update_kernel_stub(kCPU, state, logits, 0);
+  return std::make_tuple(
+      sampling_finish_kernel_stub(kCPU, state),
+      return_logits ? logits : at::empty({0}, logits.options()));
+}
+#endif
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "sample_logits(Tensor logits, Tensor seeds, Tensor counters, "
+      "Tensor? prev_tokens=None, float temperature=1.0, int top_k=0, "
+      "float top_p=1.0, float min_p=0.0, float repetition_penalty=1.0) "
+      "-> Tensor");
+  m.impl(
+      "sample_logits", c10::DispatchKey::CPU, torch_ipex::cpu::sample_logits);
+#ifdef USE_LIBXSMM
+  m.def(
+      "tpp_linear_sample(Tensor t_in, Tensor t_wt, Tensor t_bias, "
+      "Tensor seeds, Tensor counters, Tensor? prev_tokens, int out_features, "
+      "float temperature=1.0, int top_k=0, float top_p=1.0, float min_p=0.0, "
+      "float repetition_penalty=1.0, bool return_logits=False) "
+      "-> (Tensor, Tensor)");
+  m.impl(
+      "tpp_linear_sample",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::tpp_linear_sample);
+  m.def(
+      "woq_linear_sample(Tensor input, Tensor W_prepack, Tensor seeds, "
+      "Tensor counters, Tensor? prev_tokens, float temperature=1.0, "
+      "int top_k=0, float top_p=1.0, float min_p=0.0, "
+      "float repetition_penalty=1.0, bool return_logits=False) "
+      "-> (Tensor, Tensor)");
+  m.impl(
+      "woq_linear_sample",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::woq_linear_sample);
+#endif
+}
+
+} // namespace
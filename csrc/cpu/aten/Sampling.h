@@ -0,0 +1,143 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Sampling of the next tokens from the logits of the last token of each
+// sequence. The logits are processed in the order of
+//   repetition penalty -> temperature -> top-k -> top-p -> min-p
+// and the token is drawn from the remaining candidates.
+//
+// The vocab is consumed in tiles, so that the logits of the LM head can be
+// sampled as they are computed, without writing the logits of the whole
+// vocab. Each thread keeps the running top candidates of each sequence and
+// the running max and sum of the softmax over the whole vocab.
+//
+// Random numbers are drawn from Philox with the seed of the sequence as key
+// and the counter of the sequence as subsequence, so that a sequence gets
+// the same tokens for the same seed and counters whatever the batch it is in.
+struct SamplingParams {
+  // Not greater than 0 for greedy search
+  double temperature = 1.0;
+  // 0 to keep all tokens
+  int64_t top_k = 0;
+  // 1 to keep all tokens
+  double top_p = 1.0;
+  // 0 to keep all tokens
+  double min_p = 0.0;
+  // 1 for no penalty
+  double repetition_penalty = 1.0;
+};
+
+// Running candidates of one sequence of one thread
+struct SamplingCandidates {
+  // Heap of the best candidates of (logit, token), worst at the front
+  std::vector<std::pair<float, int64_t>> heap;
+  // Online softmax of the processed tokens
+  float max = -std::numeric_limits<float>::infinity();
+  float sum = 0.f;
+};
+
+struct SamplingState {
+  SamplingParams params;
+  int64_t batch_size = 0;
+  int64_t vocab_size = 0;
+  // Capacity of the heaps
+  int64_t num_candidates = 0;
+  // Without top-p and min-p filtering, tokens are drawn by the Gumbel-max
+  // trick on the logits of the whole vocab, and the heaps only keep the best
+  // perturbed logit.
+  bool gumbel = false;
+  // Seeds and counters of the sequences, int64 of [batch_size]
+  at::Tensor seeds;
+  at::Tensor counters;
+  // Sorted distinct tokens of each sequence to apply the repetition penalty
+  std::vector<std::vector<int64_t>> penalized_tokens;
+  // Candidates of thread i and sequence b at i * batch_size + b
+  std::vector<SamplingCandidates> candidates;
+};
+
+SamplingState sampling_init(
+    int64_t batch_size,
+    int64_t vocab_size,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    const SamplingParams& params);
+
+// Sample the next token of each sequence from logits of [batch_size, vocab]
+at::Tensor sample_logits(
+    const at::Tensor& logits,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty);
+
+#ifdef USE_LIBXSMM
+// LM head with a weight packed by TPP on the last token of each sequence of
+// t_in, sampled tile by tile of the vocab. The logits of the whole vocab are
+// only returned with return_logits, otherwise an empty tensor is returned.
+std::tuple<at::Tensor, at::Tensor> tpp_linear_sample(
+    const at::Tensor& t_in,
+    const at::Tensor& t_wt,
+    const at::Tensor& t_bias,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    int64_t out_features,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty,
+    bool return_logits);
+
+// Same as tpp_linear_sample for the weight-only quantized LM head. The GEMM
+// computes the logits of the whole vocab, which are then sampled.
+std::tuple<at::Tensor, at::Tensor> woq_linear_sample(
+    const at::Tensor& input,
+    const at::Tensor& op_context,
+    const at::Tensor& seeds,
+    const at::Tensor& counters,
+    const c10::optional<at::Tensor>& prev_tokens,
+    double temperature,
+    int64_t top_k,
+    double top_p,
+    double min_p,
+    double repetition_penalty,
+    bool return_logits);
+#endif
+
+namespace {
+
+void sampling_update_kernel_impl(
+    SamplingState& state,
+    const at::Tensor& logits,
+    int64_t offset);
+
+at::Tensor sampling_finish_kernel_impl(SamplingState& state);
+} // namespace
+
+// Add the logits of [batch_size, n] of the tokens from offset to the
+// candidates. Columns beyond vocab_size are ignored.
+using sampling_update_kernel_fn =
+    void (*)(SamplingState&, const at::Tensor&, int64_t);
+// Merge the candidates of the threads and draw the tokens, int64 of
+// [batch_size]
+using sampling_finish_kernel_fn = at::Tensor (*)(SamplingState&);
+IPEX_DECLARE_DISPATCH(sampling_update_kernel_fn, sampling_update_kernel_stub);
+IPEX_DECLARE_DISPATCH(sampling_finish_kernel_fn, sampling_finish_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,446 @@
+#include "ShmAllReduce.h"
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+
+#include <fcntl.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(shm_reduce_kernel_stub);
+
+namespace {
+
+constexpr int64_t kMaxRanks = 64;
+constexpr int64_t kPageSize = 4096;
+constexpr int64_t kNumParities = 2;
+// Elements of the slice reduced by one rank are aligned to this number so
+// that the slices start at full vectors
+constexpr int64_t kSliceAlign = 32;
+// Time to wait for the other ranks to attach to the segment
+constexpr auto kAttachTimeout = std::chrono::seconds(300);
+// Default time to wait for the other ranks in a collective, after which the
+// peers are assumed dead
+constexpr int64_t kDefaultTimeoutSeconds = 300;
+// Spins between two reads of the clock while waiting for the other ranks
+constexpr int64_t kSpinsPerClockCheck = 1024;
+
+struct alignas(64) ShmFlag {
+  std::atomic<int64_t> value;
+};
+
+struct ShmRankState {
+  // sequence number of the last collective whose input the rank copied
+  ShmFlag copied;
+  // sequence number of the last all_reduce whose slice the rank reduced
+  ShmFlag reduced;
+};
+
+struct ShmHeader {
+  ShmFlag ready;
+  ShmFlag attached;
+  // set by a rank which gave up waiting, so that the others fail fast
+  ShmFlag aborted;
+  int64_t world_size;
+  int64_t buffer_size;
+  ShmRankState states[kMaxRanks];
+};
+
+std::chrono::seconds timeout_from_env() {
+  auto val = std::getenv("IPEX_SHM_COMM_TIMEOUT");
+  int64_t seconds = val != nullptr ? std::atoll(val) : 0;
+  return std::chrono::seconds(
+      seconds > 0 ? seconds : kDefaultTimeoutSeconds);
+}
+
+int64_t header_bytes() {
+  return (sizeof(ShmHeader) + kPageSize - 1) / kPageSize * kPageSize;
+}
+
+inline void spin_pause(int64_t& spins) {
+  if (++spins < 4096) {
+    _mm_pause();
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+class ShmComm {
+ public:
+  ShmComm(
+      const std::string& name,
+      int64_t rank,
+      int64_t world_size,
+      int64_t buffer_size)
+      : name_(name),
+        rank_(rank),
+        world_size_(world_size),
+        buffer_size_(buffer_size),
+        timeout_(timeout_from_env()) {
+    segment_size_ =
+        header_bytes() + kNumParities * world_size_ * buffer_size_;
+    if (rank_ == 0) {
+      create();
+    } else {
+      open();
+    }
+    // Page in the own buffers from this rank so that they are local to its
+    // NUMA node
+    for (int64_t parity = 0; parity < kNumParities; parity++) {
+      std::memset(buffer(parity, rank_), 0, buffer_size_);
+    }
+    header_->attached.value.fetch_add(1, std::memory_order_acq_rel);
+    auto deadline = std::chrono::steady_clock::now() + kAttachTimeout;
+    int64_t spins = 0;
+    while (header_->attached.value.load(std::memory_order_acquire) <
+           world_size_) {
+      TORCH_CHECK(
+          std::chrono::steady_clock::now() < deadline,
+          "shm_comm_init: timed out waiting for the other ranks");
+      spin_pause(spins);
+    }
+    if (rank_ == 0) {
+      shm_unlink(name_.c_str());
+    }
+  }
+
+  ~ShmComm() {
+    munmap(header_, segment_size_);
+  }
+
+  int64_t world_size() const {
+    return world_size_;
+  }
+
+  int64_t buffer_size() const {
+    return buffer_size_;
+  }
+
+  void all_reduce(at::Tensor& self) {
+    auto nbytes = self.nbytes();
+    auto element_size = self.element_size();
+    auto numel = self.numel();
+    int64_t seq = ++seq_;
+    int64_t parity = seq % kNumParities;
+    std::memcpy(buffer(parity, rank_), self.data_ptr(), nbytes);
+    signal_and_wait(&ShmRankState::copied, seq);
+
+    int64_t slice = (numel + world_size_ - 1) / world_size_;
+    slice = (slice + kSliceAlign - 1) / kSliceAlign * kSliceAlign;
+    int64_t begin = std::min(rank_ * slice, numel);
+    int64_t end = std::min(begin + slice, numel);
+    if (begin < end) {
+      std::vector<char*> ins;
+      for (int64_t r = 0; r < world_size_; r++) {
+        ins.push_back(buffer(parity, r) + begin * element_size);
+      }
+      shm_reduce_kernel_stub(
+          kCPU,
+          buffer(parity, rank_) + begin * element_size,
+          ins,
+          end - begin,
+          self.scalar_type());
+    }
+    signal_and_wait(&ShmRankState::reduced, seq);
+
+    auto out = static_cast<char*>(self.data_ptr());
+    for (int64_t r = 0; r < world_size_; r++) {
+      int64_t r_begin = std::min(r * slice, numel);
+      int64_t r_end = std::min(r_begin + slice, numel);
+      if (r_begin < r_end) {
+        std::memcpy(
+            out + r_begin * element_size,
+            buffer(parity, r) + r_begin * element_size,
+            (r_end - r_begin) * element_size);
+      }
+    }
+  }
+
+  // Gather nbytes of src of all ranks into dst, one block of nbytes per rank
+  void all_gather(char* dst, const char* src, int64_t nbytes) {
+    for (int64_t offset = 0; offset < nbytes; offset += buffer_size_) {
+      int64_t bytes = std::min(buffer_size_, nbytes - offset);
+      int64_t seq = ++seq_;
+      int64_t parity = seq % kNumParities;
+      std::memcpy(buffer(parity, rank_), src + offset, bytes);
+      signal_and_wait(&ShmRankState::copied, seq);
+      for (int64_t r = 0; r < world_size_; r++) {
+        std::memcpy(dst + r * nbytes + offset, buffer(parity, r), bytes);
+      }
+    }
+  }
+
+ private:
+  char* buffer(int64_t parity, int64_t rank) {
+    return reinterpret_cast<char*>(header_) + header_bytes() +
+        (parity * world_size_ + rank) * buffer_size_;
+  }
+
+  // A rank which died or hung would leave the others spinning forever, so
+  // the wait gives up after timeout_ and aborts the communicator of all ranks.
+  // The sequence numbers of the ranks then disagree, so that shm_comm_init
+  // should be called again before the next collective.
+  void signal_and_wait(ShmFlag ShmRankState::*flag, int64_t seq) {
+    TORCH_CHECK(
+        header_->aborted.value.load(std::memory_order_relaxed) == 0,
+        "shm_comm: the communicator was aborted, call shm_comm_init again");
+    (header_->states[rank_].*flag).value.store(seq, std::memory_order_release);
+    auto deadline = std::chrono::steady_clock::now() + timeout_;
+    for (int64_t r = 0; r < world_size_; r++) {
+      int64_t spins = 0;
+      while ((header_->states[r].*flag).value.load(std::memory_order_acquire) <
+             seq) {
+        spin_pause(spins);
+        if (spins % kSpinsPerClockCheck != 0) {
+          continue;
+        }
+        if (header_->aborted.value.load(std::memory_order_relaxed) != 0) {
+          TORCH_CHECK(
+              false,
+              "shm_comm: rank ",
+              rank_,
+              " aborted as another rank timed out waiting for its peers");
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+          header_->aborted.value.store(1, std::memory_order_relaxed);
+          TORCH_CHECK(
+              false,
+              "shm_comm: rank ",
+              rank_,
+              " timed out after ",
+              timeout_.count(),
+              " s waiting for rank ",
+              r,
+              ", which may have exited. Raise IPEX_SHM_COMM_TIMEOUT if the "
+              "ranks are just unbalanced");
+        }
+      }
+    }
+  }
+
+  void map(int fd) {
+    void* addr = mmap(
+        nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    TORCH_CHECK(
+        addr != MAP_FAILED,
+        "shm_comm_init: failed to map ",
+        name_,
+        ": ",
+        std::strerror(err));
+    header_ = static_cast<ShmHeader*>(addr);
+  }
+
+  void create() {
+    // Remove the segment left by a crashed job of the same name
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    TORCH_CHECK(
+        fd >= 0,
+        "shm_comm_init: failed to create ",
+        name_,
+        ": ",
+        std::strerror(errno));
+    if (ftruncate(fd, segment_size_) != 0) {
+      close(fd);
+      shm_unlink(name_.c_str());
+      TORCH_CHECK(
+          false,
+          "shm_comm_init: failed to allocate ",
+          segment_size_,
+          " bytes for ",
+          name_);
+    }
+    map(fd);
+    header_->world_size = world_size_;
+    header_->buffer_size = buffer_size_;
+    header_->ready.value.store(1, std::memory_order_release);
+  }
+
+  void open() {
+    auto deadline = std::chrono::steady_clock::now() + kAttachTimeout;
+    int fd = -1;
+    while (true) {
+      fd = shm_open(name_.c_str(), O_RDWR, 0600);
+      if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= segment_size_) {
+          break;
+        }
+        close(fd);
+      }
+      TORCH_CHECK(
+          std::chrono::steady_clock::now() < deadline,
+          "shm_comm_init: timed out waiting for rank 0 to create ",
+          name_);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    map(fd);
+    int64_t spins = 0;
+    while (header_->ready.value.load(std::memory_order_acquire) == 0) {
+      TORCH_CHECK(
+          std::chrono::steady_clock::now() < deadline,
+          "shm_comm_init: timed out waiting for rank 0 to initialize ",
+          name_);
+      spin_pause(spins);
+    }
+    TORCH_CHECK(
+        header_->world_size == world_size_ &&
+            header_->buffer_size == buffer_size_,
+        "shm_comm_init: world_size or buffer_size differs from rank 0");
+  }
+
+  std::string name_;
+  int64_t rank_;
+  int64_t world_size_;
+  int64_t buffer_size_;
+  int64_t segment_size_;
+  std::chrono::seconds timeout_;
+  ShmHeader* header_ = nullptr;
+  // sequence number of the last collective issued by this rank
+  int64_t seq_ = 0;
+};
+
+std::unique_ptr<ShmComm> shm_comm;
+std::mutex shm_comm_mutex;
+
+at::Tensor fallback_all_reduce(at::Tensor& self) {
+  auto op = c10::Dispatcher::singleton().findOp(
+      c10::OperatorName("deepspeed_comm::all_reduce", ""));
+  TORCH_CHECK(
+      op.has_value(),
+      "shm_all_reduce: the message does not fit the shared memory buffer or "
+      "shm_comm_init is not called, and deepspeed_comm::all_reduce is not "
+      "available");
+  return op->typed<at::Tensor(const at::Tensor&)>().call(self);
+}
+
+} // namespace
+
+void shm_comm_init(
+    const std::string& name,
+    int64_t rank,
+    int64_t world_size,
+    int64_t buffer_size) {
+  TORCH_CHECK(
+      world_size > 0 && world_size <= kMaxRanks,
+      "shm_comm_init: world_size should be in [1, ",
+      kMaxRanks,
+      "]");
+  TORCH_CHECK(
+      rank >= 0 && rank < world_size,
+      "shm_comm_init: rank should be in [0, world_size)");
+  TORCH_CHECK(
+      buffer_size > 0 && buffer_size % kPageSize == 0,
+      "shm_comm_init: buffer_size should be a multiple of ",
+      kPageSize);
+  TORCH_CHECK(
+      !name.empty() && name[0] == '/' &&
+          name.find('/', 1) == std::string::npos,
+      "shm_comm_init: name should start with '/' and contain no other '/'");
+  std::lock_guard<std::mutex> lock(shm_comm_mutex);
+  shm_comm.reset();
+  shm_comm = std::make_unique<ShmComm>(name, rank, world_size, buffer_size);
+}
+
+bool shm_comm_is_initialized() {
+  std::lock_guard<std::mutex> lock(shm_comm_mutex);
+  return shm_comm != nullptr;
+}
+
+void shm_comm_destroy() {
+  std::lock_guard<std::mutex> lock(shm_comm_mutex);
+  shm_comm.reset();
+}
+
+at::Tensor shm_all_reduce(at::Tensor& self) {
+  RECORD_FUNCTION("IPEX::shm_all_reduce", c10::ArrayRef<c10::IValue>({}));
+  auto dtype = self.scalar_type();
+  {
+    std::lock_guard<std::mutex> lock(shm_comm_mutex);
+    if (shm_comm && self.is_contiguous() &&
+        (int64_t)self.nbytes() <= shm_comm->buffer_size() &&
+        (dtype == at::kFloat || dtype == at::kBFloat16 || dtype == at::kHalf)) {
+      if (shm_comm->world_size() > 1 && self.numel() > 0) {
+        shm_comm->all_reduce(self);
+      }
+      return self;
+    }
+  }
+  return fallback_all_reduce(self);
+}
+
+at::Tensor shm_all_gather(const at::Tensor& self, int64_t dim) {
+  RECORD_FUNCTION("IPEX::shm_all_gather", c10::ArrayRef<c10::IValue>({}));
+  std::lock_guard<std::mutex> lock(shm_comm_mutex);
+  TORCH_CHECK(shm_comm, "shm_all_gather: shm_comm_init is not called");
+  dim = c10::maybe_wrap_dim(dim, self.dim());
+  auto world_size = shm_comm->world_size();
+  auto input = self.contiguous();
+  auto gathered_sizes = input.sizes().vec();
+  gathered_sizes.insert(gathered_sizes.begin(), world_size);
+  auto gathered = at::empty(gathered_sizes, input.options());
+  if (input.numel() > 0) {
+    shm_comm->all_gather(
+        static_cast<char*>(gathered.data_ptr()),
+        static_cast<const char*>(input.data_ptr()),
+        input.nbytes());
+  }
+  if (dim == 0) {
+    auto output_sizes = input.sizes().vec();
+    output_sizes[0] *= world_size;
+    return gathered.view(output_sizes);
+  }
+  return at::cat(gathered.unbind(0), dim);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+void shm_comm_init(
+    c10::string_view name,
+    int64_t rank,
+    int64_t world_size,
+    int64_t buffer_size) {
+  torch_ipex::cpu::shm_comm_init(
+      std::string(name), rank, world_size, buffer_size);
+}
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "shm_comm_init(str name, int rank, int world_size, int buffer_size) "
+      "-> ()",
+      shm_comm_init);
+  m.def(
+      "shm_comm_is_initialized() -> bool",
+      torch_ipex::cpu::shm_comm_is_initialized);
+  m.def("shm_comm_destroy() -> ()", torch_ipex::cpu::shm_comm_destroy);
+  m.def("shm_all_reduce(Tensor(a!) self) -> Tensor(a!)");
+  m.impl(
+      "shm_all_reduce",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::shm_all_reduce);
+  m.def("shm_all_gather(Tensor self, int dim=0) -> Tensor");
+  m.impl(
+      "shm_all_gather",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::shm_all_gather);
+}
+
+} // namespace
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <dyndisp/DispatchStub.h>
+
+#include <string>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Collectives among the ranks of one host through a POSIX shared memory
+// segment, for the small activations of tensor-parallel decoding.
+//
+// Each rank owns one buffer of buffer_size bytes per parity in the segment.
+// A rank first-touches its own buffers so that they are allocated on its NUMA
+// node. all_reduce copies the input into the own buffer, reduces 1/world_size
+// of the elements across all buffers into the own buffer, and gathers the
+// reduced slices of all ranks. Ranks synchronize with monotonic sequence
+// flags in the segment, without locks. Consecutive collectives alternate
+// between the two parities so that a rank never overwrites a buffer that
+// another rank is still reading.
+//
+// The name must be unique for the job and is shared by all ranks. Rank 0
+// creates the segment and unlinks it once all ranks attached, so that it is
+// removed when the processes exit.
+//
+// A collective waits at most IPEX_SHM_COMM_TIMEOUT seconds for the other
+// ranks. On timeout it raises and aborts the communicator of all ranks.
+void shm_comm_init(
+    const std::string& name,
+    int64_t rank,
+    int64_t world_size,
+    int64_t buffer_size);
+
+bool shm_comm_is_initialized();
+
+void shm_comm_destroy();
+
+// Sum self across the ranks in place. Messages larger than buffer_size, of
+// other dtypes than float, bfloat16 and half, or issued before shm_comm_init
+// go through deepspeed_comm::all_reduce instead.
+at::Tensor shm_all_reduce(at::Tensor& self);
+
+// Concatenate self of all ranks along dim. Messages larger than buffer_size
+// are transferred in several rounds.
+at::Tensor shm_all_gather(const at::Tensor& self, int64_t dim);
+
+namespace {
+
+void shm_reduce_kernel_impl(
+    char* out,
+    const std::vector<char*>& ins,
+    int64_t numel,
+    at::ScalarType dtype);
+}
+
+// Sum numel elements of all ins into out, which may be one of ins. ins are
+// summed in order so that all ranks get the same result.
+using shm_reduce_kernel_fn = void (*)(
+    char*,
+    const std::vector<char*>&,
+    int64_t,
+    at::ScalarType);
+IPEX_DECLARE_DISPATCH(shm_reduce_kernel_fn, shm_reduce_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
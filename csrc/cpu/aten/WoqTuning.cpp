@@ -0,0 +1,370 @@
+#ifdef USE_LIBXSMM
+#include "WoqTuning.h"
+#include <omp.h>
+#include <torch/all.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include "Linear.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+constexpr int64_t kWarmupIters = 2;
+constexpr int64_t kBenchIters = 5;
+// M of the benchmarks when a weight is tuned at its first use, covering
+// next-token generation and prompt processing
+const std::vector<int64_t> kDefaultTuneMList = {1, 4, 32, 128};
+
+int64_t get_default_block_k(int64_t K, int64_t group_size) {
+  int64_t block_k = group_size > 0 ? std::min(group_size, (int64_t)64) : 64;
+  while (block_k > 1 && K % block_k != 0) {
+    block_k /= 2;
+  }
+  return block_k;
+}
+
+WoqTuningKey get_key(
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t m_bucket) {
+  return {
+      N,
+      K,
+      qw_type,
+      std::max<int64_t>(group_size, 0),
+      lowp_mode,
+      omp_get_max_threads(),
+      m_bucket};
+}
+
+// Random weight, packed weight and fake quantization parameters of one
+// candidate of the packing
+struct TuningProblem {
+  int64_t N;
+  int64_t K;
+  int64_t qw_type;
+  int64_t group_size;
+  int64_t lowp_mode;
+  at::Tensor packed_weight;
+  std::vector<at::Tensor> scales_list;
+  std::vector<at::Tensor> zps_list;
+
+  // Median latency in seconds of M x K activations under the given config
+  double benchmark(
+      int64_t M,
+      at::ScalarType act_dtype,
+      const WoqTuningConfig& config) {
+    auto x = at::randn({M, K}, at::TensorOptions().dtype(act_dtype));
+    std::vector<at::Tensor> bias_list, others_list;
+    woq_tuning::ConfigOverrideGuard guard(config);
+    auto run = [&]() {
+      return woq_tpp_gemm_kernel_stub(
+          kCPU,
+          x,
+          packed_weight,
+          scales_list,
+          zps_list,
+          bias_list,
+          qw_type,
+          lowp_mode,
+          /*num_concats*/ 1,
+          WOQ_FUSE_NONE,
+          others_list,
+          /*act_quant_mode*/ 0,
+          /*quant_w_mode*/ group_size > 0 ? 1 : 0,
+          group_size);
+    };
+    for (int64_t i = 0; i < kWarmupIters; i++) {
+      run();
+    }
+    std::vector<double> times;
+    for (int64_t i = 0; i < kBenchIters; i++) {
+      auto start = std::chrono::steady_clock::now();
+      run();
+      auto end = std::chrono::steady_clock::now();
+      times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+  }
+};
+
+// Return false if the kernel of the current ISA does not pack the weight
+bool make_problem(
+    TuningProblem& problem,
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t block_n,
+    int64_t block_k) {
+  int64_t bits = woq_dtype_bits(qw_type);
+  // Weight of less than 8 bits is padded along N as woq_linear_pack_weight
+  // does
+  int64_t N_padded = bits < 8 ? (N + block_n - 1) / block_n * block_n : N;
+  at::Tensor weight = bits < 8
+      ? at::randint(0, 256, {N_padded, K * bits / 8}, at::dtype(at::kByte))
+      : at::randint(-128, 128, {N_padded, K}, at::dtype(at::kChar));
+  problem.packed_weight = woq_tpp_gemm_packB_stub(
+      kCPU, weight, qw_type, block_n, block_k, lowp_mode);
+  if (problem.packed_weight.dim() != 4) {
+    return false;
+  }
+  problem.N = N_padded;
+  problem.K = K;
+  problem.qw_type = qw_type;
+  problem.group_size = std::max<int64_t>(group_size, 0);
+  problem.lowp_mode = lowp_mode;
+  // The values do not matter, only the size does
+  int64_t num_groups =
+      problem.group_size > 0 ? K / problem.group_size : (int64_t)1;
+  auto scales = at::full({N_padded * num_groups}, 0.01f);
+  auto zps = at::full({N_padded * num_groups}, 8.0f);
+  problem.scales_list = {
+      scales, scales.to(at::kHalf), scales.to(at::kBFloat16)};
+  problem.zps_list = {
+      zps, zps.to(at::kHalf), zps.to(at::kBFloat16), zps.to(at::kChar)};
+  return true;
+}
+
+bool is_valid_block_k(
+    int64_t K,
+    int64_t block_k,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode) {
+  if (K % block_k != 0 || (group_size > 0 && group_size % block_k != 0)) {
+    return false;
+  }
+  // VNNI layout of int4 weight for the int8 compute
+  if (woq_is_4bit_dtype(qw_type) && lowp_mode == 3 && block_k % 4 != 0) {
+    return false;
+  }
+  return block_k % 2 == 0;
+}
+
+// Tune one parameter of the runtime config at a time, keeping the best value
+// of the parameters tuned before
+WoqTuningConfig tune_runtime_config(
+    TuningProblem& problem,
+    int64_t M,
+    at::ScalarType act_dtype,
+    const WoqTuningConfig& pack_config) {
+  auto best = pack_config;
+  double best_time = problem.benchmark(M, act_dtype, best);
+  auto try_candidates = [&](int64_t WoqTuningConfig::*param,
+                            const std::vector<int64_t>& candidates) {
+    auto config = best;
+    for (auto candidate : candidates) {
+      if (candidate == best.*param) {
+        continue;
+      }
+      config.*param = candidate;
+      auto time = problem.benchmark(M, act_dtype, config);
+      if (time < best_time) {
+        best_time = time;
+        best = config;
+      }
+    }
+  };
+  try_candidates(&WoqTuningConfig::prefetch_k_dist, {0, 32, 64, 128, 256});
+  if (M > 16) {
+    try_candidates(&WoqTuningConfig::block_m, {16, 32, 64});
+  }
+  if (M < 32) {
+    int64_t Kc = problem.K / pack_config.block_k;
+    std::vector<int64_t> k_splits;
+    for (int64_t k_split : {2, 4, 8}) {
+      if (Kc % k_split == 0) {
+        k_splits.push_back(k_split);
+      }
+    }
+    try_candidates(&WoqTuningConfig::k_splits, k_splits);
+  }
+  // parallelize over M first or over N first
+  try_candidates(
+      &WoqTuningConfig::parallel_m_threshold,
+      {1, std::numeric_limits<int32_t>::max()});
+  // always or never use the dequant micro-kernel instead of brgemm
+  try_candidates(&WoqTuningConfig::small_batch_threshold, {0, 65});
+  return best;
+}
+
+} // namespace
+
+WoqTuningConfig woq_get_pack_config(
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode) {
+  auto key = get_key(N, K, qw_type, group_size, lowp_mode, /*m_bucket*/ 0);
+  if (woq_tuning::has_config(key)) {
+    auto config = woq_tuning::get_config(key);
+    if (config.block_k <= 0) {
+      config.block_k = get_default_block_k(K, group_size);
+    }
+    return config;
+  }
+  if (woq_tuning::is_autotune_enabled()) {
+    return woq_tune_gemm(
+        N,
+        K,
+        qw_type,
+        group_size,
+        lowp_mode,
+        kDefaultTuneMList,
+        at::kBFloat16);
+  }
+  WoqTuningConfig config;
+  config.block_k = get_default_block_k(K, group_size);
+  return config;
+}
+
+WoqTuningConfig woq_tune_gemm(
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode,
+    const std::vector<int64_t>& m_list,
+    at::ScalarType act_dtype) {
+  RECORD_FUNCTION("IPEX::woq_tune_gemm", c10::ArrayRef<c10::IValue>({}));
+  TORCH_CHECK(
+      K % 2 == 0, "woq_tune_gemm: only even K is supported by the TPP kernel");
+  TORCH_CHECK(
+      K * woq_dtype_bits(qw_type) % 8 == 0,
+      "woq_tune_gemm: K values of the weight dtype should fill whole bytes");
+  TORCH_CHECK(!m_list.empty(), "woq_tune_gemm: m_list should not be empty");
+  bool is_padded = woq_dtype_bits(qw_type) < 8;
+
+  WoqTuningConfig default_config;
+  default_config.block_k = get_default_block_k(K, group_size);
+
+  // Select the packing by the sum of the latencies of all M
+  WoqTuningConfig best_config = default_config;
+  TuningProblem best_problem;
+  bool found = false;
+  double best_time = std::numeric_limits<double>::max();
+  for (int64_t block_n : {16, 32, 64, 128}) {
+    if (!is_padded && N % block_n != 0) {
+      continue;
+    }
+    for (int64_t block_k : {32, 64, 128}) {
+      if (!is_valid_block_k(K, block_k, qw_type, group_size, lowp_mode)) {
+        continue;
+      }
+      TuningProblem problem;
+      if (!make_problem(
+              problem,
+              N,
+              K,
+              qw_type,
+              group_size,
+              lowp_mode,
+              block_n,
+              block_k)) {
+        // The weight is not packed on this ISA, nothing to tune
+        return default_config;
+      }
+      auto config = default_config;
+      config.block_n = block_n;
+      config.block_k = block_k;
+      double time = 0;
+      for (auto M : m_list) {
+        time += problem.benchmark(M, act_dtype, config);
+      }
+      if (time < best_time) {
+        best_time = time;
+        best_config = config;
+        best_problem = std::move(problem);
+        found = true;
+      }
+    }
+  }
+  if (!found) {
+    return default_config;
+  }
+
+  for (auto M : m_list) {
+    auto config = tune_runtime_config(best_problem, M, act_dtype, best_config);
+    woq_tuning::set_config(
+        get_key(
+            best_problem.N,
+            K,
+            qw_type,
+            group_size,
+            lowp_mode,
+            woq_tuning::get_m_bucket(M)),
+        config);
+  }
+  woq_tuning::set_config(
+      get_key(N, K, qw_type, group_size, lowp_mode, /*m_bucket*/ 0),
+      best_config);
+  return best_config;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+std::vector<int64_t> woq_tune_gemm(
+    int64_t N,
+    int64_t K,
+    int64_t weight_dtype,
+    int64_t group_size,
+    int64_t lowp_mode,
+    std::vector<int64_t> m_list,
+    at::ScalarType act_dtype) {
+  TORCH_CHECK(
+      weight_dtype == WOQ_DTYPE_QINT8 || weight_dtype == WOQ_DTYPE_QINT4 ||
+          weight_dtype == WOQ_DTYPE_NF4,
+      "woq_tune_gemm: only INT8, INT4 and NF4 weights are tuned");
+  auto config = torch_ipex::cpu::woq_tune_gemm(
+      N,
+      K,
+      weight_dtype,
+      group_size,
+      lowp_mode,
+      m_list,
+      act_dtype);
+  return {config.block_n, config.block_k};
+}
+
+void woq_tuning_db_load(c10::string_view path) {
+  torch_ipex::cpu::woq_tuning::load_db(std::string(path));
+}
+
+void woq_tuning_db_save(c10::string_view path) {
+  torch_ipex::cpu::woq_tuning::save_db(std::string(path));
+}
+
+void woq_tuning_db_clear() {
+  torch_ipex::cpu::woq_tuning::clear_db();
+}
+
+void woq_set_autotune(bool enabled) {
+  torch_ipex::cpu::woq_tuning::set_autotune_enabled(enabled);
+}
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "woq_tune_gemm(int N, int K, int weight_dtype, int group_size, "
+      "int lowp_mode, int[] m_list, ScalarType act_dtype) -> int[]",
+      woq_tune_gemm);
+  m.def("woq_tuning_db_load(str path) -> ()", woq_tuning_db_load);
+  m.def("woq_tuning_db_save(str path) -> ()", woq_tuning_db_save);
+  m.def("woq_tuning_db_clear() -> ()", woq_tuning_db_clear);
+  m.def("woq_set_autotune(bool enabled) -> ()", woq_set_autotune);
+}
+
+} // namespace
+#endif
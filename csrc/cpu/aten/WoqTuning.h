@@ -0,0 +1,38 @@
+#pragma once
+
+#ifdef USE_LIBXSMM
+#include <ATen/Tensor.h>
+
+#include <vector>
+
+#include "utils/woq_tuning.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// Block sizes to pack a WoQ weight with. Use the tuned ones if they exist,
+// otherwise benchmark the candidates first if autotuning is enabled, or fall
+// back to the defaults. block_k of the returned config is always resolved.
+WoqTuningConfig woq_get_pack_config(
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode);
+
+// Benchmark the candidate configs of the WoQ TPP GEMM for a weight shape on
+// the current number of threads and record the winners in the tuning
+// database: the block sizes for packing, and the runtime parameters for each
+// M in m_list. Return the selected block sizes.
+WoqTuningConfig woq_tune_gemm(
+    int64_t N,
+    int64_t K,
+    int64_t qw_type,
+    int64_t group_size,
+    int64_t lowp_mode,
+    const std::vector<int64_t>& m_list,
+    at::ScalarType act_dtype);
+
+} // namespace cpu
+} // namespace torch_ipex
+#endif
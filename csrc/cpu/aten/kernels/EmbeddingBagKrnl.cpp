@@ -13,6 +13,7 @@
 
 #include "autocast/autocast_mode.h"
 #include "cpu/kernels/Embeddingbag.h"
+#include "utils/kernel_profiler.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -62,7 +63,9 @@ static inline Tensor _embedding_bag_index_add_select_fast(
 
   Tensor output = empty({output_size, src.size(1)}, src.options());
   auto* output_data = output.data_ptr<T>();
+  auto profile_scope = utils::KernelProfileScope::current();
   parallel_for(0, output_size, 16, [&](int64_t start, int64_t end) {
+    utils::KernelThreadTimer thread_timer(profile_scope);
     for (int64_t i = start; i < end; i++) {
       auto* out_data_ptr = &output_data[i * ddim];
       auto inputs_start = offsets_data[i];
@@ -92,6 +95,14 @@ Tensor embedding_bag_kernel_impl(
     const Tensor& offsets,
     bool include_last_offset) {
   Tensor offsets_ = offsets.is_contiguous() ? offsets : offsets.contiguous();
+  utils::KernelProfileScope profile("embedding_bag", weight, indices, offsets);
+  // A row of the weight gathered and summed per index
+  auto gathered = static_cast<double>(indices.numel()) * weight.size(1);
+  profile.add_cost(
+      gathered,
+      gathered * weight.element_size() + indices.nbytes() + offsets.nbytes(),
+      static_cast<double>(offsets.numel() - include_last_offset) *
+          weight.size(1) * weight.element_size());
 
   Tensor output;
   if (is_bfloat16_tensor(weight)) {
@@ -12,6 +12,7 @@
 #include <torch/csrc/autograd/function.h>
 #include <limits>
 #include "../cpu/utils/isa_utils.h"
+#include "../cpu/utils/kernel_profiler.h"
 #include "csrc/cpu/tpp/woq/tla.h"
 #include "mkl.h"
 #include "vec/vec.h"
@@ -104,6 +105,50 @@ inline void _mkl_gemm(
   TORCH_CHECK(false, "_mkl_gemm does not support FP16 yet");
 }
 
+// c = (a + a_offset) * op(b), of unsigned a and signed b. Only exact with the
+// int8 dot products of VNNI/AMX, see int8_gemm_is_exact
+// Without VNNI/AMX, the u8 x s8 products are summed in pairs by vpmaddubsw,
+// which saturates at int16 for inputs of the full 8 bit range
+inline bool int8_gemm_is_exact() {
+  static const bool exact = utils::isa_has_avx512_vnni_support() ||
+      utils::isa_has_avx2_vnni_support() || utils::isa_has_amx_support();
+  return exact;
+}
+
+inline void _mkl_gemm_u8s8s32(
+    const CBLAS_TRANSPOSE transb,
+    const int& m,
+    const int& n,
+    const int& k,
+    const uint8_t* a,
+    const int& lda,
+    const int8_t& a_offset,
+    const int8_t* b,
+    const int& ldb,
+    int32_t* c,
+    const int& ldc) {
+  const MKL_INT32 c_offset = 0;
+  cblas_gemm_s8u8s32(
+      CblasRowMajor,
+      CblasNoTrans,
+      transb,
+      CblasFixOffset,
+      m,
+      n,
+      k,
+      1.f,
+      a,
+      a_offset,
+      lda,
+      b,
+      0,
+      ldb,
+      0.f,
+      c,
+      ldc,
+      &c_offset);
+}
+
 namespace torch_ipex {
 using namespace tpp;
 namespace cpu {
@@ -461,8 +506,10 @@ cpu_flash_attention(
   scalar_t* out_data = output.data_ptr<scalar_t>();
   accum_t* buf_data = buf.data_ptr<accum_t>();
 
+  auto profile_scope = utils::KernelProfileScope::current();
   at::parallel_for(
       0, batchSize * num_head * qSlice, 1, [&](int64_t begin, int64_t end) {
+        utils::KernelThreadTimer thread_timer(profile_scope);
         int64_t i = 0, j = 0, k = 0;
         at::native::data_index_init(
             begin, i, batchSize, j, num_head, k, qSlice);
@@ -924,8 +971,10 @@ cpu_flash_attention(
       XPOSE);
 
   // Reorder K, V
+  auto profile_scope = utils::KernelProfileScope::current();
   at::parallel_for(
       0, batchSize * num_head * kvSlice, 1, [&](int64_t begin, int64_t end) {
+        utils::KernelThreadTimer thread_timer(profile_scope);
         int64_t i = 0, j = 0, l = 0, n = 0;
         at::native::data_index_init(
             begin, i, batchSize, j, num_head, l, kvSlice);
@@ -1037,6 +1086,7 @@ cpu_flash_attention(
 
   at::parallel_for(
       0, batchSize * num_head * qSlice, 1, [&](int64_t begin, int64_t end) {
+        utils::KernelThreadTimer thread_timer(profile_scope);
         int64_t i = 0, j = 0, k = 0;
         at::native::data_index_init(
             begin, i, batchSize, j, num_head, k, qSlice);
@@ -1326,6 +1376,11 @@ void flash_attention_kernel_impl(
     bool is_causal,
     c10::optional<at::Tensor> attention_mask,
     c10::optional<double> scale) {
+  utils::KernelProfileScope profile("flash_attention", query, key, value);
+  profile.add_cost(
+      (is_causal ? 2.0 : 4.0) * query.numel() * key.size(2),
+      query.nbytes() + key.nbytes() + value.nbytes(),
+      output.nbytes());
   auto q_seq_len = query.size(2);
 
   AT_DISPATCH_FLOATING_TYPES_AND2(
@@ -1367,6 +1422,457 @@ void flash_attention_kernel_impl(
       });
 }
 
+template <typename out_t>
+inline void _store_int8_attention_output(
+    out_t* out,
+    const float* dst,
+    float scale,
+    int64_t size) {
+  for (const auto d : c10::irange(size)) {
+    out[d] = static_cast<out_t>(dst[d] * scale);
+  }
+}
+
+inline void _store_int8_attention_output(
+    int8_t* out,
+    const float* dst,
+    float scale,
+    int64_t size) {
+  for (const auto d : c10::irange(size)) {
+    out[d] = static_cast<int8_t>(
+        std::min(std::max(std::nearbyint(dst[d] * scale), -128.f), 127.f));
+  }
+}
+
+/*
+ *Caculate the flash attention SDPA of int8 Q/K/V.
+ *q @ k.T and softmax(q @ k.T) @ v run as u8s8s32 GEMMs, the softmax is
+ *computed in FP32 on the blocks of the scores. The probabilities are in
+ *[0, 1] after subtracting the running max, and are quantized to u8 with the
+ *scale of 1 / 255.
+ *@template out_t: output data type, int8 or bf16
+ *@template q_split_size: q block size
+ *@template kv_split_size: kv block size
+ *@param output: output result
+ *@param q: query
+ *@param k: key
+ *@param v: value
+ *@param q_scale: per head scales of query
+ *@param k_scale: per head scales of key
+ *@param v_scale: per head scales of value
+ *@param is_causal: assume causal attention masking if true
+ *@param attention_mask: additive FP32 attention mask
+ *@param scaling_factor: scaling factor applied prior to softmax
+ *@param output_scale: the reciprocal of the int8 output scale, 1 for bf16
+ */
+template <typename out_t, int64_t q_split_size, int64_t kv_split_size>
+void cpu_int8_flash_attention(
+    const at::Tensor& output,
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    c10::optional<at::Tensor> attention_mask,
+    float scaling_factor,
+    float output_scale) {
+  // (Batch x Num_heads x Seq_len x Dim_per_head)
+  //    -> (Batch x Seq_len x Num_heads x Dim_per_head)
+  at::Tensor query = q.transpose(1, 2);
+  at::Tensor key = k.transpose(1, 2);
+  at::Tensor value = v.transpose(1, 2);
+  using Vec = at::vec::Vectorized<float>;
+
+  int64_t batchSize = query.size(0);
+  int64_t qSize = query.size(1);
+  int64_t kvSize = value.size(1);
+  int64_t num_head = query.size(2);
+  int64_t headSize = query.size(3);
+
+  int64_t qStrideB = query.stride(0);
+  int64_t qStrideM = query.stride(1);
+  int64_t qStrideH = query.stride(2);
+  int64_t kStrideB = key.stride(0);
+  int64_t kStrideN = key.stride(1);
+  int64_t kStrideH = key.stride(2);
+  int64_t vStrideB = value.stride(0);
+  int64_t vStrideN = value.stride(1);
+  int64_t vStrideH = value.stride(2);
+  int64_t oStrideB = output.stride(0);
+  int64_t oStrideM = output.stride(1);
+  int64_t oStrideH = output.stride(2);
+  int64_t mStrideB =
+      (attention_mask.has_value() && attention_mask.value().size(0) > 1)
+      ? attention_mask.value().stride(0)
+      : 0;
+  int64_t mStrideH =
+      (attention_mask.has_value() && attention_mask.value().size(1) > 1)
+      ? attention_mask.value().stride(1)
+      : 0;
+  int64_t mStrideM =
+      attention_mask.has_value() ? attention_mask.value().stride(2) : 0;
+
+  int64_t qSplitSize = q_split_size > qSize ? qSize : q_split_size;
+  int64_t kvSplitSize = kv_split_size > kvSize ? kvSize : kv_split_size;
+  int64_t qSlice = (qSize - 1) / qSplitSize + 1;
+  int64_t num_thread = at::get_num_threads();
+
+  // allocate per thread temp bufs
+  int64_t fp32_size_per_thread =
+      /* qk     */ qSplitSize * kvSplitSize +
+      /* qk_max */ qSplitSize +
+      /* qk_sum */ qSplitSize +
+      /* dst    */ qSplitSize * headSize;
+  int64_t s32_size_per_thread =
+      /* qk_s32 */ qSplitSize * kvSplitSize +
+      /* pv_s32 */ qSplitSize * headSize;
+  int64_t u8_size_per_thread =
+      /* q_u8   */ qSplitSize * headSize +
+      /* p_u8   */ qSplitSize * kvSplitSize;
+  at::Tensor fp32_buf = at::empty(
+      {num_thread, fp32_size_per_thread}, query.options().dtype(at::kFloat));
+  at::Tensor s32_buf = at::empty(
+      {num_thread, s32_size_per_thread}, query.options().dtype(at::kInt));
+  at::Tensor u8_buf = at::empty(
+      {num_thread, u8_size_per_thread}, query.options().dtype(at::kByte));
+
+  int8_t* q_data = query.data_ptr<int8_t>();
+  int8_t* k_data = key.data_ptr<int8_t>();
+  int8_t* v_data = value.data_ptr<int8_t>();
+  float* q_scale_data = q_scale.data_ptr<float>();
+  float* k_scale_data = k_scale.data_ptr<float>();
+  float* v_scale_data = v_scale.data_ptr<float>();
+  float* mask_data = attention_mask.has_value()
+      ? attention_mask.value().data_ptr<float>()
+      : nullptr;
+  out_t* out_data = output.data_ptr<out_t>();
+  float* fp32_buf_data = fp32_buf.data_ptr<float>();
+  int32_t* s32_buf_data = s32_buf.data_ptr<int32_t>();
+  uint8_t* u8_buf_data = u8_buf.data_ptr<uint8_t>();
+
+  auto profile_scope = utils::KernelProfileScope::current();
+  at::parallel_for(
+      0, batchSize * num_head * qSlice, 1, [&](int64_t begin, int64_t end) {
+        utils::KernelThreadTimer thread_timer(profile_scope);
+        int64_t i = 0, j = 0, k = 0;
+        at::native::data_index_init(
+            begin, i, batchSize, j, num_head, k, qSlice);
+        int ompIdx = at::get_thread_num();
+        float* qk_data = fp32_buf_data + ompIdx * fp32_size_per_thread;
+        float* qk_max_data = qk_data + qSplitSize * kvSplitSize;
+        float* qk_sum_data = qk_max_data + qSplitSize;
+        float* dst_data = qk_sum_data + qSplitSize;
+        int32_t* qk_s32_data = s32_buf_data + ompIdx * s32_size_per_thread;
+        int32_t* pv_s32_data = qk_s32_data + qSplitSize * kvSplitSize;
+        uint8_t* q_u8_data = u8_buf_data + ompIdx * u8_size_per_thread;
+        uint8_t* p_u8_data = q_u8_data + qSplitSize * headSize;
+
+        for (const auto z : c10::irange(begin, end)) {
+          (void)z; // Suppress unused variable
+          int64_t m = k * qSplitSize;
+          int64_t qBlockSize = std::min(qSplitSize, qSize - m);
+          float qk_scale = q_scale_data[j] * k_scale_data[j] * scaling_factor;
+          float pv_scale = v_scale_data[j] / 255.f;
+          // The u8 GEMM takes q + 128, with the offset -128 of a
+          for (const auto row : c10::irange(qBlockSize)) {
+            const int8_t* q_row =
+                q_data + i * qStrideB + j * qStrideH + (m + row) * qStrideM;
+            uint8_t* q_u8_row = q_u8_data + row * headSize;
+            for (const auto d : c10::irange(headSize)) {
+              q_u8_row[d] = static_cast<uint8_t>(q_row[d] + 128);
+            }
+          }
+          // Initialize max and sum
+          torch_ipex::cpu::kernel::fill_stub(
+              qk_max_data, -std::numeric_limits<float>::infinity(), qBlockSize);
+          torch_ipex::cpu::kernel::fill_stub(qk_sum_data, 0.f, qBlockSize);
+          int64_t num_keys =
+              is_causal ? std::min(m + qBlockSize, kvSize) : kvSize;
+          for (int64_t n = 0; n < num_keys; n += kvSplitSize) {
+            int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
+            // Calculate q @ k.T in int32
+            _mkl_gemm_u8s8s32(
+                CblasTrans,
+                qBlockSize,
+                kvBlockSize,
+                headSize,
+                q_u8_data,
+                headSize,
+                -128,
+                k_data + i * kStrideB + j * kStrideH + n * kStrideN,
+                kStrideN,
+                qk_s32_data,
+                kvBlockSize);
+            // Dequantize and scale, apply attention mask and causal mask
+            for (const auto row : c10::irange(qBlockSize)) {
+              float* qk_row = qk_data + row * kvBlockSize;
+              const int32_t* qk_s32_row = qk_s32_data + row * kvBlockSize;
+              for (const auto col : c10::irange(kvBlockSize)) {
+                qk_row[col] = static_cast<float>(qk_s32_row[col]) * qk_scale;
+              }
+              if (attention_mask.has_value()) {
+                at::vec::map2<float>(
+                    [](Vec x, Vec y) { return x + y; },
+                    qk_row,
+                    qk_row,
+                    mask_data + i * mStrideB + j * mStrideH +
+                        (m + row) * mStrideM + n,
+                    kvBlockSize);
+              }
+              if (is_causal && num_keys - n <= kvSplitSize) {
+                int64_t last_col = m + row - n;
+                torch_ipex::cpu::kernel::fill_stub(
+                    qk_row + last_col + 1,
+                    -std::numeric_limits<float>::infinity(),
+                    kvBlockSize - last_col - 1);
+              }
+            }
+            // Update coefficients with Softmax, quantize the probabilities
+            for (const auto row : c10::irange(qBlockSize)) {
+              float* qk_row = qk_data + row * kvBlockSize;
+              float tmp_max = at::vec::reduce_all<float>(
+                  [](Vec& x, Vec& y) { return at::vec::maximum(x, y); },
+                  qk_row,
+                  kvBlockSize);
+              tmp_max = std::max(qk_max_data[row], tmp_max);
+              // qk <- exp(qk - max) and sum per row
+              float tmp_sum = tmp_max;
+              _exp_reduce_sum_fusion_kernel(
+                  qk_row, kvBlockSize, qk_row, tmp_sum);
+              float exp_tmp = std::exp(qk_max_data[row] - tmp_max);
+              qk_sum_data[row] = tmp_sum + exp_tmp * qk_sum_data[row];
+              qk_max_data[row] = tmp_max;
+              if (n > 0) {
+                at::vec::map<float>(
+                    [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
+                    dst_data + row * headSize,
+                    dst_data + row * headSize,
+                    headSize);
+              }
+              uint8_t* p_u8_row = p_u8_data + row * kvBlockSize;
+              for (const auto col : c10::irange(kvBlockSize)) {
+                p_u8_row[col] = static_cast<uint8_t>(qk_row[col] * 255.f + .5f);
+              }
+            }
+            // Calculate Softmax(q @ k.T) @ v in int32
+            _mkl_gemm_u8s8s32(
+                CblasNoTrans,
+                qBlockSize,
+                headSize,
+                kvBlockSize,
+                p_u8_data,
+                kvBlockSize,
+                0,
+                v_data + i * vStrideB + j * vStrideH + n * vStrideN,
+                vStrideN,
+                pv_s32_data,
+                headSize);
+            for (const auto idx : c10::irange(qBlockSize * headSize)) {
+              float pv = static_cast<float>(pv_s32_data[idx]) * pv_scale;
+              dst_data[idx] = n == 0 ? pv : dst_data[idx] + pv;
+            }
+          }
+          // dst <- dst / sum[row], requantized for int8 output
+          for (const auto row : c10::irange(qBlockSize)) {
+            _store_int8_attention_output(
+                out_data + i * oStrideB + j * oStrideH + (m + row) * oStrideM,
+                dst_data + row * headSize,
+                output_scale / qk_sum_data[row],
+                headSize);
+          }
+          // Move to the next query
+          at::native::data_index_step(i, batchSize, j, num_head, k, qSlice);
+        }
+      });
+}
+
+template <typename out_t>
+void int8_flash_attention_kernel_impl(
+    const at::Tensor& output,
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    c10::optional<at::Tensor> attention_mask,
+    float scaling_factor,
+    float output_scale) {
+  utils::KernelProfileScope profile(
+      "int8_flash_attention", query, key, value);
+  profile.add_cost(
+      (is_causal ? 2.0 : 4.0) * query.numel() * key.size(2),
+      query.nbytes() + key.nbytes() + value.nbytes(),
+      output.nbytes());
+  auto q_seq_len = query.size(2);
+  if (q_seq_len >= 768) {
+    cpu_int8_flash_attention<out_t, 256, 512>(
+        output,
+        query,
+        key,
+        value,
+        q_scale,
+        k_scale,
+        v_scale,
+        is_causal,
+        attention_mask,
+        scaling_factor,
+        output_scale);
+  } else if (q_seq_len >= 192) {
+    cpu_int8_flash_attention<out_t, 64, 512>(
+        output,
+        query,
+        key,
+        value,
+        q_scale,
+        k_scale,
+        v_scale,
+        is_causal,
+        attention_mask,
+        scaling_factor,
+        output_scale);
+  } else {
+    cpu_int8_flash_attention<out_t, 32, 512>(
+        output,
+        query,
+        key,
+        value,
+        q_scale,
+        k_scale,
+        v_scale,
+        is_causal,
+        attention_mask,
+        scaling_factor,
+        output_scale);
+  }
+}
+
+at::Tensor int8_flash_attention_kernel(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    const at::Tensor& q_scale,
+    const at::Tensor& k_scale,
+    const at::Tensor& v_scale,
+    bool is_causal,
+    c10::optional<at::Tensor> attention_mask,
+    c10::optional<double> scale,
+    c10::optional<double> output_scale) {
+  RECORD_FUNCTION(
+      "torch_ipex::int8_flash_attention_kernel",
+      c10::ArrayRef<c10::IValue>({}));
+
+  TORCH_CHECK(
+      query.dim() == 4 && key.dim() == 4 && value.dim() == 4,
+      "IPEX int8_flash_attention: Accept only 4 dims inputs shape of {B, H, T, K}");
+  TORCH_CHECK(
+      query.scalar_type() == at::kChar && key.scalar_type() == at::kChar &&
+          value.scalar_type() == at::kChar,
+      "IPEX int8_flash_attention: Q/K/V should be int8");
+  TORCH_CHECK(
+      (query.size(3) == value.size(3)) && (key.size(3) == value.size(3)),
+      "IPEX int8_flash_attention: Q/K/V should have the same head size");
+  TORCH_CHECK(
+      (query.stride(-1) == 1) && (key.stride(-1) == 1) &&
+          (value.stride(-1) == 1),
+      "IPEX int8_flash_attention: Q/K/V should be continuous on the last dim");
+  int64_t batchSize = query.size(0);
+  int64_t num_head = query.size(1);
+  int64_t qSize = query.size(2);
+  int64_t headSize = query.size(3);
+
+  // Per tensor scales are broadcast to the heads
+  auto per_head_scale = [num_head](const at::Tensor& s) {
+    TORCH_CHECK(
+        s.numel() == 1 || s.numel() == num_head,
+        "IPEX int8_flash_attention: Expect per tensor or per head scales");
+    return s.to(at::kFloat).reshape({-1}).expand({num_head}).contiguous();
+  };
+  if (attention_mask.has_value()) {
+    auto mask = attention_mask.value();
+    if (mask.scalar_type() == at::kBool) {
+      mask = at::zeros(mask.sizes(), mask.options().dtype(at::kFloat))
+                 .masked_fill_(
+                     mask.logical_not(),
+                     -std::numeric_limits<float>::infinity());
+    }
+    mask = mask.to(at::kFloat);
+    TORCH_CHECK(
+        mask.dim() == 4 && mask.stride(-1) == 1,
+        "IPEX int8_flash_attention: Mask should be 4 dims and continuous on the last dim");
+    attention_mask = mask;
+  }
+  float scaling_factor = calculate_scale(query, scale).as_float_unchecked();
+
+  auto q_scale_ = per_head_scale(q_scale);
+  auto k_scale_ = per_head_scale(k_scale);
+  auto v_scale_ = per_head_scale(v_scale);
+  // int8 output of the given scale, or bf16
+  at::Tensor output;
+  if (!int8_gemm_is_exact()) {
+    // Dequantize and run the FP32 kernel
+    auto dequant = [](const at::Tensor& x, const at::Tensor& s) {
+      return x.to(at::kFloat).mul_(s.view({1, -1, 1, 1}));
+    };
+    auto q = dequant(query, q_scale_);
+    output = at::empty({batchSize, qSize, num_head, headSize}, q.options());
+    at::Tensor logsumexp =
+        at::empty({batchSize, qSize, num_head}, q.options());
+    flash_attention_kernel_impl(
+        output,
+        logsumexp,
+        q,
+        dequant(key, k_scale_),
+        dequant(value, v_scale_),
+        0.0,
+        is_causal,
+        attention_mask,
+        scaling_factor);
+    if (output_scale.has_value()) {
+      output = output.div_(output_scale.value())
+                   .round_()
+                   .clamp_(-128, 127)
+                   .to(at::kChar);
+    } else {
+      output = output.to(at::kBFloat16);
+    }
+  } else if (output_scale.has_value()) {
+    output = at::empty({batchSize, qSize, num_head, headSize}, query.options());
+    int8_flash_attention_kernel_impl<int8_t>(
+        output,
+        query,
+        key,
+        value,
+        q_scale_,
+        k_scale_,
+        v_scale_,
+        is_causal,
+        attention_mask,
+        scaling_factor,
+        1.f / output_scale.value());
+  } else {
+    output = at::empty(
+        {batchSize, qSize, num_head, headSize},
+        query.options().dtype(at::kBFloat16));
+    int8_flash_attention_kernel_impl<at::BFloat16>(
+        output,
+        query,
+        key,
+        value,
+        q_scale_,
+        k_scale_,
+        v_scale_,
+        is_causal,
+        attention_mask,
+        scaling_factor,
+        1.f);
+  }
+  return output.transpose(1, 2);
+}
+
 std::tuple<at::Tensor, at::Tensor> flash_attention_kernel(
     const at::Tensor& query,
     const at::Tensor& key,
@@ -1438,6 +1944,9 @@ std::tuple<at::Tensor, at::Tensor> flash_attention_kernel(
 } // anonymous namespace
 
 IPEX_REGISTER_DISPATCH(flash_attention_kernel_stub, &flash_attention_kernel);
+IPEX_REGISTER_DISPATCH(
+    int8_flash_attention_kernel_stub,
+    &int8_flash_attention_kernel);
 
 } // namespace cpu
 } // namespace torch_ipex
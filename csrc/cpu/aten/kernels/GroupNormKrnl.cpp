@@ -29,6 +29,59 @@ namespace cpu {
 
 namespace {
 
+template <typename T>
+inline at::vec::Vectorized<T> LoadPartial(const T* ptr, int64_t len) {
+  using Vec = at::vec::Vectorized<T>;
+  return len == Vec::size() ? Vec::loadu(ptr) : Vec::loadu(ptr, len);
+}
+
+template <typename T>
+inline void StorePartial(
+    const at::vec::Vectorized<T>& vec,
+    T* ptr,
+    int64_t len) {
+  if (len == at::vec::Vectorized<T>::size()) {
+    vec.store(ptr);
+  } else {
+    vec.store(ptr, len);
+  }
+}
+
+// Epilogue of the fused GroupNorm-SiLU(-add): y = silu(y) + other in place
+// on a row of the normalized output, while the row is still in cache.
+// other_ptr is nullptr without the residual add.
+template <typename T>
+void ApplySiluAdd(T* Y_ptr, const T* other_ptr, int64_t size) {
+  using opmath_t = at::opmath_type<T>;
+  using fVec = at::vec::Vectorized<opmath_t>;
+  using Vec = at::vec::Vectorized<T>;
+  const fVec one(opmath_t(1));
+  auto silu = [&](const fVec& y) { return y / (one + y.neg().exp()); };
+  for (int64_t d = 0; d < size; d += Vec::size()) {
+    const int64_t len = std::min<int64_t>(Vec::size(), size - d);
+    if constexpr (std::is_same<T, opmath_t>::value) {
+      fVec y = silu(LoadPartial(Y_ptr + d, len));
+      if (other_ptr != nullptr) {
+        y = y + LoadPartial(other_ptr + d, len);
+      }
+      StorePartial(y, Y_ptr + d, len);
+    } else {
+      fVec y0, y1;
+      std::tie(y0, y1) = convert_to_float<T>(LoadPartial(Y_ptr + d, len));
+      y0 = silu(y0);
+      y1 = silu(y1);
+      if (other_ptr != nullptr) {
+        fVec other0, other1;
+        std::tie(other0, other1) =
+            convert_to_float<T>(LoadPartial(other_ptr + d, len));
+        y0 = y0 + other0;
+        y1 = y1 + other1;
+      }
+      StorePartial(convert_from_float<T>(y0, y1), Y_ptr + d, len);
+    }
+  }
+}
+
 template <typename T, typename PT>
 void GroupNormKernelImplInternal(
     const at::Tensor& X,
@@ -41,7 +94,9 @@ void GroupNormKernelImplInternal(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const at::Tensor& other,
+    bool silu) {
   TORCH_CHECK(X.numel() == N * C * HxW);
   TORCH_CHECK(!gamma.defined() || gamma.numel() == C);
   TORCH_CHECK(!beta.defined() || beta.numel() == C);
@@ -51,6 +106,7 @@ void GroupNormKernelImplInternal(
   const PT* gamma_data = gamma.defined() ? gamma.data_ptr<PT>() : nullptr;
   const PT* beta_data = beta.defined() ? beta.data_ptr<PT>() : nullptr;
   T* Y_data = Y.data_ptr<T>();
+  const T* other_data = other.defined() ? other.data_ptr<T>() : nullptr;
   PT* mean_data = mean.data_ptr<PT>();
   PT* rstd_data = rstd.data_ptr<PT>();
   const bool gamma_null = (gamma_data == nullptr);
@@ -72,6 +128,12 @@ void GroupNormKernelImplInternal(
         for (const auto j : c10::irange(inner_size)) {
           Y_ptr[j] = (X_ptr[j] - mean_val) * rstd_val;
         }
+        if (silu) {
+          ApplySiluAdd<T>(
+              Y_ptr,
+              other_data ? other_data + i * inner_size : nullptr,
+              inner_size);
+        }
       } else {
         const int64_t g = i % G;
         for (const auto j : c10::irange(D)) {
@@ -85,6 +147,12 @@ void GroupNormKernelImplInternal(
           for (const auto k : c10::irange(HxW)) {
             Y_ptr[k] = scale * X_ptr[k] + bias;
           }
+          if (silu) {
+            ApplySiluAdd<T>(
+                Y_ptr,
+                other_data ? other_data + (i * D + j) * HxW : nullptr,
+                HxW);
+          }
         }
       }
       mean_data[i] = mean_val;
@@ -306,7 +374,9 @@ void GroupNormKernelImplChannelsLastInternal(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const at::Tensor& other,
+    bool silu) {
   TORCH_CHECK(X.numel() == N * C * HxW);
   TORCH_CHECK(!gamma.defined() || gamma.numel() == C);
   TORCH_CHECK(!beta.defined() || beta.numel() == C);
@@ -316,6 +386,7 @@ void GroupNormKernelImplChannelsLastInternal(
   const PT* gamma_data = gamma.defined() ? gamma.data_ptr<PT>() : nullptr;
   const PT* beta_data = beta.defined() ? beta.data_ptr<PT>() : nullptr;
   T* Y_data = Y.data_ptr<T>();
+  const T* other_data = other.defined() ? other.data_ptr<T>() : nullptr;
   PT* mean_data = mean.data_ptr<PT>();
   PT* rstd_data = rstd.data_ptr<PT>();
 
@@ -388,6 +459,13 @@ void GroupNormKernelImplChannelsLastInternal(
           const T* X_ptr = X_data + n * HxW * C + m * C + g * D;
           T* Y_ptr = Y_data + n * HxW * C + m * C + g * D;
           ApplyScaleBias<T, opmath_t>(Y_ptr, X_ptr, scale_ptr, bias_ptr, D);
+          if (silu) {
+            ApplySiluAdd<T>(
+                Y_ptr,
+                other_data ? other_data + n * HxW * C + m * C + g * D
+                           : nullptr,
+                D);
+          }
         }
         at::native::data_index_step(n, N, g, G);
       }
@@ -498,13 +576,17 @@ void GroupNormKernelImplChannelsLastInternal(
         opmath_t* scale_ptr = buffer_data + n * 2 * C;
         opmath_t* bias_ptr = scale_ptr + C;
         ApplyScaleBias<T, opmath_t>(Y_ptr, X_ptr, scale_ptr, bias_ptr, C);
+        if (silu) {
+          ApplySiluAdd<T>(
+              Y_ptr, other_data ? other_data + i * C : nullptr, C);
+        }
         at::native::data_index_step(n, N, m, HxW);
       }
     });
   }
 }
 
-void GroupNormKernelImpl(
+void GroupNormKernelImplCommon(
     const at::Tensor& X,
     const at::Tensor& gamma,
     const at::Tensor& beta,
@@ -515,7 +597,9 @@ void GroupNormKernelImpl(
     double eps,
     at::Tensor& Y,
     at::Tensor& mean,
-    at::Tensor& rstd) {
+    at::Tensor& rstd,
+    const at::Tensor& other,
+    bool silu) {
   const bool mixed_type = at::native::is_mixed_type(X, gamma, beta);
   switch (X.suggest_memory_format()) {
     case at::MemoryFormat::Contiguous: {
@@ -529,18 +613,66 @@ void GroupNormKernelImpl(
             if (!is_channels_last_1d(X)) {
               if (mixed_type) {
                 GroupNormKernelImplInternal<scalar_t, param_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    other,
+                    silu);
               } else {
                 GroupNormKernelImplInternal<scalar_t, scalar_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    other,
+                    silu);
               }
             } else {
               if (mixed_type) {
                 GroupNormKernelImplChannelsLastInternal<scalar_t, param_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    other,
+                    silu);
               } else {
                 GroupNormKernelImplChannelsLastInternal<scalar_t, scalar_t>(
-                    X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                    X,
+                    gamma,
+                    beta,
+                    N,
+                    C,
+                    HxW,
+                    group,
+                    eps,
+                    Y,
+                    mean,
+                    rstd,
+                    other,
+                    silu);
               }
             }
           });
@@ -557,10 +689,34 @@ void GroupNormKernelImpl(
             using param_t = at::opmath_type<scalar_t>;
             if (mixed_type) {
               GroupNormKernelImplChannelsLastInternal<scalar_t, param_t>(
-                  X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                  X,
+                  gamma,
+                  beta,
+                  N,
+                  C,
+                  HxW,
+                  group,
+                  eps,
+                  Y,
+                  mean,
+                  rstd,
+                  other,
+                  silu);
             } else {
               GroupNormKernelImplChannelsLastInternal<scalar_t, scalar_t>(
-                  X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd);
+                  X,
+                  gamma,
+                  beta,
+                  N,
+                  C,
+                  HxW,
+                  group,
+                  eps,
+                  Y,
+                  mean,
+                  rstd,
+                  other,
+                  silu);
             }
           });
       break;
@@ -572,6 +728,247 @@ void GroupNormKernelImpl(
   }
 }
 
+void GroupNormKernelImpl(
+    const at::Tensor& X,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    double eps,
+    at::Tensor& Y,
+    at::Tensor& mean,
+    at::Tensor& rstd) {
+  GroupNormKernelImplCommon(
+      X,
+      gamma,
+      beta,
+      N,
+      C,
+      HxW,
+      group,
+      eps,
+      Y,
+      mean,
+      rstd,
+      at::Tensor() /* other */,
+      false /* silu */);
+}
+
+void GroupNormSiluKernelImpl(
+    const at::Tensor& X,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    const at::Tensor& other,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    double eps,
+    at::Tensor& Y,
+    at::Tensor& mean,
+    at::Tensor& rstd) {
+  GroupNormKernelImplCommon(
+      X, gamma, beta, N, C, HxW, group, eps, Y, mean, rstd, other, true);
+}
+
+// dY of the GroupNorm output y = x * scale + bias from the dY of silu(y):
+// dy * s * (1 + y * (1 - s)) with s = sigmoid(y). scale_ptr and bias_ptr
+// point to one value for the whole row if broadcast, else to one value per
+// element.
+template <typename T>
+void ApplySiluBackward(
+    T* dY_gn_ptr,
+    const T* dY_ptr,
+    const T* X_ptr,
+    const at::opmath_type<T>* scale_ptr,
+    const at::opmath_type<T>* bias_ptr,
+    int64_t size,
+    bool broadcast) {
+  using opmath_t = at::opmath_type<T>;
+  using fVec = at::vec::Vectorized<opmath_t>;
+  using Vec = at::vec::Vectorized<T>;
+  const fVec one(opmath_t(1));
+  auto load_param = [&](const opmath_t* ptr, int64_t d, int64_t len) {
+    return broadcast ? fVec(*ptr) : LoadPartial(ptr + d, len);
+  };
+  auto silu_grad = [&](const fVec& dy,
+                       const fVec& x,
+                       const fVec& scale,
+                       const fVec& bias) {
+    fVec y = x * scale + bias;
+    fVec sig = one / (one + y.neg().exp());
+    return dy * sig * (one + y * (one - sig));
+  };
+  for (int64_t d = 0; d < size; d += Vec::size()) {
+    const int64_t len = std::min<int64_t>(Vec::size(), size - d);
+    if constexpr (std::is_same<T, opmath_t>::value) {
+      fVec out = silu_grad(
+          LoadPartial(dY_ptr + d, len),
+          LoadPartial(X_ptr + d, len),
+          load_param(scale_ptr, d, len),
+          load_param(bias_ptr, d, len));
+      StorePartial(out, dY_gn_ptr + d, len);
+    } else {
+      const int64_t len0 = std::min<int64_t>(fVec::size(), len);
+      const int64_t len1 = len - len0;
+      fVec dy0, dy1, x0, x1;
+      std::tie(dy0, dy1) = convert_to_float<T>(LoadPartial(dY_ptr + d, len));
+      std::tie(x0, x1) = convert_to_float<T>(LoadPartial(X_ptr + d, len));
+      fVec out0 = silu_grad(
+          dy0,
+          x0,
+          load_param(scale_ptr, d, len0),
+          load_param(bias_ptr, d, len0));
+      fVec out1 = silu_grad(
+          dy1,
+          x1,
+          load_param(scale_ptr, d + fVec::size(), len1),
+          load_param(bias_ptr, d + fVec::size(), len1));
+      StorePartial(convert_from_float<T>(out0, out1), dY_gn_ptr + d, len);
+    }
+  }
+}
+
+template <typename T, typename PT>
+void GroupNormSiluBackwardKernelImplInternal(
+    const at::Tensor& dY,
+    const at::Tensor& X,
+    const at::Tensor& mean,
+    const at::Tensor& rstd,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    bool channels_last,
+    at::Tensor& dY_gn) {
+  TORCH_CHECK(dY.numel() == N * C * HxW);
+  TORCH_CHECK(X.numel() == N * C * HxW);
+  TORCH_CHECK(mean.numel() == N * group);
+  TORCH_CHECK(rstd.numel() == N * group);
+  TORCH_CHECK(!gamma.defined() || gamma.numel() == C);
+  TORCH_CHECK(!beta.defined() || beta.numel() == C);
+  const int64_t G = group;
+  const int64_t D = C / G;
+  const T* dY_data = dY.data_ptr<T>();
+  const T* X_data = X.data_ptr<T>();
+  const PT* mean_data = mean.data_ptr<PT>();
+  const PT* rstd_data = rstd.data_ptr<PT>();
+  const PT* gamma_data = gamma.defined() ? gamma.data_ptr<PT>() : nullptr;
+  const PT* beta_data = beta.defined() ? beta.data_ptr<PT>() : nullptr;
+  T* dY_gn_data = dY_gn.data_ptr<T>();
+
+  using opmath_t = at::opmath_type<T>;
+
+  // Recompute the GroupNorm output as y = x * scale + bias, with scale and
+  // bias of shape {N, C}, instead of saving it in the forward
+  at::Tensor buffer = at::empty(
+      {N, 2 * C}, X.options().dtype(c10::CppTypeToScalarType<opmath_t>::value));
+  opmath_t* buffer_data = buffer.data_ptr<opmath_t>();
+  for (const auto n : c10::irange(N)) {
+    opmath_t* scale_ptr = buffer_data + n * 2 * C;
+    opmath_t* bias_ptr = scale_ptr + C;
+    for (const auto c : c10::irange(C)) {
+      const int64_t i = n * G + c / D;
+      scale_ptr[c] = opmath_t(rstd_data[i]) *
+          (gamma_data == nullptr ? opmath_t(1) : opmath_t(gamma_data[c]));
+      bias_ptr[c] = -scale_ptr[c] * opmath_t(mean_data[i]) +
+          (beta_data == nullptr ? opmath_t(0) : opmath_t(beta_data[c]));
+    }
+  }
+
+  if (channels_last) {
+    // Rows of C, vectorized on C with the scale and bias of each channel
+    at::parallel_for(0, N * HxW, 1, [&](int64_t begin, int64_t end) {
+      for (const auto i : c10::irange(begin, end)) {
+        const opmath_t* scale_ptr = buffer_data + i / HxW * 2 * C;
+        ApplySiluBackward<T>(
+            dY_gn_data + i * C,
+            dY_data + i * C,
+            X_data + i * C,
+            scale_ptr,
+            scale_ptr + C,
+            C,
+            false /* broadcast */);
+      }
+    });
+  } else {
+    // Rows of HxW, vectorized on HxW with the scale and bias of the row
+    at::parallel_for(0, N * C, 1, [&](int64_t begin, int64_t end) {
+      for (const auto i : c10::irange(begin, end)) {
+        const opmath_t* scale_ptr = buffer_data + i / C * 2 * C + i % C;
+        ApplySiluBackward<T>(
+            dY_gn_data + i * HxW,
+            dY_data + i * HxW,
+            X_data + i * HxW,
+            scale_ptr,
+            scale_ptr + C,
+            HxW,
+            true /* broadcast */);
+      }
+    });
+  }
+}
+
+void GroupNormSiluBackwardKernelImpl(
+    const at::Tensor& dY,
+    const at::Tensor& X,
+    const at::Tensor& mean,
+    const at::Tensor& rstd,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t group,
+    at::Tensor& dY_gn) {
+  const bool mixed_type = at::native::is_mixed_type(X, mean, rstd);
+  const auto memory_format = X.suggest_memory_format();
+  const bool channels_last = is_channels_last_1d(X) ||
+      memory_format == at::MemoryFormat::ChannelsLast ||
+      memory_format == at::MemoryFormat::ChannelsLast3d;
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::BFloat16,
+      at::ScalarType::Half,
+      X.scalar_type(),
+      "GroupNormSiluBackwardKernelImpl",
+      [&]() {
+        using param_t = at::opmath_type<scalar_t>;
+        if (mixed_type) {
+          GroupNormSiluBackwardKernelImplInternal<scalar_t, param_t>(
+              dY,
+              X,
+              mean,
+              rstd,
+              gamma,
+              beta,
+              N,
+              C,
+              HxW,
+              group,
+              channels_last,
+              dY_gn);
+        } else {
+          GroupNormSiluBackwardKernelImplInternal<scalar_t, scalar_t>(
+              dY,
+              X,
+              mean,
+              rstd,
+              gamma,
+              beta,
+              N,
+              C,
+              HxW,
+              group,
+              channels_last,
+              dY_gn);
+        }
+      });
+}
+
 template <typename T, typename opmath_t>
 typename std::enable_if<std::is_same<T, opmath_t>::value, void>::type
 ComputeInternalGradients(
@@ -1738,6 +2135,10 @@ void GroupNormBackwardKernelImpl(
 
 IPEX_REGISTER_DISPATCH(GroupNormKernel, &GroupNormKernelImpl);
 IPEX_REGISTER_DISPATCH(GroupNormBackwardKernel, &GroupNormBackwardKernelImpl);
+IPEX_REGISTER_DISPATCH(GroupNormSiluKernel, &GroupNormSiluKernelImpl);
+IPEX_REGISTER_DISPATCH(
+    GroupNormSiluBackwardKernel,
+    &GroupNormSiluBackwardKernelImpl);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -4,6 +4,8 @@
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
 #include <limits>
+#include "utils/kernel_profiler.h"
+#include "utils/parallel_partition.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -489,6 +491,75 @@ void copy_key_value(
   }
 }
 
+/*
+ *Splits the (token, batch, head) items of the loops of the QK and AV of the
+ *indirect access kv cache attention among threads. The work of an item is
+ *its number of query tokens that attend to the token, which is the same for
+ *all the items of decoding, which are split uniformly. For the prompt, the
+ *split is balanced over the work of the tokens, of which the items of a
+ *token are split by their (batch, head) pairs.
+ */
+class IndirectAccessKvCacheSplit {
+ public:
+  IndirectAccessKvCacheSplit(
+      int64_t seq_len,
+      int64_t bs,
+      int64_t head_num,
+      int64_t cur_len,
+      int64_t offset)
+      : seq_len_(seq_len),
+        num_pairs_(bs * head_num),
+        cur_len_(cur_len),
+        offset_(offset) {
+    if (cur_len == 1) {
+      return;
+    }
+    token_prefix_.resize(seq_len + 1, 0);
+    for (int64_t ti = 0; ti < seq_len; ti++) {
+      token_prefix_[ti + 1] = token_prefix_[ti] + token_cost(ti) * num_pairs_;
+    }
+  }
+
+  // Calls f(i) for the items i = (ti * bs + bi) * head_num + hi of part of
+  // num_parts
+  template <typename F>
+  void for_each_item(int64_t part, int64_t num_parts, const F& f) const {
+    if (token_prefix_.empty()) {
+      auto n = seq_len_ * num_pairs_;
+      for (auto i = n * part / num_parts; i < n * (part + 1) / num_parts; i++) {
+        f(i);
+      }
+      return;
+    }
+    utils::for_each_balanced_range(
+        token_prefix_,
+        part,
+        num_parts,
+        [&](int64_t ti, int64_t begin, int64_t end) {
+          // Unit u of the token belongs to pair u / cost, which is taken by
+          // the part with the first unit of the pair
+          auto cost = token_cost(ti);
+          auto pair_end = (end + cost - 1) / cost;
+          for (auto pair = (begin + cost - 1) / cost; pair < pair_end;
+               pair++) {
+            f(ti * num_pairs_ + pair);
+          }
+        });
+  }
+
+ private:
+  int64_t token_cost(int64_t ti) const {
+    return cur_len_ - std::max<int64_t>(ti - offset_, 0);
+  }
+
+  int64_t seq_len_;
+  int64_t num_pairs_;
+  int64_t cur_len_;
+  int64_t offset_;
+  // Prefix sum of the work of the tokens, empty for the uniform split
+  std::vector<int64_t> token_prefix_;
+};
+
 /*
  *The scale-dot product for indirect access kv chache and fuse
  *matmul+div+add+softmax to improve data reuse
@@ -566,13 +637,22 @@ scale_dot_product_for_indirect_access_kv_cache(
       }
     }
   }
+  auto num_threads = omp_get_max_threads();
+  IndirectAccessKvCacheSplit split(seq_len, bs, head_num, cur_len, offset);
+  auto profile_scope = utils::KernelProfileScope::current();
   {
     RECORD_FUNCTION(
         "ipex::iakv_sdp::matmul(query, key)", c10::ArrayRef<c10::IValue>({}));
-#pragma omp parallel for collapse(3)
-    for (auto ti = 0; ti < seq_len; ti++) {
-      for (auto bi = 0; bi < bs; bi++) {
-        for (auto hi = 0; hi < head_num; hi++) {
+    utils::KernelProfileRegion profile_region("qk");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      for (auto part = omp_get_thread_num(); part < num_threads;
+           part += omp_get_num_threads()) {
+        split.for_each_item(part, num_threads, [&](int64_t i) {
+          auto ti = i / (bs * head_num);
+          auto bi = i / head_num % bs;
+          auto hi = i % head_num;
           for (auto query_ti = 0; query_ti < cur_len; query_ti++) {
             auto kv_hi = hi / group_size; // maping the query head to key/value
                                           // head to support MGA/MQA
@@ -643,7 +723,7 @@ scale_dot_product_for_indirect_access_kv_cache(
               }
             }
           }
-        }
+        });
       }
     }
   }
@@ -718,10 +798,16 @@ scale_dot_product_for_indirect_access_kv_cache(
     RECORD_FUNCTION(
         "ipex::iakv_sdp::matmul(attn_w, value)",
         c10::ArrayRef<c10::IValue>({}));
-#pragma omp parallel for collapse(3)
-    for (auto vi = 0; vi < seq_len; vi++) {
-      for (auto bi = 0; bi < bs; bi++) {
-        for (auto hi = 0; hi < head_num; hi++) {
+    utils::KernelProfileRegion profile_region("av");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      for (auto part = omp_get_thread_num(); part < num_threads;
+           part += omp_get_num_threads()) {
+        split.for_each_item(part, num_threads, [&](int64_t i) {
+          auto vi = i / (bs * head_num);
+          auto bi = i / head_num % bs;
+          auto hi = i % head_num;
           auto thread_id = omp_get_thread_num();
           for (auto query_ti = 0; query_ti < cur_len; query_ti++) {
             auto kv_hi = hi / group_size; // maping the query head to key/value
@@ -800,7 +886,7 @@ scale_dot_product_for_indirect_access_kv_cache(
           }
           if (flag_access[thread_id][bi][hi] == 0)
             flag_access[thread_id][bi][hi] = 1;
-        }
+        });
       }
     }
   }
@@ -898,13 +984,22 @@ scale_dot_product_for_indirect_access_kv_cache_half(
       }
     }
   }
+  auto num_threads = omp_get_max_threads();
+  IndirectAccessKvCacheSplit split(seq_len, bs, head_num, cur_len, offset);
+  auto profile_scope = utils::KernelProfileScope::current();
   {
     RECORD_FUNCTION(
         "ipex::iakv_sdp::matmul(query, key)", c10::ArrayRef<c10::IValue>({}));
-#pragma omp parallel for collapse(3)
-    for (auto ti = 0; ti < seq_len; ti++) {
-      for (auto bi = 0; bi < bs; bi++) {
-        for (auto hi = 0; hi < head_num; hi++) {
+    utils::KernelProfileRegion profile_region("qk");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      for (auto part = omp_get_thread_num(); part < num_threads;
+           part += omp_get_num_threads()) {
+        split.for_each_item(part, num_threads, [&](int64_t i) {
+          auto ti = i / (bs * head_num);
+          auto bi = i / head_num % bs;
+          auto hi = i % head_num;
           for (auto query_ti = 0; query_ti < cur_len; query_ti++) {
             auto kv_hi = hi / group_size; // maping the query head to key/value
                                           // head to support MGA/MQA
@@ -975,7 +1070,7 @@ scale_dot_product_for_indirect_access_kv_cache_half(
               }
             }
           }
-        }
+        });
       }
     }
   }
@@ -1024,10 +1119,16 @@ scale_dot_product_for_indirect_access_kv_cache_half(
     RECORD_FUNCTION(
         "ipex::iakv_sdp::matmul(attn_w, value)",
         c10::ArrayRef<c10::IValue>({}));
-#pragma omp parallel for collapse(3)
-    for (auto vi = 0; vi < seq_len; vi++) {
-      for (auto bi = 0; bi < bs; bi++) {
-        for (auto hi = 0; hi < head_num; hi++) {
+    utils::KernelProfileRegion profile_region("av");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      for (auto part = omp_get_thread_num(); part < num_threads;
+           part += omp_get_num_threads()) {
+        split.for_each_item(part, num_threads, [&](int64_t i) {
+          auto vi = i / (bs * head_num);
+          auto bi = i / head_num % bs;
+          auto hi = i % head_num;
           auto thread_id = omp_get_thread_num();
           for (auto query_ti = 0; query_ti < cur_len; query_ti++) {
             auto kv_hi = hi / group_size; // maping the query head to key/value
@@ -1106,7 +1207,7 @@ scale_dot_product_for_indirect_access_kv_cache_half(
             if (flag_access[thread_id][bi][hi] == 0)
               flag_access[thread_id][bi][hi] = 1;
           }
-        }
+        });
       }
     }
   }
@@ -1154,6 +1255,22 @@ zero_copy_kv_cache_masked_multihead_self_attention_kernel_impl(
   assert(
       key.scalar_type() == at::kBFloat16 || key.scalar_type() == at::kFloat ||
       key.scalar_type() == at::kHalf);
+  utils::KernelProfileScope profile(
+      "indirect_access_kv_cache_attention", query, key, value, key_cache);
+  if (profile.active()) {
+    // Each query token attends to the past tokens and itself
+    auto bs = query.size(0);
+    auto cur_len = query.size(1);
+    auto head_num = query.size(2);
+    auto head_size = query.size(3);
+    auto attended = cur_len * offset + cur_len * (cur_len + 1) / 2;
+    auto past_bytes =
+        offset * bs * key.size(2) * head_size * key_cache.element_size();
+    profile.add_cost(
+        4.0 * bs * head_num * head_size * attended,
+        query.nbytes() + key.nbytes() + value.nbytes() + 2.0 * past_bytes,
+        query.nbytes() + key.nbytes() + value.nbytes());
+  }
   if (query.scalar_type() == at::kFloat && value.scalar_type() == at::kFloat) {
     return scale_dot_product_for_indirect_access_kv_cache<float, float>(
         query,
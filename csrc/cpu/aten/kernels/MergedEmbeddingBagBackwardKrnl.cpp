@@ -2,6 +2,8 @@
 #include <aten/MergedEmbeddingBag.h>
 #include <c10/core/CPUAllocator.h>
 #include <omp.h>
+#include <array>
+#include <cstring>
 #include "vec/merged_emb_utils.hpp"
 #include "vec/unroll_helper.hpp"
 #include "vec/vec.h"
@@ -25,7 +27,7 @@ typename std::enable_if<
 #if defined(CPU_CAPABILITY_AVX512_BF16)
   if (emb_dim == 128) {
     __m512 cache_vec[8];
-    auto emb_cache = ewc.cache();
+    const auto& emb_cache = ewc.cache();
     for (auto& [k, v] : emb_cache) {
       compile_time_for<8>::op(load_fp32, cache_vec, v);
       if (std::is_same<data_t, BFloat16>::value)
@@ -42,7 +44,7 @@ typename std::enable_if<
   using fVec = at::vec::Vectorized<float>;
   auto vec_size = lpVec::size();
   auto fvec_size = fVec::size();
-  auto emb_cache = ewc.cache();
+  const auto& emb_cache = ewc.cache();
   for (auto& [k, v] : emb_cache) {
     int64_t i = 0;
     for (; i + vec_size <= emb_dim; i += vec_size) {
@@ -251,8 +253,10 @@ merged_embeddingbag_dense_backward(
                                         // will be double
 #pragma omp parallel
   {
+    // reused by the tables and the calls, see EmbeddingRowCache
+    thread_local EmbeddingRowCache<acc_t> ewc;
     for (int32_t n = 0; n < num_emb; ++n) {
-      EmbeddingRowCache<acc_t> ewc;
+      ewc.clear();
       embeddingbag_bwd_acc_kern<data_t, index_t, acc_t, /*use_cache=*/true>(
           /*bs_begin=*/0,
           num_batch,
@@ -572,7 +576,7 @@ void inline EmbeddingGradUpdate<data_t, acc_t, SGDArgs>::update(
     const int32_t table_id,
     const int64_t emb_dim) {
   BFloat16* bf16_trail_ptr = args.bf16_trail[table_id].data_ptr<BFloat16>();
-  auto emb_cache = ewc.cache();
+  const auto& emb_cache = ewc.cache();
   for (auto& it : emb_cache) {
     size_t idx = it.first;
     acc_t* grad = it.second;
@@ -595,7 +599,7 @@ void inline EmbeddingGradUpdate<data_t, acc_t, AdaGradArgs>::update(
     const int64_t emb_dim) {
   BFloat16* bf16_trail_ptr = args.bf16_trail[table_id].data_ptr<BFloat16>();
   acc_t* hessian_ptr = args.hessian[table_id].data_ptr<acc_t>();
-  auto emb_cache = ewc.cache();
+  const auto& emb_cache = ewc.cache();
   for (auto& it : emb_cache) {
     size_t idx = it.first;
     acc_t* grad = it.second;
@@ -610,6 +614,377 @@ void inline EmbeddingGradUpdate<data_t, acc_t, AdaGradArgs>::update(
   }
 }
 
+// 8 bits moments are coded on a log scale below the largest magnitude of the
+// row, with kMomentCodesPerOctave codes per octave, so that the small values of
+// a row with large ones keep their relative precision instead of rounding to
+// zero. Code c > 0 stands for 2^((c - 255) / kMomentCodesPerOctave) times the
+// largest magnitude, c = 0 for zero.
+constexpr int kMomentCodesPerOctave = 8;
+
+inline const float* moment_code_table() {
+  static const auto table = [] {
+    std::array<float, 256> t;
+    t[0] = 0;
+    for (int c = 1; c < 256; c++) {
+      t[c] = std::exp2(static_cast<float>(c - 255) / kMomentCodesPerOctave);
+    }
+    return t;
+  }();
+  return table.data();
+}
+
+// Code of x in (0, max], max_code for max, below 1 if x is out of range
+inline int moment_code(float x, float max, int max_code) {
+  float octaves = std::log2(x / max);
+  return max_code +
+      static_cast<int>(std::nearbyint(kMomentCodesPerOctave * octaves));
+}
+
+// Rows of a moment of Adam and LAMB, in acc_t, bfloat16 or 8 bits. An 8 bits
+// row holds the codes of the values and then the largest magnitude of the row
+// in float: int8 rows hold a sign and codes up to 127, for exp_avg, of which
+// the values out of range are flushed to zero. uint8 rows hold codes up to
+// 255, for the non negative exp_avg_sq, of which the values out of range are
+// raised to the smallest code: flushing them would leave only eps in the
+// denominator of the update.
+struct MomentRows {
+  explicit MomentRows(const Tensor& moment)
+      : dtype(moment.scalar_type()),
+        data(moment.data_ptr()),
+        stride(moment.dim() > 1 ? moment.stride(0) : 1) {}
+
+  template <typename acc_t>
+  void load(int64_t row, int64_t size, acc_t* out) const {
+    if (dtype == kBFloat16) {
+      at::vec::convert(static_cast<BFloat16*>(data) + row * stride, out, size);
+    } else if (dtype == kChar) {
+      // int8 code c stands for the uint8 code 128 + c
+      auto src = static_cast<int8_t*>(data) + row * stride;
+      auto table = moment_code_table() + 128;
+      float max;
+      std::memcpy(&max, src + size, sizeof(float));
+      for (int64_t d = 0; d < size; d++) {
+        out[d] = src[d] > 0 ? table[src[d]] * max
+            : src[d] < 0    ? -table[-src[d]] * max
+                            : 0;
+      }
+    } else if (dtype == kByte) {
+      auto src = static_cast<uint8_t*>(data) + row * stride;
+      auto table = moment_code_table();
+      float max;
+      std::memcpy(&max, src + size, sizeof(float));
+      for (int64_t d = 0; d < size; d++) {
+        out[d] = table[src[d]] * max;
+      }
+    } else {
+      auto src = static_cast<acc_t*>(data) + row * stride;
+      std::copy(src, src + size, out);
+    }
+  }
+
+  template <typename acc_t>
+  void store(int64_t row, int64_t size, const acc_t* in) const {
+    if (dtype == kBFloat16) {
+      at::vec::convert(in, static_cast<BFloat16*>(data) + row * stride, size);
+    } else if (dtype == kChar) {
+      auto dst = static_cast<int8_t*>(data) + row * stride;
+      float max = 0;
+      for (int64_t d = 0; d < size; d++) {
+        max = std::max<float>(max, std::abs(in[d]));
+      }
+      for (int64_t d = 0; d < size; d++) {
+        int code = in[d] != 0 ? moment_code(std::abs(in[d]), max, 127) : 0;
+        code = code < 1 ? 0 : code;
+        dst[d] = static_cast<int8_t>(in[d] < 0 ? -code : code);
+      }
+      std::memcpy(dst + size, &max, sizeof(float));
+    } else if (dtype == kByte) {
+      auto dst = static_cast<uint8_t*>(data) + row * stride;
+      float max = 0;
+      for (int64_t d = 0; d < size; d++) {
+        max = std::max<float>(max, in[d]);
+      }
+      for (int64_t d = 0; d < size; d++) {
+        int code = in[d] > 0 ? moment_code(in[d], max, 255) : 0;
+        dst[d] = static_cast<uint8_t>(in[d] > 0 ? std::max(code, 1) : 0);
+      }
+      std::memcpy(dst + size, &max, sizeof(float));
+    } else {
+      std::copy(in, in + size, static_cast<acc_t*>(data) + row * stride);
+    }
+  }
+
+  ScalarType dtype;
+  void* data;
+  int64_t stride;
+};
+
+template <typename param_t>
+inline void load_param(
+    const param_t* param_ptr,
+    const at::BFloat16* trail_ptr,
+    param_t* out,
+    int64_t size) {
+  std::copy(param_ptr, param_ptr + size, out);
+}
+
+inline void load_param(
+    const at::BFloat16* param_ptr,
+    const at::BFloat16* trail_ptr,
+    float* out,
+    int64_t size) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    fVec param_fvec, param_fvec2;
+    std::tie(param_fvec, param_fvec2) = at::vec::pack_bfloat16_float(
+        bVec::loadu(param_ptr + d), bVec::loadu(trail_ptr + d));
+    param_fvec.store(out + d);
+    param_fvec2.store(out + d + fVec::size());
+  }
+  for (; d < size; d++) {
+    out[d] = at::vec::pack_bfloat16_float(param_ptr[d], trail_ptr[d]);
+  }
+}
+
+template <typename param_t>
+inline void store_param(
+    param_t* param_ptr,
+    at::BFloat16* trail_ptr,
+    const param_t* in,
+    int64_t size) {
+  std::copy(in, in + size, param_ptr);
+}
+
+inline void store_param(
+    at::BFloat16* param_ptr,
+    at::BFloat16* trail_ptr,
+    const float* in,
+    int64_t size) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    bVec param_bvec, trail_bvec;
+    std::tie(param_bvec, trail_bvec) = at::vec::unpack_float_bfloat16(
+        fVec::loadu(in + d), fVec::loadu(in + d + fVec::size()));
+    param_bvec.store(param_ptr + d);
+    trail_bvec.store(trail_ptr + d);
+  }
+  for (; d < size; d++) {
+    std::tie(param_ptr[d], trail_ptr[d]) =
+        at::vec::unpack_float_bfloat16(in[d]);
+  }
+}
+
+template <typename acc_t, typename optimizer_args_t>
+inline void adam_update(
+    acc_t* param_ptr,
+    acc_t* exp_avg_ptr,
+    acc_t* exp_avg_sq_ptr,
+    acc_t* update_ptr,
+    const acc_t* grad_ptr,
+    const optimizer_args_t& args,
+    acc_t bias_correction1,
+    acc_t bias_correction2_sqrt,
+    int64_t size) {
+  // grad += weight_decay * param (Adam)
+  // exp_avg = beta1 * exp_avg + (1 - beta1) * grad
+  // exp_avg_sq = beta2 * exp_avg_sq + (1 - beta2) * grad**2, of which the
+  //   rowwise Adam takes the mean over the row
+  // update = exp_avg / bias_correction1 /
+  //   (sqrt(exp_avg_sq) / bias_correction2_sqrt + eps)
+  // param -= lr * update (Adam)
+  // param -= lr * |param| / |update + weight_decay * param| *
+  //   (update + weight_decay * param) (LAMB)
+  constexpr bool rowwise =
+      std::is_same<optimizer_args_t, RowwiseAdamArgs>::value;
+  constexpr bool lamb = std::is_same<optimizer_args_t, LambArgs>::value;
+  using Vec = at::vec::Vectorized<acc_t>;
+  const acc_t beta1 = args.beta1;
+  const acc_t beta2 = args.beta2;
+  const acc_t l2 = lamb ? 0 : args.weight_decay;
+  Vec beta1_vec = Vec(beta1), beta2_vec = Vec(beta2);
+  Vec grad_scale1_vec = Vec(1 - beta1), grad_scale2_vec = Vec(1 - beta2);
+  Vec sq_sum_vec = Vec(0);
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec grad_vec = Vec::loadu(grad_ptr + d);
+    if (l2 != 0) {
+      grad_vec += Vec::loadu(param_ptr + d) * Vec(l2);
+    }
+    Vec exp_avg_vec =
+        Vec::loadu(exp_avg_ptr + d) * beta1_vec + grad_vec * grad_scale1_vec;
+    exp_avg_vec.store(exp_avg_ptr + d);
+    if (rowwise) {
+      sq_sum_vec += grad_vec * grad_vec;
+    } else {
+      Vec exp_avg_sq_vec = Vec::loadu(exp_avg_sq_ptr + d) * beta2_vec +
+          grad_vec * grad_vec * grad_scale2_vec;
+      exp_avg_sq_vec.store(exp_avg_sq_ptr + d);
+    }
+  }
+  acc_t sq_sum = rowwise ? at::vec::vec_reduce_all<acc_t>(
+                               [](Vec& x, Vec& y) { return x + y; }, sq_sum_vec)
+                         : 0;
+  for (; d < size; d++) {
+    acc_t grad_val = grad_ptr[d] + param_ptr[d] * l2;
+    exp_avg_ptr[d] = exp_avg_ptr[d] * beta1 + grad_val * (1 - beta1);
+    if (rowwise) {
+      sq_sum += grad_val * grad_val;
+    } else {
+      exp_avg_sq_ptr[d] =
+          exp_avg_sq_ptr[d] * beta2 + grad_val * grad_val * (1 - beta2);
+    }
+  }
+  if (rowwise) {
+    exp_avg_sq_ptr[0] = exp_avg_sq_ptr[0] * beta2 + sq_sum / size * (1 - beta2);
+  }
+
+  const acc_t lr = args.lr;
+  const acc_t eps = args.eps;
+  const acc_t decay = lamb ? args.weight_decay : 0;
+  const acc_t row_denom = rowwise
+      ? std::sqrt(exp_avg_sq_ptr[0]) / bias_correction2_sqrt + eps
+      : 0;
+  Vec bc1_vec = Vec(bias_correction1);
+  Vec bc2_sqrt_vec = Vec(bias_correction2_sqrt);
+  Vec param_sq_vec = Vec(0), update_sq_vec = Vec(0);
+  for (d = 0; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec denom_vec = rowwise
+        ? Vec(row_denom)
+        : Vec::loadu(exp_avg_sq_ptr + d).sqrt() / bc2_sqrt_vec + Vec(eps);
+    Vec update_vec = Vec::loadu(exp_avg_ptr + d) / bc1_vec / denom_vec;
+    Vec param_vec = Vec::loadu(param_ptr + d);
+    if (lamb) {
+      update_vec += param_vec * Vec(decay);
+      update_vec.store(update_ptr + d);
+      param_sq_vec += param_vec * param_vec;
+      update_sq_vec += update_vec * update_vec;
+    } else {
+      param_vec -= update_vec * Vec(lr);
+      param_vec.store(param_ptr + d);
+    }
+  }
+  acc_t param_sq = 0, update_sq = 0;
+  if (lamb) {
+    auto sum = [](Vec& x, Vec& y) { return x + y; };
+    param_sq = at::vec::vec_reduce_all<acc_t>(sum, param_sq_vec);
+    update_sq = at::vec::vec_reduce_all<acc_t>(sum, update_sq_vec);
+  }
+  for (; d < size; d++) {
+    acc_t denom = rowwise
+        ? row_denom
+        : std::sqrt(exp_avg_sq_ptr[d]) / bias_correction2_sqrt + eps;
+    acc_t update_val = exp_avg_ptr[d] / bias_correction1 / denom;
+    if (lamb) {
+      update_val += param_ptr[d] * decay;
+      update_ptr[d] = update_val;
+      param_sq += param_ptr[d] * param_ptr[d];
+      update_sq += update_val * update_val;
+    } else {
+      param_ptr[d] -= update_val * lr;
+    }
+  }
+  if (lamb) {
+    acc_t trust_ratio = param_sq > 0 && update_sq > 0
+        ? std::sqrt(param_sq) / std::sqrt(update_sq)
+        : 1;
+    Vec scale_vec = Vec(lr * trust_ratio);
+    for (d = 0; d < size - (size % Vec::size()); d += Vec::size()) {
+      Vec param_vec =
+          Vec::loadu(param_ptr + d) - Vec::loadu(update_ptr + d) * scale_vec;
+      param_vec.store(param_ptr + d);
+    }
+    for (; d < size; d++) {
+      param_ptr[d] -= update_ptr[d] * lr * trust_ratio;
+    }
+  }
+}
+
+// Updates the rows of the cache, with their moments, in a single pass: each
+// row is loaded in acc_t, updated and stored back in the dtype of its tensor.
+template <typename data_t, typename acc_t, typename optimizer_args_t>
+inline void adam_rows_update(
+    data_t* weight,
+    const EmbeddingRowCache<acc_t>& ewc,
+    const optimizer_args_t& args,
+    const int32_t table_id,
+    const int64_t emb_dim) {
+  constexpr bool rowwise =
+      std::is_same<optimizer_args_t, RowwiseAdamArgs>::value;
+  // Only bfloat16 weights have a trail, of which rows are formed
+  constexpr bool has_trail = std::is_same<data_t, BFloat16>::value;
+  BFloat16* bf16_trail_ptr =
+      has_trail ? args.bf16_trail[table_id].data_ptr<BFloat16>() : nullptr;
+  MomentRows exp_avg(args.exp_avg[table_id]);
+  MomentRows exp_avg_sq(args.exp_avg_sq[table_id]);
+  const int64_t sq_size = rowwise ? 1 : emb_dim;
+  const acc_t bias_correction1 = 1 - std::pow(args.beta1, args.step);
+  const acc_t bias_correction2_sqrt =
+      std::sqrt(1 - std::pow(args.beta2, args.step));
+  acc_t param_buf[emb_dim];
+  acc_t exp_avg_buf[emb_dim];
+  acc_t exp_avg_sq_buf[sq_size];
+  acc_t update_buf[emb_dim];
+  const auto& emb_cache = ewc.cache();
+  for (auto& it : emb_cache) {
+    size_t idx = it.first;
+    acc_t* grad = it.second;
+    BFloat16* trail_row = has_trail ? bf16_trail_ptr + idx * emb_dim : nullptr;
+    load_param(&weight[idx * emb_dim], trail_row, param_buf, emb_dim);
+    exp_avg.load(idx, emb_dim, exp_avg_buf);
+    exp_avg_sq.load(idx, sq_size, exp_avg_sq_buf);
+    adam_update<acc_t, optimizer_args_t>(
+        param_buf,
+        exp_avg_buf,
+        exp_avg_sq_buf,
+        update_buf,
+        grad,
+        args,
+        bias_correction1,
+        bias_correction2_sqrt,
+        emb_dim);
+    exp_avg.store(idx, emb_dim, exp_avg_buf);
+    exp_avg_sq.store(idx, sq_size, exp_avg_sq_buf);
+    store_param(&weight[idx * emb_dim], trail_row, param_buf, emb_dim);
+  }
+}
+
+template <typename data_t, typename acc_t>
+void inline EmbeddingGradUpdate<data_t, acc_t, AdamArgs>::update(
+    data_t* weight,
+    const EmbeddingRowCache<acc_t>& ewc,
+    const AdamArgs& args,
+    const int32_t table_id,
+    const int64_t emb_dim) {
+  adam_rows_update<data_t, acc_t, AdamArgs>(
+      weight, ewc, args, table_id, emb_dim);
+}
+
+template <typename data_t, typename acc_t>
+void inline EmbeddingGradUpdate<data_t, acc_t, RowwiseAdamArgs>::update(
+    data_t* weight,
+    const EmbeddingRowCache<acc_t>& ewc,
+    const RowwiseAdamArgs& args,
+    const int32_t table_id,
+    const int64_t emb_dim) {
+  adam_rows_update<data_t, acc_t, RowwiseAdamArgs>(
+      weight, ewc, args, table_id, emb_dim);
+}
+
+template <typename data_t, typename acc_t>
+void inline EmbeddingGradUpdate<data_t, acc_t, LambArgs>::update(
+    data_t* weight,
+    const EmbeddingRowCache<acc_t>& ewc,
+    const LambArgs& args,
+    const int32_t table_id,
+    const int64_t emb_dim) {
+  adam_rows_update<data_t, acc_t, LambArgs>(
+      weight, ewc, args, table_id, emb_dim);
+}
+
 template <typename data_t, typename index_t, typename optimizer_arg_t>
 void merged_embeddingbag_backward_update(
     data_t** w_ptr,
@@ -627,8 +1002,10 @@ void merged_embeddingbag_backward_update(
                                            // type will be double
 #pragma omp parallel
   {
+    // reused by the tables and the calls, see EmbeddingRowCache
+    thread_local EmbeddingRowCache<acc_t> ewc;
     for (int32_t n = 0; n < num_emb; ++n) {
-      EmbeddingRowCache<acc_t> ewc;
+      ewc.clear();
       embeddingbag_bwd_acc_kern<data_t, index_t, acc_t, /*use_cache=*/true>(
           /*bs_begin=*/0,
           num_batch,
@@ -801,6 +1178,251 @@ void merged_embeddingbag_backward_adagrad_cpu_kernel_impl(
       });
 }
 
+// The dtype of the moments of Adam and LAMB, see AdamArgs
+void check_adam_state(
+    const TensorList& weights,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    bool rowwise) {
+  TORCH_CHECK(
+      exp_avg.size() == weights.size() && exp_avg_sq.size() == weights.size(),
+      "merged_embeddingbag_backward: expect exp_avg and exp_avg_sq per table");
+  for (size_t i = 0; i < weights.size(); i++) {
+    auto acc_dtype = weights[i].scalar_type() == kBFloat16
+        ? kFloat
+        : weights[i].scalar_type();
+    auto num_rows = weights[i].size(0);
+    auto emb_dim = weights[i].size(1);
+    // 8 bits rows are followed by their float scale
+    auto moment_dim = [&](const Tensor& moment) {
+      auto dtype = moment.scalar_type();
+      return dtype == kChar || dtype == kByte ? emb_dim + 4 : emb_dim;
+    };
+    auto dtype = exp_avg[i].scalar_type();
+    TORCH_CHECK(
+        exp_avg[i].is_contiguous() &&
+            (dtype == acc_dtype || dtype == kBFloat16 || dtype == kChar) &&
+            exp_avg[i].dim() == 2 && exp_avg[i].size(0) == num_rows &&
+            exp_avg[i].size(1) == moment_dim(exp_avg[i]),
+        "merged_embeddingbag_backward: unexpected exp_avg of table ",
+        i);
+    dtype = exp_avg_sq[i].scalar_type();
+    if (rowwise) {
+      TORCH_CHECK(
+          exp_avg_sq[i].is_contiguous() &&
+              (dtype == acc_dtype || dtype == kBFloat16) &&
+              exp_avg_sq[i].dim() == 1 && exp_avg_sq[i].size(0) == num_rows,
+          "merged_embeddingbag_backward: unexpected exp_avg_sq of table ",
+          i);
+    } else {
+      TORCH_CHECK(
+          exp_avg_sq[i].is_contiguous() &&
+              (dtype == acc_dtype || dtype == kBFloat16 || dtype == kByte) &&
+              exp_avg_sq[i].dim() == 2 && exp_avg_sq[i].size(0) == num_rows &&
+              exp_avg_sq[i].size(1) == moment_dim(exp_avg_sq[i]),
+          "merged_embeddingbag_backward: unexpected exp_avg_sq of table ",
+          i);
+    }
+  }
+}
+
+template <typename optimizer_args_t>
+void merged_embeddingbag_backward_adam_update(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  int64_t num_emb = weights.size();
+
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(num_emb > 0);
+  int64_t batch_size = grad_outs_[0].size(0);
+  int64_t emb_dim = weights[0].size(1);
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(num_emb == indices.size());
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(num_emb == offsets.size());
+  check_adam_state(
+      weights,
+      exp_avg,
+      exp_avg_sq,
+      std::is_same<optimizer_args_t, RowwiseAdamArgs>::value);
+
+  auto index_type = indices[0].scalar_type();
+  auto data_type = weights[0].scalar_type();
+
+  std::vector<int64_t> last_offsets(num_emb, -1);
+  std::vector<Tensor> contiguous_grad;
+
+  for (int i = 0; i < num_emb; i++) {
+    contiguous_grad.emplace_back(grad_outs_[i].contiguous());
+    TORCH_INTERNAL_ASSERT_DEBUG_ONLY(
+        indices[i].is_contiguous() && indices[i].scalar_type() == index_type);
+    TORCH_INTERNAL_ASSERT_DEBUG_ONLY(
+        offsets[i].is_contiguous() && offsets[i].scalar_type() == index_type);
+    TORCH_INTERNAL_ASSERT_DEBUG_ONLY(
+        contiguous_grad[i].is_contiguous() &&
+        contiguous_grad[i].scalar_type() == data_type);
+    // handle last offsets
+    last_offsets[i] = indices[i].numel();
+  }
+
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::kBFloat16,
+      weights[0].scalar_type(),
+      "merged_embeddingbag_backward_update",
+      [&] {
+        AT_DISPATCH_INDEX_TYPES(
+            indices[0].scalar_type(),
+            "merged_embeddingbag_backward_update",
+            [&] {
+              scalar_t* grads_ptr[num_emb];
+              scalar_t* weights_ptr[num_emb];
+              index_t* indices_ptr[num_emb];
+              index_t* offsets_ptr[num_emb];
+              for (int i = 0; i < num_emb; i++) {
+                weights_ptr[i] = weights[i].data_ptr<scalar_t>();
+                grads_ptr[i] = contiguous_grad[i].data_ptr<scalar_t>();
+                indices_ptr[i] = indices[i].data_ptr<index_t>();
+                offsets_ptr[i] = offsets[i].data_ptr<index_t>();
+              }
+              optimizer_args_t args = optimizer_args_t(
+                  bf16_trail,
+                  exp_avg,
+                  exp_avg_sq,
+                  step,
+                  beta1,
+                  beta2,
+                  eps,
+                  lr,
+                  weight_decay);
+              merged_embeddingbag_backward_update<
+                  scalar_t,
+                  index_t,
+                  optimizer_args_t>(
+                  weights_ptr,
+                  grads_ptr,
+                  indices_ptr,
+                  offsets_ptr,
+                  batch_size,
+                  num_emb,
+                  emb_dim,
+                  last_offsets,
+                  pooling_mode,
+                  args);
+            });
+      });
+}
+
+void merged_embeddingbag_backward_adam_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  merged_embeddingbag_backward_adam_update<AdamArgs>(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void merged_embeddingbag_backward_rowwise_adam_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  merged_embeddingbag_backward_adam_update<RowwiseAdamArgs>(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void merged_embeddingbag_backward_lamb_cpu_kernel_impl(
+    const TensorList& grad_outs_,
+    const TensorList& weights,
+    const TensorList& indices,
+    const TensorList& offsets,
+    const int64_t pooling_mode,
+    const bool include_last_offsets,
+    const TensorList& exp_avg,
+    const TensorList& exp_avg_sq,
+    const TensorList& bf16_trail,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  merged_embeddingbag_backward_adam_update<LambArgs>(
+      grad_outs_,
+      weights,
+      indices,
+      offsets,
+      pooling_mode,
+      exp_avg,
+      exp_avg_sq,
+      bf16_trail,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
 template <typename acc_t, typename data_t, typename index_t>
 void prepare_emb_bwd_cache(
     std::vector<EmbeddingRowCache<acc_t>>& cache,
@@ -901,7 +1523,7 @@ mergedemb_distribute_backward_local_kernel_impl(
             "mergedemb_distribute_backward_local",
             [&] {
               using acc_t = acc_type<scalar_t, true>;
-              std::vector<EmbeddingRowCache<acc_t>> cache(world_size * num_thd);
+              auto& cache = reuse_row_caches<acc_t>(world_size * num_thd);
               scalar_t* grad_ptr = grad.data_ptr<scalar_t>();
               index_t* indices_ptr[num_emb];
               index_t* offsets_ptr[num_emb];
@@ -975,18 +1597,18 @@ void mergedemb_distribute_backward_merge(
   }
 }
 
-template <typename acc_t, typename data_t>
-void mergedemb_distribute_adagrad_update(
+template <typename acc_t, typename data_t, typename optimizer_args_t>
+void mergedemb_distribute_update(
     std::vector<EmbeddingRowCache<acc_t>>& thdcache,
     data_t* weight_ptr,
     int64_t emb_dim,
-    AdaGradArgs args) {
+    const optimizer_args_t& args) {
   RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
 #pragma omp parallel shared(thdcache)
   {
     const int64_t thdidx = omp_get_thread_num();
     EmbeddingRowCache<acc_t>& cache = thdcache[thdidx];
-    EmbeddingGradUpdate<data_t, acc_t, AdaGradArgs>::update(
+    EmbeddingGradUpdate<data_t, acc_t, optimizer_args_t>::update(
         weight_ptr, cache, args, /*table_id=*/0, emb_dim);
   }
 }
@@ -1013,7 +1635,7 @@ void mergedemb_distribute_backward_merge_adagrad_update_kernel_impl(
         AT_DISPATCH_INDEX_TYPES(
             idx[0].scalar_type(), "mergedemb_distribute_backward_merge", [&] {
               using acc_t = acc_type<scalar_t, true>;
-              std::vector<EmbeddingRowCache<acc_t>> cache(num_thd);
+              auto& cache = reuse_row_caches<acc_t>(num_thd);
               index_t* idx_ptr[world_size];
               scalar_t* val_ptr[world_size];
               int64_t* ofs_ptr[world_size];
@@ -1028,7 +1650,7 @@ void mergedemb_distribute_backward_merge_adagrad_update_kernel_impl(
               AdaGradArgs args =
                   AdaGradArgs({weight_trail}, {hessian}, eps, lr);
               scalar_t* weight_ptr = weight.data_ptr<scalar_t>();
-              mergedemb_distribute_adagrad_update<acc_t, scalar_t>(
+              mergedemb_distribute_update<acc_t, scalar_t, AdaGradArgs>(
                   cache, weight_ptr, emb_dim, args);
             });
       });
@@ -1036,6 +1658,163 @@ void mergedemb_distribute_backward_merge_adagrad_update_kernel_impl(
   return;
 }
 
+template <typename optimizer_args_t>
+void mergedemb_distribute_backward_merge_adam_update(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  int64_t world_size = idx.size();
+  int64_t emb_dim = weight.size(1);
+  const int64_t num_thd = omp_get_max_threads();
+  // the lists of the args outlive them
+  std::vector<Tensor> trails = {weight_trail};
+  std::vector<Tensor> exp_avgs = {exp_avg};
+  std::vector<Tensor> exp_avg_sqs = {exp_avg_sq};
+  check_adam_state(
+      {weight},
+      exp_avgs,
+      exp_avg_sqs,
+      std::is_same<optimizer_args_t, RowwiseAdamArgs>::value);
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::kBFloat16,
+      weight.scalar_type(),
+      "mergedemb_distribute_backward_merge",
+      [&] {
+        AT_DISPATCH_INDEX_TYPES(
+            idx[0].scalar_type(), "mergedemb_distribute_backward_merge", [&] {
+              using acc_t = acc_type<scalar_t, true>;
+              auto& cache = reuse_row_caches<acc_t>(num_thd);
+              index_t* idx_ptr[world_size];
+              scalar_t* val_ptr[world_size];
+              int64_t* ofs_ptr[world_size];
+              for (int i = 0; i < world_size; i++) {
+                idx_ptr[i] = idx[i].data_ptr<index_t>();
+                val_ptr[i] = val[i].data_ptr<scalar_t>();
+                ofs_ptr[i] = ofs[i].data_ptr<int64_t>();
+              }
+              // read from weight and accumuate in emb cache
+              mergedemb_distribute_backward_merge<acc_t, scalar_t, index_t>(
+                  cache, world_size, emb_dim, idx_ptr, val_ptr, ofs_ptr);
+              optimizer_args_t args = optimizer_args_t(
+                  trails,
+                  exp_avgs,
+                  exp_avg_sqs,
+                  step,
+                  beta1,
+                  beta2,
+                  eps,
+                  lr,
+                  weight_decay);
+              scalar_t* weight_ptr = weight.data_ptr<scalar_t>();
+              mergedemb_distribute_update<acc_t, scalar_t, optimizer_args_t>(
+                  cache, weight_ptr, emb_dim, args);
+            });
+      });
+}
+
+void mergedemb_distribute_backward_merge_adam_update_kernel_impl(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  mergedemb_distribute_backward_merge_adam_update<AdamArgs>(
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void mergedemb_distribute_backward_merge_rowwise_adam_update_kernel_impl(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  mergedemb_distribute_backward_merge_adam_update<RowwiseAdamArgs>(
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
+void mergedemb_distribute_backward_merge_lamb_update_kernel_impl(
+    const TensorList& idx,
+    const TensorList& val,
+    const TensorList& ofs,
+    Tensor& weight,
+    Tensor& weight_trail,
+    Tensor& exp_avg,
+    Tensor& exp_avg_sq,
+    const int64_t step,
+    const double beta1,
+    const double beta2,
+    const double eps,
+    const double lr,
+    const double weight_decay) {
+  RECORD_FUNCTION(__FUNCTION__, c10::ArrayRef<c10::IValue>({}));
+  mergedemb_distribute_backward_merge_adam_update<LambArgs>(
+      idx,
+      val,
+      ofs,
+      weight,
+      weight_trail,
+      exp_avg,
+      exp_avg_sq,
+      step,
+      beta1,
+      beta2,
+      eps,
+      lr,
+      weight_decay);
+}
+
 } // anonymous namespace
 
 IPEX_REGISTER_DISPATCH(
@@ -1050,6 +1829,18 @@ IPEX_REGISTER_DISPATCH(
     merged_embeddingbag_backward_adagrad_cpu_kernel_stub,
     &merged_embeddingbag_backward_adagrad_cpu_kernel_impl);
 
+IPEX_REGISTER_DISPATCH(
+    merged_embeddingbag_backward_adam_cpu_kernel_stub,
+    &merged_embeddingbag_backward_adam_cpu_kernel_impl);
+
+IPEX_REGISTER_DISPATCH(
+    merged_embeddingbag_backward_rowwise_adam_cpu_kernel_stub,
+    &merged_embeddingbag_backward_rowwise_adam_cpu_kernel_impl);
+
+IPEX_REGISTER_DISPATCH(
+    merged_embeddingbag_backward_lamb_cpu_kernel_stub,
+    &merged_embeddingbag_backward_lamb_cpu_kernel_impl);
+
 IPEX_REGISTER_DISPATCH(
     mergedemb_distribute_backward_local_kernel_stub,
     &mergedemb_distribute_backward_local_kernel_impl);
@@ -1058,5 +1849,17 @@ IPEX_REGISTER_DISPATCH(
     mergedemb_distribute_backward_merge_adagrad_update_stub,
     &mergedemb_distribute_backward_merge_adagrad_update_kernel_impl);
 
+IPEX_REGISTER_DISPATCH(
+    mergedemb_distribute_backward_merge_adam_update_stub,
+    &mergedemb_distribute_backward_merge_adam_update_kernel_impl);
+
+IPEX_REGISTER_DISPATCH(
+    mergedemb_distribute_backward_merge_rowwise_adam_update_stub,
+    &mergedemb_distribute_backward_merge_rowwise_adam_update_kernel_impl);
+
+IPEX_REGISTER_DISPATCH(
+    mergedemb_distribute_backward_merge_lamb_update_stub,
+    &mergedemb_distribute_backward_merge_lamb_update_kernel_impl);
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -709,7 +709,7 @@ void accumulate_on_chunks(
       for (int64_t nc = 0; nc < num_chk; ++nc) {
         const EmbeddingRowCache<acc_t>& src_map =
             cache_with_chunk[dest * num_emb * num_chk + nc * num_emb + n];
-        auto emb_cache = src_map.cache();
+        const auto& emb_cache = src_map.cache();
         for (const auto& [k, v] : emb_cache) {
           auto find = dst_map.find(k);
           if (find == nullptr) {
@@ -835,7 +835,9 @@ void mergedemb_distribute_forward_merge(
     data_t* res_ptr) {
 #pragma omp parallel for
   for (int64_t i = 0; i < num_emb; ++i) {
-    EmbeddingRowCache<acc_t> cache;
+    // reused by the tables and the calls, see EmbeddingRowCache
+    thread_local EmbeddingRowCache<acc_t> cache;
+    cache.clear();
     for (int64_t j = 0; j < world_size; ++j) {
       const int64_t ts = ofs_ptr[j][i];
       const int64_t te = ofs_ptr[j][i + 1];
@@ -849,7 +851,7 @@ void mergedemb_distribute_forward_merge(
         add_ker<acc_t, data_t>(find, accPtr, emb_dim);
       }
     }
-    auto emb_cache = cache.cache();
+    const auto& emb_cache = cache.cache();
     for (auto& [key, value] : emb_cache) {
       data_t* dest = &res_ptr[key * emb_dim]; // EMBRES
       move_ker<data_t, acc_t>(dest, value, emb_dim);
@@ -1,4 +1,9 @@
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+#include <ATen/native/cpu/utils.h>
 #include <aten/MultiHeadAttention.h>
+#include <limits>
 #include "csrc/cpu/tpp/woq/tla.h"
 #include "mkl.h"
 #include "vec/vec.h"
@@ -478,6 +483,227 @@ at::Tensor sd_mha_base_kernel(
 }
 #endif
 
+inline void _mha_gemm(
+    bool trans_b,
+    int64_t M,
+    int64_t N,
+    int64_t K,
+    const float* a,
+    int64_t lda,
+    const float* b,
+    int64_t ldb,
+    float beta,
+    float* c,
+    int64_t ldc) {
+  cblas_sgemm(
+      CblasRowMajor,
+      CblasNoTrans,
+      trans_b ? CblasTrans : CblasNoTrans,
+      M,
+      N,
+      K,
+      1.f,
+      a,
+      lda,
+      b,
+      ldb,
+      beta,
+      c,
+      ldc);
+}
+
+inline void _mha_gemm(
+    bool trans_b,
+    int64_t M,
+    int64_t N,
+    int64_t K,
+    const at::BFloat16* a,
+    int64_t lda,
+    const at::BFloat16* b,
+    int64_t ldb,
+    float beta,
+    float* c,
+    int64_t ldc) {
+  cblas_gemm_bf16bf16f32(
+      CblasRowMajor,
+      CblasNoTrans,
+      trans_b ? CblasTrans : CblasNoTrans,
+      M,
+      N,
+      K,
+      1.f,
+      (const MKL_BF16*)a,
+      lda,
+      (const MKL_BF16*)b,
+      ldb,
+      beta,
+      c,
+      ldc);
+}
+
+// Blocked online-softmax (Flash Attention) kernel of the Stable-Diffusion MHA
+// for FP32 and BF16 on all the ISAs. Q, K and V are read in place from the
+// un-transposed [batch, seq, num_head * headSize] projection outputs, of row
+// strides qStride/kStride/vStride, and only one [qSplitSize, kvSplitSize]
+// block of scores is kept per thread, so that the memory stays linear in the
+// sequence length (16k-65k tokens at 1024x1024 and above).
+template <typename scalar_t>
+at::Tensor sd_mha_flash_kernel(
+    const scalar_t* query,
+    const scalar_t* key,
+    const scalar_t* value,
+    const int64_t& qStride,
+    const int64_t& kStride,
+    const int64_t& vStride,
+    const int64_t& batchSize,
+    const int64_t& qSize,
+    const int64_t& kvSize,
+    const int64_t& num_head,
+    const int64_t& headSize,
+    const int64_t& hiddenSize,
+    const double& scale) {
+  using Vec = at::vec::Vectorized<float>;
+  constexpr bool is_reduced = !std::is_same<scalar_t, float>::value;
+  const auto dtype = c10::CppTypeToScalarType<scalar_t>::value;
+  at::Tensor output = at::empty({batchSize, qSize, hiddenSize}, dtype);
+
+  int64_t qSplitSize = qSize >= qsplit_size ? qsplit_size : qSize;
+  int64_t kvSplitSize = kvSize >= kvsplit_size ? kvsplit_size : kvSize;
+  int64_t qSlice = (qSize - 1) / qSplitSize + 1;
+  int64_t num_thread = at::get_num_threads();
+
+  at::Tensor qk_fp32 =
+      at::empty({num_thread, qSplitSize, kvSplitSize}, at::kFloat);
+  // The probabilities in BF16 for the BF16 GEMM with Value
+  at::Tensor qk_reduced = at::empty(
+      {is_reduced ? num_thread : 0, qSplitSize, kvSplitSize}, dtype);
+  at::Tensor qk_max = at::empty({num_thread, qSplitSize}, at::kFloat);
+  at::Tensor qk_sum = at::empty({num_thread, qSplitSize}, at::kFloat);
+  at::Tensor dst_fp32 =
+      at::empty({num_thread, qSplitSize, headSize}, at::kFloat);
+
+  auto output_ptr = output.data_ptr<scalar_t>();
+  auto qk_fp32_ptr = qk_fp32.data_ptr<float>();
+  auto qk_reduced_ptr = qk_reduced.data_ptr<scalar_t>();
+  auto qk_max_ptr = qk_max.data_ptr<float>();
+  auto qk_sum_ptr = qk_sum.data_ptr<float>();
+  auto dst_fp32_ptr = dst_fp32.data_ptr<float>();
+  const float scale_f = scale;
+
+  at::parallel_for(
+      0, batchSize * num_head * qSlice, 1, [&](int64_t begin, int64_t end) {
+        int64_t i{0}, j{0}, k{0};
+        at::native::data_index_init(
+            begin, i, batchSize, j, num_head, k, qSlice);
+        int ompIdx = at::get_thread_num();
+        float* qk = qk_fp32_ptr + ompIdx * qSplitSize * kvSplitSize;
+        scalar_t* qk_reduced_data = is_reduced
+            ? qk_reduced_ptr + ompIdx * qSplitSize * kvSplitSize
+            : nullptr;
+        float* qk_max_data = qk_max_ptr + ompIdx * qSplitSize;
+        float* qk_sum_data = qk_sum_ptr + ompIdx * qSplitSize;
+        float* dst = dst_fp32_ptr + ompIdx * qSplitSize * headSize;
+        for (const auto z : c10::irange(begin, end)) {
+          (void)z; // Suppress unused variable
+          int64_t m = k * qSplitSize;
+          int64_t qBlockSize = std::min(qSplitSize, qSize - m);
+          std::fill_n(
+              qk_max_data, qBlockSize, -std::numeric_limits<float>::infinity());
+          std::fill_n(qk_sum_data, qBlockSize, 0.f);
+          for (int64_t n = 0; n < kvSize; n += kvSplitSize) {
+            int64_t kvBlockSize = std::min(kvSplitSize, kvSize - n);
+            // [qBlockSize,headSize] x [headSize,kvBlockSize] ->
+            // [qBlockSize,kvBlockSize]
+            _mha_gemm(
+                true,
+                qBlockSize,
+                kvBlockSize,
+                headSize,
+                query + i * qSize * qStride + m * qStride + j * headSize,
+                qStride,
+                key + i * kvSize * kStride + n * kStride + j * headSize,
+                kStride,
+                0.f,
+                qk,
+                kvBlockSize);
+            // Online softmax: rescale the previous blocks to the new max
+            for (const auto row : c10::irange(qBlockSize)) {
+              float* qk_row = qk + row * kvBlockSize;
+              at::vec::map<float>(
+                  [scale_f](Vec x) { return x * Vec(scale_f); },
+                  qk_row,
+                  qk_row,
+                  kvBlockSize);
+              float tmp_max = at::vec::reduce_all<float>(
+                  [](Vec& x, Vec& y) { return at::vec::maximum(x, y); },
+                  qk_row,
+                  kvBlockSize);
+              tmp_max = std::max(tmp_max, qk_max_data[row]);
+              at::vec::map<float>(
+                  [tmp_max](Vec x) { return (x - Vec(tmp_max)).exp(); },
+                  qk_row,
+                  qk_row,
+                  kvBlockSize);
+              float tmp_sum = at::vec::reduce_all<float>(
+                  [](Vec& x, Vec& y) { return x + y; }, qk_row, kvBlockSize);
+              float exp_tmp = std::exp(qk_max_data[row] - tmp_max);
+              qk_sum_data[row] = qk_sum_data[row] * exp_tmp + tmp_sum;
+              qk_max_data[row] = tmp_max;
+              if (n > 0) {
+                float* dst_row = dst + row * headSize;
+                at::vec::map<float>(
+                    [exp_tmp](Vec x) { return x * Vec(exp_tmp); },
+                    dst_row,
+                    dst_row,
+                    headSize);
+              }
+              if constexpr (is_reduced) {
+                at::vec::convert<float, scalar_t>(
+                    qk_row, qk_reduced_data + row * kvBlockSize, kvBlockSize);
+              }
+            }
+            // [qBlockSize,kvBlockSize] x [kvBlockSize,headSize] ->
+            // [qBlockSize,headSize]
+            const scalar_t* probs;
+            if constexpr (is_reduced) {
+              probs = qk_reduced_data;
+            } else {
+              probs = qk;
+            }
+            _mha_gemm(
+                false,
+                qBlockSize,
+                headSize,
+                kvBlockSize,
+                probs,
+                kvBlockSize,
+                value + i * kvSize * vStride + n * vStride + j * headSize,
+                vStride,
+                n == 0 ? 0.f : 1.f,
+                dst,
+                headSize);
+          }
+          // Normalize and write to [batch, seq, num_head * headSize]
+          for (const auto row : c10::irange(qBlockSize)) {
+            float* dst_row = dst + row * headSize;
+            float sum_reciprocal = 1.f / qk_sum_data[row];
+            at::vec::map<float>(
+                [sum_reciprocal](Vec x) { return x * Vec(sum_reciprocal); },
+                dst_row,
+                dst_row,
+                headSize);
+            at::vec::convert<float, scalar_t>(
+                dst_row,
+                output_ptr + i * qSize * hiddenSize + (m + row) * hiddenSize +
+                    j * headSize,
+                headSize);
+          }
+          at::native::data_index_step(i, batchSize, j, num_head, k, qSlice);
+        }
+      });
+  return output;
+}
+
 at::Tensor bert_mha_kernel_impl(
     const at::Tensor& qkv,
     const at::Tensor& rel_kv,
@@ -614,13 +840,15 @@ at::Tensor bert_mha_kernel_impl(
 }
 
 at::Tensor sd_mha_kernel_v1_impl(
-    const at::Tensor& qkv,
+    const at::Tensor& _qkv,
     const int64_t& num_head,
     const int64_t& headSize,
     const double& scale) {
+  auto qkv = _qkv.contiguous();
   TORCH_CHECK(
-      qkv.dtype() == at::kBFloat16,
-      "Currently the Stable-Diffusion MHA fusion only supports BF16 data type.");
+      qkv.dtype() == at::kBFloat16 || qkv.dtype() == at::kFloat,
+      "Currently the Stable-Diffusion MHA fusion only supports BF16 and FP32 "
+      "data types.");
 
   int64_t qkvOffset = num_head * headSize;
   int64_t qkvStride = qkv.size(-1);
@@ -628,7 +856,40 @@ at::Tensor sd_mha_kernel_v1_impl(
   int64_t sequenceSize = qkv.size(1);
   int64_t hiddenSize = num_head * headSize;
 #if defined(CPU_CAPABILITY_AVX512)
-  return sd_mha_base_kernel(
+  if (qkv.dtype() == at::kBFloat16) {
+    return sd_mha_base_kernel(
+        qkv.data_ptr<at::BFloat16>(),
+        qkv.data_ptr<at::BFloat16>() + qkvOffset,
+        qkv.data_ptr<at::BFloat16>() + qkvOffset * 2,
+        qkvStride,
+        qkvStride,
+        qkvStride,
+        batchSize,
+        sequenceSize,
+        sequenceSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
+#endif
+  if (qkv.dtype() == at::kFloat) {
+    return sd_mha_flash_kernel<float>(
+        qkv.data_ptr<float>(),
+        qkv.data_ptr<float>() + qkvOffset,
+        qkv.data_ptr<float>() + qkvOffset * 2,
+        qkvStride,
+        qkvStride,
+        qkvStride,
+        batchSize,
+        sequenceSize,
+        sequenceSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
+  return sd_mha_flash_kernel<at::BFloat16>(
       qkv.data_ptr<at::BFloat16>(),
       qkv.data_ptr<at::BFloat16>() + qkvOffset,
       qkv.data_ptr<at::BFloat16>() + qkvOffset * 2,
@@ -642,25 +903,6 @@ at::Tensor sd_mha_kernel_v1_impl(
       headSize,
       hiddenSize,
       scale);
-#endif
-  auto qkv_mat = dil_mat_split<at::BFloat16>(
-      qkv, at::IntArrayRef({hiddenSize, hiddenSize, hiddenSize}));
-  auto query = qkv_mat[0];
-  auto key = qkv_mat[1];
-  auto value = qkv_mat[2];
-  query.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-  key.resize_({batchSize, sequenceSize, num_head, headSize})
-      .transpose_(1, 2)
-      .transpose_(2, 3);
-  value.resize_({batchSize, sequenceSize, num_head, headSize}).transpose_(1, 2);
-
-  auto qk = at::matmul(query, key);
-  qk = at::softmax(at::mul(qk, scale), -1);
-  auto output = at::matmul(qk, value);
-
-  output = output.transpose_(1, 2).contiguous().resize_(
-      {batchSize, sequenceSize, hiddenSize});
-  return output;
 }
 
 at::Tensor sd_mha_kernel_v2_impl(
@@ -674,9 +916,10 @@ at::Tensor sd_mha_kernel_v2_impl(
   auto key = _key.contiguous();
   auto value = _value.contiguous();
   TORCH_CHECK(
-      (query.dtype() == at::kBFloat16 && key.dtype() == at::kBFloat16 &&
-       value.dtype() == at::kBFloat16),
-      "Currently the Stable-Diffusion MHA fusion only supports BF16 data type.");
+      (query.dtype() == at::kBFloat16 || query.dtype() == at::kFloat) &&
+          key.dtype() == query.dtype() && value.dtype() == query.dtype(),
+      "Currently the Stable-Diffusion MHA fusion only supports BF16 and FP32 "
+      "data types.");
 
   int64_t batchSize = query.size(0);
   int64_t qStride = query.size(-1);
@@ -686,7 +929,40 @@ at::Tensor sd_mha_kernel_v2_impl(
   int64_t kvSize = value.size(1);
   int64_t hiddenSize = num_head * headSize;
 #if defined(CPU_CAPABILITY_AVX512)
-  return sd_mha_base_kernel(
+  if (query.dtype() == at::kBFloat16) {
+    return sd_mha_base_kernel(
+        query.data_ptr<at::BFloat16>(),
+        key.data_ptr<at::BFloat16>(),
+        value.data_ptr<at::BFloat16>(),
+        qStride,
+        kStride,
+        vStride,
+        batchSize,
+        qSize,
+        kvSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
+#endif
+  if (query.dtype() == at::kFloat) {
+    return sd_mha_flash_kernel<float>(
+        query.data_ptr<float>(),
+        key.data_ptr<float>(),
+        value.data_ptr<float>(),
+        qStride,
+        kStride,
+        vStride,
+        batchSize,
+        qSize,
+        kvSize,
+        num_head,
+        headSize,
+        hiddenSize,
+        scale);
+  }
+  return sd_mha_flash_kernel<at::BFloat16>(
       query.data_ptr<at::BFloat16>(),
       key.data_ptr<at::BFloat16>(),
       value.data_ptr<at::BFloat16>(),
@@ -700,20 +976,6 @@ at::Tensor sd_mha_kernel_v2_impl(
       headSize,
       hiddenSize,
       scale);
-#endif
-  query.resize_({batchSize, qSize, num_head, headSize}).transpose_(1, 2);
-  key.resize_({batchSize, kvSize, num_head, headSize})
-      .transpose_(1, 2)
-      .transpose_(2, 3);
-  value.resize_({batchSize, kvSize, num_head, headSize}).transpose_(1, 2);
-
-  auto qk = at::matmul(query, key);
-  qk = at::softmax(at::mul(qk, scale), -1);
-  auto output = at::matmul(qk, value);
-
-  output = output.transpose_(1, 2).contiguous().resize_(
-      {batchSize, qSize, hiddenSize});
-  return output;
 }
 
 } // anonymous namespace
@@ -0,0 +1,222 @@
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+#include <aten/MultiLora.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "mkl.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// Tokens of one adapter computed by one task, i.e. the rows of its GEMMs
+constexpr int64_t kLoraTokenBlock = 32;
+// Output features updated by one task of the expand GEMM
+constexpr int64_t kLoraColBlock = 512;
+
+// Tokens [begin, end) of the tokens sorted by adapter, all using adapter
+struct LoraSegment {
+  int64_t adapter;
+  int64_t begin;
+  int64_t end;
+};
+
+// Sort the tokens by adapter and split them into segments of at most
+// kLoraTokenBlock tokens. Tokens without adapter are left out.
+std::vector<LoraSegment> sort_tokens_by_adapter(
+    const int64_t* indices,
+    int64_t num_tokens,
+    int64_t num_adapters,
+    std::vector<int64_t>& order) {
+  std::vector<int64_t> offsets(num_adapters + 1, 0);
+  for (int64_t t = 0; t < num_tokens; t++) {
+    auto a = indices[t];
+    TORCH_CHECK(
+        a < num_adapters,
+        "multi_lora_add_: adapter index ",
+        a,
+        " out of range of ",
+        num_adapters,
+        " adapters");
+    if (a >= 0) {
+      offsets[a + 1]++;
+    }
+  }
+  for (int64_t a = 0; a < num_adapters; a++) {
+    offsets[a + 1] += offsets[a];
+  }
+  order.resize(offsets[num_adapters]);
+  std::vector<int64_t> pos(offsets.begin(), offsets.end() - 1);
+  for (int64_t t = 0; t < num_tokens; t++) {
+    if (indices[t] >= 0) {
+      order[pos[indices[t]]++] = t;
+    }
+  }
+  std::vector<LoraSegment> segments;
+  for (int64_t a = 0; a < num_adapters; a++) {
+    for (int64_t b = offsets[a]; b < offsets[a + 1]; b += kLoraTokenBlock) {
+      segments.push_back({a, b, std::min(b + kLoraTokenBlock, offsets[a + 1])});
+    }
+  }
+  return segments;
+}
+
+// The rows x cols matrix at src of leading dimension ld in fp32, converted
+// into buf unless scalar_t is float. Sets ld to that of the returned matrix.
+template <typename scalar_t>
+const float* as_float(
+    const scalar_t* src,
+    int64_t rows,
+    int64_t cols,
+    int64_t& ld,
+    std::vector<float>& buf) {
+  if constexpr (std::is_same_v<scalar_t, float>) {
+    return src;
+  } else {
+    for (int64_t i = 0; i < rows; i++) {
+      at::vec::convert(src + i * ld, buf.data() + i * cols, cols);
+    }
+    ld = cols;
+    return buf.data();
+  }
+}
+
+template <typename scalar_t>
+void multi_lora_add_kernel(
+    at::Tensor& output,
+    const at::Tensor& input,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings) {
+  using Vec = at::vec::Vectorized<float>;
+  auto T = input.size(0);
+  auto K = input.size(1);
+  auto N = output.size(1);
+  auto num_adapters = lora_a.size(0);
+  auto R = lora_a.size(1);
+
+  std::vector<int64_t> order;
+  auto segments = sort_tokens_by_adapter(
+      indices.data_ptr<int64_t>(), T, num_adapters, order);
+  if (segments.empty() || R == 0) {
+    return;
+  }
+  auto out_ptr = output.data_ptr<scalar_t>();
+  auto in_ptr = input.data_ptr<scalar_t>();
+  auto a_ptr = lora_a.data_ptr<scalar_t>();
+  auto b_ptr = lora_b.data_ptr<scalar_t>();
+  auto scale_ptr = scalings.data_ptr<float>();
+  int64_t num_segments = segments.size();
+
+  // Shrink: shrunk[s] = scaling * input[order[s]] @ lora_a[a].T, in fp32,
+  // as one GEMM per segment. The segments of a task are consecutive, so that
+  // the adapter weights are converted once for all of its segments.
+  std::vector<float> shrunk(order.size() * R);
+  at::parallel_for(0, num_segments, 1, [&](int64_t begin, int64_t end) {
+    std::vector<float> x_buf(kLoraTokenBlock * K);
+    std::vector<float> a_buf(R * K);
+    const float* a = nullptr;
+    int64_t lda = K;
+    for (int64_t i = begin; i < end; i++) {
+      auto& seg = segments[i];
+      auto m = seg.end - seg.begin;
+      for (int64_t j = 0; j < m; j++) {
+        at::vec::convert(
+            in_ptr + order[seg.begin + j] * K, x_buf.data() + j * K, K);
+      }
+      if (i == begin || seg.adapter != segments[i - 1].adapter) {
+        lda = K;
+        a = as_float(a_ptr + seg.adapter * R * K, R, K, lda, a_buf);
+      }
+      cblas_sgemm(
+          CblasRowMajor,
+          CblasNoTrans,
+          CblasTrans,
+          m,
+          R,
+          K,
+          scale_ptr[seg.adapter],
+          x_buf.data(),
+          K,
+          a,
+          lda,
+          0.f,
+          shrunk.data() + seg.begin * R,
+          R);
+    }
+  });
+
+  // Expand: output[order[s]] += shrunk[s] @ lora_b[a], as one GEMM per
+  // segment and column block. Each token is in one segment, so that the tasks
+  // write disjoint parts of the output.
+  auto num_col_blocks = (N + kLoraColBlock - 1) / kLoraColBlock;
+  at::parallel_for(
+      0, num_segments * num_col_blocks, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> acc(kLoraTokenBlock * kLoraColBlock);
+        std::vector<float> b_buf(R * kLoraColBlock);
+        std::vector<float> out_buf(kLoraColBlock);
+        for (int64_t i = begin; i < end; i++) {
+          auto& seg = segments[i / num_col_blocks];
+          auto n0 = (i % num_col_blocks) * kLoraColBlock;
+          auto cols = std::min(kLoraColBlock, N - n0);
+          auto m = seg.end - seg.begin;
+          int64_t ldb = N;
+          auto b = as_float(
+              b_ptr + seg.adapter * R * N + n0, R, cols, ldb, b_buf);
+          cblas_sgemm(
+              CblasRowMajor,
+              CblasNoTrans,
+              CblasNoTrans,
+              m,
+              cols,
+              R,
+              1.f,
+              shrunk.data() + seg.begin * R,
+              R,
+              b,
+              ldb,
+              0.f,
+              acc.data(),
+              kLoraColBlock);
+          for (int64_t j = 0; j < m; j++) {
+            auto out_j = out_ptr + order[seg.begin + j] * N + n0;
+            at::vec::convert(out_j, out_buf.data(), cols);
+            at::vec::map2<float>(
+                [](Vec x, Vec y) { return x + y; },
+                out_buf.data(),
+                out_buf.data(),
+                acc.data() + j * kLoraColBlock,
+                cols);
+            at::vec::convert(out_buf.data(), out_j, cols);
+          }
+        }
+      });
+}
+
+void multi_lora_add_kernel_impl(
+    at::Tensor& output,
+    const at::Tensor& input,
+    const at::Tensor& lora_a,
+    const at::Tensor& lora_b,
+    const at::Tensor& indices,
+    const at::Tensor& scalings) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, output.scalar_type(), "multi_lora_add_", [&] {
+        multi_lora_add_kernel<scalar_t>(
+            output, input, lora_a, lora_b, indices, scalings);
+      });
+}
+
+} // anonymous namespace
+
+IPEX_REGISTER_DISPATCH(multi_lora_add_kernel_stub, &multi_lora_add_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,8 +1,19 @@
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
 #include <ATen/Tensor.h>
 #include <aten/PagedAttention.h>
 #include <torch/all.h>
 #include <torch/csrc/autograd/function.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits>
+#include <vector>
+#include "utils/kernel_profiler.h"
+#include "utils/parallel_partition.h"
+#include "utils/sha256.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -128,89 +139,117 @@ void single_query_cached_kv_attention_kernel(
         "alibi_slopes size is not equal to num_heads");
   }
 
-#pragma omp parallel for collapse(3)
-  for (auto seq_id = 0; seq_id < num_seqs; seq_id++) {
-    for (auto head_id = 0; head_id < num_heads; head_id++) {
-      for (auto token_id = 0; token_id < max_context_len; token_id++) {
-        auto context_len = context_lens_ptr[seq_id];
-        if (token_id >= context_len)
-          continue;
-        auto attn_w_pos = attn_weights_ptr + seq_id * attn_weights_stride +
-            head_id * max_context_len + token_id;
-        auto q_ptr_start = query_ptr + seq_id * q_stride + head_id * head_size;
-        auto block_id = block_tables_ptr
-            [seq_id * max_num_blocks_per_seq + token_id / block_size];
-        auto block_offset = token_id % block_size;
-        auto k_cache_start = key_cache_ptr + block_id * kv_block_stride +
-            block_offset * num_kv_heads * head_size +
-            head_mapping_ptr[head_id] * head_size;
-        reduce_head<scalar_t, scalar_t>(
-            q_ptr_start, k_cache_start, attn_w_pos, head_size);
+  // The heads of a seq have as much work as its context length. Split the
+  // tokens of the contexts of all the (seq, head) pairs evenly, rather than
+  // the seqs, heads and tokens up to max_context_len uniformly, so that the
+  // threads finish together when the context lengths differ. A thread may
+  // get the end of the context of a head and the start of another one.
+  auto num_threads = omp_get_max_threads();
+  std::vector<int64_t> token_prefix(num_seqs * num_heads + 1, 0);
+  for (auto i = 0; i < num_seqs * num_heads; i++) {
+    token_prefix[i + 1] = token_prefix[i] + context_lens_ptr[i / num_heads];
+  }
+  auto profile_scope = utils::KernelProfileScope::current();
+  {
+    utils::KernelProfileRegion profile_region("qk");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      auto qk = [&](int64_t i, int64_t token_begin, int64_t token_end) {
+        auto seq_id = i / num_heads;
+        auto head_id = i % num_heads;
+        for (auto token_id = token_begin; token_id < token_end; token_id++) {
+          auto attn_w_pos = attn_weights_ptr + seq_id * attn_weights_stride +
+              head_id * max_context_len + token_id;
+          auto q_ptr_start =
+              query_ptr + seq_id * q_stride + head_id * head_size;
+          auto block_id = block_tables_ptr
+              [seq_id * max_num_blocks_per_seq + token_id / block_size];
+          auto block_offset = token_id % block_size;
+          auto k_cache_start = key_cache_ptr + block_id * kv_block_stride +
+              block_offset * num_kv_heads * head_size +
+              head_mapping_ptr[head_id] * head_size;
+          reduce_head<scalar_t, scalar_t>(
+              q_ptr_start, k_cache_start, attn_w_pos, head_size);
+        }
+      };
+      for (auto part = omp_get_thread_num(); part < num_threads;
+           part += omp_get_num_threads()) {
+        utils::for_each_balanced_range(token_prefix, part, num_threads, qk);
       }
     }
   }
 
-// div+add+softmax
-#pragma omp parallel for collapse(2)
-  for (auto seq_id = 0; seq_id < num_seqs; seq_id++) {
-    for (auto head_id = 0; head_id < num_heads; head_id++) {
-      auto max_val = -10000.0f;
-      float sum = 0.0f;
-      auto context_len = context_lens_ptr[seq_id];
-      auto attn_w_start = attn_weights_ptr + seq_id * attn_weights_stride +
-          head_id * max_context_len;
+  // div+add+softmax, of which the work of a head is its context length too
+  auto head_bounds = utils::balanced_partition(
+      num_seqs * num_heads, num_threads, [&](int64_t i) {
+        return context_lens_ptr[i / num_heads];
+      });
+#pragma omp parallel
+  {
+    for (auto part = omp_get_thread_num(); part < num_threads;
+         part += omp_get_num_threads()) {
+      for (auto i = head_bounds[part]; i < head_bounds[part + 1]; i++) {
+        auto seq_id = i / num_heads;
+        auto head_id = i % num_heads;
+        auto max_val = -10000.0f;
+        float sum = 0.0f;
+        auto context_len = context_lens_ptr[seq_id];
+        auto attn_w_start = attn_weights_ptr + seq_id * attn_weights_stride +
+            head_id * max_context_len;
 #if defined(CPU_CAPABILITY_AVX512)
-      if (alibi_slopes_ptr != nullptr) {
-        auto alibi_slope = alibi_slopes_ptr[head_id];
-        torch_ipex::cpu::kernel::
-            _dil_div_add_alibi_and_reduce_max_fusion_kernel<float>(
-                attn_w_start,
-                scale,
-                context_len,
-                attn_w_start,
-                max_val,
-                alibi_slope,
-                true);
-      } else {
-        torch_ipex::cpu::kernel::
-            _dil_div_add_alibi_and_reduce_max_fusion_kernel<float>(
-                attn_w_start,
-                scale,
-                context_len,
-                attn_w_start,
-                max_val,
-                1,
-                false);
-      }
-      torch_ipex::cpu::kernel::_dil_exp_reduce_sum_fusion_kernel(
-          attn_w_start, context_len, attn_w_start, max_val);
-      torch_ipex::cpu::kernel::_dil_normalization_kernel<float>(
-          attn_w_start, max_val, context_len, attn_w_start);
-
-#else
-      // div+add+softmax
-      for (auto token_id = 0; token_id < context_lens_ptr[seq_id]; token_id++) {
-        attn_w_start[token_id] = attn_w_start[token_id] * scale;
         if (alibi_slopes_ptr != nullptr) {
           auto alibi_slope = alibi_slopes_ptr[head_id];
-          auto alibi_slopes_val =
-              alibi_slope * (token_id + 1 - context_lens_ptr[seq_id]);
-          attn_w_start[token_id] = attn_w_start[token_id] + alibi_slopes_val;
+          torch_ipex::cpu::kernel::
+              _dil_div_add_alibi_and_reduce_max_fusion_kernel<float>(
+                  attn_w_start,
+                  scale,
+                  context_len,
+                  attn_w_start,
+                  max_val,
+                  alibi_slope,
+                  true);
+        } else {
+          torch_ipex::cpu::kernel::
+              _dil_div_add_alibi_and_reduce_max_fusion_kernel<float>(
+                  attn_w_start,
+                  scale,
+                  context_len,
+                  attn_w_start,
+                  max_val,
+                  1,
+                  false);
         }
-        if (attn_w_start[token_id] > max_val) {
-          max_val = attn_w_start[token_id];
+        torch_ipex::cpu::kernel::_dil_exp_reduce_sum_fusion_kernel(
+            attn_w_start, context_len, attn_w_start, max_val);
+        torch_ipex::cpu::kernel::_dil_normalization_kernel<float>(
+            attn_w_start, max_val, context_len, attn_w_start);
+
+#else
+        // div+add+softmax
+        for (auto token_id = 0; token_id < context_len; token_id++) {
+          attn_w_start[token_id] = attn_w_start[token_id] * scale;
+          if (alibi_slopes_ptr != nullptr) {
+            auto alibi_slope = alibi_slopes_ptr[head_id];
+            auto alibi_slopes_val =
+                alibi_slope * (token_id + 1 - context_lens_ptr[seq_id]);
+            attn_w_start[token_id] = attn_w_start[token_id] + alibi_slopes_val;
+          }
+          if (attn_w_start[token_id] > max_val) {
+            max_val = attn_w_start[token_id];
+          }
+        }
+        // exp and sum
+        for (auto token_id = 0; token_id < context_len; token_id++) {
+          attn_w_start[token_id] = exp(attn_w_start[token_id] - max_val);
+          sum += attn_w_start[token_id];
+        }
+        // normalize
+        for (auto token_id = 0; token_id < context_len; token_id++) {
+          attn_w_start[token_id] = attn_w_start[token_id] / sum;
         }
-      }
-      // exp and sum
-      for (auto token_id = 0; token_id < context_lens_ptr[seq_id]; token_id++) {
-        attn_w_start[token_id] = exp(attn_w_start[token_id] - max_val);
-        sum += attn_w_start[token_id];
-      }
-      // normalize
-      for (auto token_id = 0; token_id < context_lens_ptr[seq_id]; token_id++) {
-        attn_w_start[token_id] = attn_w_start[token_id] / sum;
-      }
 #endif
+      }
     }
   }
 
@@ -222,37 +261,44 @@ void single_query_cached_kv_attention_kernel(
   auto flag_access = private_attn_out_flag.accessor<uint8_t, 3>();
   auto private_attn_out_ptr = private_attn_outs.data_ptr<float>();
   auto private_attn_out_stride = private_attn_outs.stride(0);
-// mul and accumulate
-#pragma omp parallel for collapse(3)
-  for (auto seq_id = 0; seq_id < num_seqs; seq_id++) {
-    for (auto head_id = 0; head_id < num_heads; head_id++) {
-      for (auto token_id = 0; token_id < max_context_len; token_id++) {
-        auto context_len = context_lens_ptr[seq_id];
-        auto thread_id = omp_get_thread_num();
-        if (token_id >= context_len)
-          continue;
-        auto attn_w = attn_weights_ptr
-            [seq_id * attn_weights_stride + head_id * max_context_len +
-             token_id];
-        auto block_id = block_tables_ptr
-            [seq_id * max_num_blocks_per_seq + token_id / block_size];
-        auto block_offset = token_id % block_size;
-        auto v_cache_start = value_cache_ptr + block_id * kv_block_stride +
-            block_offset * num_kv_heads * head_size +
-            head_mapping_ptr[head_id] * head_size;
-        auto attn_out_start = private_attn_out_ptr +
-            thread_id * private_attn_out_stride + seq_id * q_stride +
-            head_id * head_size;
-        mul_attenion_weights_and_value_of_head<float, scalar_t>(
-            attn_w,
-            v_cache_start,
-            attn_out_start,
-            head_size,
-            flag_access[thread_id][seq_id][head_id]);
-        flag_access[thread_id][seq_id][head_id] = 1;
-      } // for token_id
-    } // for head_id
-  } // for seq_id
+  // mul and accumulate
+  {
+    utils::KernelProfileRegion profile_region("av");
+#pragma omp parallel
+    {
+      utils::KernelThreadTimer thread_timer(profile_scope);
+      auto thread_id = omp_get_thread_num();
+      auto av = [&](int64_t i, int64_t token_begin, int64_t token_end) {
+        auto seq_id = i / num_heads;
+        auto head_id = i % num_heads;
+        for (auto token_id = token_begin; token_id < token_end; token_id++) {
+          auto attn_w = attn_weights_ptr
+              [seq_id * attn_weights_stride + head_id * max_context_len +
+               token_id];
+          auto block_id = block_tables_ptr
+              [seq_id * max_num_blocks_per_seq + token_id / block_size];
+          auto block_offset = token_id % block_size;
+          auto v_cache_start = value_cache_ptr + block_id * kv_block_stride +
+              block_offset * num_kv_heads * head_size +
+              head_mapping_ptr[head_id] * head_size;
+          auto attn_out_start = private_attn_out_ptr +
+              thread_id * private_attn_out_stride + seq_id * q_stride +
+              head_id * head_size;
+          mul_attenion_weights_and_value_of_head<float, scalar_t>(
+              attn_w,
+              v_cache_start,
+              attn_out_start,
+              head_size,
+              flag_access[thread_id][seq_id][head_id]);
+          flag_access[thread_id][seq_id][head_id] = 1;
+        } // for token_id
+      };
+      for (auto part = thread_id; part < num_threads;
+           part += omp_get_num_threads()) {
+        utils::for_each_balanced_range(token_prefix, part, num_threads, av);
+      }
+    }
+  }
   {
     RECORD_FUNCTION(
         "ipex::single_query_cached_kv_attention::reduction_private_result",
@@ -347,6 +393,228 @@ void reshape_and_cache_kernel(
   }
 }
 
+/**
+ * Attention of the tokens of a speculative token tree over the cached keys
+ * and values.
+ *
+ * The keys and values of the tree tokens are in the cache after the prefix of
+ * the sequence, in the order of the tree tokens. Tree token q attends to the
+ * prefix and to the tree tokens of its ancestor mask, i.e. its ancestors and
+ * itself. The mask is built from the parents, so that only [num_tree_tokens]
+ * parents are passed instead of a dense mask.
+ *
+ * Each task computes all tree tokens of one head of one sequence with an
+ * online softmax over the blocks of the cache, so that each cached key and
+ * value is loaded once for all tree tokens.
+ *
+ * The alibi bias uses the depth of the tree tokens as their positions after
+ * the prefix.
+ *
+ * @param tree_parents  [num_seqs, num_tree_tokens] parent of each tree token,
+ * -1 for the children of the last token of the prefix. Parents should precede
+ * their children.
+ */
+template <typename scalar_t>
+void tree_cached_kv_attention_kernel(
+    at::Tensor& out,
+    at::Tensor& query,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& head_mapping,
+    const double scale,
+    at::Tensor& block_tables,
+    at::Tensor& context_lens,
+    at::Tensor& tree_parents,
+    int64_t block_size,
+    const c10::optional<at::Tensor>& alibi_slopes) {
+  auto out_ptr = out.data_ptr<scalar_t>();
+  auto query_ptr = query.data_ptr<scalar_t>();
+  auto key_cache_ptr = key_cache.data_ptr<scalar_t>();
+  auto value_cache_ptr = value_cache.data_ptr<scalar_t>();
+  auto head_mapping_ptr = head_mapping.data_ptr<int>();
+  auto block_tables_ptr = block_tables.data_ptr<int>();
+  auto context_lens_ptr = context_lens.data_ptr<int>();
+  auto parents_ptr = tree_parents.data_ptr<int>();
+  auto alibi_slopes_ptr = alibi_slopes.has_value()
+      ? alibi_slopes.value().data_ptr<float>()
+      : nullptr;
+  auto num_seqs = query.size(0);
+  auto num_tree_tokens = query.size(1);
+  auto num_heads = query.size(2);
+  auto head_size = query.size(3);
+  auto num_kv_heads = key_cache.size(2);
+  auto max_num_blocks_per_seq = block_tables.size(1);
+  auto kv_block_stride = key_cache.stride(0);
+  auto kv_token_stride = key_cache.stride(1);
+  auto q_seq_stride = query.stride(0);
+  auto q_token_stride = query.stride(1);
+  auto out_seq_stride = out.stride(0);
+  auto out_token_stride = out.stride(1);
+
+  // ancestor masks of the tree tokens, in words of 64 tokens
+  auto num_words = (num_tree_tokens + 63) / 64;
+  std::vector<uint64_t> masks(num_seqs * num_tree_tokens * num_words, 0);
+  std::vector<int64_t> depths(num_seqs * num_tree_tokens, 0);
+  for (int64_t s = 0; s < num_seqs; s++) {
+    TORCH_CHECK(
+        context_lens_ptr[s] >= num_tree_tokens,
+        "tree_cached_kv_attention: context_lens should include the tree ",
+        "tokens");
+    for (int64_t q = 0; q < num_tree_tokens; q++) {
+      auto parent = parents_ptr[s * num_tree_tokens + q];
+      TORCH_CHECK(
+          parent >= -1 && parent < q,
+          "tree_cached_kv_attention: the parent of a tree token should ",
+          "precede it");
+      auto mask = masks.data() + (s * num_tree_tokens + q) * num_words;
+      if (parent >= 0) {
+        auto parent_mask =
+            masks.data() + (s * num_tree_tokens + parent) * num_words;
+        std::copy(parent_mask, parent_mask + num_words, mask);
+        depths[s * num_tree_tokens + q] =
+            depths[s * num_tree_tokens + parent] + 1;
+      }
+      mask[q / 64] |= uint64_t(1) << (q % 64);
+    }
+  }
+
+  at::parallel_for(0, num_seqs * num_heads, 1, [&](int64_t begin, int64_t end) {
+    std::vector<float> scores(num_tree_tokens * block_size);
+    std::vector<float> acc(num_tree_tokens * head_size);
+    std::vector<float> row_max(num_tree_tokens);
+    std::vector<float> row_sum(num_tree_tokens);
+    for (int64_t i = begin; i < end; i++) {
+      auto s = i / num_heads;
+      auto h = i % num_heads;
+      auto kv_h = head_mapping_ptr[h];
+      auto context_len = context_lens_ptr[s];
+      auto prefix_len = context_len - num_tree_tokens;
+      auto seq_masks = masks.data() + s * num_tree_tokens * num_words;
+      auto seq_depths = depths.data() + s * num_tree_tokens;
+      auto alibi_slope = alibi_slopes_ptr ? alibi_slopes_ptr[h] : 0.f;
+      std::fill(acc.begin(), acc.end(), 0.f);
+      std::fill(
+          row_max.begin(),
+          row_max.end(),
+          -std::numeric_limits<float>::infinity());
+      std::fill(row_sum.begin(), row_sum.end(), 0.f);
+      for (int64_t start = 0; start < context_len; start += block_size) {
+        auto n = std::min(block_size, context_len - start);
+        auto block_id =
+            block_tables_ptr[s * max_num_blocks_per_seq + start / block_size];
+        auto k_block = key_cache_ptr + block_id * kv_block_stride +
+            kv_h * head_size;
+        auto v_block = value_cache_ptr + block_id * kv_block_stride +
+            kv_h * head_size;
+        for (int64_t j = 0; j < n; j++) {
+          auto pos = start + j;
+          auto tree_token = pos - prefix_len;
+          auto key_pos =
+              tree_token < 0 ? pos : prefix_len + seq_depths[tree_token];
+          for (int64_t q = 0; q < num_tree_tokens; q++) {
+            auto score = scores.data() + q * block_size + j;
+            if (tree_token >= 0 &&
+                !((seq_masks[q * num_words + tree_token / 64] >>
+                   (tree_token % 64)) &
+                  1)) {
+              *score = -std::numeric_limits<float>::infinity();
+              continue;
+            }
+            auto q_ptr = query_ptr + s * q_seq_stride + q * q_token_stride +
+                h * head_size;
+            reduce_head<scalar_t, scalar_t>(
+                q_ptr, k_block + j * kv_token_stride, score, head_size);
+            *score = *score * scale;
+            if (alibi_slopes_ptr != nullptr) {
+              *score += alibi_slope * (key_pos - prefix_len - seq_depths[q]);
+            }
+          }
+        }
+        for (int64_t q = 0; q < num_tree_tokens; q++) {
+          auto q_scores = scores.data() + q * block_size;
+          auto block_max = *std::max_element(q_scores, q_scores + n);
+          if (std::isinf(block_max)) {
+            continue;
+          }
+          auto q_acc = acc.data() + q * head_size;
+          auto new_max = std::max(row_max[q], block_max);
+          auto rescale = std::exp(row_max[q] - new_max);
+          row_sum[q] *= rescale;
+          for (int64_t d = 0; d < head_size; d++) {
+            q_acc[d] *= rescale;
+          }
+          for (int64_t j = 0; j < n; j++) {
+            if (std::isinf(q_scores[j])) {
+              continue;
+            }
+            auto w = std::exp(q_scores[j] - new_max);
+            row_sum[q] += w;
+            mul_attenion_weights_and_value_of_head<float, scalar_t>(
+                w, v_block + j * kv_token_stride, q_acc, head_size, true);
+          }
+          row_max[q] = new_max;
+        }
+      }
+      for (int64_t q = 0; q < num_tree_tokens; q++) {
+        auto q_acc = acc.data() + q * head_size;
+        auto out_start = out_ptr + s * out_seq_stride + q * out_token_stride +
+            h * head_size;
+        for (int64_t d = 0; d < head_size; d++) {
+          out_start[d] = static_cast<scalar_t>(q_acc[d] / row_sum[q]);
+        }
+      }
+    }
+  });
+} // tree_cached_kv_attention_kernel
+
+/**
+ * Moves the keys and values of the accepted tree tokens of each sequence to
+ * the slots right after its prefix. The accepted tokens are in ascending
+ * order, so that moving them in order never overwrites a token to move.
+ */
+template <typename scalar_t>
+void tree_accept_kv_cache_kernel(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& block_tables,
+    at::Tensor& prefix_lens,
+    at::Tensor& accepted,
+    at::Tensor& num_accepted) {
+  auto key_cache_ptr = key_cache.data_ptr<scalar_t>();
+  auto value_cache_ptr = value_cache.data_ptr<scalar_t>();
+  auto block_tables_ptr = block_tables.data_ptr<int>();
+  auto prefix_lens_ptr = prefix_lens.data_ptr<int>();
+  auto accepted_ptr = accepted.data_ptr<int>();
+  auto num_accepted_ptr = num_accepted.data_ptr<int>();
+  auto num_seqs = block_tables.size(0);
+  auto max_num_blocks_per_seq = block_tables.size(1);
+  auto max_num_accepted = accepted.size(1);
+  auto block_size = key_cache.size(1);
+  auto cache_stride = key_cache.stride(0);
+  auto token_size = key_cache.size(2) * key_cache.size(3);
+  auto slot_offset = [&](int64_t s, int64_t pos) {
+    auto block_id =
+        block_tables_ptr[s * max_num_blocks_per_seq + pos / block_size];
+    return block_id * cache_stride + (pos % block_size) * token_size;
+  };
+#pragma omp parallel for
+  for (auto s = 0; s < num_seqs; s++) {
+    auto prefix_len = prefix_lens_ptr[s];
+    for (auto t = 0; t < num_accepted_ptr[s]; t++) {
+      auto token = accepted_ptr[s * max_num_accepted + t];
+      if (token == t) {
+        continue;
+      }
+      auto src = slot_offset(s, prefix_len + token);
+      auto dst = slot_offset(s, prefix_len + t);
+      torch_ipex::cpu::kernel::move_ker<scalar_t, scalar_t>(
+          key_cache_ptr + dst, key_cache_ptr + src, token_size);
+      torch_ipex::cpu::kernel::move_ker<scalar_t, scalar_t>(
+          value_cache_ptr + dst, value_cache_ptr + src, token_size);
+    }
+  }
+}
+
 void single_query_cached_kv_attention_kernel_impl(
     at::Tensor& out, // [num_seqs, num_heads, head_size]
     at::Tensor& query, // [num_seqs, num_heads, head_size]
@@ -362,6 +630,18 @@ void single_query_cached_kv_attention_kernel_impl(
   RECORD_FUNCTION(
       "ipex::single_query_cached_kv_attention_kernel_impl",
       c10::ArrayRef<c10::IValue>({}));
+  utils::KernelProfileScope profile(
+      "paged_attention", query, key_cache, value_cache);
+  if (profile.active()) {
+    // QK and AV of each head against the cached keys and values of its seq
+    auto kv_tokens = context_lens.sum().item<int64_t>();
+    auto kv_bytes = kv_tokens * key_cache.size(2) * key_cache.size(3) *
+        key_cache.element_size();
+    profile.add_cost(
+        4.0 * kv_tokens * query.size(1) * query.size(2),
+        query.nbytes() + 2.0 * kv_bytes,
+        out.nbytes());
+  }
   // dispatch kernel according to the data type of input tensor
   if (out.scalar_type() == at::ScalarType::Float) {
     single_query_cached_kv_attention_kernel<float>(
@@ -426,6 +706,175 @@ void reshape_and_cache_cpu_kernel_impl(
   }
 }
 
+void tree_cached_kv_attention_kernel_impl(
+    at::Tensor& out,
+    at::Tensor& query,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& head_mapping,
+    const double scale,
+    at::Tensor& block_tables,
+    at::Tensor& context_lens,
+    at::Tensor& tree_parents,
+    int64_t block_size,
+    const c10::optional<at::Tensor>& alibi_slopes) {
+  if (out.scalar_type() == at::ScalarType::Float) {
+    tree_cached_kv_attention_kernel<float>(
+        out,
+        query,
+        key_cache,
+        value_cache,
+        head_mapping,
+        scale,
+        block_tables,
+        context_lens,
+        tree_parents,
+        block_size,
+        alibi_slopes);
+  } else if (out.scalar_type() == at::ScalarType::BFloat16) {
+    tree_cached_kv_attention_kernel<at::BFloat16>(
+        out,
+        query,
+        key_cache,
+        value_cache,
+        head_mapping,
+        scale,
+        block_tables,
+        context_lens,
+        tree_parents,
+        block_size,
+        alibi_slopes);
+  } else {
+    TORCH_CHECK(false, "Unsupported data type for tree_cached_kv_attention");
+  }
+}
+
+void tree_accept_kv_cache_kernel_impl(
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    at::Tensor& block_tables,
+    at::Tensor& prefix_lens,
+    at::Tensor& accepted,
+    at::Tensor& num_accepted) {
+  TORCH_CHECK(
+      key_cache.scalar_type() == value_cache.scalar_type(),
+      "key_cache and value_cache should have the same data type");
+  TORCH_CHECK(key_cache.is_contiguous(), "key_cache should be contiguous");
+  TORCH_CHECK(value_cache.is_contiguous(), "value_cache should be contiguous");
+  if (key_cache.scalar_type() == at::ScalarType::Float) {
+    tree_accept_kv_cache_kernel<float>(
+        key_cache,
+        value_cache,
+        block_tables,
+        prefix_lens,
+        accepted,
+        num_accepted);
+  } else if (key_cache.scalar_type() == at::ScalarType::BFloat16) {
+    tree_accept_kv_cache_kernel<at::BFloat16>(
+        key_cache,
+        value_cache,
+        block_tables,
+        prefix_lens,
+        accepted,
+        num_accepted);
+  } else {
+    TORCH_CHECK(false, "Unsupported data type for tree_accept_kv_cache");
+  }
+}
+
+void copy_blocks_kernel_impl(
+    at::TensorList key_caches,
+    at::TensorList value_caches,
+    const at::Tensor& block_mapping) {
+  auto num_layers = key_caches.size();
+  auto num_pairs = block_mapping.size(0);
+  auto mapping_ptr = block_mapping.data_ptr<int64_t>();
+  auto block_bytes = key_caches[0].stride(0) * key_caches[0].element_size();
+#pragma omp parallel for collapse(2)
+  for (size_t li = 0; li < num_layers; li++) {
+    for (int64_t pi = 0; pi < num_pairs; pi++) {
+      auto src = mapping_ptr[2 * pi] * block_bytes;
+      auto dst = mapping_ptr[2 * pi + 1] * block_bytes;
+      auto key_ptr = static_cast<char*>(key_caches[li].data_ptr());
+      auto value_ptr = static_cast<char*>(value_caches[li].data_ptr());
+      std::memcpy(key_ptr + dst, key_ptr + src, block_bytes);
+      std::memcpy(value_ptr + dst, value_ptr + src, block_bytes);
+    }
+  }
+}
+
+template <typename SRC_T, typename DST_T>
+void swap_blocks_kernel(
+    const at::Tensor& src,
+    at::Tensor& dst,
+    const at::Tensor& block_mapping) {
+  auto num_pairs = block_mapping.size(0);
+  auto mapping_ptr = block_mapping.data_ptr<int64_t>();
+  auto block_numel = src.stride(0);
+  auto src_ptr = src.data_ptr<SRC_T>();
+  auto dst_ptr = dst.data_ptr<DST_T>();
+#pragma omp parallel for
+  for (int64_t pi = 0; pi < num_pairs; pi++) {
+    at::vec::convert(
+        src_ptr + mapping_ptr[2 * pi] * block_numel,
+        dst_ptr + mapping_ptr[2 * pi + 1] * block_numel,
+        block_numel);
+  }
+}
+
+void swap_blocks_kernel_impl(
+    const at::Tensor& src,
+    at::Tensor& dst,
+    const at::Tensor& block_mapping) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, src.scalar_type(), "swap_blocks", [&] {
+        using src_t = scalar_t;
+        AT_DISPATCH_FLOATING_TYPES_AND2(
+            at::kBFloat16, at::kHalf, dst.scalar_type(), "swap_blocks", [&] {
+              swap_blocks_kernel<src_t, scalar_t>(src, dst, block_mapping);
+            });
+      });
+}
+
+at::Tensor hash_kv_blocks_kernel_impl(
+    const at::Tensor& token_ids,
+    const at::Tensor& seq_lens,
+    int64_t block_size,
+    const at::Tensor& extra_hashes) {
+  using utils::Sha256;
+  constexpr int64_t kHashWords = Sha256::kDigestSize / sizeof(int64_t);
+  auto num_seqs = token_ids.size(0);
+  auto max_len = token_ids.size(1);
+  auto max_num_blocks = max_len / block_size;
+  auto hashes = at::zeros({num_seqs, max_num_blocks, kHashWords}, at::kLong);
+  auto hashes_ptr = hashes.data_ptr<int64_t>();
+  auto token_ids_ptr = token_ids.data_ptr<int64_t>();
+  auto seq_lens_ptr = seq_lens.data_ptr<int64_t>();
+  auto extra_ptr =
+      extra_hashes.defined() ? extra_hashes.data_ptr<int64_t>() : nullptr;
+  at::parallel_for(0, num_seqs, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t s = begin; s < end; s++) {
+      // The digest of a block is the SHA-256 of the digest of the block
+      // before it and of its tokens, the chain starting from the extra hash
+      Sha256::Digest digest{};
+      int64_t extra = extra_ptr ? extra_ptr[s] : 0;
+      std::memcpy(digest.data(), &extra, sizeof(extra));
+      auto tokens = token_ids_ptr + s * max_len;
+      for (int64_t b = 0; b < seq_lens_ptr[s] / block_size; b++) {
+        Sha256 sha;
+        sha.update(digest.data(), digest.size());
+        sha.update(tokens + b * block_size, block_size * sizeof(int64_t));
+        digest = sha.digest();
+        std::memcpy(
+            hashes_ptr + (s * max_num_blocks + b) * kHashWords,
+            digest.data(),
+            digest.size());
+      }
+    }
+  });
+  return hashes;
+}
+
 } // namespace
 
 IPEX_REGISTER_DISPATCH(
@@ -434,6 +883,15 @@ IPEX_REGISTER_DISPATCH(
 IPEX_REGISTER_DISPATCH(
     reshape_and_cache_kernel_stub,
     &reshape_and_cache_cpu_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    tree_cached_kv_attention_kernel_stub,
+    &tree_cached_kv_attention_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    tree_accept_kv_cache_kernel_stub,
+    &tree_accept_kv_cache_kernel_impl);
+IPEX_REGISTER_DISPATCH(copy_blocks_kernel_stub, &copy_blocks_kernel_impl);
+IPEX_REGISTER_DISPATCH(swap_blocks_kernel_stub, &swap_blocks_kernel_impl);
+IPEX_REGISTER_DISPATCH(hash_kv_blocks_kernel_stub, &hash_kv_blocks_kernel_impl);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -1,6 +1,7 @@
 #include <aten/RMSNorm.h>
 
 #include <torch/csrc/autograd/function.h>
+#include "utils/kernel_profiler.h"
 #include "vec/vec.h"
 
 namespace torch_ipex {
@@ -19,10 +20,17 @@ void RMSNormKernelImpl(
     at::Tensor& Y) {
   DCHECK(a.numel() == M * N);
   DCHECK(!gamma.defined() || gamma.numel() == M * N);
+  utils::KernelProfileScope profile("rmsnorm", a, gamma);
+  profile.add_cost(
+      4.0 * M * N,
+      a.nbytes() + (gamma.defined() ? gamma.nbytes() : 0),
+      Y.nbytes());
   const T* a_data = a.data_ptr<T>();
   const T1* gamma_data = gamma.defined() ? gamma.data_ptr<T1>() : nullptr;
   T* Y_data = Y.data_ptr<T>();
+  auto profile_scope = utils::KernelProfileScope::current();
   at::parallel_for(0, M, 1, [&](int64_t start, int64_t end) {
+    utils::KernelThreadTimer thread_timer(profile_scope);
     for (const auto i : c10::irange(start, end)) {
       const T* a_ptr = a_data + i * N;
       T* Y_ptr = Y_data + i * N;
@@ -0,0 +1,453 @@
+#include <ATen/Parallel.h>
+#include <ATen/Tensor.h>
+#include <c10/util/Exception.h>
+#include <torch/all.h>
+
+#include <aten/RnntGreedyDecode.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+inline float sigmoid_ker(float x) {
+  return 1.f / (1.f + std::exp(-x));
+}
+
+std::tuple<at::Tensor, at::Tensor> rnnt_lstm_pack_weight_kernel_impl(
+    const at::Tensor& weight_ih,
+    const at::Tensor& weight_hh,
+    const at::Tensor& bias_ih,
+    const at::Tensor& bias_hh) {
+  TORCH_CHECK(
+      weight_ih.dim() == 2 && weight_hh.dim() == 2,
+      "rnnt_lstm_pack_weight: expect 2D weight_ih and weight_hh");
+  TORCH_CHECK(
+      weight_ih.size(0) == weight_hh.size(0) &&
+          weight_hh.size(0) == 4 * weight_hh.size(1),
+      "rnnt_lstm_pack_weight: expect weight_hh to be [4*hidden_size, hidden_size]");
+  // [x, h] x [[W_ih^T], [W_hh^T]] gives the 4 gates in one GEMM
+  auto weight = at::cat({weight_ih, weight_hh}, 1).t().contiguous();
+  // Bias is added in fp32 inside the LSTM cell
+  auto bias = at::add(bias_ih.to(at::kFloat), bias_hh.to(at::kFloat))
+                  .contiguous();
+  return std::make_tuple(weight, bias);
+}
+
+// Per-slot state of the compacted working set. Slot s in [0, active) holds
+// one unfinished utterance; the rows of the hidden buffers follow the slot.
+template <typename scalar_t>
+struct GreedyDecodeState {
+  int64_t num_layers;
+  int64_t batch_size;
+  int64_t hidden_size;
+  int64_t joint_dim;
+  std::vector<int64_t> utt;
+  std::vector<int64_t> time_idx;
+  std::vector<int64_t> symbols_added;
+  std::vector<int64_t> last_label;
+  // whether pred_proj/h_new/c_new are up to date with the committed state
+  std::vector<char> pred_valid;
+  // committed hidden state: [num_layers, batch_size, hidden_size]
+  scalar_t* h;
+  float* c;
+  // hidden state after consuming last_label, committed on a non-blank symbol
+  scalar_t* h_new;
+  float* c_new;
+  // joint network projection of the prediction output: [batch_size, joint]
+  scalar_t* pred_proj;
+
+  inline int64_t hidden_offset(int64_t layer, int64_t slot) const {
+    return (layer * batch_size + slot) * hidden_size;
+  }
+
+  void commit(int64_t slot) {
+    for (int64_t l = 0; l < num_layers; l++) {
+      auto off = hidden_offset(l, slot);
+      std::copy(h_new + off, h_new + off + hidden_size, h + off);
+      std::copy(c_new + off, c_new + off + hidden_size, c + off);
+    }
+  }
+
+  void move_slot(int64_t dst, int64_t src) {
+    utt[dst] = utt[src];
+    time_idx[dst] = time_idx[src];
+    symbols_added[dst] = symbols_added[src];
+    last_label[dst] = last_label[src];
+    pred_valid[dst] = pred_valid[src];
+    for (int64_t l = 0; l < num_layers; l++) {
+      auto d = hidden_offset(l, dst);
+      auto s = hidden_offset(l, src);
+      std::copy(h + s, h + s + hidden_size, h + d);
+      std::copy(c + s, c + s + hidden_size, c + d);
+      std::copy(h_new + s, h_new + s + hidden_size, h_new + d);
+      std::copy(c_new + s, c_new + s + hidden_size, c_new + d);
+    }
+    std::copy(
+        pred_proj + src * joint_dim,
+        pred_proj + (src + 1) * joint_dim,
+        pred_proj + dst * joint_dim);
+  }
+};
+
+template <typename scalar_t>
+void rnnt_greedy_decode_kernel(
+    const at::Tensor& enc_proj,
+    const int64_t* lens_ptr,
+    const at::Tensor& embedding_table,
+    const std::vector<at::Tensor>& lstm_weights,
+    const std::vector<at::Tensor>& lstm_biases,
+    const at::Tensor& pred_weight_t,
+    const at::Tensor& pred_bias,
+    const at::Tensor& fc_weight_t,
+    const at::Tensor& fc_bias,
+    at::Tensor& labels,
+    at::Tensor& label_lens,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS) {
+  const int64_t batch_size = enc_proj.size(0);
+  const int64_t time_step = enc_proj.size(1);
+  const int64_t joint_dim = enc_proj.size(2);
+  const int64_t num_layers = lstm_weights.size();
+  const int64_t hidden_size = lstm_biases[0].numel() / 4;
+  const int64_t embedding_dim = embedding_table.size(1);
+  const int64_t vocab_size = fc_weight_t.size(1);
+  const int64_t label_stride = labels.size(1);
+
+  auto opts = enc_proj.options();
+  auto f32_opts = opts.dtype(at::kFloat);
+  auto h = at::zeros({num_layers, batch_size, hidden_size}, opts);
+  auto c = at::zeros({num_layers, batch_size, hidden_size}, f32_opts);
+  auto h_new = at::empty({num_layers, batch_size, hidden_size}, opts);
+  auto c_new = at::empty({num_layers, batch_size, hidden_size}, f32_opts);
+  auto pred_proj = at::empty({batch_size, joint_dim}, opts);
+  // Scratch buffers reused across all the steps of the decoding loop
+  std::vector<at::Tensor> layer_in(num_layers);
+  for (int64_t l = 0; l < num_layers; l++) {
+    auto in_size = l == 0 ? embedding_dim : hidden_size;
+    layer_in[l] = at::empty({batch_size, in_size + hidden_size}, opts);
+  }
+  auto gates = at::empty({batch_size, 4 * hidden_size}, opts);
+  auto pred_out = at::empty({batch_size, hidden_size}, opts);
+  auto pred_proj_tmp = at::empty({batch_size, joint_dim}, opts);
+  auto joint_hidden = at::empty({batch_size, joint_dim}, opts);
+  auto logits = at::empty({batch_size, vocab_size}, opts);
+
+  GreedyDecodeState<scalar_t> state;
+  state.num_layers = num_layers;
+  state.batch_size = batch_size;
+  state.hidden_size = hidden_size;
+  state.joint_dim = joint_dim;
+  state.h = h.data_ptr<scalar_t>();
+  state.c = c.data_ptr<float>();
+  state.h_new = h_new.data_ptr<scalar_t>();
+  state.c_new = c_new.data_ptr<float>();
+  state.pred_proj = pred_proj.data_ptr<scalar_t>();
+  for (int64_t i = 0; i < batch_size; i++) {
+    if (lens_ptr[i] > 0) {
+      state.utt.push_back(i);
+    }
+  }
+  int64_t active = state.utt.size();
+  state.time_idx.assign(active, 0);
+  state.symbols_added.assign(active, 0);
+  state.last_label.assign(active, _SOS);
+  state.pred_valid.assign(active, 0);
+
+  const auto* enc_proj_ptr = enc_proj.data_ptr<scalar_t>();
+  const auto* emb_ptr = embedding_table.data_ptr<scalar_t>();
+  auto* labels_ptr = labels.data_ptr<int64_t>();
+  auto* label_lens_ptr = label_lens.data_ptr<int64_t>();
+  auto* gates_ptr = gates.data_ptr<scalar_t>();
+  auto* pred_out_ptr = pred_out.data_ptr<scalar_t>();
+  auto* pred_proj_tmp_ptr = pred_proj_tmp.data_ptr<scalar_t>();
+  auto* joint_hidden_ptr = joint_hidden.data_ptr<scalar_t>();
+  auto* logits_ptr = logits.data_ptr<scalar_t>();
+
+  std::vector<int64_t> rows;
+  std::vector<int64_t> k(batch_size);
+  std::vector<char> finished(batch_size);
+  rows.reserve(batch_size);
+
+  while (active > 0) {
+    // 1. Prediction network, only for the slots which emitted a non-blank
+    // symbol in the last step. A blank keeps both the label and the hidden
+    // state, so the previous prediction is still valid.
+    rows.clear();
+    for (int64_t s = 0; s < active; s++) {
+      if (!state.pred_valid[s]) {
+        rows.push_back(s);
+      }
+    }
+    const int64_t num_rows = rows.size();
+    if (num_rows > 0) {
+      at::parallel_for(0, num_rows, 16, [&](int64_t start, int64_t end) {
+        for (int64_t r = start; r < end; r++) {
+          auto s = rows[r];
+          auto* in0 = layer_in[0].data_ptr<scalar_t>() +
+              r * (embedding_dim + hidden_size);
+          if (state.last_label[s] == _SOS) {
+            std::fill(in0, in0 + embedding_dim, static_cast<scalar_t>(0));
+          } else {
+            const auto* emb = emb_ptr + state.last_label[s] * embedding_dim;
+            std::copy(emb, emb + embedding_dim, in0);
+          }
+          for (int64_t l = 0; l < num_layers; l++) {
+            auto in_size = l == 0 ? embedding_dim : hidden_size;
+            auto* in = layer_in[l].data_ptr<scalar_t>() +
+                r * (in_size + hidden_size) + in_size;
+            const auto* hx = state.h + state.hidden_offset(l, s);
+            std::copy(hx, hx + hidden_size, in);
+          }
+        }
+      });
+
+      for (int64_t l = 0; l < num_layers; l++) {
+        auto gates_rows = gates.narrow(0, 0, num_rows);
+        at::mm_out(
+            gates_rows, layer_in[l].narrow(0, 0, num_rows), lstm_weights[l]);
+        const auto* bias_ptr = lstm_biases[l].data_ptr<float>();
+        auto* next_in = l + 1 < num_layers
+            ? layer_in[l + 1].data_ptr<scalar_t>()
+            : pred_out_ptr;
+        auto next_stride =
+            l + 1 < num_layers ? hidden_size + hidden_size : hidden_size;
+        at::parallel_for(0, num_rows, 16, [&](int64_t start, int64_t end) {
+          for (int64_t r = start; r < end; r++) {
+            auto s = rows[r];
+            auto off = state.hidden_offset(l, s);
+            const auto* g = gates_ptr + r * 4 * hidden_size;
+            const auto* cx = state.c + off;
+            auto* cy = state.c_new + off;
+            auto* hy = state.h_new + off;
+            auto* out = next_in + r * next_stride;
+            // PyTorch gate order: input, forget, cell, output
+            for (int64_t j = 0; j < hidden_size; j++) {
+              float ig = sigmoid_ker(static_cast<float>(g[j]) + bias_ptr[j]);
+              float fg = sigmoid_ker(
+                  static_cast<float>(g[hidden_size + j]) +
+                  bias_ptr[hidden_size + j]);
+              float cg = std::tanh(
+                  static_cast<float>(g[2 * hidden_size + j]) +
+                  bias_ptr[2 * hidden_size + j]);
+              float og = sigmoid_ker(
+                  static_cast<float>(g[3 * hidden_size + j]) +
+                  bias_ptr[3 * hidden_size + j]);
+              float cv = fg * cx[j] + ig * cg;
+              auto hv = static_cast<scalar_t>(og * std::tanh(cv));
+              cy[j] = cv;
+              hy[j] = hv;
+              out[j] = hv;
+            }
+          }
+        });
+      }
+
+      auto pred_proj_rows = pred_proj_tmp.narrow(0, 0, num_rows);
+      at::addmm_out(
+          pred_proj_rows,
+          pred_bias,
+          pred_out.narrow(0, 0, num_rows),
+          pred_weight_t);
+      at::parallel_for(0, num_rows, 16, [&](int64_t start, int64_t end) {
+        for (int64_t r = start; r < end; r++) {
+          auto s = rows[r];
+          std::copy(
+              pred_proj_tmp_ptr + r * joint_dim,
+              pred_proj_tmp_ptr + (r + 1) * joint_dim,
+              state.pred_proj + s * joint_dim);
+          state.pred_valid[s] = 1;
+        }
+      });
+    }
+
+    // 2. Joint network over all the active slots. The encoder side has been
+    // projected for all the time steps ahead of the loop.
+    at::parallel_for(0, active, 16, [&](int64_t start, int64_t end) {
+      for (int64_t s = start; s < end; s++) {
+        const auto* f = enc_proj_ptr +
+            (state.utt[s] * time_step + state.time_idx[s]) * joint_dim;
+        const auto* g = state.pred_proj + s * joint_dim;
+        auto* z = joint_hidden_ptr + s * joint_dim;
+        for (int64_t j = 0; j < joint_dim; j++) {
+          float v = static_cast<float>(f[j]) + static_cast<float>(g[j]);
+          z[j] = static_cast<scalar_t>(v > 0.f ? v : 0.f);
+        }
+      }
+    });
+    auto logits_rows = logits.narrow(0, 0, active);
+    at::addmm_out(
+        logits_rows, fc_bias, joint_hidden.narrow(0, 0, active), fc_weight_t);
+
+    // log_softmax is monotonic, argmax on the logits is enough
+    at::parallel_for(0, active, 16, [&](int64_t start, int64_t end) {
+      for (int64_t s = start; s < end; s++) {
+        const auto* row = logits_ptr + s * vocab_size;
+        int64_t best = 0;
+        float best_val = -std::numeric_limits<float>::infinity();
+        for (int64_t v = 0; v < vocab_size; v++) {
+          float val = static_cast<float>(row[v]);
+          if (val > best_val) {
+            best_val = val;
+            best = v;
+          }
+        }
+        k[s] = best;
+      }
+    });
+
+    // 3. Update the labels and the time index of each slot
+    at::parallel_for(0, active, 16, [&](int64_t start, int64_t end) {
+      for (int64_t s = start; s < end; s++) {
+        auto u = state.utt[s];
+        if (k[s] == blank_id) {
+          state.time_idx[s]++;
+          state.symbols_added[s] = 0;
+        } else {
+          labels_ptr[u * label_stride + label_lens_ptr[u]] = k[s];
+          label_lens_ptr[u]++;
+          state.commit(s);
+          state.last_label[s] = k[s];
+          state.pred_valid[s] = 0;
+          if (++state.symbols_added[s] >= max_symbols) {
+            state.time_idx[s]++;
+            state.symbols_added[s] = 0;
+          }
+        }
+        finished[s] = state.time_idx[s] >= std::min(lens_ptr[u], time_step);
+      }
+    });
+
+    // 4. Compact the working set: fill the finished slots with the last
+    // unfinished ones so that the next step runs on a dense batch.
+    for (int64_t s = 0; s < active; s++) {
+      if (!finished[s]) {
+        continue;
+      }
+      while (active > s + 1 && finished[active - 1]) {
+        active--;
+      }
+      if (active > s + 1) {
+        state.move_slot(s, active - 1);
+        finished[s] = 0;
+      }
+      active--;
+    }
+  }
+}
+
+std::tuple<at::Tensor, at::Tensor> rnnt_greedy_decode_kernel_impl(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const std::vector<at::Tensor>& lstm_weights,
+    const std::vector<at::Tensor>& lstm_biases,
+    const at::Tensor& joint_enc_weight,
+    const at::Tensor& joint_enc_bias,
+    const at::Tensor& joint_pred_weight,
+    const at::Tensor& joint_pred_bias,
+    const at::Tensor& joint_fc_weight,
+    const at::Tensor& joint_fc_bias,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS) {
+  auto dtype = x.scalar_type();
+  TORCH_CHECK(
+      dtype == at::kFloat || dtype == at::kBFloat16,
+      "rnnt_greedy_decode: only support x to be float or bf16 tensor");
+  const int64_t batch_size = x.size(0);
+  const int64_t time_step = x.size(1);
+  const int64_t hidden_size = lstm_biases[0].numel() / 4;
+
+  auto lens = out_lens.to(at::kLong).contiguous();
+  const auto* lens_ptr = lens.data_ptr<int64_t>();
+  int64_t max_len = 0;
+  for (int64_t i = 0; i < batch_size; i++) {
+    max_len = std::max(max_len, std::min(lens_ptr[i], time_step));
+  }
+
+  auto embedding = embedding_table.to(dtype).contiguous();
+  std::vector<at::Tensor> weights, biases;
+  for (size_t l = 0; l < lstm_weights.size(); l++) {
+    auto in_size = l == 0 ? embedding.size(1) : hidden_size;
+    TORCH_CHECK(
+        lstm_weights[l].dim() == 2 &&
+            lstm_weights[l].size(0) == in_size + hidden_size &&
+            lstm_weights[l].size(1) == 4 * hidden_size,
+        "rnnt_greedy_decode: LSTM weight of layer ",
+        l,
+        " is not packed by rnnt_lstm_pack_weight");
+    weights.push_back(lstm_weights[l].to(dtype).contiguous());
+    biases.push_back(lstm_biases[l].to(at::kFloat).contiguous());
+  }
+  TORCH_CHECK(
+      joint_pred_weight.size(1) == hidden_size,
+      "rnnt_greedy_decode: joint_pred_weight does not match the LSTM hidden size");
+
+  // The encoder side of the joint network does not depend on the decoded
+  // labels, project all the time steps with one GEMM.
+  auto enc_proj =
+      at::linear(x, joint_enc_weight.to(dtype), joint_enc_bias.to(dtype))
+          .contiguous();
+  auto pred_weight_t = joint_pred_weight.to(dtype).t().contiguous();
+  auto pred_bias = joint_pred_bias.to(dtype).contiguous();
+  auto fc_weight_t = joint_fc_weight.to(dtype).t().contiguous();
+  auto fc_bias = joint_fc_bias.to(dtype).contiguous();
+
+  auto labels =
+      at::full({batch_size, max_len * max_symbols}, _SOS, lens.options());
+  auto label_lens = at::zeros({batch_size}, lens.options());
+
+  if (dtype == at::kBFloat16) {
+    rnnt_greedy_decode_kernel<at::BFloat16>(
+        enc_proj,
+        lens_ptr,
+        embedding,
+        weights,
+        biases,
+        pred_weight_t,
+        pred_bias,
+        fc_weight_t,
+        fc_bias,
+        labels,
+        label_lens,
+        max_symbols,
+        blank_id,
+        _SOS);
+  } else {
+    rnnt_greedy_decode_kernel<float>(
+        enc_proj,
+        lens_ptr,
+        embedding,
+        weights,
+        biases,
+        pred_weight_t,
+        pred_bias,
+        fc_weight_t,
+        fc_bias,
+        labels,
+        label_lens,
+        max_symbols,
+        blank_id,
+        _SOS);
+  }
+  return std::make_tuple(labels, label_lens);
+}
+
+} // anonymous namespace
+
+IPEX_REGISTER_DISPATCH(
+    rnnt_lstm_pack_weight_kernel_stub,
+    &rnnt_lstm_pack_weight_kernel_impl);
+
+IPEX_REGISTER_DISPATCH(
+    rnnt_greedy_decode_kernel_stub,
+    &rnnt_greedy_decode_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
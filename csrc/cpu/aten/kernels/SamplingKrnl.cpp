@@ -0,0 +1,233 @@
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/PhiloxRNGEngine.h>
+#include <aten/Sampling.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// Logits of one task of the update
+constexpr int64_t kSamplingChunkSize = 4096;
+
+using Candidate = std::pair<float, int64_t>;
+
+// Higher logits first, then lower tokens, so that the candidates do not
+// depend on the tiling of the vocab or on the number of threads
+inline bool better(const Candidate& a, const Candidate& b) {
+  return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+inline void push_candidate(
+    std::vector<Candidate>& heap,
+    int64_t capacity,
+    float logit,
+    int64_t token) {
+  Candidate c(logit, token);
+  if ((int64_t)heap.size() < capacity) {
+    heap.push_back(c);
+    std::push_heap(heap.begin(), heap.end(), better);
+  } else if (better(c, heap.front())) {
+    std::pop_heap(heap.begin(), heap.end(), better);
+    heap.back() = c;
+    std::push_heap(heap.begin(), heap.end(), better);
+  }
+}
+
+// Uniform in (0, 1)
+inline double uniform(at::Philox4_32& engine) {
+  return (static_cast<double>(engine()) + 0.5) / 4294967296.0;
+}
+
+template <typename scalar_t>
+void sampling_update(
+    SamplingState& state,
+    const at::Tensor& logits,
+    int64_t offset) {
+  auto B = state.batch_size;
+  auto n = std::min(logits.size(1), state.vocab_size - offset);
+  if (n <= 0) {
+    return;
+  }
+  TORCH_CHECK(
+      logits.size(0) == B && logits.stride(1) == 1,
+      "sampling: expect logits of [batch_size, n] of contiguous rows");
+  auto logits_ptr = logits.data_ptr<scalar_t>();
+  auto ld = logits.stride(0);
+  auto seeds = state.seeds.data_ptr<int64_t>();
+  auto counters = state.counters.data_ptr<int64_t>();
+  auto& params = state.params;
+  bool greedy = params.temperature <= 0;
+  float inv_temperature = greedy ? 1.f : 1.f / params.temperature;
+  float penalty = params.repetition_penalty;
+  bool online_softmax = !greedy && !state.gumbel;
+  int64_t num_threads = state.candidates.size() / B;
+
+  auto num_chunks = (n + kSamplingChunkSize - 1) / kSamplingChunkSize;
+  at::parallel_for(0, B * num_chunks, 1, [&](int64_t begin, int64_t end) {
+    int64_t tid = at::get_thread_num();
+    TORCH_CHECK(tid < num_threads, "sampling: more threads than at init");
+    for (int64_t i = begin; i < end; i++) {
+      auto b = i / num_chunks;
+      auto c0 = (i % num_chunks) * kSamplingChunkSize;
+      auto c1 = std::min(c0 + kSamplingChunkSize, n);
+      auto& cand = state.candidates[tid * B + b];
+      auto row = logits_ptr + b * ld;
+      auto& penalized = state.penalized_tokens[b];
+      auto penalized_it =
+          std::lower_bound(penalized.begin(), penalized.end(), offset + c0);
+      // 4 numbers per counter of Philox, the noise of token t is number
+      // t % 4 of counter t / 4
+      at::Philox4_32 engine(seeds[b], counters[b], (offset + c0) / 4);
+      if (state.gumbel) {
+        for (int64_t k = 0; k < (offset + c0) % 4; k++) {
+          engine();
+        }
+      }
+      auto max = cand.max;
+      auto sum = cand.sum;
+      for (int64_t j = c0; j < c1; j++) {
+        auto token = offset + j;
+        float v = static_cast<float>(row[j]);
+        if (penalized_it != penalized.end() && *penalized_it == token) {
+          v = v > 0 ? v / penalty : v * penalty;
+          ++penalized_it;
+        }
+        v *= inv_temperature;
+        if (state.gumbel) {
+          v -= std::log(-std::log(uniform(engine)));
+        }
+        if (online_softmax && !std::isinf(v)) {
+          if (v > max) {
+            sum = sum * std::exp(max - v) + 1.f;
+            max = v;
+          } else {
+            sum += std::exp(v - max);
+          }
+        }
+        push_candidate(cand.heap, state.num_candidates, v, token);
+      }
+      cand.max = max;
+      cand.sum = sum;
+    }
+  });
+}
+
+void sampling_update_kernel_impl(
+    SamplingState& state,
+    const at::Tensor& logits,
+    int64_t offset) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::kBFloat16, at::kHalf, logits.scalar_type(), "sampling_update", [&] {
+        sampling_update<scalar_t>(state, logits, offset);
+      });
+}
+
+at::Tensor sampling_finish_kernel_impl(SamplingState& state) {
+  auto B = state.batch_size;
+  int64_t num_threads = B > 0 ? state.candidates.size() / B : 0;
+  auto& params = state.params;
+  bool greedy = params.temperature <= 0;
+  auto seeds = state.seeds.data_ptr<int64_t>();
+  auto counters = state.counters.data_ptr<int64_t>();
+  auto tokens = at::zeros({B}, at::kLong);
+  auto tokens_ptr = tokens.data_ptr<int64_t>();
+
+  at::parallel_for(0, B, 1, [&](int64_t begin, int64_t end) {
+    std::vector<Candidate> merged;
+    std::vector<double> probs;
+    for (int64_t b = begin; b < end; b++) {
+      merged.clear();
+      float max = -std::numeric_limits<float>::infinity();
+      for (int64_t t = 0; t < num_threads; t++) {
+        auto& cand = state.candidates[t * B + b];
+        merged.insert(merged.end(), cand.heap.begin(), cand.heap.end());
+        max = std::max(max, cand.max);
+      }
+      double sum = 0;
+      for (int64_t t = 0; t < num_threads; t++) {
+        auto& cand = state.candidates[t * B + b];
+        if (cand.sum > 0) {
+          sum += cand.sum * std::exp(static_cast<double>(cand.max - max));
+        }
+      }
+      int64_t k = std::min<int64_t>(state.num_candidates, merged.size());
+      if (k == 0) {
+        continue;
+      }
+      std::partial_sort(
+          merged.begin(), merged.begin() + k, merged.end(), better);
+      if (greedy || state.gumbel) {
+        tokens_ptr[b] = merged[0].second;
+        continue;
+      }
+
+      // Probabilities relative to that of the best candidate
+      auto top = merged[0].first;
+      probs.resize(k);
+      double candidates_sum = 0;
+      for (int64_t i = 0; i < k; i++) {
+        probs[i] = std::exp(static_cast<double>(merged[i].first - top));
+        candidates_sum += probs[i];
+      }
+      // top-p is over the top-k tokens with top-k, otherwise over the vocab
+      double denom = params.top_k > 0
+          ? candidates_sum
+          : sum * std::exp(static_cast<double>(max - top));
+      int64_t kept = k;
+      if (params.top_p < 1) {
+        double cum = 0;
+        for (int64_t i = 0; i < k; i++) {
+          cum += probs[i] / denom;
+          if (cum >= params.top_p) {
+            kept = i + 1;
+            break;
+          }
+        }
+      }
+      if (params.min_p > 0) {
+        for (int64_t i = 1; i < kept; i++) {
+          if (probs[i] < params.min_p) {
+            kept = i;
+            break;
+          }
+        }
+      }
+
+      double total = 0;
+      for (int64_t i = 0; i < kept; i++) {
+        total += probs[i];
+      }
+      at::Philox4_32 engine(seeds[b], counters[b], 0);
+      auto u = uniform(engine) * total;
+      int64_t picked = kept - 1;
+      double cum = 0;
+      for (int64_t i = 0; i < kept; i++) {
+        cum += probs[i];
+        if (u < cum) {
+          picked = i;
+          break;
+        }
+      }
+      tokens_ptr[b] = merged[picked].second;
+    }
+  });
+  return tokens;
+}
+
+} // anonymous namespace
+
+IPEX_REGISTER_DISPATCH(
+    sampling_update_kernel_stub,
+    &sampling_update_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    sampling_finish_kernel_stub,
+    &sampling_finish_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,112 @@
+#include <ATen/Parallel.h>
+#include <aten/ShmAllReduce.h>
+
+#include "vec/vec.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// Elements of one task of the reduction. Decode messages are reduced by a
+// single thread.
+constexpr int64_t kReduceGrainSize = 16384;
+
+template <typename scalar_t>
+void reduce_ref(
+    scalar_t* out,
+    const std::vector<scalar_t*>& ins,
+    int64_t begin,
+    int64_t end) {
+  for (int64_t i = begin; i < end; i++) {
+    float acc = static_cast<float>(ins[0][i]);
+    for (size_t j = 1; j < ins.size(); j++) {
+      acc += static_cast<float>(ins[j][i]);
+    }
+    out[i] = static_cast<scalar_t>(acc);
+  }
+}
+
+#if defined(CPU_CAPABILITY_AVX512)
+inline __m512 load_fp32(const float* p) {
+  return _mm512_loadu_ps(p);
+}
+
+inline __m512 load_fp32(const at::BFloat16* p) {
+  return cvt_bf16_to_fp32(_mm256_loadu_si256((const __m256i*)p));
+}
+
+inline __m512 load_fp32(const at::Half* p) {
+  return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)p));
+}
+
+inline void store_fp32(float* p, __m512 v) {
+  _mm512_storeu_ps(p, v);
+}
+
+inline void store_fp32(at::BFloat16* p, __m512 v) {
+  _mm256_storeu_si256((__m256i*)p, cvt_fp32_to_bf16(v));
+}
+
+inline void store_fp32(at::Half* p, __m512 v) {
+  _mm256_storeu_si256(
+      (__m256i*)p, _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+
+// Low precision inputs are accumulated in fp32 and rounded once
+template <typename scalar_t>
+void reduce_avx512(
+    scalar_t* out,
+    const std::vector<scalar_t*>& ins,
+    int64_t begin,
+    int64_t end) {
+  int64_t i = begin;
+  for (; i + 16 <= end; i += 16) {
+    auto acc = load_fp32(ins[0] + i);
+    for (size_t j = 1; j < ins.size(); j++) {
+      acc = _mm512_add_ps(acc, load_fp32(ins[j] + i));
+    }
+    store_fp32(out + i, acc);
+  }
+  reduce_ref(out, ins, i, end);
+}
+#endif
+
+template <typename scalar_t>
+void reduce(char* out, const std::vector<char*>& ins, int64_t numel) {
+  std::vector<scalar_t*> in_ptrs;
+  for (auto in : ins) {
+    in_ptrs.push_back(reinterpret_cast<scalar_t*>(in));
+  }
+  auto out_ptr = reinterpret_cast<scalar_t*>(out);
+  at::parallel_for(0, numel, kReduceGrainSize, [&](int64_t begin, int64_t end) {
+#if defined(CPU_CAPABILITY_AVX512)
+    reduce_avx512(out_ptr, in_ptrs, begin, end);
+#else
+    reduce_ref(out_ptr, in_ptrs, begin, end);
+#endif
+  });
+}
+
+void shm_reduce_kernel_impl(
+    char* out,
+    const std::vector<char*>& ins,
+    int64_t numel,
+    at::ScalarType dtype) {
+  if (dtype == at::kFloat) {
+    reduce<float>(out, ins, numel);
+  } else if (dtype == at::kBFloat16) {
+    reduce<at::BFloat16>(out, ins, numel);
+  } else if (dtype == at::kHalf) {
+    reduce<at::Half>(out, ins, numel);
+  } else {
+    TORCH_CHECK(false, "shm_all_reduce: unsupported dtype ", dtype);
+  }
+}
+
+} // anonymous namespace
+
+IPEX_REGISTER_DISPATCH(shm_reduce_kernel_stub, &shm_reduce_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
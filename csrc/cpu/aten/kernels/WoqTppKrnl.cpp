@@ -5,7 +5,10 @@
 #include <ATen/cpu/vec/functional.h>
 #include <ATen/cpu/vec/vec.h>
 #include <aten/Linear.h>
+#include <aten/utils/woq_tuning.h>
+#include <numeric>
 #include "csrc/cpu/tpp/woq/tla.h"
+#include "utils/kernel_profiler.h"
 
 #ifdef __GNUC__
 #include <features.h>
@@ -34,13 +37,89 @@ using TensorList = std::vector<at::Tensor>;
 #define QINT8 1
 #define QINT4 2
 #define NF4 3
+// MX (microscaling) formats: FP4 (E2M1) codes are packed two per byte as int4,
+// FP6 (E2M3) codes four in three bytes in the bit planes of INT2 and FP8
+// (E4M3) codes take one byte each as int8. The E8M0 block scales are converted
+// to float at prepacking.
+#define MXFP4 4
+#define MXFP6 5
+#define MXFP8 6
+// Asymmetric 2-bit and 3-bit integers, packed in bit planes, see
+// load_dequant_zp_only_lowbit
+#define INT2 7
+#define INT3 8
+
+constexpr bool is_mx(const int qw_type) {
+  return qw_type == MXFP4 || qw_type == MXFP6 || qw_type == MXFP8;
+}
 
 constexpr bool is_4bit(const int qw_type) {
-  return qw_type == QINT4 || qw_type == NF4;
+  return qw_type == QINT4 || qw_type == NF4 || qw_type == MXFP4;
 }
 
 constexpr bool is_sym_quant(const int qw_type) {
-  return qw_type == NF4;
+  return qw_type == NF4 || is_mx(qw_type);
+}
+
+constexpr bool is_lowbit(const int qw_type) {
+  return qw_type == INT2 || qw_type == INT3;
+}
+
+// Codes packed in 2-bit planes, see load_dequant_zp_only_lowbit
+constexpr bool is_2bit_planes(const int qw_type) {
+  return is_lowbit(qw_type) || qw_type == MXFP6;
+}
+
+// Number of 2-bit planes of the codes: one for the low two bits of INT2 and
+// INT3, and three for bits 0-1, 2-3 and 4-5 of MXFP6
+constexpr int num_2bit_planes(const int qw_type) {
+  return qw_type == MXFP6 ? 3 : 1;
+}
+
+// Bits of the code of one weight element
+constexpr int qw_bits(const int qw_type) {
+  return qw_type == INT2 ? 2
+      : qw_type == INT3  ? 3
+      : is_4bit(qw_type) ? 4
+      : qw_type == MXFP6 ? 6
+                         : 8;
+}
+
+// Get the value of `bits` bits at bit `pos` of a little-endian bitstream, or
+// add it to the zeroed bits there
+inline uint8_t get_bits(const uint8_t* p, long pos, int bits) {
+  int shift = pos % 8;
+  int word = p[pos / 8];
+  if (shift + bits > 8) {
+    word |= p[pos / 8 + 1] << 8;
+  }
+  return (word >> shift) & ((1 << bits) - 1);
+}
+
+inline void or_bits(uint8_t* p, long pos, int bits, uint8_t val) {
+  int shift = pos % 8;
+  p[pos / 8] |= val << shift;
+  if (shift + bits > 8) {
+    p[pos / 8 + 1] |= val >> (8 - shift);
+  }
+}
+
+// Values of `bits` bits packed along the last dim of qw as a little-endian
+// bitstream, [N, K * bits / 8] -> [N, K] in uint8, K being a multiple of 8
+at::Tensor unpack_bitstream(const at::Tensor& qw, int bits) {
+  // Each 8 values take `bits` bytes
+  auto N = qw.size(0);
+  auto bytes = qw.reshape({N, -1, bits}).to(at::kLong);
+  auto words = at::zeros({N, bytes.size(1)}, bytes.options());
+  for (int i = 0; i < bits; i++) {
+    words.bitwise_or_(bytes.select(-1, i).bitwise_left_shift(8 * i));
+  }
+  auto shifts = at::arange(0, 8 * bits, bits, bytes.options());
+  return words.unsqueeze(-1)
+      .bitwise_right_shift(shifts)
+      .bitwise_and((1 << bits) - 1)
+      .view({N, -1})
+      .to(at::kByte);
 }
 
 uint8_t quantize_nf4_scalar(float x) {
@@ -127,6 +206,30 @@ float dequantize_nf4_scalar(uint8_t val) {
     return -1.0f;
 }
 
+float dequantize_mx_scalar(uint8_t val, int qw_type) {
+  const int ebits = qw_type == MXFP8 ? 4 : 2;
+  const int mbits = qw_type == MXFP4 ? 1 : 3;
+  const int bias = (1 << (ebits - 1)) - 1;
+  int exp = (val >> mbits) & ((1 << ebits) - 1);
+  int man = val & ((1 << mbits) - 1);
+  // subnormal if the exponent is 0
+  float ret = exp == 0
+      ? std::ldexp((float)man, 1 - bias - mbits)
+      : std::ldexp((float)((1 << mbits) | man), exp - bias - mbits);
+  return (val >> (ebits + mbits)) & 1 ? -ret : ret;
+}
+
+// Decode the MX element codes in uint8 or int8 to float
+at::Tensor dequantize_mx(const at::Tensor& codes, int qw_type) {
+  const int num_codes = qw_type == MXFP4 ? 16 : (qw_type == MXFP6 ? 64 : 256);
+  std::vector<float> lut(num_codes);
+  for (int i = 0; i < num_codes; i++) {
+    lut[i] = dequantize_mx_scalar(i, qw_type);
+  }
+  auto idx = codes.to(at::kLong).bitwise_and(num_codes - 1);
+  return at::tensor(lut, at::kFloat).index({idx});
+}
+
 // We only build optimized kernels if AVX512_FP16 is supported and gcc>=12.3
 // Otherwise we just return empty results
 // TODO(Weiwen) Merge WoqTppKrnl.cpp and WoqLinearKrnl.cpp and put the latter in
@@ -134,8 +237,8 @@ float dequantize_nf4_scalar(uint8_t val) {
 #if defined(CPU_CAPABILITY_AVX512_FP16) && defined(COMPILER_PREREQ_MET)
 
 #define SMALL_BATCH_THRESHOLD 32
-#define PARALLEL_M_THRESHOLD 128
-constexpr long PREFETCH_K_DIST = 64; // TODO(jgong5): do not hard-code
+// Defaults of the parameters tunable at runtime, see WoqTuningConfig
+constexpr long PREFETCH_K_DIST = 64;
 constexpr long LOOP_K_UNROLL = 4; // TODO(jgong5): do not hard-code
 
 #define UNQUANT_A -1
@@ -147,6 +250,143 @@ constexpr long LOOP_K_UNROLL = 4; // TODO(jgong5): do not hard-code
 #define QUANT_W_PER_CHANNEL 0
 #define QUANT_W_PER_K_BLOCK 1
 
+// Convert codes of one byte to float or half. For the MX formats, the
+// exponent and mantissa bits are moved to those of float or half and the
+// exponent is rebiased with an integer add. Subnormal codes are decoded as
+// normal ones with exponent 1 and the implicit leading one subtracted
+// afterwards, so that no denormal is involved. The NaN codes of E4M3 are not
+// handled, they are never produced by quantization.
+template <int qw_type>
+struct mx_8bit_traits {
+  static_assert(qw_type == MXFP6 || qw_type == MXFP8, "not an E*M3 MX type");
+  static constexpr int ebits = qw_type == MXFP8 ? 4 : 2;
+  static constexpr int mbits = 3;
+  static constexpr int bias = (1 << (ebits - 1)) - 1;
+  static constexpr int mag_bits = ebits + mbits;
+  // 2^(1 - bias), the implicit leading one of subnormals
+  static constexpr float min_normal = qw_type == MXFP8 ? 0.015625f : 1.0f;
+};
+
+#ifdef __AVX512F__
+// MX codes in the 32-bit lanes of codes
+template <int qw_type>
+inline __m512 cvt_mx_to_ps(__m512i codes) {
+  using traits = mx_8bit_traits<qw_type>;
+  auto mag =
+      _mm512_and_si512(codes, _mm512_set1_epi32((1 << traits::mag_bits) - 1));
+  auto implicit_one = _mm512_set1_epi32(1 << traits::mbits);
+  auto subnormal = _mm512_cmplt_epi32_mask(mag, implicit_one);
+  mag = _mm512_mask_or_epi32(mag, subnormal, mag, implicit_one);
+  auto v = _mm512_castsi512_ps(_mm512_add_epi32(
+      _mm512_slli_epi32(mag, 23 - traits::mbits),
+      _mm512_set1_epi32((127 - traits::bias) << 23)));
+  v = _mm512_mask_sub_ps(v, subnormal, v, _mm512_set1_ps(traits::min_normal));
+  auto sign =
+      _mm512_slli_epi32(_mm512_srli_epi32(codes, traits::mag_bits), 31);
+  return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(v), sign));
+}
+
+template <int qw_type>
+inline __m512 cvt_8bit_to_ps(__m128i packed) {
+  if constexpr (!is_mx(qw_type)) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(packed));
+  } else {
+    return cvt_mx_to_ps<qw_type>(_mm512_cvtepu8_epi32(packed));
+  }
+}
+#endif
+
+#ifdef __AVX512FP16__
+// MX codes in the 16-bit lanes of codes
+template <int qw_type>
+inline __m512h cvt_mx_to_ph(__m512i codes) {
+  using traits = mx_8bit_traits<qw_type>;
+  auto mag =
+      _mm512_and_si512(codes, _mm512_set1_epi16((1 << traits::mag_bits) - 1));
+  auto implicit_one = _mm512_set1_epi16(1 << traits::mbits);
+  auto subnormal = _mm512_cmplt_epi16_mask(mag, implicit_one);
+  mag = _mm512_or_si512(mag, _mm512_maskz_mov_epi16(subnormal, implicit_one));
+  auto v = _mm512_castsi512_ph(_mm512_add_epi16(
+      _mm512_slli_epi16(mag, 10 - traits::mbits),
+      _mm512_set1_epi16((15 - traits::bias) << 10)));
+  v = _mm512_mask_sub_ph(
+      v, subnormal, v, _mm512_set1_ph((_Float16)traits::min_normal));
+  auto sign =
+      _mm512_slli_epi16(_mm512_srli_epi16(codes, traits::mag_bits), 15);
+  return _mm512_castsi512_ph(_mm512_or_si512(_mm512_castph_si512(v), sign));
+}
+
+template <int qw_type>
+inline __m512h cvt_8bit_to_ph(__m256i packed) {
+  if constexpr (!is_mx(qw_type)) {
+    return _mm512_cvtepi16_ph(_mm512_cvtepi8_epi16(packed));
+  } else {
+    return cvt_mx_to_ph<qw_type>(_mm512_cvtepu8_epi16(packed));
+  }
+}
+#endif
+
+// Convert INT2, INT3 or MXFP6 codes to float or half. The 2-bit pieces of the
+// codes are the low two bits of the lanes of `planes`, the third bit of INT3
+// that of the lane in `high_bits`.
+#ifdef __AVX512F__
+template <int qw_type>
+inline __m512 cvt_lowbit_to_ps(
+    std::array<__m512i, num_2bit_planes(qw_type)> planes,
+    __mmask16 high_bits) {
+  auto mask = _mm512_set1_epi32(3);
+  auto codes = _mm512_and_si512(planes[0], mask);
+  if constexpr (qw_type == MXFP6) {
+    codes = _mm512_or_si512(
+        codes, _mm512_slli_epi32(_mm512_and_si512(planes[1], mask), 2));
+    codes = _mm512_or_si512(
+        codes, _mm512_slli_epi32(_mm512_and_si512(planes[2], mask), 4));
+    return cvt_mx_to_ps<qw_type>(codes);
+  } else {
+    if constexpr (qw_type == INT3) {
+      codes =
+          _mm512_mask_or_epi32(codes, high_bits, codes, _mm512_set1_epi32(4));
+    }
+    return _mm512_cvtepi32_ps(codes);
+  }
+}
+#endif
+
+#ifdef __AVX512FP16__
+template <int qw_type>
+inline __m512h cvt_lowbit_to_ph(
+    std::array<__m512i, num_2bit_planes(qw_type)> planes,
+    __mmask32 high_bits) {
+  auto mask = _mm512_set1_epi16(3);
+  auto codes = _mm512_and_si512(planes[0], mask);
+  if constexpr (qw_type == MXFP6) {
+    codes = _mm512_or_si512(
+        codes, _mm512_slli_epi16(_mm512_and_si512(planes[1], mask), 2));
+    codes = _mm512_or_si512(
+        codes, _mm512_slli_epi16(_mm512_and_si512(planes[2], mask), 4));
+    return cvt_mx_to_ph<qw_type>(codes);
+  } else {
+    if constexpr (qw_type == INT3) {
+      // There is no masked or of 16-bit lanes, and bit 2 is clear to add to
+      codes =
+          _mm512_mask_add_epi16(codes, high_bits, codes, _mm512_set1_epi16(4));
+    }
+    return _mm512_cvtepi16_ph(codes);
+  }
+}
+#endif
+
+// Third bits of the INT3 codes of vector idx of a group, each vector taking
+// the bits of one mask
+template <typename MaskT, long N_GROUP_SIZE, int qw_type>
+inline MaskT load_int3_high_bits(uint8_t* p, long idx) {
+  if constexpr (qw_type == INT3) {
+    return reinterpret_cast<MaskT*>(p + N_GROUP_SIZE / 4)[idx];
+  } else {
+    return 0;
+  }
+}
+
 template <long N_GROUP_SIZE, bool sym_quant>
 struct load_dequant_zp_only_4bit {
   template <typename LUT, typename VAT>
@@ -155,7 +395,8 @@ struct load_dequant_zp_only_4bit {
   }
 };
 
-template <long N_GROUP_SIZE, bool sym_quant>
+// Load codes of one byte, i.e. int8 or MXFP8
+template <long N_GROUP_SIZE, bool sym_quant, int qw_type = QINT8>
 struct load_dequant_zp_only_int8 {
   template <typename VAT>
   static inline VAT call(uint8_t* p, VAT vzps) {
@@ -163,6 +404,22 @@ struct load_dequant_zp_only_int8 {
   }
 };
 
+// Load INT2, INT3 or MXFP6 codes. The codes of a group of N_GROUP_SIZE
+// columns take 2-bit planes of N_GROUP_SIZE / 4 bytes, whose byte j holds two
+// bits of the columns j + i * N_GROUP_SIZE / 4 at bit 2 * i. INT2 and INT3
+// take one plane for the low two bits, followed for INT3 by a plane of
+// N_GROUP_SIZE / 8 bytes holding the third bit of column c at bit c. MXFP6
+// takes three planes for bits 0-1, 2-3 and 4-5, i.e. four codes in three
+// bytes. The 2-bit pieces of the columns of a vector are then shifts of the
+// same bytes, and the third bits are the masks of a masked or.
+template <long N_GROUP_SIZE, bool sym_quant, int qw_type>
+struct load_dequant_zp_only_lowbit {
+  template <typename VAT>
+  static inline VAT call(uint8_t* p, VAT vzps) {
+    TLA_ASSERT(false, "not implemented");
+  }
+};
+
 template <bool sym_quant>
 struct load_dequant_zp_only_4bit<64, sym_quant> {
 // TODO(jgong5): further simplify the dequant intrinsics below with VecOps
@@ -229,8 +486,8 @@ struct load_dequant_zp_only_4bit<64, sym_quant> {
 #endif
 };
 
-template <bool sym_quant>
-struct load_dequant_zp_only_int8<64, sym_quant> {
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_int8<64, sym_quant, qw_type> {
 // TODO(jgong5): further simplify the dequant intrinsics below with VecOps
 #ifdef __AVX512F__
   static inline std::array<__m512, 4> call(
@@ -245,7 +502,7 @@ struct load_dequant_zp_only_int8<64, sym_quant> {
     compile_time_for<COLS>::op([&](auto i) {
       constexpr long imm = i;
       auto int8 = _mm512_extracti32x4_epi32(packed, imm);
-      vbs[i] = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(int8));
+      vbs[i] = cvt_8bit_to_ps<qw_type>(int8);
       if constexpr (!sym_quant) {
         vbs[i] = _mm512_sub_ps(vbs[i], vzps[i]);
       }
@@ -267,7 +524,7 @@ struct load_dequant_zp_only_int8<64, sym_quant> {
     compile_time_for<COLS>::op([&](auto i) {
       constexpr long imm = i;
       auto int8 = _mm512_extracti64x4_epi64(packed, imm);
-      vbs[i] = _mm512_cvtepi16_ph(_mm512_cvtepi8_epi16(int8));
+      vbs[i] = cvt_8bit_to_ph<qw_type>(int8);
       if constexpr (!sym_quant) {
         vbs[i] = _mm512_sub_ph(vbs[i], vzps[i]);
       }
@@ -337,8 +594,8 @@ struct load_dequant_zp_only_4bit<32, sym_quant> {
 #endif
 };
 
-template <bool sym_quant>
-struct load_dequant_zp_only_int8<32, sym_quant> {
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_int8<32, sym_quant, qw_type> {
 #ifdef __AVX512F__
   static inline std::array<__m512, 2> call(
       uint8_t* p,
@@ -352,7 +609,7 @@ struct load_dequant_zp_only_int8<32, sym_quant> {
     compile_time_for<COLS>::op([&](auto i) {
       constexpr long imm = i;
       auto int8 = _mm256_extracti128_si256(packed, imm);
-      vbs[i] = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(int8));
+      vbs[i] = cvt_8bit_to_ps<qw_type>(int8);
       if constexpr (!sym_quant) {
         vbs[i] = _mm512_sub_ps(vbs[i], vzps[i]);
       }
@@ -373,7 +630,7 @@ struct load_dequant_zp_only_int8<32, sym_quant> {
     VAT vbs;
     compile_time_for<COLS>::op([&](auto i) {
       constexpr long imm = i;
-      vbs[i] = _mm512_cvtepi16_ph(_mm512_cvtepi8_epi16(packed));
+      vbs[i] = cvt_8bit_to_ph<qw_type>(packed);
       if constexpr (!sym_quant) {
         vbs[i] = _mm512_sub_ph(vbs[i], vzps[i]);
       }
@@ -418,8 +675,8 @@ struct load_dequant_zp_only_4bit<16, sym_quant> {
 #endif
 };
 
-template <bool sym_quant>
-struct load_dequant_zp_only_int8<16, sym_quant> {
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_int8<16, sym_quant, qw_type> {
 #ifdef __AVX512F__
   static inline std::array<__m512, 1> call(
       uint8_t* p,
@@ -431,7 +688,172 @@ struct load_dequant_zp_only_int8<16, sym_quant> {
     static_assert(COLS == 1);
     auto packed = _mm_loadu_si128((__m128i*)p);
     VAT vbs;
-    vbs[0] = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(packed));
+    vbs[0] = cvt_8bit_to_ps<qw_type>(packed);
+    if constexpr (!sym_quant) {
+      vbs[0] = _mm512_sub_ps(vbs[0], vzps[0]);
+    }
+    return vbs;
+  }
+#endif
+
+#ifdef __AVX512FP16__
+  static inline std::array<__m512h, 0> call(
+      uint8_t* p,
+      std::array<__m512h, 0> vzps) {
+    TLA_ASSERT(false, "not implemented");
+  }
+#endif
+};
+
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_lowbit<64, sym_quant, qw_type> {
+#ifdef __AVX512F__
+  static inline std::array<__m512, 4> call(
+      uint8_t* p,
+      std::array<__m512, 4> vzps) {
+    using T = float;
+    using VA = VecArray<64, T>;
+    using VAT = typename VA::type;
+    constexpr long COLS = VA::num_vec;
+    constexpr int PLANES = num_2bit_planes(qw_type);
+    // lane j of vector i: bits 2 * i of byte j
+    std::array<__m512i, PLANES> codes;
+    for (int j = 0; j < PLANES; j++) {
+      codes[j] = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(p + 16 * j)));
+    }
+    VAT vbs;
+    compile_time_for<COLS>::op([&](auto i) {
+      constexpr long shift = 2 * i;
+      std::array<__m512i, PLANES> planes;
+      for (int j = 0; j < PLANES; j++) {
+        planes[j] = _mm512_srli_epi32(codes[j], shift);
+      }
+      vbs[i] = cvt_lowbit_to_ps<qw_type>(
+          planes, load_int3_high_bits<__mmask16, 64, qw_type>(p, i));
+      if constexpr (!sym_quant) {
+        vbs[i] = _mm512_sub_ps(vbs[i], vzps[i]);
+      }
+    });
+    return vbs;
+  }
+#endif
+
+#ifdef __AVX512FP16__
+  static inline std::array<__m512h, 2> call(
+      uint8_t* p,
+      std::array<__m512h, 2> vzps) {
+    using T = tpp::half;
+    using VA = VecArray<64, T>;
+    using VAT = typename VA::type;
+    constexpr long COLS = VA::num_vec;
+    constexpr int PLANES = num_2bit_planes(qw_type);
+    // lane j < 16 of vector i: bits 4 * i of byte j, lane j >= 16: bits
+    // 4 * i + 2 of byte j - 16
+    std::array<__m512i, PLANES> codes;
+    for (int j = 0; j < PLANES; j++) {
+      auto packed = _mm_loadu_si128((__m128i*)(p + 16 * j));
+      codes[j] = _mm512_cvtepu8_epi16(_mm256_inserti128_si256(
+          _mm256_castsi128_si256(packed), _mm_srli_epi16(packed, 2), 1));
+    }
+    VAT vbs;
+    compile_time_for<COLS>::op([&](auto i) {
+      constexpr long shift = 4 * i;
+      std::array<__m512i, PLANES> planes;
+      for (int j = 0; j < PLANES; j++) {
+        planes[j] = _mm512_srli_epi16(codes[j], shift);
+      }
+      vbs[i] = cvt_lowbit_to_ph<qw_type>(
+          planes, load_int3_high_bits<__mmask32, 64, qw_type>(p, i));
+      if constexpr (!sym_quant) {
+        vbs[i] = _mm512_sub_ph(vbs[i], vzps[i]);
+      }
+    });
+    return vbs;
+  }
+#endif
+};
+
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_lowbit<32, sym_quant, qw_type> {
+#ifdef __AVX512F__
+  static inline std::array<__m512, 2> call(
+      uint8_t* p,
+      std::array<__m512, 2> vzps) {
+    using T = float;
+    using VA = VecArray<32, T>;
+    using VAT = typename VA::type;
+    constexpr long COLS = VA::num_vec;
+    constexpr int PLANES = num_2bit_planes(qw_type);
+    // lane j < 8 of vector i: bits 4 * i of byte j, lane j >= 8: bits
+    // 4 * i + 2 of byte j - 8
+    std::array<__m512i, PLANES> codes;
+    for (int j = 0; j < PLANES; j++) {
+      uint64_t packed = reinterpret_cast<uint64_t*>(p)[j];
+      codes[j] = _mm512_cvtepu8_epi32(_mm_set_epi64x(packed >> 2, packed));
+    }
+    VAT vbs;
+    compile_time_for<COLS>::op([&](auto i) {
+      constexpr long shift = 4 * i;
+      std::array<__m512i, PLANES> planes;
+      for (int j = 0; j < PLANES; j++) {
+        planes[j] = _mm512_srli_epi32(codes[j], shift);
+      }
+      vbs[i] = cvt_lowbit_to_ps<qw_type>(
+          planes, load_int3_high_bits<__mmask16, 32, qw_type>(p, i));
+      if constexpr (!sym_quant) {
+        vbs[i] = _mm512_sub_ps(vbs[i], vzps[i]);
+      }
+    });
+    return vbs;
+  }
+#endif
+
+#ifdef __AVX512FP16__
+  static inline std::array<__m512h, 1> call(
+      uint8_t* p,
+      std::array<__m512h, 1> vzps) {
+    using T = tpp::half;
+    using VA = VecArray<32, T>;
+    using VAT = typename VA::type;
+    // lane j of 8 * i + j: bits 2 * i of byte j
+    constexpr int PLANES = num_2bit_planes(qw_type);
+    std::array<__m512i, PLANES> planes;
+    for (int j = 0; j < PLANES; j++) {
+      uint64_t packed = reinterpret_cast<uint64_t*>(p)[j];
+      planes[j] = _mm512_cvtepu8_epi16(
+          _mm256_set_epi64x(packed >> 6, packed >> 4, packed >> 2, packed));
+    }
+    VAT vbs;
+    vbs[0] = cvt_lowbit_to_ph<qw_type>(
+        planes, load_int3_high_bits<__mmask32, 32, qw_type>(p, 0));
+    if constexpr (!sym_quant) {
+      vbs[0] = _mm512_sub_ph(vbs[0], vzps[0]);
+    }
+    return vbs;
+  }
+#endif
+};
+
+template <bool sym_quant, int qw_type>
+struct load_dequant_zp_only_lowbit<16, sym_quant, qw_type> {
+#ifdef __AVX512F__
+  static inline std::array<__m512, 1> call(
+      uint8_t* p,
+      std::array<__m512, 1> vzps) {
+    using T = float;
+    using VA = VecArray<16, T>;
+    using VAT = typename VA::type;
+    constexpr int PLANES = num_2bit_planes(qw_type);
+    // lane 4 * i + j: bits 2 * i of byte j
+    std::array<__m512i, PLANES> planes;
+    for (int j = 0; j < PLANES; j++) {
+      uint32_t packed = reinterpret_cast<uint32_t*>(p)[j];
+      planes[j] = _mm512_cvtepu8_epi32(
+          _mm_set_epi32(packed >> 6, packed >> 4, packed >> 2, packed));
+    }
+    VAT vbs;
+    vbs[0] = cvt_lowbit_to_ps<qw_type>(
+        planes, load_int3_high_bits<__mmask16, 16, qw_type>(p, 0));
     if constexpr (!sym_quant) {
       vbs[0] = _mm512_sub_ps(vbs[0], vzps[0]);
     }
@@ -543,7 +965,7 @@ struct load_dequant_4bit {
   }
 };
 
-template <long N, bool sym_quant, typename T>
+template <long N, bool sym_quant, typename T, int qw_type = QINT8>
 struct load_dequant_int8 {
   using VT = typename VecType<T>::type;
   using V = VecOps<VT>;
@@ -552,7 +974,25 @@ struct load_dequant_int8 {
   constexpr static long COLS = VA::num_vec;
 
   static inline VAT call(uint8_t* p, VAT vscales, VAT vzps) {
-    auto vbs = load_dequant_zp_only_int8<N, sym_quant>::call(p, vzps);
+    auto vbs =
+        load_dequant_zp_only_int8<N, sym_quant, qw_type>::call(p, vzps);
+    compile_time_for<COLS>::op(
+        [&](auto idx) { vbs[idx] = V::mul(vbs[idx], vscales[idx]); });
+    return vbs;
+  }
+};
+
+template <long N, bool sym_quant, typename T, int qw_type>
+struct load_dequant_lowbit {
+  using VT = typename VecType<T>::type;
+  using V = VecOps<VT>;
+  using VA = VecArray<N, T>;
+  using VAT = typename VA::type;
+  constexpr static long COLS = VA::num_vec;
+
+  static inline VAT call(uint8_t* p, VAT vscales, VAT vzps) {
+    auto vbs =
+        load_dequant_zp_only_lowbit<N, sym_quant, qw_type>::call(p, vzps);
     compile_time_for<COLS>::op(
         [&](auto idx) { vbs[idx] = V::mul(vbs[idx], vscales[idx]); });
     return vbs;
@@ -563,6 +1003,13 @@ constexpr int get_n_group_size(int N) {
   return N == 16 ? 16 : (N == 32 ? 32 : 64);
 }
 
+// Codes of the columns from n of row k of a [K, ldb] block of weight codes,
+// n being a multiple of the N group size
+template <int qw_type>
+inline uint8_t* qw_address(uint8_t* qB, long k, long n, long ldb) {
+  return qB + (k * ldb + n) * qw_bits(qw_type) / 8;
+}
+
 // TODO(jgong5): move to tpp.h
 // TODO(jgong5): add pre/post op fusion
 template <
@@ -588,7 +1035,8 @@ struct GemmMicroKernel {
       Tout* C,
       long ldc,
       TScale* scales,
-      TZero* zps) {
+      TZero* zps,
+      long prefetch_k_dist = PREFETCH_K_DIST) {
     TLA_ASSERT(false, "Not implemented");
   }
 };
@@ -626,7 +1074,8 @@ struct GemmMicroKernel<
       T* C,
       long ldc,
       T* scales,
-      T* zps) {
+      T* zps,
+      long prefetch_k_dist = PREFETCH_K_DIST) {
 #define INDEX(x, y, ld) ((x) * (ld) + (y))
 #define ADDRESS(p, x, y, ld) ((p) + (x) * (ld) + (y))
 
@@ -650,9 +1099,12 @@ struct GemmMicroKernel<
 
     VT lut;
     constexpr bool is_4bit_flag = is_4bit(qw_type);
+    constexpr bool is_2bit_planes_flag = is_2bit_planes(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
     if constexpr (is_4bit_flag) {
-      lut = qw_type == NF4 ? V::set_nf4_lut() : V::set_0_to_15();
+      lut = qw_type == NF4 ? V::set_nf4_lut()
+          : qw_type == MXFP4 ? V::set_mxfp4_lut()
+                             : V::set_0_to_15();
     }
 
     // Load scales and zps
@@ -667,7 +1119,8 @@ struct GemmMicroKernel<
     // NB: For fp16 in int8 woq, we do not delay the scale to the post-op but
     // leave it to the dequant otherwise the weight value might be too large to
     // overflow fp16 range.
-    constexpr bool scale_as_post_op = !std::is_same<T, half>() || is_4bit_flag;
+    constexpr bool scale_as_post_op =
+        !std::is_same<T, half>() || qw_bits(qw_type) < 8;
 
     compile_time_for<M * COLS>::op([&](auto i) { vc[i] = V::setzero(); });
 
@@ -685,38 +1138,38 @@ struct GemmMicroKernel<
 
       if constexpr (row == 0) {
         constexpr const int col = cbidx * CBLOCK;
+        uint8_t* pB = qw_address<qw_type>(B, k, col * V::VLEN, ldb);
         if constexpr (scale_as_post_op) {
           if constexpr (is_4bit_flag) {
             vb[cbidx] =
                 load_dequant_zp_only_4bit<N_GROUP_SIZE, sym_quant>::call(
-                    ADDRESS(B, k, col * V::VLEN / 2, ldb / 2),
-                    lut,
-                    vzps[cbidx]);
+                    pB, lut, vzps[cbidx]);
+          } else if constexpr (is_2bit_planes_flag) {
+            vb[cbidx] = load_dequant_zp_only_lowbit<
+                N_GROUP_SIZE,
+                sym_quant,
+                qw_type>::call(pB, vzps[cbidx]);
           } else {
-            vb[cbidx] =
-                load_dequant_zp_only_int8<N_GROUP_SIZE, sym_quant>::call(
-                    ADDRESS(B, k, col * V::VLEN, ldb), vzps[cbidx]);
+            vb[cbidx] = load_dequant_zp_only_int8<
+                N_GROUP_SIZE,
+                sym_quant,
+                qw_type>::call(pB, vzps[cbidx]);
           }
         } else {
           if constexpr (is_4bit_flag) {
             vb[cbidx] = load_dequant_4bit<N_GROUP_SIZE, sym_quant, T>::call(
-                ADDRESS(B, k, col * V::VLEN / 2, ldb / 2),
-                vscales[cbidx],
-                lut,
-                vzps[cbidx]);
+                pB, vscales[cbidx], lut, vzps[cbidx]);
           } else {
-            vb[cbidx] = load_dequant_int8<N_GROUP_SIZE, sym_quant, T>::call(
-                ADDRESS(B, k, col * V::VLEN, ldb), vscales[cbidx], vzps[cbidx]);
+            vb[cbidx] =
+                load_dequant_int8<N_GROUP_SIZE, sym_quant, T, qw_type>::call(
+                    pB, vscales[cbidx], vzps[cbidx]);
           }
         }
         if constexpr (PREFETCH_K_DIST > 0) {
-          if constexpr (is_4bit_flag) {
+          if (prefetch_k_dist > 0) {
             _mm_prefetch(
-                ADDRESS(B, k + PREFETCH_K_DIST, col * V::VLEN / 2, ldb / 2),
-                _MM_HINT_T0);
-          } else {
-            _mm_prefetch(
-                ADDRESS(B, k + PREFETCH_K_DIST, col * V::VLEN, ldb),
+                qw_address<qw_type>(
+                    B, k + prefetch_k_dist, col * V::VLEN, ldb),
                 _MM_HINT_T0);
           }
         }
@@ -795,7 +1248,8 @@ struct GemmMicroKernel<
       int8_t* zps,
       float* scale_a,
       int32_t* zp_a,
-      int32_t k_groups) {
+      int32_t k_groups,
+      long prefetch_k_dist = PREFETCH_K_DIST) {
     TLA_ASSERT(zps, "Calculation of uint8 does not support symmetric quant.");
     auto pqB = GetVLAPtr<uint8_t>(B, {ldb, 2}); // [K/4,N,4] packed in 4-bit
 
@@ -838,7 +1292,10 @@ struct GemmMicroKernel<
         vb[col] = _mm512_sub_epi8(vb[col], vzps[col]);
         vcompensate[col] = _mm512_dpbusd_epi32(vcompensate[col], ones, vb[col]);
         if constexpr (PREFETCH_K_DIST > 0) {
-          _mm_prefetch(pqB[(k + PREFETCH_K_DIST) / 4][col * 16], _MM_HINT_T0);
+          if (prefetch_k_dist > 0) {
+            _mm_prefetch(
+                pqB[(k + prefetch_k_dist) / 4][col * 16], _MM_HINT_T0);
+          }
         }
       }
 
@@ -918,7 +1375,6 @@ struct dequant_n_grouped {
       const Lambda3& store) {
     using VA = VecArray<N_GROUP_SIZE, Tin>;
     using VAT = typename VA::type;
-    constexpr bool is_4bit_flag = is_4bit(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
     for (int n = 0; n < N; n += N_GROUP_SIZE) {
       // load scales and zps
@@ -930,9 +1386,7 @@ struct dequant_n_grouped {
       for (int k = 0; k < K; k++) {
         // load and dequant qB to vb
         auto vbs = load_qint_as_fp(
-            is_4bit_flag ? &qB[k * ldb / 2 + n / 2] : &qB[k * ldb + n],
-            vscales,
-            vzps);
+            qw_address<qw_type>(qB, k, n, ldb), vscales, vzps);
         // store vb to B
         store(B + k * N + n, vbs);
       }
@@ -959,7 +1413,6 @@ struct dequant_n_grouped<bfloat16, ldb, N_GROUP_SIZE, qw_type> {
     using VA = VecArray<N_GROUP_SIZE, float>;
     using VAT = typename VA::type;
     constexpr long COLS = VA::num_vec;
-    constexpr bool is_4bit_flag = is_4bit(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
 
     for (int n = 0; n < N; n += N_GROUP_SIZE) {
@@ -1011,15 +1464,10 @@ struct dequant_n_grouped<bfloat16, ldb, N_GROUP_SIZE, qw_type> {
                _mm512_permutex2var_ps(v0, idx_high, v1)});
         };
         // load and dequant qB to vb
-        auto vbs_k0 = load_qint_as_fp(
-            is_4bit_flag ? &qB[k * ldb / 2 + n / 2] : &qB[k * ldb + n],
-            vscales,
-            vzps);
+        auto vbs_k0 =
+            load_qint_as_fp(qw_address<qw_type>(qB, k, n, ldb), vscales, vzps);
         auto vbs_k1 = load_qint_as_fp(
-            is_4bit_flag ? &qB[(k + 1) * ldb / 2 + n / 2]
-                         : &qB[(k + 1) * ldb + n],
-            vscales,
-            vzps);
+            qw_address<qw_type>(qB, k + 1, n, ldb), vscales, vzps);
         typename VA::type vbs[2];
         compile_time_for<COLS>::op([&](auto i) {
           auto [low, high] = interleave(vbs_k0[i], vbs_k1[i]);
@@ -1068,7 +1516,9 @@ struct Dequantize<float, ldb, N_GROUP_SIZE, qw_type> {
     constexpr bool is_4bit_flag = is_4bit(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
     if constexpr (is_4bit_flag) {
-      lut = qw_type == NF4 ? V::set_nf4_lut() : V::set_0_to_15();
+      lut = qw_type == NF4 ? V::set_nf4_lut()
+          : qw_type == MXFP4 ? V::set_mxfp4_lut()
+                             : V::set_0_to_15();
     }
 
     dequant_n_grouped<float, ldb, N_GROUP_SIZE, qw_type>::call(
@@ -1083,9 +1533,12 @@ struct Dequantize<float, ldb, N_GROUP_SIZE, qw_type> {
           if constexpr (is_4bit_flag) {
             return load_dequant_4bit<N_GROUP_SIZE, sym_quant, T>::call(
                 p, vscales, lut, vzps);
+          } else if constexpr (is_2bit_planes(qw_type)) {
+            return load_dequant_lowbit<N_GROUP_SIZE, sym_quant, T, qw_type>::
+                call(p, vscales, vzps);
           } else {
-            return load_dequant_int8<N_GROUP_SIZE, sym_quant, T>::call(
-                p, vscales, vzps);
+            return load_dequant_int8<N_GROUP_SIZE, sym_quant, T, qw_type>::
+                call(p, vscales, vzps);
           }
         },
         [&](auto p, auto vbs) {
@@ -1122,7 +1575,9 @@ struct Dequantize<bfloat16, ldb, N_GROUP_SIZE, qw_type> {
     constexpr bool is_4bit_flag = is_4bit(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
     if constexpr (is_4bit_flag) {
-      lut = qw_type == NF4 ? V::set_nf4_lut() : V::set_0_to_15();
+      lut = qw_type == NF4 ? V::set_nf4_lut()
+          : qw_type == MXFP4 ? V::set_mxfp4_lut()
+                             : V::set_0_to_15();
     }
 
     dequant_n_grouped<bfloat16, ldb, N_GROUP_SIZE, qw_type>::call(
@@ -1137,9 +1592,18 @@ struct Dequantize<bfloat16, ldb, N_GROUP_SIZE, qw_type> {
           if constexpr (is_4bit_flag) {
             return load_dequant_4bit<N_GROUP_SIZE, sym_quant, float>::call(
                 p, vscales, lut, vzps);
+          } else if constexpr (is_2bit_planes(qw_type)) {
+            return load_dequant_lowbit<
+                N_GROUP_SIZE,
+                sym_quant,
+                float,
+                qw_type>::call(p, vscales, vzps);
           } else {
-            return load_dequant_int8<N_GROUP_SIZE, sym_quant, float>::call(
-                p, vscales, vzps);
+            return load_dequant_int8<
+                N_GROUP_SIZE,
+                sym_quant,
+                float,
+                qw_type>::call(p, vscales, vzps);
           }
         },
         [&](auto p, auto vbs) {
@@ -1179,7 +1643,9 @@ struct Dequantize<half, ldb, N_GROUP_SIZE, qw_type> {
     constexpr bool is_4bit_flag = is_4bit(qw_type);
     constexpr bool sym_quant = is_sym_quant(qw_type);
     if constexpr (is_4bit_flag) {
-      lut = qw_type == NF4 ? V::set_nf4_lut() : V::set_0_to_15();
+      lut = qw_type == NF4 ? V::set_nf4_lut()
+          : qw_type == MXFP4 ? V::set_mxfp4_lut()
+                             : V::set_0_to_15();
     }
 
     dequant_n_grouped<half, ldb, N_GROUP_SIZE, qw_type>::call(
@@ -1194,9 +1660,12 @@ struct Dequantize<half, ldb, N_GROUP_SIZE, qw_type> {
           if constexpr (is_4bit_flag) {
             return load_dequant_4bit<N_GROUP_SIZE, sym_quant, T>::call(
                 p, vscales, lut, vzps);
+          } else if constexpr (is_2bit_planes(qw_type)) {
+            return load_dequant_lowbit<N_GROUP_SIZE, sym_quant, T, qw_type>::
+                call(p, vscales, vzps);
           } else {
-            return load_dequant_int8<N_GROUP_SIZE, sym_quant, T>::call(
-                p, vscales, vzps);
+            return load_dequant_int8<N_GROUP_SIZE, sym_quant, T, qw_type>::
+                call(p, vscales, vzps);
           }
         },
         [&](auto p, auto vbs) {
@@ -1267,7 +1736,13 @@ template <
     long PREFETCH_K_DIST = 0>
 class DequantGemmTPP {
  public:
-  DequantGemmTPP(long M, long K, long lda, long ldc) {
+  DequantGemmTPP(
+      long M,
+      long K,
+      long lda,
+      long ldc,
+      long prefetch_k_dist = PREFETCH_K_DIST,
+      long small_batch_threshold = SMALL_BATCH_THRESHOLD) {
     TLA_ASSERT(false, "not implemented");
   }
 
@@ -1318,8 +1793,19 @@ class DequantGemmTPP<
     quant_a_mode,
     PREFETCH_K_DIST> {
  public:
-  DequantGemmTPP(long M, long K, long lda, long ldc)
-      : M(M), K(K), lda(lda), ldc(ldc) {
+  DequantGemmTPP(
+      long M,
+      long K,
+      long lda,
+      long ldc,
+      long prefetch_k_dist = PREFETCH_K_DIST,
+      long small_batch_threshold = SMALL_BATCH_THRESHOLD)
+      : M(M),
+        K(K),
+        lda(lda),
+        ldc(ldc),
+        prefetch_k_dist(prefetch_k_dist),
+        small_batch_threshold(small_batch_threshold) {
     static_assert(N % 16 == 0, "N must be a multiple of 16");
     if (std::is_same<Tin, bfloat16>())
       TLA_ASSERT(K % 2 == 0, "Kb must be a multiple of 2 for bfloat16");
@@ -1352,7 +1838,7 @@ class DequantGemmTPP<
       float* scale_a = nullptr,
       int32_t* zp_a = nullptr,
       int32_t k_groups = -1) {
-    if (M < SMALL_BATCH_THRESHOLD &&
+    if (M < small_batch_threshold &&
         ((std::is_same<Tin, half>() && std::is_same<Tout, half>()) ||
          (std::is_same<Tin, float>() && std::is_same<Tout, float>()))) {
       for (long m = 0; m < M; m += BLOCK_M) {
@@ -1380,7 +1866,8 @@ class DequantGemmTPP<
                       (Tin*)C + m * ldc,
                       ldc,
                       scales,
-                      zps);
+                      zps,
+                      prefetch_k_dist);
             },
             [&](auto i) {
               range_dispatcher<long, 1, BLOCK_M - 1>::call(
@@ -1406,7 +1893,8 @@ class DequantGemmTPP<
                             (Tin*)C + m * ldc,
                             ldc,
                             scales,
-                            zps);
+                            zps,
+                            prefetch_k_dist);
                   },
                   [&](auto j) { failing_fallback(); });
             });
@@ -1439,6 +1927,8 @@ class DequantGemmTPP<
   long K;
   long lda;
   long ldc;
+  long prefetch_k_dist;
+  long small_batch_threshold;
 };
 
 template <
@@ -1465,8 +1955,19 @@ class DequantGemmTPP<
   using TBrgemmTPP = BrgemmTPP<int8_t, int32_t>;
 
  public:
-  DequantGemmTPP(long M, long K, long lda, long ldc)
-      : M(M), K(K), lda(lda), ldc(ldc) {
+  DequantGemmTPP(
+      long M,
+      long K,
+      long lda,
+      long ldc,
+      long prefetch_k_dist = PREFETCH_K_DIST,
+      long small_batch_threshold = SMALL_BATCH_THRESHOLD)
+      : M(M),
+        K(K),
+        lda(lda),
+        ldc(ldc),
+        prefetch_k_dist(prefetch_k_dist),
+        small_batch_threshold(small_batch_threshold) {
     static_assert(N % 16 == 0, "N must be a multiple of 16");
     TLA_ASSERT(K % 4 == 0, "Kb must be a multiple of 4 for int8 VNNI");
     // TODO(jgong5): output fp32 directly
@@ -1501,7 +2002,7 @@ class DequantGemmTPP<
       int32_t k_groups = -1) {
     auto qA = GetVLAPtr<uint8_t>(A, {lda});
 #ifdef __AVX512VNNI__
-    if (M < SMALL_BATCH_THRESHOLD) {
+    if (M < small_batch_threshold) {
       constexpr long PREFERRED_BLOCK_M =
           BLOCK_M * N / 16 >= 16 ? BLOCK_M / 2 : BLOCK_M;
       for (long m = 0; m < M; m += PREFERRED_BLOCK_M) {
@@ -1543,7 +2044,8 @@ class DequantGemmTPP<
                       zps,
                       scale_a_m,
                       zp_a_m,
-                      k_groups);
+                      k_groups,
+                      prefetch_k_dist);
             },
             [&](auto i) {
               range_dispatcher<long, 1, PREFERRED_BLOCK_M - 1>::call(
@@ -1572,7 +2074,8 @@ class DequantGemmTPP<
                             zps,
                             scale_a_m,
                             zp_a_m,
-                            k_groups);
+                            k_groups,
+                            prefetch_k_dist);
                   },
                   [&](auto j) { failing_fallback(); });
             });
@@ -1633,6 +2136,8 @@ class DequantGemmTPP<
   long K;
   long lda;
   long ldc;
+  long prefetch_k_dist;
+  long small_batch_threshold;
 };
 
 // If T != TComp
@@ -1656,7 +2161,7 @@ void qlinear_woq_affine_impl(
     const at::Tensor& b, // dtype is TComp
     at::Tensor y,
     const int qw_type,
-    int k_splits,
+    const WoqTuningConfig& tuning,
     int num_concats,
     int fusion_type,
     const TensorList& others_list,
@@ -1664,13 +2169,13 @@ void qlinear_woq_affine_impl(
     const std::optional<at::Tensor>& zps = std::nullopt, // dtype is TComp
     float* scales_a_ptr = nullptr,
     int32_t* zps_a_ptr = nullptr) {
-  const bool is_4bit_flag = is_4bit(qw_type);
+  const int bits = qw_bits(qw_type);
   const bool sym_quant = is_sym_quant(qw_type);
   auto x_sizes = x.sizes();
   auto w_sizes = qw_packed.sizes();
   auto M = x_sizes[0];
   auto Nc = w_sizes[0];
-  auto Nb = is_4bit_flag ? w_sizes[3] * 2 : w_sizes[3];
+  auto Nb = w_sizes[3] * 8 / bits;
   auto Kc = w_sizes[1];
   auto Kb = w_sizes[2];
   auto N = Nc * Nb;
@@ -1688,7 +2193,9 @@ void qlinear_woq_affine_impl(
   // select BLOCK_M according to M
   // TODO(jgong5): improve the heuristic
   auto BLOCK_M = [&]() -> long {
-    if (M < 32) {
+    if (tuning.block_m > 0) {
+      return std::min<long>(tuning.block_m, M);
+    } else if (M < 32) {
       return M;
     } else if (M < 64) {
       return 32;
@@ -1699,11 +2206,13 @@ void qlinear_woq_affine_impl(
 
   auto BLOCK_M_rem = M % BLOCK_M;
 
-  // TODO(jgong5): use heuristics to decide k_splits
-  if (k_splits <= 0 || num_concats > 1 || M >= 32 || BLOCK_M_rem) {
+  // A tuned k_splits may not fit the blocking of this weight, fall back to no
+  // split in that case
+  int k_splits = tuning.k_splits;
+  if (k_splits <= 0 || num_concats > 1 || M >= 32 || BLOCK_M_rem ||
+      Kc % k_splits) {
     k_splits = 1;
   }
-  TLA_ASSERT(Kc % k_splits == 0, "Kc must be a multiple of k_splits");
   TLA_ASSERT(
       !(std::is_same<T, uint8_t>()) || (std::is_same<T, TComp>()),
       "T must be TComp if T is uint8_t");
@@ -1718,7 +2227,7 @@ void qlinear_woq_affine_impl(
 
   auto px = GetVLAPtr<T>(x, {Kc, Kb});
   auto pw = GetVLAPtr<uint8_t>(
-      (uint8_t*)qw_packed.data_ptr(), {Kc, Kb * (is_4bit_flag ? Nb / 2 : Nb)});
+      (uint8_t*)qw_packed.data_ptr(), {Kc, Kb * Nb * bits / 8});
   auto py = GetVLAPtr<Tout>(y, {Nc, Nb}); /*[M, Nc, Nb]*/
   auto py_concat = GetVLAPtr<Tout>(
       y, {M, Nc / num_concats, Nb}); /*[num_concats, M, Nc/num_concats, Nb]*/
@@ -1809,7 +2318,16 @@ void qlinear_woq_affine_impl(
       std::tuple</*BLOCK_N*/ long, /*qw_type*/ int>,
       std::tuple<
           enumerate_dispatcher<long, 16, 32, 64, 128>,
-          enumerate_dispatcher<int, QINT8, QINT4, NF4>>>::
+          enumerate_dispatcher<
+              int,
+              QINT8,
+              QINT4,
+              NF4,
+              MXFP4,
+              MXFP6,
+              MXFP8,
+              INT2,
+              INT3>>>::
       call(
           std::make_tuple(Nb, qw_type),
           [&](auto tuple) {
@@ -1833,7 +2351,9 @@ void qlinear_woq_affine_impl(
                 /*M*/ BLOCK_M,
                 /*K*/ Kb,
                 /*lda*/ lda,
-                /*ldc*/ ldc);
+                /*ldc*/ ldc,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
             auto dequant_gemm_no_prefetch_tpp = DequantGemmTPP<
                 TComp,
                 TGemmOut,
@@ -1850,7 +2370,9 @@ void qlinear_woq_affine_impl(
                 /*M*/ BLOCK_M,
                 /*K*/ Kb,
                 /*lda*/ lda,
-                /*ldc*/ ldc);
+                /*ldc*/ ldc,
+                /*prefetch_k_dist*/ 0,
+                tuning.small_batch_threshold);
             auto dequant_gemm_rem_tpp = DequantGemmTPP<
                 TComp,
                 TGemmOut,
@@ -1867,7 +2389,9 @@ void qlinear_woq_affine_impl(
                 /*M*/ BLOCK_M_rem,
                 /*K*/ Kb,
                 /*lda*/ lda,
-                /*ldc*/ ldc);
+                /*ldc*/ ldc,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
             auto dequant_gemm_no_prefetch_rem_tpp = DequantGemmTPP<
                 TComp,
                 TGemmOut,
@@ -1884,7 +2408,9 @@ void qlinear_woq_affine_impl(
                 /*M*/ BLOCK_M_rem,
                 /*K*/ Kb,
                 /*lda*/ lda,
-                /*ldc*/ ldc);
+                /*ldc*/ ldc,
+                /*prefetch_k_dist*/ 0,
+                tuning.small_batch_threshold);
 
             auto pcvt_x_tpp = std::is_same<T, uint8_t>()
                 ? nullptr
@@ -1913,11 +2439,14 @@ void qlinear_woq_affine_impl(
 
             // TODO(jgong5): parallelize over M on large BS
             if (no_y_buf) {
-              auto loop_scheme = M >= PARALLEL_M_THRESHOLD ? "ACb" : "aCb";
+              auto loop_scheme =
+                  M >= tuning.parallel_m_threshold ? "ACb" : "aCb";
               auto gemm_loop = ThreadedLoop<3>(
                   {{0, M, BLOCK_M, false}, {Kc}, {Nc}}, loop_scheme);
+              auto profile_scope = utils::KernelProfileScope::current();
               gemm_loop(
                   [&](int* idx) {
+                    utils::KernelThreadTimer thread_timer(profile_scope);
                     int m = idx[0];
                     int kc = idx[1];
                     int nc = idx[2];
@@ -2061,12 +2590,15 @@ void qlinear_woq_affine_impl(
               auto y_private_ptr = GetVLAPtr<TGemmOut>(y_private, {M, Nc, Nb});
               auto y_private_valid_ptr =
                   GetVLAPtr<bool>(y_private_valid, {M / BLOCK_M, Nc});
-              auto loop_scheme = M >= PARALLEL_M_THRESHOLD ? "CAB" : "ABc";
+              auto loop_scheme =
+                  M >= tuning.parallel_m_threshold ? "CAB" : "ABc";
               auto gemm_loop = ThreadedLoop<3>(
                   {{Nc}, {0, Kc, Kc / k_splits, true}, {0, M, BLOCK_M, false}},
                   loop_scheme);
+              auto profile_scope = utils::KernelProfileScope::current();
               gemm_loop(
                   [&](int* idx) {
+                    utils::KernelThreadTimer thread_timer(profile_scope);
                     int my_id = omp_get_thread_num();
                     int nc = idx[0];
                     int kc_start = idx[1];
@@ -2257,6 +2789,330 @@ void qlinear_woq_affine_impl(
           [](auto tuple) { failing_fallback(); });
 }
 
+// Gated MLP of one weight packed from the gate and up projections and one of
+// the down projection:
+//   y = (silu(x * W_gate + b_gate) * (x * W_up + b_up)) * W_down + b_down
+// The gate blocks come first along N of the packed gate/up weight, followed by
+// the up blocks. Each task computes a tile of the intermediate activation for
+// a block of rows, applies SiLU-and-mul on it and multiplies it with the rows
+// of the down weight of the tile right away, so that the intermediate
+// activation stays in cache. The tiles of a block of rows are split in chunks
+// among threads for small M, each chunk accumulating the down projection in
+// its own partial output, and the partial outputs are summed at the end.
+template <
+    typename TComp,
+    typename TGemmOut,
+    typename Tout,
+    typename TScale,
+    typename TZero,
+    int quant_w_mode = 0>
+void qlinear_woq_mlp_impl(
+    const at::Tensor& x, // [M, K], dtype is TComp
+    const at::Tensor& qw_gate_up,
+    const at::Tensor& scales_gate_up, // dtype is TComp
+    const at::Tensor& b_gate_up, // dtype is TGemmOut
+    const at::Tensor& qw_down,
+    const at::Tensor& scales_down, // dtype is TComp
+    const at::Tensor& b_down, // dtype is TGemmOut
+    int64_t intermediate_size,
+    at::Tensor y, // [M, N]
+    const int qw_type,
+    const WoqTuningConfig& tuning,
+    const TensorList& others_list,
+    int64_t quant_block_k,
+    const std::optional<at::Tensor>& zps_gate_up = std::nullopt,
+    const std::optional<at::Tensor>& zps_down = std::nullopt) {
+  // Columns of the intermediate activation computed at a time, rounded to the
+  // blocking of both weights
+  constexpr long MLP_TILE_COLS = 256;
+  const int bits = qw_bits(qw_type);
+  const bool sym_quant = is_sym_quant(qw_type);
+  auto M = x.size(0);
+  auto gu_sizes = qw_gate_up.sizes();
+  auto d_sizes = qw_down.sizes();
+  auto Nb = gu_sizes[3] * 8 / bits;
+  auto Kc = gu_sizes[1];
+  auto Kb = gu_sizes[2];
+  auto K = Kc * Kb;
+  auto Nc_d = d_sizes[0];
+  auto Kc_d = d_sizes[1];
+  auto Kb_d = d_sizes[2];
+  auto N = Nc_d * Nb;
+  auto I = intermediate_size;
+  TLA_ASSERT(I == Kc_d * Kb_d, "K of down must be the intermediate size");
+  TLA_ASSERT(I % Nb == 0, "intermediate size must be a multiple of Nb");
+  // Offset of the up blocks in the gate/up weight
+  auto Nc_up = I / Nb;
+  auto quant_block_multiple = quant_block_k == 0 ? 1 : quant_block_k / Kb;
+  auto quant_block_multiple_d = quant_block_k == 0 ? 1 : quant_block_k / Kb_d;
+  auto quant_k_blocks =
+      quant_block_k == 0 ? 1 : (K + quant_block_k - 1) / quant_block_k;
+  auto quant_k_blocks_d =
+      quant_block_k == 0 ? 1 : (I + quant_block_k - 1) / quant_block_k;
+  int scales_kc = quant_w_mode == QUANT_W_PER_CHANNEL ? QUANT_W_PER_K_BLOCK
+                                                      : quant_k_blocks;
+  int scales_kc_d = quant_w_mode == QUANT_W_PER_CHANNEL ? QUANT_W_PER_K_BLOCK
+                                                        : quant_k_blocks_d;
+
+  auto BLOCK_M = [&]() -> long {
+    if (tuning.block_m > 0) {
+      return std::min<long>(tuning.block_m, M);
+    } else if (M < 32) {
+      return M;
+    } else if (M < 64) {
+      return 32;
+    } else {
+      return 64;
+    }
+  }();
+  auto BLOCK_M_rem = M % BLOCK_M;
+  auto num_m_blocks = (M + BLOCK_M - 1) / BLOCK_M;
+
+  auto tile_unit = std::lcm(Nb, Kb_d);
+  auto tile_cols =
+      std::max<long>(tile_unit, MLP_TILE_COLS / tile_unit * tile_unit);
+  auto num_tiles = (I + tile_cols - 1) / tile_cols;
+  // Split the tiles so that all threads get some work on small M
+  auto num_threads = omp_get_max_threads();
+  long num_chunks = std::max<long>(
+      1,
+      std::min<long>(
+          num_tiles, (num_threads + num_m_blocks - 1) / num_m_blocks));
+
+  auto px = GetVLAPtr<TComp>(x, {Kc, Kb});
+  auto pw_gu = GetVLAPtr<uint8_t>(
+      (uint8_t*)qw_gate_up.data_ptr(),
+      {Kc, Kb * Nb * bits / 8});
+  auto pw_d = GetVLAPtr<uint8_t>(
+      (uint8_t*)qw_down.data_ptr(),
+      {Kc_d, Kb_d * Nb * bits / 8});
+  auto pscales_gu = GetVLAPtr<TScale>(scales_gate_up, {scales_kc, Nb});
+  auto pscales_d = GetVLAPtr<TScale>(scales_down, {scales_kc_d, Nb});
+  auto pzps_gu = sym_quant
+      ? GetVLAPtr<TZero>(nullptr, {1, 1})
+      : GetVLAPtr<TZero>(zps_gate_up.value(), {scales_kc, Nb});
+  auto pzps_d = sym_quant
+      ? GetVLAPtr<TZero>(nullptr, {1, 1})
+      : GetVLAPtr<TZero>(zps_down.value(), {scales_kc_d, Nb});
+  auto pb_gu = GetVLAPtr<TGemmOut>(b_gate_up, {Nb});
+  auto pb_d = GetVLAPtr<TGemmOut>(b_down, {Nb});
+  auto py = GetVLAPtr<Tout>(y, {Nc_d, Nb}); /*[M, Nc_d, Nb]*/
+  auto tin0 = others_list.size() > 0 ? others_list[0] : at::Tensor{};
+  auto pin0 = GetVLAPtr<Tout>(tin0, {Nc_d, Nb}); /*[M, Nc_d, Nb]*/
+  TGemmOut* y_partial = (TGemmOut*)std::aligned_alloc(
+      64, num_chunks * M * N * sizeof(TGemmOut));
+  auto py_partial = GetVLAPtr<TGemmOut>(y_partial, {M, Nc_d, Nb});
+  // Gate, up and intermediate tiles of each thread. They are sized by
+  // BLOCK_M, which may be tuned, so they are taken from the heap instead of
+  // the stack.
+  auto round_up = [](size_t nbytes) { return (nbytes + 63) / 64 * 64; };
+  size_t gate_up_buf_bytes = round_up(BLOCK_M * Nb * sizeof(TGemmOut));
+  size_t inter_buf_bytes = round_up(BLOCK_M * tile_cols * sizeof(TComp));
+  size_t thread_buf_bytes = gate_up_buf_bytes * 2 + inter_buf_bytes;
+  char* thread_bufs =
+      (char*)std::aligned_alloc(64, num_threads * thread_buf_bytes);
+
+  auto copy_bias_buf_tpp = CpyBiasTPP<TGemmOut>(BLOCK_M, Nb, Nb);
+  auto copy_bias_buf_rem_tpp = CpyBiasTPP<TGemmOut>(BLOCK_M_rem, Nb, Nb);
+  auto zero_buf_tpp = SetZeroTPP<TGemmOut>(BLOCK_M, Nb, Nb);
+  auto zero_buf_rem_tpp = SetZeroTPP<TGemmOut>(BLOCK_M_rem, Nb, Nb);
+  auto copy_bias_out_tpp = CpyBiasTPP<TGemmOut>(BLOCK_M, Nb, N);
+  auto copy_bias_out_rem_tpp = CpyBiasTPP<TGemmOut>(BLOCK_M_rem, Nb, N);
+  auto zero_out_tpp = SetZeroTPP<TGemmOut>(BLOCK_M, Nb, N);
+  auto zero_out_rem_tpp = SetZeroTPP<TGemmOut>(BLOCK_M_rem, Nb, N);
+  auto silu_tpp = SiLUFwdTPP<TGemmOut>(BLOCK_M, Nb, Nb, Nb);
+  auto silu_rem_tpp = SiLUFwdTPP<TGemmOut>(BLOCK_M_rem, Nb, Nb, Nb);
+  auto mul_tpp = MulTPP<TGemmOut, TComp>(BLOCK_M, Nb, Nb, tile_cols);
+  auto mul_rem_tpp = MulTPP<TGemmOut, TComp>(BLOCK_M_rem, Nb, Nb, tile_cols);
+  auto add_partial_tpp = AddTPP<TGemmOut>(BLOCK_M, Nb, N, N);
+  auto add_partial_rem_tpp = AddTPP<TGemmOut>(BLOCK_M_rem, Nb, N, N);
+  auto cvt_y_tpp = ConvertTPP<TGemmOut, Tout>(BLOCK_M, Nb, N, N);
+  auto cvt_y_rem_tpp = ConvertTPP<TGemmOut, Tout>(BLOCK_M_rem, Nb, N, N);
+  auto add_y_tpp = AddTPP<Tout>(BLOCK_M, Nb, N, N);
+  auto add_y_rem_tpp = AddTPP<Tout>(BLOCK_M_rem, Nb, N, N);
+
+  constexpr long MICRO_BLOCK_M = 8;
+  product_dispatcher<
+      std::tuple</*BLOCK_N*/ long, /*qw_type*/ int>,
+      std::tuple<
+          enumerate_dispatcher<long, 16, 32, 64, 128>,
+          enumerate_dispatcher<
+              int,
+              QINT8,
+              QINT4,
+              NF4,
+              MXFP4,
+              MXFP6,
+              MXFP8,
+              INT2,
+              INT3>>>::
+      call(
+          std::make_tuple(Nb, qw_type),
+          [&](auto tuple) {
+            auto BLOCK_N = std::get<0>(tuple);
+            auto qw_type = std::get<1>(tuple);
+            using DequantGemm = DequantGemmTPP<
+                TComp,
+                TGemmOut,
+                TScale,
+                TZero,
+                MICRO_BLOCK_M,
+                BLOCK_N,
+                /*ldb*/ BLOCK_N,
+                /*transA*/ false,
+                /*ACC*/ true,
+                qw_type,
+                UNQUANT_A,
+                PREFETCH_K_DIST>;
+            // x is read with ld of K and the intermediate tile with ld of
+            // tile_cols. The two GEMMs alternate, so that each call sets up
+            // its own tile config.
+            auto gemm_gu_tpp = DequantGemm(
+                BLOCK_M,
+                Kb,
+                K,
+                Nb,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
+            auto gemm_gu_rem_tpp = DequantGemm(
+                BLOCK_M_rem,
+                Kb,
+                K,
+                Nb,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
+            auto gemm_down_tpp = DequantGemm(
+                BLOCK_M,
+                Kb_d,
+                tile_cols,
+                N,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
+            auto gemm_down_rem_tpp = DequantGemm(
+                BLOCK_M_rem,
+                Kb_d,
+                tile_cols,
+                N,
+                tuning.prefetch_k_dist,
+                tuning.small_batch_threshold);
+
+            auto get_scale = [&](auto pscales, int nc, int kc, long multiple) {
+              return quant_w_mode == QUANT_W_PER_CHANNEL
+                  ? (TScale*)pscales[nc][0]
+                  : (TScale*)pscales[nc][kc / multiple];
+            };
+            auto get_zp = [&](auto pzps, int nc, int kc, long multiple) {
+              if (sym_quant) {
+                return (TZero*)nullptr;
+              }
+              return quant_w_mode == QUANT_W_PER_CHANNEL
+                  ? (TZero*)pzps[nc][0]
+                  : (TZero*)pzps[nc][kc / multiple];
+            };
+
+            auto mlp_loop = ThreadedLoop<2>(
+                {{0, M, BLOCK_M, false}, {num_chunks}}, "AB");
+            mlp_loop(
+                [&](int* idx) {
+                  int m = idx[0];
+                  int chunk = idx[1];
+                  bool is_rem = (m + BLOCK_M > M);
+                  auto& gemm_gu = is_rem ? gemm_gu_rem_tpp : gemm_gu_tpp;
+                  auto& gemm_down = is_rem ? gemm_down_rem_tpp : gemm_down_tpp;
+                  auto& copy_bias_buf =
+                      is_rem ? copy_bias_buf_rem_tpp : copy_bias_buf_tpp;
+                  auto& zero_buf = is_rem ? zero_buf_rem_tpp : zero_buf_tpp;
+                  char* thread_buf =
+                      thread_bufs + omp_get_thread_num() * thread_buf_bytes;
+                  auto gate_buf = (TGemmOut*)thread_buf;
+                  auto up_buf = (TGemmOut*)(thread_buf + gate_up_buf_bytes);
+                  auto inter_buf = (TComp*)(thread_buf + gate_up_buf_bytes * 2);
+                  for (int nc_d = 0; nc_d < Nc_d; nc_d++) {
+                    TGemmOut* out_ptr = py_partial[chunk][m][nc_d];
+                    if (chunk == 0 && b_down.defined()) {
+                      is_rem ? copy_bias_out_rem_tpp(pb_d[nc_d], out_ptr)
+                             : copy_bias_out_tpp(pb_d[nc_d], out_ptr);
+                    } else {
+                      is_rem ? zero_out_rem_tpp(out_ptr)
+                             : zero_out_tpp(out_ptr);
+                    }
+                  }
+                  long tile_begin = chunk * num_tiles / num_chunks;
+                  long tile_end = (chunk + 1) * num_tiles / num_chunks;
+                  for (long tile = tile_begin; tile < tile_end; tile++) {
+                    long i_begin = tile * tile_cols;
+                    long i_end = std::min<long>(I, i_begin + tile_cols);
+                    for (long nc = i_begin / Nb; nc < i_end / Nb; nc++) {
+                      auto compute = [&](long nc_gu, TGemmOut* buf) {
+                        if (b_gate_up.defined()) {
+                          copy_bias_buf(pb_gu[nc_gu], buf);
+                        } else {
+                          zero_buf(buf);
+                        }
+                        for (int kc = 0; kc < Kc; kc++) {
+                          gemm_gu(
+                              (TComp*)px[m][kc],
+                              pw_gu[nc_gu][kc],
+                              get_scale(
+                                  pscales_gu, nc_gu, kc, quant_block_multiple),
+                              get_zp(pzps_gu, nc_gu, kc, quant_block_multiple),
+                              buf,
+                              false);
+                        }
+                      };
+                      compute(nc, gate_buf);
+                      compute(nc + Nc_up, up_buf);
+                      TComp* inter_ptr = inter_buf + nc * Nb - i_begin;
+                      if (!is_rem) {
+                        silu_tpp(gate_buf, gate_buf);
+                        mul_tpp(gate_buf, up_buf, inter_ptr);
+                      } else {
+                        silu_rem_tpp(gate_buf, gate_buf);
+                        mul_rem_tpp(gate_buf, up_buf, inter_ptr);
+                      }
+                    }
+                    for (int nc_d = 0; nc_d < Nc_d; nc_d++) {
+                      for (long kc_d = i_begin / Kb_d; kc_d < i_end / Kb_d;
+                           kc_d++) {
+                        gemm_down(
+                            inter_buf + kc_d * Kb_d - i_begin,
+                            pw_d[nc_d][kc_d],
+                            get_scale(
+                                pscales_d, nc_d, kc_d, quant_block_multiple_d),
+                            get_zp(pzps_d, nc_d, kc_d, quant_block_multiple_d),
+                            py_partial[chunk][m][nc_d],
+                            false);
+                      }
+                    }
+                  }
+                },
+                [&]() {},
+                [&]() { gemm_gu_tpp.release(); });
+          },
+          [](auto tuple) { failing_fallback(); });
+
+  auto reduce_loop = ThreadedLoop<2>({{0, M, BLOCK_M, false}, {Nc_d}}, "AB");
+  reduce_loop([&](int* idx) {
+    int m = idx[0];
+    int nc_d = idx[1];
+    bool is_rem = (m + BLOCK_M > M);
+    TGemmOut* acc_ptr = py_partial[0][m][nc_d];
+    for (int chunk = 1; chunk < num_chunks; chunk++) {
+      is_rem
+          ? add_partial_rem_tpp(acc_ptr, py_partial[chunk][m][nc_d], acc_ptr)
+          : add_partial_tpp(acc_ptr, py_partial[chunk][m][nc_d], acc_ptr);
+    }
+    Tout* y_ptr = py[m][nc_d];
+    is_rem ? cvt_y_rem_tpp(acc_ptr, y_ptr) : cvt_y_tpp(acc_ptr, y_ptr);
+    if (tin0.defined()) {
+      is_rem ? add_y_rem_tpp(y_ptr, pin0[m][nc_d], y_ptr)
+             : add_y_tpp(y_ptr, pin0[m][nc_d], y_ptr);
+    }
+  });
+  std::free(thread_bufs);
+  std::free(y_partial);
+}
+
 /**
  * @brief pack the weight in quantized format.
  * @param qw quantized weight with shape [N, K]
@@ -2272,9 +3128,10 @@ at::Tensor qlinear_woq_pack(
     int64_t lowp_mode) {
   TLA_ASSERT(qw.is_contiguous(), "qw must be contiguous");
   bool is_4bit_flag = is_4bit(qw_type);
+  const int bits = qw_bits(qw_type);
   auto sizes = qw.sizes();
   auto N = sizes[0];
-  auto K = is_4bit_flag ? sizes[1] * 2 : sizes[1];
+  auto K = sizes[1] * 8 / bits;
   TLA_ASSERT(N % block_n == 0, "N must be multiple of block_n");
   TLA_ASSERT(K % block_k == 0, "K must be multiple of block_k");
   TLA_ASSERT(block_n % 16 == 0, "block_n must be multiple of 16 for int4");
@@ -2287,7 +3144,46 @@ at::Tensor qlinear_woq_pack(
       lowp_mode != LOWP_MODE_INT8 ? get_n_group_size(block_n) : 16;
   const int Nc = N / block_n;
   const int Kc = K / block_k;
-  if (is_4bit_flag) {
+  if (is_2bit_planes(qw_type)) {
+    TLA_ASSERT(
+        lowp_mode != LOWP_MODE_INT8,
+        "lowp mode int8 is not supported with weight in 2-bit planes");
+    auto result =
+        at::zeros({Nc, Kc, block_k, block_n * bits / 8}, qw.options());
+    // Pack weight in [N,K] to [N/block_n, K/block_k, block_k, block_n] and
+    // split each N_GROUP_SIZE values of a row into the bit planes read by
+    // load_dequant_zp_only_lowbit
+    uint8_t* src_data = (uint8_t*)qw.data_ptr();
+    uint8_t* dst_data = (uint8_t*)result.data_ptr();
+    auto pdst =
+        GetVLAPtr<uint8_t>(dst_data, {Kc, block_k, block_n * bits / 8});
+    const int quarter = N_GROUP_SIZE / 4;
+    auto pack_loop =
+        ThreadedLoop<3>({{Nc}, {Kc}, {0, block_n, N_GROUP_SIZE, false}}, "ABc");
+    pack_loop([&](int* idx) {
+      int nc = idx[0];
+      int kc = idx[1];
+      int nb = idx[2];
+      for (int i = 0; i < N_GROUP_SIZE; i++) {
+        uint8_t* src = src_data + (nc * block_n + nb + i) * K * bits / 8;
+        for (int kb = 0; kb < block_k; kb++) {
+          uint8_t* dst = &pdst[nc][kc][kb][nb * bits / 8];
+          auto val = get_bits(src, (kc * block_k + kb) * bits, bits);
+          for (int j = 0; j < bits / 2; j++) {
+            or_bits(
+                dst,
+                2 * N_GROUP_SIZE * j + 8 * (i % quarter) + 2 * (i / quarter),
+                2,
+                (val >> (2 * j)) & 3);
+          }
+          if (bits == 3) {
+            or_bits(dst, 2 * N_GROUP_SIZE + i, 1, val >> 2);
+          }
+        }
+      }
+    });
+    return result;
+  } else if (is_4bit_flag) {
     // TODO(jgong5): support lowp_mode == LOWP_MODE_INT8
     auto result = at::empty({Nc, Kc, block_k, block_n / 2}, qw.options());
     // Pack weight in [N,K] to [N/block_n, K/block_k, block_k, block_n]
@@ -2358,16 +3254,47 @@ at::Tensor qlinear_woq_unpack(
     int64_t lowp_mode) {
   bool is_4bit_flag = is_4bit(qw_type);
   if (qw_packed.dim() == 4) {
+    const int bits = qw_bits(qw_type);
     auto w_sizes = qw_packed.sizes();
     auto Nc = w_sizes[0];
-    auto Nb = is_4bit_flag ? w_sizes[3] * 2 : w_sizes[3];
+    auto Nb = w_sizes[3] * 8 / bits;
     auto Kc = w_sizes[1];
     auto Kb = w_sizes[2];
     auto N = Nc * Nb;
     auto K = Kc * Kb;
     const int N_GROUP_SIZE =
         lowp_mode != LOWP_MODE_INT8 ? get_n_group_size(Nb) : 16;
-    if (is_4bit_flag) {
+    if (is_2bit_planes(qw_type)) {
+      auto result = at::zeros({N, K * bits / 8}, qw_packed.options());
+      uint8_t* src_data = (uint8_t*)qw_packed.data_ptr();
+      uint8_t* dst_data = (uint8_t*)result.data_ptr();
+      auto psrc = GetVLAPtr<uint8_t>(src_data, {Kc, Kb, Nb * bits / 8});
+      const int quarter = N_GROUP_SIZE / 4;
+      // Rows are shared by the blocks along K, so only split N
+      auto unpack_loop =
+          ThreadedLoop<2>({{Nc}, {0, Nb, N_GROUP_SIZE, false}}, "AB");
+      unpack_loop([&](int* idx) {
+        int nc = idx[0];
+        int nb = idx[1];
+        for (int i = 0; i < N_GROUP_SIZE; i++) {
+          uint8_t* dst = dst_data + (nc * Nb + nb + i) * K * bits / 8;
+          for (int k = 0; k < K; k++) {
+            uint8_t* src = &psrc[nc][k / Kb][k % Kb][nb * bits / 8];
+            uint8_t val = 0;
+            for (int j = 0; j < bits / 2; j++) {
+              auto pos =
+                  2 * N_GROUP_SIZE * j + 8 * (i % quarter) + 2 * (i / quarter);
+              val |= get_bits(src, pos, 2) << (2 * j);
+            }
+            if (bits == 3) {
+              val |= get_bits(src, 2 * N_GROUP_SIZE + i, 1) << 2;
+            }
+            or_bits(dst, k * bits, bits, val);
+          }
+        }
+      });
+      return result;
+    } else if (is_4bit_flag) {
       // TODO: support lowp_mode == 3
       auto result = at::empty({N, K / 2}, qw_packed.options());
       uint8_t* src_data = (uint8_t*)qw_packed.data_ptr();
@@ -2990,26 +3917,31 @@ at::Tensor qlinear_woq_affine(
     int64_t quant_a_mode = -1,
     int64_t quant_w_mode = 0,
     int64_t quant_block_k = 0) {
-  const int64_t k_splits = 0;
   // int8_idx is only valid with zp_list when lowp_mode == LOWP_MODE_INT8
   constexpr size_t fp32_idx = 0, fp16_idx = 1, bf16_idx = 2, int8_idx = 3;
   auto biases = bias_list.empty()
       ? TensorList({at::Tensor(), at::Tensor(), at::Tensor()})
       : bias_list;
-  const bool is_4bit_flag = is_4bit(qw_type);
   const bool sym_quant = is_sym_quant(qw_type);
   if (qw.dim() == 4) {
     auto w_sizes = qw.sizes();
     auto K = x.size(-1);
     auto M = x.numel() / K;
-    auto N = w_sizes[0] * w_sizes[3];
-    if (is_4bit_flag) {
-      N *= 2;
-    }
+    auto N = w_sizes[0] * w_sizes[3] * 8 / qw_bits(qw_type);
+    auto tuning = woq_tuning::get_config(
+        {N,
+         K,
+         qw_type,
+         std::max<int64_t>(quant_block_k, 0),
+         lowp_mode,
+         omp_get_max_threads(),
+         woq_tuning::get_m_bucket(M)});
     auto out_sizes = x.sizes().vec();
     out_sizes.back() = N;
     auto y = at::empty(out_sizes, x.options());
     auto x_reshape = x.reshape({M, K});
+    utils::KernelProfileScope profile("woq_linear", x, qw);
+    profile.add_cost(2.0 * M * N * K, x.nbytes() + qw.nbytes(), y.nbytes());
     product_dispatcher<
         std::tuple<at::ScalarType, long>,
         std::tuple<
@@ -3044,7 +3976,7 @@ at::Tensor qlinear_woq_affine(
                       biases[fp16_idx],
                       y,
                       qw_type,
-                      k_splits,
+                      tuning,
                       num_concats,
                       fusion_type,
                       others_list,
@@ -3065,7 +3997,7 @@ at::Tensor qlinear_woq_affine(
                       biases[fp16_idx],
                       y,
                       qw_type,
-                      k_splits,
+                      tuning,
                       num_concats,
                       fusion_type,
                       others_list,
@@ -3089,7 +4021,7 @@ at::Tensor qlinear_woq_affine(
                       biases[fp32_idx],
                       y,
                       qw_type,
-                      k_splits,
+                      tuning,
                       num_concats,
                       fusion_type,
                       others_list,
@@ -3110,7 +4042,7 @@ at::Tensor qlinear_woq_affine(
                       biases[fp32_idx],
                       y,
                       qw_type,
-                      k_splits,
+                      tuning,
                       num_concats,
                       fusion_type,
                       others_list,
@@ -3139,7 +4071,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3160,7 +4092,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3184,7 +4116,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3205,7 +4137,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3234,7 +4166,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3255,7 +4187,7 @@ at::Tensor qlinear_woq_affine(
                         biases[fp32_idx],
                         y,
                         qw_type,
-                        k_splits,
+                        tuning,
                         num_concats,
                         fusion_type,
                         others_list,
@@ -3294,7 +4226,7 @@ at::Tensor qlinear_woq_affine(
                       biases[fp32_idx],
                       y,
                       qw_type,
-                      k_splits,
+                      tuning,
                       num_concats,
                       fusion_type,
                       others_list,
@@ -3340,7 +4272,7 @@ at::Tensor qlinear_woq_affine(
                                 biases[fp32_idx],
                                 y,
                                 qw_type,
-                                k_splits,
+                                tuning,
                                 num_concats,
                                 fusion_type,
                                 others_list,
@@ -3370,7 +4302,7 @@ at::Tensor qlinear_woq_affine(
     }
     at::Tensor scale, zp;
     scale = scales_list[fp32_idx].unsqueeze(-1);
-    if (qw_type != NF4) {
+    if (!sym_quant) {
       zp = zp_list[fp32_idx].unsqueeze(-1);
     }
     auto w =
@@ -3404,6 +4336,42 @@ at::Tensor qlinear_woq_affine(
               dqw = dqw.view({N, -1});
             }
             return dqw;
+          } else if (is_mx(qw_type)) {
+            using namespace at::indexing;
+            auto codes = qw;
+            if (qw_type == MXFP6) {
+              codes = unpack_bitstream(qw, qw_bits(qw_type));
+            } else if (qw_type == MXFP4) {
+              codes =
+                  at::empty({N, qw.size(1) * 2}, qw.options().dtype(at::kByte));
+              codes.index({Slice(), Slice(None, None, 2)})
+                  .copy_(qw.bitwise_and(0xf));
+              codes.index({Slice(), Slice(1, None, 2)})
+                  .copy_(qw.bitwise_right_shift(4));
+            }
+            auto w_ret = dequantize_mx(codes, qw_type);
+            at::Tensor dqw;
+            if (quant_w_mode == 0) {
+              dqw = w_ret * scale;
+            } else {
+              int64_t num_blocks = scale.size(-2);
+              dqw = (w_ret.view({N, num_blocks, -1}) * scale).view({N, -1});
+            }
+            return dqw;
+          } else if (is_lowbit(qw_type)) {
+            TLA_ASSERT(
+                !sym_quant,
+                "Weight must be asymmetrically quantized for INT2 and INT3");
+            auto w_int = unpack_bitstream(qw, qw_bits(qw_type)).to(at::kFloat);
+            at::Tensor dqw;
+            if (quant_w_mode == 0) {
+              dqw = (w_int - zp) * scale;
+            } else {
+              int64_t num_blocks = scale.size(-2);
+              dqw = (w_int.view({N, num_blocks, -1}) - zp) * scale;
+              dqw = dqw.view({N, -1});
+            }
+            return dqw;
           } else if (qw_type == QINT4) {
             TLA_ASSERT(
                 !sym_quant, "Weight must be asymmetrically quantized for INT4");
@@ -3483,6 +4451,249 @@ at::Tensor qlinear_woq_affine(
   }
 }
 
+template <typename TComp, typename TGemmOut, typename Tout, long quant_w_mode>
+void qlinear_woq_mlp_call(
+    const at::Tensor& x,
+    const at::Tensor& qw_gate_up,
+    const TensorList& scales_gate_up,
+    const TensorList& zp_gate_up,
+    const TensorList& bias_gate_up,
+    const at::Tensor& qw_down,
+    const TensorList& scales_down,
+    const TensorList& zp_down,
+    const TensorList& bias_down,
+    size_t scale_idx,
+    size_t bias_idx,
+    int64_t intermediate_size,
+    at::Tensor& y,
+    const int qw_type,
+    const WoqTuningConfig& tuning,
+    const TensorList& others_list,
+    int64_t quant_block_k) {
+  auto x_comp = x.to(c10::CppTypeToScalarType<TComp>::value).contiguous();
+  if (is_sym_quant(qw_type)) {
+    qlinear_woq_mlp_impl<TComp, TGemmOut, Tout, TComp, TComp, quant_w_mode>(
+        x_comp,
+        qw_gate_up,
+        scales_gate_up[scale_idx],
+        bias_gate_up[bias_idx],
+        qw_down,
+        scales_down[scale_idx],
+        bias_down[bias_idx],
+        intermediate_size,
+        y,
+        qw_type,
+        tuning,
+        others_list,
+        quant_block_k);
+  } else {
+    qlinear_woq_mlp_impl<TComp, TGemmOut, Tout, TComp, TComp, quant_w_mode>(
+        x_comp,
+        qw_gate_up,
+        scales_gate_up[scale_idx],
+        bias_gate_up[bias_idx],
+        qw_down,
+        scales_down[scale_idx],
+        bias_down[bias_idx],
+        intermediate_size,
+        y,
+        qw_type,
+        tuning,
+        others_list,
+        quant_block_k,
+        zp_gate_up[scale_idx],
+        zp_down[scale_idx]);
+  }
+}
+
+// Run the gated MLP with qlinear_woq_mlp_impl if the blocking of the weights
+// allows it. Return an undefined tensor otherwise.
+at::Tensor qlinear_woq_mlp_fused(
+    const at::Tensor& x,
+    const at::Tensor& qw_gate_up,
+    const TensorList& scales_gate_up,
+    const TensorList& zp_gate_up,
+    const TensorList& bias_gate_up,
+    const at::Tensor& qw_down,
+    const TensorList& scales_down,
+    const TensorList& zp_down,
+    const TensorList& bias_down,
+    int64_t intermediate_size,
+    int64_t out_features,
+    const int qw_type,
+    int64_t lowp_mode,
+    const TensorList& others_list,
+    int64_t quant_w_mode,
+    int64_t quant_block_k) {
+  constexpr size_t fp32_idx = 0, fp16_idx = 1, bf16_idx = 2;
+  if (qw_gate_up.dim() != 4 || qw_down.dim() != 4 ||
+      lowp_mode == LOWP_MODE_INT8) {
+    return at::Tensor();
+  }
+  const int bits = qw_bits(qw_type);
+  auto gu_sizes = qw_gate_up.sizes();
+  auto d_sizes = qw_down.sizes();
+  auto Nb = gu_sizes[3] * 8 / bits;
+  auto Nb_d = d_sizes[3] * 8 / bits;
+  auto K = gu_sizes[1] * gu_sizes[2];
+  auto Kb_d = d_sizes[2];
+  auto I = intermediate_size;
+  auto M = x.numel() / x.size(-1);
+  // The gate and up blocks must not share a block of N, and the down
+  // projection must not be padded along N so that the residual can be added
+  // in place.
+  bool fusable = Nb == Nb_d &&
+      (Nb == 16 || Nb == 32 || Nb == 64 || Nb == 128) && x.size(-1) == K &&
+      I % Nb == 0 && gu_sizes[0] * Nb >= 2 * I && d_sizes[1] * Kb_d == I &&
+      d_sizes[0] * Nb == out_features && Kb_d % 2 == 0 &&
+      (quant_block_k <= 0 ||
+       (quant_block_k % gu_sizes[2] == 0 && quant_block_k % Kb_d == 0));
+  if (!fusable || others_list.size() > 1 ||
+      (others_list.size() == 1 &&
+       (others_list[0].scalar_type() != x.scalar_type() ||
+        others_list[0].numel() != M * out_features))) {
+    return at::Tensor();
+  }
+  auto biases_gu = bias_gate_up.empty()
+      ? TensorList({at::Tensor(), at::Tensor(), at::Tensor()})
+      : bias_gate_up;
+  auto biases_d = bias_down.empty()
+      ? TensorList({at::Tensor(), at::Tensor(), at::Tensor()})
+      : bias_down;
+  auto tuning = woq_tuning::get_config(
+      {gu_sizes[0] * Nb,
+       K,
+       qw_type,
+       std::max<int64_t>(quant_block_k, 0),
+       lowp_mode,
+       omp_get_max_threads(),
+       woq_tuning::get_m_bucket(M)});
+  auto out_sizes = x.sizes().vec();
+  out_sizes.back() = out_features;
+  auto y = at::empty(out_sizes, x.options());
+  auto x_reshape = x.reshape({M, x.size(-1)});
+  TensorList others;
+  for (auto& tin : others_list) {
+    others.push_back(tin.contiguous());
+  }
+  quant_block_k = std::max<int64_t>(quant_block_k, 0);
+  product_dispatcher<
+      std::tuple<at::ScalarType, long>,
+      std::tuple<
+          enumerate_dispatcher<
+              at::ScalarType,
+              at::kFloat,
+              at::kBFloat16,
+              at::kHalf>,
+          range_dispatcher<long, 0, 1>>>::
+      call(
+          std::make_tuple(x.scalar_type(), quant_w_mode),
+          [&](auto tuple) {
+            auto act_dtype = std::get<0>(tuple);
+            auto quant_w_mode_ = std::get<1>(tuple);
+            using act_type =
+                typename c10::impl::ScalarTypeToCPPType<act_dtype>::type;
+            // Same choice of the compute dtype as qlinear_woq_affine
+            auto compute_in_half = [&]() {
+#ifdef __AVX512FP16__
+              qlinear_woq_mlp_call<half, half, act_type, quant_w_mode_>(
+                  x_reshape,
+                  qw_gate_up,
+                  scales_gate_up,
+                  zp_gate_up,
+                  biases_gu,
+                  qw_down,
+                  scales_down,
+                  zp_down,
+                  biases_d,
+                  fp16_idx,
+                  fp16_idx,
+                  I,
+                  y,
+                  qw_type,
+                  tuning,
+                  others,
+                  quant_block_k);
+#else
+              qlinear_woq_mlp_call<float, float, act_type, quant_w_mode_>(
+                  x_reshape,
+                  qw_gate_up,
+                  scales_gate_up,
+                  zp_gate_up,
+                  biases_gu,
+                  qw_down,
+                  scales_down,
+                  zp_down,
+                  biases_d,
+                  fp32_idx,
+                  fp32_idx,
+                  I,
+                  y,
+                  qw_type,
+                  tuning,
+                  others,
+                  quant_block_k);
+#endif
+            };
+            auto compute_in_bf16 = [&]() {
+              qlinear_woq_mlp_call<bfloat16, float, act_type, quant_w_mode_>(
+                  x_reshape,
+                  qw_gate_up,
+                  scales_gate_up,
+                  zp_gate_up,
+                  biases_gu,
+                  qw_down,
+                  scales_down,
+                  zp_down,
+                  biases_d,
+                  bf16_idx,
+                  fp32_idx,
+                  I,
+                  y,
+                  qw_type,
+                  tuning,
+                  others,
+                  quant_block_k);
+            };
+            if (lowp_mode == LOWP_MODE_NONE) {
+              if (std::is_same<act_type, half>()) {
+                compute_in_half();
+              } else if (std::is_same<act_type, bfloat16>()) {
+                compute_in_bf16();
+              } else {
+                qlinear_woq_mlp_call<float, float, act_type, quant_w_mode_>(
+                    x_reshape,
+                    qw_gate_up,
+                    scales_gate_up,
+                    zp_gate_up,
+                    biases_gu,
+                    qw_down,
+                    scales_down,
+                    zp_down,
+                    biases_d,
+                    fp32_idx,
+                    fp32_idx,
+                    I,
+                    y,
+                    qw_type,
+                    tuning,
+                    others,
+                    quant_block_k);
+              }
+            } else if (lowp_mode == LOWP_MODE_FP16) {
+              compute_in_half();
+            } else {
+              if (M >= SMALL_BATCH_THRESHOLD) {
+                compute_in_bf16();
+              } else {
+                compute_in_half();
+              }
+            }
+          },
+          [](auto tuple) { failing_fallback(); });
+  return y;
+}
+
 #else // defined(CPU_CAPABILITY_AVX512_FP16) && defined(COMPILER_PREREQ_MET)
 
 #define SMALL_BATCH_THRESHOLD 32
@@ -3519,7 +4730,7 @@ at::Tensor qlinear_woq_affine(
   }
   at::Tensor scale, zp;
   scale = scales_list[fp32_idx].unsqueeze(-1);
-  if (qw_type != NF4) {
+  if (!sym_quant) {
     zp = zp_list[fp32_idx].unsqueeze(-1);
   }
   auto w =
@@ -3553,6 +4764,42 @@ at::Tensor qlinear_woq_affine(
             dqw = dqw.view({N, -1});
           }
           return dqw;
+        } else if (is_mx(qw_type)) {
+          using namespace at::indexing;
+          auto codes = qw;
+          if (qw_type == MXFP6) {
+            codes = unpack_bitstream(qw, qw_bits(qw_type));
+          } else if (qw_type == MXFP4) {
+            codes =
+                at::empty({N, qw.size(1) * 2}, qw.options().dtype(at::kByte));
+            codes.index({Slice(), Slice(None, None, 2)})
+                .copy_(qw.bitwise_and(0xf));
+            codes.index({Slice(), Slice(1, None, 2)})
+                .copy_(qw.bitwise_right_shift(4));
+          }
+          auto w_ret = dequantize_mx(codes, qw_type);
+          at::Tensor dqw;
+          if (quant_w_mode == 0) {
+            dqw = w_ret * scale;
+          } else {
+            int64_t num_blocks = scale.size(-2);
+            dqw = (w_ret.view({N, num_blocks, -1}) * scale).view({N, -1});
+          }
+          return dqw;
+        } else if (is_lowbit(qw_type)) {
+          TLA_ASSERT(
+              !sym_quant,
+              "Weight must be asymmetrically quantized for INT2 and INT3");
+          auto w_int = unpack_bitstream(qw, qw_bits(qw_type)).to(at::kFloat);
+          at::Tensor dqw;
+          if (quant_w_mode == 0) {
+            dqw = (w_int - zp) * scale;
+          } else {
+            int64_t num_blocks = scale.size(-2);
+            dqw = (w_int.view({N, num_blocks, -1}) - zp) * scale;
+            dqw = dqw.view({N, -1});
+          }
+          return dqw;
         } else if (qw_type == QINT4) {
           TLA_ASSERT(
               !sym_quant, "Weight must be asymmetrically quantized for INT4");
@@ -3646,13 +4893,125 @@ at::Tensor qlinear_woq_unpack(
     int64_t lowp_mode) {
   return qw_packed;
 }
+
+at::Tensor qlinear_woq_mlp_fused(
+    const at::Tensor& x,
+    const at::Tensor& qw_gate_up,
+    const TensorList& scales_gate_up,
+    const TensorList& zp_gate_up,
+    const TensorList& bias_gate_up,
+    const at::Tensor& qw_down,
+    const TensorList& scales_down,
+    const TensorList& zp_down,
+    const TensorList& bias_down,
+    int64_t intermediate_size,
+    int64_t out_features,
+    const int qw_type,
+    int64_t lowp_mode,
+    const TensorList& others_list,
+    int64_t quant_w_mode,
+    int64_t quant_block_k) {
+  return at::Tensor();
+}
 #endif // defined(CPU_CAPABILITY_AVX512_FP16) && defined(COMPILER_PREREQ_MET)
 
+/**
+ * @brief Gated MLP of weight-only quantized gate/up and down projections,
+ * down(silu(gate(x)) * up(x)) + others.
+ * @param qw_gate_up weight of the gate and up projections concatenated along
+ * N, gate first.
+ * @param intermediate_size N of each of the gate and up projections, K of the
+ * down projection.
+ * @param out_features N of the down projection.
+ * @param others_list at most one tensor of the output shape added to the
+ * output, e.g., the residual.
+ */
+at::Tensor qlinear_woq_mlp(
+    const at::Tensor& x,
+    const at::Tensor& qw_gate_up,
+    const TensorList& scales_gate_up,
+    const TensorList& zp_gate_up,
+    const TensorList& bias_gate_up,
+    const at::Tensor& qw_down,
+    const TensorList& scales_down,
+    const TensorList& zp_down,
+    const TensorList& bias_down,
+    int64_t intermediate_size,
+    int64_t out_features,
+    const int qw_type,
+    int64_t lowp_mode,
+    const TensorList& others_list,
+    int64_t quant_a_mode,
+    int64_t quant_w_mode,
+    int64_t quant_block_k) {
+  auto y = qlinear_woq_mlp_fused(
+      x,
+      qw_gate_up,
+      scales_gate_up,
+      zp_gate_up,
+      bias_gate_up,
+      qw_down,
+      scales_down,
+      zp_down,
+      bias_down,
+      intermediate_size,
+      out_features,
+      qw_type,
+      lowp_mode,
+      others_list,
+      quant_w_mode,
+      quant_block_k);
+  if (y.defined()) {
+    return y;
+  }
+  // Unfused. The gate/up output is computed without the layout of num_concats
+  // so that gate and up are split at the intermediate size even if N is padded.
+  auto gate_up = qlinear_woq_affine(
+      x,
+      qw_gate_up,
+      scales_gate_up,
+      zp_gate_up,
+      bias_gate_up,
+      qw_type,
+      lowp_mode,
+      /*num_concats*/ 1,
+      /*fusion_type*/ 0,
+      TensorList(),
+      quant_a_mode,
+      quant_w_mode,
+      quant_block_k);
+  auto gate = gate_up.narrow(-1, 0, intermediate_size);
+  auto up = gate_up.narrow(-1, intermediate_size, intermediate_size);
+  auto inter = at::silu(gate).mul_(up);
+  y = qlinear_woq_affine(
+      inter,
+      qw_down,
+      scales_down,
+      zp_down,
+      bias_down,
+      qw_type,
+      lowp_mode,
+      /*num_concats*/ 1,
+      /*fusion_type*/ 0,
+      TensorList(),
+      quant_a_mode,
+      quant_w_mode,
+      quant_block_k);
+  if (y.size(-1) != out_features) {
+    y = y.narrow(-1, 0, out_features);
+  }
+  for (auto& tin : others_list) {
+    y = at::add(y, tin.view(y.sizes()));
+  }
+  return y;
+}
+
 } // namespace
 
 IPEX_REGISTER_DISPATCH(woq_tpp_gemm_kernel_stub, &qlinear_woq_affine);
 IPEX_REGISTER_DISPATCH(woq_tpp_gemm_packB_stub, &qlinear_woq_pack);
 IPEX_REGISTER_DISPATCH(woq_tpp_gemm_unpackB_stub, &qlinear_woq_unpack);
+IPEX_REGISTER_DISPATCH(woq_tpp_mlp_kernel_stub, &qlinear_woq_mlp);
 
 } // namespace cpu
 } // namespace torch_ipex
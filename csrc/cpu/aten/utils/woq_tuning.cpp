@@ -0,0 +1,323 @@
+#include "woq_tuning.h"
+
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+namespace torch_ipex {
+namespace cpu {
+namespace woq_tuning {
+
+namespace {
+
+const char* db_path_from_env() {
+  static const char* path = std::getenv("IPEX_WOQ_TUNING_DB");
+  return path;
+}
+
+struct TuningDB {
+  std::mutex mutex;
+  std::map<WoqTuningKey, WoqTuningConfig> entries;
+  // Bumped under the lock whenever entries change, so that the threads drop
+  // the configs they cached
+  std::atomic<int64_t> version{0};
+  bool autotune = []() {
+    auto val = std::getenv("IPEX_WOQ_AUTOTUNE");
+    return val != nullptr && std::string(val) == "1";
+  }();
+};
+
+int64_t get_process_id() {
+#ifndef _WIN32
+  return getpid();
+#else
+  return _getpid();
+#endif
+}
+
+// Whether the values of a loaded config can be used by the kernel. block_m
+// sizes the buffers of a thread, so that it is bounded.
+bool is_valid_config(const WoqTuningConfig& config) {
+  return config.block_n > 0 && config.block_n % 16 == 0 &&
+      config.block_k >= 0 && config.prefetch_k_dist >= 0 &&
+      config.block_m >= 0 && config.block_m <= kMaxBlockM &&
+      config.k_splits > 0 && config.parallel_m_threshold >= 0 &&
+      config.small_batch_threshold >= 0;
+}
+
+// Parse the entries of path, throw if any of them is malformed
+std::map<WoqTuningKey, WoqTuningConfig> read_db(const std::string& path) {
+  std::map<WoqTuningKey, WoqTuningConfig> entries;
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) {
+    return entries;
+  }
+  std::string line;
+  int64_t line_no = 0;
+  while (std::getline(ifs, line)) {
+    line_no++;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    WoqTuningKey key;
+    WoqTuningConfig config;
+    iss >> key.N >> key.K >> key.qw_type >> key.group_size >> key.lowp_mode >>
+        key.num_threads >> key.m_bucket >> config.block_n >> config.block_k >>
+        config.prefetch_k_dist >> config.block_m >> config.k_splits >>
+        config.parallel_m_threshold >> config.small_batch_threshold;
+    TORCH_CHECK(
+        !iss.fail() && is_valid_config(config),
+        "WoQ tuning database: malformed entry at ",
+        path,
+        ":",
+        line_no);
+    entries[key] = config;
+  }
+  return entries;
+}
+
+// The caller holds the lock of db. The entries of path are merged only if
+// all of them are well formed.
+void load_db_locked(TuningDB& db, const std::string& path) {
+  auto entries = read_db(path);
+  for (const auto& entry : entries) {
+    db.entries[entry.first] = entry.second;
+  }
+  db.version.fetch_add(1, std::memory_order_release);
+}
+
+// The caller holds the lock of db. The entries are written to a temporary
+// file first, which then replaces path, so that a crash or a concurrent
+// writer never leaves a partially written database.
+void save_db_locked(const TuningDB& db, const std::string& path) {
+  auto tmp_path = path + ".tmp." + std::to_string(get_process_id());
+  {
+    std::ofstream ofs(tmp_path, std::ofstream::out | std::ofstream::trunc);
+    TORCH_CHECK(
+        ofs.is_open(),
+        "WoQ tuning database: failed to open ",
+        tmp_path,
+        " to write");
+    ofs << "# N K qw_type group_size lowp_mode num_threads m_bucket block_n "
+           "block_k prefetch_k_dist block_m k_splits parallel_m_threshold "
+           "small_batch_threshold\n";
+    for (const auto& entry : db.entries) {
+      const auto& key = entry.first;
+      const auto& config = entry.second;
+      ofs << key.N << " " << key.K << " " << key.qw_type << " "
+          << key.group_size << " " << key.lowp_mode << " " << key.num_threads
+          << " " << key.m_bucket << " " << config.block_n << " "
+          << config.block_k << " " << config.prefetch_k_dist << " "
+          << config.block_m << " " << config.k_splits << " "
+          << config.parallel_m_threshold << " "
+          << config.small_batch_threshold << "\n";
+    }
+    ofs.flush();
+    if (!ofs.good()) {
+      ofs.close();
+      std::remove(tmp_path.c_str());
+      TORCH_CHECK(false, "WoQ tuning database: failed to write ", tmp_path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    TORCH_CHECK(
+        false,
+        "WoQ tuning database: failed to replace ",
+        path,
+        " by ",
+        tmp_path);
+  }
+}
+
+TuningDB& get_db() {
+  static TuningDB* db = []() {
+    auto db = new TuningDB();
+    if (db_path_from_env() != nullptr) {
+      // A bad database only costs the tuned configs, so that it must not
+      // fail the GEMMs looking up their configs
+      try {
+        load_db_locked(*db, db_path_from_env());
+      } catch (const c10::Error& e) {
+        TORCH_WARN(
+            "WoQ tuning database: ignore ",
+            db_path_from_env(),
+            ", ",
+            e.what_without_backtrace());
+      }
+    }
+    return db;
+  }();
+  return *db;
+}
+
+thread_local const WoqTuningConfig* override_config = nullptr;
+
+// The configs looked up by the calling thread, tuned or default, which are
+// valid while the version of the database does not change. get_config is
+// called for every GEMM, so that it only takes the lock of the database at
+// the first lookup of a key.
+struct ThreadConfigCache {
+  int64_t version = -1;
+  std::map<WoqTuningKey, WoqTuningConfig> entries;
+};
+
+thread_local ThreadConfigCache thread_config_cache;
+
+// The caller holds the lock of db. Find the entry of key, or of the M bucket
+// nearest to the one of key if it is not tuned, e.g. an M beyond the ones
+// benchmarked. The packing entry of M bucket 0 is only found by itself.
+std::map<WoqTuningKey, WoqTuningConfig>::const_iterator find_nearest_locked(
+    const TuningDB& db,
+    const WoqTuningKey& key) {
+  auto it = db.entries.lower_bound(key);
+  if (it != db.entries.end() && !(key < it->first)) {
+    return it;
+  }
+  if (key.m_bucket <= 0) {
+    return db.entries.end();
+  }
+  // Entries of other M buckets of the key are adjacent in the map
+  auto same_shape = [&](const WoqTuningKey& other) {
+    return other.m_bucket > 0 &&
+        std::tie(key.N,
+                 key.K,
+                 key.qw_type,
+                 key.group_size,
+                 key.lowp_mode,
+                 key.num_threads) ==
+        std::tie(other.N,
+                 other.K,
+                 other.qw_type,
+                 other.group_size,
+                 other.lowp_mode,
+                 other.num_threads);
+  };
+  auto nearest = db.entries.end();
+  if (it != db.entries.end() && same_shape(it->first)) {
+    nearest = it;
+  }
+  if (it != db.entries.begin() && same_shape(std::prev(it)->first)) {
+    auto below = std::prev(it);
+    // Buckets are powers of two, compare their ratios to the bucket of key
+    if (nearest == db.entries.end() ||
+        key.m_bucket * key.m_bucket <
+            below->first.m_bucket * nearest->first.m_bucket) {
+      nearest = below;
+    }
+  }
+  return nearest;
+}
+
+} // namespace
+
+int64_t get_m_bucket(int64_t M) {
+  int64_t bucket = 1;
+  while (bucket < M) {
+    bucket *= 2;
+  }
+  return bucket;
+}
+
+WoqTuningConfig get_config(const WoqTuningKey& key) {
+  if (override_config != nullptr) {
+    return *override_config;
+  }
+  auto& db = get_db();
+  auto& cache = thread_config_cache;
+  auto version = db.version.load(std::memory_order_acquire);
+  if (cache.version != version) {
+    cache.entries.clear();
+    cache.version = version;
+  }
+  auto cached = cache.entries.find(key);
+  if (cached != cache.entries.end()) {
+    return cached->second;
+  }
+  WoqTuningConfig config;
+  {
+    std::lock_guard<std::mutex> lock(db.mutex);
+    auto it = find_nearest_locked(db, key);
+    if (it != db.entries.end()) {
+      config = it->second;
+    }
+  }
+  cache.entries.emplace(key, config);
+  return config;
+}
+
+bool has_config(const WoqTuningKey& key) {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  return db.entries.count(key) > 0;
+}
+
+void set_config(const WoqTuningKey& key, const WoqTuningConfig& config) {
+  TORCH_CHECK(
+      is_valid_config(config), "WoQ tuning database: invalid config to set");
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  db.entries[key] = config;
+  db.version.fetch_add(1, std::memory_order_release);
+  if (db_path_from_env() != nullptr) {
+    save_db_locked(db, db_path_from_env());
+  }
+}
+
+bool is_autotune_enabled() {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  return db.autotune;
+}
+
+void set_autotune_enabled(bool enabled) {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  db.autotune = enabled;
+}
+
+void load_db(const std::string& path) {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  load_db_locked(db, path);
+}
+
+void save_db(const std::string& path) {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  save_db_locked(db, path);
+}
+
+void clear_db() {
+  auto& db = get_db();
+  std::lock_guard<std::mutex> lock(db.mutex);
+  db.entries.clear();
+  db.version.fetch_add(1, std::memory_order_release);
+}
+
+ConfigOverrideGuard::ConfigOverrideGuard(const WoqTuningConfig& config)
+    : config_(config), prev_(override_config) {
+  override_config = &config_;
+}
+
+ConfigOverrideGuard::~ConfigOverrideGuard() {
+  override_config = prev_;
+}
+
+} // namespace woq_tuning
+} // namespace cpu
+} // namespace torch_ipex
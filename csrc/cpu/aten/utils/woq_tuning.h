@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Upper bound of a tuned block_m, which sizes the buffers of a thread in the
+// kernels
+constexpr int64_t kMaxBlockM = 256;
+
+// Blocking and scheduling parameters of the WoQ TPP GEMM. block_n and block_k
+// decide the layout of the packed weight and are used when the weight is
+// packed, the others are read by the kernel at every call.
+struct WoqTuningConfig {
+  int64_t block_n = 32;
+  // 0: min(group_size, 64), halved until K is a multiple of it
+  int64_t block_k = 0;
+  // distance in rows of K to prefetch the weight ahead, 0 to disable
+  int64_t prefetch_k_dist = 64;
+  // 0: selected by M, at most kMaxBlockM
+  int64_t block_m = 0;
+  // number of splits along K for small M, each split is computed by a
+  // different thread and reduced at the end
+  int64_t k_splits = 1;
+  // M from which the loop is parallelized over M first
+  int64_t parallel_m_threshold = 128;
+  // M (of a block) below which the dequant micro-kernel is used instead of
+  // dequant + brgemm
+  int64_t small_batch_threshold = 32;
+};
+
+// A tuning entry is specific to a weight shape, a weight dtype, a quantization
+// group size, a lowp mode and a number of threads. m_bucket is M rounded up to
+// a power of two, and 0 for the entry holding the block sizes to pack with.
+struct WoqTuningKey {
+  int64_t N;
+  int64_t K;
+  int64_t qw_type;
+  int64_t group_size;
+  int64_t lowp_mode;
+  int64_t num_threads;
+  int64_t m_bucket;
+
+  bool operator<(const WoqTuningKey& other) const {
+    return std::tie(
+               N, K, qw_type, group_size, lowp_mode, num_threads, m_bucket) <
+        std::tie(other.N,
+                 other.K,
+                 other.qw_type,
+                 other.group_size,
+                 other.lowp_mode,
+                 other.num_threads,
+                 other.m_bucket);
+  }
+};
+
+namespace woq_tuning {
+
+// Round M up to a power of two
+int64_t get_m_bucket(int64_t M);
+
+// Return the tuned config of the key, or of the nearest tuned M bucket of the
+// same weight, or the default config if the weight is not tuned. A config
+// forced on the calling thread by ConfigOverrideGuard takes precedence. The
+// tuning database given by IPEX_WOQ_TUNING_DB is loaded at the first lookup.
+// The configs are cached by the calling thread, so that the lookups of a key
+// after the first one take no lock until the database changes.
+WoqTuningConfig get_config(const WoqTuningKey& key);
+
+bool has_config(const WoqTuningKey& key);
+
+// Record a config. The database is written back to IPEX_WOQ_TUNING_DB if set,
+// through a temporary file which replaces it.
+void set_config(const WoqTuningKey& key, const WoqTuningConfig& config);
+
+// Whether to benchmark the candidates of a weight shape when it is packed
+// for the first time and no tuned config exists. Enabled by
+// IPEX_WOQ_AUTOTUNE=1.
+bool is_autotune_enabled();
+void set_autotune_enabled(bool enabled);
+
+// The database is a text file with one entry per line:
+//   N K qw_type group_size lowp_mode num_threads m_bucket block_n block_k
+//   prefetch_k_dist block_m k_splits parallel_m_threshold
+//   small_batch_threshold
+// Lines starting with '#' are ignored. Entries loaded later override earlier
+// ones of the same key. load_db throws on a malformed entry and keeps the
+// database as it is, while a malformed IPEX_WOQ_TUNING_DB is ignored with a
+// warning.
+void load_db(const std::string& path);
+void save_db(const std::string& path);
+void clear_db();
+
+// Force the config of all the lookups on the calling thread, used to
+// benchmark a candidate
+class ConfigOverrideGuard {
+ public:
+  explicit ConfigOverrideGuard(const WoqTuningConfig& config);
+  ~ConfigOverrideGuard();
+
+  ConfigOverrideGuard(const ConfigOverrideGuard&) = delete;
+  ConfigOverrideGuard& operator=(const ConfigOverrideGuard&) = delete;
+
+ private:
+  WoqTuningConfig config_;
+  const WoqTuningConfig* prev_;
+};
+
+} // namespace woq_tuning
+} // namespace cpu
+} // namespace torch_ipex
@@ -7,8 +7,13 @@
 #include <dnnl.hpp>
 
 #include <algorithm>
+#include <cctype>
 #include <cstdlib>
 #include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 
 namespace torch_ipex {
 namespace cpu {
@@ -41,6 +46,18 @@ const char* CPUCapabilityToString(CPUCapability isa) {
   }
 }
 
+CPUCapability CPUCapabilityFromString(const std::string& isa) {
+  for (int32_t i = 0; i < kNumCPUCapabilities; i++) {
+    auto level = static_cast<CPUCapability>(i);
+    std::string name = CPUCapabilityToString(level);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == isa) {
+      return level;
+    }
+  }
+  return CPUCapability::NUM_OPTIONS;
+}
+
 CPUCapability _get_highest_cpu_support_isa_level() {
   /*
   reference to FindAVX.cmake
@@ -163,23 +180,8 @@ static CPUCapability compute_cpu_capability() {
   */
   auto envar = std::getenv("ATEN_CPU_CAPABILITY");
   if (envar) {
-    if (strcmp(envar, "avx512_fp16") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_FP16;
-    } else if (strcmp(envar, "amx") == 0) {
-      manual_setup_isa_level = CPUCapability::AMX;
-    } else if (strcmp(envar, "avx512_bf16") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_BF16;
-    } else if (strcmp(envar, "avx512_vnni") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512_VNNI;
-    } else if (strcmp(envar, "avx512") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX512;
-    } else if (strcmp(envar, "avx2_vnni") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX2_VNNI;
-    } else if (strcmp(envar, "avx2") == 0) {
-      manual_setup_isa_level = CPUCapability::AVX2;
-    } else if (strcmp(envar, "default") == 0) {
-      manual_setup_isa_level = CPUCapability::DEFAULT;
-    } else {
+    manual_setup_isa_level = CPUCapabilityFromString(envar);
+    if (manual_setup_isa_level == CPUCapability::NUM_OPTIONS) {
       TORCH_WARN("ignoring invalid value for ATEN_CPU_CAPABILITY: ", envar);
       b_manual_setup = false;
     }
@@ -209,6 +211,173 @@ CPUCapability get_cpu_capability() {
   return g_cpu_capability;
 }
 
+std::atomic<bool> dispatch_telemetry_enabled{[] {
+  auto envar = std::getenv("IPEX_DISPATCH_TELEMETRY");
+  return envar && strcmp(envar, "1") == 0;
+}()};
+
+namespace {
+
+struct DispatchStubRegistry {
+  std::mutex mutex;
+  std::vector<DispatchStubImpl*> stubs;
+  std::unordered_map<std::string, CPUCapability> isa_overrides;
+};
+
+void load_isa_overrides(DispatchStubRegistry& registry) {
+  auto envar = std::getenv("IPEX_DISPATCH_ISA_OVERRIDE");
+  if (!envar) {
+    return;
+  }
+  std::stringstream overrides(envar);
+  std::string item;
+  while (std::getline(overrides, item, ',')) {
+    auto pos = item.find('=');
+    auto isa = pos == std::string::npos
+        ? CPUCapability::NUM_OPTIONS
+        : CPUCapabilityFromString(item.substr(pos + 1));
+    if (isa == CPUCapability::NUM_OPTIONS) {
+      TORCH_WARN(
+          "ignoring invalid item of IPEX_DISPATCH_ISA_OVERRIDE: ",
+          item,
+          ", expect <stub name>=<isa>");
+      continue;
+    }
+    registry.isa_overrides[item.substr(0, pos)] = isa;
+  }
+}
+
+// Leaked on purpose, so that it outlives the stubs of the other translation
+// units at exit
+DispatchStubRegistry& dispatch_stub_registry() {
+  static DispatchStubRegistry* registry = [] {
+    auto registry = new DispatchStubRegistry();
+    load_isa_overrides(*registry);
+    return registry;
+  }();
+  return *registry;
+}
+
+CPUCapability get_stub_cpu_capability(const char* name) {
+  if (name != nullptr) {
+    auto& registry = dispatch_stub_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.isa_overrides.find(name);
+    if (it != registry.isa_overrides.end()) {
+      return std::min(
+          {it->second,
+           _get_highest_cpu_support_isa_level(),
+           _get_highest_binary_support_isa_level()});
+    }
+  }
+  return get_cpu_capability();
+}
+
+// The stubs choose their kernels again on the next call
+void reset_dispatch_ptrs(
+    DispatchStubRegistry& registry,
+    const std::string& stub_name) {
+  for (auto stub : registry.stubs) {
+    if (stub_name.empty() || stub_name == stub->name) {
+      stub->cpu_dispatch_ptr.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace
+
+void set_dispatch_isa_override(
+    const std::string& stub_name,
+    CPUCapability isa) {
+  TORCH_CHECK(
+      isa != CPUCapability::NUM_OPTIONS,
+      "DispatchStub: invalid ISA override for ",
+      stub_name);
+  auto& registry = dispatch_stub_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.isa_overrides[stub_name] = isa;
+  reset_dispatch_ptrs(registry, stub_name);
+}
+
+void clear_dispatch_isa_override(const std::string& stub_name) {
+  auto& registry = dispatch_stub_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (stub_name.empty()) {
+    registry.isa_overrides.clear();
+  } else {
+    registry.isa_overrides.erase(stub_name);
+  }
+  reset_dispatch_ptrs(registry, stub_name);
+}
+
+void set_dispatch_telemetry_enabled(bool enabled) {
+  dispatch_telemetry_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<DispatchStubStats> get_dispatch_stats() {
+  std::vector<DispatchStubStats> stats;
+  auto& registry = dispatch_stub_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto stub : registry.stubs) {
+    for (int32_t isa = 0; isa < kNumCPUCapabilities; isa++) {
+      auto calls = stub->call_counts[isa].load(std::memory_order_relaxed);
+      if (calls > 0) {
+        stats.push_back(
+            {stub->name,
+             static_cast<CPUCapability>(isa),
+             calls,
+             stub->call_ns[isa].load(std::memory_order_relaxed)});
+      }
+    }
+  }
+  return stats;
+}
+
+void reset_dispatch_stats() {
+  auto& registry = dispatch_stub_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto stub : registry.stubs) {
+    for (int32_t isa = 0; isa < kNumCPUCapabilities; isa++) {
+      stub->call_counts[isa].store(0, std::memory_order_relaxed);
+      stub->call_ns[isa].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+std::string dump_dispatch_stats() {
+  auto stats = get_dispatch_stats();
+  std::sort(
+      stats.begin(),
+      stats.end(),
+      [](const DispatchStubStats& a, const DispatchStubStats& b) {
+        return a.total_ns > b.total_ns;
+      });
+  std::stringstream ss;
+  ss << std::left << std::setw(48) << "stub" << std::setw(14) << "isa"
+     << std::right << std::setw(12) << "calls" << std::setw(16)
+     << "total (us)" << std::setw(14) << "avg (us)" << "\n";
+  for (const auto& stat : stats) {
+    ss << std::left << std::setw(48) << stat.stub_name << std::setw(14)
+       << CPUCapabilityToString(stat.isa) << std::right << std::setw(12)
+       << stat.calls << std::fixed << std::setprecision(3) << std::setw(16)
+       << stat.total_ns / 1e3 << std::setw(14)
+       << stat.total_ns / 1e3 / stat.calls << "\n";
+  }
+  return ss.str();
+}
+
+DispatchStubImpl::DispatchStubImpl(const char* name) : name(name) {
+  auto& registry = dispatch_stub_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.stubs.push_back(this);
+}
+
+void DispatchStubImpl::record_call(uint64_t ns) {
+  auto isa = this->cpu_dispatch_isa.load(std::memory_order_relaxed);
+  this->call_counts[isa].fetch_add(1, std::memory_order_relaxed);
+  this->call_ns[isa].fetch_add(ns, std::memory_order_relaxed);
+}
+
 void* DispatchStubImpl::get_call_ptr(
     DeviceType device_type,
     void* DEFAULT
@@ -326,8 +495,13 @@ void* DispatchStubImpl::choose_cpu_impl(
     void* AVX2
 #endif
 ) {
-  auto capability = static_cast<int>(get_cpu_capability());
+  auto capability = static_cast<int>(get_stub_cpu_capability(this->name));
   (void)capability;
+  auto choose = [this](void* fn, CPUCapability isa) {
+    this->cpu_dispatch_isa.store(
+        static_cast<int32_t>(isa), std::memory_order_relaxed);
+    return fn;
+  };
 #ifdef HAVE_AVX512_FP16_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX512_FP16)) {
     // Quantization kernels have also been disabled on Windows
@@ -336,9 +510,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_FP16)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return choose(AVX2, CPUCapability::AVX2);
     } else {
-      return AVX512_FP16;
+      return choose(AVX512_FP16, CPUCapability::AVX512_FP16);
     }
   }
 #endif
@@ -350,9 +524,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AMX)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return choose(AVX2, CPUCapability::AVX2);
     } else {
-      return AMX;
+      return choose(AMX, CPUCapability::AMX);
     }
   }
 #endif
@@ -364,9 +538,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_BF16)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return choose(AVX2, CPUCapability::AVX2);
     } else {
-      return AVX512_BF16;
+      return choose(AVX512_BF16, CPUCapability::AVX512_BF16);
     }
   }
 #endif
@@ -378,9 +552,9 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512_VNNI)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return choose(AVX2, CPUCapability::AVX2);
     } else {
-      return AVX512_VNNI;
+      return choose(AVX512_VNNI, CPUCapability::AVX512_VNNI);
     }
   }
 #endif
@@ -392,27 +566,27 @@ void* DispatchStubImpl::choose_cpu_impl(
     if (C10_UNLIKELY(!AVX512)) {
       // dispatch to AVX2, since the AVX512 kernel is missing
       TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-      return AVX2;
+      return choose(AVX2, CPUCapability::AVX2);
     } else {
-      return AVX512;
+      return choose(AVX512, CPUCapability::AVX512);
     }
   }
 #endif
 #ifdef HAVE_AVX2_VNNI_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX2_VNNI)) {
     TORCH_INTERNAL_ASSERT(AVX2_VNNI, "DispatchStub: missing AVX2_VNNI kernel");
-    return AVX2_VNNI;
+    return choose(AVX2_VNNI, CPUCapability::AVX2_VNNI);
   }
 #endif
 #ifdef HAVE_AVX2_CPU_DEFINITION
   if (capability >= static_cast<int>(CPUCapability::AVX2)) {
     TORCH_INTERNAL_ASSERT(AVX2, "DispatchStub: missing AVX2 kernel");
-    return AVX2;
+    return choose(AVX2, CPUCapability::AVX2);
   }
 #endif
 
   TORCH_INTERNAL_ASSERT(DEFAULT, "DispatchStub: missing default kernel");
-  return DEFAULT;
+  return choose(DEFAULT, CPUCapability::DEFAULT);
 }
 
 } // namespace cpu
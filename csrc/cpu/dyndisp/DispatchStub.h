@@ -5,8 +5,12 @@
 #include <c10/util/Exception.h>
 
 #include <Macros.h>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 using namespace c10;
 
@@ -62,7 +66,13 @@ enum class CPUCapability {
   NUM_OPTIONS
 };
 
+constexpr int32_t kNumCPUCapabilities =
+    static_cast<int32_t>(CPUCapability::NUM_OPTIONS);
+
 const char* CPUCapabilityToString(CPUCapability isa);
+// Parse the lower case names of ATEN_CPU_CAPABILITY, e.g. "avx512_bf16".
+// Return NUM_OPTIONS for an invalid name.
+CPUCapability CPUCapabilityFromString(const std::string& isa);
 CPUCapability _get_highest_cpu_support_isa_level();
 CPUCapability _get_highest_binary_support_isa_level();
 
@@ -70,6 +80,34 @@ bool check_not_sync_onednn_isa_level();
 
 CPUCapability get_cpu_capability();
 
+// Per stub ISA override. The stub of the name dispatches as if the ISA level
+// were isa, capped by the levels supported by the CPU and the binary, while
+// the other stubs keep the level of ATEN_CPU_CAPABILITY. The overrides are
+// also read from the environment variable IPEX_DISPATCH_ISA_OVERRIDE, e.g.
+// "flash_attention_kernel_stub=avx512,add_softmax_inplace_stub=avx2".
+IPEX_API void set_dispatch_isa_override(
+    const std::string& stub_name,
+    CPUCapability isa);
+// Clear the override of the stub, or all of them for an empty name
+IPEX_API void clear_dispatch_isa_override(const std::string& stub_name = "");
+
+// Dispatch telemetry: calls and inclusive time of the stubs per ISA of the
+// kernel run. Off by default, or enabled by IPEX_DISPATCH_TELEMETRY=1.
+struct DispatchStubStats {
+  std::string stub_name;
+  CPUCapability isa;
+  uint64_t calls;
+  uint64_t total_ns;
+};
+
+extern IPEX_API std::atomic<bool> dispatch_telemetry_enabled;
+IPEX_API void set_dispatch_telemetry_enabled(bool enabled);
+// Stats of the stubs and ISAs called since the last reset
+IPEX_API std::vector<DispatchStubStats> get_dispatch_stats();
+IPEX_API void reset_dispatch_stats();
+// Table of the stats, the slowest first
+IPEX_API std::string dump_dispatch_stats();
+
 template <typename FnPtr, typename T>
 struct DispatchStub;
 
@@ -80,6 +118,10 @@ struct DispatchStub;
  * number of specialization of the DispatchStub<> class.
  */
 struct IPEX_API DispatchStubImpl {
+  DispatchStubImpl() = default;
+  // Named stubs are registered for the ISA overrides and the telemetry
+  explicit DispatchStubImpl(const char* name);
+
   void* get_call_ptr(
       DeviceType device_type,
       void* DEFAULT
@@ -150,6 +192,9 @@ struct IPEX_API DispatchStubImpl {
 #endif
   );
 
+  // Telemetry of a call to the chosen kernel
+  void record_call(uint64_t ns);
+
 // Fixing dispatch error in Windows debug builds.
 // See https://github.com/pytorch/pytorch/issues/22681 for more details.
 #if defined(_MSC_VER) && defined(_DEBUG)
@@ -159,6 +204,24 @@ struct IPEX_API DispatchStubImpl {
   std::atomic<void*> cpu_dispatch_ptr{nullptr};
   void* xpu_dispatch_ptr = nullptr;
 #endif
+  const char* name = nullptr;
+  // ISA of the kernel of cpu_dispatch_ptr
+  std::atomic<int32_t> cpu_dispatch_isa{0};
+  std::array<std::atomic<uint64_t>, kNumCPUCapabilities> call_counts{};
+  std::array<std::atomic<uint64_t>, kNumCPUCapabilities> call_ns{};
+};
+
+struct DispatchTelemetryScope {
+  explicit DispatchTelemetryScope(DispatchStubImpl& impl)
+      : impl(impl), start(std::chrono::steady_clock::now()) {}
+  ~DispatchTelemetryScope() {
+    impl.record_call(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count());
+  }
+
+  DispatchStubImpl& impl;
+  std::chrono::steady_clock::time_point start;
 };
 
 template <typename rT, typename T, typename... Args>
@@ -166,6 +229,7 @@ struct DispatchStub<rT (*)(Args...), T> {
   using FnPtr = rT (*)(Args...);
 
   DispatchStub() = default;
+  explicit DispatchStub(const char* name) : impl(name) {}
   DispatchStub(const DispatchStub&) = delete;
   DispatchStub& operator=(const DispatchStub&) = delete;
 
@@ -209,6 +273,11 @@ struct DispatchStub<rT (*)(Args...), T> {
   template <typename... ArgTypes>
   rT operator()(DeviceType device_type, ArgTypes&&... args) {
     FnPtr call_ptr = get_call_ptr(device_type);
+    if (C10_LIKELY(
+            !dispatch_telemetry_enabled.load(std::memory_order_relaxed))) {
+      return (*call_ptr)(std::forward<ArgTypes>(args)...);
+    }
+    DispatchTelemetryScope scope(impl);
     return (*call_ptr)(std::forward<ArgTypes>(args)...);
   }
 
@@ -265,12 +334,12 @@ struct RegisterHIPDispatch {
 // adding parentheses and using helper struct to get rid of the parentheses, do
 // not work with MSVC. So do a `using`-declaration if you need to pass in such
 // `fn`, e.g., grid_sampler_2d_backward_cpu_kernel in GridSampleKernel.h.
-#define IPEX_DECLARE_DISPATCH(fn, name)    \
-  struct name : DispatchStub<fn, name> {   \
-    name() = default;                      \
-    name(const name&) = delete;            \
-    name& operator=(const name&) = delete; \
-  };                                       \
+#define IPEX_DECLARE_DISPATCH(fn, name)       \
+  struct name : DispatchStub<fn, name> {      \
+    name() : DispatchStub<fn, name>(#name) {} \
+    name(const name&) = delete;               \
+    name& operator=(const name&) = delete;    \
+  };                                          \
   extern IPEX_API struct name name
 
 #define IPEX_DEFINE_DISPATCH(name) struct name name
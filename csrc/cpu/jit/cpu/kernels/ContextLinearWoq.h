@@ -20,6 +20,16 @@ struct ContextLinearWoq final {
   int64_t lowp_mode_;
   int64_t num_concats_;
   int64_t act_quant_mode_;
+  // Group index of each input channel for GPTQ act-order (desc_act) weights,
+  // whose groups are not contiguous along K. The input channels of the packed
+  // weight are sorted by group, and those of the input are gathered by k_perm_
+  // before the GEMM.
+  c10::optional<at::Tensor> g_idx_;
+  c10::optional<at::Tensor> k_perm_;
+  // WOQ_DTYPE_* of the weight. is_int4_ is true for all dtypes packed two
+  // values per byte, and false for int2, int3 and mxfp6 packed by
+  // woq_dtype_bits.
+  int64_t weight_dtype_;
 
   ContextLinearWoq() = delete;
 
@@ -33,7 +43,10 @@ struct ContextLinearWoq final {
       int64_t group_size = -1,
       int64_t lowp_mode = 0,
       int64_t num_concats = 1,
-      int64_t act_quant_mode = 0)
+      int64_t act_quant_mode = 0,
+      c10::optional<at::Tensor>&& g_idx = c10::nullopt,
+      c10::optional<at::Tensor>&& k_perm = c10::nullopt,
+      int64_t weight_dtype = 0)
       : at_weight_(std::move(at_weight)),
         weight_shape_(std::move(weight_shape)),
         at_bias_(std::move(bias)),
@@ -41,7 +54,10 @@ struct ContextLinearWoq final {
         group_size_(group_size),
         lowp_mode_(lowp_mode),
         num_concats_(num_concats),
-        act_quant_mode_(act_quant_mode) {
+        act_quant_mode_(act_quant_mode),
+        g_idx_(std::move(g_idx)),
+        k_perm_(std::move(k_perm)),
+        weight_dtype_(weight_dtype) {
     // Make three dtype versions of scale, zp and bias
     // There is one more dtype for zp
     if (group_size > 0) {
@@ -50,12 +66,10 @@ struct ContextLinearWoq final {
       // -> [#block_n, #block_k, block_n]
       at::Tensor scales_perm, zp_perm;
       if (at_weight_.dim() == 4) {
-        // packed weight in 4d (Nc, Kc, block_k, block_n)
-        int64_t block_n = at_weight_.size(-1);
-        if (is_int4) {
-          block_n *= 2;
-        }
-        TORCH_CHECK(scales_float.size(0) % block_n == 0);
+        // packed weight in 4d (Nc, Kc, block_k, block_n), whose last dim
+        // takes less than block_n bytes for weight of less than 8 bits
+        TORCH_CHECK(scales_float.size(0) % at_weight_.size(0) == 0);
+        int64_t block_n = scales_float.size(0) / at_weight_.size(0);
         std::vector<int64_t> reshape_dim = {
             scales_float.size(0) / block_n, block_n, scales_float.size(1)};
         scales_perm = scales_float.view(reshape_dim)
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <ideep.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+// Weights of one RNN layer packed for a given chunk shape. The ATen tensors
+// own the memory when the packed ideep tensors are views of them.
+struct RNNPackedLayer {
+  at::Tensor at_weight_ih_;
+  at::Tensor at_weight_hh_;
+  at::Tensor at_bias_;
+  ideep::tensor weight_ih_;
+  ideep::tensor weight_hh_;
+  ideep::tensor bias_;
+  // linear-before-reset GRU primitive of the chunk shape, GRU only
+  dnnl::lbr_gru_forward::primitive_desc gru_pd_;
+  dnnl::lbr_gru_forward gru_;
+};
+
+// Packed layers of one chunk shape. Shared with the running chunks, so that
+// evicting them from the context does not free the weights in use.
+struct RNNPackedEntry {
+  std::shared_ptr<const std::vector<RNNPackedLayer>> layers_;
+  // value of ContextRNN::packed_clock_ at the last use
+  int64_t last_use_;
+};
+
+// Hidden (and cell, for LSTM) state carried across chunks of one stream
+struct RNNStreamState {
+  std::vector<at::Tensor> hx_;
+  std::vector<at::Tensor> cx_;
+};
+
+// (seq_length, mini_batch, dtype) of the chunk the weights are packed for
+using RNNChunkKey = std::tuple<int64_t, int64_t, int64_t>;
+
+struct ContextRNN final {
+  // Chunk shapes whose packed weights are kept at the same time. Streaming
+  // callers use a few chunk lengths, while the tail chunks of arbitrary
+  // length would otherwise grow the cache without bound.
+  static constexpr size_t kMaxPackedChunkShapes = 16;
+
+  std::string mode_;
+  int64_t input_size_;
+  int64_t hidden_size_;
+  int64_t num_layers_;
+  bool has_biases_;
+  bool batch_first_;
+  // original per-layer weights in PyTorch layout, used for serialization
+  std::vector<at::Tensor> at_params_;
+  // per-layer weights with gates shuffled into the oneDNN order
+  std::vector<at::Tensor> at_weight_ih_;
+  std::vector<at::Tensor> at_weight_hh_;
+  std::vector<at::Tensor> at_bias_;
+
+  // at most kMaxPackedChunkShapes entries, the least recently used one is
+  // evicted first
+  std::map<RNNChunkKey, RNNPackedEntry> packed_weights_;
+  int64_t packed_clock_ = 0;
+  std::unordered_map<int64_t, RNNStreamState> states_;
+  // guards packed_weights_ and states_; streams run concurrently
+  std::unique_ptr<std::mutex> mutex_;
+
+  ContextRNN() = delete;
+
+  ContextRNN(
+      std::string&& mode,
+      int64_t input_size,
+      int64_t hidden_size,
+      int64_t num_layers,
+      bool has_biases,
+      bool batch_first,
+      std::vector<at::Tensor>&& at_params,
+      std::vector<at::Tensor>&& at_weight_ih,
+      std::vector<at::Tensor>&& at_weight_hh,
+      std::vector<at::Tensor>&& at_bias)
+      : mode_(std::move(mode)),
+        input_size_(input_size),
+        hidden_size_(hidden_size),
+        num_layers_(num_layers),
+        has_biases_(has_biases),
+        batch_first_(batch_first),
+        at_params_(std::move(at_params)),
+        at_weight_ih_(std::move(at_weight_ih)),
+        at_weight_hh_(std::move(at_weight_hh)),
+        at_bias_(std::move(at_bias)),
+        mutex_(new std::mutex()) {}
+
+  ContextRNN(ContextRNN&&) = default;
+  ContextRNN& operator=(ContextRNN&&) = default;
+
+  ~ContextRNN() {}
+};
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -7,7 +7,13 @@
 #include <c10/util/Logging.h>
 #include <torch/csrc/autograd/function.h>
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
 
 #include <ideep.hpp>
 #include "Matmul.h"
@@ -787,5 +793,530 @@ at::Tensor einsum_binary(
   return result;
 }
 
+namespace {
+
+constexpr uint8_t kEinsumLabels = 52;
+// Operands of the equations searched for the path of the least cost, the
+// others are contracted greedily
+constexpr size_t kMaxOptimalEinsumOperands = 6;
+constexpr size_t kMaxCachedEinsumPlans = 1024;
+
+using EinsumLabels = std::vector<uint8_t>;
+using EinsumLabelSet = std::bitset<kEinsumLabels>;
+using EinsumLabelSizes = std::array<int64_t, kEinsumLabels>;
+using EinsumPath = std::vector<std::pair<size_t, size_t>>;
+
+// One pairwise contraction of a multi-operand einsum, run as the batched
+// matmul [batch, m, k] x [batch, k, n] -> [batch, m, n]
+struct EinsumStep {
+  // Live operands contracted by the step, left < right. They are removed
+  // from the live operands and the result is appended.
+  size_t left;
+  size_t right;
+  // Labels of only one of the operands which are not used later, summed
+  // before the matmul
+  EinsumLabels left_sum;
+  EinsumLabels right_sum;
+  EinsumLabels batch;
+  EinsumLabels m;
+  EinsumLabels k;
+  EinsumLabels n;
+};
+
+struct EinsumPlan {
+  std::vector<EinsumLabels> operand_labels;
+  EinsumLabels output_labels;
+  EinsumLabelSizes label_sizes;
+  std::vector<EinsumStep> steps;
+};
+
+//! function: einsum_parse_labels
+/*!
+ * Parse the labels of the operands and of the output of the equation.
+ * Return false for the equations the planner does not support: ellipsis,
+ * repeated labels of one operand (diagonals), and the malformed ones, which
+ * are left to at::einsum to report.
+ */
+bool einsum_parse_labels(
+    c10::string_view equation,
+    size_t num_ops,
+    std::vector<EinsumLabels>& op_labels,
+    EinsumLabels& out_labels) {
+  const auto arrow_pos = equation.find("->");
+  const auto lhs = equation.substr(0, arrow_pos);
+  op_labels.assign(num_ops, EinsumLabels());
+  std::vector<int64_t> label_count(kEinsumLabels, 0);
+  size_t curr_op = 0;
+  for (const unsigned char label : lhs) {
+    if (label == ' ') {
+      continue;
+    }
+    if (label == ',') {
+      if (++curr_op == num_ops) {
+        return false;
+      }
+      continue;
+    }
+    if (!einsum_check_label(label)) {
+      return false;
+    }
+    const auto index = einsum_label_to_index(label);
+    auto& labels = op_labels[curr_op];
+    if (std::find(labels.begin(), labels.end(), index) != labels.end()) {
+      return false;
+    }
+    labels.push_back(index);
+    label_count[index]++;
+  }
+  if (curr_op != num_ops - 1) {
+    return false;
+  }
+
+  out_labels.clear();
+  if (arrow_pos == std::string::npos) {
+    // Implicit output is the labels seen only once, in alphabetical order
+    for (const auto label : c10::irange(kEinsumLabels)) {
+      if (label_count[label] == 1) {
+        out_labels.push_back(label);
+      }
+    }
+    return true;
+  }
+  for (const unsigned char label : equation.substr(arrow_pos + 2)) {
+    if (label == ' ') {
+      continue;
+    }
+    if (!einsum_check_label(label)) {
+      return false;
+    }
+    const auto index = einsum_label_to_index(label);
+    if (label_count[index] == 0 ||
+        std::find(out_labels.begin(), out_labels.end(), index) !=
+            out_labels.end()) {
+      return false;
+    }
+    out_labels.push_back(index);
+  }
+  return true;
+}
+
+EinsumLabels to_labels(const EinsumLabelSet& set) {
+  EinsumLabels labels;
+  for (const auto label : c10::irange(kEinsumLabels)) {
+    if (set[label]) {
+      labels.push_back(label);
+    }
+  }
+  return labels;
+}
+
+double label_set_numel(
+    const EinsumLabelSet& set,
+    const EinsumLabelSizes& sizes) {
+  double numel = 1;
+  for (const auto label : c10::irange(kEinsumLabels)) {
+    if (set[label]) {
+      numel *= sizes[label];
+    }
+  }
+  return numel;
+}
+
+//! function: einsum_pair_cost
+/*!
+ * Cost of contracting the live operands i and j: the multiply-adds of the
+ * matmul plus the elements of its result, and the elements read to sum the
+ * labels of only one of them. The labels of the result are returned in
+ * result.
+ */
+double einsum_pair_cost(
+    const std::vector<EinsumLabelSet>& live,
+    size_t i,
+    size_t j,
+    const EinsumLabelSet& output,
+    const EinsumLabelSizes& sizes,
+    EinsumLabelSet& result) {
+  // Labels used after the step
+  auto keep = output;
+  for (const auto o : c10::irange(live.size())) {
+    if (o != i && o != j) {
+      keep |= live[o];
+    }
+  }
+  const auto shared = live[i] & live[j];
+  result = (live[i] | live[j]) & keep;
+  auto cost =
+      label_set_numel(result | shared, sizes) + label_set_numel(result, sizes);
+  if ((live[i] & ~shared & ~keep).any()) {
+    cost += label_set_numel(live[i], sizes);
+  }
+  if ((live[j] & ~shared & ~keep).any()) {
+    cost += label_set_numel(live[j], sizes);
+  }
+  return cost;
+}
+
+std::vector<EinsumLabelSet> contract_live(
+    const std::vector<EinsumLabelSet>& live,
+    size_t i,
+    size_t j,
+    const EinsumLabelSet& result) {
+  auto next = live;
+  next.erase(next.begin() + j);
+  next.erase(next.begin() + i);
+  next.push_back(result);
+  return next;
+}
+
+void search_optimal_path(
+    const std::vector<EinsumLabelSet>& live,
+    const EinsumLabelSet& output,
+    const EinsumLabelSizes& sizes,
+    double cost,
+    EinsumPath& path,
+    double& best_cost,
+    EinsumPath& best_path) {
+  if (cost >= best_cost) {
+    return;
+  }
+  if (live.size() == 1) {
+    best_cost = cost;
+    best_path = path;
+    return;
+  }
+  for (const auto i : c10::irange(live.size())) {
+    for (const auto j : c10::irange(i + 1, live.size())) {
+      EinsumLabelSet result;
+      auto step_cost = einsum_pair_cost(live, i, j, output, sizes, result);
+      path.emplace_back(i, j);
+      search_optimal_path(
+          contract_live(live, i, j, result),
+          output,
+          sizes,
+          cost + step_cost,
+          path,
+          best_cost,
+          best_path);
+      path.pop_back();
+    }
+  }
+}
+
+EinsumPath search_greedy_path(
+    std::vector<EinsumLabelSet> live,
+    const EinsumLabelSet& output,
+    const EinsumLabelSizes& sizes) {
+  EinsumPath path;
+  while (live.size() > 1) {
+    auto best_cost = std::numeric_limits<double>::infinity();
+    size_t best_i = 0, best_j = 1;
+    EinsumLabelSet best_result;
+    for (const auto i : c10::irange(live.size())) {
+      for (const auto j : c10::irange(i + 1, live.size())) {
+        EinsumLabelSet result;
+        auto cost = einsum_pair_cost(live, i, j, output, sizes, result);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+          best_result = result;
+        }
+      }
+    }
+    path.emplace_back(best_i, best_j);
+    live = contract_live(live, best_i, best_j, best_result);
+  }
+  return path;
+}
+
+//! function: make_einsum_plan
+/*!
+ * Plan the pairwise contractions of the operands by their FLOPs and the
+ * sizes of the intermediates. Return nullptr if the equation or the shapes
+ * are not supported by the planner, e.g. broadcasting of the labels.
+ */
+std::shared_ptr<const EinsumPlan> make_einsum_plan(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  auto plan = std::make_shared<EinsumPlan>();
+  if (!einsum_parse_labels(
+          equation,
+          operands.size(),
+          plan->operand_labels,
+          plan->output_labels)) {
+    return nullptr;
+  }
+  plan->label_sizes.fill(-1);
+  std::vector<EinsumLabelSet> live;
+  for (const auto i : c10::irange(operands.size())) {
+    const auto& labels = plan->operand_labels[i];
+    const at::Tensor operand = operands.get(i);
+    if (operand.dim() != static_cast<int64_t>(labels.size())) {
+      return nullptr;
+    }
+    EinsumLabelSet set;
+    for (const auto d : c10::irange(labels.size())) {
+      auto& size = plan->label_sizes[labels[d]];
+      if (size != -1 && size != operand.size(d)) {
+        return nullptr;
+      }
+      size = operand.size(d);
+      set.set(labels[d]);
+    }
+    live.push_back(set);
+  }
+  EinsumLabelSet output;
+  for (const auto label : plan->output_labels) {
+    output.set(label);
+  }
+
+  EinsumPath path;
+  if (live.size() <= kMaxOptimalEinsumOperands) {
+    EinsumPath curr_path;
+    auto best_cost = std::numeric_limits<double>::infinity();
+    search_optimal_path(
+        live, output, plan->label_sizes, 0, curr_path, best_cost, path);
+  } else {
+    path = search_greedy_path(live, output, plan->label_sizes);
+  }
+
+  for (const auto& pair : path) {
+    const auto left = live[pair.first];
+    const auto right = live[pair.second];
+    EinsumLabelSet result;
+    einsum_pair_cost(
+        live, pair.first, pair.second, output, plan->label_sizes, result);
+    const auto shared = left & right;
+    EinsumStep step;
+    step.left = pair.first;
+    step.right = pair.second;
+    step.left_sum = to_labels(left & ~right & ~result);
+    step.right_sum = to_labels(right & ~left & ~result);
+    step.batch = to_labels(shared & result);
+    step.m = to_labels(left & ~right & result);
+    step.k = to_labels(shared & ~result);
+    step.n = to_labels(right & ~left & result);
+    plan->steps.push_back(std::move(step));
+    live = contract_live(live, pair.first, pair.second, result);
+  }
+  return plan;
+}
+
+// Plans are cached by the equation and the shapes of the operands
+std::shared_ptr<const EinsumPlan> get_einsum_plan(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  static std::mutex cache_mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const EinsumPlan>>
+      plan_cache;
+
+  std::string key(equation.data(), equation.size());
+  for (const auto i : c10::irange(operands.size())) {
+    key += ";";
+    for (const auto size : operands.get(i).sizes()) {
+      key += std::to_string(size) + ",";
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = plan_cache.find(key);
+    if (it != plan_cache.end()) {
+      return it->second;
+    }
+  }
+  auto plan = make_einsum_plan(equation, operands);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (plan_cache.size() >= kMaxCachedEinsumPlans) {
+    plan_cache.clear();
+  }
+  plan_cache.emplace(std::move(key), plan);
+  return plan;
+}
+
+std::vector<int64_t> label_dims(
+    const EinsumLabels& labels,
+    const EinsumLabels& tensor_labels) {
+  std::vector<int64_t> dims;
+  for (const auto label : labels) {
+    dims.push_back(
+        std::find(tensor_labels.begin(), tensor_labels.end(), label) -
+        tensor_labels.begin());
+  }
+  return dims;
+}
+
+int64_t labels_numel(
+    const EinsumLabels& labels,
+    const EinsumLabelSizes& sizes) {
+  int64_t numel = 1;
+  for (const auto label : labels) {
+    numel *= sizes[label];
+  }
+  return numel;
+}
+
+EinsumLabels concat_labels(
+    const EinsumLabels& a,
+    const EinsumLabels& b,
+    const EinsumLabels& c) {
+  EinsumLabels labels(a);
+  labels.insert(labels.end(), b.begin(), b.end());
+  labels.insert(labels.end(), c.begin(), c.end());
+  return labels;
+}
+
+// Order the labels as the dims of the tensor, the larger strides first, so
+// that the reshape of the permuted tensor collapses them into one dim
+// without a copy
+EinsumLabels order_by_strides(
+    EinsumLabels labels,
+    const at::Tensor& tensor,
+    const EinsumLabels& tensor_labels) {
+  auto dims = label_dims(labels, tensor_labels);
+  std::vector<size_t> order(labels.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return tensor.stride(dims[a]) > tensor.stride(dims[b]);
+  });
+  EinsumLabels ordered;
+  for (const auto i : order) {
+    ordered.push_back(labels[i]);
+  }
+  return ordered;
+}
+
+// Sum the dims of the labels, which are removed from tensor_labels
+at::Tensor sum_labels(
+    const at::Tensor& tensor,
+    EinsumLabels& tensor_labels,
+    const EinsumLabels& labels) {
+  if (labels.empty()) {
+    return tensor;
+  }
+  auto result = tensor.sum(label_dims(labels, tensor_labels));
+  EinsumLabels remaining;
+  for (const auto label : tensor_labels) {
+    if (std::find(labels.begin(), labels.end(), label) == labels.end()) {
+      remaining.push_back(label);
+    }
+  }
+  tensor_labels = std::move(remaining);
+  return result;
+}
+
+at::Tensor einsum_bmm(const at::Tensor& left, const at::Tensor& right) {
+  if (left.scalar_type() == at::kFloat ||
+      left.scalar_type() == at::kBFloat16) {
+    return bmm_impl(left, right, at::Tensor(), ideep::attr_t(), {}, 1.f);
+  }
+  return at::bmm(left, right);
+}
+
+//! function: einsum_contract_pair
+/*!
+ * Run one step of the plan. The operands are permuted and reshaped to
+ * [batch, m, k] and [batch, k, n], the labels of each group ordered as the
+ * strides of the operands, so that the reshapes are views for the
+ * contiguous operands and the intermediates, and the transposed layouts are
+ * passed to the matmul as they are. The result is [batch, m, n], of the
+ * labels returned in result_labels.
+ */
+at::Tensor einsum_contract_pair(
+    at::Tensor left,
+    EinsumLabels left_labels,
+    at::Tensor right,
+    EinsumLabels right_labels,
+    const EinsumStep& step,
+    const EinsumLabelSizes& sizes,
+    EinsumLabels& result_labels) {
+  left = sum_labels(left, left_labels, step.left_sum);
+  right = sum_labels(right, right_labels, step.right_sum);
+  // The labels of both operands follow the larger one, so that a copy, if
+  // any, is of the smaller one
+  const bool left_major = left.numel() >= right.numel();
+  const auto& major = left_major ? left : right;
+  const auto& major_labels = left_major ? left_labels : right_labels;
+  const auto batch = order_by_strides(step.batch, major, major_labels);
+  const auto k = order_by_strides(step.k, major, major_labels);
+  const auto m = order_by_strides(step.m, left, left_labels);
+  const auto n = order_by_strides(step.n, right, right_labels);
+
+  const auto batch_size = labels_numel(batch, sizes);
+  const auto k_size = labels_numel(k, sizes);
+  left = left.permute(label_dims(concat_labels(batch, m, k), left_labels))
+             .reshape({batch_size, labels_numel(m, sizes), k_size});
+  right = right.permute(label_dims(concat_labels(batch, k, n), right_labels))
+              .reshape({batch_size, k_size, labels_numel(n, sizes)});
+
+  result_labels = concat_labels(batch, m, n);
+  std::vector<int64_t> result_sizes;
+  for (const auto label : result_labels) {
+    result_sizes.push_back(sizes[label]);
+  }
+  return einsum_bmm(left, right).view(result_sizes);
+}
+
+} // namespace
+
+//! function: einsum_multi
+/*!
+ * This function computes the einsum of any number of operands by the
+ * contraction path planned for the equation and the shapes, running each
+ * pairwise contraction as one batched matmul. The plans are cached. The
+ * equations and inputs not supported by the planner (ellipsis, diagonals,
+ * broadcasting, mixed dtypes, empty operands) fall back to at::einsum.
+ *\param equation:  The subscripts for the Einstein summation.
+ *\param operands: The tensors to compute the Einstein summation of.
+ */
+at::Tensor einsum_multi(
+    c10::string_view equation,
+    const c10::List<at::Tensor>& operands) {
+  RECORD_FUNCTION("dil_einsum", c10::ArrayRef<c10::IValue>({}));
+  bool supported = !operands.empty();
+  for (const auto i : c10::irange(operands.size())) {
+    const at::Tensor operand = operands.get(i);
+    supported = supported && operand.layout() == at::kStrided &&
+        operand.numel() > 0 &&
+        operand.scalar_type() == operands.get(0).scalar_type();
+  }
+  auto plan = supported ? get_einsum_plan(equation, operands) : nullptr;
+  if (!plan) {
+    return at::einsum(equation, operands.vec());
+  }
+
+  auto live = operands.vec();
+  auto live_labels = plan->operand_labels;
+  for (const auto& step : plan->steps) {
+    EinsumLabels result_labels;
+    auto result = einsum_contract_pair(
+        live[step.left],
+        live_labels[step.left],
+        live[step.right],
+        live_labels[step.right],
+        step,
+        plan->label_sizes,
+        result_labels);
+    live.erase(live.begin() + step.right);
+    live.erase(live.begin() + step.left);
+    live_labels.erase(live_labels.begin() + step.right);
+    live_labels.erase(live_labels.begin() + step.left);
+    live.push_back(std::move(result));
+    live_labels.push_back(std::move(result_labels));
+  }
+
+  // The labels of a single operand which are not in the output
+  auto labels = live_labels[0];
+  EinsumLabels summed;
+  for (const auto label : labels) {
+    if (std::find(
+            plan->output_labels.begin(), plan->output_labels.end(), label) ==
+        plan->output_labels.end()) {
+      summed.push_back(label);
+    }
+  }
+  auto result = sum_labels(live[0], labels, summed);
+  return result.permute(label_dims(plan->output_labels, labels));
+}
+
 } // namespace cpu
 } // namespace torch_ipex
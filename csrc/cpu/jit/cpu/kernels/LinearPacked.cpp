@@ -34,6 +34,22 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
       std::move(weight), std::move(bias), batch_size);
 }
 
+c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContextFromPacked(
+    at::Tensor&& packed_weight,
+    std::vector<int64_t>&& weight_shape,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size) {
+  RECORD_FUNCTION(
+      "ipex_prepack::createLinearPrePackOpContextFromPacked",
+      c10::ArrayRef<c10::IValue>({}));
+
+  return IpexLinearOpContext::create_context_from_packed(
+      std::move(packed_weight),
+      std::move(weight_shape),
+      std::move(bias),
+      batch_size);
+}
+
 at::Tensor linear_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
@@ -224,6 +240,23 @@ at::Tensor linear_mul_add_run(
       input, post_op_tensors, op_attr.set_fpmath_mode(torch_ipex::fpmath_mode));
 }
 
+// The packed layout of oneDNN for a weight of [out_features, in_features]
+static ideep::tensor::desc get_packed_weight_desc(
+    int64_t out_features,
+    int64_t in_features,
+    const c10::optional<int64_t> batch_size,
+    ideep::data_type dtype) {
+  ideep::dims input_size;
+  if (batch_size.has_value()) {
+    input_size = {batch_size.value(), in_features};
+  }
+  return ideep::inner_product_forward::expected_weights_desc(
+      {out_features, in_features},
+      input_size,
+      /* weight dtype */ dtype,
+      /* src dtype */ dtype);
+}
+
 ContextLinear create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -232,17 +265,10 @@ ContextLinear create(
   auto in_features = weight.size(1);
   ideep::tensor packed_weight;
   auto w = itensor_view_from_dense(weight);
-  ideep::dims input_size;
   auto dtype = w.get_data_type();
   ideep::tensor::desc ori_desc(w.get_desc());
-  if (batch_size.has_value()) {
-    input_size = {batch_size.value(), in_features};
-  }
-  auto packed_desc = ideep::inner_product_forward::expected_weights_desc(
-      {out_features, in_features},
-      input_size,
-      /* weight dtype */ dtype,
-      /* src dtype */ dtype);
+  auto packed_desc =
+      get_packed_weight_desc(out_features, in_features, batch_size, dtype);
   auto at_weight = empty_aten_tensor_from_desc(packed_desc, weight.options());
   if (ideep::data_type::f32 == dtype) {
     packed_weight.init(packed_desc, at_weight.template data_ptr<float>());
@@ -264,6 +290,39 @@ ContextLinear create(
   };
 }
 
+ContextLinear create_from_packed(
+    const at::Tensor& packed_weight,
+    const std::vector<int64_t>& weight_shape,
+    const c10::optional<at::Tensor>& bias,
+    const c10::optional<int64_t> batch_size) {
+  TORCH_CHECK(
+      weight_shape.size() == 2,
+      "linear_prepack_from_packed: expect a weight shape of [out, in]");
+  auto dtype = get_mkldnn_dtype(packed_weight.scalar_type());
+  TORCH_CHECK(
+      ideep::data_type::f32 == dtype || ideep::data_type::bf16 == dtype ||
+          ideep::data_type::f16 == dtype,
+      "Only support bfloat16, float16 and float for weight prepack of linear");
+  auto packed_desc = get_packed_weight_desc(
+      weight_shape[0], weight_shape[1], batch_size, dtype);
+  // The layout may differ if the weight is packed on another ISA
+  TORCH_CHECK(
+      packed_weight.is_contiguous() &&
+          packed_weight.nbytes() == packed_desc.get_size(),
+      "linear_prepack_from_packed: the packed weight does not match the "
+      "layout of oneDNN for this weight shape, batch size and ISA");
+  ideep::tensor::desc ori_desc(
+      {weight_shape[0], weight_shape[1]}, dtype, ideep::format_tag::ab);
+  ideep::tensor w;
+  w.init(packed_desc, packed_weight.data_ptr());
+  return ContextLinear{
+      std::move(ori_desc),
+      std::move(w),
+      at::Tensor(packed_weight),
+      bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+  };
+}
+
 at::Tensor run(
     const ContextLinear& context,
     const at::Tensor& input,
@@ -19,6 +19,15 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
     c10::optional<at::Tensor>&& bias,
     c10::optional<int64_t> batch_size);
 
+// Restore a context from the weight packed by another one of the same
+// weight shape and batch size. The weight is not copied, so that it may be
+// mapped from a file.
+c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContextFromPacked(
+    at::Tensor&& packed_weight,
+    std::vector<int64_t>&& weight_shape,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size);
+
 at::Tensor linear_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context);
@@ -93,6 +102,13 @@ ContextLinear create(
     const c10::optional<at::Tensor>& bias,
     const c10::optional<int64_t> batch_size);
 
+// Same as create for a weight of weight_shape packed already by create
+ContextLinear create_from_packed(
+    const at::Tensor& packed_weight,
+    const std::vector<int64_t>& weight_shape,
+    const c10::optional<at::Tensor>& bias,
+    const c10::optional<int64_t> batch_size);
+
 at::Tensor run(
     const ContextLinear& context,
     const at::Tensor& input,
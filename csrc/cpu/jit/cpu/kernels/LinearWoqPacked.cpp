@@ -1,6 +1,8 @@
 #ifdef USE_LIBXSMM
 #include "LinearWoqPacked.h"
+#include <ATen/Parallel.h>
 #include <ideep.hpp>
+#include <numeric>
 #include "aten/Linear.h"
 #include "aten/WeightPack.h"
 #include "ideep/IDeepConversions.h"
@@ -10,6 +12,135 @@ namespace cpu {
 namespace detail {
 namespace woq_linear {
 
+// Unpack values of `bits` bits compressed in int32 along the last dim as a
+// little-endian bitstream, e.g., 8 4-bit values in one int32 or 32 3-bit
+// values in three int32 as GPTQ does. Return [rows, num_values] in uint8.
+static at::Tensor unpack_int32_bitstream(
+    const at::Tensor& packed,
+    int64_t bits,
+    int64_t num_values) {
+  auto packed_ = packed.contiguous();
+  int64_t rows = packed_.size(0);
+  int64_t cols = packed_.size(1);
+  TORCH_CHECK(
+      num_values * bits <= cols * 32,
+      "IPEX WOQ: compressed data is too short to hold ",
+      num_values,
+      " values of ",
+      bits,
+      " bits");
+  auto unpacked = at::empty({rows, num_values}, at::dtype(c10::kByte));
+  auto src = reinterpret_cast<const uint32_t*>(packed_.data_ptr());
+  auto dst = unpacked.data_ptr<uint8_t>();
+  const uint32_t mask = (1u << bits) - 1;
+  at::parallel_for(0, rows, 0, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const uint32_t* row = src + i * cols;
+      for (int64_t j = 0; j < num_values; ++j) {
+        int64_t bit = j * bits;
+        int64_t word = bit / 32;
+        int64_t shift = bit % 32;
+        uint64_t val = row[word] >> shift;
+        if (shift + bits > 32) {
+          // the value spans two int32
+          val |= (uint64_t)row[word + 1] << (32 - shift);
+        }
+        dst[i * num_values + j] = val & mask;
+      }
+    }
+  });
+  return unpacked;
+}
+
+// Shifts of the values of `bits` bits in the fewest whole bytes holding
+// them, e.g. 8 3-bit values in 3 bytes, and those of the bytes
+static std::pair<at::Tensor, at::Tensor> bitstream_shifts(int64_t bits) {
+  int64_t g = std::gcd(bits, (int64_t)8);
+  auto options = at::dtype(c10::kLong);
+  return {
+      at::arange(0, 8 / g * bits, bits, options),
+      at::arange(0, bits / g * 8, 8, options)};
+}
+
+// [N, K] uint8 values of `bits` bits -> [N, K * bits / 8] uint8 as a
+// little-endian bitstream, e.g. two int4 in one uint8, even columns in low
+// bits
+static at::Tensor compress_bitstream(const at::Tensor& values, int64_t bits) {
+  auto [value_shifts, byte_shifts] = bitstream_shifts(bits);
+  auto words = values.to(c10::kLong)
+                   .view({values.size(0), -1, value_shifts.size(0)})
+                   .bitwise_left_shift(value_shifts)
+                   .sum({-1}, /*keepdim*/ true);
+  return words.bitwise_right_shift(byte_shifts)
+      .bitwise_and(0xff)
+      .view({values.size(0), -1})
+      .to(c10::kByte);
+}
+
+// [N, K * bits / 8] uint8 -> [N, K] uint8
+static at::Tensor uncompress_bitstream(
+    const at::Tensor& qweight,
+    int64_t bits) {
+  auto [value_shifts, byte_shifts] = bitstream_shifts(bits);
+  auto words = qweight.to(c10::kLong)
+                   .view({qweight.size(0), -1, byte_shifts.size(0)})
+                   .bitwise_left_shift(byte_shifts)
+                   .sum({-1}, /*keepdim*/ true);
+  return words.bitwise_right_shift(value_shifts)
+      .bitwise_and((1 << bits) - 1)
+      .view({qweight.size(0), -1})
+      .to(c10::kByte);
+}
+
+// Reorder the input channels of a weight in [N, K] by perm, whose values of
+// less than 8 bits are compressed along K
+static at::Tensor permute_weight_k(
+    const at::Tensor& weight,
+    const at::Tensor& perm,
+    int64_t bits) {
+  if (bits < 8) {
+    return compress_bitstream(
+        uncompress_bitstream(weight, bits).index_select(1, perm), bits);
+  }
+  return weight.index_select(1, perm);
+}
+
+// Permutation of input channels that makes the groups of g_idx contiguous,
+// or nullopt if they are contiguous already.
+static c10::optional<at::Tensor> get_k_perm(
+    const at::Tensor& g_idx,
+    int64_t K,
+    int64_t group_size) {
+  TORCH_CHECK(
+      group_size > 0, "IPEX WOQ: g_idx requires group-wise quantization");
+  TORCH_CHECK(
+      g_idx.dim() == 1 && g_idx.size(0) == K,
+      "IPEX WOQ: expect g_idx of shape [",
+      K,
+      "], but got ",
+      g_idx.sizes());
+  auto g_idx_long = g_idx.to(c10::kLong);
+  auto perm = at::argsort(g_idx_long, /*stable*/ true);
+  auto k_idx = at::arange(K, at::dtype(c10::kLong));
+  TORCH_CHECK(
+      g_idx_long.index_select(0, perm).equal(k_idx.div(group_size, "floor")),
+      "IPEX WOQ: each group of g_idx should contain group_size input channels");
+  if (perm.equal(k_idx)) {
+    return c10::nullopt;
+  }
+  return perm;
+}
+
+// Gather the input channels in the order of the packed weight
+static at::Tensor get_kernel_input(
+    const ContextLinearWoq& context,
+    const at::Tensor& input) {
+  if (context.k_perm_.has_value()) {
+    return input.index_select(-1, context.k_perm_.value());
+  }
+  return input.contiguous();
+}
+
 c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContext(
     at::Tensor&& weight,
     std::vector<int64_t>&& weight_shape,
@@ -21,10 +152,16 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContext(
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode) {
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_dtype) {
   RECORD_FUNCTION(
       "ipex_prepack::createWoqLinearPrePackOpContext",
       c10::ArrayRef<c10::IValue>({}));
+  // 0 for int8 or int4 weight by is_int4
+  if (weight_dtype == 0) {
+    weight_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
+  }
 
   return IpexWoqLinearOpContext::create_context(
       std::move(weight),
@@ -37,7 +174,47 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContext(
       group_size,
       lowp_mode,
       num_concats,
-      act_quant_mode);
+      act_quant_mode,
+      std::move(g_idx),
+      weight_dtype);
+}
+
+c10::intrusive_ptr<WoqLinearOpContext>
+createWoqLinearPrePackOpContextFromPacked(
+    at::Tensor&& packed_weight,
+    std::vector<int64_t>&& weight_shape,
+    at::Tensor&& scales,
+    at::Tensor&& zero_points,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size,
+    bool is_int4,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t num_concats,
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_dtype) {
+  RECORD_FUNCTION(
+      "ipex_prepack::createWoqLinearPrePackOpContextFromPacked",
+      c10::ArrayRef<c10::IValue>({}));
+  if (weight_dtype == 0) {
+    weight_dtype = is_int4 ? WOQ_DTYPE_QINT4 : WOQ_DTYPE_QINT8;
+  }
+
+  return IpexWoqLinearOpContext::create_context_from_packed(
+      std::move(packed_weight),
+      std::move(weight_shape),
+      std::move(scales),
+      std::move(zero_points),
+      std::move(bias),
+      batch_size,
+      is_int4,
+      group_size,
+      lowp_mode,
+      num_concats,
+      act_quant_mode,
+      std::move(g_idx),
+      weight_dtype);
 }
 
 c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
@@ -49,43 +226,41 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
     int64_t group_size, // group_size along input channel
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode) {
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_bits) {
   RECORD_FUNCTION(
       "ipex_prepack::createWoqLinearPrePackOpContextInt4",
       c10::ArrayRef<c10::IValue>({}));
   // clang-format off
   // From
-  // Weight dtype = int32 (uint4 * 8) or uint8 (4bit * 2), scale dtype = fp16,
-  // zero points dtype = int32 (int4 * 8)
+  // Weight dtype = int32 (uint4 * 8, uint3 * 32 / 3 or uint2 * 16) or
+  // uint8 (4bit * 2), scale dtype = fp16,
+  // zero points dtype = int32 (compressed in the same way as weight)
   // To
-  // Weight dtype = quint4x2, scale dtype = fp32, zero points dtype = fp32
+  // Weight dtype = uint8 (uint4 * 2, uint3 * 8 / 3 or uint2 * 4),
+  // scale dtype = fp32, zero points dtype = fp32
   // There might be an extra output channel in weight and scales.
   // clang-format on
+  TORCH_CHECK(
+      weight_bits >= 2 && weight_bits <= 4,
+      "IPEX WOQ INT4: weight_bits should be 2, 3 or 4, but got ",
+      weight_bits);
   auto scales_fp32 = scales.squeeze().to(c10::ScalarType::Float);
 
   at::Tensor zp_fp32;
 
   if (zero_points.scalar_type() == c10::kInt) {
-    // Two cases: (1) each int32 contains 8 values of zero points
-    // (2) each int32 is a single value of zero point
+    // Two cases: (1) each int32 contains 32 / weight_bits values of zero
+    // points (2) each int32 is a single value of zero point
     if (zero_points.numel() != scales_fp32.numel()) {
       // Assume group_size > 0 and zero point data are compressed
       TORCH_CHECK(scales_fp32.dim() == 2 && zero_points.dim() == 2)
       TORCH_CHECK(scales_fp32.size(0) == zero_points.size(0))
-      auto num_row = scales_fp32.size(0);
-      auto num_col = scales_fp32.size(1);
-      auto num_col_zp = zero_points.size(1);
       // Convert compressed zero points to float
-      zp_fp32 = at::empty_like(scales_fp32);
-      float* zp_fp32_ptr = reinterpret_cast<float*>(zp_fp32.data_ptr());
-      uint32_t* zp_int32_ptr =
-          reinterpret_cast<uint32_t*>(zero_points.data_ptr());
-      for (size_t i = 0; i < num_row; ++i) {
-        for (size_t j = 0; j < num_col; ++j) {
-          zp_fp32_ptr[i * num_col + j] =
-              (float)((zp_int32_ptr[i * num_col_zp + j / 8] >> ((j % 8) * 4)) & 0xf);
-        }
-      }
+      zp_fp32 =
+          unpack_int32_bitstream(zero_points, weight_bits, scales_fp32.size(1))
+              .to(c10::kFloat);
     } else if (zero_points.numel() == scales_fp32.numel()) {
       // Not compressed
       zp_fp32 = zero_points.squeeze().to(c10::kFloat);
@@ -97,19 +272,29 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
   }
   // Support two cases here:
   // 1. fp32/bf16 weight after calibration
-  // 2. int4 weight after calibration, quantized and compressed, as int32/uint8
+  // 2. int4 weight after calibration, quantized and compressed, as int32/uint8,
+  //    or int2/int3 weight compressed as int32
   at::Tensor weight_int4;
   std::vector<int64_t> weight_shape(2);
   if (weight.scalar_type() == c10::kInt || weight.scalar_type() == c10::kByte) {
+    TORCH_CHECK(
+        weight_bits == 4 || weight.scalar_type() == c10::kInt,
+        "IPEX WOQ INT4: expect ",
+        weight_bits,
+        "-bit weight compressed as int32, but got uint8");
     // Create empty weight with desired options then copy data
     int64_t N = weight.size(0);
     int64_t K_compressed = weight.size(1);
-    int64_t K_uint8 =
-        weight.scalar_type() == c10::kInt ? K_compressed * 8 / 2 : K_compressed;
+    int64_t K_uint8 = weight.scalar_type() == c10::kInt
+        ? K_compressed * sizeof(uint32_t)
+        : K_compressed;
+    TORCH_CHECK(
+        K_uint8 * 8 % weight_bits == 0,
+        "IPEX WOQ INT4: size of compressed weight does not match weight_bits");
     weight_shape[0] = N;
-    weight_shape[1] = K_uint8 * 2;
+    weight_shape[1] = K_uint8 * 8 / weight_bits;
     std::vector<int64_t> weight_size = {N, K_uint8};
-    // Create an empty uint8 weight to hold int4 data
+    // Create an empty uint8 weight to hold the compressed data
     weight_int4 = at::empty(weight_size, device(c10::kCPU).dtype(c10::kByte));
     auto sizeof_dtype = weight.scalar_type() == c10::kInt
         ? sizeof(uint32_t)
@@ -140,20 +325,26 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
           at::round(weight / scale_view + zp_view).to(c10::kByte);
     }
     weight_int4_as_uint8 = weight_int4_as_uint8.view(weight_shape);
-    using at::indexing::None;
-    using at::indexing::Slice;
-    at::Tensor even_columns =
-        weight_int4_as_uint8.index({Slice(), Slice(1, None, 2)});
-    even_columns = even_columns.bitwise_left_shift(4);
-    at::Tensor odd_columns =
-        weight_int4_as_uint8.index({Slice(), Slice(None, None, 2)});
-    weight_int4 = even_columns.bitwise_or(odd_columns);
+    TORCH_CHECK(
+        weight_bits == 4 || weight_shape[1] % 8 == 0,
+        "IPEX WOQ INT4: expect input channels of ",
+        weight_bits,
+        "-bit weight to be a multiple of 8");
+    weight_int4 = compress_bitstream(weight_int4_as_uint8, weight_bits);
   } else {
     TORCH_CHECK(
         false,
         "IPEX WOQ INT4: unexpected weight data type: ",
         weight.scalar_type());
   }
+  int64_t weight_dtype = WOQ_DTYPE_QINT4;
+  if (weight_bits < 4) {
+    weight_dtype = weight_bits == 2 ? WOQ_DTYPE_INT2 : WOQ_DTYPE_INT3;
+    // There is no int8 compute with int2/int3 weight
+    if (lowp_mode == 3) {
+      lowp_mode = 2;
+    }
+  }
   return IpexWoqLinearOpContext::create_context(
       std::move(weight_int4),
       std::move(weight_shape),
@@ -161,11 +352,87 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
       std::move(zp_fp32),
       std::move(bias),
       batch_size,
-      /*is_int4*/ true,
+      /*is_int4*/ weight_bits == 4,
       group_size,
       lowp_mode,
       num_concats,
-      act_quant_mode);
+      act_quant_mode,
+      std::move(g_idx),
+      weight_dtype);
+}
+
+c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextMX(
+    at::Tensor&& weight,
+    at::Tensor&& scales,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size,
+    c10::string_view format,
+    int64_t lowp_mode,
+    int64_t num_concats) {
+  RECORD_FUNCTION(
+      "ipex_prepack::createWoqLinearPrePackOpContextMX",
+      c10::ArrayRef<c10::IValue>({}));
+  int64_t weight_dtype = 0;
+  if (format == "mxfp4") {
+    weight_dtype = WOQ_DTYPE_MXFP4;
+  } else if (format == "mxfp6") {
+    weight_dtype = WOQ_DTYPE_MXFP6;
+  } else if (format == "mxfp8") {
+    weight_dtype = WOQ_DTYPE_MXFP8;
+  } else {
+    TORCH_CHECK(false, "IPEX WOQ MX: unsupported format ", format);
+  }
+  TORCH_CHECK(
+      weight.dim() == 2 && weight.scalar_type() == c10::kByte,
+      "IPEX WOQ MX: expect 2D weight of element codes in uint8");
+  TORCH_CHECK(
+      scales.scalar_type() == c10::kByte,
+      "IPEX WOQ MX: expect E8M0 scales in uint8");
+  bool is_int4 = weight_dtype == WOQ_DTYPE_MXFP4;
+  int64_t bits = woq_dtype_bits(weight_dtype);
+  int64_t N = weight.size(0);
+  // MXFP6 codes of one byte each are compressed, four in three bytes
+  if (bits == 6 && scales.dim() == 2 &&
+      weight.size(1) == scales.size(1) * WOQ_MX_BLOCK_SIZE) {
+    weight = compress_bitstream(weight, bits);
+  }
+  int64_t K = weight.size(1) * 8 / bits;
+  int64_t num_blocks = K / WOQ_MX_BLOCK_SIZE;
+  TORCH_CHECK(
+      K % WOQ_MX_BLOCK_SIZE == 0 && scales.dim() == 2 &&
+          scales.size(0) == N && scales.size(1) == num_blocks,
+      "IPEX WOQ MX: expect scales of [",
+      N,
+      ", ",
+      num_blocks,
+      "], but got ",
+      scales.sizes());
+  // E8M0 is an exponent with bias 127, without sign and mantissa
+  auto scales_fp32 = at::exp2(scales.to(c10::kFloat) - 127.f);
+  // MX formats are symmetric, zero points are not used by the kernels
+  auto zp_fp32 = at::zeros_like(scales_fp32);
+  // The codes are decoded to floating point, there is no int8 compute
+  if (lowp_mode == 3) {
+    lowp_mode = 2;
+  }
+  // Codes of one byte take the layout of int8 weight
+  auto weight_codes =
+      bits < 8 ? weight.contiguous() : weight.contiguous().view(c10::kChar);
+  std::vector<int64_t> weight_shape = {N, K};
+  return IpexWoqLinearOpContext::create_context(
+      std::move(weight_codes),
+      std::move(weight_shape),
+      std::move(scales_fp32),
+      std::move(zp_fp32),
+      std::move(bias),
+      batch_size,
+      is_int4,
+      WOQ_MX_BLOCK_SIZE,
+      lowp_mode,
+      num_concats,
+      /*act_quant_mode*/ 0,
+      c10::nullopt,
+      weight_dtype);
 }
 
 at::Tensor woq_linear_run(
@@ -177,35 +444,31 @@ at::Tensor woq_linear_run(
   return op_context->run(input);
 }
 
-ContextLinearWoq create(
-    at::Tensor& weight,
+// Context of a packed weight, whose output channels may be padded to a
+// multiple of block_n. The scales, zero points and bias are padded alike.
+static ContextLinearWoq make_context(
+    at::Tensor&& packed_weight,
     std::vector<int64_t>& weight_shape,
     at::Tensor& scales,
     at::Tensor& zero_points,
     const c10::optional<at::Tensor>& bias,
-    const c10::optional<int64_t> batch_size,
     bool is_int4,
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode) {
-  auto packed_weight = woq_linear_pack_weight(
-      weight, weight_shape, is_int4, group_size, lowp_mode);
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& act_order_g_idx,
+    c10::optional<at::Tensor>&& k_perm,
+    int64_t weight_dtype) {
   auto packed_shape = packed_weight.sizes();
-  int64_t N = weight.size(0);
-  int64_t K = weight.size(1);
+  int64_t N = weight_shape[0];
   // If OC is not a multiple of BLOCK_N, it may be padded.
-  bool oc_is_padded = (packed_shape.size() == 4 && is_int4 &&
-                       packed_shape[0] * packed_shape[3] * 2 != N) ||
-      (packed_shape.size() == 4 && !is_int4 &&
-       packed_shape[0] * packed_shape[3] != N) ||
-      (packed_shape.size() == 2 && packed_shape[0] != N);
+  int64_t padded_N = packed_shape.size() == 4
+      ? packed_shape[0] * packed_shape[3] * 8 / woq_dtype_bits(weight_dtype)
+      : packed_shape[0];
+  bool oc_is_padded = padded_N != N;
   auto zero_points_float = zero_points.to(c10::kFloat);
   if (oc_is_padded) {
-    int64_t padded_N = packed_shape.size() == 4
-        ? (is_int4 ? packed_shape[0] * packed_shape[3] * 2
-                   : packed_shape[0] * packed_shape[3])
-        : packed_shape[0];
     std::vector<int64_t> pad_vec = scales.dim() == 1
         ? std::vector<int64_t>({0, padded_N - N})
         : std::vector<int64_t>({0, 0, 0, padded_N - N});
@@ -225,7 +488,10 @@ ContextLinearWoq create(
           group_size,
           lowp_mode,
           num_concats,
-          act_quant_mode);
+          act_quant_mode,
+          std::move(act_order_g_idx),
+          std::move(k_perm),
+          weight_dtype);
     } else {
       return ContextLinearWoq(
           std::move(packed_weight),
@@ -237,7 +503,10 @@ ContextLinearWoq create(
           group_size,
           lowp_mode,
           num_concats,
-          act_quant_mode);
+          act_quant_mode,
+          std::move(act_order_g_idx),
+          std::move(k_perm),
+          weight_dtype);
     }
   }
   return ContextLinearWoq(
@@ -250,7 +519,98 @@ ContextLinearWoq create(
       group_size,
       lowp_mode,
       num_concats,
-      act_quant_mode);
+      act_quant_mode,
+      std::move(act_order_g_idx),
+      std::move(k_perm),
+      weight_dtype);
+}
+
+ContextLinearWoq create(
+    at::Tensor& weight,
+    std::vector<int64_t>& weight_shape,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const c10::optional<at::Tensor>& bias,
+    const c10::optional<int64_t> batch_size,
+    bool is_int4,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t num_concats,
+    int64_t act_quant_mode,
+    const c10::optional<at::Tensor>& g_idx,
+    int64_t weight_dtype) {
+  // For act-order weights, sort the input channels by group so that the
+  // kernels see contiguous groups along K as usual.
+  c10::optional<at::Tensor> k_perm = c10::nullopt;
+  if (g_idx.has_value() && g_idx.value().defined()) {
+    k_perm = get_k_perm(g_idx.value(), weight_shape[1], group_size);
+  }
+  c10::optional<at::Tensor> act_order_g_idx =
+      k_perm.has_value() ? g_idx : c10::nullopt;
+  auto packed_weight = woq_linear_pack_weight(
+      k_perm.has_value()
+          ? permute_weight_k(
+                weight, k_perm.value(), woq_dtype_bits(weight_dtype))
+          : weight,
+      weight_shape,
+      weight_dtype,
+      group_size,
+      lowp_mode);
+  return make_context(
+      std::move(packed_weight),
+      weight_shape,
+      scales,
+      zero_points,
+      bias,
+      is_int4,
+      group_size,
+      lowp_mode,
+      num_concats,
+      act_quant_mode,
+      std::move(act_order_g_idx),
+      std::move(k_perm),
+      weight_dtype);
+}
+
+ContextLinearWoq create_from_packed(
+    at::Tensor& packed_weight,
+    std::vector<int64_t>& weight_shape,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const c10::optional<at::Tensor>& bias,
+    const c10::optional<int64_t> batch_size,
+    bool is_int4,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t num_concats,
+    int64_t act_quant_mode,
+    const c10::optional<at::Tensor>& g_idx,
+    int64_t weight_dtype) {
+  TORCH_CHECK(
+      weight_shape.size() == 2 &&
+          (packed_weight.dim() == 2 || packed_weight.dim() == 4),
+      "IPEX WOQ: expect a packed weight of 2 or 4 dims and a weight shape of "
+      "[N, K]");
+  c10::optional<at::Tensor> k_perm = c10::nullopt;
+  if (g_idx.has_value() && g_idx.value().defined()) {
+    k_perm = get_k_perm(g_idx.value(), weight_shape[1], group_size);
+  }
+  c10::optional<at::Tensor> act_order_g_idx =
+      k_perm.has_value() ? g_idx : c10::nullopt;
+  return make_context(
+      at::Tensor(packed_weight),
+      weight_shape,
+      scales,
+      zero_points,
+      bias,
+      is_int4,
+      group_size,
+      lowp_mode,
+      num_concats,
+      act_quant_mode,
+      std::move(act_order_g_idx),
+      std::move(k_perm),
+      weight_dtype);
 }
 
 at::Tensor run(ContextLinearWoq& context, const at::Tensor& input) {
@@ -263,14 +623,14 @@ at::Tensor run(ContextLinearWoq& context, const at::Tensor& input) {
       " and ",
       w_k,
       " respectively.");
-  auto input_ = input.contiguous();
+  auto input_ = get_kernel_input(context, input);
   auto res = woq_linear_kernel(
       input_,
       context.at_weight_,
       context.scales_list_,
       context.zero_points_list_,
       context.bias_list_,
-      context.is_int4_,
+      context.weight_dtype_,
       context.group_size_,
       context.lowp_mode_,
       context.num_concats_,
@@ -298,7 +658,7 @@ at::Tensor run_eltwise(
       " and ",
       w_k,
       " respectively.");
-  auto input_ = input.contiguous();
+  auto input_ = get_kernel_input(context, input);
   return woq_linear_eltwise_kernel(
       input_,
       context.at_weight_,
@@ -308,7 +668,7 @@ at::Tensor run_eltwise(
       post_op,
       scalars,
       algorithm,
-      context.is_int4_,
+      context.weight_dtype_,
       context.group_size_,
       context.lowp_mode_,
       context.num_concats_,
@@ -329,14 +689,14 @@ at::Tensor run_add(
       " and ",
       w_k,
       " respectively.");
-  auto input_ = input.contiguous();
+  auto input_ = get_kernel_input(context, input);
   return woq_linear_add_kernel(
       input_,
       context.at_weight_,
       context.scales_list_,
       context.zero_points_list_,
       context.bias_list_,
-      context.is_int4_,
+      context.weight_dtype_,
       context.group_size_,
       context.lowp_mode_,
       context.num_concats_,
@@ -358,14 +718,14 @@ at::Tensor run_add_add(
       " and ",
       w_k,
       " respectively.");
-  auto input_ = input.contiguous();
+  auto input_ = get_kernel_input(context, input);
   return woq_linear_add_add_kernel(
       input_,
       context.at_weight_,
       context.scales_list_,
       context.zero_points_list_,
       context.bias_list_,
-      context.is_int4_,
+      context.weight_dtype_,
       context.group_size_,
       context.lowp_mode_,
       context.num_concats_,
@@ -373,6 +733,73 @@ at::Tensor run_add_add(
       context.act_quant_mode_);
 }
 
+// Called by IpexWoqLinearOpContext::run_fused_mlp
+at::Tensor run_fused_mlp(
+    ContextLinearWoq& gate_up,
+    ContextLinearWoq& down,
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& others) {
+  auto w_k = gate_up.weight_shape_[1];
+  TORCH_CHECK(
+      input.size(input.dim() - 1) == w_k,
+      "WOQ fused MLP: input and weight shapes do not match, got k = ",
+      input.size(input.dim() - 1),
+      " and ",
+      w_k,
+      " respectively.");
+  auto intermediate_size = down.weight_shape_[1];
+  TORCH_CHECK(
+      gate_up.weight_shape_[0] == 2 * intermediate_size,
+      "WOQ fused MLP: expect N of gate/up to be twice of K of down, got ",
+      gate_up.weight_shape_[0],
+      " and ",
+      intermediate_size);
+  TORCH_CHECK(
+      gate_up.weight_dtype_ == down.weight_dtype_ &&
+          gate_up.group_size_ == down.group_size_ &&
+          gate_up.lowp_mode_ == down.lowp_mode_,
+      "WOQ fused MLP: gate/up and down must be quantized with the same config");
+  TORCH_CHECK(others.size() <= 1, "WOQ fused MLP: expect at most one addend");
+  auto input_ = get_kernel_input(gate_up, input);
+  if (down.k_perm_.has_value()) {
+    // The input channels of down are reordered by act-order, so is the
+    // intermediate activation
+    auto gate_up_out = woq_linear_kernel(
+        input_,
+        gate_up.at_weight_,
+        gate_up.scales_list_,
+        gate_up.zero_points_list_,
+        gate_up.bias_list_,
+        gate_up.weight_dtype_,
+        gate_up.group_size_,
+        gate_up.lowp_mode_,
+        /*num_concats*/ 1,
+        gate_up.act_quant_mode_);
+    auto gate = at::narrow(gate_up_out, -1, 0, intermediate_size);
+    auto up =
+        at::narrow(gate_up_out, -1, intermediate_size, intermediate_size);
+    auto inter = at::silu(gate).mul_(up);
+    return others.empty() ? run(down, inter) : run_add(down, inter, others);
+  }
+  return woq_fused_mlp_kernel(
+      input_,
+      gate_up.at_weight_,
+      gate_up.scales_list_,
+      gate_up.zero_points_list_,
+      gate_up.bias_list_,
+      down.at_weight_,
+      down.scales_list_,
+      down.zero_points_list_,
+      down.bias_list_,
+      intermediate_size,
+      down.weight_shape_[0],
+      gate_up.weight_dtype_,
+      gate_up.group_size_,
+      gate_up.lowp_mode_,
+      others,
+      gate_up.act_quant_mode_);
+}
+
 at::Tensor pack(ContextLinearWoq& context, const at::Tensor& tensor) {
   return tensor;
 }
@@ -381,26 +808,29 @@ at::Tensor unpack(ContextLinearWoq& context, const at::Tensor& tensor) {
   // By using different kernels, the packed weight dim can be 2 or 4
   // Return result directly if dim == 2
   // For dim == 4, make a new quantized tensor and return.
-  // For padded weight (int4), make a slice of it.
-  auto unpacked_weight =
-      woq_linear_unpack_weight(tensor, context.is_int4_, context.lowp_mode_);
+  // For padded weight (less than 8 bits), make a slice of it.
+  auto unpacked_weight = woq_linear_unpack_weight(
+      tensor, context.weight_dtype_, context.lowp_mode_);
+  int64_t bits = woq_dtype_bits(context.weight_dtype_);
   if (tensor.dim() > 2) {
     auto scales = context.scales_list_[0];
     auto zero_points = context.zero_points_list_[0];
-    if (context.is_int4_) {
-      auto unpacked_shape = unpacked_weight.sizes().vec(); // = N * K/2
+    if (bits < 8) {
+      auto unpacked_shape = unpacked_weight.sizes().vec(); // = N * K*bits/8
       auto shape = context.weight_shape_;
-      shape.back() /= 2;
+      shape.back() = shape.back() * bits / 8;
       at::Tensor qweight =
           at::empty(shape, device(c10::kCPU).dtype(c10::kByte));
-      assert(qweight.numel() % 2 == 0);
       std::memcpy(
           qweight.data_ptr(), unpacked_weight.data_ptr(), qweight.numel());
-      return qweight;
-    } else { // int8
-      return unpacked_weight;
+      unpacked_weight = qweight;
     }
   }
+  if (context.k_perm_.has_value()) {
+    // Restore the original order of input channels
+    auto inverse_perm = at::argsort(context.k_perm_.value());
+    return permute_weight_k(unpacked_weight, inverse_perm, bits);
+  }
   return unpacked_weight;
 }
 
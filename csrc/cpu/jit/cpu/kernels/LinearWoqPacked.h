@@ -21,8 +21,32 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContext(
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode);
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_dtype);
 
+// Restore a context from the state returned by packed_state() of another
+// one, whose weight is packed already. The weight is not copied, so that it
+// may be mapped from a file.
+c10::intrusive_ptr<WoqLinearOpContext>
+createWoqLinearPrePackOpContextFromPacked(
+    at::Tensor&& packed_weight,
+    std::vector<int64_t>&& weight_shape,
+    at::Tensor&& scales,
+    at::Tensor&& zero_points,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size,
+    bool is_int4,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t num_concats,
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_dtype);
+
+// weight_bits is the bit width of the weight and zero points compressed in
+// int32, 2, 3 or 4. 2-bit and 3-bit weights take WOQ_DTYPE_INT2 and
+// WOQ_DTYPE_INT3.
 c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
     at::Tensor&& weight,
     at::Tensor&& scales,
@@ -32,7 +56,23 @@ c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextInt4(
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode);
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_bits);
+
+// MX (microscaling) weight of format "mxfp4", "mxfp6" or "mxfp8". weight holds
+// the element codes in uint8, two per byte for mxfp4, four in three bytes as a
+// little-endian bitstream for mxfp6, which also takes one code per byte, and
+// one per byte for mxfp8. scales are the E8M0 exponents in uint8 of
+// [N, K / 32].
+c10::intrusive_ptr<WoqLinearOpContext> createWoqLinearPrePackOpContextMX(
+    at::Tensor&& weight,
+    at::Tensor&& scales,
+    c10::optional<at::Tensor>&& bias,
+    c10::optional<int64_t> batch_size,
+    c10::string_view format,
+    int64_t lowp_mode,
+    int64_t num_concats);
 
 at::Tensor woq_linear_run(
     const at::Tensor& input,
@@ -49,7 +89,25 @@ ContextLinearWoq create(
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode);
+    int64_t act_quant_mode,
+    const c10::optional<at::Tensor>& g_idx,
+    int64_t weight_dtype);
+
+// Same as create for a weight packed already by woq_linear_pack_weight
+ContextLinearWoq create_from_packed(
+    at::Tensor& packed_weight,
+    std::vector<int64_t>& weight_shape,
+    at::Tensor& scales,
+    at::Tensor& zero_points,
+    const c10::optional<at::Tensor>& bias,
+    const c10::optional<int64_t> batch_size,
+    bool is_int4,
+    int64_t group_size,
+    int64_t lowp_mode,
+    int64_t num_concats,
+    int64_t act_quant_mode,
+    const c10::optional<at::Tensor>& g_idx,
+    int64_t weight_dtype);
 
 at::Tensor run(ContextLinearWoq& context, const at::Tensor& input);
 
@@ -70,6 +128,14 @@ at::Tensor run_add_add(
     const at::Tensor& input,
     const std::vector<at::Tensor>& others);
 
+// Gated MLP, down(silu(gate(input)) * up(input)) + others, where gate_up is
+// the context of the gate and up projections concatenated along N
+at::Tensor run_fused_mlp(
+    ContextLinearWoq& gate_up,
+    ContextLinearWoq& down,
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& others);
+
 at::Tensor woq_linear_add_run(
     const at::Tensor& input,
     at::Tensor& accumu,
@@ -225,7 +225,7 @@ at::Tensor dil_bert_flash_mha(
 
 /**
  *  This kernel implements Flast attention on stable-diffusion models (from
- * Diffusers 0.12.1 and 0.13) for BF16 dtype, where qkv is from one
+ * Diffusers 0.12.1 and 0.13) for BF16 and FP32 dtypes, where qkv is from one
  * aten::linear; Note that in 0.13, aten::scaled_dot_product_attention uses the
  * scale of sqrt(headSize) if no scale is provided for query, where we are
  * following
@@ -247,9 +247,10 @@ at::Tensor dil_sd_flash_mha(
 
 /**
  *  This kernel implements Flast attention on stable-diffusion models (from
- * Diffusers 0.12.1 and 0.13) for BF16 dtype, where qkv is splited; Note that
- * in 0.13, aten::scaled_dot_product_attention uses the scale of sqrt(headSize)
- * if no scale is provided for query, where we are following
+ * Diffusers 0.12.1 and 0.13) for BF16 and FP32 dtypes, where qkv is
+ * splited; Note that in 0.13, aten::scaled_dot_product_attention uses the
+ * scale of sqrt(headSize) if no scale is provided for query, where we are
+ * following
  */
 at::Tensor dil_sd_flash_mha(
     const at::Tensor& query,
@@ -5,6 +5,7 @@
 #include "LinearMKLPacked.h"
 #include "LinearPacked.h"
 #include "LinearWoqPacked.h"
+#include "RNNPacked.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -145,6 +146,18 @@ c10::intrusive_ptr<LinearOpContext> IpexLinearOpContext::create_context(
       batch_size, std::move(op_context));
 }
 
+c10::intrusive_ptr<LinearOpContext> IpexLinearOpContext::
+    create_context_from_packed(
+        at::Tensor&& packed_weight,
+        std::vector<int64_t>&& weight_shape,
+        c10::optional<at::Tensor>&& bias,
+        c10::optional<int64_t> batch_size) {
+  auto op_context = torch_ipex::cpu::detail::linear::create_from_packed(
+      packed_weight, weight_shape, bias, batch_size);
+  return c10::make_intrusive<IpexLinearOpContext>(
+      batch_size, std::move(op_context));
+}
+
 at::Tensor IpexLinearOpContext::get_data_handle() {
   at::Tensor ptr = at::empty(1, at::kLong);
   ptr[0] = reinterpret_cast<int64_t>(this);
@@ -359,6 +372,52 @@ void IpexConvTransposeOpContext::load_from_ctx(
   load_from_ctx_template(this, other);
 }
 
+c10::intrusive_ptr<RNNOpContext> IpexRNNOpContext::create_context(
+    std::vector<at::Tensor>&& params,
+    std::string&& mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool batch_first) {
+  auto op_context = torch_ipex::cpu::detail::rnn::create(
+      params, mode, hidden_size, num_layers, has_biases, batch_first);
+  return c10::make_intrusive<IpexRNNOpContext>(std::move(op_context));
+}
+
+at::Tensor IpexRNNOpContext::run(const at::Tensor& input, int64_t stream_id) {
+  return torch_ipex::cpu::detail::rnn::run(op_context_, input, stream_id);
+}
+
+void IpexRNNOpContext::reset_state(int64_t stream_id) {
+  torch_ipex::cpu::detail::rnn::reset_state(op_context_, stream_id);
+}
+
+std::vector<at::Tensor> IpexRNNOpContext::get_state(int64_t stream_id) {
+  return torch_ipex::cpu::detail::rnn::get_state(op_context_, stream_id);
+}
+
+void IpexRNNOpContext::set_state(
+    int64_t stream_id,
+    const at::Tensor& hx,
+    const c10::optional<at::Tensor>& cx) {
+  torch_ipex::cpu::detail::rnn::set_state(op_context_, stream_id, hx, cx);
+}
+
+int64_t IpexRNNOpContext::get_num_streams() {
+  std::lock_guard<std::mutex> lock(*op_context_.mutex_);
+  return op_context_.states_.size();
+}
+
+at::Tensor IpexRNNOpContext::get_data_handle() {
+  at::Tensor ptr = at::empty(1, at::kLong);
+  ptr[0] = reinterpret_cast<int64_t>(this);
+  return ptr;
+}
+
+detail::ContextRNN& IpexRNNOpContext::get_context() {
+  return op_context_;
+}
+
 #ifdef USE_LIBXSMM
 // For weight-only quantization
 c10::intrusive_ptr<WoqLinearOpContext> IpexWoqLinearOpContext::create_context(
@@ -372,7 +431,9 @@ c10::intrusive_ptr<WoqLinearOpContext> IpexWoqLinearOpContext::create_context(
     int64_t group_size,
     int64_t lowp_mode,
     int64_t num_concats,
-    int64_t act_quant_mode) {
+    int64_t act_quant_mode,
+    c10::optional<at::Tensor>&& g_idx,
+    int64_t weight_dtype) {
   auto op_context = torch_ipex::cpu::detail::woq_linear::create(
       weight,
       weight_shape,
@@ -384,7 +445,42 @@ c10::intrusive_ptr<WoqLinearOpContext> IpexWoqLinearOpContext::create_context(
       group_size,
       lowp_mode,
       num_concats,
-      act_quant_mode);
+      act_quant_mode,
+      g_idx,
+      weight_dtype);
+  return c10::make_intrusive<IpexWoqLinearOpContext>(
+      batch_size, std::move(op_context));
+}
+
+c10::intrusive_ptr<WoqLinearOpContext> IpexWoqLinearOpContext::
+    create_context_from_packed(
+        at::Tensor&& packed_weight,
+        std::vector<int64_t>&& weight_shape,
+        at::Tensor&& scales_fp32,
+        at::Tensor&& zp_fp32,
+        c10::optional<at::Tensor>&& bias,
+        c10::optional<int64_t> batch_size,
+        bool is_int4,
+        int64_t group_size,
+        int64_t lowp_mode,
+        int64_t num_concats,
+        int64_t act_quant_mode,
+        c10::optional<at::Tensor>&& g_idx,
+        int64_t weight_dtype) {
+  auto op_context = torch_ipex::cpu::detail::woq_linear::create_from_packed(
+      packed_weight,
+      weight_shape,
+      scales_fp32,
+      zp_fp32,
+      bias,
+      batch_size,
+      is_int4,
+      group_size,
+      lowp_mode,
+      num_concats,
+      act_quant_mode,
+      g_idx,
+      weight_dtype);
   return c10::make_intrusive<IpexWoqLinearOpContext>(
       batch_size, std::move(op_context));
 }
@@ -422,6 +518,14 @@ at::Tensor IpexWoqLinearOpContext::run_add_add(
       op_context_, input, others);
 }
 
+at::Tensor IpexWoqLinearOpContext::run_fused_mlp(
+    const at::Tensor& input,
+    WoqLinearOpContext& down,
+    const std::vector<at::Tensor>& others) {
+  return torch_ipex::cpu::detail::woq_linear::run_fused_mlp(
+      op_context_, down.get_context(), input, others);
+}
+
 at::Tensor IpexWoqLinearOpContext::to_public(const at::Tensor& tensor) {
   return torch_ipex::cpu::detail::woq_linear::unpack(op_context_, tensor);
 }
@@ -10,6 +10,7 @@
 #include "ContextLinear.h"
 #include "ContextLinearMKL.h"
 #include "ContextLinearWoq.h"
+#include "ContextRNN.h"
 #include "assert.h"
 
 namespace torch_ipex {
@@ -268,6 +269,12 @@ class IpexLinearOpContext final : public LinearOpContext {
       c10::optional<at::Tensor>&& bias,
       c10::optional<int64_t> batch_size);
 
+  static c10::intrusive_ptr<LinearOpContext> create_context_from_packed(
+      at::Tensor&& packed_weight,
+      std::vector<int64_t>&& weight_shape,
+      c10::optional<at::Tensor>&& bias,
+      c10::optional<int64_t> batch_size);
+
   virtual void load_from_ctx(
       c10::intrusive_ptr<LinearOpContext> other) override;
 };
@@ -371,7 +378,9 @@ using SerializationTypeWoqLinearPrePack = std::tuple<
     int64_t, // group size
     int64_t, // lowp_mode
     int64_t, // num_concats
-    int64_t>; // act_quant_mode
+    int64_t, // act_quant_mode
+    c10::optional<at::Tensor>, // g_idx
+    int64_t>; // weight_dtype
 
 class WoqLinearOpContext : public torch::jit::CustomClassHolder {
  protected:
@@ -395,7 +404,33 @@ class WoqLinearOpContext : public torch::jit::CustomClassHolder {
         this->get_context().group_size_,
         this->get_context().lowp_mode_,
         this->get_context().num_concats_,
-        this->get_context().act_quant_mode_);
+        this->get_context().act_quant_mode_,
+        this->get_context().g_idx_,
+        this->get_context().weight_dtype_);
+  }
+
+  // Same as unpack with the weight kept packed, to restore the context by
+  // weight_only_qlinear_prepack_from_packed without packing it again
+  SerializationTypeWoqLinearPrePack packed_state() {
+    auto weight_shape_ = this->get_weight_shape();
+    auto bias_ = this->get_context().at_bias_;
+    if (bias_.has_value() && bias_.value().size(0) > weight_shape_[0]) {
+      bias_ = bias_.value().narrow(0, 0, weight_shape_[0]);
+    }
+    return std::make_tuple(
+        this->get_at_packed_weight(),
+        weight_shape_,
+        this->get_scales(),
+        this->get_zero_points(),
+        bias_,
+        batch_size_,
+        this->get_context().is_int4_,
+        this->get_context().group_size_,
+        this->get_context().lowp_mode_,
+        this->get_context().num_concats_,
+        this->get_context().act_quant_mode_,
+        this->get_context().g_idx_,
+        this->get_context().weight_dtype_);
   }
 
   virtual at::Tensor get_data_handle() = 0;
@@ -416,6 +451,13 @@ class WoqLinearOpContext : public torch::jit::CustomClassHolder {
       const at::Tensor& input,
       const std::vector<at::Tensor>& others) = 0;
 
+  // Gated MLP with this context as the concatenated gate/up projections and
+  // down as the down projection
+  virtual at::Tensor run_fused_mlp(
+      const at::Tensor& input,
+      WoqLinearOpContext& down,
+      const std::vector<at::Tensor>& others) = 0;
+
   virtual at::Tensor to_public(const at::Tensor& tensor) = 0;
 
   virtual at::Tensor get_at_packed_weight() = 0;
@@ -472,6 +514,11 @@ class IpexWoqLinearOpContext final : public WoqLinearOpContext {
       const at::Tensor& input,
       const std::vector<at::Tensor>& others) override;
 
+  virtual at::Tensor run_fused_mlp(
+      const at::Tensor& input,
+      WoqLinearOpContext& down,
+      const std::vector<at::Tensor>& others) override;
+
   virtual at::Tensor to_public(const at::Tensor& tensor) override;
 
   virtual at::Tensor get_at_packed_weight() override;
@@ -499,7 +546,24 @@ class IpexWoqLinearOpContext final : public WoqLinearOpContext {
       int64_t group_size,
       int64_t lowp_mode,
       int64_t num_concats,
-      int64_t act_quant_mode);
+      int64_t act_quant_mode,
+      c10::optional<at::Tensor>&& g_idx,
+      int64_t weight_dtype);
+
+  static c10::intrusive_ptr<WoqLinearOpContext> create_context_from_packed(
+      at::Tensor&& packed_weight,
+      std::vector<int64_t>&& weight_shape,
+      at::Tensor&& scales_fp32,
+      at::Tensor&& zp_fp32,
+      c10::optional<at::Tensor>&& bias,
+      c10::optional<int64_t> batch_size,
+      bool is_int4,
+      int64_t group_size,
+      int64_t lowp_mode,
+      int64_t num_concats,
+      int64_t act_quant_mode,
+      c10::optional<at::Tensor>&& g_idx,
+      int64_t weight_dtype);
 
   virtual void load_from_ctx(
       c10::intrusive_ptr<WoqLinearOpContext> other) override;
@@ -653,5 +717,85 @@ class IpexConvTransposeOpContext final : public ConvTransposeOpContext {
       c10::intrusive_ptr<ConvTransposeOpContext> other) override;
 };
 
+// Stateful RNN for streaming inference
+using SerializationTypeRNNPrePack = std::tuple<
+    std::vector<at::Tensor>, // params
+    std::string, // mode
+    int64_t, // hidden_size
+    int64_t, // num_layers
+    bool, // has_biases
+    bool>; // batch_first
+
+class RNNOpContext : public torch::jit::CustomClassHolder {
+ public:
+  // Only the weights are serialized, the carried states of the streams are
+  // runtime data
+  SerializationTypeRNNPrePack unpack() {
+    auto& ctx = this->get_context();
+    return std::make_tuple(
+        ctx.at_params_,
+        ctx.mode_,
+        ctx.hidden_size_,
+        ctx.num_layers_,
+        ctx.has_biases_,
+        ctx.batch_first_);
+  }
+
+  // Run one chunk of the stream identified by stream_id, starting from the
+  // hidden state left by the previous chunk of the same stream
+  virtual at::Tensor run(const at::Tensor& input, int64_t stream_id) = 0;
+
+  // Drop the carried state so that the next chunk starts from zeros
+  virtual void reset_state(int64_t stream_id) = 0;
+
+  // Return {hx, cx} of the stream, cx is undefined for GRU
+  virtual std::vector<at::Tensor> get_state(int64_t stream_id) = 0;
+
+  virtual void set_state(
+      int64_t stream_id,
+      const at::Tensor& hx,
+      const c10::optional<at::Tensor>& cx) = 0;
+
+  virtual int64_t get_num_streams() = 0;
+
+  virtual at::Tensor get_data_handle() = 0;
+
+  virtual detail::ContextRNN& get_context() = 0;
+};
+
+class IpexRNNOpContext final : public RNNOpContext {
+ private:
+  detail::ContextRNN op_context_;
+
+ public:
+  IpexRNNOpContext(detail::ContextRNN&& op_context)
+      : op_context_(std::move(op_context)) {}
+
+  virtual at::Tensor run(const at::Tensor& input, int64_t stream_id) override;
+
+  virtual void reset_state(int64_t stream_id) override;
+
+  virtual std::vector<at::Tensor> get_state(int64_t stream_id) override;
+
+  virtual void set_state(
+      int64_t stream_id,
+      const at::Tensor& hx,
+      const c10::optional<at::Tensor>& cx) override;
+
+  virtual int64_t get_num_streams() override;
+
+  virtual at::Tensor get_data_handle() override;
+
+  virtual detail::ContextRNN& get_context() override;
+
+  static c10::intrusive_ptr<RNNOpContext> create_context(
+      std::vector<at::Tensor>&& params,
+      std::string&& mode,
+      int64_t hidden_size,
+      int64_t num_layers,
+      bool has_biases,
+      bool batch_first);
+};
+
 } // namespace cpu
 } // namespace torch_ipex
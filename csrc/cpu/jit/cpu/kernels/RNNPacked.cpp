@@ -0,0 +1,472 @@
+#include "RNNPacked.h"
+#include <ideep.hpp>
+#include <algorithm>
+#include "aten/RNN.h"
+#include "ideep/IDeepConversions.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace rnn {
+
+namespace {
+
+// When feeding to mkldnn, weight is in `ldigo`
+constexpr int weights_scale_mask = 0 +
+    (1 << 3) // bit, indicating the unique scales for `g` dim in `ldigo`
+    + (1 << 4); // bit, indicating the unique scales for `o` dim in `ldigo`
+
+using format = ideep::format_tag;
+using dtype = ideep::tensor::data_type;
+
+bool is_lstm(const ContextRNN& context) {
+  return context.mode_ == "LSTM";
+}
+
+at::Tensor zero_state(
+    const ContextRNN& context,
+    int64_t mini_batch,
+    at::ScalarType scalar_type) {
+  return at::zeros(
+      {1, mini_batch, context.hidden_size_},
+      at::TensorOptions().dtype(scalar_type));
+}
+
+// The caller holds the lock of the context
+RNNStreamState& get_or_create_state(
+    ContextRNN& context,
+    int64_t stream_id,
+    int64_t mini_batch,
+    at::ScalarType scalar_type) {
+  auto& state = context.states_[stream_id];
+  if (state.hx_.empty()) {
+    for (int64_t l = 0; l < context.num_layers_; l++) {
+      state.hx_.push_back(zero_state(context, mini_batch, scalar_type));
+      if (is_lstm(context)) {
+        state.cx_.push_back(zero_state(context, mini_batch, scalar_type));
+      }
+    }
+    return state;
+  }
+  // A carried state is never dropped implicitly
+  TORCH_CHECK(
+      state.hx_[0].size(1) == mini_batch,
+      "ipex_prepack::rnn_run: stream ",
+      stream_id,
+      " carries a state of batch size ",
+      state.hx_[0].size(1),
+      ", but got a chunk of batch size ",
+      mini_batch,
+      ". Call reset_state to restart the stream");
+  if (state.hx_[0].scalar_type() != scalar_type) {
+    for (auto& hx : state.hx_) {
+      hx = hx.to(scalar_type);
+    }
+    for (auto& cx : state.cx_) {
+      cx = cx.to(scalar_type);
+    }
+  }
+  return state;
+}
+
+// Create the lbr_gru primitive of the chunk shape and reorder the weights
+// of the layer into the format it expects
+void pack_gru_layer(
+    RNNPackedLayer& layer,
+    const ideep::tensor& w1,
+    const ideep::tensor& w2,
+    int64_t seq_length,
+    int64_t mini_batch,
+    int64_t input_size,
+    int64_t hidden_size,
+    dtype dt) {
+  ideep::tensor::desc src_layer_desc(
+      {seq_length, mini_batch, input_size}, dt, format::tnc);
+  ideep::tensor::desc dst_layer_desc(
+      {seq_length, mini_batch, hidden_size}, dt, format::tnc);
+  ideep::tensor::desc iter_desc(
+      {1, 1, mini_batch, hidden_size}, dt, format::ldnc);
+  layer.gru_pd_ = dnnl::lbr_gru_forward::primitive_desc(
+      ideep::engine::cpu_engine(),
+      dnnl::prop_kind::forward_inference,
+      dnnl::rnn_direction::unidirectional_left2right,
+      src_layer_desc,
+      iter_desc,
+      ideep::tensor::desc(w1.get_dims(), dt, format::any),
+      ideep::tensor::desc(w2.get_dims(), dt, format::any),
+      layer.bias_.get_desc(),
+      dst_layer_desc,
+      iter_desc,
+      ideep::attr_t(torch_ipex::fpmath_mode));
+  layer.gru_ = dnnl::lbr_gru_forward(layer.gru_pd_);
+  layer.weight_ih_ = w1.reorder_if_differ_in(
+      ideep::tensor::desc(layer.gru_pd_.weights_layer_desc()),
+      ideep::attr_t());
+  layer.weight_hh_ = w2.reorder_if_differ_in(
+      ideep::tensor::desc(layer.gru_pd_.weights_iter_desc()),
+      ideep::attr_t());
+}
+
+// Reorder the weights into the format oneDNN expects for the given chunk
+// shape. The result is cached per (seq_length, mini_batch, dtype): unlike
+// the global weight cache of ipex_lstm, the blocked or rnn_packed formats
+// are never shared across chunk shapes here, so the weights can always stay
+// packed. The least recently used chunk shape is evicted beyond
+// kMaxPackedChunkShapes. The caller holds the lock of the context.
+std::shared_ptr<const std::vector<RNNPackedLayer>> get_packed_weights(
+    ContextRNN& context,
+    int64_t seq_length,
+    int64_t mini_batch,
+    at::ScalarType scalar_type) {
+  RNNChunkKey key{seq_length, mini_batch, static_cast<int64_t>(scalar_type)};
+  auto clock = ++context.packed_clock_;
+  auto it = context.packed_weights_.find(key);
+  if (it != context.packed_weights_.end()) {
+    it->second.last_use_ = clock;
+    return it->second.layers_;
+  }
+  if (context.packed_weights_.size() >= ContextRNN::kMaxPackedChunkShapes) {
+    auto lru = std::min_element(
+        context.packed_weights_.begin(),
+        context.packed_weights_.end(),
+        [](const auto& a, const auto& b) {
+          return a.second.last_use_ < b.second.last_use_;
+        });
+    context.packed_weights_.erase(lru);
+  }
+
+  auto dt = get_mkldnn_dtype(scalar_type);
+  auto hidden_size = context.hidden_size_;
+  int64_t num_gates = is_lstm(context) ? 4 : 3;
+  auto layers =
+      std::make_shared<std::vector<RNNPackedLayer>>(context.num_layers_);
+  for (int64_t l = 0; l < context.num_layers_; l++) {
+    auto input_size = l == 0 ? context.input_size_ : hidden_size;
+    auto& layer = (*layers)[l];
+    layer.at_weight_ih_ =
+        context.at_weight_ih_[l].to(scalar_type).contiguous();
+    layer.at_weight_hh_ =
+        context.at_weight_hh_[l].to(scalar_type).contiguous();
+    layer.at_bias_ = context.at_bias_[l].to(scalar_type).contiguous();
+
+    auto w1 = itensor_view_from_dense(
+        layer.at_weight_ih_,
+        {{1, 1, input_size, num_gates, hidden_size}, dt, format::ldgoi});
+    auto w2 = itensor_view_from_dense(
+        layer.at_weight_hh_,
+        {{1, 1, hidden_size, num_gates, hidden_size}, dt, format::ldgoi});
+    // 4 bias gates for both, GRU has a separate bias of the new gate
+    layer.bias_ = itensor_view_from_dense(
+        layer.at_bias_,
+        {{1, 1, 4, hidden_size}, dt, format::ldgo});
+    if (!is_lstm(context)) {
+      pack_gru_layer(
+          layer,
+          w1,
+          w2,
+          seq_length,
+          mini_batch,
+          input_size,
+          hidden_size,
+          dt);
+      continue;
+    }
+
+    ideep::tensor src_layer(
+        {{seq_length, mini_batch, input_size}, dt, format::tnc});
+    ideep::tensor src_iter(
+        {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    ideep::tensor src_iter_c(
+        {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    ideep::tensor::desc packed_desc_ih, packed_desc_hh;
+    std::tie(packed_desc_ih, packed_desc_hh) =
+        ideep::lstm_forward_inference::expected_weights_desc(
+            {seq_length, mini_batch, hidden_size},
+            src_layer,
+            src_iter,
+            src_iter_c,
+            w1,
+            w2,
+            layer.bias_,
+            /*reverse*/ false);
+    layer.weight_ih_ =
+        w1.reorder_if_differ_in(packed_desc_ih, ideep::attr_t());
+    layer.weight_hh_ =
+        w2.reorder_if_differ_in(packed_desc_hh, ideep::attr_t());
+  }
+  context.packed_weights_.emplace(key, RNNPackedEntry{layers, clock});
+  return layers;
+}
+
+at::Tensor run_lstm(
+    const at::Tensor& input,
+    const std::vector<RNNPackedLayer>& layers,
+    RNNStreamState& state,
+    int64_t hidden_size) {
+  auto seq_length = input.size(0);
+  auto mini_batch = input.size(1);
+  auto dt = get_mkldnn_dtype(input.scalar_type());
+  auto layer_input = input;
+  for (size_t l = 0; l < layers.size(); l++) {
+    auto input_size = layer_input.size(2);
+    auto output =
+        at::empty({seq_length, mini_batch, hidden_size}, input.options());
+    auto hy_ = at::empty_like(state.hx_[l]);
+    auto cy_ = at::empty_like(state.cx_[l]);
+    auto x = itensor_view_from_dense(
+        layer_input, {{seq_length, mini_batch, input_size}, dt, format::tnc});
+    auto hx = itensor_view_from_dense(
+        state.hx_[l], {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    auto cx = itensor_view_from_dense(
+        state.cx_[l], {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    auto y = itensor_view_from_dense(
+        output, {{seq_length, mini_batch, hidden_size}, dt, format::tnc});
+    auto hy = itensor_view_from_dense(
+        hy_, {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    auto cy = itensor_view_from_dense(
+        cy_, {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    ideep::lstm_forward_inference::compute(
+        x,
+        hx,
+        cx,
+        layers[l].weight_ih_,
+        layers[l].weight_hh_,
+        layers[l].bias_,
+        y,
+        hy,
+        cy,
+        /*reverse*/ false,
+        ideep::prop_kind::forward_inference,
+        /*scale*/ -1.,
+        /*zp*/ -1,
+        weights_scale_mask,
+        /*weights_scales*/ {},
+        ideep::attr_t(torch_ipex::fpmath_mode));
+    state.hx_[l] = hy_;
+    state.cx_[l] = cy_;
+    layer_input = output;
+  }
+  return layer_input;
+}
+
+at::Tensor run_gru(
+    const at::Tensor& input,
+    const std::vector<RNNPackedLayer>& layers,
+    RNNStreamState& state,
+    int64_t hidden_size) {
+  auto seq_length = input.size(0);
+  auto mini_batch = input.size(1);
+  auto dt = get_mkldnn_dtype(input.scalar_type());
+  auto layer_input = input;
+  ideep::stream stream = ideep::stream::default_stream();
+  for (size_t l = 0; l < layers.size(); l++) {
+    auto input_size = layer_input.size(2);
+    auto output =
+        at::empty({seq_length, mini_batch, hidden_size}, input.options());
+    auto hy_ = at::empty_like(state.hx_[l]);
+    auto x = itensor_view_from_dense(
+        layer_input, {{seq_length, mini_batch, input_size}, dt, format::tnc});
+    auto hx = itensor_view_from_dense(
+        state.hx_[l], {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    auto y = itensor_view_from_dense(
+        output, {{seq_length, mini_batch, hidden_size}, dt, format::tnc});
+    auto hy = itensor_view_from_dense(
+        hy_, {{1, 1, mini_batch, hidden_size}, dt, format::ldnc});
+    // per call, as chunks of different streams run concurrently
+    ideep::tensor scratchpad(
+        ideep::tensor::desc(layers[l].gru_pd_.scratchpad_desc()));
+    layers[l].gru_.execute(
+        stream,
+        {{DNNL_ARG_SRC_LAYER, x},
+         {DNNL_ARG_SRC_ITER, hx},
+         {DNNL_ARG_WEIGHTS_LAYER, layers[l].weight_ih_},
+         {DNNL_ARG_WEIGHTS_ITER, layers[l].weight_hh_},
+         {DNNL_ARG_BIAS, layers[l].bias_},
+         {DNNL_ARG_DST_LAYER, y},
+         {DNNL_ARG_DST_ITER, hy},
+         {DNNL_ARG_SCRATCHPAD, scratchpad}});
+    stream.wait();
+    state.hx_[l] = hy_;
+    layer_input = output;
+  }
+  return layer_input;
+}
+
+} // namespace
+
+c10::intrusive_ptr<RNNOpContext> createRNNPrePackOpContext(
+    std::vector<at::Tensor>&& params,
+    std::string&& mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool batch_first) {
+  RECORD_FUNCTION(
+      "ipex_prepack::createRNNPrePackOpContext",
+      c10::ArrayRef<c10::IValue>({}));
+
+  return IpexRNNOpContext::create_context(
+      std::move(params),
+      std::move(mode),
+      hidden_size,
+      num_layers,
+      has_biases,
+      batch_first);
+}
+
+ContextRNN create(
+    std::vector<at::Tensor>& params,
+    std::string& mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool batch_first) {
+  TORCH_CHECK(
+      mode == "LSTM" || mode == "GRU",
+      "ipex_prepack::rnn_prepack: only LSTM and GRU are supported, but got ",
+      mode);
+  int64_t weight_stride0 = has_biases ? 4 : 2;
+  TORCH_CHECK(
+      params.size() == static_cast<size_t>(weight_stride0 * num_layers),
+      "ipex_prepack::rnn_prepack: expect ",
+      weight_stride0 * num_layers,
+      " params, but got ",
+      params.size());
+  auto rnn_mode = static_cast<int64_t>(
+      mode == "LSTM" ? ideep::rnn_kind::LSTM : ideep::rnn_kind::GRU);
+  int64_t num_gates = mode == "LSTM" ? 4 : 3;
+  int64_t input_size = params[0].size(1);
+
+  std::vector<at::Tensor> at_params, at_weight_ih, at_weight_hh, at_bias;
+  for (int64_t l = 0; l < num_layers; l++) {
+    auto weight_ih = params[l * weight_stride0].contiguous();
+    auto weight_hh = params[l * weight_stride0 + 1].contiguous();
+    TORCH_CHECK(
+        weight_hh.size(0) == num_gates * hidden_size &&
+            weight_hh.size(1) == hidden_size,
+        "ipex_prepack::rnn_prepack: unexpected shape of weight_hh of layer ",
+        l);
+    at_params.push_back(weight_ih);
+    at_params.push_back(weight_hh);
+    at_weight_ih.push_back(_shuffle_weight(weight_ih, rnn_mode));
+    at_weight_hh.push_back(_shuffle_weight(weight_hh, rnn_mode));
+    if (has_biases) {
+      auto bias_ih = params[l * weight_stride0 + 2].contiguous();
+      auto bias_hh = params[l * weight_stride0 + 3].contiguous();
+      at_params.push_back(bias_ih);
+      at_params.push_back(bias_hh);
+      at_bias.push_back(_shuffle_bias(bias_ih, bias_hh, rnn_mode));
+    } else {
+      at_bias.push_back(at::zeros({4 * hidden_size}, weight_ih.options()));
+    }
+  }
+
+  return ContextRNN{
+      std::move(mode),
+      input_size,
+      hidden_size,
+      num_layers,
+      has_biases,
+      batch_first,
+      std::move(at_params),
+      std::move(at_weight_ih),
+      std::move(at_weight_hh),
+      std::move(at_bias)};
+}
+
+// Chunks of the same stream must not run concurrently, while different
+// streams can. Only the lookups of the packed weights and of the state table
+// are serialized, the recurrent computation runs outside of the lock.
+at::Tensor run(
+    ContextRNN& context,
+    const at::Tensor& input,
+    int64_t stream_id) {
+  TORCH_CHECK(
+      input.dim() == 3,
+      "ipex_prepack::rnn_run: expect a 3D input, but got ",
+      input.dim(),
+      "D");
+  auto scalar_type = input.scalar_type();
+  TORCH_CHECK(
+      scalar_type == at::ScalarType::Float ||
+          scalar_type == at::ScalarType::BFloat16,
+      "ipex_prepack::rnn_run: expected input to be Float or BFloat16 but got ",
+      scalar_type);
+  auto x = context.batch_first_ ? input.transpose(0, 1) : input;
+  x = x.contiguous();
+  auto seq_length = x.size(0);
+  auto mini_batch = x.size(1);
+  TORCH_CHECK(
+      x.size(2) == context.input_size_,
+      "ipex_prepack::rnn_run: expect input_size ",
+      context.input_size_,
+      ", but got ",
+      x.size(2));
+
+  RNNStreamState state;
+  std::shared_ptr<const std::vector<RNNPackedLayer>> layers;
+  {
+    std::lock_guard<std::mutex> lock(*context.mutex_);
+    state = get_or_create_state(context, stream_id, mini_batch, scalar_type);
+    layers = get_packed_weights(context, seq_length, mini_batch, scalar_type);
+  }
+
+  auto output = is_lstm(context)
+      ? run_lstm(x, *layers, state, context.hidden_size_)
+      : run_gru(x, *layers, state, context.hidden_size_);
+
+  {
+    std::lock_guard<std::mutex> lock(*context.mutex_);
+    context.states_[stream_id] = std::move(state);
+  }
+  return context.batch_first_ ? output.transpose(0, 1) : output;
+}
+
+void reset_state(ContextRNN& context, int64_t stream_id) {
+  std::lock_guard<std::mutex> lock(*context.mutex_);
+  context.states_.erase(stream_id);
+}
+
+std::vector<at::Tensor> get_state(ContextRNN& context, int64_t stream_id) {
+  std::lock_guard<std::mutex> lock(*context.mutex_);
+  auto it = context.states_.find(stream_id);
+  TORCH_CHECK(
+      it != context.states_.end(),
+      "ipex_prepack::rnn_run: no state for stream ",
+      stream_id);
+  auto hx = at::cat(it->second.hx_, 0);
+  auto cx =
+      it->second.cx_.empty() ? at::Tensor() : at::cat(it->second.cx_, 0);
+  return {hx, cx};
+}
+
+void set_state(
+    ContextRNN& context,
+    int64_t stream_id,
+    const at::Tensor& hx,
+    const c10::optional<at::Tensor>& cx) {
+  TORCH_CHECK(
+      hx.dim() == 3 && hx.size(0) == context.num_layers_ &&
+          hx.size(2) == context.hidden_size_,
+      "ipex_prepack::rnn_run: expect hx of shape [num_layers, batch, hidden_size]");
+  TORCH_CHECK(
+      is_lstm(context) == cx.has_value(),
+      "ipex_prepack::rnn_run: cx should be given only for LSTM");
+  RNNStreamState state;
+  for (int64_t l = 0; l < context.num_layers_; l++) {
+    state.hx_.push_back(hx.narrow(0, l, 1).contiguous());
+    if (cx.has_value()) {
+      TORCH_CHECK(
+          cx.value().sizes() == hx.sizes(),
+          "ipex_prepack::rnn_run: expect cx to be of the same shape as hx");
+      state.cx_.push_back(cx.value().narrow(0, l, 1).contiguous());
+    }
+  }
+  std::lock_guard<std::mutex> lock(*context.mutex_);
+  context.states_[stream_id] = std::move(state);
+}
+
+} // namespace rnn
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include "ContextRNN.h"
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace rnn {
+
+c10::intrusive_ptr<RNNOpContext> createRNNPrePackOpContext(
+    std::vector<at::Tensor>&& params,
+    std::string&& mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool batch_first);
+
+ContextRNN create(
+    std::vector<at::Tensor>& params,
+    std::string& mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool batch_first);
+
+at::Tensor run(
+    ContextRNN& context,
+    const at::Tensor& input,
+    int64_t stream_id);
+
+void reset_state(ContextRNN& context, int64_t stream_id);
+
+std::vector<at::Tensor> get_state(ContextRNN& context, int64_t stream_id);
+
+void set_state(
+    ContextRNN& context,
+    int64_t stream_id,
+    const at::Tensor& hx,
+    const c10::optional<at::Tensor>& cx);
+
+} // namespace rnn
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
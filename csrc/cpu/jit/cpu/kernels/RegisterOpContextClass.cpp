@@ -7,16 +7,21 @@
 #include "LinearPacked.h"
 #include "LinearWoqPacked.h"
 #include "OpContext.h"
+#include "RNNPacked.h"
 
 namespace torch_ipex {
 namespace cpu {
 using detail::conv_transpose::createConvTransposePrePackOpContext;
 using detail::convolution::createConvolutionPrePackOpContext;
 using detail::linear::createLinearPrePackOpContext;
+using detail::linear::createLinearPrePackOpContextFromPacked;
 using detail::mkl_sgemm::createLinearMKLPrePackOpContext;
+using detail::rnn::createRNNPrePackOpContext;
 #ifdef USE_LIBXSMM
 using detail::woq_linear::createWoqLinearPrePackOpContext;
+using detail::woq_linear::createWoqLinearPrePackOpContextFromPacked;
 using detail::woq_linear::createWoqLinearPrePackOpContextInt4;
+using detail::woq_linear::createWoqLinearPrePackOpContextMX;
 #endif
 
 TORCH_LIBRARY(ipex_prepack, m) {
@@ -121,6 +126,28 @@ TORCH_LIBRARY(ipex_prepack, m) {
       .def(
           "load_from_ctx",
           &torch_ipex::cpu::ConvTransposeOpContext::load_from_ctx);
+  m.class_<RNNOpContext>("RNNOpContext")
+      .def_pickle(
+          [](const c10::intrusive_ptr<RNNOpContext>& op_context)
+              -> SerializationTypeRNNPrePack { // __getstate__
+            return op_context->unpack();
+          },
+          [](SerializationTypeRNNPrePack state)
+              -> c10::intrusive_ptr<RNNOpContext> { // __setstate__
+            return createRNNPrePackOpContext(
+                std::move(std::get<0>(state)), // params
+                std::move(std::get<1>(state)), // mode
+                std::move(std::get<2>(state)), // hidden_size
+                std::move(std::get<3>(state)), // num_layers
+                std::move(std::get<4>(state)), // has_biases
+                std::move(std::get<5>(state))); // batch_first
+          })
+      .def("run", &torch_ipex::cpu::RNNOpContext::run)
+      .def("reset_state", &torch_ipex::cpu::RNNOpContext::reset_state)
+      .def("get_state", &torch_ipex::cpu::RNNOpContext::get_state)
+      .def("set_state", &torch_ipex::cpu::RNNOpContext::set_state)
+      .def("get_num_streams", &torch_ipex::cpu::RNNOpContext::get_num_streams)
+      .def("get_data_handle", &torch_ipex::cpu::RNNOpContext::get_data_handle);
 #ifdef USE_LIBXSMM
   m.class_<WoqLinearOpContext>("WoqLinearOpContext")
       .def_pickle(
@@ -128,20 +155,40 @@ TORCH_LIBRARY(ipex_prepack, m) {
               -> SerializationTypeWoqLinearPrePack { // __getstate__
             return op_context->unpack();
           },
-          [](SerializationTypeWoqLinearPrePack state)
+          [](c10::IValue state)
               -> c10::intrusive_ptr<WoqLinearOpContext> { // __setstate__
+            // The state is a SerializationTypeWoqLinearPrePack. Contexts
+            // pickled before g_idx and weight_dtype were added have 11 and 12
+            // elements, and the missing ones take their default.
+            const auto& elements = state.toTupleRef().elements();
+            TORCH_CHECK(
+                elements.size() >= 11 && elements.size() <= 13,
+                "WoqLinearOpContext: unexpected state of ",
+                elements.size(),
+                " elements");
             return createWoqLinearPrePackOpContext(
-                std::move(std::get<0>(state)), // weight
-                std::move(std::get<1>(state)), // weight shape
-                std::move(std::get<2>(state)), // scales
-                std::move(std::get<3>(state)), // zero points
-                std::move(std::get<4>(state)), // bias
-                std::move(std::get<5>(state)), // batch size
-                std::move(std::get<6>(state)), // is_int4
-                std::move(std::get<7>(state)), // group size
-                std::move(std::get<8>(state)), // lowp_mode
-                std::move(std::get<9>(state)), // num_concats
-                std::move(std::get<10>(state))); // act_quant_mode
+                elements[0].toTensor(), // weight
+                elements[1].toIntVector(), // weight shape
+                elements[2].toTensor(), // scales
+                elements[3].toTensor(), // zero points
+                elements[4].toOptional<at::Tensor>(), // bias
+                elements[5].toOptional<int64_t>(), // batch size
+                elements[6].toBool(), // is_int4
+                elements[7].toInt(), // group size
+                elements[8].toInt(), // lowp_mode
+                elements[9].toInt(), // num_concats
+                elements[10].toInt(), // act_quant_mode
+                // g_idx
+                elements.size() > 11 ? elements[11].toOptional<at::Tensor>()
+                                     : c10::nullopt,
+                // weight_dtype
+                elements.size() > 12 ? elements[12].toInt() : 0);
+          })
+      .def(
+          "packed_state",
+          [](const c10::intrusive_ptr<WoqLinearOpContext>& op_context)
+              -> SerializationTypeWoqLinearPrePack {
+            return op_context->packed_state();
           })
       .def(
           "get_weight",
@@ -170,6 +217,10 @@ TORCH_LIBRARY(ipex_prepack, m) {
   m.def(
       "linear_prepack(Tensor W, Tensor? B, int? batch_size) "
       "-> __torch__.torch.classes.ipex_prepack.LinearOpContext");
+  m.def(
+      "linear_prepack_from_packed(Tensor W, int[] W_shape, Tensor? B, "
+      "int? batch_size) "
+      "-> __torch__.torch.classes.ipex_prepack.LinearOpContext");
   m.def(
       "mkl_sgemm_prepack(Tensor W, Tensor? B, int? batch_size) "
       "-> __torch__.torch.classes.ipex_prepack.MKLOpContext");
@@ -178,12 +229,26 @@ TORCH_LIBRARY(ipex_prepack, m) {
       "int[] padding, int[] output_padding, int groups, int[] dilation, "
       "bool input_is_channels_last, int[] input_sizes) "
       "-> __torch__.torch.classes.ipex_prepack.ConvTransposeOpContext");
+  m.def(
+      "rnn_prepack(Tensor[] params, str mode, int hidden_size, "
+      "int num_layers, bool has_biases, bool batch_first) "
+      "-> __torch__.torch.classes.ipex_prepack.RNNOpContext");
 #ifdef USE_LIBXSMM
   m.def(
-      "weight_only_qlinear_prepack(Tensor W, int[] W_shape, Tensor scales, Tensor zero_points, Tensor? B, int? batch_size, bool is_int4, int group_size, int lowp_mode, int num_concats, int act_quant_mode) "
+      "weight_only_qlinear_prepack(Tensor W, int[] W_shape, Tensor scales, Tensor zero_points, Tensor? B, int? batch_size, bool is_int4, int group_size, int lowp_mode, int num_concats, int act_quant_mode, Tensor? g_idx=None, int weight_dtype=0) "
       "-> __torch__.torch.classes.ipex_prepack.WoqLinearOpContext");
   m.def(
-      "weight_only_qlinear_prepack_int4(Tensor W, Tensor scales, Tensor zero_points, Tensor? B, int? batch_size, int group_size, int lowp_mode, int num_concats, int act_quant_mode) "
+      "weight_only_qlinear_prepack_from_packed(Tensor W, int[] W_shape, "
+      "Tensor scales, Tensor zero_points, Tensor? B, int? batch_size, "
+      "bool is_int4, int group_size, int lowp_mode, int num_concats, "
+      "int act_quant_mode, Tensor? g_idx=None, int weight_dtype=0) "
+      "-> __torch__.torch.classes.ipex_prepack.WoqLinearOpContext");
+  m.def(
+      "weight_only_qlinear_prepack_int4(Tensor W, Tensor scales, Tensor zero_points, Tensor? B, int? batch_size, int group_size, int lowp_mode, int num_concats, int act_quant_mode, Tensor? g_idx=None, int weight_bits=4) "
+      "-> __torch__.torch.classes.ipex_prepack.WoqLinearOpContext");
+  m.def(
+      "weight_only_qlinear_prepack_mx(Tensor W, Tensor scales, Tensor? B, "
+      "int? batch_size, str format, int lowp_mode, int num_concats) "
       "-> __torch__.torch.classes.ipex_prepack.WoqLinearOpContext");
 #endif
 }
@@ -191,20 +256,34 @@ TORCH_LIBRARY(ipex_prepack, m) {
 TORCH_LIBRARY_IMPL(ipex_prepack, CPU, m) {
   m.impl("convolution_prepack", TORCH_FN(createConvolutionPrePackOpContext));
   m.impl("linear_prepack", TORCH_FN(createLinearPrePackOpContext));
+  m.impl(
+      "linear_prepack_from_packed",
+      TORCH_FN(createLinearPrePackOpContextFromPacked));
   m.impl("mkl_sgemm_prepack", TORCH_FN(createLinearMKLPrePackOpContext));
   m.impl(
       "conv_transpose_prepack", TORCH_FN(createConvTransposePrePackOpContext));
+  m.impl("rnn_prepack", TORCH_FN(createRNNPrePackOpContext));
 }
 #ifdef USE_LIBXSMM
 TORCH_LIBRARY_IMPL(ipex_prepack, CPU, m) {
   m.impl(
       "weight_only_qlinear_prepack", TORCH_FN(createWoqLinearPrePackOpContext));
 }
+TORCH_LIBRARY_IMPL(ipex_prepack, CPU, m) {
+  m.impl(
+      "weight_only_qlinear_prepack_from_packed",
+      TORCH_FN(createWoqLinearPrePackOpContextFromPacked));
+}
 TORCH_LIBRARY_IMPL(ipex_prepack, CPU, m) {
   m.impl(
       "weight_only_qlinear_prepack_int4",
       TORCH_FN(createWoqLinearPrePackOpContextInt4));
 }
+TORCH_LIBRARY_IMPL(ipex_prepack, CPU, m) {
+  m.impl(
+      "weight_only_qlinear_prepack_mx",
+      TORCH_FN(createWoqLinearPrePackOpContextMX));
+}
 #endif
 } // namespace cpu
 } // namespace torch_ipex
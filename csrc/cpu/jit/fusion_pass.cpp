@@ -83,6 +83,7 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
 
   // ipex einsum
   graph_rewrite::FusedEinsumPost(graph);
+  graph_rewrite::replaceEinsumWithIpexEinsum(graph);
 
   // replace python GELU to Aten GELU which are equally in math for more post-op
   // fusions
@@ -125,7 +126,9 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
   graph_rewrite::fuseConvAddRelu(graph);
   GRAPH_DUMP("After fuseConvAddRelu.Before fuseBottleneck", graph);
   graph_rewrite::fuseBottleneck(graph);
-  GRAPH_DUMP("After fuseBottleneck.", graph);
+  GRAPH_DUMP("After fuseBottleneck.Before fuseGroupNormSilu", graph);
+  graph_rewrite::fuseGroupNormSilu(graph);
+  GRAPH_DUMP("After fuseGroupNormSilu.", graph);
 
   // TODO: Record original aten nodes, while convert aten linear-> ipex linear,
   // will ignore these aten linear (if they are fp32 dtype). For BF16 dtype,
@@ -196,6 +199,7 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
   // TODO: Some post processing?? ECS/EDC/Peephole???
 
   graph_rewrite::simplifyAllReduce(graph);
+  graph_rewrite::replaceAllReduceWithShmAllReduce(graph);
   // This path contains two functions:
   // 1. Fuse BF16 Mha for ViT because ViT has a special QKV split algorithm
   // 2. Replace the Matmul OP with MKL or DNNL Matmul kernels to enable
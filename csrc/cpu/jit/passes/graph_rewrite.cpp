@@ -4,6 +4,7 @@
 
 #include <ATen/code_template.h>
 #include <torch/csrc/jit/passes/remove_mutation.h>
+#include "aten/ShmAllReduce.h"
 #include "utils/onednn_utils.h"
 
 namespace torch_ipex {
@@ -1369,6 +1370,27 @@ void simplifyAllReduce(std::shared_ptr<Graph>& graph) {
   rewriter_v2.runOnGraph(graph);
 }
 
+// Swap in the shared memory all-reduce once the ranks of the host attached to
+// the segment. torch_ipex::shm_all_reduce falls back to
+// deepspeed_comm::all_reduce itself for the messages it does not handle.
+void replaceAllReduceWithShmAllReduce(std::shared_ptr<Graph>& graph) {
+  if (!torch_ipex::cpu::shm_comm_is_initialized()) {
+    return;
+  }
+  std::string all_reduce = R"(
+    graph(%a):
+      %r = deepspeed_comm::all_reduce(%a)
+      return (%r) )";
+  std::string shm_all_reduce = R"(
+    graph(%a):
+      %r = torch_ipex::shm_all_reduce(%a)
+      return (%r) )";
+
+  SubgraphRewriter rewriter;
+  rewriter.RegisterRewritePattern(all_reduce, shm_all_reduce);
+  rewriter.runOnGraph(graph);
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch_ipex
@@ -42,6 +42,8 @@ void replaceLstmWithQLstm(std::shared_ptr<torch::jit::Graph>& graph);
 void replaceAddWithQAdd(std::shared_ptr<torch::jit::Graph>& graph);
 
 void simplifyAllReduce(std::shared_ptr<torch::jit::Graph>& graph);
+void replaceAllReduceWithShmAllReduce(
+    std::shared_ptr<torch::jit::Graph>& graph);
 void replaceFrozenIPEXConvWithAtenConv(
     std::shared_ptr<torch::jit::Graph>& graph);
 void replaceFrozenIPEXLinearWithAtenLinear(
@@ -49,6 +51,7 @@ void replaceFrozenIPEXLinearWithAtenLinear(
     const bool& use_mkl_sgemm);
 void insertPrePackedConvOp(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvWithEltwiseAdd(std::shared_ptr<torch::jit::Graph>& graph);
+void fuseGroupNormSilu(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvAddRelu(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseBottleneck(std::shared_ptr<torch::jit::Graph>& graph);
 void RecordAtenLinearNodes(
@@ -73,6 +76,7 @@ void fuseConvTransposeWithEltwise(std::shared_ptr<torch::jit::Graph>& graph);
 void fuseConvTransposeAdd(std::shared_ptr<torch::jit::Graph>& graph);
 
 void FusedEinsumPost(std::shared_ptr<torch::jit::Graph>& graph);
+void replaceEinsumWithIpexEinsum(std::shared_ptr<torch::jit::Graph>& graph);
 
 void FusedTransFreeMha(std::shared_ptr<torch::jit::Graph>& graph);
 void FusePythonGELUWithAten(std::shared_ptr<torch::jit::Graph>& graph);
@@ -340,6 +340,123 @@ void fuseConvWithEltwiseAdd(std::shared_ptr<Graph>& graph) {
       graph, fuse_add_filter_accumu_on_the_left);
 }
 
+void fuseGroupNormSilu(std::shared_ptr<Graph>& graph) {
+  SubgraphRewriter rewriter_silu, rewriter_silu_add_on_the_right,
+      rewriter_silu_add_on_the_left;
+  std::array<std::string, 2> silu_operators = {"silu", "silu_"};
+  std::array<std::string, 2> add_operators = {"add", "add_"};
+
+  // GroupNorm + SiLU of the diffusion UNet and VAE blocks
+  auto group_norm_silu_rstring = CodeTemplate(R"(
+    graph(%input, %num_groups:int, %weight, %bias, %eps:float, %cudnn_enabled:bool):
+        %x = aten::group_norm(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled)
+        %res = aten::${silu}(%x)
+        return (%res))");
+
+  std::string group_norm_silu_fused = R"(
+    graph(%input, %num_groups:int, %weight, %bias, %eps:float, %cudnn_enabled:bool):
+        %other : NoneType = prim::Constant()
+        %res = torch_ipex::group_norm_silu(%input, %num_groups, %weight, %bias, %other, %eps)
+        return (%res))";
+
+  // group_norm_silu   Y
+  //             \    /
+  //              add
+  // output = group_norm_silu_output + alpha*Y
+  auto group_norm_silu_add_on_the_right_rstring = CodeTemplate(R"(
+    graph(%input, %num_groups:int, %weight, %bias, %eps:float, %cudnn_enabled:bool, %accumu, %alpha):
+        %x = aten::group_norm(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled)
+        %y = aten::${silu}(%x)
+        %res = aten::${add}(%y, %accumu, %alpha)
+        return (%res))");
+
+  //  Y     group_norm_silu
+  //   \   /
+  //    add
+  // output = Y + alpha*group_norm_silu_output, alpha need to be one.
+  auto group_norm_silu_add_on_the_left_rstring = CodeTemplate(R"(
+    graph(%input, %num_groups:int, %weight, %bias, %eps:float, %cudnn_enabled:bool, %accumu, %alpha):
+        %x = aten::group_norm(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled)
+        %y = aten::${silu}(%x)
+        %res = aten::add(%accumu, %y, %alpha)
+        return (%res))");
+
+  std::string group_norm_silu_add_fused = R"(
+    graph(%input, %num_groups:int, %weight, %bias, %eps:float, %cudnn_enabled:bool, %accumu, %alpha):
+        %res = torch_ipex::group_norm_silu(%input, %num_groups, %weight, %bias, %accumu, %eps)
+        return (%res))";
+
+  for (const auto& silu : silu_operators) {
+    TemplateEnv env;
+    env.s("silu", silu);
+    rewriter_silu.RegisterRewritePattern(
+        group_norm_silu_rstring.format(env), group_norm_silu_fused);
+    // The in-place add on the left writes Y, which is not fused
+    rewriter_silu_add_on_the_left.RegisterRewritePattern(
+        group_norm_silu_add_on_the_left_rstring.format(env),
+        group_norm_silu_add_fused);
+    for (const auto& add : add_operators) {
+      env.s("add", add);
+      rewriter_silu_add_on_the_right.RegisterRewritePattern(
+          group_norm_silu_add_on_the_right_rstring.format(env),
+          group_norm_silu_add_fused);
+    }
+  }
+
+  // The fused kernel adds Y of the shape and the dtype of the output without
+  // broadcast nor type promotion, and alpha should be one.
+  auto fuse_add_filter = [](const Match& match,
+                            const std::unordered_map<std::string, Value*>&
+                                vmap) {
+    auto accumu = match.values_map.at(vmap.at("accumu"));
+    auto add_node = match.values_map.at(vmap.at("res"))->node();
+    if (!accumu->type()->cast<TensorType>()) {
+      return false;
+    }
+    auto size1_option = add_node->inputs()
+                            .at(0)
+                            ->type()
+                            ->cast<TensorType>()
+                            ->sizes()
+                            .concrete_sizes();
+    auto size2_option = add_node->inputs()
+                            .at(1)
+                            ->type()
+                            ->cast<TensorType>()
+                            ->sizes()
+                            .concrete_sizes();
+    if (!size1_option.has_value() || !size2_option.has_value() ||
+        size1_option.value().empty() ||
+        size1_option.value() != size2_option.value()) {
+      return false;
+    }
+    // group_norm_silu casts Y to the dtype of X, while aten::add promotes
+    auto dtype1_option =
+        add_node->inputs().at(0)->type()->cast<TensorType>()->scalarType();
+    auto dtype2_option =
+        add_node->inputs().at(1)->type()->cast<TensorType>()->scalarType();
+    if (!dtype1_option.has_value() || !dtype2_option.has_value() ||
+        dtype1_option.value() != dtype2_option.value()) {
+      return false;
+    }
+    auto alpha = toIValue(match.values_map.at(vmap.at("alpha")));
+    if (!alpha.has_value()) {
+      return false;
+    }
+    if (alpha.value().isDouble()) {
+      return alpha.value().toDouble() == 1.0;
+    }
+    if (alpha.value().isInt()) {
+      return alpha.value().toInt() == 1;
+    }
+    return false;
+  };
+
+  rewriter_silu_add_on_the_right.runOnGraph(graph, fuse_add_filter);
+  rewriter_silu_add_on_the_left.runOnGraph(graph, fuse_add_filter);
+  rewriter_silu.runOnGraph(graph);
+}
+
 void fuseConvAddRelu(std::shared_ptr<Graph>& graph) {
   SubgraphRewriter rewriter_add_accumu_on_the_right,
       rewriter_add_accumu_on_the_left, rewriter_add_relu;
@@ -26,6 +26,22 @@ auto ipex_einsum_filter =
       return true;
     };
 
+// Equations of 3 or more operands without ellipsis, for the contraction
+// path planner of ipex::einsum
+auto ipex_einsum_multi_filter =
+    [](const Match& match,
+       const std::unordered_map<std::string, Value*>& vmap) {
+      const auto& match_vmap = match.values_map;
+      auto equation_value = torch_ipex::jit::graph_rewrite_helper::getIValue(
+          "equation", match_vmap, vmap);
+      if (!equation_value.has_value()) {
+        return false;
+      }
+      auto equation = equation_value.value().toStringView();
+      int num_ops = std::count(equation.begin(), equation.end(), ',') + 1;
+      return num_ops >= 3 && equation.find('.') == std::string::npos;
+    };
+
 void FusedEinsumPost(std::shared_ptr<Graph>& graph) {
   SubgraphRewriter rewriter_einsum_binary;
   std::array<std::string, 2> binarys = {"add", "add_"};
@@ -48,6 +64,20 @@ void FusedEinsumPost(std::shared_ptr<Graph>& graph) {
   rewriter_einsum_binary.runOnGraph(graph, ipex_einsum_filter);
 }
 
+void replaceEinsumWithIpexEinsum(std::shared_ptr<Graph>& graph) {
+  SubgraphRewriter rewriter_einsum;
+  std::string aten_einsum = R"(
+     graph(%equation, %inputs, %path):
+        %res = aten::einsum(%equation, %inputs, %path)
+        return (%res))";
+  std::string ipex_einsum = R"(
+     graph(%equation, %inputs, %path):
+        %res = ipex::einsum(%equation, %inputs)
+        return (%res))";
+  rewriter_einsum.RegisterRewritePattern(aten_einsum, ipex_einsum);
+  rewriter_einsum.runOnGraph(graph, ipex_einsum_multi_filter);
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch_ipex
@@ -48,6 +48,14 @@ auto bert_flash_mha_filter =
       return true;
     };
 
+// The Stable-Diffusion MHA fusion runs the blocked Flash Attention kernel,
+// which supports BF16 and FP32
+bool sd_flash_mha_dtype_supported(const TensorTypePtr& input) {
+  auto dtype = input->scalarType();
+  return dtype.has_value() &&
+      (dtype.value() == at::kBFloat16 || dtype.value() == at::kFloat);
+}
+
 auto sd_flash_mha_filter_v1 = [](const Match& match,
                                  const std::unordered_map<std::string, Value*>&
                                      vmap) {
@@ -77,7 +85,7 @@ auto sd_flash_mha_filter_v1 = [](const Match& match,
   std::vector<int64_t> permute_ref = {0, 2, 1, 3};
   if (permute_sizes != permute_ref ||
       !(zero == 0 && neg_one == -1 && neg_two == -2 && one == 1 && two == 2) ||
-      qkv->scalarType().value() != at::kBFloat16 || split_idx.size() != 3 ||
+      !sd_flash_mha_dtype_supported(qkv) || split_idx.size() != 3 ||
       split_idx[0] != split_idx[1] || split_idx[0] != split_idx[2]) {
     return false;
   }
@@ -110,7 +118,7 @@ auto sd_flash_mha_filter_v2 = [](const Match& match,
   std::vector<int64_t> permute_ref = {0, 2, 1, 3};
   if (permute_sizes != permute_ref ||
       !(zero == 0 && neg_one == -1 && neg_two == -2 && one == 1 && two == 2) ||
-      query0->scalarType().value() != at::kBFloat16) {
+      !sd_flash_mha_dtype_supported(query0)) {
     return false;
   }
   return true;
@@ -136,8 +144,18 @@ auto sd_flash_mha_filter_v3 =
                      "qkv", match_vmap, vmap)
                      ->type()
                      ->cast<TensorType>();
+      // No dropout and no causal mask in the inference
+      auto dropout = toIValue(graph_rewrite_helper::getValue(
+                                  "dropout", match_vmap, vmap))
+                         ->toDouble();
+      auto is_causal =
+          toIValue(graph_rewrite_helper::getValue("no", match_vmap, vmap))
+              ->toBool();
+      if (dropout != 0 || is_causal) {
+        return false;
+      }
       if (!(one == 1 && two == 2 && neg_one == -1) ||
-          qkv->scalarType().value() != at::kBFloat16 || split_idx.size() != 3 ||
+          !sd_flash_mha_dtype_supported(qkv) || split_idx.size() != 3 ||
           split_idx[0] != split_idx[1] || split_idx[0] != split_idx[2]) {
         return false;
       }
@@ -161,8 +179,18 @@ auto sd_flash_mha_filter_v4 =
                         "query0", match_vmap, vmap)
                         ->type()
                         ->cast<TensorType>();
+      // No dropout and no causal mask in the inference
+      auto dropout = toIValue(graph_rewrite_helper::getValue(
+                                  "dropout", match_vmap, vmap))
+                         ->toDouble();
+      auto is_causal =
+          toIValue(graph_rewrite_helper::getValue("no", match_vmap, vmap))
+              ->toBool();
+      if (dropout != 0 || is_causal) {
+        return false;
+      }
       if (!(one == 1 && two == 2 && neg_one == -1) ||
-          query0->scalarType().value() != at::kBFloat16) {
+          !sd_flash_mha_dtype_supported(query0)) {
         return false;
       }
       return true;
@@ -530,12 +558,12 @@ void FusedTransFreeMha(std::shared_ptr<Graph>& graph) {
   sd_mha_fusion_v2.RegisterRewritePattern(
       sd_mha_pattern_v2, sd_fused_mha_pattern_v2);
   sd_mha_fusion_v2.runOnGraph(graph, sd_flash_mha_filter_v2);
-  // sd_mha_fusion_v3.RegisterRewritePattern(
-  //     sd_mha_pattern_v3, sd_fused_mha_pattern_v3);
-  // sd_mha_fusion_v3.runOnGraph(graph, sd_flash_mha_filter_v3);
-  // sd_mha_fusion_v4.RegisterRewritePattern(
-  //     sd_mha_pattern_v4, sd_fused_mha_pattern_v4);
-  // sd_mha_fusion_v4.runOnGraph(graph, sd_flash_mha_filter_v4);
+  sd_mha_fusion_v3.RegisterRewritePattern(
+      sd_mha_pattern_v3, sd_fused_mha_pattern_v3);
+  sd_mha_fusion_v3.runOnGraph(graph, sd_flash_mha_filter_v3);
+  sd_mha_fusion_v4.RegisterRewritePattern(
+      sd_mha_pattern_v4, sd_fused_mha_pattern_v4);
+  sd_mha_fusion_v4.runOnGraph(graph, sd_flash_mha_filter_v4);
 
   auto bmm_pattern = R"(
     graph(%batch1, %batch2):
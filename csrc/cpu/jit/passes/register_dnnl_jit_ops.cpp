@@ -1552,6 +1552,19 @@ torch::jit::RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::einsum(str equation, Tensor[] tensors) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = einsum_multi(
+                (std::move(peek(stack, 0, 2))).toStringView(),
+                (std::move(peek(stack, 1, 2))).toTensorList());
+            drop(stack, 2);
+            torch::jit::pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex::max_pool2d(Tensor input, int[2] kernel_size, int[2] stride, "
         "int[2] padding, int[2] dilation, bool ceil_mode) -> Tensor",
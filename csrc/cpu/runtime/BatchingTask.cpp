@@ -0,0 +1,207 @@
+#include "BatchingTask.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace torch_ipex {
+namespace runtime {
+
+namespace {
+
+using Batch = std::vector<std::shared_ptr<BatchingTask::Request>>;
+
+at::Tensor pad_to(
+    const at::Tensor& t,
+    int64_t dim,
+    int64_t length,
+    double pad_value) {
+  if (t.dim() <= dim || t.size(dim) == length) {
+    return t;
+  }
+  auto sizes = t.sizes().vec();
+  sizes[dim] = length;
+  auto padded = at::full(sizes, pad_value, t.options());
+  padded.narrow(dim, 0, t.size(dim)).copy_(t);
+  return padded;
+}
+
+std::vector<at::Tensor> concat_inputs(
+    const Batch& batch,
+    const BatchingPolicy& policy) {
+  int64_t max_length = 0;
+  for (const auto& request : batch) {
+    max_length = std::max(max_length, request->length);
+  }
+  auto num_inputs = batch[0]->inputs.size();
+  std::vector<at::Tensor> inputs;
+  for (size_t i = 0; i < num_inputs; i++) {
+    std::vector<at::Tensor> parts;
+    for (const auto& request : batch) {
+      if (request->inputs.size() != num_inputs) {
+        throw std::runtime_error(
+            "BatchingTask: the requests of a batch have different numbers "
+            "of inputs.");
+      }
+      auto input = request->inputs[i];
+      if (policy.pad_dim >= 0) {
+        input = pad_to(input, policy.pad_dim, max_length, policy.pad_value);
+      }
+      parts.push_back(input);
+    }
+    inputs.push_back(at::cat(parts, 0));
+  }
+  return inputs;
+}
+
+void run_batch(
+    const BatchingTask::BatchFunction& f,
+    const BatchingPolicy& policy,
+    const Batch& batch) {
+  try {
+    if (batch.size() == 1) {
+      batch[0]->promise.set_value(f(batch[0]->inputs));
+      return;
+    }
+    auto outputs = f(concat_inputs(batch, policy));
+    std::vector<int64_t> batch_sizes;
+    for (const auto& request : batch) {
+      batch_sizes.push_back(request->batch_size);
+    }
+    std::vector<std::vector<at::Tensor>> results(batch.size());
+    for (const auto& output : outputs) {
+      auto parts = at::split_with_sizes(output, batch_sizes, 0);
+      for (size_t i = 0; i < batch.size(); i++) {
+        auto part = parts[i];
+        if (policy.output_pad_dim >= 0 && part.dim() > policy.output_pad_dim) {
+          part = part.narrow(policy.output_pad_dim, 0, batch[i]->length);
+        }
+        results[i].push_back(part);
+      }
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+      batch[i]->promise.set_value(std::move(results[i]));
+    }
+  } catch (...) {
+    for (const auto& request : batch) {
+      request->promise.set_exception(std::current_exception());
+    }
+  }
+}
+
+} // namespace
+
+BatchingTask::BatchingTask(
+    BatchFunction f,
+    std::shared_ptr<TaskExecutor> task_executor,
+    BatchingPolicy policy)
+    : f(std::move(f)),
+      task_executor(std::move(task_executor)),
+      policy(policy) {
+  if (policy.max_batch_size < 1 || policy.max_delay_us < 0 ||
+      policy.pad_dim == 0 || policy.output_pad_dim == 0) {
+    throw std::runtime_error(
+        "Fail to init BatchingTask. Expect a positive max_batch_size, a "
+        "non-negative max_delay_us, and pad dims other than the batch dim.");
+  }
+  this->collector = std::thread([this] { this->collect(); });
+}
+
+BatchingTask::~BatchingTask() {
+  this->stop();
+}
+
+std::future<std::vector<at::Tensor>> BatchingTask::operator()(
+    std::vector<at::Tensor> inputs) {
+  if (inputs.empty() || inputs[0].dim() == 0) {
+    throw std::runtime_error(
+        "BatchingTask: expect the inputs batched along dim 0.");
+  }
+  auto request = std::make_shared<Request>();
+  request->batch_size = inputs[0].size(0);
+  for (const auto& input : inputs) {
+    if (input.dim() == 0 || input.size(0) != request->batch_size) {
+      throw std::runtime_error(
+          "BatchingTask: expect the inputs of the same batch size.");
+    }
+  }
+  request->length = 0;
+  if (this->policy.pad_dim >= 0) {
+    if (inputs[0].dim() <= this->policy.pad_dim) {
+      throw std::runtime_error(
+          "BatchingTask: the first input has no pad dim " +
+          std::to_string(this->policy.pad_dim) + ".");
+    }
+    request->length = inputs[0].size(this->policy.pad_dim);
+  }
+  request->inputs = std::move(inputs);
+  request->grad_mode = at::GradMode::is_enabled();
+  request->arrival = std::chrono::steady_clock::now();
+  auto res = request->promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->stopped)
+      throw std::runtime_error("BatchingTask submit after stop");
+    this->queued_samples += request->batch_size;
+    this->requests.push_back(std::move(request));
+  }
+  this->condition.notify_one();
+  return res;
+}
+
+void BatchingTask::collect() {
+  auto max_delay = std::chrono::microseconds(this->policy.max_delay_us);
+  while (true) {
+    Batch batch;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->condition.wait(
+          lock, [this] { return this->stopped || !this->requests.empty(); });
+      if (this->requests.empty())
+        return;
+      auto deadline = this->requests.front()->arrival + max_delay;
+      this->condition.wait_until(lock, deadline, [this] {
+        return this->stopped ||
+            this->queued_samples >= this->policy.max_batch_size;
+      });
+      int64_t samples = 0;
+      while (!this->requests.empty()) {
+        auto batch_size = this->requests.front()->batch_size;
+        if (!batch.empty() &&
+            samples + batch_size > this->policy.max_batch_size) {
+          break;
+        }
+        samples += batch_size;
+        batch.push_back(std::move(this->requests.front()));
+        this->requests.pop_front();
+      }
+      this->queued_samples -= samples;
+    }
+    auto grad_mode = batch[0]->grad_mode;
+    try {
+      this->task_executor->submit(
+          [f = this->f, policy = this->policy, batch, grad_mode]() {
+            at::GradMode::set_enabled(grad_mode);
+            run_batch(f, policy, batch);
+          });
+    } catch (...) {
+      // The executor is stopped
+      for (const auto& request : batch) {
+        request->promise.set_exception(std::current_exception());
+      }
+    }
+  }
+}
+
+void BatchingTask::stop() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->stopped)
+      return;
+    this->stopped = true;
+  }
+  this->condition.notify_all();
+  this->collector.join();
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <Macros.h>
+#include "TaskExecutor.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+struct BatchingPolicy {
+  // Samples of a batch. A request of more samples runs as a batch alone.
+  int64_t max_batch_size = 8;
+  // Time a request waits for the others to fill its batch
+  int64_t max_delay_us = 1000;
+  // Dim of the variable length of the inputs, which is padded to the
+  // longest request of the batch with pad_value. -1 if the requests of a
+  // batch have the same shapes except the batch dim.
+  int64_t pad_dim = -1;
+  double pad_value = 0;
+  // Dim of the outputs narrowed back to the length of each request, -1 to
+  // return them of the padded length
+  int64_t output_pad_dim = -1;
+};
+
+/*BatchingTask batches the concurrent requests to one function*/
+// Each request is a list of inputs batched along dim 0, usually of one
+// sample. The inputs of the requests are concatenated along dim 0, the
+// function runs once on the TaskExecutor for the whole batch, and its
+// outputs are split along dim 0 back to the futures of the requests.
+//
+// A batch is run once it has max_batch_size samples, or once its first
+// request has waited for max_delay_us. An error of the function is set to
+// the futures of all the requests of the batch.
+class IPEX_API BatchingTask {
+ public:
+  using BatchFunction =
+      std::function<std::vector<at::Tensor>(std::vector<at::Tensor>)>;
+
+  explicit BatchingTask(
+      BatchFunction f,
+      std::shared_ptr<TaskExecutor> task_executor,
+      BatchingPolicy policy = BatchingPolicy());
+  BatchingTask(const BatchingTask& task) = delete;
+  BatchingTask(BatchingTask&& task) = delete;
+  BatchingTask& operator=(const BatchingTask& task) = delete;
+  BatchingTask& operator=(BatchingTask&& task) = delete;
+  ~BatchingTask();
+
+  std::future<std::vector<at::Tensor>> operator()(
+      std::vector<at::Tensor> inputs);
+  // Run the queued requests without waiting for more
+  void stop();
+
+  struct Request {
+    std::vector<at::Tensor> inputs;
+    int64_t batch_size;
+    int64_t length;
+    bool grad_mode;
+    std::chrono::steady_clock::time_point arrival;
+    std::promise<std::vector<at::Tensor>> promise;
+  };
+
+ private:
+  void collect();
+
+  BatchFunction f;
+  std::shared_ptr<TaskExecutor> task_executor;
+  BatchingPolicy policy;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::shared_ptr<Request>> requests;
+  int64_t queued_samples{0};
+  bool stopped{false};
+  std::thread collector;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -8,6 +8,8 @@
 #include <Macros.h>
 #include <torch/csrc/jit/api/module.h>
 
+#include "CPUPoolArena.h"
+
 namespace torch_ipex {
 namespace runtime {
 
@@ -64,14 +66,24 @@ IPEX_API void set_mask_affinity_from_cpu_pool(const CPUPool& cpu_pool);
 
 class IPEX_API WithCPUPool {
  public:
-  explicit WithCPUPool(CPUPool&& cpu_pool)
+  // With use_numa_arena, the CPU allocations of the current thread inside
+  // the scope are served by the CPUPoolArena of the node of cpu_pool.
+  explicit WithCPUPool(CPUPool&& cpu_pool, bool use_numa_arena = false)
       : previous_cpu_pool(
             torch_ipex::runtime::get_cpu_pool_from_mask_affinity()),
-        current_cpu_pool(std::move(cpu_pool)) {
+        current_cpu_pool(std::move(cpu_pool)),
+        use_numa_arena(use_numa_arena) {
     torch_ipex::runtime::_pin_cpu_cores(current_cpu_pool);
+    if (use_numa_arena) {
+      previous_arena = torch_ipex::runtime::set_current_cpu_pool_arena(
+          CPUPoolArena::get(current_cpu_pool));
+    }
   }
 
   ~WithCPUPool() {
+    if (use_numa_arena) {
+      torch_ipex::runtime::set_current_cpu_pool_arena(previous_arena);
+    }
     torch_ipex::runtime::set_mask_affinity_from_cpu_pool(
         this->previous_cpu_pool);
   }
@@ -79,6 +91,8 @@ class IPEX_API WithCPUPool {
  private:
   CPUPool previous_cpu_pool;
   CPUPool current_cpu_pool;
+  bool use_numa_arena;
+  CPUPoolArena* previous_arena = nullptr;
 
   WithCPUPool() = delete;
   WithCPUPool(const WithCPUPool& cpu_pool_guard) = delete;
@@ -0,0 +1,320 @@
+#include "CPUPoolArena.h"
+#include "CPUPool.h"
+#include "utils/SysUtil.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace torch_ipex {
+namespace runtime {
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+constexpr size_t kPageSize = 4096;
+// MPOL_PREFERRED of <numaif.h>, which falls back to the other nodes instead
+// of failing when the node is out of memory
+constexpr int kMpolPreferred = 1;
+constexpr int64_t kDefaultMaxCachedBytes = int64_t(2) << 30;
+
+// Round up to a quarter of the power of two below nbytes, so that a buffer
+// is at most 25% larger than requested
+size_t size_class(size_t nbytes) {
+  if (nbytes <= kAlignment) {
+    return kAlignment;
+  }
+  size_t power = size_t(1) << (63 - __builtin_clzll(nbytes - 1));
+  size_t step = std::max(power / 4, kAlignment);
+  return (nbytes + step - 1) / step * step;
+}
+
+// NUMA node of a core from sysfs, -1 if unknown
+int32_t node_of_core(int32_t core) {
+#ifndef _WIN32
+  auto path = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return -1;
+  }
+  int32_t node = -1;
+  while (auto entry = readdir(dir)) {
+    if (std::strncmp(entry->d_name, "node", 4) == 0 &&
+        std::isdigit(entry->d_name[4])) {
+      node = std::atoi(entry->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+#else
+  return -1;
+#endif
+}
+
+int64_t max_cached_bytes_from_env() {
+  auto val = std::getenv("IPEX_CPU_POOL_ARENA_MAX_CACHED_BYTES");
+  return val != nullptr ? std::atoll(val) : kDefaultMaxCachedBytes;
+}
+
+thread_local CPUPoolArena* current_arena = nullptr;
+
+// The CPU allocator while any thread has an arena. The allocations of the
+// threads without arena go to the allocator it replaced.
+class CPUPoolArenaAllocator final : public c10::Allocator {
+ public:
+  c10::DataPtr allocate(size_t nbytes) const override {
+    if (current_arena != nullptr) {
+      return current_arena->allocate(nbytes);
+    }
+    return fallback_.load(std::memory_order_acquire)->allocate(nbytes);
+  }
+
+  void copy_data(void* dest, const void* src, std::size_t count)
+      const override {
+    std::memcpy(dest, src, count);
+  }
+
+  void set_fallback(c10::Allocator* fallback) {
+    fallback_.store(fallback, std::memory_order_release);
+  }
+
+  c10::Allocator* fallback() const {
+    return fallback_.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::atomic<c10::Allocator*> fallback_{nullptr};
+};
+
+// Never deleted, as the allocator may be installed until the exit
+CPUPoolArenaAllocator& arena_allocator() {
+  static auto allocator = new CPUPoolArenaAllocator();
+  return *allocator;
+}
+
+std::mutex allocator_mutex;
+// Threads with an arena
+int64_t num_arena_threads = 0;
+
+// Install the allocator when the first thread sets an arena, and restore the
+// one it replaced when the last thread resets its arena. The data pointers
+// of the arena keep their own deleters, so that the tensors allocated inside
+// the scope may outlive it.
+void update_allocator(bool had_arena, bool has_arena) {
+  if (had_arena == has_arena) {
+    return;
+  }
+  auto& allocator = arena_allocator();
+  std::lock_guard<std::mutex> lock(allocator_mutex);
+  if (has_arena) {
+    if (num_arena_threads++ == 0) {
+      auto previous = c10::GetAllocator(c10::DeviceType::CPU);
+      if (previous != &allocator) {
+        allocator.set_fallback(previous);
+        c10::SetAllocator(c10::DeviceType::CPU, &allocator);
+      }
+    }
+  } else if (--num_arena_threads == 0) {
+    // Keep an allocator installed on top of this one in place
+    if (c10::GetAllocator(c10::DeviceType::CPU) == &allocator) {
+      c10::SetAllocator(c10::DeviceType::CPU, allocator.fallback());
+    }
+  }
+}
+
+} // namespace
+
+CPUPoolArena* CPUPoolArena::get(const CPUPool& cpu_pool) {
+  if (!cpu_pool.is_cpu_core_list_initialized()) {
+    throw std::runtime_error(
+        "Fail to get the arena of CPUPool. Current CPUPool object didn't "
+        "express as cpu_core_list format.");
+  }
+  std::map<int32_t, int64_t> cores_per_node;
+  for (auto core : cpu_pool.get_cpu_core_list()) {
+    cores_per_node[node_of_core(core)]++;
+  }
+  int32_t node = -1;
+  int64_t max_cores = 0;
+  for (const auto& it : cores_per_node) {
+    if (it.second > max_cores) {
+      node = it.first;
+      max_cores = it.second;
+    }
+  }
+
+  static std::mutex mutex;
+  static std::map<int32_t, CPUPoolArena*> arenas;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& arena = arenas[node];
+  if (arena == nullptr) {
+    // Never deleted, as the tensors of the arena may outlive any scope
+    arena = new CPUPoolArena(node);
+  }
+  return arena;
+}
+
+CPUPoolArena::CPUPoolArena(int32_t node)
+    : node_(node), max_cached_bytes_(max_cached_bytes_from_env()) {}
+
+int32_t CPUPoolArena::node() const {
+  return node_;
+}
+
+CPUPoolArena::Block* CPUPoolArena::new_block(size_t size_class) {
+  auto size = size_class;
+  void* ptr = nullptr;
+  bool mapped = false;
+#ifndef _WIN32
+  if (size >= kPageSize) {
+    size = (size + kPageSize - 1) / kPageSize * kPageSize;
+    ptr = mmap(
+        nullptr,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    mapped = true;
+    bool bound = false;
+    if (node_ >= 0) {
+      std::vector<unsigned long> nodemask(node_ / 64 + 1, 0);
+      nodemask[node_ / 64] = 1UL << (node_ % 64);
+      bound = syscall(
+                  SYS_mbind,
+                  ptr,
+                  size,
+                  kMpolPreferred,
+                  nodemask.data(),
+                  nodemask.size() * 64 + 1,
+                  0) == 0;
+    }
+    if (!bound) {
+      // First touch from the allocating thread
+      for (size_t i = 0; i < size; i += kPageSize) {
+        static_cast<volatile char*>(ptr)[i] = 0;
+      }
+    }
+  }
+#endif
+  if (ptr == nullptr) {
+    ptr = ipex_alloc_aligned(size, kAlignment);
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+  return new Block{this, ptr, size, size_class, mapped};
+}
+
+void CPUPoolArena::release_block(Block* block) {
+#ifndef _WIN32
+  if (block->mapped) {
+    munmap(block->ptr, block->size);
+    delete block;
+    return;
+  }
+#endif
+  ipex_free_aligned(block->ptr);
+  delete block;
+}
+
+c10::DataPtr CPUPoolArena::allocate(size_t nbytes) {
+  auto size = size_class(nbytes);
+  Block* block = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.num_allocs++;
+    auto it = free_blocks_.find(size);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      block = it->second.back();
+      it->second.pop_back();
+      stats_.cached_bytes -= size;
+      stats_.num_cache_hits++;
+    }
+    stats_.allocated_bytes += size;
+  }
+  if (block == nullptr) {
+    try {
+      block = new_block(size);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.allocated_bytes -= size;
+      throw;
+    }
+  }
+  return {
+      block->ptr, block, &CPUPoolArena::free_block, c10::Device(c10::kCPU)};
+}
+
+void CPUPoolArena::free_block(void* ctx) {
+  auto block = static_cast<Block*>(ctx);
+  auto arena = block->arena;
+  auto size = block->size_class;
+  {
+    std::lock_guard<std::mutex> lock(arena->mutex_);
+    arena->stats_.allocated_bytes -= size;
+    if (arena->stats_.cached_bytes + size <= arena->max_cached_bytes_) {
+      arena->free_blocks_[size].push_back(block);
+      arena->stats_.cached_bytes += size;
+      return;
+    }
+  }
+  arena->release_block(block);
+}
+
+CPUPoolArenaStats CPUPoolArena::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void CPUPoolArena::empty_cache() {
+  std::unordered_map<size_t, std::vector<Block*>> blocks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks.swap(free_blocks_);
+    stats_.cached_bytes = 0;
+  }
+  for (auto& it : blocks) {
+    for (auto block : it.second) {
+      release_block(block);
+    }
+  }
+}
+
+void CPUPoolArena::set_max_cached_bytes(int64_t max_cached_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_cached_bytes_ = max_cached_bytes;
+  }
+  empty_cache();
+}
+
+CPUPoolArena* set_current_cpu_pool_arena(CPUPoolArena* arena) {
+  auto previous = current_arena;
+  update_allocator(previous != nullptr, arena != nullptr);
+  current_arena = arena;
+  return previous;
+}
+
+CPUPoolArena* get_current_cpu_pool_arena() {
+  return current_arena;
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,99 @@
+#pragma once
+#include <c10/core/Allocator.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <Macros.h>
+
+namespace torch_ipex {
+namespace runtime {
+
+class CPUPool;
+
+struct CPUPoolArenaStats {
+  // Bytes of the buffers in use, rounded up to their size classes
+  int64_t allocated_bytes = 0;
+  // Bytes of the free buffers kept for reuse
+  int64_t cached_bytes = 0;
+  int64_t num_allocs = 0;
+  // Allocations served by a cached buffer
+  int64_t num_cache_hits = 0;
+};
+
+// Arena of the buffers placed on the NUMA node of a CPUPool.
+//
+// Buffers are rounded up to size classes of a quarter of a power of two, and
+// the freed buffers are kept in a free list per class for the following
+// allocations of the class, so that the buffers of the tensors of one
+// iteration are recycled by the next one.
+//
+// Buffers of at least one page are mapped and bound to the node by mbind
+// with a preferred policy. If the node is not known or mbind is not
+// permitted, the pages are first-touched by the allocating thread, which is
+// pinned to the pool inside WithCPUPool. Smaller buffers are taken from the
+// heap and are first-touched by their users.
+//
+// There is one arena per NUMA node for the lifetime of the process, shared
+// by all the pools of the node.
+class IPEX_API CPUPoolArena {
+ public:
+  // Arena of the node of most of the cores of cpu_pool, which must be
+  // expressed as a core list
+  static CPUPoolArena* get(const CPUPool& cpu_pool);
+
+  // NUMA node of the buffers, -1 if unknown
+  int32_t node() const;
+
+  // Buffer of at least nbytes, aligned to 64 bytes
+  c10::DataPtr allocate(size_t nbytes);
+
+  CPUPoolArenaStats stats();
+
+  // Release the cached buffers to the system
+  void empty_cache();
+
+  // Cached bytes above which freed buffers are released instead of cached
+  void set_max_cached_bytes(int64_t max_cached_bytes);
+
+ private:
+  struct Block {
+    CPUPoolArena* arena;
+    void* ptr;
+    // Bytes mapped or allocated, a mapped block is rounded up to pages
+    size_t size;
+    // Key of the free list, the size class the block was allocated for
+    size_t size_class;
+    bool mapped;
+  };
+
+  explicit CPUPoolArena(int32_t node);
+
+  Block* new_block(size_t size_class);
+  void release_block(Block* block);
+  static void free_block(void* ctx);
+
+  int32_t node_;
+  std::mutex mutex_;
+  std::unordered_map<size_t, std::vector<Block*>> free_blocks_;
+  CPUPoolArenaStats stats_;
+  int64_t max_cached_bytes_;
+
+  CPUPoolArena(const CPUPoolArena&) = delete;
+  CPUPoolArena& operator=(const CPUPoolArena&) = delete;
+};
+
+// Arena of the CPU allocations of the current thread, nullptr for the
+// default CPU allocator. Return the previous one.
+//
+// While any thread has an arena, a CPU allocator is installed which forwards
+// the allocations of the threads without arena to the CPU allocator it
+// replaces. The replaced allocator is restored when no thread has an arena.
+IPEX_API CPUPoolArena* set_current_cpu_pool_arena(CPUPoolArena* arena);
+IPEX_API CPUPoolArena* get_current_cpu_pool_arena();
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -21,7 +21,10 @@ namespace runtime {
 template <class F, class... Args>
 class IPEX_API Task {
  public:
-  explicit Task(F&& f, std::shared_ptr<TaskExecutor> task_executor);
+  explicit Task(
+      F&& f,
+      std::shared_ptr<TaskExecutor> task_executor,
+      TaskPriority priority = TaskPriority::kNormal);
   Task(const Task& task) = delete;
   Task(Task&& task) = delete;
   Task& operator=(const Task& task) = delete;
@@ -29,16 +32,27 @@ class IPEX_API Task {
   ~Task();
   auto operator()(Args&&... args)
       -> std::future<decltype(F()(std::forward<Args>(args)...))>;
+  // Submit with a cancellation, which drops the run if it is cancelled
+  // before the run starts
+  auto submit(
+      std::shared_ptr<TaskCancellation> cancellation,
+      Args&&... args)
+      -> std::future<decltype(F()(std::forward<Args>(args)...))>;
 
  private:
   F f;
   std::shared_ptr<TaskExecutor> task_executor;
+  TaskPriority priority;
 };
 
 template <class F, class... Args>
-Task<F, Args...>::Task(F&& f, std::shared_ptr<TaskExecutor> task_executor) {
+Task<F, Args...>::Task(
+    F&& f,
+    std::shared_ptr<TaskExecutor> task_executor,
+    TaskPriority priority) {
   this->f = f;
   this->task_executor = task_executor;
+  this->priority = priority;
 }
 
 template <class F, class... Args>
@@ -47,6 +61,14 @@ Task<F, Args...>::~Task() {}
 template <class F, class... Args>
 auto Task<F, Args...>::operator()(Args&&... args)
     -> std::future<decltype(F()(std::forward<Args>(args)...))> {
+  return this->submit(nullptr, std::forward<Args>(args)...);
+}
+
+template <class F, class... Args>
+auto Task<F, Args...>::submit(
+    std::shared_ptr<TaskCancellation> cancellation,
+    Args&&... args)
+    -> std::future<decltype(F()(std::forward<Args>(args)...))> {
   typedef decltype(F()(std::forward<Args>(args)...)) return_type;
   auto task = std::make_shared<std::packaged_task<return_type()>>(
       [&, this]() -> return_type {
@@ -54,21 +76,16 @@ auto Task<F, Args...>::operator()(Args&&... args)
       });
   std::future<return_type> res = task->get_future();
   auto grad_mode = at::GradMode::is_enabled();
-  {
-    std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-    // submit task to a stopping the pool is not allowed
-    if (this->task_executor->is_stop())
-      throw std::runtime_error("Task submit on stopped ThreadPool");
-    this->task_executor->get_tasks().emplace([task, grad_mode]() {
-      // set the thread local status, such as the grad mode before execuating
-      // the status
-      at::GradMode::set_enabled(grad_mode);
-      // execuate the task
-      (*task)();
-    });
-  }
-
-  this->task_executor->get_condition().notify_one();
+  this->task_executor->submit(
+      [task, grad_mode]() {
+        // set the thread local status, such as the grad mode before
+        // execuating the status
+        at::GradMode::set_enabled(grad_mode);
+        // execuate the task
+        (*task)();
+      },
+      this->priority,
+      std::move(cancellation));
   return res;
 }
 
@@ -3,7 +3,111 @@
 namespace torch_ipex {
 namespace runtime {
 
-TaskExecutor::TaskExecutor(const torch_ipex::runtime::CPUPool& cpu_pool) {
+namespace {
+// The executor and the worker of the current thread, so that the tasks
+// submitted by a running task go to the deque of its worker
+thread_local TaskExecutor* current_executor = nullptr;
+thread_local int32_t current_worker_id = -1;
+
+constexpr int64_t kInitialDequeCapacity = 64;
+} // namespace
+
+void TaskCancellation::cancel() {
+  this->cancelled_.store(true, std::memory_order_release);
+}
+
+bool TaskCancellation::is_cancelled() const {
+  return this->cancelled_.load(std::memory_order_acquire);
+}
+
+namespace detail {
+
+WorkStealingDeque::WorkStealingDeque() {
+  this->buffers_.emplace_back(new Buffer(kInitialDequeCapacity));
+  this->buffer_.store(this->buffers_.back().get());
+}
+
+WorkStealingDeque::~WorkStealingDeque() {
+  auto buffer = this->buffer_.load();
+  for (auto i = this->top_.load(); i < this->bottom_.load(); i++) {
+    delete buffer->get(i);
+  }
+}
+
+void WorkStealingDeque::push(WorkItem* item) {
+  auto bottom = this->bottom_.load(std::memory_order_relaxed);
+  auto top = this->top_.load(std::memory_order_acquire);
+  auto buffer = this->buffer_.load(std::memory_order_relaxed);
+  if (bottom - top > buffer->capacity - 1) {
+    buffer = this->grow(buffer, bottom, top);
+  }
+  buffer->put(bottom, item);
+  // Publish the item to the thieves
+  this->bottom_.store(bottom + 1, std::memory_order_release);
+}
+
+WorkItem* WorkStealingDeque::take() {
+  auto bottom = this->bottom_.load(std::memory_order_relaxed) - 1;
+  auto buffer = this->buffer_.load(std::memory_order_relaxed);
+  this->bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto top = this->top_.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    // Empty
+    this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto item = buffer->get(bottom);
+  if (top == bottom) {
+    // The last item, race with the thieves for it
+    if (!this->top_.compare_exchange_strong(
+            top,
+            top + 1,
+            std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+      item = nullptr;
+    }
+    this->bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return item;
+}
+
+WorkItem* WorkStealingDeque::steal() {
+  auto top = this->top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto bottom = this->bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return nullptr;
+  }
+  auto buffer = this->buffer_.load(std::memory_order_acquire);
+  auto item = buffer->get(top);
+  if (!this->top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    // Taken by the owner or another thief
+    return nullptr;
+  }
+  return item;
+}
+
+WorkStealingDeque::Buffer* WorkStealingDeque::grow(
+    Buffer* buffer,
+    int64_t bottom,
+    int64_t top) {
+  auto bigger = std::make_unique<Buffer>(buffer->capacity * 2);
+  for (auto i = top; i < bottom; i++) {
+    bigger->put(i, buffer->get(i));
+  }
+  auto raw = bigger.get();
+  this->buffers_.push_back(std::move(bigger));
+  this->buffer_.store(raw, std::memory_order_release);
+  return raw;
+}
+
+} // namespace detail
+
+TaskExecutor::TaskExecutor(
+    const torch_ipex::runtime::CPUPool& cpu_pool,
+    int32_t num_workers) {
   // Notice: We shouldn't load iomp symbol in sub_thread, otherwise race
   // condition happens.
   if (!is_runtime_ext_enabled()) {
@@ -11,56 +115,165 @@ TaskExecutor::TaskExecutor(const torch_ipex::runtime::CPUPool& cpu_pool) {
         "Fail to init TaskExecutor. Didn't preload IOMP "
         "before using the runtime API.");
   }
+  if (!cpu_pool.is_cpu_core_list_initialized()) {
+    throw std::runtime_error(
+        "Fail to init TaskExecutor. The CPUPool should be expressed as "
+        "cpu_core_list format.");
+  }
+  const std::vector<int32_t>& cpu_core_list = cpu_pool.get_cpu_core_list();
+  int32_t num_cores = cpu_core_list.size();
+  if (num_workers < 1 || num_workers > num_cores) {
+    throw std::runtime_error(
+        "Fail to init TaskExecutor. The number of workers should be in [1, " +
+        std::to_string(num_cores) + "], but got " +
+        std::to_string(num_workers) + ".");
+  }
   this->stop = false;
 
-  this->worker = std::make_shared<std::thread>([&, this] {
-    _pin_cpu_cores(cpu_pool);
-    while (true) {
-      std::function<void()> task;
-      {
-        std::unique_lock<std::mutex> lock(this->worker_mutex);
-        this->worker_condition.wait(
-            lock, [this] { return this->stop || !this->tasks.empty(); });
+  // All the workers exist before any of them steals
+  for (int32_t i = 0; i < num_workers; i++) {
+    this->workers.emplace_back(new Worker());
+  }
+  for (int32_t i = 0; i < num_workers; i++) {
+    std::vector<int32_t> sub_core_list(
+        cpu_core_list.begin() + i * num_cores / num_workers,
+        cpu_core_list.begin() + (i + 1) * num_cores / num_workers);
+    this->workers[i]->thread = std::thread(
+        &TaskExecutor::run_worker, this, i, std::move(sub_core_list));
+  }
+}
+
+void TaskExecutor::run_worker(
+    int32_t worker_id,
+    std::vector<int32_t> cpu_core_list) {
+  _pin_cpu_cores(CPUPool(cpu_core_list));
+  current_executor = this;
+  current_worker_id = worker_id;
+  while (true) {
+    auto item = this->find_work(worker_id);
+    if (item != nullptr) {
+      this->run_item(item);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(this->worker_mutex);
+    this->worker_condition.wait(
+        lock, [this] { return this->stop || this->pending > 0; });
+    if (this->stop && this->pending == 0)
+      return;
+  }
+}
 
-        if (this->stop && this->tasks.empty())
-          return;
+detail::WorkItem* TaskExecutor::take_from_inbox(
+    Worker& worker,
+    int32_t priority,
+    bool owner) {
+  std::deque<detail::WorkItem*> items;
+  {
+    std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+    auto& inbox = worker.inboxes[priority];
+    if (inbox.empty()) {
+      return nullptr;
+    }
+    if (!owner) {
+      auto item = inbox.front();
+      inbox.pop_front();
+      return item;
+    }
+    items.swap(inbox);
+  }
+  // Move the rest of the inbox to the deque for the thieves, the newest
+  // first so that the owner takes them in the order of submission
+  auto item = items.front();
+  for (auto it = items.rbegin(); it != items.rend() - 1; ++it) {
+    worker.deques[priority].push(*it);
+  }
+  return item;
+}
 
-        task = std::move(this->tasks.front());
-        this->tasks.pop();
+detail::WorkItem* TaskExecutor::find_work(int32_t worker_id) {
+  int32_t num_workers = this->workers.size();
+  auto& self = *this->workers[worker_id];
+  for (int32_t priority = 0; priority < kNumTaskPriorities; priority++) {
+    if (auto item = self.deques[priority].take()) {
+      return item;
+    }
+    if (auto item = this->take_from_inbox(self, priority, true)) {
+      return item;
+    }
+    for (int32_t i = 1; i < num_workers; i++) {
+      auto& victim = *this->workers[(worker_id + i) % num_workers];
+      if (auto item = victim.deques[priority].steal()) {
+        return item;
+      }
+      if (auto item = this->take_from_inbox(victim, priority, false)) {
+        return item;
       }
-      task();
     }
-  });
+  }
+  return nullptr;
 }
 
-std::mutex& TaskExecutor::get_mutex() {
-  return this->worker_mutex;
+void TaskExecutor::run_item(detail::WorkItem* item) {
+  this->pending--;
+  std::unique_ptr<detail::WorkItem> owned_item(item);
+  // Dropping the function of a cancelled task breaks the promise of its
+  // future
+  if (item->cancellation != nullptr && item->cancellation->is_cancelled()) {
+    return;
+  }
+  item->fn();
 }
 
-std::condition_variable& TaskExecutor::get_condition() {
-  return this->worker_condition;
+void TaskExecutor::submit(
+    std::function<void()> task,
+    TaskPriority priority,
+    std::shared_ptr<TaskCancellation> cancellation) {
+  bool from_worker = current_executor == this;
+  // Count the task before checking stop, so that the workers don't exit
+  // before it is queued
+  this->pending++;
+  // submit task to a stopping the pool is not allowed, except by the running
+  // tasks, which are drained before the workers exit
+  if (this->stop && !from_worker) {
+    this->pending--;
+    throw std::runtime_error("Task submit on stopped TaskExecutor");
+  }
+  auto item = new detail::WorkItem{std::move(task), std::move(cancellation)};
+  auto p = static_cast<int32_t>(priority);
+  if (from_worker) {
+    this->workers[current_worker_id]->deques[p].push(item);
+  } else {
+    auto& worker =
+        *this->workers[this->next_worker++ % this->workers.size()];
+    std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+    worker.inboxes[p].push_back(item);
+  }
+  {
+    // Don't notify between the check and the wait of a worker
+    std::lock_guard<std::mutex> lock(this->worker_mutex);
+  }
+  this->worker_condition.notify_one();
 }
 
-bool TaskExecutor::is_stop() {
-  return this->stop;
+int32_t TaskExecutor::get_num_workers() const {
+  return this->workers.size();
 }
 
-std::queue<std::function<void()>>& TaskExecutor::get_tasks() {
-  return this->tasks;
+bool TaskExecutor::is_stop() {
+  return this->stop;
 }
 
 void TaskExecutor::stop_executor() {
-  bool should_wait_worker_join = false;
+  bool expected = false;
+  if (!this->stop.compare_exchange_strong(expected, true)) {
+    return;
+  }
   {
-    std::unique_lock<std::mutex> lock(this->worker_mutex);
-    if (this->stop == false) {
-      should_wait_worker_join = true;
-      this->stop = true;
-    }
+    std::lock_guard<std::mutex> lock(this->worker_mutex);
   }
-  if (should_wait_worker_join) {
-    this->worker_condition.notify_all();
-    this->worker->join();
+  this->worker_condition.notify_all();
+  for (auto& worker : this->workers) {
+    worker->thread.join();
   }
   return;
 }
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <omp.h>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <iostream>
@@ -22,22 +25,124 @@
 namespace torch_ipex {
 namespace runtime {
 
+// Tasks of a higher priority are run before the queued tasks of the lower
+// ones, by the worker which queues them and by the workers stealing them.
+enum class TaskPriority : int32_t {
+  kHigh = 0,
+  kNormal = 1,
+  kLow = 2,
+};
+constexpr int32_t kNumTaskPriorities = 3;
+
+// Cancellation of the queued tasks submitted with it. A cancelled task which
+// is not started yet is dropped, and the get() of its future throws
+// std::future_error of broken_promise. A running task is not interrupted, it
+// may poll is_cancelled() to stop early.
+class IPEX_API TaskCancellation {
+ public:
+  void cancel();
+  bool is_cancelled() const;
+
+ private:
+  std::atomic<bool> cancelled_{false};
+};
+
+namespace detail {
+
+struct WorkItem {
+  std::function<void()> fn;
+  std::shared_ptr<TaskCancellation> cancellation;
+};
+
+// Chase-Lev deque: the owner worker pushes and takes at the bottom without
+// locks, and the other workers steal from the top with a CAS.
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque();
+  ~WorkStealingDeque();
+
+  // Owner only
+  void push(WorkItem* item);
+  WorkItem* take();
+  // Any thread
+  WorkItem* steal();
+
+ private:
+  struct Buffer {
+    explicit Buffer(int64_t capacity)
+        : capacity(capacity), items(new std::atomic<WorkItem*>[capacity]) {}
+    WorkItem* get(int64_t i) const {
+      return items[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    void put(int64_t i, WorkItem* item) {
+      items[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+    int64_t capacity;
+    std::unique_ptr<std::atomic<WorkItem*>[]> items;
+  };
+
+  Buffer* grow(Buffer* buffer, int64_t bottom, int64_t top);
+
+  std::atomic<int64_t> top_{0};
+  std::atomic<int64_t> bottom_{0};
+  std::atomic<Buffer*> buffer_;
+  // Buffers replaced by grow(), kept until destruction since a thief may
+  // still read them
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+} // namespace detail
+
+// Executor of tasks on num_workers threads. The cores of cpu_pool are split
+// into num_workers contiguous sub-pools, and each worker is pinned to one of
+// them.
+//
+// Each worker has one lock-free deque per priority, which receives the tasks
+// submitted by the worker itself, and an inbox of the tasks submitted by
+// the other threads, which are assigned round-robin. An idle worker steals
+// from the deques and the inboxes of the others, so that bursts submitted to
+// one worker are shared by all of them.
 class IPEX_API TaskExecutor {
  public:
-  explicit TaskExecutor(const torch_ipex::runtime::CPUPool& cpu_pool);
-  std::mutex& get_mutex();
-  std::condition_variable& get_condition();
+  explicit TaskExecutor(
+      const torch_ipex::runtime::CPUPool& cpu_pool,
+      int32_t num_workers = 1);
+  // Queue task, to be dropped if cancellation is cancelled before it starts.
+  // Throw if the executor is stopped.
+  void submit(
+      std::function<void()> task,
+      TaskPriority priority = TaskPriority::kNormal,
+      std::shared_ptr<TaskCancellation> cancellation = nullptr);
+  int32_t get_num_workers() const;
   bool is_stop();
-  std::queue<std::function<void()>>& get_tasks();
+  // Run the queued tasks, then join the workers
   void stop_executor();
   ~TaskExecutor();
 
  private:
-  std::queue<std::function<void()>> tasks;
-  std::shared_ptr<std::thread> worker;
+  struct Worker {
+    std::array<detail::WorkStealingDeque, kNumTaskPriorities> deques;
+    std::mutex inbox_mutex;
+    std::array<std::deque<detail::WorkItem*>, kNumTaskPriorities> inboxes;
+    std::thread thread;
+  };
+
+  void run_worker(int32_t worker_id, std::vector<int32_t> cpu_core_list);
+  detail::WorkItem* find_work(int32_t worker_id);
+  // The owner moves the inbox to its deque, a thief takes the oldest task
+  detail::WorkItem* take_from_inbox(
+      Worker& worker,
+      int32_t priority,
+      bool owner);
+  void run_item(detail::WorkItem* item);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<uint32_t> next_worker{0};
+  // Tasks queued and not taken yet
+  std::atomic<int64_t> pending{0};
 
   // Synchronization
-  bool stop;
+  std::atomic<bool> stop;
   std::mutex worker_mutex;
   std::condition_variable worker_condition;
 
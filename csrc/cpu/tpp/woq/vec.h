@@ -28,6 +28,9 @@ struct VecOps {
   static VT set_nf4_lut() {
     TLA_ASSERT(false, "should not reach here");
   }
+  static VT set_mxfp4_lut() {
+    TLA_ASSERT(false, "should not reach here");
+  }
   static VT mul() {
     TLA_ASSERT(false, "should not reach here");
   }
@@ -99,6 +102,26 @@ struct VecOps<__m512> {
         -0.6961928009986877,
         -1.0f);
   }
+  // values of the E2M1 codes of MXFP4, the sign is the highest bit
+  static inline __m512 set_mxfp4_lut() {
+    return _mm512_set_ps(
+        -6.0f,
+        -4.0f,
+        -3.0f,
+        -2.0f,
+        -1.5f,
+        -1.0f,
+        -0.5f,
+        -0.0f,
+        6.0f,
+        4.0f,
+        3.0f,
+        2.0f,
+        1.5f,
+        1.0f,
+        0.5f,
+        0.0f);
+  }
 };
 
 template <>
@@ -201,6 +224,42 @@ struct VecOps<__m512h> {
         -0.6961928009986877,
         -1.0f);
   }
+  // values of the E2M1 codes of MXFP4, the sign is the highest bit
+  static inline __m512h set_mxfp4_lut() {
+    return _mm512_set_ph(
+        -6.0f,
+        -4.0f,
+        -3.0f,
+        -2.0f,
+        -1.5f,
+        -1.0f,
+        -0.5f,
+        -0.0f,
+        6.0f,
+        4.0f,
+        3.0f,
+        2.0f,
+        1.5f,
+        1.0f,
+        0.5f,
+        0.0f,
+        -6.0f,
+        -4.0f,
+        -3.0f,
+        -2.0f,
+        -1.5f,
+        -1.0f,
+        -0.5f,
+        -0.0f,
+        6.0f,
+        4.0f,
+        3.0f,
+        2.0f,
+        1.5f,
+        1.0f,
+        0.5f,
+        0.0f);
+  }
 };
 
 template <>
@@ -0,0 +1,334 @@
+#include "kernel_profiler.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace torch_ipex {
+namespace utils {
+
+namespace {
+
+bool env_enabled(const char* name) {
+  auto envar = std::getenv(name);
+  return envar != nullptr && std::string(envar) == "1";
+}
+
+// Calls kept for the trace, the later ones are only aggregated
+constexpr size_t kMaxTraceEvents = 1 << 20;
+
+struct KernelEvent {
+  const char* name;
+  std::string shapes;
+  std::string dtype;
+  double flops;
+  double bytes_read;
+  double bytes_written;
+  int64_t start_ns;
+  int64_t dur_ns;
+  int32_t tid;
+  int32_t num_threads;
+  double imbalance;
+  std::vector<std::pair<const char*, double>> region_imbalance;
+};
+
+struct KernelAggregate {
+  uint64_t calls = 0;
+  uint64_t total_ns = 0;
+  double flops = 0;
+  double bytes_read = 0;
+  double bytes_written = 0;
+  double imbalance_sum = 0;
+  uint64_t imbalance_calls = 0;
+  // Sum of the imbalance and calls of each region
+  std::map<std::string, std::pair<double, uint64_t>> regions;
+};
+
+// Max over the mean of the busy times of the threads, 0 if none is timed
+double imbalance_of(const std::vector<int64_t>& ns) {
+  int64_t max_ns = 0;
+  int64_t sum_ns = 0;
+  for (auto t : ns) {
+    max_ns = std::max(max_ns, t);
+    sum_ns += t;
+  }
+  return sum_ns > 0 ? static_cast<double>(max_ns) * ns.size() / sum_ns : 0;
+}
+
+struct KernelProfileRegistry {
+  std::mutex mutex;
+  std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+  std::vector<KernelEvent> events;
+  uint64_t dropped_events = 0;
+  std::map<std::pair<std::string, std::string>, KernelAggregate> aggregates;
+};
+
+// Leaked on purpose, so that it outlives the kernels called at exit
+KernelProfileRegistry& kernel_profile_registry() {
+  static KernelProfileRegistry* registry = new KernelProfileRegistry();
+  return *registry;
+}
+
+thread_local KernelProfileScope* current_scope = nullptr;
+
+// Small ids of the calling threads for the trace
+int32_t trace_thread_id() {
+  static std::atomic<int32_t> next_id{0};
+  thread_local int32_t id = next_id++;
+  return id;
+}
+
+double machine_balance() {
+  static double balance = [] {
+    auto envar = std::getenv("IPEX_KERNEL_PROFILE_BALANCE");
+    return envar != nullptr ? std::atof(envar) : 10.0;
+  }();
+  return balance;
+}
+
+// Report the kernels called by a run with IPEX_KERNEL_PROFILE=1 at exit
+struct KernelProfileAtExit {
+  ~KernelProfileAtExit() {
+    if (!env_enabled("IPEX_KERNEL_PROFILE")) {
+      return;
+    }
+    auto trace_path = std::getenv("IPEX_KERNEL_PROFILE_TRACE");
+    if (trace_path != nullptr) {
+      dump_kernel_profile_trace(trace_path);
+    }
+    std::cerr << kernel_profile_table();
+  }
+};
+KernelProfileAtExit kernel_profile_at_exit;
+
+} // namespace
+
+std::atomic<bool> kernel_profiling_enabled{
+    env_enabled("IPEX_KERNEL_PROFILE")};
+
+void set_kernel_profiling_enabled(bool enabled) {
+  kernel_profiling_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool is_kernel_profiling_enabled() {
+  return kernel_profiling_enabled.load(std::memory_order_relaxed);
+}
+
+void reset_kernel_profile() {
+  auto& registry = kernel_profile_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.epoch = std::chrono::steady_clock::now();
+  registry.events.clear();
+  registry.dropped_events = 0;
+  registry.aggregates.clear();
+}
+
+std::vector<KernelProfileStats> get_kernel_profile_stats() {
+  std::vector<KernelProfileStats> stats;
+  auto& registry = kernel_profile_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& it : registry.aggregates) {
+    const auto& agg = it.second;
+    std::vector<std::pair<std::string, double>> region_imbalance;
+    for (const auto& region : agg.regions) {
+      region_imbalance.emplace_back(
+          region.first, region.second.first / region.second.second);
+    }
+    stats.push_back(
+        {it.first.first,
+         it.first.second,
+         agg.calls,
+         agg.total_ns,
+         agg.flops,
+         agg.bytes_read,
+         agg.bytes_written,
+         agg.imbalance_calls > 0 ? agg.imbalance_sum / agg.imbalance_calls
+                                 : 0,
+         std::move(region_imbalance)});
+  }
+  return stats;
+}
+
+std::string kernel_profile_table() {
+  auto stats = get_kernel_profile_stats();
+  std::sort(
+      stats.begin(),
+      stats.end(),
+      [](const KernelProfileStats& a, const KernelProfileStats& b) {
+        return a.total_ns > b.total_ns;
+      });
+  std::stringstream ss;
+  ss << std::left << std::setw(40) << "kernel" << std::setw(12) << "dtype"
+     << std::right << std::setw(10) << "calls" << std::setw(14)
+     << "total (us)" << std::setw(12) << "avg (us)" << std::setw(12)
+     << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(10) << "FLOP/B"
+     << std::setw(11) << "imbalance" << std::setw(10) << "bound"
+     << "\n";
+  for (const auto& stat : stats) {
+    auto bytes = stat.bytes_read + stat.bytes_written;
+    auto intensity = bytes > 0 ? stat.flops / bytes : 0;
+    ss << std::left << std::setw(40) << stat.name << std::setw(12)
+       << stat.dtype << std::right << std::setw(10) << stat.calls
+       << std::fixed << std::setprecision(3) << std::setw(14)
+       << stat.total_ns / 1e3 << std::setw(12)
+       << stat.total_ns / 1e3 / stat.calls << std::setprecision(2)
+       << std::setw(12) << stat.flops / stat.total_ns << std::setw(10)
+       << bytes / stat.total_ns << std::setw(10) << intensity
+       << std::setw(11) << stat.imbalance << std::setw(10)
+       << (bytes > 0 ? (intensity < machine_balance() ? "memory" : "compute")
+                     : "-")
+       << "\n";
+    for (const auto& region : stat.region_imbalance) {
+      ss << std::left << std::setw(40) << ("  ." + region.first) << std::right
+         << std::setw(91) << region.second << "\n";
+    }
+  }
+  return ss.str();
+}
+
+void dump_kernel_profile_trace(const std::string& path) {
+  std::ofstream out(path);
+  TORCH_CHECK(out, "Fail to open the kernel profile trace ", path);
+  auto pid = getpid();
+  auto& registry = kernel_profile_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+  for (size_t i = 0; i < registry.events.size(); i++) {
+    const auto& event = registry.events[i];
+    auto dur_ns = std::max<int64_t>(event.dur_ns, 1);
+    out << "{\"name\": \"" << event.name
+        << "\", \"cat\": \"kernel\", \"ph\": \"X\", \"pid\": " << pid
+        << ", \"tid\": " << event.tid << ", \"ts\": " << event.start_ns / 1e3
+        << ", \"dur\": " << event.dur_ns / 1e3 << ", \"args\": {\"shapes\": \""
+        << event.shapes << "\", \"dtype\": \"" << event.dtype
+        << "\", \"flops\": " << event.flops
+        << ", \"bytes_read\": " << event.bytes_read
+        << ", \"bytes_written\": " << event.bytes_written
+        << ", \"GFLOP/s\": " << event.flops / dur_ns << ", \"GB/s\": "
+        << (event.bytes_read + event.bytes_written) / dur_ns
+        << ", \"threads\": " << event.num_threads
+        << ", \"imbalance\": " << event.imbalance << ", \"regions\": {";
+    for (size_t j = 0; j < event.region_imbalance.size(); j++) {
+      out << (j > 0 ? ", " : "") << "\"" << event.region_imbalance[j].first
+          << "\": " << event.region_imbalance[j].second;
+    }
+    out << "}}}"
+        << (i + 1 < registry.events.size() ? ",\n" : "\n");
+  }
+  out << "], \"otherData\": {\"dropped_events\": " << registry.dropped_events
+      << "}}\n";
+}
+
+KernelProfileScope* KernelProfileScope::current() {
+  return current_scope;
+}
+
+void KernelProfileScope::start(const char* name) {
+  name_ = name;
+  thread_times_.resize(at::get_num_threads());
+  outer_ = current_scope;
+  current_scope = this;
+  start_ = std::chrono::steady_clock::now();
+}
+
+void KernelProfileScope::add_input(const at::Tensor& input) {
+  if (!shapes_.empty()) {
+    shapes_ += ", ";
+  }
+  if (!input.defined()) {
+    shapes_ += "None";
+    return;
+  }
+  shapes_ += "[";
+  for (int64_t i = 0; i < input.dim(); i++) {
+    shapes_ += (i > 0 ? ", " : "") + std::to_string(input.size(i));
+  }
+  shapes_ += "]";
+  if (dtype_.empty()) {
+    dtype_ = c10::toString(input.scalar_type());
+  }
+}
+
+void KernelProfileScope::add_thread_time(int64_t ns) {
+  size_t tid = at::get_thread_num();
+  if (tid < thread_times_.size()) {
+    thread_times_[tid].ns += ns;
+  }
+}
+
+void KernelProfileScope::begin_region(const char* name) {
+  region_name_ = name;
+  region_start_ns_.resize(thread_times_.size());
+  for (size_t i = 0; i < thread_times_.size(); i++) {
+    region_start_ns_[i] = thread_times_[i].ns;
+  }
+}
+
+void KernelProfileScope::end_region() {
+  for (size_t i = 0; i < thread_times_.size(); i++) {
+    region_start_ns_[i] = thread_times_[i].ns - region_start_ns_[i];
+  }
+  region_imbalance_.emplace_back(region_name_, imbalance_of(region_start_ns_));
+}
+
+void KernelProfileScope::finish() {
+  auto end = std::chrono::steady_clock::now();
+  current_scope = outer_;
+  std::vector<int64_t> thread_ns;
+  for (const auto& thread_time : thread_times_) {
+    thread_ns.push_back(thread_time.ns);
+  }
+  double imbalance = imbalance_of(thread_ns);
+  auto dur_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_)
+          .count();
+  auto tid = trace_thread_id();
+
+  auto& registry = kernel_profile_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto& agg = registry.aggregates[{name_, dtype_}];
+  agg.calls++;
+  agg.total_ns += dur_ns;
+  agg.flops += flops_;
+  agg.bytes_read += bytes_read_;
+  agg.bytes_written += bytes_written_;
+  if (imbalance > 0) {
+    agg.imbalance_sum += imbalance;
+    agg.imbalance_calls++;
+  }
+  for (const auto& region : region_imbalance_) {
+    auto& region_agg = agg.regions[region.first];
+    region_agg.first += region.second;
+    region_agg.second++;
+  }
+  if (registry.events.size() >= kMaxTraceEvents) {
+    registry.dropped_events++;
+    return;
+  }
+  registry.events.push_back(
+      {name_,
+       std::move(shapes_),
+       dtype_,
+       flops_,
+       bytes_read_,
+       bytes_written_,
+       std::chrono::duration_cast<std::chrono::nanoseconds>(
+           start_ - registry.epoch)
+           .count(),
+       dur_ns,
+       tid,
+       static_cast<int32_t>(thread_times_.size()),
+       imbalance,
+       std::move(region_imbalance_)});
+}
+
+} // namespace utils
+} // namespace torch_ipex
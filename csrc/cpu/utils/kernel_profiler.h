@@ -0,0 +1,179 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <Macros.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace torch_ipex {
+namespace utils {
+
+// Kernel profiling. The instrumented kernels record the shapes and the dtype
+// of their inputs, the bytes read and written, the FLOPs, the wall time, and
+// the busy time of each thread of their parallel loops, from which the load
+// imbalance is derived. Off by default, it is enabled by IPEX_KERNEL_PROFILE=1
+// or set_kernel_profiling_enabled(). When off, a kernel only pays a relaxed
+// atomic load per call and a null check per task of its parallel loops.
+//
+// With IPEX_KERNEL_PROFILE=1, the table of the kernels is printed to stderr at
+// exit, and the Chrome trace is written to IPEX_KERNEL_PROFILE_TRACE if it is
+// set. The table classifies a kernel as memory or compute bound by comparing
+// its FLOPs per byte with the machine balance, IPEX_KERNEL_PROFILE_BALANCE
+// FLOPs per byte, 10 by default.
+struct KernelProfileStats {
+  std::string name;
+  std::string dtype;
+  uint64_t calls;
+  uint64_t total_ns;
+  double flops;
+  double bytes_read;
+  double bytes_written;
+  // Mean of the max over the mean busy time of the threads of the calls, 0
+  // if the kernel has no per thread timing
+  double imbalance;
+  // Mean imbalance of each parallel region profiled by KernelProfileRegion
+  std::vector<std::pair<std::string, double>> region_imbalance;
+};
+
+extern IPEX_API std::atomic<bool> kernel_profiling_enabled;
+IPEX_API void set_kernel_profiling_enabled(bool enabled);
+IPEX_API bool is_kernel_profiling_enabled();
+IPEX_API void reset_kernel_profile();
+// Stats of the kernels called since the last reset, by name and dtype
+IPEX_API std::vector<KernelProfileStats> get_kernel_profile_stats();
+// Table of the stats, the slowest first
+IPEX_API std::string kernel_profile_table();
+// Chrome trace JSON of the calls, which Perfetto also reads
+IPEX_API void dump_kernel_profile_trace(const std::string& path);
+
+/*KernelProfileScope profiles a call of a kernel*/
+// Construct it on the calling thread at the beginning of the kernel, with the
+// inputs of which the shapes are recorded:
+//
+//   utils::KernelProfileScope profile("rmsnorm", input, weight);
+//   profile.add_cost(flops, bytes_read, bytes_written);
+//
+// and time the tasks of the parallel loops with KernelThreadTimer, by the
+// scope of the calling thread:
+//
+//   auto profile_scope = utils::KernelProfileScope::current();
+//   at::parallel_for(0, M, 1, [&](int64_t begin, int64_t end) {
+//     utils::KernelThreadTimer thread_timer(profile_scope);
+//     ...
+//   });
+class IPEX_API KernelProfileScope {
+ public:
+  template <typename... Tensors>
+  explicit KernelProfileScope(const char* name, const Tensors&... inputs)
+      : active_(kernel_profiling_enabled.load(std::memory_order_relaxed)) {
+    if (C10_UNLIKELY(active_)) {
+      start(name);
+      (add_input(inputs), ...);
+    }
+  }
+  ~KernelProfileScope() {
+    if (C10_UNLIKELY(active_)) {
+      finish();
+    }
+  }
+  KernelProfileScope(const KernelProfileScope&) = delete;
+  KernelProfileScope& operator=(const KernelProfileScope&) = delete;
+
+  // Whether the call is profiled, to skip computing a costly cost otherwise
+  bool active() const {
+    return active_;
+  }
+  void add_cost(double flops, double bytes_read, double bytes_written) {
+    flops_ += flops;
+    bytes_read_ += bytes_read;
+    bytes_written_ += bytes_written;
+  }
+  // Active scope of the calling thread, nullptr if profiling is off
+  static KernelProfileScope* current();
+  void add_thread_time(int64_t ns);
+  void begin_region(const char* name);
+  void end_region();
+
+ private:
+  void start(const char* name);
+  void add_input(const at::Tensor& input);
+  void finish();
+
+  struct alignas(64) ThreadTime {
+    int64_t ns = 0;
+  };
+
+  bool active_;
+  const char* name_ = nullptr;
+  std::string shapes_;
+  std::string dtype_;
+  double flops_ = 0;
+  double bytes_read_ = 0;
+  double bytes_written_ = 0;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<ThreadTime> thread_times_;
+  const char* region_name_ = nullptr;
+  std::vector<int64_t> region_start_ns_;
+  std::vector<std::pair<const char*, double>> region_imbalance_;
+  KernelProfileScope* outer_ = nullptr;
+};
+
+/*KernelProfileRegion profiles a parallel region of a kernel*/
+// The busy time of the threads timed by KernelThreadTimer while it is alive
+// gives the imbalance of the region, reported along with the one of the
+// whole kernel, which sums the busy time of all its regions:
+//
+//   {
+//     utils::KernelProfileRegion region("qk");
+//     at::parallel_for(...);
+//   }
+class KernelProfileRegion {
+ public:
+  explicit KernelProfileRegion(const char* name)
+      : scope_(KernelProfileScope::current()) {
+    if (C10_UNLIKELY(scope_ != nullptr)) {
+      scope_->begin_region(name);
+    }
+  }
+  ~KernelProfileRegion() {
+    if (C10_UNLIKELY(scope_ != nullptr)) {
+      scope_->end_region();
+    }
+  }
+  KernelProfileRegion(const KernelProfileRegion&) = delete;
+  KernelProfileRegion& operator=(const KernelProfileRegion&) = delete;
+
+ private:
+  KernelProfileScope* scope_;
+};
+
+// Busy time of the thread of a task of a parallel loop
+class KernelThreadTimer {
+ public:
+  explicit KernelThreadTimer(KernelProfileScope* scope) : scope_(scope) {
+    if (C10_UNLIKELY(scope_ != nullptr)) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~KernelThreadTimer() {
+    if (C10_UNLIKELY(scope_ != nullptr)) {
+      scope_->add_thread_time(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start_)
+              .count());
+    }
+  }
+  KernelThreadTimer(const KernelThreadTimer&) = delete;
+  KernelThreadTimer& operator=(const KernelThreadTimer&) = delete;
+
+ private:
+  KernelProfileScope* scope_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace utils
+} // namespace torch_ipex
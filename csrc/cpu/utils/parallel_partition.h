@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace torch_ipex {
+namespace utils {
+
+/*balanced_partition splits work items of uneven cost among threads*/
+// Splits the items [0, n), of which cost(i) is the cost, into num_parts
+// contiguous ranges of about the same total cost, and returns the
+// num_parts + 1 bounds of the ranges: part p has the items
+// [bounds[p], bounds[p + 1]). Unlike the uniform split of the iterations
+// of a static OpenMP schedule, the threads of a loop whose items have
+// different costs, e.g. the heads of sequences of different context
+// lengths, finish at about the same time.
+//
+//   auto bounds = utils::balanced_partition(n, num_threads, cost);
+// #pragma omp parallel
+//   for (auto p = omp_get_thread_num(); p < num_threads;
+//        p += omp_get_num_threads()) {
+//     for (auto i = bounds[p]; i < bounds[p + 1]; i++) {
+//       ...
+//     }
+//   }
+//
+// Iterating the parts by the thread number and the number of threads, as
+// above, keeps the loop correct when the region has fewer threads than
+// num_parts.
+template <typename F>
+std::vector<int64_t> balanced_partition(
+    int64_t n,
+    int64_t num_parts,
+    const F& cost) {
+  num_parts = std::max<int64_t>(num_parts, 1);
+  std::vector<int64_t> prefix(n + 1, 0);
+  for (int64_t i = 0; i < n; i++) {
+    prefix[i + 1] = prefix[i] + static_cast<int64_t>(cost(i));
+  }
+  auto total = prefix[n];
+  std::vector<int64_t> bounds(num_parts + 1, n);
+  bounds[0] = 0;
+  for (int64_t p = 1; p < num_parts; p++) {
+    // First item of which the work ends after the share of the parts before
+    auto share = total / num_parts * p + total % num_parts * p / num_parts;
+    bounds[p] = std::max(
+        bounds[p - 1],
+        std::upper_bound(prefix.begin() + 1, prefix.end(), share) -
+            prefix.begin() - 1);
+  }
+  return bounds;
+}
+
+/*for_each_balanced_range splits the units of items of uneven size*/
+// Of the items [0, n), of which prefix is the prefix sum of the sizes (n + 1
+// elements), part p of num_parts gets an equal share of the units of the
+// concatenation of the items, and f(i, begin, end) is called for the units
+// [begin, end) of each item i in the share. Unlike balanced_partition, a
+// share may start or end in the middle of an item, e.g. within the tokens of
+// the context of a head, so that the parts are even when there are fewer
+// items than parts, and the work is linear in the items, not in their units.
+template <typename F>
+void for_each_balanced_range(
+    const std::vector<int64_t>& prefix,
+    int64_t part,
+    int64_t num_parts,
+    const F& f) {
+  int64_t n = prefix.size() - 1;
+  auto total = prefix[n];
+  auto share = [&](int64_t p) {
+    return total / num_parts * p + total % num_parts * p / num_parts;
+  };
+  auto begin = share(part);
+  auto end = share(part + 1);
+  if (begin >= end) {
+    return;
+  }
+  // Last item which starts at or before begin, which is not empty
+  int64_t i = std::upper_bound(prefix.begin(), prefix.end(), begin) -
+      prefix.begin() - 1;
+  for (; i < n && prefix[i] < end; i++) {
+    auto item_begin = std::max(begin, prefix[i]) - prefix[i];
+    auto item_end = std::min(end, prefix[i + 1]) - prefix[i];
+    if (item_begin < item_end) {
+      f(i, item_begin, item_end);
+    }
+  }
+}
+
+} // namespace utils
+} // namespace torch_ipex
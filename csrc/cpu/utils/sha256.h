@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace torch_ipex {
+namespace utils {
+
+/*Sha256 is the SHA-256 hash of FIPS 180-4*/
+// Used where a hash must be collision resistant, e.g. the keys of cached
+// blocks shared between requests, which a caller controlling the input must
+// not be able to collide.
+//
+//   Sha256 sha;
+//   sha.update(data, size);
+//   auto digest = sha.digest();
+class Sha256 {
+ public:
+  static constexpr size_t kDigestSize = 32;
+  using Digest = std::array<uint8_t, kDigestSize>;
+
+  void update(const void* data, size_t size) {
+    auto bytes = static_cast<const uint8_t*>(data);
+    length_ += size;
+    if (buffered_ > 0) {
+      auto n = std::min(size, kBlockSize - buffered_);
+      std::memcpy(buffer_ + buffered_, bytes, n);
+      buffered_ += n;
+      bytes += n;
+      size -= n;
+      if (buffered_ < kBlockSize) {
+        return;
+      }
+      compress(buffer_);
+      buffered_ = 0;
+    }
+    for (; size >= kBlockSize; size -= kBlockSize, bytes += kBlockSize) {
+      compress(bytes);
+    }
+    std::memcpy(buffer_, bytes, size);
+    buffered_ = size;
+  }
+
+  // Digest of the bytes so far, after which the object should not be updated
+  Digest digest() {
+    uint64_t bit_length = length_ * 8;
+    uint8_t padding[kBlockSize * 2] = {0x80};
+    auto pad_size = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; i++) {
+      padding[pad_size + i] = static_cast<uint8_t>(bit_length >> (56 - 8 * i));
+    }
+    update(padding, pad_size + 8);
+    Digest digest;
+    for (size_t i = 0; i < 8; i++) {
+      for (size_t j = 0; j < 4; j++) {
+        digest[i * 4 + j] = static_cast<uint8_t>(state_[i] >> (24 - 8 * j));
+      }
+    }
+    return digest;
+  }
+
+ private:
+  static constexpr size_t kBlockSize = 64;
+
+  static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+  }
+
+  void compress(const uint8_t* block) {
+    static constexpr uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+        0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+        0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+        0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+      w[i] = (uint32_t(block[i * 4]) << 24) |
+          (uint32_t(block[i * 4 + 1]) << 16) |
+          (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+      auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    auto a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    auto e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; i++) {
+      auto s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+      auto ch = (e & f) ^ (~e & g);
+      auto t1 = h + s1 + ch + k[i] + w[i];
+      auto s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+      auto maj = (a & b) ^ (a & c) ^ (b & c);
+      auto t2 = s0 + maj;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+  }
+
+  uint32_t state_[8] = {
+      0x6a09e667,
+      0xbb67ae85,
+      0x3c6ef372,
+      0xa54ff53a,
+      0x510e527f,
+      0x9b05688c,
+      0x1f83d9ab,
+      0x5be0cd19};
+  uint64_t length_ = 0;
+  uint8_t buffer_[kBlockSize];
+  size_t buffered_ = 0;
+};
+
+} // namespace utils
+} // namespace torch_ipex
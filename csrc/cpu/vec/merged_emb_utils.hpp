@@ -45,7 +45,7 @@ void prepare_ccl_buffer(
   for (int64_t i = 0; i < inn_size; ++i) {
     for (int64_t o = 0; o < world_size; ++o) {
       size_t j = ofs_ptr[o][i];
-      auto emb_cache = cache[o * inn_size + i].cache();
+      const auto& emb_cache = cache[o * inn_size + i].cache();
       for (auto& [key, value] : emb_cache) {
         idx_ptr[o][j] = key;
         scalar_t* bufPtr = &val_ptr[o][j * emb_dim];
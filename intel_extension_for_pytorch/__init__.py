@@ -146,6 +146,7 @@ from .frontend import enable_auto_channels_last, disable_auto_channels_last
 from .frontend import set_fp32_math_mode, get_fp32_math_mode, FP32MathMode
 from .cpu._auto_kernel_selection import _enable_dnnl, _disable_dnnl, _using_dnnl
 from .cpu.utils.verbose import verbose
+from .cpu.utils.kernel_profile import kernel_profile
 from .cpu.tpp.fused_bert import fast_bert
 from ._inductor.compiler import _set_compiler_backend, _get_compiler_backend, compile
 from .cpu.onednn_fusion import enable_onednn_fusion
@@ -1,3 +1,4 @@
 from . import runtime
 from . import autocast
 from . import auto_ipex
+from . import comm
@@ -0,0 +1,62 @@
+import os
+
+import torch
+
+DEFAULT_SHM_BUFFER_SIZE = 1 << 20
+
+
+def init_shm_comm(rank, world_size, name=None, buffer_size=DEFAULT_SHM_BUFFER_SIZE):
+    r"""
+    Set up the shared memory collectives among the ranks of one host, used by
+    tensor-parallel inference for the all-reduce of small activations instead
+    of ``deepspeed_comm::all_reduce``. Once called, the all-reduce of
+    tensor-parallel linear layers and of TorchScript graphs frozen afterwards
+    goes through shared memory. Messages larger than ``buffer_size`` bytes still
+    go through ``deepspeed_comm::all_reduce``.
+
+    All the ranks should call it with the same ``name``, ``world_size`` and
+    ``buffer_size``. Each rank should be bound to the cores of one NUMA node.
+
+    A collective raises an error when a peer does not join it within
+    ``IPEX_SHM_COMM_TIMEOUT`` seconds, 300 by default, for example because
+    the peer exited. The communicator of all ranks is then aborted and should
+    be set up again.
+
+    Args:
+        rank (int): Rank of the process, in [0, world_size).
+        world_size (int): Number of processes.
+        name (str): Name of the shared memory segment, unique for the job.
+            Defaults to one derived from the ``MASTER_ADDR`` and ``MASTER_PORT``
+            environment variables.
+        buffer_size (int): Largest message in bytes handled through shared
+            memory, a multiple of 4096.
+    """
+    if name is None:
+        name = "/ipex_shm_comm_{}_{}_{}".format(
+            os.getuid(),
+            os.environ.get("MASTER_ADDR", "localhost"),
+            os.environ.get("MASTER_PORT", "29500"),
+        )
+    torch.ops.torch_ipex.shm_comm_init(name, rank, world_size, buffer_size)
+
+
+def is_shm_comm_initialized():
+    return torch.ops.torch_ipex.shm_comm_is_initialized()
+
+
+def destroy_shm_comm():
+    torch.ops.torch_ipex.shm_comm_destroy()
+
+
+def all_reduce(tensor):
+    r"""
+    Sum ``tensor`` across the ranks in place and return it.
+    """
+    return torch.ops.torch_ipex.shm_all_reduce(tensor)
+
+
+def all_gather(tensor, dim=0):
+    r"""
+    Concatenate ``tensor`` of all the ranks along ``dim``.
+    """
+    return torch.ops.torch_ipex.shm_all_gather(tensor, dim)
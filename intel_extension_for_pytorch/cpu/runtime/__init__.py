@@ -1,4 +1,4 @@
-from .task import Task
+from .task import Task, BatchingTask
 from .cpupool import pin, CPUPool, is_runtime_ext_enabled
 from .multi_stream import (
     MultiStreamModule,
@@ -47,6 +47,19 @@ class CPUPool(object):
         # Since ipex._C.CPUPool will filter out core ids which not available for current process.
         self.core_ids = self.cpu_pool.get_core_list()
 
+    def arena(self):
+        r"""
+        The arena of the CPU buffers placed on the NUMA node of most of the
+        cores of this pool, which serves the CPU allocations inside
+        ``pin(cpu_pool, use_numa_arena=True)``. All the pools of a node share
+        its arena.
+
+        Returns:
+            The arena, with ``node()``, ``stats()``, ``empty_cache()`` and
+            ``set_max_cached_bytes(max_cached_bytes)``.
+        """
+        return ipex._C.CPUPoolArena.get(self.cpu_pool)
+
 
 class pin(object):
     r"""
@@ -57,6 +70,12 @@ class pin(object):
         cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool):
             intel_extension_for_pytorch.cpu.runtime.CPUPool object, contains
             all CPU cores used by the designated operations.
+        use_numa_arena (bool): Serve the CPU allocations of the master thread
+            inside the scope from the arena of the NUMA node of ``cpu_pool``,
+            which places the buffers on the node and recycles them across
+            iterations. Default: ``False``. The maximum bytes cached by each
+            arena is 2 GiB by default, which can be changed by the
+            environment variable ``IPEX_CPU_POOL_ARENA_MAX_CACHED_BYTES``.
 
     Returns:
         intel_extension_for_pytorch.cpu.runtime.pin: Generated
@@ -64,16 +83,23 @@ class pin(object):
         as a `with` context or a function decorator.
     """
 
-    def __init__(self, cpu_pool: CPUPool):
+    def __init__(self, cpu_pool: CPUPool, use_numa_arena: bool = False):
         self.cpu_pool = cpu_pool
+        self.use_numa_arena = use_numa_arena
         ipex._C.init_runtime_ext()
 
     def __enter__(self):
         assert type(self.cpu_pool) is CPUPool
         self.previous_cpu_pool = ipex._C.get_current_cpu_pool()
         ipex._C.pin_cpu_cores(self.cpu_pool.cpu_pool)
+        if self.use_numa_arena:
+            self.previous_arena = ipex._C.set_current_cpu_pool_arena(
+                self.cpu_pool.arena()
+            )
 
     def __exit__(self, *args):
+        if self.use_numa_arena:
+            ipex._C.set_current_cpu_pool_arena(self.previous_arena)
         ipex._C.set_cpu_pool(self.previous_cpu_pool)
 
     # Support decorator
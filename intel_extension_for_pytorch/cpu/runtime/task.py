@@ -34,3 +34,82 @@ class Task(object):
     def run_sync(self, *args, **kwargs):
         # sync execution
         return self._task.run_sync(*args, **kwargs)
+
+
+class BatchingTask(object):
+    r"""
+    An abstraction of computation based on PyTorch module, which batches the
+    concurrent calls and runs the module once per batch asynchronously.
+
+    The positional tensor inputs of each call are batched along dim 0,
+    usually with one sample. The inputs of the concurrent calls are
+    concatenated along dim 0, the module runs once for the batch, and its
+    outputs are split along dim 0 back to the calls. A batch is run once it
+    has ``max_batch_size`` samples, or once its first call has waited for
+    ``max_delay_ms``.
+
+    Inputs of variable length, such as token sequences, are padded along
+    ``pad_dim`` to the longest call of a batch with ``pad_value``, and the
+    outputs are narrowed back along ``output_pad_dim`` to the length of the
+    first input of each call.
+
+    Args:
+        model (torch.jit.ScriptModule or torch.nn.Module): The input module,
+            which takes tensors and returns a tensor or a tuple of tensors.
+        cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): An
+            intel_extension_for_pytorch.cpu.runtime.CPUPool object, contains
+            all CPU cores used to run the batches.
+        max_batch_size (int): The maximum samples of a batch. A call with
+            more samples is run as a batch alone. Default: 8.
+        max_delay_ms (float): The time a call waits for the others to fill
+            its batch. Default: 1.
+        pad_dim (int): The dim of the variable length of the inputs, or None
+            if the inputs have the same shapes except dim 0. Default: None.
+        pad_value (float): The value to pad the inputs. Default: 0.
+        output_pad_dim (int): The dim of the outputs to narrow to the length
+            of each call, or None to return the padded outputs.
+            Default: None.
+        num_workers (int): The number of batches run in parallel, each on a
+            sub-pool of ``cpu_pool``. Default: 1.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.BatchingTask: Generated
+        intel_extension_for_pytorch.cpu.runtime.BatchingTask object. A call
+        returns a future, whose ``get()`` returns the output of the call, as
+        a tensor for a single output, otherwise as a tuple.
+    """
+
+    def __init__(
+        self,
+        module,
+        cpu_pool: CPUPool,
+        max_batch_size: int = 8,
+        max_delay_ms: float = 1.0,
+        pad_dim: int = None,
+        pad_value: float = 0.0,
+        output_pad_dim: int = None,
+        num_workers: int = 1,
+    ):
+        self.cpu_pool = cpu_pool
+        assert type(self.cpu_pool) is CPUPool
+        assert pad_dim != 0 and output_pad_dim != 0, "dim 0 is the batch dim"
+        if isinstance(module, torch.jit.ScriptModule):
+            module = module._c
+        self._task = ipex._C.BatchingTaskModule(
+            module,
+            self.cpu_pool.cpu_pool,
+            max_batch_size,
+            int(max_delay_ms * 1000),
+            -1 if pad_dim is None else pad_dim,
+            pad_value,
+            -1 if output_pad_dim is None else output_pad_dim,
+            num_workers,
+        )
+
+    def __call__(self, *args):
+        # async execution
+        return self._task.run_async(*args)
+
+    def run_sync(self, *args):
+        # sync execution
+        return self._task.run_sync(*args)
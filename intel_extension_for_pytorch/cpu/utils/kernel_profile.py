@@ -0,0 +1,70 @@
+import intel_extension_for_pytorch._C as core
+
+
+class kernel_profile(object):
+    """
+    Profiling of the IPEX kernels
+
+    The instrumented kernels (attention, weight-only quantized linear,
+    RMSNorm, embedding bag) record the shapes and dtype of their inputs,
+    their FLOPs, the bytes they read and write, their duration and the load
+    imbalance of the threads of their parallel loops. From those, the table
+    reports the achieved GFLOP/s and GB/s of each kernel and whether it is
+    memory or compute bound, and the trace shows each call on a timeline in
+    chrome://tracing or Perfetto.
+
+    The profile can also be taken for a whole run with the environment
+    variable `IPEX_KERNEL_PROFILE=1`, which prints the table at exit, and
+    `IPEX_KERNEL_PROFILE_TRACE=<path>`, which writes the trace at exit.
+    Profiling is restored to its state before the scope on exit. When it is
+    already on, the scope keeps the kernels recorded so far, so that the
+    profile of the whole run is complete.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        import intel_extension_for_pytorch as ipex
+        with ipex.kernel_profile(trace_path="trace.json") as prof:
+            model(data)
+        print(prof.table())
+
+    Args:
+        trace_path (str): Path of the Chrome trace JSON written on exit.
+            Default is ``None``, no trace.
+
+    :meta public:
+    """
+
+    def __init__(self, trace_path=None):
+        self.trace_path = trace_path
+        self.prev_enabled = False
+
+    def __enter__(self):
+        self.prev_enabled = core._is_kernel_profiling_enabled()
+        if not self.prev_enabled:
+            core._reset_kernel_profile()
+            core._set_kernel_profiling_enabled(True)
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        core._set_kernel_profiling_enabled(self.prev_enabled)
+        if self.trace_path is not None:
+            core._dump_kernel_profile_trace(self.trace_path)
+        return False
+
+    def stats(self):
+        r"""
+        Stats of the kernels called in the scope, a dict per kernel and dtype
+        with the keys ``kernel``, ``dtype``, ``calls``, ``total_ns``,
+        ``flops``, ``bytes_read``, ``bytes_written``, ``imbalance`` and
+        ``regions``. ``imbalance`` is the max over the mean busy time of the
+        threads, 1 when the work is evenly split, and ``regions`` the
+        imbalance of each parallel region of the kernel.
+        """
+        return core._get_kernel_profile_stats()
+
+    def table(self):
+        r"""
+        Table of the kernels called in the scope, the slowest first.
+        """
+        return core._kernel_profile_table()
@@ -25,6 +25,7 @@
 #include "jit/cpu/tensorexpr/nnc_fuser_register.h"
 #include "utils/fpmath_mode.h"
 #include "utils/isa_utils.h"
+#include "utils/kernel_profiler.h"
 #include "utils/module_version.h"
 #include "utils/onednn_utils.h"
 
@@ -85,6 +86,88 @@ void InitIpexModuleBindings(py::module m) {
     return get_highest_binary_support_isa_level();
   });
 
+  m.def(
+      "_set_dispatch_isa_override",
+      [](const std::string& stub_name, const std::string& isa) {
+        using namespace torch_ipex::cpu;
+        set_dispatch_isa_override(stub_name, CPUCapabilityFromString(isa));
+      });
+
+  m.def(
+      "_clear_dispatch_isa_override",
+      [](const std::string& stub_name) {
+        torch_ipex::cpu::clear_dispatch_isa_override(stub_name);
+      },
+      py::arg("stub_name") = "");
+
+  m.def("_set_dispatch_telemetry_enabled", [](bool enabled) {
+    torch_ipex::cpu::set_dispatch_telemetry_enabled(enabled);
+  });
+
+  m.def("_get_dispatch_stats", []() {
+    using namespace torch_ipex::cpu;
+    py::list stats;
+    for (const auto& stat : get_dispatch_stats()) {
+      py::dict py_stat;
+      py_stat["stub"] = stat.stub_name;
+      py_stat["isa"] = CPUCapabilityToString(stat.isa);
+      py_stat["calls"] = stat.calls;
+      py_stat["total_ns"] = stat.total_ns;
+      stats.append(py_stat);
+    }
+    return stats;
+  });
+
+  m.def("_reset_dispatch_stats", []() {
+    torch_ipex::cpu::reset_dispatch_stats();
+  });
+
+  m.def("_dump_dispatch_stats", []() {
+    return torch_ipex::cpu::dump_dispatch_stats();
+  });
+
+  m.def("_set_kernel_profiling_enabled", [](bool enabled) {
+    torch_ipex::utils::set_kernel_profiling_enabled(enabled);
+  });
+
+  m.def("_is_kernel_profiling_enabled", []() {
+    return torch_ipex::utils::is_kernel_profiling_enabled();
+  });
+
+  m.def("_reset_kernel_profile", []() {
+    torch_ipex::utils::reset_kernel_profile();
+  });
+
+  m.def("_get_kernel_profile_stats", []() {
+    py::list stats;
+    for (const auto& stat : torch_ipex::utils::get_kernel_profile_stats()) {
+      py::dict py_stat;
+      py_stat["kernel"] = stat.name;
+      py_stat["dtype"] = stat.dtype;
+      py_stat["calls"] = stat.calls;
+      py_stat["total_ns"] = stat.total_ns;
+      py_stat["flops"] = stat.flops;
+      py_stat["bytes_read"] = stat.bytes_read;
+      py_stat["bytes_written"] = stat.bytes_written;
+      py_stat["imbalance"] = stat.imbalance;
+      py::dict regions;
+      for (const auto& region : stat.region_imbalance) {
+        regions[py::str(region.first)] = region.second;
+      }
+      py_stat["regions"] = regions;
+      stats.append(py_stat);
+    }
+    return stats;
+  });
+
+  m.def("_kernel_profile_table", []() {
+    return torch_ipex::utils::kernel_profile_table();
+  });
+
+  m.def("_dump_kernel_profile_trace", [](const std::string& path) {
+    torch_ipex::utils::dump_kernel_profile_trace(path);
+  });
+
   m.def("mkldnn_set_verbose", &torch_ipex::utils::onednn_set_verbose);
   m.def("onednn_has_bf16_support", []() {
     return torch_ipex::utils::onednn_has_bf16_type_support();
@@ -191,6 +274,36 @@ void InitIpexModuleBindings(py::module m) {
         return self.get_cpu_core_list();
       });
 
+  py::class_<torch_ipex::runtime::CPUPoolArenaStats>(m, "CPUPoolArenaStats")
+      .def_readonly(
+          "allocated_bytes",
+          &torch_ipex::runtime::CPUPoolArenaStats::allocated_bytes)
+      .def_readonly(
+          "cached_bytes", &torch_ipex::runtime::CPUPoolArenaStats::cached_bytes)
+      .def_readonly(
+          "num_allocs", &torch_ipex::runtime::CPUPoolArenaStats::num_allocs)
+      .def_readonly(
+          "num_cache_hits",
+          &torch_ipex::runtime::CPUPoolArenaStats::num_cache_hits);
+
+  // Arenas live for the whole process, Python never owns them.
+  py::class_<
+      torch_ipex::runtime::CPUPoolArena,
+      std::unique_ptr<torch_ipex::runtime::CPUPoolArena, py::nodelete>>(
+      m, "CPUPoolArena")
+      .def_static(
+          "get",
+          [](std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool) {
+            return torch_ipex::runtime::CPUPoolArena::get(*cpu_pool);
+          },
+          py::return_value_policy::reference)
+      .def("node", &torch_ipex::runtime::CPUPoolArena::node)
+      .def("stats", &torch_ipex::runtime::CPUPoolArena::stats)
+      .def("empty_cache", &torch_ipex::runtime::CPUPoolArena::empty_cache)
+      .def(
+          "set_max_cached_bytes",
+          &torch_ipex::runtime::CPUPoolArena::set_max_cached_bytes);
+
   py::class_<
       torch_ipex::runtime::TaskModule,
       std::shared_ptr<torch_ipex::runtime::TaskModule>>(m, "TaskModule")
@@ -224,6 +337,59 @@ void InitIpexModuleBindings(py::module m) {
             return self.run_async(std::move(args), std::move(kwargs));
           });
 
+  py::class_<
+      torch_ipex::runtime::BatchingTaskModule,
+      std::shared_ptr<torch_ipex::runtime::BatchingTaskModule>>(
+      m, "BatchingTaskModule")
+      .def(py::init([](const torch::jit::Module& module,
+                       std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool,
+                       int64_t max_batch_size,
+                       int64_t max_delay_us,
+                       int64_t pad_dim,
+                       double pad_value,
+                       int64_t output_pad_dim,
+                       int32_t num_workers) {
+        return std::make_shared<torch_ipex::runtime::BatchingTaskModule>(
+            module,
+            (*cpu_pool),
+            torch_ipex::runtime::BatchingPolicy{
+                max_batch_size,
+                max_delay_us,
+                pad_dim,
+                pad_value,
+                output_pad_dim},
+            num_workers);
+      }))
+      .def(py::init([](const py::object& module,
+                       std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool,
+                       int64_t max_batch_size,
+                       int64_t max_delay_us,
+                       int64_t pad_dim,
+                       double pad_value,
+                       int64_t output_pad_dim,
+                       int32_t num_workers) {
+        return std::make_shared<torch_ipex::runtime::BatchingTaskModule>(
+            module,
+            (*cpu_pool),
+            torch_ipex::runtime::BatchingPolicy{
+                max_batch_size,
+                max_delay_us,
+                pad_dim,
+                pad_value,
+                output_pad_dim},
+            num_workers);
+      }))
+      .def(
+          "run_sync",
+          [](torch_ipex::runtime::BatchingTaskModule& self, py::args& args) {
+            return self.run_sync(std::move(args));
+          })
+      .def(
+          "run_async",
+          [](torch_ipex::runtime::BatchingTaskModule& self, py::args& args) {
+            return self.run_async(std::move(args));
+          });
+
   m.def(
       "get_process_available_cores",
       &torch_ipex::runtime::get_process_available_cores);
@@ -251,6 +417,14 @@ void InitIpexModuleBindings(py::module m) {
         torch_ipex::runtime::set_mask_affinity_from_cpu_pool((*cpu_pool));
         return;
       });
+  m.def(
+      "set_current_cpu_pool_arena",
+      &torch_ipex::runtime::set_current_cpu_pool_arena,
+      py::return_value_policy::reference);
+  m.def(
+      "get_current_cpu_pool_arena",
+      &torch_ipex::runtime::get_current_cpu_pool_arena,
+      py::return_value_policy::reference);
 
   m.def("roc_auc_score", &toolkit::roc_auc_score);
   m.def("roc_auc_score_all", &toolkit::roc_auc_score_all);
@@ -4,6 +4,17 @@ namespace torch_ipex {
 namespace runtime {
 
 py::object FutureTensor::get() {
+  if (this->batching_module_initialized_) {
+    std::vector<at::Tensor> res;
+    {
+      pybind11::gil_scoped_release no_gil_guard;
+      res = this->future_tensors.get();
+    }
+    if (res.size() == 1) {
+      return py::cast(res[0]);
+    }
+    return py::tuple(py::cast(res));
+  }
   CHECK(this->script_module_initialized_ ^ this->module_initialized_);
   if (this->script_module_initialized_) {
     c10::IValue res;
@@ -78,21 +89,13 @@ std::unique_ptr<FutureTensor> TaskModule::run_async(
       future_tensor_result->script_module_initialized_ = true;
       future_tensor_result->future_script_tensor = task->get_future();
 
-      {
-        std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-        // submit task to a stopping the pool is not allowed
-        if (this->task_executor->is_stop())
-          throw std::runtime_error(
-              "submit TaskModule(py::object) on stopped ThreadPool");
-        this->task_executor->get_tasks().emplace([task, grad_mode]() {
-          // set the thread local status, such as the grad mode before
-          // execuating the status
-          at::GradMode::set_enabled(grad_mode);
-          // execuate the task
-          (*task)();
-        });
-      }
-      this->task_executor->get_condition().notify_one();
+      this->task_executor->submit([task, grad_mode]() {
+        // set the thread local status, such as the grad mode before
+        // execuating the status
+        at::GradMode::set_enabled(grad_mode);
+        // execuate the task
+        (*task)();
+      });
     }
   } else {
     CHECK(this->module_initialized_);
@@ -112,21 +115,13 @@ std::unique_ptr<FutureTensor> TaskModule::run_async(
     future_tensor_result->module_initialized_ = true;
     future_tensor_result->future_tensor = task->get_future();
 
-    {
-      std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-      // submit task to a stopping the pool is not allowed
-      if (this->task_executor->is_stop())
-        throw std::runtime_error(
-            "submit TaskModule(py::object) on stopped ThreadPool");
-      this->task_executor->get_tasks().emplace([task, grad_mode]() {
-        // set the thread local status, such as the grad mode before execuating
-        // the status
-        at::GradMode::set_enabled(grad_mode);
-        // execuate the task
-        (*task)();
-      });
-    }
-    this->task_executor->get_condition().notify_one();
+    this->task_executor->submit([task, grad_mode]() {
+      // set the thread local status, such as the grad mode before execuating
+      // the status
+      at::GradMode::set_enabled(grad_mode);
+      // execuate the task
+      (*task)();
+    });
   }
   return future_tensor_result;
 }
@@ -138,5 +133,95 @@ py::object TaskModule::run_sync(py::args&& args, py::kwargs&& kwargs) {
   return future_tensor_result->get();
 }
 
+BatchingTaskModule::BatchingTaskModule(
+    const torch::jit::Module& script_module,
+    const torch_ipex::runtime::CPUPool& cpu_pool,
+    const BatchingPolicy& policy,
+    int32_t num_workers)
+    : script_module_(script_module) {
+  this->task_executor = std::make_shared<TaskExecutor>(cpu_pool, num_workers);
+  this->script_module_initialized_ = true;
+  this->batching_task = std::make_unique<BatchingTask>(
+      [this](std::vector<at::Tensor> inputs) {
+        return this->forward(std::move(inputs));
+      },
+      this->task_executor,
+      policy);
+}
+
+BatchingTaskModule::BatchingTaskModule(
+    const py::object& module,
+    const torch_ipex::runtime::CPUPool& cpu_pool,
+    const BatchingPolicy& policy,
+    int32_t num_workers)
+    : module_(module) {
+  this->task_executor = std::make_shared<TaskExecutor>(cpu_pool, num_workers);
+  this->module_initialized_ = true;
+  this->batching_task = std::make_unique<BatchingTask>(
+      [this](std::vector<at::Tensor> inputs) {
+        return this->forward(std::move(inputs));
+      },
+      this->task_executor,
+      policy);
+}
+
+BatchingTaskModule::~BatchingTaskModule() {
+  pybind11::gil_scoped_release no_gil_guard;
+  // Flush the queued requests, then wait for the batches to finish since
+  // they run forward() of this module
+  this->batching_task->stop();
+  this->task_executor->stop_executor();
+}
+
+std::vector<at::Tensor> BatchingTaskModule::forward(
+    std::vector<at::Tensor> inputs) {
+  if (this->script_module_initialized_) {
+    std::vector<c10::IValue> stack(inputs.begin(), inputs.end());
+    auto output = this->script_module_.get_method("forward")(std::move(stack));
+    if (output.isTensor()) {
+      return {output.toTensor()};
+    }
+    if (output.isTuple()) {
+      std::vector<at::Tensor> outputs;
+      for (const auto& element : output.toTupleRef().elements()) {
+        outputs.push_back(element.toTensor());
+      }
+      return outputs;
+    }
+    return output.toTensorVector();
+  }
+  CHECK(this->module_initialized_);
+  pybind11::gil_scoped_acquire gil_guard;
+  py::tuple args(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    args[i] = py::cast(inputs[i]);
+  }
+  py::object output = this->module_(*args);
+  if (THPVariable_Check(output.ptr())) {
+    return {py::cast<at::Tensor>(output)};
+  }
+  return py::cast<std::vector<at::Tensor>>(output);
+}
+
+std::unique_ptr<FutureTensor> BatchingTaskModule::run_async(py::args&& args) {
+  std::vector<at::Tensor> inputs;
+  for (const auto& arg : args) {
+    inputs.push_back(py::cast<at::Tensor>(arg));
+  }
+  std::unique_ptr<FutureTensor> future_tensor_result =
+      std::make_unique<FutureTensor>();
+  future_tensor_result->batching_module_initialized_ = true;
+  future_tensor_result->future_tensors =
+      (*this->batching_task)(std::move(inputs));
+  return future_tensor_result;
+}
+
+py::object BatchingTaskModule::run_sync(py::args&& args) {
+  // sync API to run application inside a batch
+  std::unique_ptr<FutureTensor> future_tensor_result =
+      this->run_async(std::move(args));
+  return future_tensor_result->get();
+}
+
 } // namespace runtime
 } // namespace torch_ipex
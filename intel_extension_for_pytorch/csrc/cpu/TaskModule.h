@@ -13,6 +13,7 @@
 #include <torch/csrc/jit/api/module.h>
 #include <torch/csrc/jit/python/pybind_utils.h>
 #include <torch/csrc/utils/pybind.h>
+#include "BatchingTask.h"
 #include "TaskExecutor.h"
 
 namespace torch_ipex {
@@ -24,6 +25,10 @@ struct FutureTensor {
   // nn module
   std::future<py::object> future_tensor;
   bool module_initialized_{false};
+  // batching module, a single output is returned as a tensor, otherwise
+  // the outputs are returned as a tuple
+  std::future<std::vector<at::Tensor>> future_tensors;
+  bool batching_module_initialized_{false};
   // get the result
   py::object get();
 };
@@ -61,5 +66,42 @@ class TaskModule {
   py::kwargs kwargs;
 };
 
+/*BatchingTaskModule batches the concurrent calls of a module*/
+class BatchingTaskModule {
+ public:
+  explicit BatchingTaskModule(
+      const torch::jit::Module& module,
+      const torch_ipex::runtime::CPUPool& cpu_pool,
+      const BatchingPolicy& policy,
+      int32_t num_workers);
+  explicit BatchingTaskModule(
+      const py::object& module,
+      const torch_ipex::runtime::CPUPool& cpu_pool,
+      const BatchingPolicy& policy,
+      int32_t num_workers);
+  BatchingTaskModule(const BatchingTaskModule& task_module) = delete;
+  BatchingTaskModule(BatchingTaskModule&& task_module) = delete;
+  BatchingTaskModule& operator=(const BatchingTaskModule& task_module) =
+      delete;
+  BatchingTaskModule& operator=(BatchingTaskModule&& task_module) = delete;
+  ~BatchingTaskModule();
+  py::object run_sync(py::args&& args); /*sync execution*/
+  std::unique_ptr<FutureTensor> run_async(
+      py::args&& args); /*async execution in a batch*/
+ private:
+  // Run the module on a batch in a worker of the TaskExecutor
+  std::vector<at::Tensor> forward(std::vector<at::Tensor> inputs);
+
+  // Script module input
+  torch::jit::Module script_module_;
+  bool script_module_initialized_{false};
+  // Module input
+  py::object module_;
+  bool module_initialized_{false};
+
+  std::shared_ptr<TaskExecutor> task_executor;
+  std::unique_ptr<BatchingTask> batching_task;
+};
+
 } // namespace runtime
 } // namespace torch_ipex
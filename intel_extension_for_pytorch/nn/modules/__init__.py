@@ -4,6 +4,9 @@ from .merged_embeddingbag import MergedEmbeddingBagWithSGD
 from .merged_embeddingbag import MergedEmbeddingBag
 from .merged_embeddingbag import MergedEmbeddingBagWithCat
 from .merged_embeddingbag import MergedEmbeddingBagWithAdaGrad
+from .merged_embeddingbag import MergedEmbeddingBagWithAdam
+from .merged_embeddingbag import MergedEmbeddingBagWithLAMB
 from .merged_embeddingbag import DistMergeEmbeddingBagWithAdaGrad
 from ...cpu.nn.linear_fuse_eltwise import IPEXLinearEltwise
 from .weight_only_quantization import IpexWoqLinear
+from .multi_lora import MultiLoraLinear
@@ -1,7 +1,7 @@
 import torch
 from torch import nn
 from torch.autograd import Function
-from typing import List, Optional, NamedTuple
+from typing import List, Optional, NamedTuple, Tuple
 import enum
 
 
@@ -23,6 +23,21 @@ class AdaGradArgs(NamedTuple):
     lr: float
 
 
+class AdamArgs(NamedTuple):
+    # "adam" (lazy Adam), "rowwise_adam" or "lamb"
+    update: str
+    exp_avg: List[torch.Tensor]
+    exp_avg_sq: List[torch.Tensor]
+    bf16_trail: List[Optional[torch.Tensor]]
+    # number of the updates, incremented by each backward
+    step: torch.Tensor
+    beta1: float
+    beta2: float
+    eps: float
+    lr: float
+    weight_decay: float
+
+
 class EmbeddingSpec(NamedTuple):
     num_embeddings: int
     embedding_dim: int
@@ -92,6 +107,23 @@ def merged_embeddingbag_adagrad(
     )
 
 
+def merged_embeddingbag_adam(
+    weights, indices, offsets, pooling_mode, include_last_offset, adam_args
+):
+    if torch.is_grad_enabled():
+        return MergedEmbeddingBagAdamFunc.apply(
+            indices,
+            offsets,
+            pooling_mode,
+            include_last_offset,
+            adam_args,
+            *weights,
+        )
+    return torch.ops.torch_ipex.merged_embeddingbag_forward(
+        weights, indices, offsets, pooling_mode, include_last_offset
+    )
+
+
 class MergedEmbeddingBagFunc(Function):
     @staticmethod
     def forward(ctx, indices, offsets, pooling_mode, include_last_offset, *weights):
@@ -222,6 +254,56 @@ class MergedEmbeddingBagAdaGradFunc(Function):
         return tuple(output)
 
 
+class MergedEmbeddingBagAdamFunc(Function):
+    @staticmethod
+    def forward(
+        ctx,
+        indices,
+        offsets,
+        pooling_mode,
+        include_last_offset,
+        adam_args,
+        *weights,
+    ):
+        output = torch.ops.torch_ipex.merged_embeddingbag_forward(
+            weights, indices, offsets, pooling_mode, include_last_offset
+        )
+        ctx.indices = indices
+        ctx.offsets = offsets
+        ctx.weights = weights
+        ctx.pooling_mode = pooling_mode
+        ctx.include_last_offset = include_last_offset
+        ctx.adam_args = adam_args
+        return tuple(output)
+
+    @staticmethod
+    def backward(ctx, *grad_out):
+        adam_args = ctx.adam_args
+        adam_args.step.add_(1)
+        backward_update = getattr(
+            torch.ops.torch_ipex, "merged_embeddingbag_backward_" + adam_args.update
+        )
+        backward_update(
+            grad_out,
+            ctx.weights,
+            ctx.indices,
+            ctx.offsets,
+            ctx.pooling_mode,
+            ctx.include_last_offset,
+            adam_args.exp_avg,
+            adam_args.exp_avg_sq,
+            adam_args.bf16_trail,
+            int(adam_args.step),
+            adam_args.beta1,
+            adam_args.beta2,
+            adam_args.eps,
+            adam_args.lr,
+            adam_args.weight_decay,
+        )
+        output = [None] * (5 + len(ctx.weights))
+        return tuple(output)
+
+
 class MergedEmbeddingBag(nn.Module):
     r"""
     Merge multiple Pytorch `EmbeddingBag <https://pytorch.org/docs/stable/generated/torch.nn.EmbeddingBag.html
@@ -259,6 +341,7 @@ class MergedEmbeddingBag(nn.Module):
     Now `MergedEmbeddingBagWithSGD` is the only option running with an optimizer. We plan to add more optimizer support
     in the future. Visit `MergedEmbeddingBagWithSGD` for introduction of `MergedEmbeddingBagWith[Optimizer]`.
     """
+
     embedding_specs: List[EmbeddingSpec]
 
     def __init__(
@@ -402,6 +485,7 @@ class MergedEmbeddingBagWithSGD(MergedEmbeddingBag):
         gradients from the backward step and thus the memory access pattern becomes more friendly. Data access will
         happen on cache more than on memory.
     """
+
     embedding_specs: List[EmbeddingSpec]
 
     def __init__(
@@ -603,6 +687,203 @@ class MergedEmbeddingBagWithAdaGrad(MergedEmbeddingBag):
         return cls(embedding_specs, lr, eps)
 
 
+class MergedEmbeddingBagWithAdam(MergedEmbeddingBag):
+    r"""
+    `MergedEmbeddingBag` with the Adam update fused with the backward, as
+    `MergedEmbeddingBagWithSGD` does for SGD. Like for `torch.optim.SparseAdam`,
+    the moments are lazy: only the rows looked up by the batch are updated,
+    together with their moments, in a single pass over the rows. `weight_decay`
+    is added to the gradient as for `torch.optim.Adam`.
+
+        >>> EmbLists = torch.nn.Modulist(emb1, emb2, emb3, ..., emb_m)
+        >>> merged_emb = MergedEmbeddingBagWithAdam.from_embeddingbag_list(EmbLists, lr=lr)
+        >>> outputs = merged_emb(indices, offsets)
+        >>> torch.autograd.backward(outputs, grads)
+
+    Args:
+        rowwise (bool): keep a single second moment per row, the mean of the
+            squared gradients of the row, which saves most of the memory of
+            the moments. Default: ``False``
+        state_dtype (torch.dtype, optional): dtype of the moments,
+            ``torch.bfloat16``, or ``torch.int8`` for 8 bits moments quantized
+            on a log scale below the largest magnitude of each row. Default:
+            the dtype of the weights, float for bfloat16 weights
+    """
+
+    embedding_specs: List[EmbeddingSpec]
+
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 1e-3,
+        betas: Tuple[float, float] = (0.9, 0.999),
+        eps: float = 1e-8,
+        weight_decay: float = 0,
+        rowwise: bool = False,
+        state_dtype: Optional[torch.dtype] = None,
+    ):
+        self._init(
+            embedding_specs,
+            "rowwise_adam" if rowwise else "adam",
+            lr,
+            betas,
+            eps,
+            weight_decay,
+            state_dtype,
+        )
+
+    def _init(self, embedding_specs, update, lr, betas, eps, weight_decay, state_dtype):
+        super(MergedEmbeddingBagWithAdam, self).__init__(embedding_specs)
+        if state_dtype not in (None, torch.float, torch.bfloat16, torch.int8):
+            raise ValueError("Invalid state dtype: {}".format(state_dtype))
+        self.state_dtype = state_dtype
+        self.adam_args = self.init_adam_args(update, lr, betas, eps, weight_decay)
+        for i in range(self.n_tables):
+            weight = self.weights[i]
+            if weight.dtype == torch.bfloat16:
+                self.adam_args.bf16_trail.append(
+                    torch.zeros_like(weight, dtype=torch.bfloat16)
+                )
+            else:
+                self.adam_args.bf16_trail.append(torch.empty(0, dtype=torch.bfloat16))
+            exp_avg, exp_avg_sq = self.init_moments(weight)
+            self.adam_args.exp_avg.append(exp_avg)
+            self.adam_args.exp_avg_sq.append(exp_avg_sq)
+
+    def init_adam_args(self, update, lr, betas, eps, weight_decay):
+        if lr < 0.0:
+            raise ValueError("Invalid learning rate: {}".format(lr))
+        if eps < 0.0:
+            raise ValueError("Invalid epsilon value: {}".format(eps))
+        if not 0.0 <= betas[0] < 1.0 or not 0.0 <= betas[1] < 1.0:
+            raise ValueError("Invalid beta parameters: {}".format(betas))
+        if weight_decay < 0.0:
+            raise ValueError("Invalid weight_decay value: {}".format(weight_decay))
+        return AdamArgs(
+            update=update,
+            exp_avg=[],
+            exp_avg_sq=[],
+            bf16_trail=[],
+            step=torch.zeros(1, dtype=torch.int64),
+            beta1=betas[0],
+            beta2=betas[1],
+            eps=eps,
+            lr=lr,
+            weight_decay=weight_decay,
+        )
+
+    def init_moments(self, weight):
+        acc_dtype = torch.float if weight.dtype == torch.bfloat16 else weight.dtype
+        num_rows, emb_dim = weight.shape
+        rowwise = self.adam_args.update == "rowwise_adam"
+        if self.state_dtype == torch.int8:
+            # 8 bits rows end with the float scale of the row
+            exp_avg = torch.zeros(num_rows, emb_dim + 4, dtype=torch.int8)
+            if rowwise:
+                exp_avg_sq = torch.zeros(num_rows, dtype=acc_dtype)
+            else:
+                exp_avg_sq = torch.zeros(num_rows, emb_dim + 4, dtype=torch.uint8)
+            return exp_avg, exp_avg_sq
+        dtype = acc_dtype if self.state_dtype is None else self.state_dtype
+        exp_avg = torch.zeros(num_rows, emb_dim, dtype=dtype)
+        exp_avg_sq = torch.zeros(num_rows, *([] if rowwise else [emb_dim]), dtype=dtype)
+        return exp_avg, exp_avg_sq
+
+    def to_bfloat16_train(self):
+        r"""
+        Cast weight to bf16 and it's trail part for training
+        """
+        trails = []
+        for i in range(len(self.weights)):
+            if self.weights[i].dtype == torch.float:
+                bf16_w, trail = torch.ops.torch_ipex.split_float_bfloat16(
+                    self.weights[i]
+                )
+            elif self.weights[i].dtype == torch.bfloat16:
+                bf16_w = self.weights[i]
+                trail = torch.zeros_like(bf16_w, dtype=torch.bfloat16)
+            elif self.weights[i].dtype == torch.double:
+                bf16_w, trail = torch.ops.torch_ipex.split_float_bfloat16(
+                    self.weights[i].float()
+                )
+            else:
+                AssertionError(
+                    False
+                ), r"MergedEmbeddingBag only support dtypes with bfloat, float and double"
+            trails.append(trail)
+            self.weights[i] = torch.nn.Parameter(bf16_w)
+        # the moments of bfloat16 weights are kept in float at most
+        for moments in (self.adam_args.exp_avg, self.adam_args.exp_avg_sq):
+            for i, moment in enumerate(moments):
+                if moment.dtype == torch.double:
+                    moments[i] = moment.float()
+        self.adam_args = self.adam_args._replace(bf16_trail=trails)
+
+    def forward(self, indices, offsets):
+        r"""
+        Args:
+            indices (List[Tensor]): See
+                https://pytorch.org/docs/stable/generated/torch.nn.EmbeddingBag.html#torch.nn.EmbeddingBag.forward
+            offsets (List[Tensor]): See
+                https://pytorch.org/docs/stable/generated/torch.nn.EmbeddingBag.html#torch.nn.EmbeddingBag.forward
+        Returns:
+            List[Tensor] output shape of `(batch_size, embedding_dim)` which length = num of tables.
+        """
+        return merged_embeddingbag_adam(
+            self.weights,
+            indices,
+            offsets,
+            self.pooling_mode,
+            self.include_last_offset,
+            self.adam_args,
+        )
+
+    @classmethod
+    def from_embeddingbag_list(
+        cls,
+        tables: List[torch.nn.EmbeddingBag],
+        **kwargs,
+    ):
+        embedding_specs = []
+        for emb in tables:
+            emb_shape = emb.weight.shape
+            embedding_specs.append(
+                EmbeddingSpec(
+                    num_embeddings=emb_shape[0],
+                    embedding_dim=emb_shape[1],
+                    pooling_mode=emb.mode,
+                    dtype=emb.weight.dtype,
+                    weight=emb.weight.detach(),
+                    sparse=emb.sparse,
+                    include_last_offset=emb.include_last_offset,
+                )
+            )
+        return cls(embedding_specs, **kwargs)
+
+
+class MergedEmbeddingBagWithLAMB(MergedEmbeddingBagWithAdam):
+    r"""
+    `MergedEmbeddingBag` with the LAMB update fused with the backward. The Adam
+    update of each row looked up by the batch, plus the decoupled
+    `weight_decay` times the row, is scaled by the trust ratio of the row, the
+    norm of the row over the norm of its update.
+
+    Args:
+        state_dtype (torch.dtype, optional): see `MergedEmbeddingBagWithAdam`
+    """
+
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 1e-3,
+        betas: Tuple[float, float] = (0.9, 0.999),
+        eps: float = 1e-6,
+        weight_decay: float = 0,
+        state_dtype: Optional[torch.dtype] = None,
+    ):
+        self._init(embedding_specs, "lamb", lr, betas, eps, weight_decay, state_dtype)
+
+
 class MergedEmbeddingBagWithCat(MergedEmbeddingBag):
     r"""
     To support `MergedEmbeddingBag` with cat all outputs with an given input.
@@ -625,6 +906,7 @@ class MergedEmbeddingBagWithCat(MergedEmbeddingBag):
         >>> merged_emb = MergedEmbeddingBagWithCat.from_embeddingbag_list(EmbLists)
         >>> cat_out = MergedEmbeddingBagWithCat(dense_feature, inputs)
     """
+
     embedding_specs: List[EmbeddingSpec]
 
     def __init__(
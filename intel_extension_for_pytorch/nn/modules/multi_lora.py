@@ -0,0 +1,133 @@
+import torch
+from torch import nn
+
+from .weight_only_quantization import IpexWoqLinear
+
+
+class MultiLoraLinear(nn.Module):
+    r"""
+    A linear layer with a pool of LoRA adapters, for serving a batch of
+    requests that use different adapters on top of the same base model.
+
+    The output of each token is that of the base linear plus the low-rank
+    delta of the adapter picked for the token:
+
+        >>> y[t] = base(x[t]) + scaling[a] * x[t] @ A[a].T @ B[a].T, a = indices[t]
+
+    All tokens are computed in one call: tokens are grouped by adapter and the
+    deltas are computed by one segmented grouped GEMM for the whole batch.
+    When ``base`` is an ``IpexWoqLinear`` or a linear prepacked by TPP, the base
+    GEMM runs in the same op.
+
+    Adapters of lower ranks than ``max_rank`` are padded with zeros.
+
+    Args:
+        base (torch.nn.Module): The base linear, ``torch.nn.Linear``, a linear
+            optimized by ``ipex.optimize`` or ``IpexWoqLinear``.
+        max_adapters (int): Number of adapter slots of the pool.
+        max_rank (int): Largest rank of the adapters.
+        dtype (torch.dtype): Dtype of the adapters and of the activations.
+            Default: ``torch.bfloat16``.
+    """
+
+    def __init__(self, base, max_adapters, max_rank, dtype=torch.bfloat16):
+        super().__init__()
+        self.base = base
+        self.in_features = base.in_features
+        self.out_features = base.out_features
+        self.max_adapters = max_adapters
+        self.max_rank = max_rank
+        self.dtype = dtype
+        # lora_B is stored transposed so that the deltas are added along the
+        # contiguous output features
+        self.register_buffer(
+            "lora_a", torch.zeros(max_adapters, max_rank, self.in_features, dtype=dtype)
+        )
+        self.register_buffer(
+            "lora_b",
+            torch.zeros(max_adapters, max_rank, self.out_features, dtype=dtype),
+        )
+        self.register_buffer("scalings", torch.zeros(max_adapters))
+
+    def load_adapter(self, slot, lora_a, lora_b, scaling=1.0):
+        r"""
+        Load an adapter into ``slot`` of the pool.
+
+        Args:
+            slot (int): Slot of the adapter, in [0, max_adapters).
+            lora_a (torch.Tensor): Weight of ``lora_A`` of shape
+                [rank, in_features].
+            lora_b (torch.Tensor): Weight of ``lora_B`` of shape
+                [out_features, rank].
+            scaling (float): Scaling of the delta, ``lora_alpha / rank`` for
+                PEFT adapters.
+        """
+        rank = lora_a.size(0)
+        assert 0 <= slot < self.max_adapters, "adapter slot out of range"
+        assert rank <= self.max_rank, "rank of the adapter exceeds max_rank"
+        assert lora_a.shape == (rank, self.in_features)
+        assert lora_b.shape == (self.out_features, rank)
+        with torch.no_grad():
+            self.lora_a[slot].zero_()
+            self.lora_b[slot].zero_()
+            self.lora_a[slot, :rank].copy_(lora_a)
+            self.lora_b[slot, :rank].copy_(lora_b.t())
+            self.scalings[slot] = scaling
+
+    def unload_adapter(self, slot):
+        with torch.no_grad():
+            self.lora_a[slot].zero_()
+            self.lora_b[slot].zero_()
+            self.scalings[slot] = 0.0
+
+    def _token_indices(self, x, indices):
+        num_tokens = x.numel() // self.in_features
+        if indices.numel() != num_tokens:
+            # one adapter per sequence of x of [batch, seq_len, in_features]
+            assert x.dim() == 3 and indices.numel() == x.size(0)
+            indices = indices.view(-1, 1).expand(x.size(0), x.size(1))
+        return indices.reshape(-1)
+
+    def forward(self, x, indices):
+        r"""
+        Args:
+            x (torch.Tensor): Input of shape [..., in_features].
+            indices (torch.Tensor): Adapter of each token of ``x``, or of each
+                sequence when ``x`` is [batch, seq_len, in_features]. Tokens of
+                negative indices only go through the base linear.
+        """
+        x = x.to(self.dtype).contiguous()
+        indices = self._token_indices(x, indices)
+        if type(self.base) is IpexWoqLinear:
+            return torch.ops.torch_ipex.woq_linear_multi_lora(
+                x,
+                self.base._op_context.get_data_handle(),
+                self.lora_a,
+                self.lora_b,
+                indices,
+                self.scalings,
+            )
+        if getattr(self.base, "use_tpp", False) and not self.base.tpp_fallback:
+            return torch.ops.torch_ipex.tpp_linear_multi_lora(
+                x,
+                self.base.weight.detach(),
+                (
+                    self.base.bias.detach()
+                    if self.base.bias is not None
+                    else x.new_empty(0)
+                ),
+                self.lora_a,
+                self.lora_b,
+                indices,
+                self.scalings,
+                self.out_features,
+            )
+        y = self.base(x).to(self.dtype)
+        return torch.ops.torch_ipex.multi_lora_add_(
+            y, x, self.lora_a, self.lora_b, indices, self.scalings
+        )
+
+    def extra_repr(self):
+        return "in_features={}, out_features={}, max_adapters={}, max_rank={}".format(
+            self.in_features, self.out_features, self.max_adapters, self.max_rank
+        )
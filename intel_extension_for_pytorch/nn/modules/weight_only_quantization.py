@@ -34,6 +34,10 @@ class IpexWoqLinear(nn.Module):
         self._num_concats = 1
         self._act_quant_mode = 0
         self._group_size = -1
+        # Group index of each input channel for act-order weights
+        self._g_idx = None
+        # "mxfp4", "mxfp6" or "mxfp8" for weights in MX formats
+        self._weight_format = None
 
     def pre_ipex_gemm(self, input):
         return input
@@ -137,7 +141,15 @@ class IpexWoqLinear(nn.Module):
 
     @classmethod
     def from_float_and_int4_weight(
-        cls, mod, qweight, scales, zero_points, bias=None, group_size=-1
+        cls,
+        mod,
+        qweight,
+        scales,
+        zero_points,
+        bias=None,
+        group_size=-1,
+        g_idx=None,
+        weight_bits=4,
     ):
         r"""Create a weight-only quantized module from a float module and int4 weight
 
@@ -148,6 +160,13 @@ class IpexWoqLinear(nn.Module):
             bias (Tensor or None): bias for linear
             scales (Tensor): scales for qweight
             zero_points (Tensor): zero points for qweight
+            group_size (int): group size along input channel, -1 for per channel
+            g_idx (Tensor or None): group index of each input channel, for
+                GPTQ checkpoints quantized with act-order (desc_act)
+            weight_bits (int): bit width of the values of qweight and zero points
+                if they are compressed in int32, 2, 3 or 4. 2-bit and 3-bit
+                weights are packed in 2 and 3 bits and need a multiple of 8
+                input channels. They are computed in bf16 for lowp_mode INT8.
         """
         float_modules = [torch.nn.Linear]
         deepspeed_modules = may_import_deepspeed_modules()
@@ -201,15 +220,77 @@ class IpexWoqLinear(nn.Module):
             int(lowp_mode),
             num_concats,
             act_quant_mode,
+            g_idx,
+            weight_bits,
         )
         qlinear.weight = qlinear._op_context.get_weight()
         qlinear._lowp_mode = lowp_mode
         qlinear._num_concats = num_concats
         qlinear._act_quant_mode = act_quant_mode
         qlinear._group_size = group_size
+        qlinear._g_idx = g_idx
         del qweight
         return qlinear
 
+    @classmethod
+    def from_float_and_mx_weight(cls, mod, qweight, scales, weight_format, bias=None):
+        r"""Create a weight-only quantized module from a float module and weight in
+        an MX (microscaling) format, where every 32 elements along input channel
+        share an E8M0 scale. The elements are decoded to floating point at runtime,
+        so lowp_mode=3 (INT8) falls back to 2 (BF16).
+
+        Args:
+            mod (Module): a float module, either produced by torch.ao.quantization
+                          utilities or provided by the user
+            qweight (Tensor): element codes in uint8, two per byte for "mxfp4" with
+                the even input channel in the lower 4 bits, four in three bytes for
+                "mxfp6" as a little-endian bitstream, one per byte for "mxfp8",
+                e.g., as returned by ipex.quantization.quantize_mx. One code per
+                byte is also accepted for "mxfp6".
+            scales (Tensor): E8M0 scales in uint8 in shape [N, K / 32]
+            weight_format (str): "mxfp4" (E2M1), "mxfp6" (E2M3) or "mxfp8" (E4M3)
+            bias (Tensor or None): bias for linear
+        """
+        assert weight_format in [
+            "mxfp4",
+            "mxfp6",
+            "mxfp8",
+        ], f"Unsupported MX weight format {weight_format}"
+        assert qweight.dtype == torch.uint8 and scales.dtype == torch.uint8, (
+            "MX weight and scales should have data type uint8, but got: "
+            f"{qweight.dtype} and {scales.dtype}"
+        )
+        lowp_mode = 0
+        qconfig = getattr(mod, "qconfig", None)
+        if qconfig is not None and hasattr(qconfig, "lowp_mode"):
+            lowp_mode = qconfig.lowp_mode
+        num_concats = 1
+        if hasattr(mod, "_num_concats"):
+            num_concats = mod._num_concats
+        if not hasattr(mod, "in_features"):
+            mod.in_features = mod.weight.size()[1]
+        if not hasattr(mod, "out_features"):
+            mod.out_features = mod.weight.size()[0]
+
+        qlinear = cls(mod.in_features, mod.out_features, dtype=torch.uint8)
+        if bias is None:
+            bias = mod.bias
+        qlinear._op_context = torch.ops.ipex_prepack.weight_only_qlinear_prepack_mx(
+            qweight,
+            scales,
+            bias,
+            None,
+            weight_format,
+            int(lowp_mode),
+            num_concats,
+        )
+        qlinear.weight = qlinear._op_context.get_weight()
+        qlinear._lowp_mode = 2 if lowp_mode == 3 else lowp_mode
+        qlinear._num_concats = num_concats
+        qlinear._group_size = 32
+        qlinear._weight_format = weight_format
+        return qlinear
+
     @classmethod
     def _init_cls(
         cls,
@@ -105,7 +105,10 @@ if "deepspeed" in installed_pkg:
 
 def _all_reduce_and_bias_add(mp_group, original_bias, output):
     if mp_group is not None:
-        torch.ops.deepspeed_comm.all_reduce(output)
+        if torch.ops.torch_ipex.shm_comm_is_initialized():
+            torch.ops.torch_ipex.shm_all_reduce(output)
+        else:
+            torch.ops.deepspeed_comm.all_reduce(output)
     if original_bias is not None:
         output += original_bias
 
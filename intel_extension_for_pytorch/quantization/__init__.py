@@ -16,5 +16,7 @@ from ._quantize_utils import (
     dequantize_per_channel,
     quantize_per_block,
     dequantize_per_block,
+    quantize_mx,
+    dequantize_mx,
 )
 from ._GPTQ import gptq
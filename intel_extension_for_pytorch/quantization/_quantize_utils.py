@@ -1022,3 +1022,113 @@ def dequantize_per_block(
     if weight_shape is not None:
         t = t[: weight_shape[0], : weight_shape[1]].contiguous()
     return t
+
+
+# MX (microscaling) element formats of the OCP Microscaling spec:
+# (exponent bits, mantissa bits, max exponent of normal values)
+_MX_FORMATS = {
+    "mxfp4": (2, 1, 2),  # E2M1
+    "mxfp6": (2, 3, 2),  # E2M3
+    "mxfp8": (4, 3, 8),  # E4M3
+}
+MX_BLOCK_SIZE = 32
+# Four 6-bit codes of "mxfp6" are packed in three bytes
+_MXFP6_CODE_SHIFTS = torch.tensor([0, 6, 12, 18], dtype=torch.int32)
+_MXFP6_BYTE_SHIFTS = torch.tensor([0, 8, 16], dtype=torch.int32)
+
+
+def _mx_element_values(weight_format):
+    # Values of the element codes without sign, in ascending order
+    ebits, mbits, _ = _MX_FORMATS[weight_format]
+    bias = 2 ** (ebits - 1) - 1
+    codes = torch.arange(2 ** (ebits + mbits))
+    exp = codes >> mbits
+    man = codes & (2**mbits - 1)
+    subnormal = man * 2.0 ** (1 - bias - mbits)
+    normal = (man + 2**mbits) * torch.exp2((exp - bias - mbits).to(torch.float))
+    return torch.where(exp == 0, subnormal, normal)
+
+
+def quantize_mx(input: torch.Tensor, weight_format):
+    r"""
+    Quantize a weight tensor of Linear modules to an MX format.
+    Assume the tensor shape is [output channel, input channel],
+    every 32 elements along input channel share a power-of-two scale.
+
+    Args:
+        input: The tensor to be quantized
+        weight_format: "mxfp4", "mxfp6" or "mxfp8"
+
+    Returns:
+        A tuple of
+        - The element codes in uint8, two per byte for "mxfp4" with the
+          even input channel in the lower 4 bits, four in three bytes for
+          "mxfp6" as a little-endian bitstream, one per byte for "mxfp8"
+        - E8M0 scales in uint8 in shape [N, K / 32]
+    """
+    assert weight_format in _MX_FORMATS, f"Unsupported MX format {weight_format}"
+    assert (
+        input.dim() == 2 and input.size(1) % MX_BLOCK_SIZE == 0
+    ), f"{__name__}: Expect 2D input with K divisible by {MX_BLOCK_SIZE}"
+    ebits, mbits, emax = _MX_FORMATS[weight_format]
+    N, K = input.shape
+    t = input.to(torch.float).view(N, K // MX_BLOCK_SIZE, MX_BLOCK_SIZE)
+    amax = t.abs().amax(dim=-1, keepdim=True)
+    shared_exp = torch.where(
+        amax > 0, torch.floor(torch.log2(amax)) - emax, torch.tensor(-127.0)
+    ).clamp(-127, 127)
+    values = _mx_element_values(weight_format)
+    if weight_format == "mxfp8":
+        # The largest code of E4M3 is NaN
+        values = values[:-1]
+    # Round to nearest and saturate to the largest value
+    v = t / torch.exp2(shared_exp)
+    codes = torch.bucketize(v.abs(), (values[1:] + values[:-1]) / 2)
+    codes = codes.bitwise_or((v < 0).to(torch.long) << (ebits + mbits))
+    qt = codes.view(N, K).to(torch.uint8)
+    if weight_format == "mxfp4":
+        qt = qt[:, 1::2].bitwise_left_shift(4).bitwise_or_(qt[:, ::2])
+    elif weight_format == "mxfp6":
+        words = qt.view(N, -1, 4).to(torch.int32) << _MXFP6_CODE_SHIFTS
+        words = words.sum(-1, keepdim=True)
+        qt = (words >> _MXFP6_BYTE_SHIFTS).bitwise_and(0xFF).to(torch.uint8)
+        qt = qt.view(N, -1)
+    scales = (shared_exp.squeeze(-1) + 127).to(torch.uint8)
+    return qt.contiguous(), scales
+
+
+def dequantize_mx(qt: torch.Tensor, scales: torch.Tensor, weight_format):
+    r"""
+    Dequantize a weight tensor of Linear modules in an MX format.
+
+    Args:
+        qt: The element codes, as returned by quantize_mx
+        scales: E8M0 scales in uint8 in shape [N, K / 32]
+        weight_format: "mxfp4", "mxfp6" or "mxfp8"
+
+    Returns:
+        The dequantized tensor
+    """
+    assert weight_format in _MX_FORMATS, f"Unsupported MX format {weight_format}"
+    ebits, mbits, _ = _MX_FORMATS[weight_format]
+    codes = qt.to(torch.uint8)
+    if weight_format == "mxfp4":
+        t = torch.empty(
+            qt.shape[0], qt.shape[1] * 2, dtype=torch.uint8, device=qt.device
+        )
+        t[:, ::2] = codes.bitwise_and(0xF)
+        t[:, 1::2] = codes.bitwise_right_shift(4)
+        codes = t
+    elif weight_format == "mxfp6":
+        words = codes.view(qt.size(0), -1, 3).to(torch.int32) << _MXFP6_BYTE_SHIFTS
+        words = words.sum(-1, keepdim=True)
+        codes = (words >> _MXFP6_CODE_SHIFTS).bitwise_and(0x3F)
+        codes = codes.view(qt.size(0), -1)
+    codes = codes.to(torch.long)
+    mag = _mx_element_values(weight_format)[codes.bitwise_and(2 ** (ebits + mbits) - 1)]
+    t = torch.where(codes >> (ebits + mbits) == 1, -mag, mag)
+    N, K = t.shape
+    t = t.view(N, K // MX_BLOCK_SIZE, MX_BLOCK_SIZE) * torch.exp2(
+        scales.to(torch.float) - 127
+    ).unsqueeze(-1)
+    return t.view(N, K)
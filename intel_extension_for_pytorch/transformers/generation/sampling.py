@@ -0,0 +1,78 @@
+import torch
+
+from ...nn.modules import IpexWoqLinear
+
+
+def lm_head_sample(
+    lm_head,
+    hidden_states,
+    seeds,
+    counters,
+    prev_tokens=None,
+    temperature=1.0,
+    top_k=0,
+    top_p=1.0,
+    min_p=0.0,
+    repetition_penalty=1.0,
+    return_logits=False,
+):
+    r"""
+    Apply the LM head to the last token of each sequence of ``hidden_states``
+    and sample the next tokens, with the logits processed in the order of
+    repetition penalty, temperature, top-k, top-p and min-p.
+
+    With an LM head packed by TPP, the logits are sampled tile by tile of the
+    vocab as they are computed, and the logits of the whole vocab are only
+    written with ``return_logits``.
+
+    Tokens are drawn from a counter-based RNG, so that a sequence gets the same
+    tokens for the same seed and counters whatever the batch it is in.
+
+    Args:
+        lm_head (torch.nn.Module): The LM head, ``torch.nn.Linear``, a linear
+            optimized by ``ipex.optimize`` or ``IpexWoqLinear``.
+        hidden_states (torch.Tensor): [batch_size, seq_len, hidden_size].
+        seeds (torch.Tensor): int64 seed of each sequence.
+        counters (torch.Tensor): int64 counter of each sequence, usually the
+            number of tokens generated so far.
+        prev_tokens (torch.Tensor): [batch_size, length] tokens to apply the
+            repetition penalty on, padded with negative tokens.
+        temperature (float): Not greater than 0 for greedy search.
+        top_k (int): 0 to keep all tokens.
+        top_p (float): 1 to keep all tokens.
+        min_p (float): 0 to keep all tokens.
+        repetition_penalty (float): 1 for no penalty.
+        return_logits (bool): Also return the logits of the last tokens.
+
+    Returns:
+        The next tokens of [batch_size], and the logits of
+        [batch_size, vocab_size] with ``return_logits``, otherwise an empty
+        tensor.
+    """
+    args = (temperature, top_k, top_p, min_p, repetition_penalty, return_logits)
+    if type(lm_head) is IpexWoqLinear:
+        return torch.ops.torch_ipex.woq_linear_sample(
+            hidden_states,
+            lm_head._op_context.get_data_handle(),
+            seeds,
+            counters,
+            prev_tokens,
+            *args,
+        )
+    if getattr(lm_head, "use_tpp", False) and not lm_head.tpp_fallback:
+        x = hidden_states.to(lm_head.weight.dtype).contiguous()
+        return torch.ops.torch_ipex.tpp_linear_sample(
+            x,
+            lm_head.weight.detach(),
+            lm_head.bias.detach() if lm_head.bias is not None else x.new_empty(0),
+            seeds,
+            counters,
+            prev_tokens,
+            lm_head.out_features,
+            *args,
+        )
+    logits = lm_head(hidden_states[:, -1, :])
+    tokens = torch.ops.torch_ipex.sample_logits(
+        logits, seeds, counters, prev_tokens, *args[:-1]
+    )
+    return tokens, logits if return_logits else logits.new_empty(0)
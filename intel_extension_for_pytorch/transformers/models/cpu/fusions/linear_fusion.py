@@ -268,6 +268,24 @@ class _IPEXConcatLinearCPU(_IPEXlinearFusionCPU):
                     )
                     weights_list = []
                     break
+                if getattr(linear, "_g_idx", None) is not None:
+                    # Groups of act-order weights are not contiguous along K,
+                    # so they cannot be dequantized per block here.
+                    warnings.warn(
+                        "Concat linear fusion for CPU WOQ failed "
+                        "because weight is quantized with act-order. "
+                        "Falling back to separate linears."
+                    )
+                    weights_list = []
+                    break
+                if getattr(linear, "_weight_format", None) is not None:
+                    warnings.warn(
+                        "Concat linear fusion for CPU WOQ failed "
+                        "because weight is in MX format. "
+                        "Falling back to separate linears."
+                    )
+                    weights_list = []
+                    break
                 qw = linear._op_context.to_public(linear._op_context.get_weight())
                 scales = linear._op_context.get_scales()
                 zero_points = linear._op_context.get_zero_points()
@@ -363,6 +381,97 @@ class _IPEXConcatLinearCPU(_IPEXlinearFusionCPU):
         return tuple(output_list)
 
 
+class _IPEXWoqFusedMlpCPU(nn.Module):
+    r"""
+    Gated MLP of WOQ linears, down(silu(gate(x)) * up(x)) + residual, in one op.
+    The gate and up projections are packed in one concatenated weight, so that
+    the intermediate activation is consumed by the down projection tile by tile
+    and never written to memory. The concatenated weight is built from the
+    packed weights of gate and up without quantizing again, and the caller is
+    expected to drop gate and up afterwards to keep one copy of the weights.
+    ``gate_up_linear`` is None if the concatenated weight cannot be built, in
+    which case the module should not be used.
+    """
+
+    def __init__(self, module_gate, module_up, module_down):
+        super().__init__()
+        self.gate_up_linear = None
+        self.down_linear = module_down
+        # Down of tensor parallel is a subclass reducing its output across ranks
+        if not all(
+            type(linear) is IpexWoqLinear and linear._op_context is not None
+            for linear in [module_gate, module_up, module_down]
+        ):
+            return
+        if any(
+            linear._weight_format is not None for linear in [module_gate, module_up]
+        ):
+            return
+        gate = module_gate._op_context.packed_state()
+        up = module_up._op_context.packed_state()
+        weight, weight_shape, scales, zero_points, bias = gate[:5]
+        # Blocks of the packed weights are laid out along output channels
+        # first, so they can be concatenated as they are if gate and up are
+        # packed the same way without padded output channels.
+        if (
+            weight.dim() != 4
+            or weight.shape != up[0].shape
+            or list(weight_shape) != list(up[1])
+            or scales.size(0) != weight_shape[0]
+            or gate[6:9] != up[6:9]
+            or gate[10] != up[10]
+            or gate[12] != up[12]
+            or (zero_points is None) != (up[3] is None)
+            or gate[11] is not None
+            or up[11] is not None
+        ):
+            return
+        if bias is not None or up[4] is not None:
+            bias = torch.cat(
+                [
+                    b if b is not None else scales.new_zeros(weight_shape[0])
+                    for b in [bias, up[4]]
+                ]
+            )
+        num_concats = 2
+        ctx = torch.ops.ipex_prepack.weight_only_qlinear_prepack_from_packed(
+            torch.cat([weight, up[0]]),
+            [weight_shape[0] * 2, weight_shape[1]],
+            torch.cat([scales, up[2]]),
+            None if zero_points is None else torch.cat([zero_points, up[3]]),
+            bias,
+            gate[5],
+            gate[6],
+            gate[7],
+            gate[8],
+            num_concats,
+            gate[10],
+            None,
+            gate[12],
+        )
+        gate_up_linear = IpexWoqLinear(
+            module_gate.in_features,
+            module_gate.out_features * 2,
+            bias_=bias is not None,
+            dtype=module_gate.dtype,
+        )
+        gate_up_linear._op_context = ctx
+        gate_up_linear.weight = ctx.get_weight()
+        gate_up_linear._lowp_mode = module_gate._lowp_mode
+        gate_up_linear._num_concats = num_concats
+        gate_up_linear._act_quant_mode = module_gate._act_quant_mode
+        gate_up_linear._group_size = module_gate._group_size
+        self.gate_up_linear = gate_up_linear
+
+    def forward(self, x, residual=None):
+        return torch.ops.torch_ipex.woq_fused_mlp(
+            x,
+            self.gate_up_linear._op_context.get_data_handle(),
+            self.down_linear._op_context.get_data_handle(),
+            [] if residual is None else [residual],
+        )
+
+
 class _IPEXlinearSiluMulCPU(nn.Module):
     def __init__(self, module_s, module_m, tpp=False, woq=False):
         super().__init__()
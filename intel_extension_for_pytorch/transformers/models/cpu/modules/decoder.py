@@ -1,3 +1,4 @@
+import os
 from torch import nn
 from ...cpu.fusions.linear_fusion import (
     _IPEXlinearAddCPU,
@@ -7,6 +8,7 @@ from ...cpu.fusions.linear_fusion import (
     _IPEXlinearGeluCPU,
     _IPEXlinearMulCPU,
     _IPEXlinearSiluMulCPU,
+    _IPEXWoqFusedMlpCPU,
 )
 
 
@@ -40,12 +42,35 @@ class _IPEXDecoderLayerCPU(nn.Module):
                 self.mlp_linear_add = _IPEXlinearAddCPU(
                     module.mlp_linear_add.linear, tpp=tpp, woq=woq
                 )
-            self.linear_silu_mul = _IPEXlinearSiluMulCPU(
-                module.linear_silu_mul.linear_s,
-                module.linear_silu_mul.linear_m,
-                tpp=tpp,
-                woq=woq,
-            )
+            woq_fused_mlp = None
+            if (
+                woq
+                and not self.distributed
+                and os.environ.get("IPEX_WOQ_FUSED_MLP", "0") == "1"
+            ):
+                woq_fused_mlp = _IPEXWoqFusedMlpCPU(
+                    module.linear_silu_mul.linear_s,
+                    module.linear_silu_mul.linear_m,
+                    module.mlp_linear_add.linear,
+                )
+            if woq_fused_mlp is not None and woq_fused_mlp.gate_up_linear is not None:
+                self.woq_fused_mlp = woq_fused_mlp
+                # Release gate and up, whose weights are held by woq_fused_mlp
+                gate_up = [
+                    module.linear_silu_mul.linear_s,
+                    module.linear_silu_mul.linear_m,
+                ]
+                for name, child in list(self.mlp.named_children()):
+                    if any(child is linear for linear in gate_up):
+                        setattr(self.mlp, name, None)
+                self.linear_silu_mul = None
+            else:
+                self.linear_silu_mul = _IPEXlinearSiluMulCPU(
+                    module.linear_silu_mul.linear_s,
+                    module.linear_silu_mul.linear_m,
+                    tpp=tpp,
+                    woq=woq,
+                )
         elif self.model_backbone == "OPTForCausalLM":
             if not self.distributed:
                 self.mha_linear_add = _IPEXlinearAddCPU(
@@ -46,13 +46,16 @@ def LlamaDecoderLayer_forward(
     residual = hidden_states
     hidden_states = self.post_attention_layernorm(hidden_states)
 
-    mlp_gate = self.linear_silu_mul(hidden_states)
-
-    if not self.distributed:
-        hidden_states = self.mlp_linear_add(mlp_gate, residual)
+    if hasattr(self, "woq_fused_mlp"):
+        hidden_states = self.woq_fused_mlp(hidden_states, residual)
     else:
-        hidden_states = self.mlp.down_proj(mlp_gate)
-        hidden_states = residual + hidden_states
+        mlp_gate = self.linear_silu_mul(hidden_states)
+
+        if not self.distributed:
+            hidden_states = self.mlp_linear_add(mlp_gate, residual)
+        else:
+            hidden_states = self.mlp.down_proj(mlp_gate)
+            hidden_states = residual + hidden_states
 
     outputs = (hidden_states,)
 
@@ -341,12 +344,15 @@ def BaichuanDecoder_forward(
     residual = hidden_states
     hidden_states = self.post_attention_layernorm(hidden_states)
 
-    mlp_gate = self.linear_silu_mul(hidden_states)
-    if not self.distributed:
-        hidden_states = self.mlp_linear_add(mlp_gate, residual)
+    if hasattr(self, "woq_fused_mlp"):
+        hidden_states = self.woq_fused_mlp(hidden_states, residual)
     else:
-        hidden_states = self.mlp.down_proj(mlp_gate)
-        hidden_states = residual + hidden_states
+        mlp_gate = self.linear_silu_mul(hidden_states)
+        if not self.distributed:
+            hidden_states = self.mlp_linear_add(mlp_gate, residual)
+        else:
+            hidden_states = self.mlp.down_proj(mlp_gate)
+            hidden_states = residual + hidden_states
     outputs = (hidden_states,)
 
     if output_attentions:
@@ -673,13 +679,16 @@ def MistralDecoderLayer_forward(
     residual = hidden_states
     hidden_states = self.post_attention_layernorm(hidden_states)
 
-    mlp_gate = self.linear_silu_mul(hidden_states)
-
-    if not self.distributed:
-        hidden_states = self.mlp_linear_add(mlp_gate, residual)
+    if hasattr(self, "woq_fused_mlp"):
+        hidden_states = self.woq_fused_mlp(hidden_states, residual)
     else:
-        hidden_states = self.mlp.down_proj(mlp_gate)
-        hidden_states = residual + hidden_states
+        mlp_gate = self.linear_silu_mul(hidden_states)
+
+        if not self.distributed:
+            hidden_states = self.mlp_linear_add(mlp_gate, residual)
+        else:
+            hidden_states = self.mlp.down_proj(mlp_gate)
+            hidden_states = residual + hidden_states
 
     outputs = (hidden_states,)
 
@@ -919,13 +928,16 @@ def StableLMEpochDecoderLayer_forward(
     residual = hidden_states
     hidden_states = self.post_attention_layernorm(hidden_states)
 
-    mlp_gate = self.linear_silu_mul(hidden_states)
-
-    if not self.distributed:
-        hidden_states = self.mlp_linear_add(mlp_gate, residual)
+    if hasattr(self, "woq_fused_mlp"):
+        hidden_states = self.woq_fused_mlp(hidden_states, residual)
     else:
-        hidden_states = self.mlp.down_proj(mlp_gate)
-        hidden_states = residual + hidden_states
+        mlp_gate = self.linear_silu_mul(hidden_states)
+
+        if not self.distributed:
+            hidden_states = self.mlp_linear_add(mlp_gate, residual)
+        else:
+            hidden_states = self.mlp.down_proj(mlp_gate)
+            hidden_states = residual + hidden_states
 
     outputs = (hidden_states,)
 
@@ -793,6 +793,9 @@ def optimize(
             Weights shape should be N by K and they are quantized to UINT4 and compressed along K, then stored as
             `torch.int32`. Zero points are also UINT4 and stored as INT32. Scales and bias are floating point values.
             Bias is optional. If bias is not in state dict, bias of the original model is used.
+            For checkpoints quantized with act-order, the group index of input channels is read
+            by the key given by 'g_idx_key' ('g_idx' by default). 2-bit and 3-bit checkpoints
+            are loaded by setting 'weight_bits' to 2 or 3 in the config.
             Default value is ``None``.
         sample_inputs (Tuple tensors): sample inputs used for model quantization or torchscript.
             Default value is ``None``, and for well supported model, we provide this sample inputs automaticlly.
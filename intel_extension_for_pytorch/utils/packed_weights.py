@@ -0,0 +1,194 @@
+import json
+
+import torch
+from intel_extension_for_pytorch.nn.modules import IpexWoqLinear
+from intel_extension_for_pytorch.nn.utils._weight_prepack import _IPEXLinear
+
+# Version of the metadata layout in the archive
+_METADATA_VERSION = 1
+
+# Fields of packed_state() of WoqLinearOpContext
+_WOQ_STATE_FIELDS = (
+    "weight",
+    "weight_shape",
+    "scales",
+    "zero_points",
+    "bias",
+    "batch_size",
+    "is_int4",
+    "group_size",
+    "lowp_mode",
+    "num_concats",
+    "act_quant_mode",
+    "g_idx",
+    "weight_dtype",
+)
+
+
+def _packed_entry(m):
+    r"""
+    Return the kind, the tensors and the parameters to rebuild the packed
+    weight of m, or None if m has no packed weight to save.
+    """
+    if isinstance(m, IpexWoqLinear):
+        if m._op_context is None:
+            return None
+        state = dict(zip(_WOQ_STATE_FIELDS, m._op_context.packed_state()))
+        tensors = {
+            k: state.pop(k)
+            for k in ("weight", "scales", "zero_points", "bias", "g_idx")
+            if state[k] is not None
+        }
+        return "woq", tensors, state
+    if isinstance(m, _IPEXLinear) and not m.training:
+        if m.use_tpp and not m.tpp_fallback:
+            tensors = {"weight": m.weight.detach()}
+            if m.bias is not None:
+                tensors["bias"] = m.bias.detach()
+            return "tpp", tensors, {}
+        if m.use_dnnl:
+            tensors = {"weight": m.ctx.get_weight()}
+            if m.ctx.get_bias() is not None:
+                tensors["bias"] = m.ctx.get_bias()
+            params = {
+                "weight_shape": [m.out_features, m.in_features],
+                "batch_size": m.batch_size_collapsed,
+            }
+            return "dnnl", tensors, params
+    return None
+
+
+def save_packed_weights(model, path):
+    r"""
+    Save the packed weights of the linear modules of ``model`` to ``path``, so
+    that another process restores them by :func:`load_packed_weights` without
+    packing the weights again.
+
+    The weights of ``IpexWoqLinear``, and of the linear modules optimized by
+    ``ipex.optimize`` for inference with oneDNN or TPP, are saved in their
+    packed layouts. Each tensor starts at a page boundary of the file, so that
+    the loading processes map it into memory without copies and share the
+    physical pages of the file.
+
+    The packed layouts depend on the ISA of the machine, the archive can only
+    be loaded by a process of the same ISA level.
+
+    Args:
+        model (torch.nn.Module): The optimized model.
+        path (str): The file to write.
+    """
+    names = []
+    tensors = []
+    modules = {}
+    for module_name, m in model.named_modules():
+        entry = _packed_entry(m)
+        if entry is None:
+            continue
+        kind, module_tensors, params = entry
+        for key, t in module_tensors.items():
+            names.append(module_name + "." + key)
+            tensors.append(t)
+        modules[module_name] = {
+            "kind": kind,
+            "tensors": list(module_tensors.keys()),
+            "params": params,
+        }
+    metadata = json.dumps({"version": _METADATA_VERSION, "modules": modules})
+    torch.ops.torch_ipex.save_packed_weights(path, names, tensors, metadata)
+
+
+def _load_woq(m, tensors, params):
+    ctx = torch.ops.ipex_prepack.weight_only_qlinear_prepack_from_packed(
+        tensors["weight"],
+        params["weight_shape"],
+        tensors["scales"],
+        tensors["zero_points"],
+        tensors.get("bias"),
+        params["batch_size"],
+        params["is_int4"],
+        params["group_size"],
+        params["lowp_mode"],
+        params["num_concats"],
+        params["act_quant_mode"],
+        tensors.get("g_idx"),
+        params["weight_dtype"],
+    )
+    m._op_context = ctx
+    m.weight = ctx.get_weight()
+    m._lowp_mode = params["lowp_mode"]
+    m._num_concats = params["num_concats"]
+    m._act_quant_mode = params["act_quant_mode"]
+    m._group_size = params["group_size"]
+    m._g_idx = tensors.get("g_idx")
+
+
+def _load_tpp(m, tensors):
+    assert m.use_tpp and not m.tpp_fallback, "expect a linear module packed by TPP"
+    for key, t in tensors.items():
+        param = getattr(m, key)
+        assert param is not None, f"expect {key} as saved"
+        assert param.shape == t.shape, f"expect {key} of shape {t.shape} as saved"
+        param.data = t
+
+
+def _load_dnnl(m, tensors, params):
+    assert m.use_dnnl, "expect a linear module packed by oneDNN"
+    ctx = torch.ops.ipex_prepack.linear_prepack_from_packed(
+        tensors["weight"],
+        params["weight_shape"],
+        tensors.get("bias"),
+        params["batch_size"],
+    )
+    m.ctx = ctx
+    m.weight_wrapper.op_ctx = ctx
+    m.weight.data = ctx.get_weight()
+    if m.bias is not None and "bias" in tensors:
+        m.bias.data = tensors["bias"]
+
+
+def load_packed_weights(model, path):
+    r"""
+    Restore the packed weights saved by :func:`save_packed_weights` into
+    ``model``, which has the modules of the saved model under the same names.
+
+    The file is mapped into memory and the weights are views of the mapping,
+    they are neither read nor copied until they are used. The processes
+    loading the same file share its physical pages, unless they write the
+    weights.
+
+    Args:
+        model (torch.nn.Module): The model to restore the weights of.
+        path (str): The file written by :func:`save_packed_weights`.
+
+    Returns:
+        The model.
+    """
+    names, tensors, metadata, isa = torch.ops.torch_ipex.load_packed_weights(path)
+    current_isa = torch.ops.torch_ipex.packed_weight_isa_signature()
+    if isa != current_isa:
+        raise RuntimeError(
+            f"The weights of {path} are packed for ISA {isa}, "
+            f"which differs from {current_isa} of this machine. "
+            "Pack the weights again on this machine."
+        )
+    metadata = json.loads(metadata)
+    if metadata.get("version") != _METADATA_VERSION:
+        raise RuntimeError(f"Unsupported version of the packed weights of {path}")
+    all_tensors = dict(zip(names, tensors))
+    modules = dict(model.named_modules())
+    with torch.no_grad():
+        for module_name, entry in metadata["modules"].items():
+            if module_name not in modules:
+                raise RuntimeError(f"{module_name} of {path} is not in the model")
+            m = modules[module_name]
+            module_tensors = {
+                key: all_tensors[module_name + "." + key] for key in entry["tensors"]
+            }
+            kind = entry["kind"]
+            if kind == "woq":
+                _load_woq(m, module_tensors, entry["params"])
+            elif kind == "tpp":
+                _load_tpp(m, module_tensors)
+            else:
+                _load_dnnl(m, module_tensors, entry["params"])
+    return model
@@ -6,6 +6,11 @@ from torch.ao.quantization import PlaceholderObserver, QConfigMapping
 # The config describes how to load low precision checkpoint for weight only quantization.
 # Weight shape is N by K if transposed is False otherwise K by N.
 # Bias is optional. If bias is not provided in the checkpoint, we read the original model.
+# Optional keys:
+# - "g_idx_key": key of the group index of input channels for checkpoints quantized
+#   with act-order (desc_act). Default is "g_idx".
+# - "weight_bits": bit width of weight and zero points compressed in int32,
+#   2, 3 or 4. Default is 4.
 DEFAULT_LOWP_CHECKPOINT_CONFIG = {
     "name": "default",
     "weight_key": "packed_weight",
@@ -47,18 +52,22 @@ def _get_linear_parameters(attr_name, state_dict, checkpoint_config):
     s_key = attr_name + "." + scales_key
     z_key = attr_name + "." + zeros_key
     b_key = attr_name + "." + bias_key
+    g_key = attr_name + "." + checkpoint_config.get("g_idx_key", "g_idx")
+    weight_bits = checkpoint_config.get("weight_bits", 4)
     # all are tensors
     qweight = state_dict.get(w_key, None)
     scales = state_dict.get(s_key, None)
     qzeros = state_dict.get(z_key, None)
     bias = state_dict.get(b_key, None)
+    g_idx = state_dict.get(g_key, None)
     group_size = -1
     if qweight is not None and scales is not None:
         assert scales.dim() == 2, "Unexpected scales tensor dimension"
         if scales.size(-1) != 1:
-            # qweight is compressed along the last dim int4 * 8 -> int32
-            group_size = qweight.size(-1) * 8 // scales.size(-1)
-    return qweight, scales, qzeros, bias, group_size
+            # qweight is compressed along the last dim,
+            # e.g., int4 * 8 -> int32
+            group_size = qweight.size(-1) * 32 // weight_bits // scales.size(-1)
+    return qweight, scales, qzeros, bias, group_size, g_idx, weight_bits
 
 
 def _convert_woq_with_low_precision_checkpoint(
@@ -114,13 +123,26 @@ def _convert_woq_with_low_precision_checkpoint(
     def _convert(mod, attr_name):
         if isinstance(mod, torch.nn.Linear):
             mod.qconfig = qconfig_mapping.global_qconfig
-            qweight, scales, qzeros, bias, group_size = _get_linear_parameters(
-                attr_name, state_dict, checkpoint_config
-            )
+            (
+                qweight,
+                scales,
+                qzeros,
+                bias,
+                group_size,
+                g_idx,
+                weight_bits,
+            ) = _get_linear_parameters(attr_name, state_dict, checkpoint_config)
             if any(i is None for i in [qweight, scales, qzeros]):
                 return mod
             mod_new = IpexWoqLinear.from_float_and_int4_weight(
-                mod, qweight, scales, qzeros, bias, group_size=group_size
+                mod,
+                qweight,
+                scales,
+                qzeros,
+                bias,
+                group_size=group_size,
+                g_idx=g_idx,
+                weight_bits=weight_bits,
             )
             return mod_new
 
@@ -0,0 +1,73 @@
+# Tune the weight-only quantization GEMM for a list of weight shapes and save
+# the winners to a tuning database, to be loaded with IPEX_WOQ_TUNING_DB.
+# Run it with the same number of threads as the deployment, e.g.
+#   OMP_NUM_THREADS=56 python woq_autotune.py --db woq_tuning.db \
+#       --shapes 4096x4096 11008x4096 --weight-dtype INT4 --group-size 128
+import argparse
+import os
+
+import torch
+import intel_extension_for_pytorch  # noqa: F401
+
+LOWP_MODES = {"NONE": 0, "FP16": 1, "BF16": 2, "INT8": 3}
+WEIGHT_DTYPES = {"INT8": 1, "INT4": 2, "NF4": 3}
+
+
+def parse_shape(shape):
+    n, k = shape.lower().split("x")
+    return int(n), int(k)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Tune the weight-only quantization GEMM of weight shapes"
+    )
+    parser.add_argument("--db", required=True, help="tuning database to update")
+    parser.add_argument(
+        "--shapes",
+        nargs="+",
+        required=True,
+        help="weight shapes as NxK, i.e. out_features x in_features",
+    )
+    parser.add_argument(
+        "--weight-dtype", choices=list(WEIGHT_DTYPES.keys()), default="INT8"
+    )
+    parser.add_argument(
+        "--int4", action="store_true", help="INT4 weight, same as --weight-dtype INT4"
+    )
+    parser.add_argument("--group-size", type=int, default=-1)
+    parser.add_argument(
+        "--lowp-mode", choices=list(LOWP_MODES.keys()), default="BF16"
+    )
+    parser.add_argument(
+        "--m",
+        type=int,
+        nargs="+",
+        default=[1, 4, 32, 128],
+        help="numbers of tokens to tune for",
+    )
+    parser.add_argument(
+        "--dtype", choices=["float32", "bfloat16", "float16"], default="bfloat16"
+    )
+    args = parser.parse_args()
+
+    if os.path.exists(args.db):
+        torch.ops.torch_ipex.woq_tuning_db_load(args.db)
+    weight_dtype = "INT4" if args.int4 else args.weight_dtype
+    for shape in args.shapes:
+        n, k = parse_shape(shape)
+        block_n, block_k = torch.ops.torch_ipex.woq_tune_gemm(
+            n,
+            k,
+            WEIGHT_DTYPES[weight_dtype],
+            args.group_size,
+            LOWP_MODES[args.lowp_mode],
+            args.m,
+            getattr(torch, args.dtype),
+        )
+        print(f"{n}x{k}: block_n={block_n}, block_k={block_k}")
+    torch.ops.torch_ipex.woq_tuning_db_save(args.db)
+
+
+if __name__ == "__main__":
+    main()
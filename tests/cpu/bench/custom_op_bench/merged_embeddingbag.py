@@ -112,6 +112,20 @@ class MergedEmbAdaGrad(torch.nn.Module):
         return self.merged_emb(indices, offsets)
 
 
+class MergedEmbAdam(torch.nn.Module):
+    def __init__(self, emblist, lamb=False, **kwargs):
+        super(MergedEmbAdam, self).__init__()
+        cls = (
+            ipex.nn.modules.MergedEmbeddingBagWithLAMB
+            if lamb
+            else ipex.nn.modules.MergedEmbeddingBagWithAdam
+        )
+        self.merged_emb = cls.from_embeddingbag_list(emblist.list, **kwargs)
+
+    def forward(self, indices, offsets):
+        return self.merged_emb(indices, offsets)
+
+
 def run_bench(bench_name, module, input_data, optimizer=None, training=False):
     iters = 100 if training else 1000
     for i in range(iters):
@@ -272,6 +286,33 @@ def merged_emb_with_adagrad(args, input):
             )
 
 
+def merged_emb_with_adam(args, input):
+    # the lazy moments of the fused Adam are the ones of SparseAdam
+    emblist = EmbeddingBagList(NUM_TABLE, args.vector_size, torch.float32)
+    ref_m = EmbeddingBagList(NUM_TABLE, args.vector_size, torch.float32, sparse=True)
+    ref_m.load_state_dict(emblist.state_dict())
+    opt = torch.optim.SparseAdam(ref_m.parameters(), lr=0.1)
+    assert not args.inference, "the fused Adam is only benchmarked for training"
+    for state_dtype in [None, torch.bfloat16, torch.int8]:
+        for rowwise in [False, True]:
+            m = MergedEmbAdam(
+                copy.deepcopy(emblist), lr=0.1, rowwise=rowwise, state_dtype=state_dtype
+            )
+            run_bench(
+                f"MergedEmbeddingBagWithAdam: rowwise:{rowwise} state_dtype:{state_dtype}",
+                m,
+                input,
+                training=True,
+            )
+    run_bench(
+        "EmbeddingBagList with SparseAdam",
+        ref_m,
+        input,
+        optimizer=opt,
+        training=True,
+    )
+
+
 def get_data(batch_size):
     indices = []
     offsets = []
@@ -332,7 +373,7 @@ def run():
         "--optimizer",
         type=str,
         default="sgd",
-        choices=["sgd", "adagrad"],
+        choices=["sgd", "adagrad", "adam"],
     )
     args = parser.parse_args()
     input_data = get_data(args.batch_size)
@@ -343,8 +384,10 @@ def run():
 
     if args.optimizer == "sgd":
         merged_emb_with_sgd(args, input_data)
-    else:
+    elif args.optimizer == "adagrad":
         merged_emb_with_adagrad(args, input_data)
+    else:
+        merged_emb_with_adam(args, input_data)
 
 
 if __name__ == "__main__":
@@ -0,0 +1,666 @@
+// Micro benchmarks of the kernels behind IPEX_DECLARE_DISPATCH, for each
+// ISA level the kernels are compiled for.
+//
+// Each case calls a torch_ipex op through the dispatcher, while the per stub
+// ISA override pins the dispatch stub of the op to one ISA level at a time.
+// The ISA levels above the levels of the CPU and the binary, and those the
+// stub has no kernel for, are skipped. For each case and ISA it reports the
+// median time, GFLOP/s and GB/s, and the efficiency against the roofline of
+// the peak FLOP/s and memory bandwidth measured at startup.
+//
+// Usage:
+//   ipex_cpp_bench [--filter=<substr>] [--isa=<isa,...>] [--warmup=<n>]
+//                  [--iters=<n>] [--threads=<n>] [--json=<path>]
+//                  [--baseline=<path>] [--threshold=<ratio>]
+//                  [--peak-gbps=<gbps>] [--peak-gflops=<gflops>]
+//
+// --json writes the results, which can be used as the --baseline of a later
+// run. A case of the baseline is regressed if its median time is more than
+// (1 + threshold) times the baseline, 0.1 by default, and the benchmark exits
+// with 1 if any case is regressed.
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <c10/core/InferenceMode.h>
+#include <torch/script.h>
+#include <torch/torch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csrc/cpu/dyndisp/DispatchStub.h"
+
+using namespace torch_ipex::cpu;
+
+namespace {
+
+struct BenchOptions {
+  std::string filter;
+  std::vector<CPUCapability> isa_list;
+  int64_t warmup = 3;
+  int64_t iters = 20;
+  int64_t threads = 0;
+  std::string json_path;
+  std::string baseline_path;
+  double threshold = 0.1;
+  double peak_gbps = 0;
+  double peak_gflops = 0;
+};
+
+struct BenchCase {
+  std::string name;
+  // Dispatch stub of the op, which is pinned to the ISA under test
+  std::string stub;
+  // Data type of the compute, for the peak FLOP/s of the roofline
+  at::ScalarType compute_dtype;
+  double flops;
+  double bytes;
+  std::function<void()> run;
+};
+
+struct BenchResult {
+  std::string name;
+  std::string stub;
+  std::string isa;
+  double time_us;
+  double min_us;
+  double gflops;
+  double gbps;
+  double roofline_us;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_us(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+      .count();
+}
+
+c10::optional<c10::OperatorHandle> find_op(const char* name) {
+  return c10::Dispatcher::singleton().findSchema({name, ""});
+}
+
+// Boxed call with all the arguments of the schema, defaults included
+std::function<void()> boxed_call(
+    const c10::OperatorHandle& op,
+    std::vector<c10::IValue> args) {
+  return [op, args]() {
+    torch::jit::Stack stack(args);
+    op.callBoxed(&stack);
+  };
+}
+
+double element_size(at::ScalarType dtype) {
+  return c10::elementSize(dtype);
+}
+
+const char* dtype_name(at::ScalarType dtype) {
+  return dtype == at::kBFloat16 ? "bf16" : "fp32";
+}
+
+void add_rmsnorm_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::rmsnorm");
+  if (!op) {
+    return;
+  }
+  for (auto dtype : {at::kFloat, at::kBFloat16}) {
+    for (int64_t tokens : {1, 128, 2048}) {
+      int64_t hidden = 4096;
+      auto input = at::randn({tokens, hidden}).to(dtype);
+      auto weight = at::rand({hidden}).to(dtype);
+      std::ostringstream name;
+      name << "rmsnorm/" << dtype_name(dtype) << "/T=" << tokens
+           << ",H=" << hidden;
+      cases.push_back(
+          {name.str(),
+           "rmsnorm_kernel_stub",
+           dtype,
+           4.0 * tokens * hidden,
+           (2.0 * tokens * hidden + hidden) * element_size(dtype),
+           boxed_call(*op, {input, weight, 1e-6})});
+    }
+  }
+}
+
+void add_rope_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::rotary_position_embedding");
+  if (!op) {
+    return;
+  }
+  // LLaMA style rotary embedding of the whole head
+  int64_t num_heads = 32;
+  int64_t head_size = 128;
+  int64_t max_positions = 2048;
+  auto inv_freq = 1.0 /
+      at::pow(10000.0, at::arange(0, head_size, 2).to(at::kFloat) / head_size);
+  auto sinusoid = at::outer(at::arange(max_positions).to(at::kFloat), inv_freq);
+  auto embed_positions = at::cat({at::sin(sinusoid), at::cos(sinusoid)}, 1);
+  for (auto dtype : {at::kFloat, at::kBFloat16}) {
+    for (int64_t seq_len : {1, 2048}) {
+      auto input = at::randn({1, seq_len, num_heads, head_size}).to(dtype);
+      auto position_ids = at::arange(seq_len).unsqueeze(0);
+      double elements = static_cast<double>(seq_len) * num_heads * head_size;
+      std::ostringstream name;
+      name << "rotary_position_embedding/" << dtype_name(dtype)
+           << "/S=" << seq_len << ",N=" << num_heads << ",H=" << head_size;
+      cases.push_back(
+          {name.str(),
+           "rotary_position_embedding_kernel_stub",
+           dtype,
+           3.0 * elements,
+           2.0 * elements * element_size(dtype) +
+               seq_len * head_size * sizeof(float),
+           boxed_call(
+               *op,
+               {input,
+                embed_positions,
+                position_ids,
+                num_heads,
+                head_size,
+                head_size / 2,
+                head_size})});
+    }
+  }
+}
+
+void add_paged_attention_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::single_query_cached_kv_attention");
+  if (!op) {
+    return;
+  }
+  // Decoding of GQA heads, one query per sequence
+  int64_t num_heads = 32;
+  int64_t num_kv_heads = 8;
+  int64_t head_size = 128;
+  int64_t block_size = 16;
+  int64_t context_len = 1024;
+  int64_t blocks_per_seq = context_len / block_size;
+  auto head_mapping = at::arange(num_kv_heads)
+                          .to(at::kInt)
+                          .repeat_interleave(num_heads / num_kv_heads);
+  for (auto dtype : {at::kFloat, at::kBFloat16}) {
+    for (int64_t num_seqs : {1, 16, 64}) {
+      int64_t num_blocks = num_seqs * blocks_per_seq;
+      auto query = at::randn({num_seqs, num_heads, head_size}).to(dtype);
+      auto out = at::empty_like(query);
+      auto key_cache =
+          at::randn({num_blocks, block_size, num_kv_heads, head_size})
+              .to(dtype);
+      auto value_cache = at::randn_like(key_cache);
+      auto block_tables =
+          at::randperm(num_blocks).to(at::kInt).view({num_seqs, -1});
+      auto context_lens = at::full({num_seqs}, context_len, at::kInt);
+      double kv_elements =
+          2.0 * num_seqs * num_kv_heads * context_len * head_size;
+      std::ostringstream name;
+      name << "paged_attention/" << dtype_name(dtype) << "/seqs=" << num_seqs
+           << ",ctx=" << context_len << ",N=" << num_heads
+           << ",N_kv=" << num_kv_heads << ",H=" << head_size;
+      cases.push_back(
+          {name.str(),
+           "single_query_cached_kv_attention_kernel_stub",
+           dtype,
+           4.0 * num_seqs * num_heads * context_len * head_size,
+           (kv_elements + 2.0 * query.numel()) * element_size(dtype),
+           boxed_call(
+               *op,
+               {out,
+                query,
+                key_cache,
+                value_cache,
+                head_mapping,
+                1.0 / std::sqrt(static_cast<double>(head_size)),
+                block_tables,
+                context_lens,
+                block_size,
+                context_len,
+                c10::IValue()})});
+    }
+  }
+}
+
+void add_woq_linear_cases(std::vector<BenchCase>& cases) {
+  // Only built with libxsmm
+  auto prepack = find_op("ipex_prepack::weight_only_qlinear_prepack");
+  auto op = find_op("torch_ipex::ipex_woq_linear");
+  if (!prepack || !op) {
+    return;
+  }
+  int64_t N = 4096;
+  int64_t K = 4096;
+  auto weight = at::randint(-128, 128, {N, K}).to(at::kChar);
+  auto scales = at::rand({N}) * 0.01 + 0.001;
+  auto zero_points = at::zeros({N});
+  // Per channel INT8 weight, BF16 compute
+  int64_t lowp_mode = 2;
+  torch::jit::Stack stack{
+      weight,
+      std::vector<int64_t>{N, K},
+      scales,
+      zero_points,
+      c10::IValue(),
+      c10::IValue(),
+      false,
+      -1,
+      lowp_mode,
+      1,
+      0,
+      c10::IValue(),
+      0};
+  prepack->callBoxed(&stack);
+  auto op_context = torch::jit::Object(stack[0].toObject());
+  auto packed_weight = op_context.run_method("get_data_handle").toTensor();
+  for (int64_t M : {1, 32, 256}) {
+    auto input = at::randn({M, K}).to(at::kBFloat16);
+    std::ostringstream name;
+    name << "woq_linear/int8_bf16/M=" << M << ",N=" << N << ",K=" << K;
+    cases.push_back(
+        {name.str(),
+         "woq_tpp_gemm_kernel_stub",
+         at::kBFloat16,
+         2.0 * M * N * K,
+         N * K + 2.0 * N * sizeof(float) + (M * K + M * N) * 2.0,
+         boxed_call(*op, {input, packed_weight})});
+  }
+}
+
+void add_embedding_bag_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::embedding_bag");
+  if (!op) {
+    return;
+  }
+  int64_t num_rows = 200000;
+  int64_t num_bags = 2048;
+  int64_t pooling = 32;
+  for (int64_t dim : {64, 128}) {
+    auto weight = at::randn({num_rows, dim});
+    auto indices = at::randint(num_rows, {num_bags * pooling});
+    auto offsets = at::arange(0, num_bags * pooling + 1, pooling);
+    double lookups = static_cast<double>(num_bags) * pooling;
+    std::ostringstream name;
+    name << "embedding_bag/fp32/bags=" << num_bags << ",pooling=" << pooling
+         << ",D=" << dim;
+    cases.push_back(
+        {name.str(),
+         "embedding_bag_kernel_stub",
+         at::kFloat,
+         lookups * dim,
+         lookups * (dim * sizeof(float) + sizeof(int64_t)) +
+             num_bags * dim * sizeof(float),
+         boxed_call(*op, {weight, indices, offsets, false, true})});
+  }
+}
+
+void add_nms_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::nms");
+  if (!op) {
+    return;
+  }
+  for (int64_t num_boxes : {1000, 5000}) {
+    auto corners = at::rand({num_boxes, 2}) * 1000;
+    auto sizes = at::rand({num_boxes, 2}) * 90 + 10;
+    auto dets = at::cat({corners, corners + sizes}, 1);
+    auto scores = at::rand({num_boxes});
+    std::ostringstream name;
+    name << "nms/fp32/boxes=" << num_boxes;
+    // IoU of all the pairs, an upper bound of the suppression
+    cases.push_back(
+        {name.str(),
+         "nms_cpu_kernel_stub",
+         at::kFloat,
+         10.0 * num_boxes * num_boxes / 2,
+         num_boxes * 5.0 * sizeof(float),
+         boxed_call(*op, {dets, scores, 0.5, false})});
+  }
+}
+
+void add_flash_attention_cases(std::vector<BenchCase>& cases) {
+  auto op = find_op("torch_ipex::flash_attention");
+  if (!op) {
+    return;
+  }
+  int64_t num_heads = 32;
+  int64_t head_size = 128;
+  for (auto dtype : {at::kFloat, at::kBFloat16}) {
+    for (int64_t seq_len : {512, 2048}) {
+      auto query = at::randn({1, num_heads, seq_len, head_size}).to(dtype);
+      auto key = at::randn_like(query);
+      auto value = at::randn_like(query);
+      double elements = static_cast<double>(num_heads) * seq_len * head_size;
+      std::ostringstream name;
+      name << "flash_attention/" << dtype_name(dtype) << "/L=" << seq_len
+           << ",N=" << num_heads << ",H=" << head_size;
+      cases.push_back(
+          {name.str(),
+           "flash_attention_kernel_stub",
+           dtype,
+           4.0 * elements * seq_len,
+           4.0 * elements * element_size(dtype),
+           boxed_call(
+               *op,
+               {query, key, value, 0.0, false, c10::IValue(), c10::IValue()})});
+    }
+  }
+}
+
+double measure_peak_gbps() {
+  // 256MB copies, read and write
+  auto src = at::rand({64 << 20});
+  auto dst = at::empty_like(src);
+  dst.copy_(src);
+  double best_us = 0;
+  for (int i = 0; i < 5; i++) {
+    auto start = Clock::now();
+    dst.copy_(src);
+    auto us = elapsed_us(start);
+    best_us = i == 0 ? us : std::min(best_us, us);
+  }
+  return 2.0 * src.nbytes() / best_us / 1e3;
+}
+
+double measure_peak_gflops(at::ScalarType dtype) {
+  int64_t size = 2048;
+  auto a = at::rand({size, size}).to(dtype);
+  auto b = at::rand({size, size}).to(dtype);
+  auto c = at::mm(a, b);
+  double best_us = 0;
+  for (int i = 0; i < 5; i++) {
+    auto start = Clock::now();
+    at::mm_out(c, a, b);
+    auto us = elapsed_us(start);
+    best_us = i == 0 ? us : std::min(best_us, us);
+  }
+  return 2.0 * size * size * size / best_us / 1e3;
+}
+
+// ISA of the kernel the stub dispatches to, NUM_OPTIONS if the stub is not
+// called by the case
+CPUCapability dispatched_isa(const BenchCase& bench_case) {
+  set_dispatch_telemetry_enabled(true);
+  reset_dispatch_stats();
+  bench_case.run();
+  set_dispatch_telemetry_enabled(false);
+  for (const auto& stats : get_dispatch_stats()) {
+    if (stats.stub_name == bench_case.stub) {
+      return stats.isa;
+    }
+  }
+  return CPUCapability::NUM_OPTIONS;
+}
+
+BenchResult run_case(
+    const BenchCase& bench_case,
+    CPUCapability isa,
+    const BenchOptions& options,
+    const std::map<at::ScalarType, double>& peak_gflops) {
+  for (int64_t i = 0; i < options.warmup; i++) {
+    bench_case.run();
+  }
+  std::vector<double> samples;
+  for (int64_t i = 0; i < options.iters; i++) {
+    auto start = Clock::now();
+    bench_case.run();
+    samples.push_back(elapsed_us(start));
+  }
+  std::sort(samples.begin(), samples.end());
+  BenchResult result;
+  result.name = bench_case.name;
+  result.stub = bench_case.stub;
+  result.isa = CPUCapabilityToString(isa);
+  result.time_us = samples[samples.size() / 2];
+  result.min_us = samples[0];
+  result.gflops = bench_case.flops / result.time_us / 1e3;
+  result.gbps = bench_case.bytes / result.time_us / 1e3;
+  result.roofline_us = std::max(
+      bench_case.flops / peak_gflops.at(bench_case.compute_dtype) / 1e3,
+      bench_case.bytes / options.peak_gbps / 1e3);
+  return result;
+}
+
+void write_json(
+    const std::string& path,
+    const BenchOptions& options,
+    const std::map<at::ScalarType, double>& peak_gflops,
+    const std::vector<BenchResult>& results) {
+  std::ofstream out(path);
+  out << "{\n";
+  out << "  \"num_threads\": " << at::get_num_threads() << ",\n";
+  out << "  \"peak_gbps\": " << options.peak_gbps << ",\n";
+  out << "  \"peak_gflops_fp32\": " << peak_gflops.at(at::kFloat) << ",\n";
+  out << "  \"peak_gflops_bf16\": " << peak_gflops.at(at::kBFloat16) << ",\n";
+  out << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto& r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"stub\": \"" << r.stub
+        << "\", \"isa\": \"" << r.isa << "\", \"time_us\": " << r.time_us
+        << ", \"min_us\": " << r.min_us << ", \"gflops\": " << r.gflops
+        << ", \"gbps\": " << r.gbps << ", \"roofline_us\": " << r.roofline_us
+        << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+// Median times of the "results" of a file written by write_json, by the name
+// and the ISA of the cases. Only the flat objects of strings and numbers of
+// write_json are parsed.
+std::map<std::pair<std::string, std::string>, double> read_baseline(
+    const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Fail to open the baseline " + path);
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  auto text = buffer.str();
+  std::map<std::pair<std::string, std::string>, double> baseline;
+  auto pos = text.find("\"results\"");
+  if (pos == std::string::npos) {
+    throw std::runtime_error("No results in the baseline " + path);
+  }
+  auto read_string = [&](size_t& p) {
+    auto end = text.find('"', p + 1);
+    auto s = text.substr(p + 1, end - p - 1);
+    p = end + 1;
+    return s;
+  };
+  while ((pos = text.find_first_of("{]", pos)) != std::string::npos &&
+         text[pos] == '{') {
+    std::map<std::string, std::string> record;
+    pos++;
+    while ((pos = text.find_first_of("\"}", pos)) != std::string::npos &&
+           text[pos] == '"') {
+      auto key = read_string(pos);
+      pos = text.find_first_not_of(" :", pos);
+      if (text[pos] == '"') {
+        record[key] = read_string(pos);
+      } else {
+        auto end = text.find_first_of(",}", pos);
+        record[key] = text.substr(pos, end - pos);
+        pos = end;
+      }
+    }
+    if (record.count("name") && record.count("isa") &&
+        record.count("time_us")) {
+      baseline[{record["name"], record["isa"]}] =
+          std::stod(record["time_us"]);
+    }
+  }
+  return baseline;
+}
+
+std::vector<std::string> split(const std::string& s, char delimiter) {
+  std::vector<std::string> parts;
+  std::stringstream stream(s);
+  std::string part;
+  while (std::getline(stream, part, delimiter)) {
+    if (!part.empty()) {
+      parts.push_back(part);
+    }
+  }
+  return parts;
+}
+
+BenchOptions parse_options(int argc, char** argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto eq = arg.find('=');
+    auto key = arg.substr(0, eq);
+    auto value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    if (key == "--filter") {
+      options.filter = value;
+    } else if (key == "--isa") {
+      for (const auto& name : split(value, ',')) {
+        auto isa = CPUCapabilityFromString(name);
+        if (isa == CPUCapability::NUM_OPTIONS) {
+          throw std::runtime_error("Unknown ISA " + name);
+        }
+        options.isa_list.push_back(isa);
+      }
+    } else if (key == "--warmup") {
+      options.warmup = std::stol(value);
+    } else if (key == "--iters") {
+      options.iters = std::max(1L, std::stol(value));
+    } else if (key == "--threads") {
+      options.threads = std::stol(value);
+    } else if (key == "--json") {
+      options.json_path = value;
+    } else if (key == "--baseline") {
+      options.baseline_path = value;
+    } else if (key == "--threshold") {
+      options.threshold = std::stod(value);
+    } else if (key == "--peak-gbps") {
+      options.peak_gbps = std::stod(value);
+    } else if (key == "--peak-gflops") {
+      options.peak_gflops = std::stod(value);
+    } else {
+      throw std::runtime_error("Unknown option " + arg);
+    }
+  }
+  if (options.isa_list.empty()) {
+    for (int32_t i = 0; i < kNumCPUCapabilities; i++) {
+      options.isa_list.push_back(static_cast<CPUCapability>(i));
+    }
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  auto options = parse_options(argc, argv);
+  if (options.threads > 0) {
+    at::set_num_threads(options.threads);
+  }
+  c10::InferenceMode guard;
+
+  std::map<at::ScalarType, double> peak_gflops;
+  if (options.peak_gflops > 0) {
+    peak_gflops[at::kFloat] = options.peak_gflops;
+    peak_gflops[at::kBFloat16] = options.peak_gflops;
+  } else {
+    peak_gflops[at::kFloat] = measure_peak_gflops(at::kFloat);
+    peak_gflops[at::kBFloat16] = measure_peak_gflops(at::kBFloat16);
+  }
+  if (options.peak_gbps <= 0) {
+    options.peak_gbps = measure_peak_gbps();
+  }
+  printf(
+      "threads: %d, peak GB/s: %.1f, peak GFLOP/s: %.1f (fp32) %.1f (bf16)\n",
+      at::get_num_threads(),
+      options.peak_gbps,
+      peak_gflops[at::kFloat],
+      peak_gflops[at::kBFloat16]);
+
+  std::vector<BenchCase> cases;
+  add_rmsnorm_cases(cases);
+  add_rope_cases(cases);
+  add_paged_attention_cases(cases);
+  add_woq_linear_cases(cases);
+  add_embedding_bag_cases(cases);
+  add_nms_cases(cases);
+  add_flash_attention_cases(cases);
+
+  printf(
+      "%-64s %-12s %12s %12s %10s %10s %8s\n",
+      "case",
+      "isa",
+      "median(us)",
+      "min(us)",
+      "GFLOP/s",
+      "GB/s",
+      "roof(%)");
+  std::vector<BenchResult> results;
+  for (const auto& bench_case : cases) {
+    if (bench_case.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    std::set<CPUCapability> done;
+    for (auto isa : options.isa_list) {
+      set_dispatch_isa_override(bench_case.stub, isa);
+      auto actual = dispatched_isa(bench_case);
+      // Capped by the CPU, or no kernel of the ISA
+      if (actual != isa || done.count(actual)) {
+        continue;
+      }
+      done.insert(actual);
+      auto result = run_case(bench_case, actual, options, peak_gflops);
+      printf(
+          "%-64s %-12s %12.2f %12.2f %10.1f %10.1f %8.1f\n",
+          result.name.c_str(),
+          result.isa.c_str(),
+          result.time_us,
+          result.min_us,
+          result.gflops,
+          result.gbps,
+          100 * result.roofline_us / result.time_us);
+      results.push_back(result);
+    }
+    clear_dispatch_isa_override(bench_case.stub);
+    if (done.empty()) {
+      printf(
+          "%-64s skipped, %s is not called\n",
+          bench_case.name.c_str(),
+          bench_case.stub.c_str());
+    }
+  }
+
+  if (!options.json_path.empty()) {
+    write_json(options.json_path, options, peak_gflops, results);
+  }
+
+  int num_regressions = 0;
+  if (!options.baseline_path.empty()) {
+    auto baseline = read_baseline(options.baseline_path);
+    for (const auto& result : results) {
+      auto it = baseline.find({result.name, result.isa});
+      if (it == baseline.end()) {
+        continue;
+      }
+      if (result.time_us > it->second * (1 + options.threshold)) {
+        printf(
+            "REGRESSION %s [%s]: %.2f us -> %.2f us (+%.1f%%)\n",
+            result.name.c_str(),
+            result.isa.c_str(),
+            it->second,
+            result.time_us,
+            100 * (result.time_us / it->second - 1));
+        num_regressions++;
+      }
+    }
+    printf(
+        "%d regressions of %zu baseline cases\n",
+        num_regressions,
+        baseline.size());
+  }
+  return num_regressions > 0 ? 1 : 0;
+}
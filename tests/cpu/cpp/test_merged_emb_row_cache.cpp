@@ -0,0 +1,104 @@
+#include <vector>
+#include "csrc/cpu/aten/MergedEmbeddingBag.h"
+#include "gtest/gtest.h"
+
+using torch_ipex::cpu::EmbeddingRowCache;
+
+TEST(TestEmbeddingRowCache, TestMixedEmbDim) {
+  EmbeddingRowCache<float> cache;
+  std::vector<int32_t> dims = {4, 100, 7, 1, 64};
+  for (int64_t key = 0; key < 50; key++) {
+    auto dim = dims[key % dims.size()];
+    float* row = cache.emplace(key * 3, dim);
+    for (int32_t i = 0; i < dim; i++) {
+      ASSERT_EQ(row[i], 0.f);
+      row[i] = key * 1000 + i;
+    }
+  }
+  ASSERT_EQ(cache.size(), 50);
+  // the rows do not overlap, and are listed in the order of their emplace
+  int64_t key = 0;
+  for (auto& [row_id, row] : cache.cache()) {
+    ASSERT_EQ(row_id, key * 3);
+    ASSERT_EQ(cache.find(row_id), row);
+    for (int32_t i = 0; i < dims[key % dims.size()]; i++) {
+      ASSERT_EQ(row[i], key * 1000 + i);
+    }
+    key++;
+  }
+  float data[7] = {1, 2, 3, 4, 5, 6, 7};
+  float* row = cache.emplace(1, data, 7);
+  ASSERT_EQ(row[6], 7.f);
+  // an emplace of a cached row returns it
+  ASSERT_EQ(cache.emplace(1, 7), row);
+  ASSERT_EQ(cache.size(), 51);
+}
+
+TEST(TestEmbeddingRowCache, TestIndexGrowth) {
+  EmbeddingRowCache<double> cache;
+  std::vector<double*> rows;
+  // strided keys, as those of a per-thread cache
+  for (int64_t key = 0; key < 10000; key++) {
+    rows.push_back(cache.emplace(key * 56, 8));
+    rows.back()[0] = key;
+  }
+  for (int64_t key = 0; key < 10000; key++) {
+    // the rows did not move as the arena and the index grew
+    ASSERT_EQ(cache.find(key * 56), rows[key]);
+    ASSERT_EQ(rows[key][0], key);
+  }
+  ASSERT_EQ(cache.find(1), nullptr);
+  ASSERT_EQ(cache.find(-56), nullptr);
+}
+
+TEST(TestEmbeddingRowCache, TestClearAndReuse) {
+  EmbeddingRowCache<float> cache;
+  ASSERT_EQ(cache.find(0), nullptr);
+  for (int iter = 0; iter < 3; iter++) {
+    for (int64_t key = 0; key < 1000; key++) {
+      float* row = cache.emplace(key, 16);
+      ASSERT_EQ(row[15], 0.f);
+      row[15] = 1.f;
+    }
+    auto capacity = cache.capacity();
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0);
+    ASSERT_TRUE(cache.cache().empty());
+    ASSERT_EQ(cache.find(0), nullptr);
+    ASSERT_EQ(cache.find(999), nullptr);
+    // the arena is kept, merged into one block
+    ASSERT_EQ(cache.capacity(), capacity);
+  }
+  // rows of another emb_dim in the reused arena
+  float* row = cache.emplace(5, 3);
+  ASSERT_EQ(row[0], 0.f);
+  ASSERT_EQ(cache.find(5), row);
+  ASSERT_EQ(cache.size(), 1);
+}
+
+TEST(TestEmbeddingRowCache, TestShrinkAndRelease) {
+  using Cache = EmbeddingRowCache<float>;
+  Cache cache;
+  for (int64_t key = 0; key < 10000; key++) {
+    cache.emplace(key, 64);
+  }
+  auto large = cache.capacity();
+  ASSERT_GE(large, 10000 * 64);
+  for (int iter = 0; iter < 2 * Cache::kShrinkPeriod; iter++) {
+    cache.clear();
+    for (int64_t key = 0; key < 10; key++) {
+      ASSERT_EQ(cache.emplace(key, 64)[63], 0.f);
+    }
+    ASSERT_EQ(cache.find(10), nullptr);
+  }
+  // shrunk once the large iteration left the shrink period
+  ASSERT_LE(cache.capacity(), 2 * 10 * 64);
+  for (int64_t key = 0; key < 10; key++) {
+    ASSERT_NE(cache.find(key), nullptr);
+  }
+  cache.release();
+  ASSERT_EQ(cache.capacity(), 0);
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_EQ(cache.find(0), nullptr);
+  ASSERT_EQ(cache.emplace(0, 4)[3], 0.f);
+}
@@ -1,4 +1,5 @@
 #include <torch/torch.h>
+#include "csrc/cpu/runtime/BatchingTask.h"
 #include "csrc/cpu/runtime/CPUPool.h"
 #include "csrc/cpu/runtime/Task.h"
 #include "csrc/cpu/runtime/TaskExecutor.h"
@@ -430,3 +431,117 @@ TEST(TestRuntimeTaskAPI, TestTaskAPISameTasksMultiTensorInputs) {
   ASSERT_VARIABLE_EQ(res, res_ref);
   ASSERT_VARIABLE_EQ(res2, res_ref2);
 }
+
+TEST(TestRuntimeTaskAPI, TestTaskAPIMultiWorkers) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP()
+        << "Skip TestRuntimeTaskAPI::TestTaskAPIMultiWorkers. Didn't preload IOMP.";
+  }
+  std::vector<int32_t> cpu_core_list =
+      torch_ipex::runtime::get_process_available_cores();
+  if (cpu_core_list.size() < 2) {
+    GTEST_SKIP()
+        << "Skip TestRuntimeTaskAPI::TestTaskAPIMultiWorkers. Need 2 cores.";
+  }
+  cpu_core_list.resize(2);
+  torch_ipex::runtime::CPUPool cpu_pool(cpu_core_list);
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(cpu_pool, 2);
+  ASSERT_EQ(task_executor->get_num_workers(), 2);
+
+  std::vector<at::Tensor> input_tensors;
+  for (int i = 0; i < 16; i++) {
+    input_tensors.push_back(at::rand({100, 8276}));
+  }
+  torch_ipex::runtime::
+      Task<at::Tensor (*)(const at::Tensor&), const at::Tensor&>
+          task(taskfunction_const_lvalue_reference, task_executor);
+  std::vector<std::future<at::Tensor>> res_futures;
+  for (auto& input_tensor : input_tensors) {
+    res_futures.push_back(task(input_tensor));
+  }
+  for (size_t i = 0; i < input_tensors.size(); i++) {
+    ASSERT_VARIABLE_EQ(
+        res_futures[i].get(), at::softmax(input_tensors[i], -1));
+  }
+}
+
+TEST(TestRuntimeTaskAPI, TestTaskAPIPriorityAndCancellation) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP()
+        << "Skip TestRuntimeTaskAPI::TestTaskAPIPriorityAndCancellation. Didn't preload IOMP.";
+  }
+  std::vector<int32_t> cpu_core_list({0});
+  torch_ipex::runtime::CPUPool cpu_pool(cpu_core_list);
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(cpu_pool);
+
+  // Hold the only worker, so that the following tasks are queued
+  std::promise<void> gate;
+  std::shared_future<void> gate_future = gate.get_future().share();
+  task_executor->submit([gate_future]() { gate_future.wait(); });
+
+  std::vector<int> order;
+  std::mutex order_mutex;
+  auto record = [&](int id) {
+    return [&, id]() {
+      std::lock_guard<std::mutex> lock(order_mutex);
+      order.push_back(id);
+    };
+  };
+  task_executor->submit(record(2), torch_ipex::runtime::TaskPriority::kLow);
+  task_executor->submit(record(0), torch_ipex::runtime::TaskPriority::kHigh);
+  task_executor->submit(record(1), torch_ipex::runtime::TaskPriority::kNormal);
+
+  torch_ipex::runtime::Task<at::Tensor (*)(const at::Tensor&), const at::Tensor&>
+      task(taskfunction_const_lvalue_reference, task_executor);
+  at::Tensor input_tensor = at::rand({100, 8276});
+  auto cancellation = std::make_shared<torch_ipex::runtime::TaskCancellation>();
+  auto cancelled_future = task.submit(cancellation, input_tensor);
+  auto res_future = task(input_tensor);
+  cancellation->cancel();
+  gate.set_value();
+
+  ASSERT_VARIABLE_EQ(res_future.get(), at::softmax(input_tensor, -1));
+  ASSERT_THROW(cancelled_future.get(), std::future_error);
+  task_executor->stop_executor();
+  ASSERT_EQ(order, std::vector<int>({0, 1, 2}));
+}
+
+TEST(TestRuntimeTaskAPI, TestBatchingTaskAPI) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP()
+        << "Skip TestRuntimeTaskAPI::TestBatchingTaskAPI. Didn't preload IOMP.";
+  }
+  std::vector<int32_t> cpu_core_list({0});
+  torch_ipex::runtime::CPUPool cpu_pool(cpu_core_list);
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(cpu_pool);
+  std::atomic<int> num_batches{0};
+  torch_ipex::runtime::BatchingPolicy policy;
+  policy.max_batch_size = 4;
+  policy.max_delay_us = 100000;
+  policy.pad_dim = 1;
+  policy.output_pad_dim = 1;
+  torch_ipex::runtime::BatchingTask task(
+      [&](std::vector<at::Tensor> inputs) -> std::vector<at::Tensor> {
+        num_batches++;
+        return {at::softmax(inputs[0], -1) * 2};
+      },
+      task_executor,
+      policy);
+
+  std::vector<at::Tensor> input_tensors;
+  std::vector<std::future<std::vector<at::Tensor>>> res_futures;
+  for (int64_t length : {3, 7, 5, 2}) {
+    input_tensors.push_back(at::rand({1, length, 16}));
+    res_futures.push_back(task({input_tensors.back()}));
+  }
+  for (size_t i = 0; i < input_tensors.size(); i++) {
+    auto res = res_futures[i].get();
+    ASSERT_EQ(res.size(), 1);
+    ASSERT_VARIABLE_EQ(res[0], at::softmax(input_tensors[i], -1) * 2);
+  }
+  // The 4 requests fill one batch before the delay
+  ASSERT_EQ(num_batches, 1);
+}
@@ -860,6 +860,58 @@ class CPUOPsTester(TestCase):
         self.assertTrue(x_bf16.grad.dtype == torch.bfloat16)
         self.assertEqual(x_bf16.grad, x2.grad, prec=prec)
 
+    def test_group_norm_silu(self):
+        def helper(size, groups, memory_format, dtype, with_other):
+            channels = size[1]
+            x = torch.randn(size).to(dtype, memory_format=memory_format)
+            other = torch.randn(size).to(dtype, memory_format=memory_format)
+            grad = torch.randn(size).to(dtype, memory_format=memory_format)
+            weight = torch.rand(channels)
+            bias = torch.rand(channels)
+
+            x1 = x.clone().requires_grad_()
+            other1 = other.clone().requires_grad_() if with_other else None
+            weight1 = weight.clone().requires_grad_()
+            bias1 = bias.clone().requires_grad_()
+            y1 = torch.ops.torch_ipex.group_norm_silu(
+                x1, groups, weight1, bias1, other1, 1e-5
+            )
+            y1.backward(grad)
+
+            x2 = x.clone().float().requires_grad_()
+            other2 = other.clone().float().requires_grad_()
+            weight2 = weight.clone().requires_grad_()
+            bias2 = bias.clone().requires_grad_()
+            y2 = F.silu(F.group_norm(x2, groups, weight2, bias2, 1e-5))
+            if with_other:
+                y2 = y2 + other2
+            y2.backward(grad.float())
+
+            prec = 2e-2 if dtype == torch.bfloat16 else None
+            self.assertTrue(y1.dtype == dtype)
+            self.assertTrue(y1.is_contiguous(memory_format=memory_format))
+            self.assertEqual(y1, y2, prec=prec)
+            self.assertEqual(x1.grad, x2.grad, prec=prec)
+            self.assertEqual(weight1.grad, weight2.grad, prec=prec)
+            self.assertEqual(bias1.grad, bias2.grad, prec=prec)
+            if with_other:
+                self.assertEqual(other1.grad, other2.grad, prec=prec)
+
+        for dtype, with_other in itertools.product(
+            [torch.float, torch.bfloat16], [False, True]
+        ):
+            helper((2, 64, 8, 8), 32, torch.contiguous_format, dtype, with_other)
+            helper((2, 30, 9, 9), 3, torch.contiguous_format, dtype, with_other)
+            helper((2, 64, 8, 8), 32, torch.channels_last, dtype, with_other)
+            helper((2, 30, 40, 40), 3, torch.channels_last, dtype, with_other)
+            helper((2, 18, 4, 5, 6), 3, torch.channels_last_3d, dtype, with_other)
+
+        # inference without autograd
+        x = torch.randn(2, 64, 8, 8)
+        with torch.no_grad():
+            y = torch.ops.torch_ipex.group_norm_silu(x, 32, None, None, None, 1e-5)
+        self.assertEqual(y, F.silu(F.group_norm(x, 32)))
+
     def test_avg_pool2d(self):
         def helper(self, m, x):
             x1 = x.clone().detach().requires_grad_()
@@ -1483,6 +1535,86 @@ class CPUOPsTester(TestCase):
                         math_ref = math_ref.to(dtype)
                     torch.testing.assert_close(actual, math_ref, atol=atol, rtol=rtol)
 
+    def test_int8_flash_attention(self):
+        def quantize(x, dim=None):
+            # symmetric per tensor, or per head along dim 1
+            amax = x.abs().amax() if dim is None else x.abs().amax(dim=(0, 2, 3))
+            scale = amax / 127
+            view = scale if dim is None else scale.view(1, -1, 1, 1)
+            return (x / view).round().clamp(-128, 127).to(torch.int8), scale
+
+        for per_head, causal, has_attention_mask, output_int8 in itertools.product(
+            [False, True], [False, True], [False, True], [False, True]
+        ):
+            if causal and has_attention_mask:
+                continue
+            for batch_size, seq_len, n_head, head_dim in itertools.product(
+                [2], [1, 129, 533], [3], [16, 64]
+            ):
+                shape = (batch_size, n_head, seq_len, head_dim)
+                q, k, v = (torch.randn(shape) for _ in range(3))
+                dim = 1 if per_head else None
+                (q8, q_scale), (k8, k_scale), (v8, v_scale) = (
+                    quantize(t, dim) for t in (q, k, v)
+                )
+                mask = (
+                    torch.randn(batch_size, 1, seq_len, seq_len)
+                    if has_attention_mask
+                    else None
+                )
+
+                def dequant(x8, scale):
+                    return x8.float() * (scale.view(1, -1, 1, 1) if per_head else scale)
+
+                math_ref = torch._scaled_dot_product_attention_math(
+                    dequant(q8, q_scale),
+                    dequant(k8, k_scale),
+                    dequant(v8, v_scale),
+                    attn_mask=mask,
+                    dropout_p=0.0,
+                    is_causal=causal,
+                )[0]
+                output_scale = (
+                    math_ref.abs().max().item() / 127 if output_int8 else None
+                )
+                actual = torch.ops.torch_ipex.int8_flash_attention(
+                    q8,
+                    k8,
+                    v8,
+                    q_scale,
+                    k_scale,
+                    v_scale,
+                    causal,
+                    attention_mask=mask,
+                    output_scale=output_scale,
+                )
+                if output_int8:
+                    self.assertEqual(actual.dtype, torch.int8)
+                    actual = actual.float() * output_scale
+                else:
+                    self.assertEqual(actual.dtype, torch.bfloat16)
+                    actual = actual.float()
+                # error of the u8 probabilities and of the output quantization
+                torch.testing.assert_close(actual, math_ref, atol=3e-2, rtol=5e-2)
+
+    def test_int8_flash_attention_full_range(self):
+        # adjacent products of 255 * 127 overflow int16 without VNNI/AMX
+        shape = (1, 2, 64, 64)
+        sign = torch.randint(0, 2, shape, dtype=torch.int8) * 2 - 1
+        q8 = torch.full(shape, 127, dtype=torch.int8)
+        k8, v8 = sign * 127, (sign * 127).flip(-1)
+        scale = torch.tensor(0.01)
+        math_ref = torch._scaled_dot_product_attention_math(
+            q8.float() * scale,
+            k8.float() * scale,
+            v8.float() * scale,
+            dropout_p=0.0,
+        )[0]
+        actual = torch.ops.torch_ipex.int8_flash_attention(
+            q8, k8, v8, scale, scale, scale, False
+        )
+        torch.testing.assert_close(actual.float(), math_ref, atol=3e-2, rtol=5e-2)
+
 
 if __name__ == "__main__":
     test = unittest.main()
@@ -148,6 +148,65 @@ class DistMergedEmbeddingTester(TestCase):
                         )
         dist.destroy_process_group()
 
+    def test_backward_merge_adam_update(self):
+        # the merge and update of a single rank match the fused update of the
+        # merged embedding, without sparse all to all
+        NUM_TABLE = 3
+        NUM_DIM = 65
+        B = 32
+        indices = [
+            torch.randint(1000, (B * self.multi_hot[i],)) for i in range(NUM_TABLE)
+        ]
+        offsets = [
+            torch.arange(0, B * self.multi_hot[i], self.multi_hot[i])
+            for i in range(NUM_TABLE)
+        ]
+        row_offset = [1000 * i for i in range(NUM_TABLE + 1)]
+        grad = torch.randn(B, NUM_TABLE, NUM_DIM)
+        for update in ["adam", "rowwise_adam", "lamb"]:
+            weights = [torch.randn(1000, NUM_DIM) for _ in range(NUM_TABLE)]
+            exp_avg = [torch.zeros_like(w) for w in weights]
+            exp_avg_sq = [
+                torch.zeros(1000) if update == "rowwise_adam" else torch.zeros_like(w)
+                for w in weights
+            ]
+            trails = [torch.empty(0, dtype=torch.bfloat16) for _ in weights]
+            weight_allin1 = torch.cat(weights)
+            exp_avg_allin1 = torch.cat(exp_avg)
+            exp_avg_sq_allin1 = torch.cat(exp_avg_sq)
+            hparams = (1, 0.9, 0.999, 1e-8, 0.1, 0.01)
+            getattr(torch.ops.torch_ipex, "merged_embeddingbag_backward_" + update)(
+                [grad[:, i].contiguous() for i in range(NUM_TABLE)],
+                weights,
+                indices,
+                offsets,
+                0,
+                False,
+                exp_avg,
+                exp_avg_sq,
+                trails,
+                *hparams,
+            )
+            idx, val, ofs = torch.ops.torch_ipex.mergedemb_distribute_backward_local(
+                grad, row_offset, indices, offsets, 0, 1, False
+            )
+            getattr(
+                torch.ops.torch_ipex,
+                "mergedemb_distribute_backward_merge_%s_update" % update,
+            )(
+                idx,
+                val,
+                ofs,
+                weight_allin1,
+                trails[0],
+                exp_avg_allin1,
+                exp_avg_sq_allin1,
+                *hparams,
+            )
+            self.assertEqual(weight_allin1, torch.cat(weights))
+            self.assertEqual(exp_avg_allin1, torch.cat(exp_avg))
+            self.assertEqual(exp_avg_sq_allin1, torch.cat(exp_avg_sq))
+
 
 if __name__ == "__main__":
     test = unittest.main()
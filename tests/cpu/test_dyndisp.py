@@ -117,6 +117,63 @@ class TestDynDisp(unittest.TestCase):
             cur_ipex_isa_1 = str(out[-1], "utf-8").strip()
             self.assertTrue(cur_ipex_isa == cur_ipex_isa_1)
 
+    def test_dispatch_isa_override(self):
+        stub = "get_current_isa_level_kernel_stub"
+        cur_isa = get_currnet_isa_level()
+        try:
+            core._set_dispatch_isa_override(stub, "default")
+            self.assertEqual(get_currnet_isa_level(), "default")
+            # capped by the levels of the cpu and the binary
+            core._set_dispatch_isa_override(stub, "avx512_fp16")
+            max_isa_val = min(
+                get_isa_val(get_highest_binary_support_isa_level()),
+                get_isa_val(get_highest_cpu_support_isa_level()),
+            )
+            self.assertTrue(get_isa_val(get_currnet_isa_level()) <= max_isa_val)
+        finally:
+            core._clear_dispatch_isa_override(stub)
+        self.assertEqual(get_currnet_isa_level(), cur_isa)
+
+    def test_dispatch_isa_override_env(self):
+        command = (
+            'IPEX_DISPATCH_ISA_OVERRIDE=get_current_isa_level_kernel_stub=default \
+            python -c "import torch; import intel_extension_for_pytorch._C \
+            as core; print(core._get_current_isa_level().lower())" '
+        )
+        with subprocess.Popen(
+            command, shell=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT
+        ) as p:
+            out = p.stdout.readlines()
+            self.assertEqual(str(out[-1], "utf-8").strip(), "default")
+
+    def test_dispatch_telemetry(self):
+        core._set_dispatch_telemetry_enabled(True)
+        try:
+            core._reset_dispatch_stats()
+            for _ in range(3):
+                cur_isa = core._get_current_isa_level()
+        finally:
+            core._set_dispatch_telemetry_enabled(False)
+        stats = [
+            stat
+            for stat in core._get_dispatch_stats()
+            if stat["stub"] == "get_current_isa_level_kernel_stub"
+        ]
+        self.assertEqual(len(stats), 1)
+        self.assertEqual(stats[0]["isa"], cur_isa)
+        self.assertEqual(stats[0]["calls"], 3)
+        self.assertTrue(
+            "get_current_isa_level_kernel_stub" in core._dump_dispatch_stats()
+        )
+        # not counted when disabled
+        core._get_current_isa_level()
+        stats = [
+            stat
+            for stat in core._get_dispatch_stats()
+            if stat["stub"] == "get_current_isa_level_kernel_stub"
+        ]
+        self.assertEqual(stats[0]["calls"], 3)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -1365,6 +1365,28 @@ class AddLayerNorm_v2(torch.nn.Module):
         )
 
 
+class GroupNormSilu(torch.nn.Module):
+    def __init__(self, channels, groups):
+        super(GroupNormSilu, self).__init__()
+        self.norm = torch.nn.GroupNorm(groups, channels)
+
+    def forward(self, x):
+        return torch.nn.functional.silu(self.norm(x))
+
+
+class GroupNormSiluAdd(torch.nn.Module):
+    def __init__(self, channels, groups, accumu_on_the_left=False):
+        super(GroupNormSiluAdd, self).__init__()
+        self.norm = torch.nn.GroupNorm(groups, channels)
+        self.accumu_on_the_left = accumu_on_the_left
+
+    def forward(self, x, y):
+        z = torch.nn.functional.silu(self.norm(x))
+        if self.accumu_on_the_left:
+            return y + z
+        return z + y
+
+
 class ConcatBnRelu(torch.nn.Module):
     def __init__(self, dim, cat_dim, in_channels, **kwargs):
         super(ConcatBnRelu, self).__init__()
@@ -1525,6 +1547,15 @@ class EinsumAddInplaceV1(nn.Module):
         return bias.add_(torch.einsum(self.equation, input1, input2))
 
 
+class EinsumMulti(nn.Module):
+    def __init__(self, equation):
+        super(EinsumMulti, self).__init__()
+        self.equation = equation
+
+    def forward(self, *inputs):
+        return torch.einsum(self.equation, *inputs)
+
+
 class AddMulDiv(nn.Module):
     def __init__(self):
         super(AddMulDiv, self).__init__()
@@ -2064,6 +2095,60 @@ class Tester(TestCase):
                 torch._C._jit_set_texpr_fuser_enabled(pre_te_enable_status)
                 self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
 
+    def test_group_norm_silu(self):
+        node = "torch_ipex::group_norm_silu"
+        for dtype, memory_format in itertools.product(
+            [torch.float32, torch.bfloat16],
+            [torch.contiguous_format, torch.channels_last],
+        ):
+            prec = 2e-2 if dtype == torch.bfloat16 else None
+            x = torch.randn(2, 64, 16, 16).to(dtype, memory_format=memory_format)
+            y = torch.randn(2, 64, 16, 16).to(dtype, memory_format=memory_format)
+            models = [
+                (GroupNormSilu(64, 32), (x,)),
+                (GroupNormSiluAdd(64, 32), (x, y)),
+                (GroupNormSiluAdd(64, 32, accumu_on_the_left=True), (x, y)),
+            ]
+            for model, inputs in models:
+                model = model.to(dtype).eval()
+                with torch.no_grad():
+                    ori_res = model(*inputs)
+                    jit_model = torch.jit.freeze(torch.jit.trace(model, inputs))
+                    for _ in range(2):
+                        jit_res = jit_model(*inputs)
+                    trace_graph = jit_model.graph_for(*inputs)
+                self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
+                self.assertEqual(jit_res, ori_res, prec=prec)
+
+        # add with broadcast is not fused
+        x = torch.randn(2, 64, 16, 16)
+        y = torch.randn(2, 64, 1, 1)
+        model = GroupNormSiluAdd(64, 32).eval()
+        with torch.no_grad():
+            ori_res = model(x, y)
+            jit_model = torch.jit.freeze(torch.jit.trace(model, (x, y)))
+            for _ in range(2):
+                jit_res = jit_model(x, y)
+            trace_graph = jit_model.graph_for(x, y)
+        self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
+        self.assertTrue(any(n.kind() == "aten::add" for n in trace_graph.nodes()))
+        self.assertEqual(jit_res, ori_res)
+
+        # add promoting to another dtype is not fused
+        x = torch.randn(2, 64, 16, 16).bfloat16()
+        y = torch.randn(2, 64, 16, 16)
+        model = GroupNormSiluAdd(64, 32).bfloat16().eval()
+        with torch.no_grad():
+            ori_res = model(x, y)
+            jit_model = torch.jit.freeze(torch.jit.trace(model, (x, y)))
+            for _ in range(2):
+                jit_res = jit_model(x, y)
+            trace_graph = jit_model.graph_for(x, y)
+        self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
+        self.assertTrue(any(n.kind() == "aten::add" for n in trace_graph.nodes()))
+        self.assertEqual(jit_res.dtype, torch.float32)
+        self.assertEqual(jit_res, ori_res, prec=2e-2)
+
     def test_concat_bn_relu(self):
         batch_size = 3
         image_size = 16
@@ -5138,6 +5223,45 @@ class Tester(TestCase):
         model_from_vit_alphafold2_v3 = EinsumAdd("bsh,bho->bso")
         _test_fp32(model_from_vit_alphafold2_v3, input1, input2, bias)
 
+    def test_einsum_multi_operand(self):
+        def _test(equation, shapes, dtype=torch.float32, kind="ipex::einsum"):
+            inputs = tuple(torch.randn(shape).to(dtype) for shape in shapes)
+            model = EinsumMulti(equation).eval()
+            with torch.no_grad():
+                tr_model = torch.jit.freeze(torch.jit.trace(model, inputs))
+                tr_model(*inputs)
+                tr_model(*inputs)
+                trace_graph = tr_model.graph_for(*inputs)
+                res_jit = tr_model(*inputs)
+                res_ref = model(*inputs)
+                prec = 5e-2 if dtype == torch.bfloat16 else 1e-3
+                self.assertEqual(res_ref, res_jit, prec=prec)
+                self.assertTrue(any(n.kind() == kind for n in trace_graph.nodes()))
+
+        _test("bij,bjk,bkl->bil", [(2, 8, 16), (2, 16, 32), (2, 32, 4)])
+        _test("ij,jk,kl,lm->im", [(16, 64), (64, 2), (2, 64), (64, 16)])
+        # labels summed from one operand, transposed and scalar outputs
+        _test("abc,cd,bde,e->da", [(2, 3, 4), (4, 5), (3, 5, 6), (6,)])
+        _test("ij,jk,kl->", [(3, 4), (4, 5), (5, 6)])
+        _test("ij,jk,kl", [(3, 4), (4, 5), (5, 6)])
+        _test(
+            "bhqd,bhkd,bhkv,bq->bhv",
+            [(2, 3, 4, 5), (2, 3, 6, 5), (2, 3, 6, 7), (2, 4)],
+        )
+        _test(
+            "bij,bjk,bkl->bil",
+            [(2, 8, 16), (2, 16, 32), (2, 32, 4)],
+            dtype=torch.bfloat16,
+        )
+        # broadcasting falls back to aten inside ipex::einsum
+        _test("bij,bjk,bkl->bil", [(2, 8, 16), (1, 16, 32), (2, 32, 4)])
+        # ellipsis is not planned
+        _test(
+            "...ij,...jk,...kl->...il",
+            [(2, 8, 16), (2, 16, 32), (2, 32, 4)],
+            kind="aten::einsum",
+        )
+
     def test_ipex_softmax(self):
         self._test_output(
             AtenSoftmaxRepalce(), torch.rand(3, 4, 4), kind_in_graph="ipex::softmax"
@@ -8,6 +8,7 @@ from bench.custom_op_bench.merged_embeddingbag import (
     MergedEmbCatDense,
     MergedEmbSGD,
     MergedEmbAdaGrad,
+    MergedEmbAdam,
 )
 import intel_extension_for_pytorch as ipex
 import copy
@@ -230,6 +231,149 @@ class TestMergedEmbedding(TestCase):
                                 )
                             self._test_training(m, ref_m, (indices, offsets), opt=opt)
 
+    def _ref_adam_step(self, weights, grads, indices, states, update, step, **args):
+        # lazy update of the rows looked up, as for torch.optim.SparseAdam
+        lr, (beta1, beta2) = args["lr"], args["betas"]
+        eps, weight_decay = args["eps"], args["weight_decay"]
+        bias_correction1 = 1 - beta1**step
+        bias_correction2_sqrt = (1 - beta2**step) ** 0.5
+        for w, grad, index, (exp_avg, exp_avg_sq) in zip(
+            weights, grads, indices, states
+        ):
+            rows = index.unique().long()
+            g = grad[rows]
+            if update != "lamb":
+                g = g + weight_decay * w[rows]
+            exp_avg[rows] = beta1 * exp_avg[rows] + (1 - beta1) * g
+            if update == "rowwise_adam":
+                exp_avg_sq[rows] = beta2 * exp_avg_sq[rows] + (1 - beta2) * (
+                    g * g
+                ).mean(dim=1)
+                denom = exp_avg_sq[rows].sqrt().unsqueeze(1)
+            else:
+                exp_avg_sq[rows] = beta2 * exp_avg_sq[rows] + (1 - beta2) * g * g
+                denom = exp_avg_sq[rows].sqrt()
+            u = exp_avg[rows] / bias_correction1 / (denom / bias_correction2_sqrt + eps)
+            if update == "lamb":
+                u = u + weight_decay * w[rows]
+                w_norm = w[rows].norm(dim=1, keepdim=True)
+                u_norm = u.norm(dim=1, keepdim=True)
+                trust_ratio = torch.where(
+                    (w_norm > 0) & (u_norm > 0),
+                    w_norm / u_norm,
+                    torch.ones_like(w_norm),
+                )
+                u = trust_ratio * u
+            w[rows] -= lr * u
+
+    def test_training_adam(self):
+        B = 64
+        NUM_TABLE = 3
+        indices = [
+            torch.randint(1000, (B * self.multi_hot[i],)) for i in range(NUM_TABLE)
+        ]
+        offsets = [
+            torch.arange(0, B * self.multi_hot[i], self.multi_hot[i])
+            for i in range(NUM_TABLE)
+        ]
+        args = {"lr": 0.01, "betas": (0.9, 0.99), "eps": 1e-8, "weight_decay": 0.01}
+        for update in ["adam", "rowwise_adam", "lamb"]:
+            for state_dtype in [None, torch.bfloat16, torch.int8]:
+                for dtype in [torch.float32, torch.bfloat16]:
+                    for NUM_DIM in [128, 129]:
+                        emb_list = EmbeddingBagList(NUM_TABLE, NUM_DIM, torch.float32)
+                        kwargs = dict(args, state_dtype=state_dtype)
+                        if update == "rowwise_adam":
+                            kwargs["rowwise"] = True
+                        m = MergedEmbAdam(
+                            copy.deepcopy(emb_list), lamb=update == "lamb", **kwargs
+                        )
+                        if dtype == torch.bfloat16:
+                            m.merged_emb.to_bfloat16_train()
+                        ref_m = copy.deepcopy(emb_list).double()
+                        ref_weights = [
+                            emb.weight.detach().clone() for emb in ref_m.list
+                        ]
+                        ref_states = [
+                            (
+                                torch.zeros_like(w),
+                                (
+                                    torch.zeros(w.size(0), dtype=w.dtype)
+                                    if update == "rowwise_adam"
+                                    else torch.zeros_like(w)
+                                ),
+                            )
+                            for w in ref_weights
+                        ]
+                        for step in range(1, 3):
+                            sum(m(indices, offsets)).sum().backward()
+                            for emb in ref_m.list:
+                                emb.weight.grad = None
+                            sum(ref_m(indices, offsets)).sum().backward()
+                            self._ref_adam_step(
+                                ref_weights,
+                                [emb.weight.grad for emb in ref_m.list],
+                                indices,
+                                ref_states,
+                                update,
+                                step,
+                                **args,
+                            )
+                            with torch.no_grad():
+                                for emb, w in zip(ref_m.list, ref_weights):
+                                    emb.weight.copy_(w)
+                        self.assertEqual(int(m.merged_emb.adam_args.step), 2)
+                        # the 8 bits moments only follow the update roughly
+                        atol = {None: 1e-5, torch.bfloat16: 1e-3, torch.int8: 2e-3}[
+                            state_dtype
+                        ]
+                        rtol = 0
+                        if dtype == torch.bfloat16:
+                            # the weights are compared without their trail
+                            rtol, atol = 1e-2, max(atol, 1e-2)
+                        for i in range(NUM_TABLE):
+                            self.assertEqual(
+                                m.merged_emb.weights[i].double(),
+                                ref_weights[i],
+                                rtol=rtol,
+                                atol=atol,
+                            )
+                            if state_dtype is None:
+                                self.assertEqual(
+                                    m.merged_emb.adam_args.exp_avg[i].double(),
+                                    ref_states[i][0],
+                                    rtol=1e-4,
+                                    atol=1e-6,
+                                )
+
+    def test_training_adam_int8_state_heterogeneous_grads(self):
+        # The grads of a row span 6 orders of magnitude. At the first step Adam
+        # moves each weight by lr, which the 8 bits moments should keep for
+        # the small grads, and never exceed for the smallest ones.
+        B, NUM_DIM = 64, 64
+        indices = [torch.randint(1000, (B,))]
+        offsets = [torch.arange(B)]
+        args = {"lr": 0.01, "betas": (0.9, 0.99), "eps": 1e-8, "weight_decay": 0}
+        grad_scale = 10 ** torch.linspace(0, -6, NUM_DIM)
+        for update in ["adam", "lamb"]:
+            emb_list = EmbeddingBagList(1, NUM_DIM, torch.float32)
+            m = MergedEmbAdam(
+                emb_list, lamb=update == "lamb", state_dtype=torch.int8, **args
+            )
+            weight = m.merged_emb.weights[0].detach().clone()
+            outputs = m(indices, offsets)
+            torch.autograd.backward(outputs, [torch.ones(B, NUM_DIM) * grad_scale])
+            rows = indices[0].unique()
+            step = (weight[rows] - m.merged_emb.weights[0][rows]) / args["lr"]
+            if update == "lamb":
+                # the trust ratio scales the whole row
+                step = step / step[:, :1]
+            self.assertTrue(bool((step <= 1.1).all()))
+            in_range = grad_scale >= 1e-4
+            self.assertEqual(
+                step[:, in_range], torch.ones_like(step[:, in_range]), atol=0.1, rtol=0
+            )
+
 
 if __name__ == "__main__":
     test = unittest.main()
@@ -472,27 +472,67 @@ class TransFreeMHATester(TestCase):
         sd_mha_model = SD_MHA_Model_v2(0.3, 8, 320, 320).eval()
         self.sd_mha_bf16_common(sd_mha_model, mat1, mat2)
 
-    # def test_sd_mha_bf16_v3(self):
-    #     mat = torch.randn(2, 4096, 320)
-    #     sd_mha_model = SD_MHA_Model_v3(8, 320, 320).eval()
-    #     self.sd_mha_bf16_common(sd_mha_model, mat)
-
-    # def test_sd_mha_bf16_scale_v3(self):
-    #     mat = torch.randn(2, 4096, 320)
-    #     sd_mha_model = SD_MHA_Model_scale_v3(8, 320, 320, 0.3).eval()
-    #     self.sd_mha_bf16_common(sd_mha_model, mat)
-
-    # def test_sd_mha_bf16_v4(self):
-    #     mat1 = torch.randn(2, 4096, 320)
-    #     mat2 = torch.randn(2, 77, 320)
-    #     sd_mha_model = SD_MHA_Model_v4(8, 320, 320).eval()
-    #     self.sd_mha_bf16_common(sd_mha_model, mat1, mat2)
-
-    # def test_sd_mha_bf16_scale_v4(self):
-    #     mat1 = torch.randn(2, 4096, 320)
-    #     mat2 = torch.randn(2, 77, 320)
-    #     sd_mha_model = SD_MHA_Model_scale_v4(8, 320, 320, 0.11).eval()
-    #     self.sd_mha_bf16_common(sd_mha_model, mat1, mat2)
+    def test_sd_mha_bf16_v3(self):
+        mat = torch.randn(2, 4096, 320)
+        sd_mha_model = SD_MHA_Model_v3(8, 320, 320).eval()
+        self.sd_mha_bf16_common(sd_mha_model, mat)
+
+    def test_sd_mha_bf16_scale_v3(self):
+        mat = torch.randn(2, 4096, 320)
+        sd_mha_model = SD_MHA_Model_scale_v3(8, 320, 320, 0.3).eval()
+        self.sd_mha_bf16_common(sd_mha_model, mat)
+
+    def test_sd_mha_bf16_v4(self):
+        mat1 = torch.randn(2, 4096, 320)
+        mat2 = torch.randn(2, 77, 320)
+        sd_mha_model = SD_MHA_Model_v4(8, 320, 320).eval()
+        self.sd_mha_bf16_common(sd_mha_model, mat1, mat2)
+
+    def test_sd_mha_bf16_scale_v4(self):
+        mat1 = torch.randn(2, 4096, 320)
+        mat2 = torch.randn(2, 77, 320)
+        sd_mha_model = SD_MHA_Model_scale_v4(8, 320, 320, 0.11).eval()
+        self.sd_mha_bf16_common(sd_mha_model, mat1, mat2)
+
+    def test_sd_flash_mha_fp32(self):
+        # Blocked kernel with the tails of the q and kv blocks, for
+        # self-attention on the packed qkv and for cross-attention
+        num_head, head_size = 8, 40
+        hidden = num_head * head_size
+
+        def ref_mha(query, key, value, scale):
+            def heads(t):
+                return t.view(t.size(0), -1, num_head, head_size).transpose(1, 2)
+
+            scores = torch.matmul(heads(query), heads(key).transpose(-1, -2))
+            probs = torch.softmax(scores * scale, dim=-1)
+            out = torch.matmul(probs, heads(value)).transpose(1, 2)
+            return out.reshape(query.size(0), -1, hidden)
+
+        qkv = torch.randn(2, 1000, hidden * 3)
+        out = torch.ops.ipex.sd_flash_mha(qkv, [hidden] * 3, 0.2, num_head)
+        query, key, value = qkv.split(hidden, dim=-1)
+        self.assertEqual(out, ref_mha(query, key, value, 0.2))
+
+        query = torch.randn(2, 1000, hidden)
+        key = torch.randn(2, 77, hidden)
+        value = torch.randn(2, 77, hidden)
+        out = torch.ops.ipex.sd_flash_mha(query, key, value, None, num_head)
+        self.assertEqual(out, ref_mha(query, key, value, head_size**-0.5))
+
+    def test_sd_mha_fp32_v3(self):
+        mat = torch.randn(2, 1000, 320)
+        model = SD_MHA_Model_v3(8, 320, 320).eval()
+        with torch.no_grad():
+            mha_jit = torch.jit.freeze(torch.jit.trace(model, (mat,)))
+            for _ in range(2):
+                res_jit = mha_jit(mat)
+            res_ref = model(mat)
+            self.assertEqual(res_ref, res_jit)
+            mha_graph = mha_jit.graph_for(mat)
+            self.assertTrue(
+                any(n.kind() == "ipex::sd_flash_mha" for n in mha_graph.nodes())
+            )
 
     def test_fake_sd_mha_bf16(self):
         mat1 = (torch.randn(1, 2, 64, 64) + 20).to(torch.bfloat16)
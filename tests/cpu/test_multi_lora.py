@@ -0,0 +1,156 @@
+import itertools
+import unittest
+
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+from intel_extension_for_pytorch.nn.modules import MultiLoraLinear
+from intel_extension_for_pytorch.quantization import prepare, convert
+from intel_extension_for_pytorch.cpu._auto_kernel_selection import (
+    _enable_tpp,
+    _disable_tpp,
+)
+from common_utils import TestCase
+
+
+def _multi_lora_ref(y, x, lora_a, lora_b, indices, scalings):
+    y = y.float().clone()
+    x2d = x.float().reshape(-1, x.size(-1))
+    y2d = y.view(-1, y.size(-1))
+    for t, a in enumerate(indices.reshape(-1).tolist()):
+        if a < 0:
+            continue
+        delta = (x2d[t] @ lora_a[a].float().t()) @ lora_b[a].float()
+        y2d[t] += scalings[a].item() * delta
+    return y
+
+
+class MultiLoraTester(TestCase):
+    def _make_pool(self, m, ranks, dtype):
+        for slot, rank in enumerate(ranks):
+            m.load_adapter(
+                slot,
+                torch.randn(rank, m.in_features).to(dtype),
+                torch.randn(m.out_features, rank).to(dtype),
+                scaling=2.0 / rank,
+            )
+
+    def test_multi_lora_add(self):
+        num_adapters, max_rank = 4, 16
+        # output features not a multiple of the vector length or column block
+        for dtype, K, N, T in itertools.product(
+            [torch.float, torch.bfloat16, torch.half],
+            [64, 100],
+            [96, 1030],
+            [1, 7, 40],
+        ):
+            x = torch.randn(T, K).to(dtype)
+            y = torch.randn(T, N).to(dtype)
+            lora_a = torch.randn(num_adapters, max_rank, K).to(dtype)
+            lora_b = torch.randn(num_adapters, max_rank, N).to(dtype)
+            scalings = torch.rand(num_adapters)
+            # -1 for the tokens without adapter
+            indices = torch.randint(-1, num_adapters, (T,))
+            y_ref = _multi_lora_ref(y, x, lora_a, lora_b, indices, scalings)
+            out = torch.ops.torch_ipex.multi_lora_add_(
+                y, x, lora_a, lora_b, indices, scalings
+            )
+            self.assertEqual(out.data_ptr(), y.data_ptr())
+            atol, rtol = (1e-4, 1e-4) if dtype == torch.float else (2e-1, 2e-2)
+            torch.testing.assert_close(
+                y.float(), y_ref.to(dtype).float(), atol=atol, rtol=rtol
+            )
+
+    def test_multi_lora_add_bad_index(self):
+        x = torch.randn(2, 8)
+        y = torch.randn(2, 8)
+        lora = torch.randn(2, 4, 8)
+        with self.assertRaises(RuntimeError):
+            torch.ops.torch_ipex.multi_lora_add_(
+                y, x, lora, lora, torch.tensor([0, 2]), torch.ones(2)
+            )
+
+    def test_multi_lora_linear(self):
+        K, N = 64, 128
+        base = nn.Linear(K, N)
+        m = MultiLoraLinear(base, max_adapters=3, max_rank=8, dtype=torch.float)
+        self._make_pool(m, [8, 4, 2], torch.float)
+        x = torch.randn(3, 5, K)
+        with torch.no_grad():
+            # one adapter per sequence and one per token
+            for indices in [
+                torch.tensor([2, -1, 0]),
+                torch.randint(-1, 3, (3, 5)),
+            ]:
+                token_indices = m._token_indices(x, indices)
+                y_ref = _multi_lora_ref(
+                    base(x), x, m.lora_a, m.lora_b, token_indices, m.scalings
+                )
+                torch.testing.assert_close(m(x, indices), y_ref)
+            m.unload_adapter(2)
+            torch.testing.assert_close(
+                m(x, torch.full((3, 5), 2)), base(x), atol=1e-5, rtol=1e-5
+            )
+
+    def test_multi_lora_woq_linear(self):
+        K, N, T = 128, 256, 9
+        base = nn.Sequential(nn.Linear(K, N)).eval()
+        data = torch.rand(T, K)
+        for w_dtype in [torch.qint8, torch.quint4x2]:
+            qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+                weight_dtype=w_dtype
+            )
+            prepared = prepare(base, qconfig, example_inputs=data, inplace=False)
+            with torch.no_grad():
+                qlinear = convert(prepared)[0]
+                m = MultiLoraLinear(qlinear, 2, 8, dtype=torch.float)
+                self._make_pool(m, [8, 3], torch.float)
+                indices = torch.randint(-1, 2, (T,))
+                y_ref = _multi_lora_ref(
+                    qlinear(data), data, m.lora_a, m.lora_b, indices, m.scalings
+                )
+                torch.testing.assert_close(m(data, indices), y_ref)
+
+    @unittest.skipIf(
+        not hasattr(torch.ops.torch_ipex, "tpp_linear_multi_lora"),
+        "built without libxsmm",
+    )
+    def test_multi_lora_tpp_linear(self):
+        K, N, num_adapters, max_rank = 256, 512, 3, 8
+        for dtype, T in itertools.product([torch.float, torch.bfloat16], [5, 130]):
+            base = nn.Sequential(nn.Linear(K, N)).eval().to(dtype)
+            x = torch.randn(T, K).to(dtype)
+            lora_a = torch.randn(num_adapters, max_rank, K).to(dtype)
+            lora_b = torch.randn(num_adapters, max_rank, N).to(dtype)
+            scalings = torch.rand(num_adapters)
+            # more tokens of an adapter than one segment holds
+            indices = torch.randint(-1, num_adapters, (T,))
+            with torch.no_grad():
+                # the tokens of each adapter at once
+                y_ref = base(x).float()
+                for a in range(num_adapters):
+                    rows = indices == a
+                    shrunk = x[rows].float() @ lora_a[a].float().t()
+                    y_ref[rows] += scalings[a] * (shrunk @ lora_b[a].float())
+                _enable_tpp()
+                linear = ipex.optimize(base, dtype=dtype)[0]
+                _disable_tpp()
+                self.assertTrue(linear.use_tpp)
+                out = torch.ops.torch_ipex.tpp_linear_multi_lora(
+                    x,
+                    linear.weight.detach(),
+                    linear.bias.detach(),
+                    lora_a,
+                    lora_b,
+                    indices,
+                    scalings,
+                    N,
+                )
+            atol, rtol = (1e-3, 1e-3) if dtype == torch.float else (5e-1, 2e-2)
+            torch.testing.assert_close(
+                out.float(), y_ref.to(dtype).float(), atol=atol, rtol=rtol
+            )
+
+
+if __name__ == "__main__":
+    test = unittest.main()
@@ -0,0 +1,138 @@
+import copy
+import os
+import tempfile
+import unittest
+
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+from intel_extension_for_pytorch.quantization import prepare, convert
+from intel_extension_for_pytorch.utils.packed_weights import (
+    save_packed_weights,
+    load_packed_weights,
+)
+from common_utils import TestCase
+
+
+class PackedWeightsTester(TestCase):
+    def setUp(self):
+        self.tmp_dir = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.tmp_dir.name, "packed.bin")
+
+    def tearDown(self):
+        self.tmp_dir.cleanup()
+
+    def test_archive(self):
+        tensors = [
+            torch.randn(3, 5),
+            torch.randn(7, 4).to(torch.bfloat16).t(),
+            torch.randint(0, 255, (1000,), dtype=torch.uint8),
+            torch.empty(0, 4),
+        ]
+        names = ["a", "b", "c", "d"]
+        torch.ops.torch_ipex.save_packed_weights(self.path, names, tensors, "{}")
+        loaded_names, loaded, metadata, isa = torch.ops.torch_ipex.load_packed_weights(
+            self.path
+        )
+        self.assertEqual(loaded_names, names)
+        self.assertEqual(metadata, "{}")
+        self.assertEqual(isa, torch.ops.torch_ipex.packed_weight_isa_signature())
+        for t, t_loaded in zip(tensors, loaded):
+            self.assertEqual(t_loaded.dtype, t.dtype)
+            self.assertEqual(t_loaded, t)
+            if t.numel() > 0:
+                self.assertEqual(t_loaded.data_ptr() % 4096, 0)
+        # the mapping is private to the process
+        loaded[0].zero_()
+        _, loaded, _, _ = torch.ops.torch_ipex.load_packed_weights(self.path)
+        self.assertEqual(loaded[0], tensors[0])
+
+        with open(self.path, "r+b") as f:
+            f.truncate(100)
+        with self.assertRaises(RuntimeError):
+            torch.ops.torch_ipex.load_packed_weights(self.path)
+
+    def test_archive_corrupted_sizes(self):
+        torch.ops.torch_ipex.save_packed_weights(
+            self.path, ["a"], [torch.randn(3, 5)], "{}"
+        )
+        isa = torch.ops.torch_ipex.packed_weight_isa_signature()
+        # magic, version, isa, metadata, number of tensors, name, dtype, dim
+        # and the two sizes of "a"
+        sizes_pos = 8 + 8 + (8 + len(isa)) + (8 + 2) + 8 + (8 + 1) + 8 + 8
+        offset_pos = sizes_pos + 2 * 8
+        for pos, value in [
+            # sizes whose product overflows
+            (sizes_pos, 2**62),
+            # an offset beyond the file
+            (offset_pos, 2**62),
+            # an offset plus size which overflows
+            (offset_pos + 8, 2**63 - 1),
+        ]:
+            with open(self.path, "rb") as f:
+                data = bytearray(f.read())
+            data[pos : pos + 8] = value.to_bytes(8, "little", signed=True)
+            corrupted = self.path + ".corrupted"
+            with open(corrupted, "wb") as f:
+                f.write(data)
+            with self.assertRaises(RuntimeError):
+                torch.ops.torch_ipex.load_packed_weights(corrupted)
+
+    def test_archive_overwrite(self):
+        tensors = [torch.randn(3, 5)]
+        torch.ops.torch_ipex.save_packed_weights(self.path, ["a"], tensors, "{}")
+        _, loaded, _, _ = torch.ops.torch_ipex.load_packed_weights(self.path)
+        # the file is replaced, the tensors mapped from the previous one do
+        # not change
+        new_tensors = [torch.randn(3, 5)]
+        torch.ops.torch_ipex.save_packed_weights(self.path, ["a"], new_tensors, "{}")
+        self.assertEqual(loaded[0], tensors[0])
+        _, loaded, _, _ = torch.ops.torch_ipex.load_packed_weights(self.path)
+        self.assertEqual(loaded[0], new_tensors[0])
+        self.assertEqual(os.listdir(self.tmp_dir.name), ["packed.bin"])
+
+    def _woq_model(self, w_dtype, group_size):
+        model = nn.Sequential(nn.Linear(128, 96), nn.ReLU(), nn.Linear(96, 50)).eval()
+        data = torch.rand(4, 128)
+        qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+            weight_dtype=w_dtype, group_size=group_size
+        )
+        prepared = prepare(model, qconfig, example_inputs=data, inplace=False)
+        with torch.no_grad():
+            return convert(prepared)
+
+    def test_woq_linear(self):
+        x = torch.rand(4, 128)
+        for w_dtype, group_size in [
+            (torch.qint8, -1),
+            (torch.quint4x2, -1),
+            (torch.quint4x2, 32),
+        ]:
+            saved = self._woq_model(w_dtype, group_size)
+            restored = self._woq_model(w_dtype, group_size)
+            save_packed_weights(saved, self.path)
+            load_packed_weights(restored, self.path)
+            with torch.no_grad():
+                self.assertEqual(restored(x), saved(x))
+
+    def test_dnnl_linear(self):
+        model = nn.Sequential(nn.Linear(64, 40), nn.ReLU(), nn.Linear(40, 16)).eval()
+        x = torch.rand(3, 64)
+        ipex._enable_dnnl()
+        try:
+            saved = ipex.optimize(model, dtype=torch.float)
+            other = copy.deepcopy(model)
+            for p in other.parameters():
+                nn.init.normal_(p)
+            restored = ipex.optimize(other, dtype=torch.float)
+        finally:
+            ipex._disable_dnnl()
+        save_packed_weights(saved, self.path)
+        load_packed_weights(restored, self.path)
+        with torch.no_grad():
+            self.assertEqual(restored(x), saved(x))
+            self.assertEqual(restored(x), model(x))
+
+
+if __name__ == "__main__":
+    test = unittest.main()
@@ -1,3 +1,4 @@
+import hashlib
 import torch
 from common_utils import TestCase
 import unittest
@@ -300,6 +301,250 @@ class PagedAttentionTest(TestCase):
                 num_token, num_kv_head, head_size, block_size, num_blocks, dtype, seed
             )
 
+    def _test_tree_attention_func(
+        self,
+        num_seqs: int,
+        num_head: Tuple[int, int],
+        head_size: int,
+        use_alibi: bool,
+        num_blocks: int,
+        block_size: int,
+        dtype: torch.dtype,
+        seed: int,
+    ) -> None:
+        random.seed(seed)
+        torch.random.manual_seed(seed)
+        torch.manual_seed(seed)
+        max_seq_len = 256
+        scale = float(1.0 / (head_size**0.5))
+        num_query_heads, num_kv_head = num_head
+        num_queries_per_kv = num_query_heads // num_kv_head
+        head_mapping = torch.repeat_interleave(
+            torch.arange(num_kv_head, dtype=torch.int32), num_queries_per_kv
+        )
+        alibi_slopes = None
+        if use_alibi:
+            alibi_slopes = torch.randn(num_query_heads, dtype=torch.float)
+        # a tree of 2 candidates for the first token, 2 and 1 children for them,
+        # and a chain under the first grandchild
+        tree_parents = torch.tensor([-1, -1, 0, 0, 1, 2, 5], dtype=torch.int)
+        num_tree_tokens = tree_parents.numel()
+        query = torch.empty(num_seqs, num_tree_tokens, num_query_heads, head_size)
+        query = query.uniform_(-scale, scale).to(dtype)
+
+        context_lens = [
+            random.randint(num_tree_tokens, max_seq_len) for _ in range(num_seqs)
+        ]
+        max_num_blocks_per_seq = (max(context_lens) + block_size - 1) // block_size
+        block_tables = torch.randint(
+            0, num_blocks, (num_seqs, max_num_blocks_per_seq), dtype=torch.int
+        )
+        context_lens = torch.tensor(context_lens, dtype=torch.int)
+        key_caches, value_caches = self.create_kv_caches(
+            num_blocks, block_size, 1, num_kv_head, head_size, dtype, seed
+        )
+        key_cache, value_cache = key_caches[0], value_caches[0]
+        output = torch.empty_like(query)
+        torch.ops.torch_ipex.tree_cached_kv_attention(
+            output,
+            query,
+            key_cache,
+            value_cache,
+            head_mapping,
+            scale,
+            block_tables,
+            context_lens,
+            tree_parents,
+            block_size,
+            alibi_slopes,
+        )
+
+        # dense mask of the ancestors of the tree tokens and their depths
+        ancestors = torch.eye(num_tree_tokens, dtype=torch.bool)
+        depths = torch.zeros(num_tree_tokens)
+        for i, parent in enumerate(tree_parents.tolist()):
+            if parent >= 0:
+                ancestors[i] |= ancestors[parent]
+                depths[i] = depths[parent] + 1
+        for i in range(num_seqs):
+            context_len = int(context_lens[i])
+            prefix_len = context_len - num_tree_tokens
+            keys = []
+            values = []
+            for j in range(context_len):
+                block_number = int(block_tables[i][j // block_size])
+                keys.append(key_cache[block_number, j % block_size])
+                values.append(value_cache[block_number, j % block_size])
+            keys = torch.stack(keys, dim=0)
+            values = torch.stack(values, dim=0)
+            if num_queries_per_kv > 1:
+                keys = torch.repeat_interleave(keys, num_queries_per_kv, dim=1)
+                values = torch.repeat_interleave(values, num_queries_per_kv, dim=1)
+            mask = torch.zeros(num_tree_tokens, context_len)
+            mask[:, prefix_len:].masked_fill_(~ancestors, float("-inf"))
+            if alibi_slopes is not None:
+                key_pos = torch.arange(context_len).float()
+                key_pos[prefix_len:] = prefix_len + depths
+                query_pos = prefix_len + depths
+                alibi_bias = key_pos.view(1, -1) - query_pos.view(-1, 1)
+                mask = mask + alibi_slopes.view(-1, 1, 1) * alibi_bias
+            ref_output = self.ref_masked_attention(query[i], keys, values, scale, mask)
+            torch.testing.assert_close(output[i], ref_output, atol=5e-3, rtol=1e-2)
+
+    def test_tree_attention(self):
+        num_blocks = 64
+        for num_head, head_size, use_alibi, block_size, dtype in product(
+            [(8, 8), (16, 4)],
+            [64, 80, 128],
+            [True, False],
+            [16, 32],
+            [torch.bfloat16, torch.float],
+        ):
+            self._test_tree_attention_func(
+                5, num_head, head_size, use_alibi, num_blocks, block_size, dtype, 0
+            )
+
+    def test_tree_accept_kv_cache(self):
+        num_blocks, block_size, num_head, head_size = 32, 16, 4, 64
+        for dtype in [torch.bfloat16, torch.float]:
+            key_caches, value_caches = self.create_kv_caches(
+                num_blocks, block_size, 1, num_head, head_size, dtype, 0
+            )
+            key_cache, value_cache = key_caches[0], value_caches[0]
+            block_tables = torch.randperm(num_blocks)[:12].view(3, 4).int()
+            prefix_lens = torch.tensor([5, 16, 30], dtype=torch.int)
+            accepted = torch.tensor(
+                [[0, 1, 3, 6], [2, 5, 0, 0], [0, 0, 0, 0]], dtype=torch.int
+            )
+            num_accepted = torch.tensor([4, 2, 0], dtype=torch.int)
+            ref_key_cache = key_cache.clone()
+            ref_value_cache = value_cache.clone()
+            for i in range(3):
+                for t in range(int(num_accepted[i])):
+                    src = int(prefix_lens[i] + accepted[i][t])
+                    dst = int(prefix_lens[i]) + t
+                    src_slot = (block_tables[i][src // block_size], src % block_size)
+                    dst_slot = (block_tables[i][dst // block_size], dst % block_size)
+                    ref_key_cache[dst_slot] = ref_key_cache[src_slot]
+                    ref_value_cache[dst_slot] = ref_value_cache[src_slot]
+            torch.ops.torch_ipex.tree_accept_kv_cache(
+                key_cache,
+                value_cache,
+                block_tables,
+                prefix_lens,
+                accepted,
+                num_accepted,
+            )
+            self.assertEqual(key_cache, ref_key_cache)
+            self.assertEqual(value_cache, ref_value_cache)
+
+            # the accepted tokens of a path are in ascending order
+            with self.assertRaises(RuntimeError):
+                torch.ops.torch_ipex.tree_accept_kv_cache(
+                    key_cache,
+                    value_cache,
+                    block_tables,
+                    prefix_lens,
+                    torch.tensor([[3, 1], [0, 0], [0, 0]], dtype=torch.int),
+                    torch.tensor([2, 0, 0], dtype=torch.int),
+                )
+
+            # the accepted tokens are in the slots of the block table
+            with self.assertRaises(RuntimeError):
+                torch.ops.torch_ipex.tree_accept_kv_cache(
+                    key_cache,
+                    value_cache,
+                    block_tables,
+                    prefix_lens,
+                    torch.tensor([[0, 0], [0, 0], [0, 34]], dtype=torch.int),
+                    torch.tensor([0, 0, 2], dtype=torch.int),
+                )
+
+    def test_copy_blocks(self):
+        num_blocks, block_size, num_head, head_size = 32, 16, 4, 64
+        for dtype in [torch.bfloat16, torch.float]:
+            key_caches, value_caches = self.create_kv_caches(
+                num_blocks, block_size, 3, num_head, head_size, dtype, 0
+            )
+            ref_key_caches = [c.clone() for c in key_caches]
+            ref_value_caches = [c.clone() for c in value_caches]
+            # one source block copied to several blocks, for copy-on-write
+            block_mapping = torch.tensor([[0, 5], [0, 6], [7, 1], [30, 31]])
+            torch.ops.torch_ipex.copy_blocks(key_caches, value_caches, block_mapping)
+            for src, dst in block_mapping.tolist():
+                for ref_key_cache, ref_value_cache in zip(
+                    ref_key_caches, ref_value_caches
+                ):
+                    ref_key_cache[dst] = ref_key_cache[src]
+                    ref_value_cache[dst] = ref_value_cache[src]
+            for key_cache, ref_key_cache in zip(key_caches, ref_key_caches):
+                self.assertEqual(key_cache, ref_key_cache)
+            for value_cache, ref_value_cache in zip(value_caches, ref_value_caches):
+                self.assertEqual(value_cache, ref_value_cache)
+            with self.assertRaises(RuntimeError):
+                torch.ops.torch_ipex.copy_blocks(
+                    key_caches, value_caches, torch.tensor([[0, num_blocks]])
+                )
+
+    def test_swap_blocks(self):
+        block_size, num_head, head_size = 16, 4, 64
+        for src_dtype, dst_dtype in [
+            (torch.bfloat16, torch.bfloat16),
+            (torch.float, torch.float),
+            (torch.float, torch.bfloat16),
+            (torch.bfloat16, torch.float),
+            (torch.float, torch.half),
+        ]:
+            src = torch.randn(16, block_size, num_head, head_size).to(src_dtype)
+            dst = torch.randn(8, block_size, num_head, head_size).to(dst_dtype)
+            ref_dst = dst.clone()
+            block_mapping = torch.tensor([[3, 0], [15, 7], [4, 2]])
+            torch.ops.torch_ipex.swap_blocks(src, dst, block_mapping)
+            for s, d in block_mapping.tolist():
+                ref_dst[d] = src[s].to(dst_dtype)
+            self.assertEqual(dst, ref_dst)
+
+    def test_hash_kv_blocks(self):
+        block_size = 4
+        prompt = torch.randint(0, 32000, (10,))
+        token_ids = torch.stack(
+            [
+                prompt,
+                prompt,
+                torch.cat([prompt[:6], prompt[6:] + 1]),
+                prompt,
+            ]
+        )
+        seq_lens = torch.tensor([10, 7, 10, 10])
+        hashes = torch.ops.torch_ipex.hash_kv_blocks(token_ids, seq_lens, block_size)
+        self.assertEqual(hashes.shape, (4, 2, 4))
+        self.assertEqual(hashes[0], hashes[3])
+        # the hashes are the SHA-256 digests of the previous digest and tokens
+        digest = bytes(32)
+        for b in range(2):
+            tokens = prompt[b * block_size : (b + 1) * block_size]
+            digest = hashlib.sha256(digest + tokens.numpy().tobytes()).digest()
+            expected = torch.frombuffer(bytearray(digest), dtype=torch.long)
+            self.assertEqual(hashes[0][b], expected)
+        # only the full blocks are hashed
+        self.assertEqual(hashes[1][0], hashes[0][0])
+        self.assertEqual(hashes[1][1], torch.zeros(4, dtype=torch.long))
+        # the blocks from the first different token differ
+        self.assertEqual(hashes[2][0], hashes[0][0])
+        self.assertNotEqual(hashes[2][1], hashes[0][1])
+        # blocks of the same tokens after different prefixes differ
+        shifted = torch.cat([prompt[4:8], prompt[4:8]]).unsqueeze(0)
+        shifted_hashes = torch.ops.torch_ipex.hash_kv_blocks(
+            shifted, torch.tensor([8]), block_size
+        )
+        self.assertNotEqual(shifted_hashes[0][0], shifted_hashes[0][1])
+        # the extra hashes seed the chains
+        extra_hashes = torch.tensor([0, 0, 0, 1])
+        hashes = torch.ops.torch_ipex.hash_kv_blocks(
+            token_ids, seq_lens, block_size, extra_hashes
+        )
+        self.assertNotEqual(hashes[0][0], hashes[3][0])
+
 
 if __name__ == "__main__":
     test = unittest.main()
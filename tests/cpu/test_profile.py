@@ -1,7 +1,11 @@
 import unittest
 from common_utils import TestCase
+import json
 import os
 import subprocess
+import tempfile
+import torch
+import intel_extension_for_pytorch as ipex
 
 
 class TestProfiler(TestCase):
@@ -21,6 +25,97 @@ class TestProfiler(TestCase):
                     num = num + 1
         assert num == 2, "IPEX op profiling info not found."
 
+    def test_kernel_profile(self):
+        x = torch.randn(64, 256)
+        weight = torch.randn(256)
+        with tempfile.TemporaryDirectory() as tmp:
+            trace_path = os.path.join(tmp, "trace.json")
+            with ipex.kernel_profile(trace_path=trace_path) as prof:
+                for _ in range(3):
+                    torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            # Disabled out of the scope
+            torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            stats = [s for s in prof.stats() if s["kernel"] == "rmsnorm"]
+            self.assertEqual(len(stats), 1)
+            self.assertEqual(stats[0]["dtype"], "Float")
+            self.assertEqual(stats[0]["calls"], 3)
+            self.assertEqual(stats[0]["flops"], 3 * 4 * x.numel())
+            self.assertEqual(
+                stats[0]["bytes_written"], 3 * x.numel() * x.element_size()
+            )
+            self.assertGreater(stats[0]["total_ns"], 0)
+            self.assertIn("rmsnorm", prof.table())
+
+            with open(trace_path) as f:
+                trace = json.load(f)
+            events = [e for e in trace["traceEvents"] if e["name"] == "rmsnorm"]
+            self.assertEqual(len(events), 3)
+            for event in events:
+                self.assertEqual(event["ph"], "X")
+                self.assertEqual(event["args"]["shapes"], "[64, 256], [256]")
+                self.assertGreaterEqual(event["args"]["imbalance"], 0)
+
+    def test_kernel_profile_restores_enabled(self):
+        x = torch.randn(64, 256)
+        weight = torch.randn(256)
+        # As with IPEX_KERNEL_PROFILE=1, the scope neither drops the kernels
+        # profiled before it nor turns profiling off
+        ipex._C._reset_kernel_profile()
+        ipex._C._set_kernel_profiling_enabled(True)
+        try:
+            torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            with ipex.kernel_profile() as prof:
+                torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            self.assertTrue(ipex._C._is_kernel_profiling_enabled())
+            torch.ops.torch_ipex.rmsnorm(x, weight, 1e-6)
+            stats = [s for s in prof.stats() if s["kernel"] == "rmsnorm"]
+            self.assertEqual(stats[0]["calls"], 3)
+        finally:
+            ipex._C._set_kernel_profiling_enabled(False)
+        with ipex.kernel_profile():
+            pass
+        self.assertFalse(ipex._C._is_kernel_profiling_enabled())
+
+    def test_kernel_profile_regions(self):
+        num_seqs, num_heads, head_size, block_size = 8, 4, 64, 16
+        # One long context among short ones, of which the work the threads
+        # split by the context lengths
+        context_lens = [3] * (num_seqs - 1) + [256]
+        max_context_len = max(context_lens)
+        max_num_blocks = (max_context_len + block_size - 1) // block_size
+        num_blocks = num_seqs * max_num_blocks
+        query = torch.randn(num_seqs, num_heads, head_size)
+        key_cache = torch.randn(num_blocks, block_size, num_heads, head_size)
+        value_cache = torch.randn(num_blocks, block_size, num_heads, head_size)
+        head_mapping = torch.arange(num_heads, dtype=torch.int)
+        block_tables = torch.arange(num_blocks, dtype=torch.int).view(
+            num_seqs, max_num_blocks
+        )
+        output = torch.empty_like(query)
+        with ipex.kernel_profile() as prof:
+            torch.ops.torch_ipex.single_query_cached_kv_attention(
+                output,
+                query,
+                key_cache,
+                value_cache,
+                head_mapping,
+                head_size**-0.5,
+                block_tables,
+                torch.tensor(context_lens, dtype=torch.int),
+                block_size,
+                max_context_len,
+                None,
+            )
+        stats = [s for s in prof.stats() if s["kernel"] == "paged_attention"]
+        self.assertEqual(len(stats), 1)
+        self.assertEqual(
+            stats[0]["flops"], 4 * sum(context_lens) * num_heads * head_size
+        )
+        self.assertEqual(sorted(stats[0]["regions"].keys()), ["av", "qk"])
+        for imbalance in stats[0]["regions"].values():
+            self.assertGreaterEqual(imbalance, 1)
+        self.assertIn(".qk", prof.table())
+
 
 if __name__ == "__main__":
     test = unittest.main()
@@ -1531,6 +1531,324 @@ class WeightOnlyQuantizationTester(TestCase):
         for shape, has_bias, act_quant_mode, group_size in cases:
             test(shape, has_bias, act_quant_mode, group_size)
 
+    def test_weight_only_quantization_autotune(self):
+        class M(nn.Module):
+            def __init__(self, ic, oc):
+                super(M, self).__init__()
+                self.linear = torch.nn.Linear(ic, oc)
+
+            def forward(self, x):
+                return self.linear(x)
+
+        N, K = 128, 256
+        torch.ops.torch_ipex.woq_tuning_db_clear()
+        # Nothing is tuned if the kernel of this ISA does not pack the weight
+        qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping()
+        m = M(K, N).eval()
+        data = torch.rand(8, K)
+        with torch.no_grad():
+            probe = convert(prepare(m, qconfig, example_inputs=data, inplace=False))
+        is_packed = probe.linear.weight.dim() == 4
+        # weight dtypes: 1 for INT8, 2 for INT4, 3 for NF4
+        block_n, block_k = torch.ops.torch_ipex.woq_tune_gemm(
+            N, K, 3, 32, 2, [1], torch.bfloat16
+        )
+        self.assertEqual(N % block_n, 0)
+        self.assertEqual(K % block_k, 0)
+        torch.ops.torch_ipex.woq_tuning_db_clear()
+        block_n, block_k = torch.ops.torch_ipex.woq_tune_gemm(
+            N, K, 1, -1, 0, [1, 8], torch.float32
+        )
+        self.assertEqual(N % block_n, 0)
+        self.assertEqual(K % block_k, 0)
+        with tempfile.TemporaryDirectory() as tmp:
+            db_path = os.path.join(tmp, "woq_tuning.db")
+            torch.ops.torch_ipex.woq_tuning_db_save(db_path)
+            with open(db_path) as f:
+                entries = [line.split() for line in f if not line.startswith("#")]
+            # the packing entry and the entries of the two M
+            self.assertEqual(len(entries), 3 if is_packed else 0)
+            for entry in entries:
+                self.assertEqual(len(entry), 14)
+            torch.ops.torch_ipex.woq_tuning_db_clear()
+            torch.ops.torch_ipex.woq_tuning_db_load(db_path)
+
+            # a malformed database is rejected as a whole
+            bad_db_path = os.path.join(tmp, "bad_woq_tuning.db")
+            with open(bad_db_path, "w") as f:
+                f.write("128 256 1 0 0\n")
+            with self.assertRaises(RuntimeError):
+                torch.ops.torch_ipex.woq_tuning_db_load(bad_db_path)
+            torch.ops.torch_ipex.woq_tuning_db_save(db_path)
+            with open(db_path) as f:
+                entries = [line.split() for line in f if not line.startswith("#")]
+            self.assertEqual(len(entries), 3 if is_packed else 0)
+
+        # the model is packed and run with the tuned config, M of 2 and 4
+        # without entries use the config of the nearest M
+        qw, w_scales, w_zero_points = quantize_per_channel(m.linear.weight, False)
+        w_fp32 = dequantize_per_channel(
+            qw, w_scales, w_zero_points.int(), False, m.linear.weight.shape
+        )
+        y_ref = data @ w_fp32.T + m.linear.bias
+        prepared_model = prepare(m, qconfig, example_inputs=data, inplace=False)
+        with torch.no_grad():
+            woq_model = convert(prepared_model)
+            for M_ in [1, 2, 4, 8]:
+                torch.testing.assert_close(woq_model(data[:M_]), y_ref[:M_])
+        torch.ops.torch_ipex.woq_tuning_db_clear()
+
+    def _compress_to_int32(self, values, bits):
+        # Compress values along the last dim as a little-endian bitstream
+        # in int32 as GPTQ does
+        rows, num_values = values.shape
+        num_words = (num_values * bits + 31) // 32
+        words = torch.zeros(rows, num_words, dtype=torch.int64)
+        for j in range(num_values):
+            word, shift = divmod(j * bits, 32)
+            val = values[:, j].long()
+            words[:, word] |= (val << shift) & 0xFFFFFFFF
+            if shift + bits > 32:
+                words[:, word + 1] |= val >> (32 - shift)
+        words = torch.where(words >= 2**31, words - 2**32, words)
+        return words.to(torch.int32)
+
+    def _uncompress_uint8(self, qweight, bits):
+        # Values of `bits` bits compressed in uint8 along the last dim as a
+        # little-endian bitstream
+        shifts = torch.arange(8, dtype=torch.uint8)
+        stream = qweight.unsqueeze(-1).bitwise_right_shift(shifts).bitwise_and(1)
+        stream = stream.view(qweight.size(0), -1, bits).long()
+        return (stream << torch.arange(bits)).sum(-1).to(torch.uint8)
+
+    def test_weight_only_quantization_act_order_and_low_bits(self):
+        def test(bits, act_order, compress_zp, has_bias):
+            M, N, K, group_size = 4, 64, 256, 64
+            num_groups = K // group_size
+            qweight = torch.randint(0, 2**bits, (N, K), dtype=torch.uint8)
+            scales = torch.rand(N, num_groups) * 0.01 + 0.001
+            zps = torch.randint(0, 2**bits, (N, num_groups), dtype=torch.uint8)
+            g_idx = torch.arange(K, dtype=torch.int32) // group_size
+            if act_order:
+                g_idx = g_idx[torch.randperm(K)]
+            w_ref = (qweight.float() - zps.float()[:, g_idx.long()]) * scales[
+                :, g_idx.long()
+            ]
+            mod = nn.Linear(K, N, has_bias)
+            mod.qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+                weight_dtype=torch.quint4x2, group_size=group_size
+            ).global_qconfig
+            woq_linear = ipex.nn.modules.IpexWoqLinear.from_float_and_int4_weight(
+                mod,
+                self._compress_to_int32(qweight, bits),
+                scales,
+                self._compress_to_int32(zps, bits) if compress_zp else zps.float(),
+                group_size=group_size,
+                g_idx=g_idx if act_order else None,
+                weight_bits=bits,
+            )
+            data = torch.rand(M, K)
+            y_ref = data @ w_ref.T + (mod.bias if has_bias else 0)
+            with torch.no_grad():
+                y = woq_linear(data)
+                torch.testing.assert_close(y, y_ref, atol=1e-4, rtol=1e-3)
+                # The public weight keeps the order of input channels
+                ctx = woq_linear._op_context
+                qw = ctx.to_public(ctx.get_weight())
+                self.assertEqual(qw.shape, (N, K * bits // 8))
+                self.assertEqual(self._uncompress_uint8(qw, bits), qweight)
+                # Serialization
+                ctx2 = torch.ops.ipex_prepack.weight_only_qlinear_prepack(
+                    *ctx.__getstate__()
+                )
+                y2 = torch.ops.torch_ipex.ipex_woq_linear(data, ctx2.get_data_handle())
+                torch.testing.assert_close(y2, y)
+
+        bits_list = [2, 3, 4]
+        act_order_list = [False, True]
+        compress_zp_list = [False, True]
+        has_bias_list = [False, True]
+        cases = itertools.product(
+            bits_list, act_order_list, compress_zp_list, has_bias_list
+        )
+        for bits, act_order, compress_zp, has_bias in cases:
+            test(bits, act_order, compress_zp, has_bias)
+
+        # Groups of g_idx should have group_size input channels each
+        mod = nn.Linear(128, 64)
+        mod.qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+            weight_dtype=torch.quint4x2, group_size=32
+        ).global_qconfig
+        with self.assertRaises(RuntimeError):
+            ipex.nn.modules.IpexWoqLinear.from_float_and_int4_weight(
+                mod,
+                torch.randint(0, 2**31, (64, 16), dtype=torch.int32),
+                torch.rand(64, 4),
+                torch.zeros(64, 4),
+                group_size=32,
+                g_idx=torch.zeros(128, dtype=torch.int32),
+            )
+
+    def test_weight_only_quantization_old_state(self):
+        # Contexts pickled before g_idx and weight_dtype were added have 11
+        # elements in their state
+        M, N, K, group_size = 4, 64, 256, 64
+        num_groups = K // group_size
+        qweight = torch.randint(0, 16, (N, K), dtype=torch.uint8)
+        scales = torch.rand(N, num_groups) * 0.01 + 0.001
+        zps = torch.randint(0, 16, (N, num_groups), dtype=torch.uint8)
+        mod = nn.Linear(K, N)
+        mod.qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+            weight_dtype=torch.quint4x2, group_size=group_size
+        ).global_qconfig
+        woq_linear = ipex.nn.modules.IpexWoqLinear.from_float_and_int4_weight(
+            mod,
+            self._compress_to_int32(qweight, 4),
+            scales,
+            zps.float(),
+            group_size=group_size,
+        )
+        ctx = woq_linear._op_context
+        state = ctx.__getstate__()
+        self.assertEqual(len(state), 13)
+        ctx2 = torch.ops.ipex_prepack.weight_only_qlinear_prepack(*state)
+        ctx2.__setstate__(tuple(state[:11]))
+        data = torch.rand(M, K)
+        with torch.no_grad():
+            y = woq_linear(data)
+            y2 = torch.ops.torch_ipex.ipex_woq_linear(data, ctx2.get_data_handle())
+            torch.testing.assert_close(y2, y)
+
+    def test_weight_only_quantization_mx(self):
+        def test(weight_format, N, has_bias, lowp_mode):
+            M, K = 4, 256
+            w = torch.randn(N, K)
+            qweight, scales = ipex.quantization.quantize_mx(w, weight_format)
+            self.assertEqual(scales.shape, (N, K // 32))
+            w_ref = ipex.quantization.dequantize_mx(qweight, scales, weight_format)
+            mod = nn.Linear(K, N, has_bias)
+            mod.qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+                lowp_mode=lowp_mode
+            ).global_qconfig
+            woq_linear = ipex.nn.modules.IpexWoqLinear.from_float_and_mx_weight(
+                mod, qweight, scales, weight_format
+            )
+            # MX weight is not computed in int8
+            self.assertEqual(woq_linear._lowp_mode, 2 if lowp_mode == 3 else lowp_mode)
+            data = torch.rand(M, K)
+            y_ref = data @ w_ref.T + (mod.bias if has_bias else 0)
+            with torch.no_grad():
+                y = woq_linear(data)
+                if lowp_mode == 0:
+                    torch.testing.assert_close(y, y_ref, atol=1e-4, rtol=1e-3)
+                else:
+                    torch.testing.assert_close(y, y_ref, atol=5e-2, rtol=5e-2)
+                ctx = woq_linear._op_context
+                qw = ctx.to_public(ctx.get_weight())
+                self.assertEqual(qw.view(torch.uint8), qweight)
+                # Serialization
+                ctx2 = torch.ops.ipex_prepack.weight_only_qlinear_prepack(
+                    *ctx.__getstate__()
+                )
+                y2 = torch.ops.torch_ipex.ipex_woq_linear(data, ctx2.get_data_handle())
+                torch.testing.assert_close(y2, y)
+                if weight_format == "mxfp6":
+                    # Four codes in three bytes, also taken one code per byte
+                    self.assertEqual(qweight.shape, (N, K * 3 // 4))
+                    bits = qweight.unsqueeze(-1).bitwise_right_shift(torch.arange(8))
+                    bits = bits.bitwise_and(1).view(N, K, 6)
+                    codes = (bits << torch.arange(6)).sum(-1).to(torch.uint8)
+                    from_mx = ipex.nn.modules.IpexWoqLinear.from_float_and_mx_weight
+                    woq_linear2 = from_mx(mod, codes, scales, weight_format)
+                    torch.testing.assert_close(woq_linear2(data), y)
+
+        format_list = ["mxfp4", "mxfp6", "mxfp8"]
+        N_list = [64, 100]
+        has_bias_list = [False, True]
+        lowp_mode_list = [0, 2, 3]
+        cases = itertools.product(format_list, N_list, has_bias_list, lowp_mode_list)
+        for weight_format, N, has_bias, lowp_mode in cases:
+            test(weight_format, N, has_bias, lowp_mode)
+
+        # Values in the formats are kept exactly, including subnormals
+        values = {
+            "mxfp4": [0.0, 0.5, 1.5, 6.0, -0.5, -3.0],
+            "mxfp6": [0.0, 0.125, 0.875, 7.5, -0.25, -1.75],
+            "mxfp8": [0.0, 2**-9, 0.01171875, 448.0, -(2**-8), -240.0],
+        }
+        for weight_format, v in values.items():
+            w = torch.tensor(v).repeat(2, 6)[:, :32]
+            qweight, scales = ipex.quantization.quantize_mx(w, weight_format)
+            self.assertEqual(scales, torch.full((2, 1), 127, dtype=torch.uint8))
+            self.assertEqual(
+                ipex.quantization.dequantize_mx(qweight, scales, weight_format), w
+            )
+
+    def test_weight_only_quantization_fused_mlp(self):
+        from intel_extension_for_pytorch.transformers.models.cpu.fusions.linear_fusion import (
+            _IPEXWoqFusedMlpCPU,
+        )
+
+        class Mlp(nn.Module):
+            def __init__(self, hidden_size, intermediate_size, has_bias):
+                super().__init__()
+                self.gate = nn.Linear(hidden_size, intermediate_size, has_bias)
+                self.up = nn.Linear(hidden_size, intermediate_size, has_bias)
+                self.down = nn.Linear(intermediate_size, hidden_size, has_bias)
+
+            def forward(self, x, residual):
+                return (
+                    self.down(nn.functional.silu(self.gate(x)) * self.up(x)) + residual
+                )
+
+        def test(intermediate_size, M, w_dtype, group_size, lowp_mode, has_bias):
+            hidden_size = 128
+            m = Mlp(hidden_size, intermediate_size, has_bias).eval()
+            data = torch.rand(M, hidden_size)
+            residual = torch.rand(M, hidden_size)
+            qconfig = ipex.quantization.get_weight_only_quant_qconfig_mapping(
+                weight_dtype=w_dtype, lowp_mode=lowp_mode, group_size=group_size
+            )
+            prepared = prepare(m, qconfig, example_inputs=data, inplace=True)
+            with torch.no_grad():
+                qm = convert(prepared)
+                fused = _IPEXWoqFusedMlpCPU(qm.gate, qm.up, qm.down)
+                y_ref = qm(data, residual)
+                if fused.gate_up_linear is None:
+                    # Padded along N and cannot be concatenated
+                    self.assertNotEqual(intermediate_size % 64, 0)
+                    return
+                # Built from the packed weights of gate and up as they are
+                self.assertEqual(
+                    fused.gate_up_linear.weight,
+                    torch.cat([qm.gate.weight, qm.up.weight]),
+                )
+                y = fused(data, residual)
+                if lowp_mode == 0:
+                    torch.testing.assert_close(y, y_ref, atol=1e-3, rtol=1e-3)
+                else:
+                    torch.testing.assert_close(y, y_ref, atol=5e-2, rtol=5e-2)
+                y = fused(data)
+                torch.testing.assert_close(y + residual, y_ref, atol=5e-2, rtol=5e-2)
+
+        # 200 is not a multiple of the block size of N and falls back
+        intermediate_size_list = [256, 200]
+        M_list = [1, 4, 33]
+        w_dtype_list = [torch.qint8, torch.quint4x2]
+        group_size_list = [-1, 64]
+        lowp_mode_list = [0, 2]
+        has_bias_list = [False, True]
+        cases = itertools.product(
+            intermediate_size_list,
+            M_list,
+            w_dtype_list,
+            group_size_list,
+            lowp_mode_list,
+            has_bias_list,
+        )
+        for intermediate_size, M, w_dtype, group_size, lowp_mode, has_bias in cases:
+            test(intermediate_size, M, w_dtype, group_size, lowp_mode, has_bias)
+
 
 class QuantizedOpsTester(TestCase):
     def test_matmul_i8i8i32(self):
@@ -250,5 +250,99 @@ class TestRNNTEmbedding(TestCase):
             self.assertEqual(y_embed_org, y_embed)
 
 
+class TestRNNTGreedyDecode(TestCase):
+    def _pred(self, label, hidden, embedding, lstm):
+        if label == self._SOS:
+            y = torch.zeros([1, 1, embedding.weight.shape[1]], dtype=torch.float)
+        else:
+            y = embedding(torch.tensor([[label]], dtype=torch.long))
+        g, hidden = lstm(y.transpose(0, 1), hidden)
+        return g.transpose(0, 1), hidden
+
+    def _test_org(self, x, out_lens, embedding, lstm, joint, max_symbols, blank_id):
+        labels = []
+        for b in range(x.size(0)):
+            hidden = None
+            label = []
+            for t in range(out_lens[b]):
+                f = x[b, t, :].view(1, 1, -1)
+                not_blank = True
+                symbols_added = 0
+                while not_blank and symbols_added < max_symbols:
+                    last = label[-1] if len(label) > 0 else self._SOS
+                    g, hidden_prime = self._pred(last, hidden, embedding, lstm)
+                    logits = joint[2](joint[0](f) + joint[1](g)).view(-1)
+                    k = logits.argmax().item()
+                    if k == blank_id:
+                        not_blank = False
+                    else:
+                        label.append(k)
+                        hidden = hidden_prime
+                    symbols_added += 1
+            labels.append(label)
+        return labels
+
+    def test_rnnt_greedy_decode(self):
+        self._SOS = -1
+        vocab_size = 29
+        blank_id = 28
+        enc_dim, pred_dim, joint_dim = 32, 16, 24
+        for batch_size, max_symbols, num_layers in product(
+            [1, 5, 17], [1, 30], [1, 2]
+        ):
+            x = torch.randn([batch_size, 12, enc_dim])
+            out_lens = torch.randint(0, 13, [batch_size], dtype=torch.int32)
+            embedding = torch.nn.Embedding(vocab_size - 1, pred_dim)
+            lstm = torch.nn.LSTM(pred_dim, pred_dim, num_layers)
+            joint_enc = torch.nn.Linear(enc_dim, joint_dim)
+            joint_pred = torch.nn.Linear(pred_dim, joint_dim)
+            joint_fc = torch.nn.Sequential(
+                torch.nn.ReLU(), torch.nn.Linear(joint_dim, vocab_size)
+            )
+            # bias the classifier towards non-blank symbols to exercise max_symbols
+            joint_fc[1].bias.data[blank_id] -= 0.5
+
+            with torch.no_grad():
+                labels_org = self._test_org(
+                    x,
+                    out_lens,
+                    embedding,
+                    lstm,
+                    [joint_enc, joint_pred, joint_fc],
+                    max_symbols,
+                    blank_id,
+                )
+
+                lstm_weights, lstm_biases = [], []
+                for layer in range(num_layers):
+                    w, b = torch.ops.torch_ipex.rnnt_lstm_pack_weight(
+                        getattr(lstm, "weight_ih_l%d" % layer),
+                        getattr(lstm, "weight_hh_l%d" % layer),
+                        getattr(lstm, "bias_ih_l%d" % layer),
+                        getattr(lstm, "bias_hh_l%d" % layer),
+                    )
+                    lstm_weights.append(w)
+                    lstm_biases.append(b)
+                labels, label_lens = torch.ops.torch_ipex.rnnt_greedy_decode(
+                    x,
+                    out_lens,
+                    embedding.weight,
+                    lstm_weights,
+                    lstm_biases,
+                    joint_enc.weight,
+                    joint_enc.bias,
+                    joint_pred.weight,
+                    joint_pred.bias,
+                    joint_fc[1].weight,
+                    joint_fc[1].bias,
+                    max_symbols,
+                    blank_id,
+                    self._SOS,
+                )
+            for b in range(batch_size):
+                self.assertEqual(label_lens[b].item(), len(labels_org[b]))
+                self.assertEqual(labels[b, : label_lens[b]].tolist(), labels_org[b])
+
+
 if __name__ == "__main__":
     test = unittest.main()
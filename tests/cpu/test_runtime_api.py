@@ -152,6 +152,35 @@ class TestCoreBinding(TestCase):
         y = model(x)
         self.assertEqual(y, y_runtime)
 
+    @unittest.skipIf(
+        not ipex.cpu.runtime.is_runtime_ext_enabled(),
+        "Skip when IPEX Runtime extension is not enabled",
+    )
+    @runtime_thread_affinity_test_env
+    def test_with_context_numa_arena(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        cpu_pool = ipex.cpu.runtime.CPUPool([1, 2, 3, 4])
+        arena = cpu_pool.arena()
+        arena.empty_cache()
+        with ipex.cpu.runtime.pin(cpu_pool, use_numa_arena=True):
+            self.assertIsNotNone(ipex._C.get_current_cpu_pool_arena())
+            for _ in range(3):
+                y_runtime = model(x)
+            stats = arena.stats()
+            self.assertGreater(stats.num_allocs, 0)
+            # the buffers of the first iteration are recycled by the next ones
+            self.assertGreater(stats.num_cache_hits, 0)
+        self.assertIsNone(ipex._C.get_current_cpu_pool_arena())
+        y = model(x)
+        self.assertEqual(y, y_runtime)
+        del y_runtime
+        # the buffers come back to the size class they were allocated for
+        self.assertEqual(arena.stats().allocated_bytes, 0)
+        arena.empty_cache()
+        self.assertEqual(arena.stats().cached_bytes, 0)
+
 
 class TestRuntimeAPI(TestCase):
     @unittest.skipIf(
@@ -247,6 +276,48 @@ class TestRuntimeAPI(TestCase):
         self.assertEqual(y, y_runtime)
         self.assertEqual(y, y_runtime2)
 
+    @unittest.skipIf(
+        not ipex.cpu.runtime.is_runtime_ext_enabled(),
+        "Skip when IPEX Runtime extension is not enabled",
+    )
+    @runtime_thread_affinity_test_env
+    def test_batching_task(self):
+        model = SimpleNet()
+        model.eval()
+        xs = [torch.rand(1, 64, 3, 3) for _ in range(10)]
+        ys = [model(x) for x in xs]
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        for m in [model, torch.jit.trace(model, xs[0])]:
+            task = ipex.cpu.runtime.BatchingTask(
+                m, cpu_pool, max_batch_size=4, max_delay_ms=50
+            )
+            futures = [task(x) for x in xs]
+            for y, future in zip(ys, futures):
+                self.assertEqual(y, future.get())
+            self.assertEqual(ys[0], task.run_sync(xs[0]))
+
+    @unittest.skipIf(
+        not ipex.cpu.runtime.is_runtime_ext_enabled(),
+        "Skip when IPEX Runtime extension is not enabled",
+    )
+    @runtime_thread_affinity_test_env
+    def test_batching_task_variable_length(self):
+        class PadModel(torch.nn.Module):
+            def forward(self, x, mask):
+                return x * 2 + mask, x.sum(dim=2)
+
+        model = PadModel().eval()
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        task = ipex.cpu.runtime.BatchingTask(
+            model, cpu_pool, max_delay_ms=50, pad_dim=1, output_pad_dim=1
+        )
+        xs = [torch.rand(1, length, 8) for length in [3, 7, 5]]
+        futures = [task(x, torch.ones(1, x.shape[1], 1)) for x in xs]
+        for x, future in zip(xs, futures):
+            y, s = future.get()
+            self.assertEqual(y, x * 2 + 1)
+            self.assertEqual(s, x.sum(dim=2))
+
 
 class TestMultiStreamModule(TestCase):
     @unittest.skipIf(
@@ -0,0 +1,121 @@
+import unittest
+
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex  # noqa: F401
+from intel_extension_for_pytorch.transformers.generation.sampling import (
+    lm_head_sample,
+)
+from common_utils import TestCase
+
+
+def _sample(logits, seeds, counters, prev_tokens=None, **kwargs):
+    return torch.ops.torch_ipex.sample_logits(
+        logits, seeds, counters, prev_tokens, **kwargs
+    )
+
+
+class SamplingTester(TestCase):
+    def test_greedy(self):
+        # more tokens than one task of the kernel
+        for dtype in [torch.float, torch.bfloat16, torch.half]:
+            logits = torch.randn(3, 10000).to(dtype)
+            seeds = torch.arange(3)
+            counters = torch.zeros(3, dtype=torch.long)
+            tokens = _sample(logits, seeds, counters, temperature=0.0)
+            self.assertEqual(tokens, logits.float().argmax(-1))
+            tokens = _sample(logits, seeds, counters, top_k=1)
+            self.assertEqual(tokens, logits.float().argmax(-1))
+
+    def test_repetition_penalty(self):
+        logits = torch.tensor([[2.0, 1.9, -1.0, -1.1], [2.0, 1.9, -1.0, -1.1]])
+        # padded with -1
+        prev_tokens = torch.tensor([[0, -1], [2, 3]])
+        seeds = torch.zeros(2, dtype=torch.long)
+        tokens = _sample(
+            logits,
+            seeds,
+            seeds,
+            prev_tokens,
+            temperature=0.0,
+            repetition_penalty=1.5,
+        )
+        self.assertEqual(tokens, torch.tensor([1, 0]))
+
+    def test_reproducible(self):
+        logits = torch.randn(4, 5000)
+        seeds = torch.tensor([11, 22, 33, 44])
+        counters = torch.tensor([0, 5, 7, 9])
+        for kwargs in [{}, {"top_k": 50}, {"top_p": 0.9}, {"min_p": 0.05}]:
+            tokens = _sample(logits, seeds, counters, **kwargs)
+            self.assertEqual(tokens, _sample(logits, seeds, counters, **kwargs))
+            # the same tokens whatever the batch or the number of threads
+            num_threads = torch.get_num_threads()
+            torch.set_num_threads(1)
+            for b in range(4):
+                token = _sample(
+                    logits[b : b + 1], seeds[b : b + 1], counters[b : b + 1], **kwargs
+                )
+                self.assertEqual(token[0], tokens[b])
+            torch.set_num_threads(num_threads)
+
+    def test_distribution(self):
+        vocab = 6
+        logits = torch.tensor([[2.0, 1.5, 1.0, 0.5, 0.0, -3.0]])
+        n = 20000
+        seeds = torch.arange(n)
+        counters = torch.zeros(n, dtype=torch.long)
+
+        def frequencies(temperature=1.0, **kwargs):
+            tokens = _sample(
+                logits.expand(n, vocab),
+                seeds,
+                counters,
+                temperature=temperature,
+                **kwargs,
+            )
+            return torch.bincount(tokens, minlength=vocab).float() / n
+
+        probs = torch.softmax(logits[0], -1)
+        torch.testing.assert_close(frequencies(), probs, atol=2e-2, rtol=0)
+        probs = torch.softmax(logits[0] / 0.5, -1)
+        torch.testing.assert_close(frequencies(0.5), probs, atol=2e-2, rtol=0)
+
+        # top-k keeps the 3 best tokens
+        probs = torch.softmax(logits[0], -1)
+        expected = torch.zeros(vocab)
+        expected[:3] = probs[:3] / probs[:3].sum()
+        torch.testing.assert_close(frequencies(top_k=3), expected, atol=2e-2, rtol=0)
+        # top-p keeps the smallest prefix of mass not lower than top_p
+        top_p = probs[:2].sum().item() + 1e-3
+        torch.testing.assert_close(
+            frequencies(top_p=top_p), expected, atol=2e-2, rtol=0
+        )
+        # min-p keeps the tokens of at least min_p of the best probability
+        min_p = (probs[2] / probs[0]).item() - 1e-3
+        torch.testing.assert_close(
+            frequencies(min_p=min_p), expected, atol=2e-2, rtol=0
+        )
+
+    def test_lm_head_sample(self):
+        hidden_size, vocab = 64, 3000
+        lm_head = nn.Linear(hidden_size, vocab, bias=False).eval()
+        hidden_states = torch.randn(2, 5, hidden_size)
+        seeds = torch.tensor([1, 2])
+        counters = torch.tensor([3, 4])
+        with torch.no_grad():
+            logits_ref = lm_head(hidden_states[:, -1, :])
+            tokens, logits = lm_head_sample(
+                lm_head, hidden_states, seeds, counters, top_k=20, return_logits=True
+            )
+            torch.testing.assert_close(logits, logits_ref)
+            self.assertEqual(tokens, _sample(logits_ref, seeds, counters, top_k=20))
+            tokens, logits = lm_head_sample(
+                lm_head, hidden_states, seeds, counters, temperature=0.0
+            )
+            self.assertEqual(logits.numel(), 0)
+            self.assertEqual(tokens, logits_ref.argmax(-1))
+
+
+if __name__ == "__main__":
+    test = unittest.main()
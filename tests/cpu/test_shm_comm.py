@@ -0,0 +1,127 @@
+import os
+import unittest
+import uuid
+
+import torch
+import torch.multiprocessing as mp
+import intel_extension_for_pytorch as ipex  # noqa: F401
+from torch.testing._internal.common_utils import TestCase
+
+WORLD_SIZE = 2
+BUFFER_SIZE = 64 * 1024
+
+
+def _rank_input(rank, shape, dtype, seed):
+    torch.manual_seed(seed * 100 + rank)
+    return torch.randn(shape).to(dtype)
+
+
+def _check_all_reduce(rank, name):
+    ipex.cpu.comm.init_shm_comm(rank, WORLD_SIZE, name, BUFFER_SIZE)
+    assert ipex.cpu.comm.is_shm_comm_initialized()
+    seed = 0
+    for dtype in [torch.float, torch.bfloat16, torch.half]:
+        # the last numels do not fill the vectors or the slices of the ranks
+        for shape in [(1, 4096), (3, 37), (1,), (5, 1000)]:
+            seed += 1
+            x = _rank_input(rank, shape, dtype, seed)
+            expected = sum(
+                _rank_input(r, shape, dtype, seed).float() for r in range(WORLD_SIZE)
+            )
+            y = ipex.cpu.comm.all_reduce(x)
+            assert y.data_ptr() == x.data_ptr()
+            torch.testing.assert_close(y.float(), expected.to(dtype).float())
+
+    for dim in [0, 1, -1]:
+        seed += 1
+        shape = (3, 5000)
+        x = _rank_input(rank, shape, torch.float, seed)
+        expected = torch.cat(
+            [_rank_input(r, shape, torch.float, seed) for r in range(WORLD_SIZE)],
+            dim,
+        )
+        # 60000 bytes per rank, 2 rounds of BUFFER_SIZE for the larger shape
+        torch.testing.assert_close(ipex.cpu.comm.all_gather(x, dim), expected)
+        x = x.repeat(2, 1)
+        expected = torch.cat(
+            [
+                _rank_input(r, shape, torch.float, seed).repeat(2, 1)
+                for r in range(WORLD_SIZE)
+            ],
+            dim,
+        )
+        torch.testing.assert_close(ipex.cpu.comm.all_gather(x, dim), expected)
+    ipex.cpu.comm.destroy_shm_comm()
+
+
+def _check_graph_rewrite(rank, name):
+    if not hasattr(torch.ops.deepspeed_comm, "all_reduce"):
+        # identity stand-in of deepspeed for the single process of the rank
+        ds_comm = torch.library.Library("deepspeed_comm", "DEF")
+        ds_comm.define("all_reduce(Tensor self) -> Tensor")
+        ds_comm_lib_cpu = torch.library.Library("deepspeed_comm", "IMPL", "CPU")
+        ds_comm_lib_cpu.impl("all_reduce", lambda x: x)
+
+    class M(torch.nn.Module):
+        def forward(self, x):
+            return torch.ops.deepspeed_comm.all_reduce(x * 2)
+
+    ipex.cpu.comm.init_shm_comm(rank, WORLD_SIZE, name, BUFFER_SIZE)
+    x = torch.ones(4, 64) * (rank + 1)
+    with torch.no_grad():
+        traced = torch.jit.freeze(torch.jit.trace(M().eval(), x))
+        traced(x)
+        graph = traced.graph_for(x)
+        assert "torch_ipex::shm_all_reduce" in str(graph)
+        assert "deepspeed_comm::all_reduce" not in str(graph)
+        expected = torch.full((4, 64), 2.0 * sum(range(1, WORLD_SIZE + 1)))
+        torch.testing.assert_close(traced(x), expected)
+    ipex.cpu.comm.destroy_shm_comm()
+
+
+def _check_peer_exit(rank, name):
+    os.environ["IPEX_SHM_COMM_TIMEOUT"] = "2"
+    ipex.cpu.comm.init_shm_comm(rank, WORLD_SIZE, name, BUFFER_SIZE)
+    if rank == 0:
+        # rank 1 exits without joining the collective
+        try:
+            ipex.cpu.comm.all_reduce(torch.ones(16))
+            raise AssertionError("all_reduce should time out")
+        except RuntimeError as e:
+            assert "timed out" in str(e)
+        # the communicator stays aborted
+        try:
+            ipex.cpu.comm.all_reduce(torch.ones(16))
+            raise AssertionError("all_reduce should fail once aborted")
+        except RuntimeError as e:
+            assert "aborted" in str(e)
+    ipex.cpu.comm.destroy_shm_comm()
+
+
+def _run(rank, fn, name):
+    torch.set_num_threads(1)
+    fn(rank, name)
+
+
+class ShmCommTester(TestCase):
+    def _spawn(self, fn):
+        name = "/ipex_shm_comm_test_{}".format(uuid.uuid4().hex)
+        mp.spawn(_run, args=(fn, name), nprocs=WORLD_SIZE, join=True)
+
+    def test_all_reduce_and_all_gather(self):
+        self._spawn(_check_all_reduce)
+
+    def test_replace_all_reduce_in_graph(self):
+        self._spawn(_check_graph_rewrite)
+
+    def test_peer_exit(self):
+        self._spawn(_check_peer_exit)
+
+    def test_not_initialized(self):
+        self.assertFalse(ipex.cpu.comm.is_shm_comm_initialized())
+        with self.assertRaises(RuntimeError):
+            ipex.cpu.comm.all_gather(torch.ones(4))
+
+
+if __name__ == "__main__":
+    test = unittest.main()
@@ -2187,6 +2187,107 @@ class TestPrepackCases(TestCase):
                 y_ref = origin_model(x_var)
                 self.assertEqual(y_var, y_ref)
 
+    def test_rnn_streaming(self):
+        # run the sequence chunk by chunk through the stateful RNN op context
+        # and compare with running the whole sequence at once
+        for mode, num_layers, bias, batch_first in itertools.product(
+            ["LSTM", "GRU"], [1, 2], [True, False], [True, False]
+        ):
+            rnn_cls = torch.nn.LSTM if mode == "LSTM" else torch.nn.GRU
+            rnn = rnn_cls(
+                input_size=5,
+                hidden_size=7,
+                num_layers=num_layers,
+                bias=bias,
+                batch_first=batch_first,
+            ).eval()
+            ctx = torch.ops.ipex_prepack.rnn_prepack(
+                rnn._flat_weights, mode, 7, num_layers, bias, batch_first
+            )
+            seq_dim = 1 if batch_first else 0
+            x = [
+                torch.randn(3, 10, 5) if batch_first else torch.randn(10, 3, 5)
+                for _ in range(2)
+            ]
+            with torch.no_grad():
+                y_ref = [rnn(x_)[0] for x_ in x]
+                # interleave the chunks of two streams
+                y = [[], []]
+                for chunk in [2, 3, 1, 4]:
+                    for stream_id in range(2):
+                        start = sum(t.size(seq_dim) for t in y[stream_id])
+                        y[stream_id].append(
+                            ctx.run(
+                                x[stream_id].narrow(seq_dim, start, chunk),
+                                stream_id,
+                            )
+                        )
+                self.assertEqual(ctx.get_num_streams(), 2)
+                for stream_id in range(2):
+                    self.assertEqual(
+                        torch.cat(y[stream_id], seq_dim), y_ref[stream_id]
+                    )
+
+                # restart a stream from zero state
+                ctx.reset_state(0)
+                self.assertEqual(ctx.get_num_streams(), 1)
+                self.assertEqual(
+                    ctx.run(x[0].narrow(seq_dim, 0, 2), 0),
+                    y_ref[0].narrow(seq_dim, 0, 2),
+                )
+
+                # continue from a given state
+                state = ctx.get_state(0)
+                ctx.set_state(
+                    2, state[0], state[1] if mode == "LSTM" else None
+                )
+                self.assertEqual(
+                    ctx.run(x[0].narrow(seq_dim, 2, 8), 2),
+                    y_ref[0].narrow(seq_dim, 2, 8),
+                )
+
+                # the carried states are not serialized
+                ctx_loaded = torch.ops.ipex_prepack.rnn_prepack(*ctx.__getstate__())
+                self.assertEqual(ctx_loaded.get_num_streams(), 0)
+                self.assertEqual(ctx_loaded.run(x[1], 0), y_ref[1])
+
+    def test_rnn_streaming_chunk_shapes(self):
+        # more chunk lengths than the packed weights cached by the context
+        for mode in ["LSTM", "GRU"]:
+            rnn_cls = torch.nn.LSTM if mode == "LSTM" else torch.nn.GRU
+            rnn = rnn_cls(input_size=5, hidden_size=7, num_layers=2).eval()
+            ctx = torch.ops.ipex_prepack.rnn_prepack(
+                rnn._flat_weights, mode, 7, 2, True, False
+            )
+            chunks = list(range(1, 21)) + list(range(1, 21))
+            x = torch.randn(sum(chunks), 3, 5)
+            with torch.no_grad():
+                y_ref = rnn(x)[0]
+                y = [ctx.run(t, 0) for t in x.split(chunks)]
+                self.assertEqual(torch.cat(y), y_ref)
+
+                # the state of a stream is not dropped on a new batch size
+                with self.assertRaisesRegex(RuntimeError, "reset_state"):
+                    ctx.run(torch.randn(2, 4, 5), 0)
+                ctx.reset_state(0)
+                self.assertEqual(ctx.run(x[:2, :2], 0), rnn(x[:2, :2])[0])
+
+    def test_rnn_streaming_bf16(self):
+        if not core.onednn_has_bf16_support():
+            return
+        lstm = torch.nn.LSTM(input_size=5, hidden_size=7, num_layers=2).eval()
+        ctx = torch.ops.ipex_prepack.rnn_prepack(
+            lstm._flat_weights, "LSTM", 7, 2, True, False
+        )
+        x = torch.randn(10, 3, 5)
+        with torch.no_grad():
+            y_ref = lstm(x)[0]
+            y = torch.cat(
+                [ctx.run(chunk.bfloat16(), 0) for chunk in x.split([4, 6])], 0
+            )
+        self.assertEqual(y.dtype, torch.bfloat16)
+        self.assertEqual(y.float(), y_ref, rtol=5e-2, atol=5e-2)
+
 
 if __name__ == "__main__":
     torch.manual_seed(2020)